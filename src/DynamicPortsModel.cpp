@@ -24,7 +24,28 @@
  */
 
 #include "DynamicPortsModel.hpp"
+#include "diag/memory-report.hpp"
+#include "spec_parser/automaton-binary.hpp"
 #include "spec_parser/automaton-parser.hpp"
+#include "spec_parser/sub-automaton.hpp"
+#include "trace/scope-trace.hpp"
+
+#include <QFileInfo>
+
+#include <algorithm>
+#include <filesystem>
+#include <memory>
+#include <system_error>
+#include <tuple>
+
+/// Removes an element of a per-node array, the last one takes its place.
+template <typename T>
+static void eraseSlot(std::vector<T> &values, size_t slot)
+{
+    if (slot + 1 != values.size())
+        values[slot] = std::move(values.back());
+    values.pop_back();
+}
 
 DynamicPortsModel::DynamicPortsModel()
     : _nextNodeId{1}
@@ -37,46 +58,72 @@ DynamicPortsModel::~DynamicPortsModel()
 
 std::unordered_set<NodeId> DynamicPortsModel::allNodeIds() const
 {
-    return _nodeIds;
+    return std::unordered_set<NodeId>(_nodeIds.begin(), _nodeIds.end());
 }
 
 std::unordered_set<ConnectionId> DynamicPortsModel::allConnectionIds(NodeId const nodeId) const
 {
-    std::unordered_set<ConnectionId> result;
-
-    std::copy_if(_connectivity.begin(),
-                 _connectivity.end(),
-                 std::inserter(result, std::end(result)),
-                 [&nodeId](ConnectionId const &cid) {
-                     return cid.inNodeId == nodeId || cid.outNodeId == nodeId;
-                 });
+    auto it = _nodeConnections.find(nodeId);
+    if (it == _nodeConnections.end())
+        return std::unordered_set<ConnectionId>();
 
-    return result;
+    return it->second;
 }
 
 void DynamicPortsModel::forceNodeUiUpdate(NodeId const id)
 {
    // This seems to be useless but without it the node widths are all messed up
    // and I have no idea why...
+   if (inBatch()) {
+       // the size is recomputed when the scene is rebuilt, fix the width afterwards
+       _batchForcedWidths.push_back(id);
+       return;
+   }
    Q_EMIT nodeUpdated(id);
-   _nodeGeometryData[id].size.setWidth(290);
+   const NodeSlot slot = slotOf(id);
+   if (slot != InvalidSlot)
+       _nodeGeometryData[slot].size.setWidth(290);
 }
 
 std::unordered_set<ConnectionId> DynamicPortsModel::connections(NodeId nodeId,
                                                                 PortType portType,
                                                                 PortIndex portIndex) const
 {
-    std::unordered_set<ConnectionId> result;
+    auto it = _portConnections.find(PortKey{nodeId, portType, portIndex});
+    if (it == _portConnections.end())
+        return std::unordered_set<ConnectionId>();
 
-    std::copy_if(_connectivity.begin(),
-                 _connectivity.end(),
-                 std::inserter(result, std::end(result)),
-                 [&portType, &portIndex, &nodeId](ConnectionId const &cid) {
-                     return (getNodeId(portType, cid) == nodeId
-                             && getPortIndex(portType, cid) == portIndex);
-                 });
+    return it->second;
+}
 
-    return result;
+void DynamicPortsModel::indexConnection(ConnectionId const connectionId, bool add)
+{
+    const PortKey outKey{connectionId.outNodeId, PortType::Out, connectionId.outPortIndex};
+    const PortKey inKey{connectionId.inNodeId, PortType::In, connectionId.inPortIndex};
+
+    if (add) {
+        _nodeConnections[connectionId.outNodeId].insert(connectionId);
+        _nodeConnections[connectionId.inNodeId].insert(connectionId);
+        _portConnections[outKey].insert(connectionId);
+        _portConnections[inKey].insert(connectionId);
+        return;
+    }
+
+    // drop emptied buckets so the indexes do not grow with deleted nodes and ports
+    auto eraseFromNode = [this, &connectionId](NodeId nodeId) {
+        auto it = _nodeConnections.find(nodeId);
+        if (it != _nodeConnections.end() && it->second.erase(connectionId) && it->second.empty())
+            _nodeConnections.erase(it);
+    };
+    auto eraseFromPort = [this, &connectionId](PortKey const &key) {
+        auto it = _portConnections.find(key);
+        if (it != _portConnections.end() && it->second.erase(connectionId) && it->second.empty())
+            _portConnections.erase(it);
+    };
+    eraseFromNode(connectionId.outNodeId);
+    eraseFromNode(connectionId.inNodeId);
+    eraseFromPort(outKey);
+    eraseFromPort(inKey);
 }
 
 bool DynamicPortsModel::connectionExists(ConnectionId const connectionId) const
@@ -88,21 +135,22 @@ NodeId DynamicPortsModel::addNode(QString const nodeType)
 {
     NodeId newId = newNodeId();
 
-    // Create new node.
-    _nodeIds.insert(newId);
+    // Create new node, it starts as a non-final state
+    const NodeSlot slot = addNodeSlot(newId);
 
     // Add a default name to the node
     QString nodeName = "State ";
     nodeName.append(QString::fromStdString(std::to_string(newId)));
-    _nodeNames[newId] = nodeName;
+    setNodeNameIndexed(slot, nodeName);
 
     // Add a default code to the node:
-    _nodeActionCodes[newId] = "# Enter code here:\n";
-
-    // Initaialzie it as non-fian lstate
-    _nodeFinalStates[newId] = false;
+    _nodeActionCodes[slot] = "# Enter code here:\n";
+    if (_searchIndexed)
+        _actionSearch.set(newId, _nodeActionCodes[slot].toStdString());
+    markChanged();
 
-    Q_EMIT nodeCreated(newId);
+    if (!inBatch())
+        Q_EMIT nodeCreated(newId);
 
     return newId;
 }
@@ -115,46 +163,116 @@ bool DynamicPortsModel::connectionPossible(ConnectionId const connectionId) cons
 void DynamicPortsModel::addConnection(ConnectionId const connectionId)
 {
     _connectivity.insert(connectionId);
+    indexConnection(connectionId, true);
 
     // Add a default transition condition code (just a comment)
     _connectionCodes[connectionId] = "";
     // Add a default delay of 0ms
     _connectionDelays[connectionId] = 0;
+    markChanged();
 
-    Q_EMIT connectionCreated(connectionId);
+    if (!inBatch())
+        Q_EMIT connectionCreated(connectionId);
 }
 
 bool DynamicPortsModel::nodeExists(NodeId const nodeId) const
 {
-    return (_nodeIds.find(nodeId) != _nodeIds.end());
+    return slotOf(nodeId) != InvalidSlot;
 }
 
-NodeId DynamicPortsModel::findNodeByName(QString const nodeName)
+NodeId DynamicPortsModel::findNodeByName(QString const nodeName) const
 {
-    for (const auto& pair : _nodeNames) {
-        if (pair.second == nodeName) {
-            return pair.first;
-        }
+    NodeId nodeId = _nodeIdsByName.value(nodeName, QtNodes::InvalidNodeId);
+    if (nodeId == QtNodes::InvalidNodeId && !_nodeInstances.empty()) {
+        const int dot = nodeName.indexOf('.');
+        if (dot > 0)
+            nodeId = _nodeIdsByName.value(nodeName.left(dot), QtNodes::InvalidNodeId);
     }
-    return QtNodes::InvalidNodeId;
+    return nodeId;
+}
+
+void DynamicPortsModel::setNodeNameIndexed(NodeSlot const slot, QString const &name)
+{
+    QString &current = _nodeNames[slot];
+    if (current == name)
+        return;
+    _nodeIdsByName.remove(current, _nodeIds[slot]);
+    current = name;
+    _nodeIdsByName.insert(name, _nodeIds[slot]);
+    if (_searchIndexed)
+        _nameSearch.set(_nodeIds[slot], name.toStdString());
 }
 
-PortAddRemoveWidget *DynamicPortsModel::widget(NodeId nodeId) const
+DynamicPortsModel::NodeSlot DynamicPortsModel::addNodeSlot(NodeId const nodeId)
 {
-    auto it = _nodeWidgets.find(nodeId);
-    if (it == _nodeWidgets.end()) {
-        _nodeWidgets[nodeId] = new PortAddRemoveWidget(0,
-                                                       0,
-                                                       nodeId,
-                                                       *const_cast<DynamicPortsModel *>(this));
+    const NodeSlot slot = static_cast<NodeSlot>(_nodeIds.size());
+    _nodeSlots.emplace(nodeId, slot);
+    _nodeIds.push_back(nodeId);
+    _nodeNames.emplace_back();
+    _nodeActionCodes.emplace_back();
+    _nodeFinalStates.push_back(false);
+    _nodeGeometryData.emplace_back();
+    _nodePortCounts.emplace_back();
+    _nodeWidgets.push_back(nullptr);
+    _lazyActionCodes.emplace_back();
+    return slot;
+}
+
+void DynamicPortsModel::removeNodeSlot(NodeSlot const slot)
+{
+    _nodeSlots.erase(_nodeIds[slot]);
+    if (slot + 1 != _nodeIds.size())
+        _nodeSlots[_nodeIds.back()] = slot;
+
+    eraseSlot(_nodeIds, slot);
+    eraseSlot(_nodeNames, slot);
+    eraseSlot(_nodeActionCodes, slot);
+    eraseSlot(_nodeFinalStates, slot);
+    eraseSlot(_nodeGeometryData, slot);
+    eraseSlot(_nodePortCounts, slot);
+    eraseSlot(_nodeWidgets, slot);
+    eraseSlot(_lazyActionCodes, slot);
+}
+
+PortAddRemoveWidget *DynamicPortsModel::widget(NodeSlot const slot) const
+{
+    PortAddRemoveWidget *&w = _nodeWidgets[slot];
+    if (!w) {
+        w = new PortAddRemoveWidget(0, 0, _nodeIds[slot], *const_cast<DynamicPortsModel *>(this));
+        // the widget may be created after the ports were set up
+        w->populateButtons(PortType::In, _nodePortCounts[slot].in);
+        w->populateButtons(PortType::Out, _nodePortCounts[slot].out);
     }
 
-    return _nodeWidgets[nodeId];
+    return w;
+}
+
+void DynamicPortsModel::SetPaintedPortControls(bool painted)
+{
+    if (_paintedPortControls == painted)
+        return;
+
+    _paintedPortControls = painted;
+
+    // the scene rebuilds the nodes with or without their widgets
+    if (!inBatch())
+        Q_EMIT modelReset();
+}
+
+QtNodes::NodeFlags DynamicPortsModel::nodeFlags(NodeId nodeId) const
+{
+    QtNodes::NodeFlags flags = _paintedPortControls ? QtNodes::NodeFlags(NodeFlag::PortControls)
+                                                    : QtNodes::NodeFlags(NodeFlag::NoFlags);
+    if (nodeId == _liveNodeId)
+        flags |= NodeFlag::Live;
+    return flags;
 }
 
 QVariant DynamicPortsModel::nodeData(NodeId nodeId, NodeRole role) const
 {
-    Q_UNUSED(nodeId);
+    // the node roles of an unknown node are left invalid
+    const NodeSlot slot = slotOf(nodeId);
+    const bool exists = slot != InvalidSlot;
 
     QVariant result;
 
@@ -164,11 +282,13 @@ QVariant DynamicPortsModel::nodeData(NodeId nodeId, NodeRole role) const
         break;
 
     case NodeRole::Position:
-        result = _nodeGeometryData[nodeId].pos;
+        if (exists)
+            result = _nodeGeometryData[slot].pos;
         break;
 
     case NodeRole::Size:
-        result = _nodeGeometryData[nodeId].size;
+        if (exists)
+            result = _nodeGeometryData[slot].size;
         break;
 
     case NodeRole::CaptionVisible:
@@ -176,27 +296,35 @@ QVariant DynamicPortsModel::nodeData(NodeId nodeId, NodeRole role) const
         break;
 
     case NodeRole::Caption:
-        result = _nodeNames.at(nodeId);
+        if (exists)
+            result = _nodeNames[slot];
         break;
 
     case NodeRole::Style: {
-        auto style = StyleCollection::nodeStyle();
-        result = style.toJson().toVariantMap();
+        // serialize the global style once per style version
+        if (_nodeStyleMapVersion != StyleCollection::nodeStyleVersion()) {
+            _nodeStyleMap = StyleCollection::nodeStyleJson().toVariantMap();
+            _nodeStyleMapVersion = StyleCollection::nodeStyleVersion();
+        }
+        result = _nodeStyleMap;
     } break;
 
     case NodeRole::InternalData:
         break;
 
     case NodeRole::InPortCount:
-        result = _nodePortCounts[nodeId].in;
+        if (exists)
+            result = _nodePortCounts[slot].in;
         break;
 
     case NodeRole::OutPortCount:
-        result = _nodePortCounts[nodeId].out;
+        if (exists)
+            result = _nodePortCounts[slot].out;
         break;
 
     case NodeRole::Widget: {
-        result = QVariant::fromValue(widget(nodeId));
+        if (exists && !_paintedPortControls)
+            result = QVariant::fromValue(widget(slot));
         break;
     }
     }
@@ -206,21 +334,27 @@ QVariant DynamicPortsModel::nodeData(NodeId nodeId, NodeRole role) const
 
 bool DynamicPortsModel::setNodeData(NodeId nodeId, NodeRole role, QVariant value)
 {
+    const NodeSlot slot = slotOf(nodeId);
+    if (slot == InvalidSlot)
+        return false;
+
     bool result = false;
 
     switch (role) {
     case NodeRole::Type:
         break;
     case NodeRole::Position: {
-        _nodeGeometryData[nodeId].pos = value.value<QPointF>();
+        _nodeGeometryData[slot].pos = value.value<QPointF>();
+        markChanged();
 
-        Q_EMIT nodePositionUpdated(nodeId);
+        if (!inBatch())
+            Q_EMIT nodePositionUpdated(nodeId);
 
         result = true;
     } break;
 
     case NodeRole::Size: {
-        _nodeGeometryData[nodeId].size = value.value<QSize>();
+        _nodeGeometryData[slot].size = value.value<QSize>();
         result = true;
     } break;
 
@@ -228,7 +362,8 @@ bool DynamicPortsModel::setNodeData(NodeId nodeId, NodeRole role, QVariant value
         break;
 
     case NodeRole::Caption:
-        _nodeNames[nodeId] = value.value<QString>();
+        setNodeNameIndexed(slot, value.value<QString>());
+        markChanged();
         result = true;
         break;
 
@@ -239,13 +374,17 @@ bool DynamicPortsModel::setNodeData(NodeId nodeId, NodeRole role, QVariant value
         break;
 
     case NodeRole::InPortCount:
-        _nodePortCounts[nodeId].in = value.toUInt();
-        widget(nodeId)->populateButtons(PortType::In, value.toUInt());
+        _nodePortCounts[slot].in = value.toUInt();
+        markChanged();
+        if (!_paintedPortControls)
+            widget(slot)->populateButtons(PortType::In, value.toUInt());
         break;
 
     case NodeRole::OutPortCount:
-        _nodePortCounts[nodeId].out = value.toUInt();
-        widget(nodeId)->populateButtons(PortType::Out, value.toUInt());
+        _nodePortCounts[slot].out = value.toUInt();
+        markChanged();
+        if (!_paintedPortControls)
+            widget(slot)->populateButtons(PortType::Out, value.toUInt());
         break;
 
     case NodeRole::Widget:
@@ -307,6 +446,9 @@ bool DynamicPortsModel::deleteConnection(ConnectionId const connectionId)
 
     // remove the connection code
     _connectionCodes.erase(connectionId);
+    _lazyConnectionCodes.erase(connectionId);
+    if (_searchIndexed)
+        indexCondition(connectionId, QString());
 
     auto it = _connectivity.find(connectionId);
 
@@ -314,19 +456,64 @@ bool DynamicPortsModel::deleteConnection(ConnectionId const connectionId)
         disconnected = true;
 
         _connectivity.erase(it);
+        indexConnection(connectionId, false);
+        if (_liveConnection == connectionId)
+            _liveConnection.reset();
+        _connectionHeat.erase(connectionId);
+        markChanged();
     };
 
-    if (disconnected)
+    if (disconnected && !inBatch())
         Q_EMIT connectionDeleted(connectionId);
 
     return disconnected;
 }
 
+bool DynamicPortsModel::reindexConnection(ConnectionId const oldConnectionId,
+                                          ConnectionId const newConnectionId)
+{
+    auto it = _connectivity.find(oldConnectionId);
+    if (it == _connectivity.end() || oldConnectionId == newConnectionId)
+        return it != _connectivity.end();
+
+    _connectivity.erase(it);
+    _connectivity.insert(newConnectionId);
+    indexConnection(oldConnectionId, false);
+    indexConnection(newConnectionId, true);
+
+    // the data keyed by the connection moves to the new id
+    auto moveKey = [&oldConnectionId, &newConnectionId](auto &map) {
+        auto node = map.extract(oldConnectionId);
+        if (node) {
+            node.key() = newConnectionId;
+            map.insert(std::move(node));
+        }
+    };
+    moveKey(_connectionCodes);
+    moveKey(_lazyConnectionCodes);
+    moveKey(_connectionDelays);
+    moveKey(_connectionHeat);
+
+    auto key = _conditionSearchKeys.extract(oldConnectionId);
+    if (key) {
+        _conditionSearchConnections[key.mapped()] = newConnectionId;
+        key.key() = newConnectionId;
+        _conditionSearchKeys.insert(std::move(key));
+    }
+
+    if (_liveConnection == oldConnectionId)
+        _liveConnection = newConnectionId;
+    markChanged();
+
+    if (!inBatch())
+        Q_EMIT connectionReindexed(oldConnectionId, newConnectionId);
+
+    return true;
+}
+
 bool DynamicPortsModel::deleteNode(NodeId const nodeId)
 {
-    _nodeFinalStates.erase(nodeId);
-    _nodeNames.erase(nodeId);
-    _nodeActionCodes.erase(nodeId);
+    markChanged();
 
     // Delete connections to this node first.
     auto connectionIds = allConnectionIds(nodeId);
@@ -334,12 +521,22 @@ bool DynamicPortsModel::deleteNode(NodeId const nodeId)
         deleteConnection(cId);
     }
 
-    _nodeIds.erase(nodeId);
-    _nodeGeometryData.erase(nodeId);
-    _nodePortCounts.erase(nodeId);
-    _nodeWidgets.erase(nodeId);
+    const NodeSlot slot = slotOf(nodeId);
+    if (slot != InvalidSlot) {
+        _nodeIdsByName.remove(_nodeNames[slot], nodeId);
+        if (_searchIndexed) {
+            _nameSearch.remove(nodeId);
+            _actionSearch.remove(nodeId);
+        }
+        removeNodeSlot(slot);
+    }
+    if (_liveNodeId == nodeId)
+        _liveNodeId = InvalidNodeId;
+    _nodeHeat.erase(nodeId);
+    _nodeInstances.erase(nodeId);
 
-    Q_EMIT nodeDeleted(nodeId);
+    if (!inBatch())
+        Q_EMIT nodeDeleted(nodeId);
 
     return true;
 }
@@ -358,8 +555,10 @@ QJsonObject DynamicPortsModel::saveNode(NodeId const nodeId) const
         posJson["y"] = pos.y();
         nodeJson["position"] = posJson;
 
-        nodeJson["inPortCount"] = QString::number(_nodePortCounts[nodeId].in);
-        nodeJson["outPortCount"] = QString::number(_nodePortCounts[nodeId].out);
+        const NodeSlot slot = slotOf(nodeId);
+        const NodePortCount ports = (slot != InvalidSlot) ? _nodePortCounts[slot] : NodePortCount();
+        nodeJson["inPortCount"] = QString::number(ports.in);
+        nodeJson["outPortCount"] = QString::number(ports.out);
     }
 
     return nodeJson;
@@ -391,7 +590,9 @@ void DynamicPortsModel::loadNode(QJsonObject const &nodeJson)
     _nextNodeId = std::max(_nextNodeId, restoredNodeId + 1);
 
     // Create new node.
-    _nodeIds.insert(restoredNodeId);
+    if (!nodeExists(restoredNodeId))
+        addNodeSlot(restoredNodeId);
+    markChanged();
 
     setNodeData(restoredNodeId, NodeRole::InPortCount, nodeJson["inPortCount"].toString().toUInt());
     setNodeData(restoredNodeId, NodeRole::OutPortCount,nodeJson["outPortCount"].toString().toUInt());
@@ -403,7 +604,8 @@ void DynamicPortsModel::loadNode(QJsonObject const &nodeJson)
         setNodeData(restoredNodeId, NodeRole::Position, pos);
     }
 
-    Q_EMIT nodeCreated(restoredNodeId);
+    if (!inBatch())
+        Q_EMIT nodeCreated(restoredNodeId);
 }
 
 void DynamicPortsModel::load(QJsonObject const &jsonDocument)
@@ -428,280 +630,630 @@ void DynamicPortsModel::load(QJsonObject const &jsonDocument)
     }
 }
 
-Automaton* DynamicPortsModel::ToAutomaton() const
+QString DynamicPortsModel::GetNodeName(NodeId const nodeId) const
 {
-    if(_startStateId == 0)
-    {
-        qWarning() << "Start state not set!";
-        return nullptr;
-    }
+    const NodeSlot slot = slotOf(nodeId);
+    return (slot != InvalidSlot) ? _nodeNames[slot] : QString();
+}
 
-    Automaton* fsm = new Automaton();
+void DynamicPortsModel::SetNodeActionCode(NodeId const nodeId, QString code)
+{
+    const NodeSlot slot = slotOf(nodeId);
+    if (slot == InvalidSlot)
+        return;
 
-    for(const NodeId& id :_nodeIds)
-    {
-        // find the data for the current NodeId
-        auto nodeActionCode = _nodeActionCodes.find(id)->second;
-        auto nodeName = _nodeNames.find(id)->second;
-        auto isFinal = _nodeFinalStates.find(id)->second;
-
-        fsm->setName(fsmName.toStdString());
-        fsm->setDescription("Description"); // TODO
-        fsm->addState(nodeName.toStdString(), nodeActionCode.toStdString());
-        if(isFinal)
-        {
-            fsm->addFinalState(nodeName.toStdString());
-        }
+    std::string_view &lazy = _lazyActionCodes[slot];
+    QString &current = _nodeActionCodes[slot];
+    if (lazy.data() || current != code)
+        markChanged();
+    lazy = std::string_view();
+    current = std::move(code);
+    if (_searchIndexed)
+        _actionSearch.set(nodeId, current.toStdString());
+}
+
+QString DynamicPortsModel::GetNodeActionCode(NodeId const nodeId)
+{
+    const NodeSlot slot = slotOf(nodeId);
+    if (slot == InvalidSlot)
+        return QString();
+
+    std::string_view &lazy = _lazyActionCodes[slot];
+    if (lazy.data()) {
+        _nodeActionCodes[slot] = QString::fromStdString(_lazySource->action(lazy));
+        lazy = std::string_view();
     }
+    return _nodeActionCodes[slot];
+}
 
-    for(const ConnectionId& connId : _connectivity)
-    {
-        // extract the data for this transtiiton
-        auto fromNodeName = _nodeNames.find(connId.outNodeId)->second;
-        auto toNodeName = _nodeNames.find(connId.inNodeId)->second;
-        auto transitionCode = _connectionCodes.find(connId)->second;
-        auto transitionDelay = _connectionDelays.find(connId)->second;
+void DynamicPortsModel::SetNodeFinalState(NodeId const nodeId, bool value)
+{
+    const NodeSlot slot = slotOf(nodeId);
+    if (slot == InvalidSlot || _nodeFinalStates[slot] == value)
+        return;
+    _nodeFinalStates[slot] = value;
+    markChanged();
+}
 
-        // create a transition isntance
-        Transition trans;
-        trans.fromState = fromNodeName.toStdString();
-        trans.toState = toNodeName.toStdString();
-        trans.condition = transitionCode.toStdString();
-        trans.delay = transitionDelay;
+bool DynamicPortsModel::GetNodeFinalState(NodeId const nodeId) const
+{
+    const NodeSlot slot = slotOf(nodeId);
+    return slot != InvalidSlot && _nodeFinalStates[slot];
+}
 
-        // add it to the fsm
-        fsm->addTransition(trans);
-    }
+void DynamicPortsModel::SetNodeInstance(NodeId const nodeId, std::optional<SubAutomatonInstance> instance)
+{
+    if (!nodeExists(nodeId))
+        return;
+    markChanged();
+    if (instance)
+        _nodeInstances[nodeId] = std::move(*instance);
+    else
+        _nodeInstances.erase(nodeId);
+}
 
-    for (const auto& varInfo : variables)
-    {
-        fsm->addVariable(varInfo.name, varInfo.value, varInfo.type);
+QString DynamicPortsModel::GetConnectionCode(ConnectionId const connId)
+{
+    auto lazy = _lazyConnectionCodes.find(connId);
+    if (lazy != _lazyConnectionCodes.end()) {
+        _connectionCodes[connId] = QString::fromStdString(_lazySource->condition(lazy->second));
+        _lazyConnectionCodes.erase(lazy);
     }
+    return _connectionCodes[connId];
+}
+
+std::string DynamicPortsModel::actionCodeUtf8(NodeSlot const slot) const
+{
+    // exported texts are read from the source without keeping a copy
+    if (_lazyActionCodes[slot].data())
+        return _lazySource->action(_lazyActionCodes[slot]);
+    return _nodeActionCodes[slot].toStdString();
+}
+
+std::string DynamicPortsModel::connectionCodeUtf8(ConnectionId const connId) const
+{
+    auto lazy = _lazyConnectionCodes.find(connId);
+    if (lazy != _lazyConnectionCodes.end())
+        return _lazySource->condition(lazy->second);
+    auto code = _connectionCodes.find(connId);
+    return (code != _connectionCodes.end()) ? code->second.toStdString() : std::string();
+}
+
+std::string DynamicPortsModel::GetNodeActionCodeUtf8(NodeId const nodeId) const
+{
+    const NodeSlot slot = slotOf(nodeId);
+    return slot != InvalidSlot ? actionCodeUtf8(slot) : std::string();
+}
 
-    // set the Start node
-    auto startNodeName = _nodeNames.find(_startStateId)->second;
-    fsm->setStartState(startNodeName.toStdString());
+ValidationGraph DynamicPortsModel::ToValidationGraph() const
+{
+    ValidationGraph graph;
+    graph.states.reserve(_nodeIds.size());
+    for (NodeSlot slot = 0; slot < _nodeIds.size(); ++slot)
+        graph.states.push_back({_nodeIds[slot], _nodeNames[slot].toStdString(), _nodeFinalStates[slot]});
+
+    graph.transitions.reserve(_connectivity.size());
+    for (const ConnectionId& connId : _connectivity)
+        graph.transitions.push_back(ToTransitionKey(connId));
 
-    return fsm;
+    graph.startState = _startStateId;
+    return graph;
 }
 
-void DynamicPortsModel::writeNodeData(ofstream& os, NodeId const nodeId) const
+void DynamicPortsModel::materializeLazyText()
 {
-    const auto nodeName = nodeData(nodeId, NodeRole::Caption).value<QString>();
-    const auto pos = nodeData(nodeId, NodeRole::Position).value<QPointF>();
-    const auto inPortCount  = nodeData(nodeId, NodeRole::InPortCount).value<unsigned int>();
-    const auto outPortCount = nodeData(nodeId, NodeRole::OutPortCount).value<unsigned int>();
+    for (size_t slot = 0; slot < _lazyActionCodes.size(); ++slot) {
+        std::string_view &ref = _lazyActionCodes[slot];
+        if (ref.data())
+            _nodeActionCodes[slot] = QString::fromStdString(_lazySource->action(ref));
+        ref = std::string_view();
+    }
+    for (const auto& [connId, ref] : _lazyConnectionCodes)
+        _connectionCodes[connId] = QString::fromStdString(_lazySource->condition(ref));
+    _lazyConnectionCodes.clear();
+    _lazySource.reset();
+}
 
-    os << "#" << nodeName.toStdString() << ";" << pos.x() << ";" << pos.y() << ";" << inPortCount << ";" << outPortCount << "\n";
+void DynamicPortsModel::buildSearchIndex()
+{
+    ICP_TRACE_SCOPE("DynamicPortsModel::buildSearchIndex");
+
+    for (NodeSlot slot = 0; slot < _nodeIds.size(); ++slot) {
+        _nameSearch.set(_nodeIds[slot], _nodeNames[slot].toStdString());
+        _actionSearch.set(_nodeIds[slot], actionCodeUtf8(slot));
+    }
+    _searchIndexed = true;
+
+    // the lazy conditions are read from the source, they stay lazy
+    for (const ConnectionId& connId : _connectivity) {
+        const std::string code = connectionCodeUtf8(connId);
+        if (code.empty())
+            continue;
+        const TextIndex::Key key = _nextConditionSearchKey++;
+        _conditionSearchKeys.emplace(connId, key);
+        _conditionSearchConnections.emplace(key, connId);
+        _conditionSearch.set(key, code);
+    }
 }
 
-void DynamicPortsModel::ToFile(std::string const filename) const
+void DynamicPortsModel::dropSearchIndex()
 {
-    auto automaton = this->ToAutomaton();
+    _nameSearch.clear();
+    _actionSearch.clear();
+    _conditionSearch.clear();
+    _conditionSearchKeys.clear();
+    _conditionSearchConnections.clear();
+    _nextConditionSearchKey = 0;
+    _searchIndexed = false;
+}
 
-    ofstream out(filename);
-    if (!out.is_open()) {
-        cerr << "Failed to open file: " << filename << endl;
+void DynamicPortsModel::indexCondition(ConnectionId const connId, QString const &code)
+{
+    auto it = _conditionSearchKeys.find(connId);
+    if (code.isEmpty()) {
+        if (it != _conditionSearchKeys.end()) {
+            _conditionSearch.remove(it->second);
+            _conditionSearchConnections.erase(it->second);
+            _conditionSearchKeys.erase(it);
+        }
         return;
     }
 
-    // writes nodes data to the begining of the file in the following format:
-    // #state_name;pos_x;pos_y;out_port_count;in_port_count
-    for(const auto nodeId : _nodeIds)
-    {
-        writeNodeData(out, nodeId);
+    if (it == _conditionSearchKeys.end()) {
+        it = _conditionSearchKeys.emplace(connId, _nextConditionSearchKey++).first;
+        _conditionSearchConnections.emplace(it->second, connId);
     }
+    _conditionSearch.set(it->second, code.toStdString());
+}
+
+std::vector<DynamicPortsModel::SearchMatch> DynamicPortsModel::Search(QString const &text, std::size_t limit)
+{
+    ICP_TRACE_SCOPE("DynamicPortsModel::Search");
+
+    if (!_searchIndexed)
+        buildSearchIndex();
+
+    std::vector<SearchMatch> matches;
+    const std::string query = text.toStdString();
+    std::unordered_set<NodeId> foundNodes;
+
+    auto addNodes = [&](TextIndex const &index, TextMatch match, SearchMatch::Field field) {
+        if (matches.size() >= limit)
+            return;
+        // the states found already may be among the keys, up to limit of them
+        for (TextIndex::Key key : index.find(query, match, limit)) {
+            const NodeId nodeId = static_cast<NodeId>(key);
+            if (matches.size() < limit && foundNodes.insert(nodeId).second)
+                matches.push_back({field, nodeId});
+        }
+    };
 
-    // AUTOMATON block
-    out << "AUTOMATON " << automaton->getName() << "\n";
-    out << "    DESCRIPTION \"" << automaton->getDescription() << "\"\n";
-    out << "    START " << automaton->getStartName() << "\n";
+    addNodes(_nameSearch, TextMatch::Prefix, SearchMatch::Field::Name);
+    addNodes(_nameSearch, TextMatch::Substring, SearchMatch::Field::Name);
+    addNodes(_actionSearch, TextMatch::Substring, SearchMatch::Field::Action);
 
-    // Final states
-    const auto& finals = automaton->getFinalStates();
-    out << "    FINISH [";
-    for (size_t i = 0; i < finals.size(); ++i) {
-        out << finals[i];
-        if (i != finals.size() - 1) out << ", ";
+    if (matches.size() < limit) {
+        for (TextIndex::Key key : _conditionSearch.find(query, TextMatch::Substring, limit - matches.size())) {
+            const ConnectionId& connId = _conditionSearchConnections.at(key);
+            matches.push_back({SearchMatch::Field::Condition, connId.outNodeId, connId});
+        }
     }
-    out << "]\n";
 
-    // Variables block
-    out << "    VARS\n";
-    for (const auto& varInfo : automaton->getVariables())
+    return matches;
+}
+
+std::unique_ptr<Automaton> DynamicPortsModel::ToAutomaton() const
+{
+    ICP_TRACE_SCOPE("DynamicPortsModel::ToAutomaton");
+
+    if(_startStateId == 0)
     {
-        auto type = Automaton::varDataTypeAsString(varInfo.type);
-        out << "        " << type << " " << varInfo.name << " = " << varInfo.value << "\n";
+        qWarning() << "Start state not set!";
+        return nullptr;
     }
-    out << "    END\n\n";
 
-    // States
-    for (const auto& [stateName, action] : automaton->getStates()) {
-        out << "STATE " << stateName << "\n";
-        out << "    ACTION\n";
+    AutomatonBuilder fsm;
+    fsm.reserve(_nodeIds.size(), _connectivity.size(), variables.size());
+    fsm.name(fsmName.toStdString());
+    fsm.description(fsmDescription.toStdString());
 
-        // Print action line by line (simulate user script with newlines)
-        istringstream stream(action);
-        string line;
-        while (getline(stream, line)) {
-            out << "        " << line << "\n";
+    // every name is converted and interned once, the transitions reuse the symbols
+    std::vector<Symbol> stateNames;
+    stateNames.reserve(_nodeIds.size());
+    for(NodeSlot slot = 0; slot < _nodeIds.size(); ++slot)
+    {
+        const Symbol stateName(_nodeNames[slot].toStdString());
+        stateNames.push_back(stateName);
+
+        // an instance is named by its node, its states come from the definition
+        auto instance = _nodeInstances.find(_nodeIds[slot]);
+        if(instance != _nodeInstances.end())
+        {
+            SubAutomatonInstance named = instance->second;
+            named.name = stateName.str();
+            fsm.instance(std::move(named));
         }
+        else
+        {
+            fsm.state(stateName, actionCodeUtf8(slot));
+        }
+        if(_nodeFinalStates[slot])
+        {
+            fsm.finalState(stateName);
+        }
+    }
+
+    // the transitions of a state keep the order of its out-ports, which is their priority
+    std::vector<ConnectionId> connections(_connectivity.begin(), _connectivity.end());
+    std::sort(connections.begin(), connections.end(), [](const ConnectionId& a, const ConnectionId& b) {
+        return std::tie(a.outNodeId, a.outPortIndex, a.inNodeId, a.inPortIndex)
+               < std::tie(b.outNodeId, b.outPortIndex, b.inNodeId, b.inPortIndex);
+    });
+    for(const ConnectionId& connId : connections)
+    {
+        auto delay = _connectionDelays.find(connId);
+        fsm.transition(stateNames[slotOf(connId.outNodeId)], stateNames[slotOf(connId.inNodeId)],
+                       connectionCodeUtf8(connId), delay != _connectionDelays.end() ? delay->second : 0);
+    }
 
-        out << "    END\n\n";
+    for (const auto& varInfo : variables)
+    {
+        fsm.variable(varInfo.name, varInfo.value, varInfo.type);
+    }
+    for (const auto& definition : _definitions)
+    {
+        fsm.definition(definition);
     }
 
-    // Transitions
-    for (const auto& t : automaton->getTransitions()) {
-        out << "TRANSITION " << t.fromState << " -> " << t.toState << "\n";
-        out << "    CONDITION " << t.condition << "\n";
-        out << "    DELAY " << t.delay << "\n\n";
+    // set the Start node, it may have been deleted
+    const NodeSlot startSlot = slotOf(_startStateId);
+    if(startSlot == InvalidSlot)
+    {
+        qWarning() << "Start state not set!";
+        return nullptr;
     }
+    fsm.start(stateNames[startSlot]);
 
-    out << "END\n";
-    out.close();
+    return fsm.buildUnique();
 }
 
-struct StateInfo {
-    std::string name;
-    int posX;
-    int posY;
-    int inPortCount;
-    int outPortCount;
-};
-
-std::vector<StateInfo> loadStateInfo(const std::string& filename)
+void DynamicPortsModel::ToFile(std::string const filename)
 {
-    std::string line;
-    std::ifstream fstream(filename);
-    std::vector<StateInfo> result;
+    ICP_TRACE_SCOPE("DynamicPortsModel::ToFile");
+
+    // the mapped texts would change under the lazy references
+    if (_lazySource && QFileInfo(QString::fromStdString(filename)) == QFileInfo(QString::fromStdString(_lazySource->filename())))
+        materializeLazyText();
 
-    while(std::getline(fstream, line))
+    if (AutomatonBinary::IsBinaryFile(filename))
     {
-        if(line.empty() || line[0] != '#')
-            break;
+        std::unique_ptr<Automaton> automaton = ToAutomaton();
+        if (!automaton)
+            return;
+
+        std::vector<StateInfo> statesInfo;
+        statesInfo.reserve(_nodeIds.size());
+        for(NodeSlot slot = 0; slot < _nodeIds.size(); ++slot)
+        {
+            if (_nodeInstances.count(_nodeIds[slot]))
+                continue;
+            const QPointF pos = _nodeGeometryData[slot].pos;
+            statesInfo.push_back({_nodeNames[slot].toStdString(),
+                                  static_cast<int>(pos.x()), static_cast<int>(pos.y()),
+                                  static_cast<int>(_nodePortCounts[slot].in),
+                                  static_cast<int>(_nodePortCounts[slot].out)});
+        }
+        if (_nodeInstances.empty())
+        {
+            AutomatonBinary::ToFile(filename, *automaton, &statesInfo);
+            return;
+        }
 
-        line = line.substr(1); // ignore the initial #
-        std::stringstream ss(line);
-        std::string token;
-        StateInfo info;
+        // the binary format has no sub-automata, an instance is saved as its states,
+        // in a column below the instance node with as many ports as they have transitions
+        std::vector<std::string> errors;
+        const Automaton expanded = expandSubAutomata(*automaton, &errors);
+        for (const std::string &error : errors)
+            qWarning() << QString::fromStdString(error);
 
-        std::getline(ss, info.name, ';');
+        std::unordered_map<Symbol, NodePortCount> degrees;
+        for (const Transition &t : expanded.getTransitions())
+        {
+            ++degrees[t.fromState].out;
+            ++degrees[t.toState].in;
+        }
+        std::vector<Symbol> instanceStates;
+        for (const auto &state : expanded.getStates())
+        {
+            if (state.first.str().find('.') != std::string::npos && !_nodeIdsByName.contains(QString::fromStdString(state.first)))
+                instanceStates.push_back(state.first);
+        }
+        std::sort(instanceStates.begin(), instanceStates.end());
 
-        std::getline(ss, token, ';');
-        info.posX = std::stoi(token);
+        std::unordered_map<NodeId, int> column;
+        for (Symbol name : instanceStates)
+        {
+            const NodeId nodeId = findNodeByName(QString::fromStdString(name));
+            const NodeSlot slot = slotOf(nodeId);
+            const QPointF pos = (slot != InvalidSlot) ? _nodeGeometryData[slot].pos : QPointF();
+            const int row = ++column[nodeId];
+            statesInfo.push_back({name.str(), static_cast<int>(pos.x()), static_cast<int>(pos.y()) + 80 * row,
+                                  static_cast<int>(degrees[name].in), static_cast<int>(degrees[name].out)});
+        }
+        AutomatonBinary::ToFile(filename, expanded, &statesInfo);
+        return;
+    }
 
-        std::getline(ss, token, ';');
-        info.posY = std::stoi(token);
+    if(_startStateId == 0)
+    {
+        qWarning() << "Start state not set!";
+        return;
+    }
 
-        std::getline(ss, token, ';');
-        info.inPortCount = std::stoi(token);
+    // the text format is written straight from the shared names and codes
+    if (!writeFsmText(TakeSnapshot(), filename))
+        cerr << "Failed to write file: " << filename << endl;
+}
 
-        std::getline(ss, token, ';');
-        info.outPortCount = std::stoi(token);
+FsmSnapshot DynamicPortsModel::TakeSnapshot() const
+{
+    FsmSnapshot snapshot;
+    snapshot.generation = _generation;
+    snapshot.name = fsmName;
+    snapshot.description = fsmDescription;
+    snapshot.variables = variables;
+    snapshot.definitions = _definitions;
+    snapshot.source = _lazySource;
+
+    // the snapshot nodes are in slot order, a slot is the index of its node
+    const NodeSlot startSlot = slotOf(_startStateId);
+    if (startSlot != InvalidSlot)
+        snapshot.startNode = static_cast<int>(startSlot);
+
+    snapshot.nodes.reserve(_nodeIds.size());
+    for(NodeSlot slot = 0; slot < _nodeIds.size(); ++slot)
+    {
+        SnapshotNode node;
+        node.name = _nodeNames[slot];
+        node.posX = static_cast<int>(_nodeGeometryData[slot].pos.x());
+        node.posY = static_cast<int>(_nodeGeometryData[slot].pos.y());
+        node.inPortCount = static_cast<int>(_nodePortCounts[slot].in);
+        node.outPortCount = static_cast<int>(_nodePortCounts[slot].out);
+        node.isFinal = _nodeFinalStates[slot];
+
+        if (auto instance = _nodeInstances.find(_nodeIds[slot]); instance != _nodeInstances.end()) {
+            snapshot.instances.push_back(instance->second);
+            snapshot.instances.back().name = node.name.toStdString();
+        }
+        if (_lazyActionCodes[slot].data()) {
+            node.lazyAction = _lazyActionCodes[slot];
+            node.lazyActionSet = true;
+        } else {
+            node.action = _nodeActionCodes[slot];
+        }
+        snapshot.nodes.push_back(std::move(node));
+    }
 
-        result.push_back(info);
+    snapshot.connections.reserve(_connectivity.size());
+    for(const ConnectionId& connId : _connectivity)
+    {
+        SnapshotConnection connection;
+        connection.outNode = slotOf(connId.outNodeId);
+        connection.inNode = slotOf(connId.inNodeId);
+        auto delay = _connectionDelays.find(connId);
+        connection.delay = (delay != _connectionDelays.end()) ? delay->second : 0;
+
+        auto lazy = _lazyConnectionCodes.find(connId);
+        if (lazy != _lazyConnectionCodes.end()) {
+            connection.lazyCondition = lazy->second;
+            connection.lazyConditionSet = true;
+        } else if (auto code = _connectionCodes.find(connId); code != _connectionCodes.end()) {
+            connection.condition = code->second;
+        }
+        snapshot.connections.push_back(std::move(connection));
     }
 
-    return result;
+    return snapshot;
+}
+
+void DynamicPortsModel::AddMemoryUsage(MemoryReport &report) const
+{
+    // a QWidget with its private data, layout and style data, roughly
+    constexpr std::size_t widgetBytes = 1024;
+
+    const std::size_t nodes = _nodeIds.size();
+    std::size_t nodeBytes = MemoryReport::hashedBytes(_nodeSlots) + MemoryReport::vectorBytes(_nodeIds)
+                            + MemoryReport::vectorBytes(_nodeNames) + _nodeFinalStates.capacity() / 8
+                            + MemoryReport::vectorBytes(_nodeGeometryData) + MemoryReport::vectorBytes(_nodePortCounts)
+                            + MemoryReport::vectorBytes(_nodeWidgets)
+                            + static_cast<std::size_t>(_nodeIdsByName.size()) * (sizeof(QString) + sizeof(NodeId) + 2 * sizeof(void *))
+                            + MemoryReport::hashedBytes(_nodeHeat) + MemoryReport::hashedBytes(_nodeProblems);
+    for (QString const &name : _nodeNames)
+        nodeBytes += MemoryReport::stringBytes(name);
+    for (auto const &problem : _nodeProblems)
+        nodeBytes += MemoryReport::stringBytes(problem.second);
+    report.add("Model: nodes", nodes, nodeBytes);
+
+    std::size_t actionBytes = MemoryReport::vectorBytes(_nodeActionCodes) + MemoryReport::vectorBytes(_lazyActionCodes);
+    for (QString const &code : _nodeActionCodes)
+        actionBytes += MemoryReport::stringBytes(code);
+    report.add("Model: actions", nodes, actionBytes);
+
+    std::size_t connectionBytes = MemoryReport::hashedBytes(_connectivity) + MemoryReport::hashedBytes(_connectionCodes)
+                                  + MemoryReport::hashedBytes(_lazyConnectionCodes)
+                                  + MemoryReport::hashedBytes(_connectionDelays)
+                                  + MemoryReport::hashedBytes(_connectionHeat)
+                                  + MemoryReport::hashedBytes(_nodeConnections)
+                                  + MemoryReport::hashedBytes(_portConnections);
+    for (auto const &code : _connectionCodes)
+        connectionBytes += MemoryReport::stringBytes(code.second);
+    for (auto const &adjacent : _nodeConnections)
+        connectionBytes += MemoryReport::hashedBytes(adjacent.second);
+    for (auto const &adjacent : _portConnections)
+        connectionBytes += MemoryReport::hashedBytes(adjacent.second);
+    report.add("Model: connections", _connectivity.size(), connectionBytes);
+
+    if (_searchIndexed) {
+        report.add("Model: search index", _nameSearch.size() + _actionSearch.size() + _conditionSearch.size(),
+                   _nameSearch.byteSize() + _actionSearch.byteSize() + _conditionSearch.byteSize()
+                       + MemoryReport::hashedBytes(_conditionSearchKeys)
+                       + MemoryReport::hashedBytes(_conditionSearchConnections));
+    }
+
+    std::size_t widgets = 0;
+    for (PortAddRemoveWidget const *w : _nodeWidgets) {
+        if (w)
+            widgets += 1 + static_cast<std::size_t>(w->findChildren<QWidget *>().size());
+    }
+    report.add("Model: port widgets", widgets, widgets * (sizeof(PortAddRemoveWidget) + widgetBytes));
+
+    if (!_definitions.empty() || !_nodeInstances.empty()) {
+        std::size_t subBytes = MemoryReport::vectorBytes(_definitions) + MemoryReport::hashedBytes(_nodeInstances);
+        for (auto const &definition : _definitions) {
+            subBytes += sizeof(Automaton) + MemoryReport::hashedBytes(definition->getStates())
+                        + definition->getTransitions().capacity() * sizeof(Transition);
+            for (auto const &state : definition->getStates())
+                subBytes += state.second.capacity();
+        }
+        report.add("Model: sub-automata", _definitions.size() + _nodeInstances.size(), subBytes);
+    }
+
+    // a lazy load keeps the file mapped, its pages are shared with the page cache
+    if (_lazySource) {
+        std::error_code error;
+        const auto fileBytes = std::filesystem::file_size(_lazySource->filename(), error);
+        report.add("Model: mapped file", 1, error ? 0 : static_cast<std::size_t>(fileBytes));
+    }
 }
 
-void trimLeadingWhitespace(std::string& str)
+void DynamicPortsModel::SetVariables(std::vector<VariableInfo> newVariables)
 {
-    str.erase(str.begin(), std::find_if(str.begin(), str.end(), [](unsigned char ch) { return !std::isspace(ch); }));
+    auto same = [](const VariableInfo& a, const VariableInfo& b) {
+        return a.name == b.name && a.value == b.value && a.type == b.type;
+    };
+    if (!std::equal(variables.begin(), variables.end(), newVariables.begin(), newVariables.end(), same))
+        markChanged();
+    variables = std::move(newVariables);
 }
 
 void DynamicPortsModel::FromFile(std::string const filename)
 {
+    ICP_TRACE_SCOPE("DynamicPortsModel::FromFile");
+
+    LoadedGraph graph;
+    loadGraph(filename, graph);
+    ApplyLoadedGraph(graph);
+}
+
+void DynamicPortsModel::ApplyLoadedGraph(LoadedGraph const &graph)
+{
+    ICP_TRACE_SCOPE("DynamicPortsModel::ApplyLoadedGraph");
+
+    // the scene is rebuilt once when the batch ends instead of per node and connection
+    BatchUpdate batch(*this);
+
     Reset();
 
-    // 1) Load node positions and port counts:
-    auto statesInfo = loadStateInfo(filename);
-    for(auto& s : statesInfo)
+    // 1) Nodes with their positions, port counts and state data
+    std::vector<NodeId> nodeIds;
+    nodeIds.reserve(graph.nodes.size());
+    for(const auto& node : graph.nodes)
     {
         NodeId id = addNode();
-        setNodeData(id, NodeRole::Position, QPointF(s.posX, s.posY));
-        setNodeData(id, NodeRole::InPortCount, s.inPortCount);
-        setNodeData(id, NodeRole::OutPortCount, s.outPortCount);
-        SetNodeName(id, QString::fromStdString(s.name));
+        nodeIds.push_back(id);
+        setNodeData(id, NodeRole::Position, QPointF(node.posX, node.posY));
+        setNodeData(id, NodeRole::InPortCount, node.inPortCount);
+        setNodeData(id, NodeRole::OutPortCount, node.outPortCount);
+        SetNodeName(id, QString::fromStdString(node.name));
+
+        // a lazy node without an action keeps a null reference and an empty code
+        const NodeSlot slot = slotOf(id);
+        if(graph.source) {
+            _lazyActionCodes[slot] = node.actionRef;
+            _nodeActionCodes[slot].clear();
+        } else {
+            _nodeActionCodes[slot] = QString::fromStdString(node.action);
+        }
+        _nodeFinalStates[slot] = node.isFinal;
 
         forceNodeUiUpdate(id);
     }
+    if(graph.startNode >= 0)
+        _startStateId = nodeIds[graph.startNode];
+    _lazySource = graph.source;
 
-    // 2) Load automaton internal data:
-    Automaton automaton;
-    AutomatonParser::FromFile(filename, automaton);
-    for(auto& nodeId: _nodeIds)
+    // 2) Automaton data
+    for(const auto& var : graph.variables)
     {
-        std::string code = automaton.getStateAction((_nodeNames.at(nodeId).toStdString()));
-        trimLeadingWhitespace(code);
-        _nodeActionCodes[nodeId] = QString::fromStdString(code);
+        variables.push_back(var);
     }
-
-    auto finalStateNames = automaton.getFinalStates();
-    for(auto& nodeId: _nodeIds)
+    fsmName = QString::fromStdString(graph.name);
+    fsmDescription = QString::fromStdString(graph.description);
+    _definitions = graph.definitions;
+    for(const auto& instance : graph.instances)
     {
-        auto nodeName = _nodeNames.at(nodeId).toStdString();
-        if(std::find(finalStateNames.begin(), finalStateNames.end(), nodeName) != finalStateNames.end())
-        {
-            _nodeFinalStates[nodeId] = true;
-        }
+        const NodeId id = findNodeByName(QString::fromStdString(instance.name));
+        if(id != InvalidNodeId)
+            _nodeInstances[id] = instance;
     }
 
-    auto startNodeName = automaton.getStartName();
-    for(auto& nodeId: _nodeIds)
+    // 3) Connect states with transitions, ports are resolved by the loader
+    for(const auto& connection : graph.connections)
     {
-        if(_nodeNames.at(nodeId).toStdString() == startNodeName)
-        {
-            _startStateId = nodeId;
-            break;
-        }
-    }
+        ConnectionId connId{ nodeIds[connection.outNode], connection.outPort, nodeIds[connection.inNode], connection.inPort };
+        addConnection(connId);
 
-    for(auto var : automaton.getVariables())
-    {
-        variables.push_back(var);
+        // add action code and delay to connection
+        if(graph.source)
+            _lazyConnectionCodes[connId] = connection.conditionRef;
+        else
+            _connectionCodes[connId] = QString::fromStdString(connection.condition);
+        _connectionDelays[connId] = connection.delay;
     }
-    fsmName = QString::fromStdString(automaton.getName());
-
-    // 3) Connect states with transitions
-    QMap<NodeId, NodeId> nextFreeInPortIndex; // to keep track of each nodes used InPort indexes
-    // iterate all nodes:
-    for(auto& nodeId : _nodeIds)
-    {
-        // get vector transitions coming out from this node (out ports)
-        auto transitionsFrom = automaton.getTransitionsFrom(_nodeNames.at(nodeId).toStdString());
-
-        // iterate transition coming out of this node and make those connections:
-        uint outPortIdx = 0;
-        for(auto& t : transitionsFrom)
-        {
-            // find the NodeId by name of the node we are connecting to
-            NodeId toStateNodeId = 0;
-            for (const auto& [key, value] : _nodeNames)
-                if (value ==  QString::fromStdString(t.toState) )
-                    toStateNodeId = key;
+}
 
-            // find the first free InPort index of the node we want to make transition to:
-            NodeId inPortIdx = nextFreeInPortIndex.value(toStateNodeId, 0); // default to 0
+LayoutGraph DynamicPortsModel::BuildLayoutGraph(std::vector<NodeId> &nodeIds) const
+{
+    // sorted, so the same graph always gives the same layout
+    nodeIds.assign(_nodeIds.begin(), _nodeIds.end());
+    std::sort(nodeIds.begin(), nodeIds.end());
+
+    // layout index of every slot
+    std::vector<uint32_t> index(_nodeIds.size());
+
+    LayoutGraph graph;
+    graph.nodeCount = static_cast<uint32_t>(nodeIds.size());
+    graph.positions.reserve(nodeIds.size());
+    for (NodeId nodeId : nodeIds) {
+        const NodeSlot slot = slotOf(nodeId);
+        index[slot] = static_cast<uint32_t>(graph.positions.size());
+        const QPointF pos = _nodeGeometryData[slot].pos;
+        graph.positions.push_back(LayoutPoint{pos.x(), pos.y()});
+    }
 
-             // make the actual connection between two of the nodes:
-            ConnectionId connId{ nodeId, outPortIdx, toStateNodeId, inPortIdx };
-            addConnection(connId);
+    graph.edges.reserve(_connectivity.size());
+    for (const auto &connectionId : _connectivity)
+        graph.edges.emplace_back(index[slotOf(connectionId.outNodeId)], index[slotOf(connectionId.inNodeId)]);
 
-            // Update the next free in-port index for this node
-            nextFreeInPortIndex[toStateNodeId] = inPortIdx + 1;
+    return graph;
+}
 
-            // add action code and delay to connection
-            _connectionCodes[connId] = QString::fromStdString(t.condition);
-            _connectionDelays[connId] = t.delay;
+void DynamicPortsModel::ApplyLayout(std::vector<NodeId> const &nodeIds,
+                                    std::vector<LayoutPoint> const &positions)
+{
+    // one modelReset() instead of a position update per node
+    BatchUpdate batch(*this);
 
-            outPortIdx++;
-        }
+    for (size_t i = 0; i < nodeIds.size() && i < positions.size(); ++i) {
+        if (nodeExists(nodeIds[i]))
+            setNodeData(nodeIds[i], NodeRole::Position, QPointF(positions[i].x, positions[i].y));
     }
 }
 
 void DynamicPortsModel::Reset()
 {
+    BatchUpdate batch(*this);
+
     auto nodeIdsCopy = _nodeIds;
     for (auto nodeId : nodeIdsCopy)
     {
@@ -710,21 +1262,56 @@ void DynamicPortsModel::Reset()
 
    
 
-    _nodeActionCodes.clear();
-    _nodeFinalStates.clear();
-    _nodeGeometryData.clear();
+    _nodeSlots.clear();
     _nodeIds.clear();
     _nodeNames.clear();
     _nodeActionCodes.clear();
+    _nodeFinalStates.clear();
+    _nodeGeometryData.clear();
+    _nodePortCounts.clear();
+    _nodeWidgets.clear();
+    _nodeIdsByName.clear();
     _connectionCodes.clear();
+    _lazyActionCodes.clear();
+    _lazyConnectionCodes.clear();
+    _lazySource.reset();
+    dropSearchIndex();
     _connectionDelays.clear();
+    _definitions.clear();
+    _nodeInstances.clear();
     _connectivity.clear();
-    _nodePortCounts.clear();
-    _nodeWidgets.clear();
+    _nodeConnections.clear();
+    _portConnections.clear();
     variables.clear();
 
     _startStateId = 0;
+    _liveNodeId = InvalidNodeId;
+    _liveConnection.reset();
+    _nodeHeat.clear();
+    _connectionHeat.clear();
+    _nodeProblems.clear();
     _nextNodeId = 1;
+    markChanged();
+}
+
+void DynamicPortsModel::beginBatch()
+{
+    ++_batchDepth;
+}
+
+void DynamicPortsModel::endBatch()
+{
+    if (_batchDepth == 0 || --_batchDepth > 0)
+        return;
+
+    Q_EMIT modelReset();
+
+    for (NodeId id : _batchForcedWidths) {
+        const NodeSlot slot = slotOf(id);
+        if (slot != InvalidSlot)
+            _nodeGeometryData[slot].size.setWidth(290);
+    }
+    _batchForcedWidths.clear();
 }
 
 void DynamicPortsModel::addPort(NodeId nodeId, PortType portType, PortIndex portIndex)
@@ -737,15 +1324,18 @@ void DynamicPortsModel::addPort(NodeId nodeId, PortType portType, PortIndex port
     portsAboutToBeInserted(nodeId, portType, first, last);
 
     // STAGE 2. Change the number of connections in your model
+    NodePortCount &ports = _nodePortCounts[slotOf(nodeId)];
     if (portType == PortType::In)
-        _nodePortCounts[nodeId].in++;
+        ports.in++;
     else
-        _nodePortCounts[nodeId].out++;
+        ports.out++;
+    markChanged();
 
-    // STAGE 3. Re-create previouly existed and now shifted connections
+    // STAGE 3. Re-index the shifted connections in place
     portsInserted();
 
-    Q_EMIT nodeUpdated(nodeId);
+    if (!inBatch())
+        Q_EMIT nodeUpdated(nodeId);
 }
 
 void DynamicPortsModel::removePort(NodeId nodeId, PortType portType, PortIndex portIndex)
@@ -758,12 +1348,16 @@ void DynamicPortsModel::removePort(NodeId nodeId, PortType portType, PortIndex p
     portsAboutToBeDeleted(nodeId, portType, first, last);
 
     // STAGE 2. Change the number of connections in your model
+    NodePortCount &ports = _nodePortCounts[slotOf(nodeId)];
     if (portType == PortType::In)
-        _nodePortCounts[nodeId].in--;
+        ports.in--;
     else
-        _nodePortCounts[nodeId].out--;
+        ports.out--;
+    markChanged();
 
+    // STAGE 3. Re-index the shifted connections in place
     portsDeleted();
 
-    Q_EMIT nodeUpdated(nodeId);
+    if (!inBatch())
+        Q_EMIT nodeUpdated(nodeId);
 }
@@ -31,12 +31,20 @@
 #include <QtNodes/ConnectionIdUtils>
 
 #include <QJsonArray>
+#include <QMultiHash>
 
 #include <iterator>
 #include <fstream>
 #include <iostream>
+#include <optional>
+#include <utility>
 
 #include "spec_parser/automaton-data.hpp"
+#include "layout/graph-layout.hpp"
+#include "load/fsm-snapshot.hpp"
+#include "load/graph-loader.hpp"
+#include "search/text-index.hpp"
+#include "validate/automaton-validator.hpp"
 #include <QtCore/QJsonObject>
 #include <QtCore/QPointF>
 #include <QtCore/QSize>
@@ -55,6 +63,7 @@ using PortType = QtNodes::PortType;
 using StyleCollection = QtNodes::StyleCollection;
 using QtNodes::InvalidNodeId;
 
+class MemoryReport;
 class PortAddRemoveWidget;
 
 /**
@@ -117,7 +126,7 @@ public:
      * @param nodeId The node ID.
      * @return The node name.
      */
-    QString GetNodeName(NodeId const nodeId) { return _nodeNames[nodeId]; }
+    QString GetNodeName(NodeId const nodeId) const;
 
     /**
      * @brief Sets the name of a node.
@@ -125,7 +134,6 @@ public:
      * @param name The new name.
      */
     void SetNodeName(NodeId const nodeId, QString name) {
-        _nodeNames[nodeId] = name;
         setNodeData(nodeId, QtNodes::NodeRole::Caption, QVariant::fromValue(name));
     }
 
@@ -134,48 +142,90 @@ public:
      * @param nodeId The node ID.
      * @param code The action code.
      */
-    void SetNodeActionCode(NodeId const nodeId, QString code) { _nodeActionCodes[nodeId] = code; }
+    void SetNodeActionCode(NodeId const nodeId, QString code);
 
     /**
      * @brief Gets the action code for a node.
+     *
+     * The action of a lazily loaded node is materialized by the first call.
      * @param nodeId The node ID.
      * @return The action code.
      */
-    QString GetNodeActionCode(NodeId const nodeId) { return _nodeActionCodes[nodeId]; }
+    QString GetNodeActionCode(NodeId const nodeId);
 
     /**
      * @brief Sets the condition code for a connection.
      * @param connId The connection ID.
      * @param code The condition code.
      */
-    void SetConnectionCode(ConnectionId const connId, QString code){ _connectionCodes[connId] = code; }
+    void SetConnectionCode(ConnectionId const connId, QString code)
+    {
+        QString& current = _connectionCodes[connId];
+        if (_lazyConnectionCodes.erase(connId) || current != code)
+            markChanged();
+        current = code;
+        if (_searchIndexed)
+            indexCondition(connId, current);
+    }
     
     /**
      * @brief Gets the condition code for a connection.
+     *
+     * The condition of a lazily loaded connection is materialized by the first call.
      * @param connId The connection ID.
      * @return The condition code.
      */
-    QString GetConnectionCode(ConnectionId const connId) { return _connectionCodes[connId]; }
+    QString GetConnectionCode(ConnectionId const connId);
+
+    /**
+     * @brief A state or a transition found by Search().
+     */
+    struct SearchMatch
+    {
+        enum class Field { Name, Action, Condition };
+
+        Field field;
+        NodeId nodeId;                  ///< the state, the source state of a condition
+        ConnectionId connectionId{};    ///< the transition of a condition
+    };
+
+    /**
+     * @brief Finds the states whose name or action and the transitions whose condition contain the text.
+     *
+     * The search ignores the case of ASCII letters. Names starting with the text come
+     * first, then the other names, the actions and the conditions. The first call
+     * builds the index, lazy texts are read without being materialized; the setters
+     * then keep it up to date, so a search does not scan the model.
+     * @param text The text to find.
+     * @param limit The maximum number of matches.
+     * @return The matches, a state or transition at most once.
+     */
+    std::vector<SearchMatch> Search(QString const &text, std::size_t limit);
 
     /**
      * @brief Sets whether a node is a final state.
      * @param nodeId The node ID.
      * @param value True if final state, false otherwise.
      */
-    void SetNodeFinalState(NodeId const nodeId, bool value){ _nodeFinalStates[nodeId] = value; }
+    void SetNodeFinalState(NodeId const nodeId, bool value);
     
     /**
      * @brief Gets whether a node is a final state.
      * @param nodeId The node ID.
      * @return True if final state, false otherwise.
      */
-    bool GetNodeFinalState(NodeId const nodeId) { return _nodeFinalStates[nodeId]; }
+    bool GetNodeFinalState(NodeId const nodeId) const;
 
     /**
      * @brief Sets the start node.
      * @param nodeId The node ID to set as start.
      */
-    void SetStartNode(NodeId const nodeId) { _startStateId = nodeId; }
+    void SetStartNode(NodeId const nodeId)
+    {
+        if (_startStateId != nodeId)
+            markChanged();
+        _startStateId = nodeId;
+    }
     
     /**
      * @brief Checks if a node is the start node.
@@ -183,13 +233,90 @@ public:
      * @return True if start node, false otherwise.
      */    
     bool IsStartNode(NodeId const nodeId) { return nodeId == _startStateId; }
+
+    /**
+     * @brief Marks the current state of the shown run, it is painted with NodeFlag::Live.
+     *
+     * Emits nothing, the caller repaints the node and the previous one.
+     * @param nodeId The node, InvalidNodeId clears the mark.
+     * @return The node that was live before, InvalidNodeId if none.
+     */
+    NodeId SetLiveNode(NodeId const nodeId)
+    {
+        return std::exchange(_liveNodeId, nodeId);
+    }
+
+    /**
+     * @brief Highlights the transition the shown run has just taken.
+     *
+     * Emits nothing, the caller repaints the connection and the previous one.
+     * @param connId The connection, nullopt clears the highlight.
+     * @return The connection highlighted before.
+     */
+    std::optional<ConnectionId> SetLiveConnection(std::optional<ConnectionId> const connId)
+    {
+        return std::exchange(_liveConnection, connId);
+    }
+
+    /**
+     * @brief Sets the profile heatmap, heats in [0, 1], missing items are cold.
+     *
+     * Emits nothing, the caller repaints the items of the previous and the new maps.
+     */
+    void SetHeat(std::unordered_map<NodeId, float> nodeHeat,
+                 std::unordered_map<ConnectionId, float> connectionHeat)
+    {
+        _nodeHeat = std::move(nodeHeat);
+        _connectionHeat = std::move(connectionHeat);
+    }
+
+    const std::unordered_map<NodeId, float>& NodeHeat() const { return _nodeHeat; }
+    const std::unordered_map<ConnectionId, float>& ConnectionHeat() const { return _connectionHeat; }
+
+    /**
+     * @brief Sets the problems found by the validation, one text per node, missing nodes have none.
+     *
+     * Emits nothing, the caller repaints the nodes of the previous and the new maps.
+     */
+    void SetNodeProblems(std::unordered_map<NodeId, QString> problems) { _nodeProblems = std::move(problems); }
+
+    const std::unordered_map<NodeId, QString>& NodeProblems() const { return _nodeProblems; }
+
+    /**
+     * @brief Copies the structure of the automaton so it can be validated on another thread.
+     */
+    ValidationGraph ToValidationGraph() const;
+
+    /**
+     * @brief Identifies a connection in a ValidationGraph.
+     */
+    static TransitionKey ToTransitionKey(ConnectionId const &connId)
+    {
+        return {connId.outNodeId, connId.outPortIndex, connId.inNodeId, connId.inPortIndex};
+    }
+
+    /**
+     * @brief Gets the action code of a node as UTF-8, a lazy action is not materialized.
+     */
+    std::string GetNodeActionCodeUtf8(NodeId const nodeId) const;
+
+    /**
+     * @brief Gets the condition code of a connection as UTF-8, a lazy condition is not materialized.
+     */
+    std::string GetConnectionCodeUtf8(ConnectionId const connId) const { return connectionCodeUtf8(connId); }
     
     /**
      * @brief Sets the delay (in ms) for a connection.
      * @param connId The connection ID.
      * @param value The delay in milliseconds.
      */
-    void SetConnectionDelay(ConnectionId const connId, int value) { _connectionDelays[connId] = value; }
+    void SetConnectionDelay(ConnectionId const connId, int value)
+    {
+        int& current = _connectionDelays[connId];
+        if (current != value)
+            markChanged();
+        current = value;
+    }
     
     /**
      * @brief Gets the delay (in ms) for a connection.
@@ -198,18 +325,92 @@ public:
      */
     int  GetConnectionDelay(ConnectionId const connId) { return _connectionDelays[connId]; }
 
+    /**
+     * @brief Sets the name of the automaton.
+     * @param name The new name.
+     */
+    void SetFsmName(QString const &name)
+    {
+        if (fsmName != name)
+            markChanged();
+        fsmName = name;
+    }
+
+    /**
+     * @brief Sets the variables of the automaton.
+     * @param newVariables The variable definitions, in order.
+     */
+    void SetVariables(std::vector<VariableInfo> newVariables);
+
+    /**
+     * @brief The sub-automaton definitions of the automaton, loaded from its file.
+     */
+    std::vector<std::shared_ptr<const Automaton>> const &Definitions() const { return _definitions; }
+
+    /**
+     * @brief Makes a node an instance of a sub-automaton definition, or a plain state again.
+     *
+     * An instance node has no action, its transitions go to the start state of the
+     * definition and leave from its final states, see expandSubAutomata(). The name of
+     * the instance is the name of the node.
+     * @param nodeId The node ID.
+     * @param instance The definition and bindings, nullopt for a plain state.
+     */
+    void SetNodeInstance(NodeId const nodeId, std::optional<SubAutomatonInstance> instance);
+
+    /**
+     * @brief Gets the instance of a node set by SetNodeInstance(), nullptr for a plain state.
+     */
+    SubAutomatonInstance const *GetNodeInstance(NodeId const nodeId) const
+    {
+        auto it = _nodeInstances.find(nodeId);
+        return it != _nodeInstances.end() ? &it->second : nullptr;
+    }
+
+    /**
+     * @brief Returns the generation of the model, bumped by every change of the saved data.
+     *
+     * Equal generations mean the model has not changed in between.
+     */
+    uint64_t Generation() const { return _generation; }
+
+    /**
+     * @brief Copies the saved data so it can be written on another thread.
+     *
+     * The names and codes are shared, not copied, see FsmSnapshot.
+     */
+    FsmSnapshot TakeSnapshot() const;
+
+    /**
+     * @brief Adds the memory of the model to the report: the nodes, actions, connections,
+     *        search index, port widgets and the mapped file of a lazy load.
+     */
+    void AddMemoryUsage(MemoryReport &report) const;
+
     /**
      * @brief Saves the model to a file.
+     *
+     * Saving over the file of a lazy load materializes the remaining texts first.
      * @param filename The file name.
      */
-    void ToFile(std::string const filename) const;
+    void ToFile(std::string const filename);
 
     /**
      * @brief Load the model from a file.
+     *
+     * Blocks until the file is parsed, LoadJob loads it on a worker thread instead.
      * @param filename The file name.
      */
     void FromFile(std::string const filename);
 
+    /**
+     * @brief Replaces the model with a graph loaded by loadGraph(), in one batch.
+     *
+     * The texts of a lazy load stay in graph.source until they are needed.
+     * @param graph The loaded graph.
+     */
+    void ApplyLoadedGraph(LoadedGraph const &graph);
+
     /**
      * @brief Checks if a connection exists.
      * @param connectionId The connection ID.
@@ -219,12 +420,28 @@ public:
 
     /**
      * @brief Converts the model to an Automaton object.
-     * @return Pointer to the Automaton.
+     * @return The Automaton, nullptr if the start state is not set.
      */
-    Automaton* ToAutomaton() const;
+    std::unique_ptr<Automaton> ToAutomaton() const;
 
     void Reset();
 
+    /**
+     * @brief Builds the input of GraphLayout from the connections of the model.
+     * @param nodeIds Filled with the node of every layout index.
+     * @return The graph with the current node positions.
+     */
+    LayoutGraph BuildLayoutGraph(std::vector<NodeId> &nodeIds) const;
+
+    /**
+     * @brief Moves the nodes to the computed positions in one batch.
+     *
+     * Nodes deleted since BuildLayoutGraph() are skipped.
+     * @param nodeIds The nodes as returned by BuildLayoutGraph().
+     * @param positions The position of every node.
+     */
+    void ApplyLayout(std::vector<NodeId> const &nodeIds, std::vector<LayoutPoint> const &positions);
+
     /**
      * @brief Adds a new node to the model.
      * @param nodeType The type of node (optional).
@@ -234,6 +451,100 @@ public:
 
     void forceNodeUiUpdate(NodeId const id);
 
+    /**
+     * @brief Starts a batch of changes, batches may be nested.
+     *
+     * Inside a batch the model emits no per node or per connection signals. The
+     * outermost endBatch() emits a single modelReset(), which makes the scene
+     * rebuild its graphics objects once. Used by FromFile() and Reset().
+     */
+    void beginBatch();
+
+    /**
+     * @brief Ends a batch started by beginBatch().
+     */
+    void endBatch();
+
+    /**
+     * @brief Checks if a batch is in progress.
+     */
+    bool inBatch() const { return _batchDepth > 0; }
+
+    /**
+     * @brief Calls beginBatch() on construction and endBatch() on destruction.
+     */
+    class BatchUpdate
+    {
+    public:
+        explicit BatchUpdate(DynamicPortsModel &model) : _model(model) { _model.beginBatch(); }
+        ~BatchUpdate() { _model.endBatch(); }
+
+        BatchUpdate(BatchUpdate const &) = delete;
+        BatchUpdate &operator=(BatchUpdate const &) = delete;
+
+    private:
+        DynamicPortsModel &_model;
+    };
+
+    /**
+     * @brief Selects how the port add/remove controls are shown.
+     *
+     * Painted controls (the default) are drawn by the node painter and reported
+     * through BasicGraphicsScene::portControlClicked(), no QWidget is created
+     * per node. Otherwise every node embeds a PortAddRemoveWidget.
+     * @param painted True for painted controls.
+     */
+    void SetPaintedPortControls(bool painted);
+
+    /**
+     * @brief Checks if the port controls are painted instead of embedded widgets.
+     */
+    bool PaintedPortControls() const { return _paintedPortControls; }
+
+    /**
+     * @brief Gets the flags of a node.
+     * @param nodeId The node ID.
+     * @return NodeFlag::PortControls when the port controls are painted.
+     */
+    QtNodes::NodeFlags nodeFlags(NodeId nodeId) const override;
+
+    /**
+     * @brief Checks if a connection is the transition set by SetLiveConnection().
+     * @param connectionId The connection ID.
+     * @return True if it is painted highlighted.
+     */
+    bool connectionHighlighted(ConnectionId const connectionId) const override
+    {
+        return _liveConnection && *_liveConnection == connectionId;
+    }
+
+    /**
+     * @brief Heat of a node set by SetHeat().
+     */
+    float nodeHeat(NodeId const nodeId) const override
+    {
+        auto it = _nodeHeat.find(nodeId);
+        return it != _nodeHeat.end() ? it->second : 0.0f;
+    }
+
+    /**
+     * @brief Heat of a connection set by SetHeat().
+     */
+    float connectionHeat(ConnectionId const connectionId) const override
+    {
+        auto it = _connectionHeat.find(connectionId);
+        return it != _connectionHeat.end() ? it->second : 0.0f;
+    }
+
+    /**
+     * @brief Problems of a node set by SetNodeProblems().
+     */
+    QString nodeProblems(NodeId const nodeId) const override
+    {
+        auto it = _nodeProblems.find(nodeId);
+        return it != _nodeProblems.end() ? it->second : QString();
+    }
+
     /**
      * @brief Checks if a connection is possible (no duplicate or reverse).
      * @param connectionId The connection ID.
@@ -256,10 +567,12 @@ public:
 
     /**
      * @brief Finds a node by its name.
+     *
+     * A state of an instance, "<instance>.<state>", is found as the instance node.
      * @param nodeName The node name.
      * @return The node ID, or InvalidNodeId if not found.
      */
-    NodeId findNodeByName(QString const nodeName);
+    NodeId findNodeByName(QString const nodeName) const;
 
     /**
      * @brief Gets data for a node.
@@ -311,6 +624,23 @@ public:
      */
     bool deleteConnection(ConnectionId const connectionId) override;
 
+    /**
+     * @brief Moves a connection to other ports in place, for addPort/removePort.
+     *
+     * The condition, delay and heat of the transition move with it, the scene keeps
+     * its graphics object (connectionReindexed() is emitted).
+     * @param oldConnectionId The connection ID before the shift.
+     * @param newConnectionId The connection ID after the shift, not used yet.
+     * @return True if the connection existed.
+     */
+    bool reindexConnection(ConnectionId const oldConnectionId,
+                           ConnectionId const newConnectionId) override;
+
+    /**
+     * @brief Keeps the connection until reindexConnection() moves it.
+     */
+    void connectionAboutToBeReindexed(ConnectionId const, ConnectionId const) override {}
+
     /**
      * @brief Deletes a node from the model.
      * @param nodeId The node ID.
@@ -362,32 +692,134 @@ public:
      */
     std::vector<VariableInfo> variables;
     QString fsmName = "my_fsm";
+    QString fsmDescription = "\"Description\""; ///< As written after DESCRIPTION, quotes included.
 
 private:
-    std::unordered_set<NodeId> _nodeIds;
-    std::unordered_map<NodeId, QString> _nodeNames;
-    std::unordered_map<NodeId, QString> _nodeActionCodes;
+    struct NodePortCount
+    {
+        unsigned int in = 0;
+        unsigned int out = 0;
+    };
+
+    /// Index of a node in the per-node arrays.
+    using NodeSlot = uint32_t;
+    static constexpr NodeSlot InvalidSlot = ~NodeSlot(0);
+
+    // Per-node data, dense arrays indexed by the slot of the node. Deleting a node
+    // moves the last node into its slot, so all nodes are iterated in slot order
+    // without gaps and a lookup is one find() in _nodeSlots.
+    std::unordered_map<NodeId, NodeSlot> _nodeSlots;
+    std::vector<NodeId> _nodeIds;
+    std::vector<QString> _nodeNames;
+    std::vector<QString> _nodeActionCodes;
+    std::vector<bool> _nodeFinalStates;
+    std::vector<NodeGeometryData> _nodeGeometryData;
+    std::vector<NodePortCount> _nodePortCounts;
+    mutable std::vector<PortAddRemoveWidget *> _nodeWidgets; ///< created on first use, see widget()
+    QMultiHash<QString, NodeId> _nodeIdsByName; ///< index of _nodeNames, names may repeat while editing
+
+    /**
+     * @brief Returns the slot of a node, InvalidSlot if it does not exist.
+     */
+    NodeSlot slotOf(NodeId const nodeId) const
+    {
+        auto it = _nodeSlots.find(nodeId);
+        return it != _nodeSlots.end() ? it->second : InvalidSlot;
+    }
+
+    /**
+     * @brief Appends a slot with default data for a new node.
+     */
+    NodeSlot addNodeSlot(NodeId const nodeId);
+
+    /**
+     * @brief Removes the slot of a deleted node, the last node takes its place.
+     */
+    void removeNodeSlot(NodeSlot const slot);
+
     std::unordered_map<ConnectionId, QString> _connectionCodes;
+
+    // texts of a lazy load not materialized yet, they point into _lazySource; an
+    // action is lazy while its view is not null
+    std::shared_ptr<const LoadedSource> _lazySource;
+    std::vector<std::string_view> _lazyActionCodes; ///< by slot, like the node data
+    std::unordered_map<ConnectionId, std::string_view> _lazyConnectionCodes;
+    std::string actionCodeUtf8(NodeSlot const slot) const;
+    std::string connectionCodeUtf8(ConnectionId const connId) const;
+    void materializeLazyText();
+    // index of Search(), built by its first call, the setters keep it up to date
+    TextIndex _nameSearch;          ///< node names by NodeId
+    TextIndex _actionSearch;        ///< node actions by NodeId
+    TextIndex _conditionSearch;     ///< connection conditions by the keys of _conditionSearchKeys
+    std::unordered_map<ConnectionId, TextIndex::Key> _conditionSearchKeys;
+    std::unordered_map<TextIndex::Key, ConnectionId> _conditionSearchConnections;
+    TextIndex::Key _nextConditionSearchKey = 0;
+    bool _searchIndexed = false;
+    void buildSearchIndex();
+    void dropSearchIndex();
+    void indexCondition(ConnectionId const connId, QString const &code);
     std::unordered_map<ConnectionId, int> _connectionDelays;
-    std::unordered_map<NodeId, bool> _nodeFinalStates;
+    std::vector<std::shared_ptr<const Automaton>> _definitions;  ///< see Definitions()
+    std::unordered_map<NodeId, SubAutomatonInstance> _nodeInstances; ///< see SetNodeInstance()
     NodeId _startStateId = 0;
-    void writeNodeData(ofstream& os, NodeId const nodeId) const;
+    NodeId _liveNodeId = InvalidNodeId;            ///< see SetLiveNode()
+    std::optional<ConnectionId> _liveConnection;  ///< see SetLiveConnection()
+    std::unordered_map<NodeId, float> _nodeHeat;              ///< see SetHeat()
+    std::unordered_map<ConnectionId, float> _connectionHeat;  ///< see SetHeat()
+    std::unordered_map<NodeId, QString> _nodeProblems;        ///< see SetNodeProblems()
+    uint64_t _generation = 0;
+    void markChanged() { ++_generation; }
 
     std::unordered_set<ConnectionId> _connectivity;
 
-    mutable std::unordered_map<NodeId, NodeGeometryData> _nodeGeometryData;
+    /// Key of the per-port adjacency index.
+    struct PortKey
+    {
+        NodeId nodeId;
+        PortType portType;
+        PortIndex portIndex;
+
+        bool operator==(PortKey const &other) const
+        {
+            return nodeId == other.nodeId && portType == other.portType && portIndex == other.portIndex;
+        }
+    };
 
-    struct NodePortCount
+    struct PortKeyHash
     {
-        unsigned int in = 0;
-        unsigned int out = 0;
+        std::size_t operator()(PortKey const &key) const
+        {
+            std::size_t h = std::hash<NodeId>()(key.nodeId);
+            h ^= std::hash<PortIndex>()(key.portIndex) + 0x9e3779b9 + (h << 6) + (h >> 2);
+            return h ^ static_cast<std::size_t>(key.portType);
+        }
     };
 
-    PortAddRemoveWidget *widget(NodeId) const;
+    /// Adjacency indexes of _connectivity, kept up to date by addConnection/deleteConnection
+    /// (addPort/removePort shift connections through reindexConnection).
+    std::unordered_map<NodeId, std::unordered_set<ConnectionId>> _nodeConnections;
+    std::unordered_map<PortKey, std::unordered_set<ConnectionId>, PortKeyHash> _portConnections;
+
+    /**
+     * @brief Adds or removes a connection from the adjacency indexes.
+     */
+    void indexConnection(ConnectionId const connectionId, bool add);
+
+    /// NodeRole::Style data, cached for StyleCollection::nodeStyleVersion()
+    mutable QVariantMap _nodeStyleMap;
+    mutable unsigned int _nodeStyleMapVersion = 0;
 
-    mutable std::unordered_map<NodeId, NodePortCount> _nodePortCounts;
-    mutable std::unordered_map<NodeId, PortAddRemoveWidget *> _nodeWidgets;
+    PortAddRemoveWidget *widget(NodeSlot const slot) const;
+
+    /**
+     * @brief Sets the name of a node and keeps the name index up to date.
+     */
+    void setNodeNameIndexed(NodeSlot const slot, QString const &name);
 
     /// A convenience variable needed for generating unique node ids.
     NodeId _nextNodeId;
+
+    unsigned int _batchDepth = 0;                ///< nesting depth of beginBatch()
+    bool _paintedPortControls = true;            ///< see SetPaintedPortControls()
+    std::vector<NodeId> _batchForcedWidths;      ///< forceNodeUiUpdate() calls made inside a batch
 };
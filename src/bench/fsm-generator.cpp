@@ -0,0 +1,82 @@
+/**
+ * @file fsm-generator.cpp
+ * @brief Implementation of generateFsm().
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#include "fsm-generator.hpp"
+
+#include <algorithm>
+#include <random>
+
+static constexpr int kGridColumns = 100;    ///< nodes per row of the layout
+static constexpr int kGridSpacing = 250;
+
+/// Code of an action of about params.codeBytes, statements over the variables.
+static QString actionCode(const FsmGeneratorParams& params, uint32_t state)
+{
+    std::string code;
+    code.reserve(params.codeBytes + 64);
+    for (uint32_t line = 0; code.size() < params.codeBytes; ++line) {
+        if (params.variables == 0) {
+            code += "x" + std::to_string(line) + " = " + std::to_string(state + line) + "\n";
+            continue;
+        }
+        const std::string name = "v" + std::to_string((state + line) % params.variables);
+        code += name + " = " + name + " + " + std::to_string(line % 7 + 1) + "\n";
+    }
+    if (!code.empty())
+        code.pop_back();
+    return QString::fromStdString(code);
+}
+
+FsmSnapshot generateFsm(const FsmGeneratorParams& params)
+{
+    const uint32_t states = std::max<uint32_t>(params.states, 1);
+    const uint32_t perState = std::max<uint32_t>(params.transitionsPerState, 1);
+    std::mt19937 random(params.seed);
+
+    FsmSnapshot snapshot;
+    snapshot.name = QString("Synthetic%1").arg(states);
+    snapshot.startNode = 0;
+
+    snapshot.variables.reserve(params.variables);
+    for (uint32_t k = 0; k < params.variables; ++k) {
+        const bool isDouble = k % 2 == 1;
+        snapshot.variables.emplace_back("v" + std::to_string(k), isDouble ? "0.5" : "0",
+                                        isDouble ? VarDataType::Double : VarDataType::Int);
+    }
+
+    snapshot.nodes.resize(states);
+    for (uint32_t i = 0; i < states; ++i) {
+        SnapshotNode& node = snapshot.nodes[i];
+        node.name = QString("S%1").arg(i);
+        node.posX = static_cast<int>(i % kGridColumns) * kGridSpacing;
+        node.posY = static_cast<int>(i / kGridColumns) * kGridSpacing;
+        node.isFinal = i + 1 == states;
+        node.action = actionCode(params, i);
+    }
+
+    // a final state has no way out, all the others take perState transitions
+    std::uniform_int_distribution<uint32_t> target(0, states - 1);
+    std::uniform_int_distribution<uint32_t> constant(0, 1000);
+    snapshot.connections.reserve(static_cast<size_t>(states) * perState);
+    for (uint32_t i = 0; i + 1 < states; ++i) {
+        for (uint32_t t = 0; t < perState; ++t) {
+            SnapshotConnection connection;
+            connection.outNode = i;
+            connection.inNode = t == 0 ? i + 1 : target(random);
+            connection.condition = params.variables == 0
+                ? QStringLiteral("True")
+                : QString("v%1 >= %2").arg(random() % params.variables).arg(constant(random));
+            connection.delay = random() % 8 == 0 ? 100 : 0;
+
+            ++snapshot.nodes[connection.outNode].outPortCount;
+            ++snapshot.nodes[connection.inNode].inPortCount;
+            snapshot.connections.push_back(std::move(connection));
+        }
+    }
+    return snapshot;
+}
@@ -0,0 +1,40 @@
+/**
+ * @file fsm-generator.hpp
+ * @brief Synthetic automata of a chosen size for the benchmarks.
+ *
+ * State i is named S<i>, it goes to S<i + 1> and to transitionsPerState - 1 states
+ * picked at random; the last state is final and has no transitions. The actions update
+ * the variables v<k> line by line until they are codeBytes long, the conditions compare a
+ * variable with a constant, one transition in eight has a delay. The same parameters and
+ * seed always give the same automaton.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#ifndef FSM_GENERATOR_HPP
+#define FSM_GENERATOR_HPP
+
+#include <cstdint>
+#include <string>
+
+#include "../load/fsm-snapshot.hpp"
+
+/**
+ * @brief Size of a synthetic automaton.
+ */
+struct FsmGeneratorParams
+{
+    uint32_t states = 10000;
+    uint32_t transitionsPerState = 2;  ///< Outgoing transitions of a state, at least 1.
+    uint32_t variables = 16;
+    uint32_t codeBytes = 256;          ///< Length of an action, roughly.
+    uint32_t seed = 1;
+};
+
+/**
+ * @brief Builds the automaton as a snapshot, writeFsmText() saves it as .fsm text.
+ */
+FsmSnapshot generateFsm(const FsmGeneratorParams& params);
+
+#endif // FSM_GENERATOR_HPP
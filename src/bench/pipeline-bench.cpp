@@ -0,0 +1,250 @@
+/**
+ * @file pipeline-bench.cpp
+ * @brief Benchmark of the loading, saving and code generation of an automaton.
+ *
+ * A synthetic automaton (see fsm-generator.hpp) or the --input file goes through the
+ * stages of the editor, each timed on its own:
+ *  - write             writeFsmText() of the synthetic automaton (not with --input)
+ *  - parse             AutomatonParser::FromFile()
+ *  - modelFromFile     DynamicPortsModel::FromFile()
+ *  - modelToAutomaton  DynamicPortsModel::ToAutomaton()
+ *  - modelToFile       DynamicPortsModel::ToFile()
+ *  - generate          InterpretGenerator::generate(), with an empty body cache
+ *
+ * Every stage is printed as one JSON line with its best time of the --repeat runs, the
+ * bytes it read or wrote, MB/s, states/s and the peak resident memory during the stage.
+ * The peak is reset before every stage on Linux (/proc/self/clear_refs), elsewhere it is
+ * the peak of the process so far.
+ *
+ * Built with ICP_BENCHMARKS only, see the option of the same name in CMakeLists.txt.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+#include "fsm-generator.hpp"
+#include "../DynamicPortsModel.hpp"
+#include "../interpret_generator.h"
+#include "../spec_parser/automaton-parser.hpp"
+
+namespace {
+
+/// Where the results go, stdout or the --output file.
+FILE *s_output = stdout;
+
+/// The peak resident memory in kB, since the last resetPeakMemory().
+long peakMemoryKb()
+{
+#ifdef __linux__
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0)
+            return std::stol(line.substr(6));
+    }
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024; // bytes there
+#else
+    return usage.ru_maxrss;
+#endif
+#else
+    return 0;
+#endif
+}
+
+/// Sets the peak of peakMemoryKb() to the current resident memory, where the kernel can.
+void resetPeakMemory()
+{
+#ifdef __linux__
+    std::ofstream clearRefs("/proc/self/clear_refs");
+    clearRefs << "5";
+#endif
+}
+
+qint64 fileSize(std::string const &filename)
+{
+    return QFileInfo(QString::fromStdString(filename)).size();
+}
+
+/// Result of a stage, the best run and the highest peak.
+struct StageResult
+{
+    double ms = std::numeric_limits<double>::max();
+    long peakKb = 0;
+    qint64 bytes = 0;
+};
+
+/**
+ * @brief Runs the stage repeat times.
+ * @param run Does the work once and returns the bytes it read or wrote.
+ */
+template <typename F>
+StageResult runStage(int repeat, F &&run)
+{
+    StageResult result;
+    for (int i = 0; i < repeat; ++i) {
+        resetPeakMemory();
+        const auto start = std::chrono::steady_clock::now();
+        result.bytes = run();
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        result.ms = std::min(result.ms, ms);
+        result.peakKb = std::max(result.peakKb, peakMemoryKb());
+    }
+    return result;
+}
+
+void printStage(QString const &stage, StageResult const &result, size_t states)
+{
+    const double seconds = result.ms / 1000.0;
+    QJsonObject line{{"bench", "pipeline"},
+                     {"stage", stage},
+                     {"ms", result.ms},
+                     {"bytes", result.bytes},
+                     {"mbPerS", seconds > 0 ? result.bytes / (1024.0 * 1024.0) / seconds : 0.0},
+                     {"states", static_cast<qint64>(states)},
+                     {"statesPerS", seconds > 0 ? states / seconds : 0.0},
+                     {"peakRssKb", static_cast<qint64>(result.peakKb)}};
+    const QByteArray text = QJsonDocument(line).toJson(QJsonDocument::Compact);
+    std::fwrite(text.constData(), 1, static_cast<size_t>(text.size()), s_output);
+    std::fputc('\n', s_output);
+    std::fflush(s_output);
+}
+
+uint32_t positive(QCommandLineParser const &options, QString const &name)
+{
+    return static_cast<uint32_t>(std::max(0LL, options.value(name).toLongLong()));
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication app(argc, argv);
+
+    QCommandLineParser options;
+    options.setApplicationDescription("Times parsing, loading, saving and generating a synthetic or given automaton.");
+    options.addHelpOption();
+    options.addOptions({
+        {"states", "States of the synthetic automaton.", "n", "10000"},
+        {"transitions", "Transitions per state.", "n", "2"},
+        {"variables", "Variables.", "n", "16"},
+        {"code-bytes", "Bytes of an action.", "n", "256"},
+        {"seed", "Seed of the random transitions.", "n", "1"},
+        {"write", "Only write the synthetic automaton to <file>.", "file"},
+        {"input", "Benchmark <file> instead of a synthetic automaton.", "file"},
+        {"repeat", "Runs of every stage, the best time is reported.", "n", "3"},
+        {"output", "Append the results to <file> instead of the standard output.", "file"},
+    });
+    options.process(app);
+
+    FsmGeneratorParams params;
+    params.states = positive(options, "states");
+    params.transitionsPerState = positive(options, "transitions");
+    params.variables = positive(options, "variables");
+    params.codeBytes = positive(options, "code-bytes");
+    params.seed = positive(options, "seed");
+    const int repeat = std::max(1, options.value("repeat").toInt());
+
+    if (options.isSet("write")) {
+        if (!writeFsmText(generateFsm(params), options.value("write").toStdString())) {
+            std::fprintf(stderr, "icp-pipeline-bench: cannot write %s\n", qPrintable(options.value("write")));
+            return 1;
+        }
+        return 0;
+    }
+
+    QTemporaryDir work;
+    if (!work.isValid()) {
+        std::fprintf(stderr, "icp-pipeline-bench: no temporary directory\n");
+        return 1;
+    }
+    if (options.isSet("output")) {
+        s_output = std::fopen(qPrintable(options.value("output")), "a");
+        if (!s_output) {
+            std::fprintf(stderr, "icp-pipeline-bench: cannot open %s\n", qPrintable(options.value("output")));
+            return 1;
+        }
+    }
+
+    std::string input = options.value("input").toStdString();
+    size_t states = params.states;
+    if (input.empty()) {
+        input = work.filePath("synthetic.fsm").toStdString();
+        const FsmSnapshot snapshot = generateFsm(params);
+        const StageResult written = runStage(repeat, [&]() {
+            writeFsmText(snapshot, input);
+            return fileSize(input);
+        });
+        printStage("write", written, states);
+    }
+
+    const StageResult parse = runStage(repeat, [&]() {
+        Automaton automaton;
+        AutomatonParser::FromFile(input, automaton);
+        states = automaton.getStates().size();
+        return fileSize(input);
+    });
+    printStage("parse", parse, states);
+
+    DynamicPortsModel model;
+    const StageResult modelFromFile = runStage(repeat, [&]() {
+        model.FromFile(input);
+        return fileSize(input);
+    });
+    printStage("modelFromFile", modelFromFile, states);
+
+    std::unique_ptr<Automaton> automaton;
+    const StageResult modelToAutomaton = runStage(repeat, [&]() {
+        automaton = model.ToAutomaton();
+        return qint64(0);
+    });
+    printStage("modelToAutomaton", modelToAutomaton, states);
+    if (!automaton) {
+        std::fprintf(stderr, "icp-pipeline-bench: the automaton has no start state\n");
+        return 1;
+    }
+
+    const std::string saved = work.filePath("saved.fsm").toStdString();
+    const StageResult modelToFile = runStage(repeat, [&]() {
+        model.ToFile(saved);
+        return fileSize(saved);
+    });
+    printStage("modelToFile", modelToFile, states);
+
+    const QString script = work.filePath("interpret.py");
+    const StageResult generate = runStage(repeat, [&]() {
+        InterpretGenerator generator; // a new one each run, the body cache would hide the work
+        generator.generate(*automaton, script);
+        return QFileInfo(script).size();
+    });
+    printStage("generate", generate, states);
+
+    if (s_output != stdout)
+        std::fclose(s_output);
+    return 0;
+}
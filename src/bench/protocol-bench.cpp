@@ -0,0 +1,485 @@
+/**
+ * @file protocol-bench.cpp
+ * @brief Load generator for the FSM protocol, measures what FsmClient and the window absorb.
+ *
+ * A fake runtime on its own thread listens on a local socket (or TCP), greets the client
+ * with FSM_CONNECTED like fsm_core does, answers SET_ENCODING and then streams a mix of
+ * CURRENT_STATE, TRANSITION_TAKEN and VARIABLE_UPDATE at a fixed rate, or as fast as the
+ * socket takes them with --rate 0. The messages are framed by FsmClient::encodeMessage(),
+ * the same JSON lines or CBOR frames the runtimes send. Every payload carries the time it
+ * was encoded (sent_us), the run ends with FSM_FINISHED and the totals of the server.
+ *
+ * The client side is a plain FsmClient on the main thread. It measures
+ *  - the messages and bytes per second it parsed,
+ *  - the latency from encoding to messageReceived() (with the window, until its handler
+ *    returned), from the sent_us stamps,
+ *  - the stalls of its event loop: a 1 ms timer records how late it fires.
+ * The window build (icp-protocol-bench-window) hands every message to the
+ * MainWindow::onRunMessageReceived() of a real window, so its log and the frame updates
+ * are in the measurements too.
+ *
+ * The result is one JSON line on the standard output or appended to --output.
+ *
+ * Built with ICP_BENCHMARKS only, see the option of the same name in CMakeLists.txt.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#ifdef ICP_BENCH_WINDOW
+#include <QApplication>
+#else
+#include <QCoreApplication>
+#endif
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QLoggingCategory>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QThread>
+#include <QTimer>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+#include "../client.hpp"
+#ifdef ICP_BENCH_WINDOW
+#include "../mainwindow.h"
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+const Clock::time_point s_epoch = Clock::now();
+
+/// Microseconds since the start, the clock of the sent_us stamps; both ends are in this process.
+double nowUs()
+{
+    return std::chrono::duration<double, std::micro>(Clock::now() - s_epoch).count();
+}
+
+constexpr int kProtocolVersion = 1;
+constexpr int kTickMs = 1;                          ///< interval of the generator and of the stall meter
+constexpr qint64 kFloodHighWater = 1024 * 1024;     ///< --rate 0 writes while fewer bytes wait in the socket
+constexpr int kFloodBatch = 256;                    ///< messages per tick of --rate 0
+constexpr int kHandshakeTimeoutMs = 1000;           ///< the stream starts without SET_ENCODING after this
+#ifdef ICP_BENCH_WINDOW
+constexpr int kBenchRunId = 1;                      ///< run of the messages handed to the window
+#endif
+
+enum class Kind { State, Transition, Variable };
+
+/// What the fake runtime sends.
+struct LoadConfig
+{
+    double rate = 10000;        ///< messages per second, 0 as fast as the socket takes them
+    double seconds = 5;
+    std::vector<Kind> pattern;  ///< the mix, repeated
+    bool offerCbor = true;
+    bool tcp = false;
+    int states = 100;
+    int variables = 16;
+};
+
+/**
+ * @brief The fake runtime, created on the main thread and run on its own.
+ */
+class LoadServer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit LoadServer(LoadConfig config) : m_config(std::move(config)) {}
+
+public slots:
+    /**
+     * @brief Listens, emits listening() with the endpoint for FsmClient::connectToEndpoint().
+     */
+    void start()
+    {
+        if (m_config.tcp) {
+            auto *server = new QTcpServer(this);
+            if (!server->listen(QHostAddress::LocalHost, 0)) {
+                emit failed(server->errorString());
+                return;
+            }
+            connect(server, &QTcpServer::newConnection, this, [this, server]() {
+                accept(server->nextPendingConnection());
+            });
+            emit listening(QString("tcp://127.0.0.1:%1").arg(server->serverPort()));
+        } else {
+            auto *server = new QLocalServer(this);
+            const QString path = QDir::temp().filePath(QString("icp-protocol-bench-%1").arg(QCoreApplication::applicationPid()));
+            QLocalServer::removeServer(path);
+            if (!server->listen(path)) {
+                emit failed(server->errorString());
+                return;
+            }
+            connect(server, &QLocalServer::newConnection, this, [this, server]() {
+                accept(server->nextPendingConnection());
+            });
+            emit listening("unix:" + server->fullServerName());
+        }
+    }
+
+signals:
+    void listening(const QString &endpoint);
+    void failed(const QString &error);
+
+private:
+    void accept(QIODevice *socket)
+    {
+        if (m_socket || !socket)
+            return;
+        m_socket = socket;
+        connect(m_socket, &QIODevice::readyRead, this, &LoadServer::onReadyRead);
+
+        QJsonArray encodings{"json"};
+        if (m_config.offerCbor)
+            encodings.append("cbor");
+        send("FSM_CONNECTED", QJsonObject{{"message", "Connected to the protocol load generator."},
+                                          {"version", kProtocolVersion},
+                                          {"encodings", encodings},
+                                          {"transports", QJsonArray{"tcp"}}});
+        if (m_config.offerCbor)
+            QTimer::singleShot(kHandshakeTimeoutMs, this, &LoadServer::beginStream);
+        else
+            beginStream();
+    }
+
+    /// Only SET_ENCODING is answered, everything the client sends after it is dropped.
+    void onReadyRead()
+    {
+        m_input += m_socket->readAll();
+        if (m_encoding == FsmClient::Encoding::Cbor) {
+            m_input.clear();
+            return;
+        }
+        qsizetype newline;
+        while ((newline = m_input.indexOf('\n')) >= 0) {
+            const QJsonObject message = QJsonDocument::fromJson(m_input.left(newline)).object();
+            m_input.remove(0, newline + 1);
+            if (message["type"].toString() != "SET_ENCODING")
+                continue;
+            const QString encoding = message["payload"].toObject()["encoding"].toString();
+            // the confirmation is the last message in JSON
+            send("ENCODING_SET", QJsonObject{{"encoding", encoding}, {"version", kProtocolVersion}});
+            if (encoding == "cbor") {
+                m_encoding = FsmClient::Encoding::Cbor;
+                m_input.clear();
+            }
+            beginStream();
+            return;
+        }
+    }
+
+    void beginStream()
+    {
+        if (m_streaming)
+            return;
+        m_streaming = true;
+        m_clock.start();
+        m_timer = new QTimer(this);
+        m_timer->setTimerType(Qt::PreciseTimer);
+        connect(m_timer, &QTimer::timeout, this, &LoadServer::tick);
+        m_timer->start(kTickMs);
+    }
+
+    void tick()
+    {
+        const double elapsed = m_clock.nsecsElapsed() / 1e9;
+        const qint64 waiting = m_socket->bytesToWrite();
+        m_maxBacklog = std::max(m_maxBacklog, waiting);
+
+        qint64 due = 0;
+        if (m_config.rate > 0)
+            due = static_cast<qint64>(m_config.rate * std::min(elapsed, m_config.seconds)) - m_sent;
+        else if (waiting < kFloodHighWater)
+            due = kFloodBatch;
+
+        QByteArray batch;
+        for (qint64 i = 0; i < due; ++i)
+            appendNext(batch);
+        write(batch);
+
+        if (elapsed >= m_config.seconds) {
+            m_timer->stop();
+            send("FSM_FINISHED", QJsonObject{{"finish_state", "S0"},
+                                             {"sent", m_sent},
+                                             {"bytes", m_bytes},
+                                             {"max_backlog", m_maxBacklog},
+                                             {"seconds", elapsed}});
+        }
+    }
+
+    /// The next message of the mix.
+    void appendNext(QByteArray &out)
+    {
+        const Kind kind = m_config.pattern[m_sent % m_config.pattern.size()];
+        const int state = static_cast<int>(m_sent % m_config.states);
+        QJsonObject message;
+        switch (kind) {
+        case Kind::State:
+            message = {{"type", "CURRENT_STATE"},
+                       {"payload", QJsonObject{{"name", QString("S%1").arg(state)}, {"is_finish", false},
+                                               {"sent_us", nowUs()}}}};
+            break;
+        case Kind::Transition:
+            message = {{"type", "TRANSITION_TAKEN"},
+                       {"payload", QJsonObject{{"from_state", QString("S%1").arg(state)},
+                                               {"to_state", QString("S%1").arg((state + 1) % m_config.states)},
+                                               {"delay", 0}, {"sent_us", nowUs()}}}};
+            break;
+        case Kind::Variable:
+            message = {{"type", "VARIABLE_UPDATE"},
+                       {"payload", QJsonObject{{"name", QString("v%1").arg(m_sent % m_config.variables)},
+                                               {"value", static_cast<qint64>(m_sent)}, {"sent_us", nowUs()}}}};
+            break;
+        }
+        FsmClient::encodeMessage(out, message, m_encoding);
+        ++m_sent;
+    }
+
+    void send(const QString &type, const QJsonObject &payload)
+    {
+        QByteArray bytes;
+        FsmClient::encodeMessage(bytes, QJsonObject{{"type", type}, {"payload", payload}}, m_encoding);
+        write(bytes);
+    }
+
+    void write(const QByteArray &bytes)
+    {
+        if (bytes.isEmpty())
+            return;
+        m_socket->write(bytes);
+        m_bytes += bytes.size();
+    }
+
+    LoadConfig m_config;
+    QIODevice *m_socket = nullptr;                          ///< The one client, the first to connect.
+    QByteArray m_input;
+    FsmClient::Encoding m_encoding = FsmClient::Encoding::Json;
+    bool m_streaming = false;
+    QTimer *m_timer = nullptr;
+    QElapsedTimer m_clock;                                  ///< since the stream started
+    qint64 m_sent = 0;                                      ///< messages of the mix
+    qint64 m_bytes = 0;                                     ///< all bytes written
+    qint64 m_maxBacklog = 0;                                ///< most bytes waiting in the socket
+};
+
+/// Value at the fraction of the sorted values.
+double percentile(const std::vector<double> &sorted, double fraction)
+{
+    if (sorted.empty())
+        return 0;
+    const size_t index = std::min(sorted.size() - 1, static_cast<size_t>(fraction * sorted.size()));
+    return sorted[index];
+}
+
+QJsonObject distribution(std::vector<double> values)
+{
+    std::sort(values.begin(), values.end());
+    return {{"p50", percentile(values, 0.50)},
+            {"p90", percentile(values, 0.90)},
+            {"p99", percentile(values, 0.99)},
+            {"max", values.empty() ? 0.0 : values.back()}};
+}
+
+/**
+ * @brief Bad arguments give an empty pattern.
+ */
+std::vector<Kind> parseMix(const QString &mix)
+{
+    std::vector<Kind> pattern;
+    for (const QString &part : mix.split(',', Qt::SkipEmptyParts)) {
+        const QStringList pair = part.split('=');
+        const int weight = pair.size() == 2 ? pair[1].toInt() : 1;
+        const QString name = pair[0].trimmed();
+        Kind kind;
+        if (name == "state")
+            kind = Kind::State;
+        else if (name == "transition")
+            kind = Kind::Transition;
+        else if (name == "variable")
+            kind = Kind::Variable;
+        else
+            return {};
+        for (int i = 0; i < weight; ++i)
+            pattern.push_back(kind);
+    }
+    return pattern;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+#ifdef ICP_BENCH_WINDOW
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication app(argc, argv);
+#else
+    QCoreApplication app(argc, argv);
+#endif
+
+    QCommandLineParser options;
+    options.setApplicationDescription("Streams FSM messages to FsmClient and measures throughput, latency and stalls.");
+    options.addHelpOption();
+    options.addOptions({
+        {"rate", "Messages per second, 0 as fast as the client reads.", "n", "10000"},
+        {"seconds", "Length of the stream.", "s", "5"},
+        {"mix", "Weights of state, transition and variable messages.", "mix", "state=1,transition=1,variable=2"},
+        {"encoding", "Wire encoding, json or cbor.", "encoding", "cbor"},
+        {"transport", "unix (a local socket, as the editor) or tcp.", "transport", "unix"},
+        {"output", "Append the result to <file> instead of the standard output.", "file"},
+        {"verbose", "Print the client diagnostics to the standard error."},
+    });
+    options.process(app);
+
+    LoadConfig config;
+    config.rate = std::max(0.0, options.value("rate").toDouble());
+    config.seconds = std::max(0.1, options.value("seconds").toDouble());
+    config.pattern = parseMix(options.value("mix"));
+    config.offerCbor = options.value("encoding") == "cbor";
+    config.tcp = options.value("transport") == "tcp";
+    if (config.pattern.empty() || (options.value("encoding") != "json" && !config.offerCbor)
+        || (options.value("transport") != "unix" && !config.tcp)) {
+        std::fprintf(stderr, "icp-protocol-bench: bad --mix, --encoding or --transport, see --help\n");
+        return 2;
+    }
+    if (!options.isSet("verbose"))
+        QLoggingCategory::setFilterRules("*.debug=false\n*.info=false");
+
+#ifdef ICP_BENCH_WINDOW
+    MainWindow window;
+    window.show();
+#endif
+
+    auto *server = new LoadServer(config);
+    QThread serverThread;
+    server->moveToThread(&serverThread);
+    QObject::connect(&serverThread, &QThread::started, server, &LoadServer::start);
+    QObject::connect(&serverThread, &QThread::finished, server, &QObject::deleteLater);
+
+    FsmClient client;
+    client.setPreferredEncoding(config.offerCbor ? FsmClient::Encoding::Cbor : FsmClient::Encoding::Json);
+
+    std::vector<double> latencies;
+    latencies.reserve(config.rate > 0 ? static_cast<size_t>(config.rate * config.seconds) : 1 << 20);
+    std::vector<double> stalls;     // ms the stall meter fired late
+    qint64 received = 0;
+    double firstUs = 0, lastUs = 0;
+    QJsonObject totals;             // payload of FSM_FINISHED
+    int exitCode = 0;
+
+    QElapsedTimer meterClock;
+    QTimer meter;
+    meter.setTimerType(Qt::PreciseTimer);
+    QObject::connect(&meter, &QTimer::timeout, [&]() {
+        const double gapMs = meterClock.nsecsElapsed() / 1e6;
+        meterClock.restart();
+        stalls.push_back(std::max(0.0, gapMs - kTickMs));
+    });
+
+    QObject::connect(server, &LoadServer::listening, &client, [&client](const QString &endpoint) {
+        client.connectToEndpoint(endpoint);
+    });
+    QObject::connect(server, &LoadServer::failed, &app, [&](const QString &error) {
+        std::fprintf(stderr, "icp-protocol-bench: %s\n", qPrintable(error));
+        exitCode = 1;
+        app.quit();
+    });
+    QObject::connect(&client, &FsmClient::fsmError, &app, [&](const QString &error) {
+        std::fprintf(stderr, "icp-protocol-bench: %s\n", qPrintable(error));
+        exitCode = 1;
+        app.quit();
+    });
+    QObject::connect(&client, &FsmClient::messageReceived, &app, [&](const QJsonObject &message) {
+        const QString type = message["type"].toString();
+#ifdef ICP_BENCH_WINDOW
+        QMetaObject::invokeMethod(&window, "onRunMessageReceived", Qt::DirectConnection,
+                                  Q_ARG(int, kBenchRunId), Q_ARG(QJsonObject, message));
+#endif
+        const QJsonObject payload = message["payload"].toObject();
+        if (type == "FSM_CONNECTED") {
+            meterClock.start();
+            meter.start(kTickMs);
+            return;
+        }
+        if (type == "FSM_FINISHED") {
+            totals = payload;
+            app.quit();
+            return;
+        }
+        const QJsonValue sent = payload["sent_us"];
+        if (sent.isUndefined())
+            return;
+        lastUs = nowUs();
+        if (received++ == 0)
+            firstUs = lastUs;
+        latencies.push_back(lastUs - sent.toDouble());
+    });
+
+    serverThread.start();
+    app.exec();
+    meter.stop();
+    serverThread.quit();
+    serverThread.wait();
+    if (exitCode != 0)
+        return exitCode;
+
+    const double spanSeconds = std::max(1e-9, (lastUs - firstUs) / 1e6);
+    double stallTotal = 0;
+    qint64 longStalls = 0;
+    for (double stall : stalls) {
+        if (stall > kTickMs)
+            stallTotal += stall;
+        if (stall > 16)
+            ++longStalls;
+    }
+
+    QJsonObject result{{"bench", "protocol"},
+#ifdef ICP_BENCH_WINDOW
+                       {"mode", "window"},
+#else
+                       {"mode", "client"},
+#endif
+                       {"encoding", client.encoding() == FsmClient::Encoding::Cbor ? "cbor" : "json"},
+                       {"transport", config.tcp ? "tcp" : "unix"},
+                       {"mix", options.value("mix")},
+                       {"rate", config.rate},
+                       {"seconds", config.seconds},
+                       {"sent", totals.value("sent")},
+                       {"received", received},
+                       {"bytes", totals.value("bytes")},
+                       {"msgsPerS", received / spanSeconds},
+                       {"mbPerS", totals.value("bytes").toDouble() / (1024.0 * 1024.0) / spanSeconds},
+                       {"latencyUs", distribution(latencies)},
+                       {"stallMs", distribution(stalls)},
+                       {"stallTotalMs", stallTotal},
+                       {"stallsOver16ms", longStalls},
+                       {"maxBacklogBytes", totals.value("max_backlog")}};
+
+    FILE *output = stdout;
+    if (options.isSet("output")) {
+        output = std::fopen(qPrintable(options.value("output")), "a");
+        if (!output) {
+            std::fprintf(stderr, "icp-protocol-bench: cannot open %s\n", qPrintable(options.value("output")));
+            return 1;
+        }
+    }
+    const QByteArray line = QJsonDocument(result).toJson(QJsonDocument::Compact);
+    std::fwrite(line.constData(), 1, static_cast<size_t>(line.size()), output);
+    std::fputc('\n', output);
+    if (output != stdout)
+        std::fclose(output);
+    return 0;
+}
+
+#include "protocol-bench.moc"
@@ -0,0 +1,319 @@
+/**
+ * @file scene-bench.cpp
+ * @brief Benchmark of the graph models and the scene of the node editor on synthetic graphs.
+ *
+ * For every size a graph of that many nodes is built in DynamicPortsModel (the automaton
+ * of the editor) and in a DataFlowGraphModel of trivial delegate nodes. Every node has two
+ * inputs and one output: its output feeds input 0 of the next node (a chain) and input 1 of
+ * a node picked by a fixed permutation, so a graph of n nodes has 2n - 1 connections and no
+ * input port takes two.
+ *
+ * Timed on each graph, in this order:
+ *  - addNode, addConnection    building the model with no scene attached
+ *  - scene                     constructing the scene, which traverses the graph and
+ *                              creates the graphics objects
+ *  - paint                     rendering the whole scene into an offscreen image
+ *  - drag                      moving a tenth of the nodes by MoveNodeCommand, as
+ *                              NodeGraphicsObject::mouseMoveEvent does, then the release
+ *  - delete, undo, redo        a DeleteCommand of a hundredth of the nodes
+ *  - allConnectionIds          of every node
+ *
+ * Every measurement is printed as one JSON line
+ * ({"bench": "scene", "model": ..., "nodes": ..., "case": ..., "ms": ..., "count": ...}) to
+ * the standard output or the --output file, so a CI job can collect and compare them.
+ * The offscreen platform is used unless QT_QPA_PLATFORM says otherwise.
+ *
+ * Built with ICP_BENCHMARKS only, see the option of the same name in CMakeLists.txt.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QImage>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPainter>
+#include <QUndoStack>
+
+#include <QtNodes/BasicGraphicsScene>
+#include <QtNodes/DataFlowGraphModel>
+#include <QtNodes/DataFlowGraphicsScene>
+#include <QtNodes/NodeDelegateModel>
+#include <QtNodes/NodeDelegateModelRegistry>
+#include <QtNodes/internal/NodeGraphicsObject.hpp>
+#include <QtNodes/internal/UndoCommands.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <numeric>
+#include <unordered_set>
+
+#include "../DynamicPortsModel.hpp"
+
+using QtNodes::AbstractGraphModel;
+using QtNodes::BasicGraphicsScene;
+using QtNodes::ConnectionId;
+using QtNodes::DataFlowGraphModel;
+using QtNodes::DataFlowGraphicsScene;
+using QtNodes::NodeId;
+using QtNodes::NodeRole;
+using QtNodes::PortType;
+
+namespace {
+
+constexpr double kNodeSpacing = 250.0;      ///< grid step of the node positions
+constexpr int kDragSteps = 20;              ///< mouse moves of the simulated drag
+constexpr int kPaintSize = 2048;            ///< edge of the offscreen image
+
+/// The delegate of the DataFlowGraphModel nodes, two inputs and an output carrying nothing.
+class BenchNode : public QtNodes::NodeDelegateModel
+{
+public:
+    QString caption() const override { return QStringLiteral("Bench"); }
+    QString name() const override { return QStringLiteral("BenchNode"); }
+
+    unsigned int nPorts(PortType portType) const override { return portType == PortType::In ? 2 : 1; }
+
+    QtNodes::NodeDataType dataType(PortType, QtNodes::PortIndex) const override
+    {
+        return {QStringLiteral("bench"), QStringLiteral("Bench")};
+    }
+
+    void setInData(std::shared_ptr<QtNodes::NodeData>, QtNodes::PortIndex const) override {}
+    std::shared_ptr<QtNodes::NodeData> outData(QtNodes::PortIndex const) override { return nullptr; }
+    QWidget *embeddedWidget() override { return nullptr; }
+};
+
+/// Where the results go, stdout or the --output file.
+FILE *s_output = stdout;
+
+void printResult(QString const &model, size_t nodes, QString const &name, double ms, size_t count)
+{
+    QJsonObject result{{"bench", "scene"},
+                       {"model", model},
+                       {"nodes", static_cast<qint64>(nodes)},
+                       {"case", name},
+                       {"ms", ms},
+                       {"count", static_cast<qint64>(count)}};
+    const QByteArray line = QJsonDocument(result).toJson(QJsonDocument::Compact);
+    std::fwrite(line.constData(), 1, static_cast<size_t>(line.size()), s_output);
+    std::fputc('\n', s_output);
+    std::fflush(s_output);
+}
+
+/// Milliseconds the callable takes.
+template <typename F>
+double timed(F &&work)
+{
+    const auto start = std::chrono::steady_clock::now();
+    work();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/// Multiplier of the permutation i -> i * m + 1 mod n of the second input of every node.
+size_t permutationMultiplier(size_t nodes)
+{
+    size_t multiplier = 7919;
+    while (nodes > 1 && std::gcd(multiplier, nodes) != 1)
+        ++multiplier;
+    return multiplier;
+}
+
+/// The connections of the synthetic graph, by index of the node.
+std::vector<std::pair<size_t, size_t>> graphEdges(size_t nodes)
+{
+    std::vector<std::pair<size_t, size_t>> edges;
+    edges.reserve(2 * nodes);
+    const size_t multiplier = permutationMultiplier(nodes);
+    for (size_t i = 0; i < nodes; ++i) {
+        if (i + 1 < nodes)
+            edges.emplace_back(i, i + 1);
+        edges.emplace_back(i, (i * multiplier + 1) % nodes);
+    }
+    return edges;
+}
+
+/**
+ * @brief Selects every step-th node that has a graphics object.
+ * @return The nodes selected.
+ */
+size_t selectNodes(BasicGraphicsScene &scene, std::vector<NodeId> const &ids, size_t step)
+{
+    scene.clearSelection();
+    size_t selected = 0;
+    for (size_t i = 0; i < ids.size(); i += step) {
+        if (auto *object = scene.nodeGraphicsObject(ids[i])) {
+            object->setSelected(true);
+            ++selected;
+        }
+    }
+    return selected;
+}
+
+/**
+ * @brief Times the scene of a built model.
+ * @param makeScene Creates the scene of the model.
+ */
+template <typename MakeScene>
+void benchScene(QString const &model,
+                AbstractGraphModel &graphModel,
+                std::vector<NodeId> const &ids,
+                size_t virtualizeAt,
+                MakeScene &&makeScene)
+{
+    const size_t nodes = ids.size();
+
+    std::unique_ptr<BasicGraphicsScene> scene;
+    printResult(model, nodes, "scene", timed([&]() { scene = makeScene(); }), nodes);
+    if (virtualizeAt > 0) {
+        scene->setVirtualizationThreshold(virtualizeAt);
+        // the view of the editor shows the top left corner
+        scene->setVisibleSceneRect(QRectF(0, 0, kPaintSize, kPaintSize));
+    }
+
+    QImage image(kPaintSize, kPaintSize, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::white);
+    printResult(model, nodes, "paint", timed([&]() {
+        QPainter painter(&image);
+        scene->render(&painter, QRectF(image.rect()), scene->itemsBoundingRect());
+    }), nodes);
+
+    const size_t dragged = selectNodes(*scene, ids, 10);
+    printResult(model, nodes, "drag", timed([&]() {
+        for (int i = 0; i < kDragSteps; ++i)
+            scene->undoStack().push(new QtNodes::MoveNodeCommand(scene.get(), QPointF(2.0, 1.0)));
+        scene->flushConnectionMoves();
+    }), dragged);
+
+    const size_t deleted = selectNodes(*scene, ids, 100);
+    printResult(model, nodes, "delete", timed([&]() {
+        scene->undoStack().push(new QtNodes::DeleteCommand(scene.get()));
+    }), deleted);
+    printResult(model, nodes, "undo", timed([&]() { scene->undoStack().undo(); }), deleted);
+    printResult(model, nodes, "redo", timed([&]() { scene->undoStack().redo(); }), deleted);
+    scene->undoStack().undo();
+
+    size_t connections = 0;
+    const std::unordered_set<NodeId> all = graphModel.allNodeIds();
+    const double ms = timed([&]() {
+        for (NodeId id : all)
+            connections += graphModel.allConnectionIds(id).size();
+    });
+    printResult(model, nodes, "allConnectionIds", ms, connections / 2);
+}
+
+/**
+ * @brief Builds the graph with addNode and addConnection and times the steps.
+ * @param addNode Adds a node with its ports and returns its id.
+ */
+template <typename AddNode>
+std::vector<NodeId> buildGraph(QString const &model, AbstractGraphModel &graphModel, size_t nodes, AddNode &&addNode)
+{
+    std::vector<NodeId> ids;
+    ids.reserve(nodes);
+    printResult(model, nodes, "addNode", timed([&]() {
+        for (size_t i = 0; i < nodes; ++i) {
+            const NodeId id = addNode();
+            graphModel.setNodeData(id, NodeRole::Position,
+                                   QPointF((i % 100) * kNodeSpacing, (i / 100) * kNodeSpacing));
+            ids.push_back(id);
+        }
+    }), nodes);
+
+    const std::vector<std::pair<size_t, size_t>> edges = graphEdges(nodes);
+    printResult(model, nodes, "addConnection", timed([&]() {
+        for (size_t e = 0; e < edges.size(); ++e) {
+            // the chain feeds input 0, the permutation input 1
+            const QtNodes::PortIndex in = edges[e].second == edges[e].first + 1 ? 0 : 1;
+            graphModel.addConnection(ConnectionId{ids[edges[e].first], 0, ids[edges[e].second], in});
+        }
+    }), edges.size());
+    return ids;
+}
+
+void benchDynamicPorts(size_t nodes, size_t virtualizeAt)
+{
+    const QString model = QStringLiteral("DynamicPortsModel");
+    DynamicPortsModel graphModel;
+    const std::vector<NodeId> ids = buildGraph(model, graphModel, nodes, [&graphModel]() {
+        const NodeId id = graphModel.addNode();
+        graphModel.setNodeData(id, NodeRole::InPortCount, 2u);
+        graphModel.setNodeData(id, NodeRole::OutPortCount, 1u);
+        return id;
+    });
+    benchScene(model, graphModel, ids, virtualizeAt, [&graphModel]() {
+        return std::make_unique<BasicGraphicsScene>(graphModel);
+    });
+}
+
+void benchDataFlow(size_t nodes, size_t virtualizeAt)
+{
+    const QString model = QStringLiteral("DataFlowGraphModel");
+    auto registry = std::make_shared<QtNodes::NodeDelegateModelRegistry>();
+    registry->registerModel<BenchNode>("Bench");
+    DataFlowGraphModel graphModel(registry);
+    const std::vector<NodeId> ids = buildGraph(model, graphModel, nodes, [&graphModel]() {
+        return graphModel.addNode(QStringLiteral("BenchNode"));
+    });
+    benchScene(model, graphModel, ids, virtualizeAt, [&graphModel]() {
+        return std::make_unique<DataFlowGraphicsScene>(graphModel);
+    });
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication app(argc, argv);
+
+    QCommandLineParser options;
+    options.setApplicationDescription("Times the graph models and the scene of the node editor on synthetic graphs.");
+    options.addHelpOption();
+    options.addOptions({
+        {"sizes", "Comma separated node counts, 1000,10000,100000 by default.", "list", "1000,10000,100000"},
+        {"model", "Only this model, dynamic or dataflow.", "model"},
+        {"virtualize", "Virtualize the scenes of <n> nodes and more, as the editor does.", "n", "0"},
+        {"output", "Append the results to <file> instead of the standard output.", "file"},
+    });
+    options.process(app);
+
+    std::vector<size_t> sizes;
+    for (QString const &size : options.value("sizes").split(',', Qt::SkipEmptyParts)) {
+        const qlonglong nodes = size.trimmed().toLongLong();
+        if (nodes <= 0) {
+            std::fprintf(stderr, "icp-scene-bench: bad size %s\n", qPrintable(size));
+            return 2;
+        }
+        sizes.push_back(static_cast<size_t>(nodes));
+    }
+    const QString only = options.value("model");
+    if (!only.isEmpty() && only != "dynamic" && only != "dataflow") {
+        std::fprintf(stderr, "icp-scene-bench: --model expects dynamic or dataflow\n");
+        return 2;
+    }
+    const size_t virtualizeAt = options.value("virtualize").toULongLong();
+
+    if (options.isSet("output")) {
+        s_output = std::fopen(qPrintable(options.value("output")), "a");
+        if (!s_output) {
+            std::fprintf(stderr, "icp-scene-bench: cannot open %s\n", qPrintable(options.value("output")));
+            return 1;
+        }
+    }
+
+    for (size_t nodes : sizes) {
+        if (only.isEmpty() || only == "dynamic")
+            benchDynamicPorts(nodes, virtualizeAt);
+        if (only.isEmpty() || only == "dataflow")
+            benchDataFlow(nodes, virtualizeAt);
+    }
+
+    if (s_output != stdout)
+        std::fclose(s_output);
+    return 0;
+}
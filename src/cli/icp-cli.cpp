@@ -0,0 +1,437 @@
+/**
+ * @file icp-cli.cpp
+ * @brief Headless command line front end: load, convert, validate, generate and run an automaton.
+ *
+ * The tool links only icp-core (Qt Core and Network). Converting, validating and
+ * generating run without any application object, so a batch job starts in a few
+ * milliseconds; a QCoreApplication is created only for --run, which needs the event
+ * loop for the engine signals or the Python process and its connection.
+ *
+ * Every message of the running FSM is printed to the standard output as one JSON line
+ * ({"type": ..., "payload": ...}, see CommunicationProtocol.md), --validate prints one
+ * VALIDATION line. Diagnostics go to the standard error.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLoggingCategory>
+#include <QProcessEnvironment>
+#include <QTimer>
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <unordered_set>
+
+#include "../engine/cpp-generator.hpp"
+#include "../engine/fsm-fleet.hpp"
+#include "../interpret_generator.h"
+#include "../load/fsm-snapshot.hpp"
+#include "../load/graph-loader.hpp"
+#include "../run/fsm-run.hpp"
+#include "../spec_parser/automaton-binary.hpp"
+#include "../spec_parser/automaton-optimizer.hpp"
+#include "../spec_parser/automaton-parser.hpp"
+
+// exit codes
+static constexpr int kExitOk = 0;
+static constexpr int kExitFailed = 1;   ///< the file cannot be read or written, the FSM failed
+static constexpr int kExitUsage = 2;
+
+static void printLine(const QJsonObject& message)
+{
+    const QByteArray line = QJsonDocument(message).toJson(QJsonDocument::Compact);
+    std::fwrite(line.constData(), 1, static_cast<size_t>(line.size()), stdout);
+    std::fputc('\n', stdout);
+}
+
+static void printError(const QString& text)
+{
+    std::fprintf(stderr, "icp-cli: %s\n", qPrintable(text));
+}
+
+/**
+ * @brief Reads a text (.fsm) or binary (.fsmb) automaton.
+ * @return False if the file cannot be opened or is not a valid .fsmb file.
+ */
+static bool readAutomaton(const std::string& filename, Automaton& automaton, std::vector<StateInfo>* statesInfo)
+{
+    if (!LoadedSource(filename).isValid())
+        return false;
+    if (AutomatonBinary::IsBinaryFile(filename))
+        return AutomatonBinary::FromFile(filename, automaton, statesInfo);
+    AutomatonParser::FromFile(filename, automaton, statesInfo); // syntax errors are printed, the lines are skipped
+    return true;
+}
+
+/**
+ * @brief Writes the automaton in the format of the extension, .fsmb is binary, anything else .fsm text.
+ */
+static bool convertAutomaton(const std::string& input, const QString& output)
+{
+    if (output.endsWith(".fsmb", Qt::CaseInsensitive)) {
+        Automaton automaton;
+        std::vector<StateInfo> statesInfo;
+        return readAutomaton(input, automaton, &statesInfo)
+               && AutomatonBinary::ToFile(output.toStdString(), automaton, &statesInfo);
+    }
+
+    // the text is written from the node graph, the same way the editor saves it;
+    // a lazy load leaves the texts in the mapped input until they are written
+    LoadedGraph graph;
+    loadGraph(input, graph, nullptr, LoadProgress(), true);
+    if (graph.startNode < 0) {
+        printError("The automaton has no start state, it cannot be written as .fsm text.");
+        return false;
+    }
+
+    FsmSnapshot snapshot;
+    snapshot.name = QString::fromStdString(graph.name);
+    snapshot.description = QString::fromStdString(graph.description);
+    snapshot.startNode = graph.startNode;
+    snapshot.variables = graph.variables;
+    snapshot.source = graph.source;
+    snapshot.nodes.reserve(graph.nodes.size());
+    for (const LoadedNode& loaded : graph.nodes) {
+        SnapshotNode node;
+        node.name = QString::fromStdString(loaded.name);
+        node.posX = loaded.posX;
+        node.posY = loaded.posY;
+        node.inPortCount = loaded.inPortCount;
+        node.outPortCount = loaded.outPortCount;
+        node.isFinal = loaded.isFinal;
+        node.lazyAction = loaded.actionRef;
+        node.lazyActionSet = true;
+        snapshot.nodes.push_back(std::move(node));
+    }
+    snapshot.connections.reserve(graph.connections.size());
+    for (const LoadedConnection& loaded : graph.connections) {
+        SnapshotConnection connection;
+        connection.outNode = loaded.outNode;
+        connection.inNode = loaded.inNode;
+        connection.lazyCondition = loaded.conditionRef;
+        connection.lazyConditionSet = true;
+        connection.delay = loaded.delay;
+        snapshot.connections.push_back(std::move(connection));
+    }
+    return writeFsmText(snapshot, output.toStdString());
+}
+
+/**
+ * @brief Prints the VALIDATION line of the automaton.
+ * @return The number of problems found.
+ */
+static int validateAutomaton(const Automaton& automaton)
+{
+    QJsonArray problems;
+    const auto& states = automaton.getStates();
+    const Symbol start = automaton.getStartName();
+    if (start.empty())
+        problems.append("No start state.");
+    else if (!states.count(start))
+        problems.append("The start state " + QString::fromStdString(start.str()) + " is not defined.");
+
+    for (Symbol state : automaton.getFinalStates()) {
+        if (!states.count(state))
+            problems.append("The final state " + QString::fromStdString(state.str()) + " is not defined.");
+    }
+
+    std::unordered_set<Symbol> reported; // one problem per undefined state
+    for (const Transition& t : automaton.getTransitions()) {
+        for (Symbol state : {t.fromState, t.toState}) {
+            if (!states.count(state) && reported.insert(state).second)
+                problems.append("The state " + QString::fromStdString(state.str()) + " of a transition is not defined.");
+        }
+        if (t.delay < 0)
+            problems.append("The transition " + QString::fromStdString(t.fromState.str()) + " -> "
+                            + QString::fromStdString(t.toState.str()) + " has a negative delay.");
+    }
+
+    // unreachable parts are not errors, the generators drop them
+    OptimizationStats stats;
+    optimizeAutomaton(automaton, &stats);
+
+    printLine({{"type", "VALIDATION"},
+               {"payload", QJsonObject{{"name", QString::fromStdString(automaton.getName())},
+                                       {"states", static_cast<qint64>(states.size())},
+                                       {"transitions", static_cast<qint64>(automaton.getTransitions().size())},
+                                       {"variables", static_cast<qint64>(automaton.getVariables().size())},
+                                       {"unreachable_states", static_cast<qint64>(stats.removedStates)},
+                                       {"shadowed_transitions", static_cast<qint64>(stats.removedTransitions)},
+                                       {"problems", problems}}}});
+    return static_cast<int>(problems.size());
+}
+
+/**
+ * @brief Writes the C++ source of the compiled backend, - for the standard output.
+ */
+static bool generateCpp(const Automaton& automaton, const QString& output)
+{
+    std::string source;
+    try {
+        source = CppGenerator::generate(automaton);
+    } catch (const ExpressionError& e) {
+        printError(QString("The automaton cannot be compiled to C++: %1").arg(e.what()));
+        return false;
+    }
+
+    if (output == "-") {
+        std::fwrite(source.data(), 1, source.size(), stdout);
+        return true;
+    }
+    QFile file(output);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)
+        || file.write(source.data(), static_cast<qint64>(source.size())) != static_cast<qint64>(source.size())) {
+        printError("Cannot write " + output + ".");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Runs many instances of the automaton in an FsmFleet, prints one FLEET line.
+ *
+ * The instances run until they end or the timeout stops them; no event loop is needed.
+ * @return The exit code of the tool, failed if an instance failed.
+ */
+static int runFleet(const Automaton& automaton, const QCommandLineParser& options)
+{
+    const qint64 instances = options.value("fleet").toLongLong();
+    const unsigned threads = options.isSet("threads") ? options.value("threads").toUInt() : 0;
+
+    std::unique_ptr<FsmFleet> fleet;
+    try {
+        fleet = std::make_unique<FsmFleet>(automaton, threads);
+    } catch (const ExpressionError& e) {
+        printError(QString("Cannot compile the automaton: ") + e.what());
+        return kExitFailed;
+    }
+    fleet->setVirtualTime(options.isSet("virtual-time"));
+
+    const auto started = std::chrono::steady_clock::now();
+    for (qint64 i = 0; i < instances; ++i)
+        fleet->spawn();
+
+    if (!options.isSet("timeout")) {
+        while (!fleet->waitIdle(std::chrono::hours(1))) {
+        }
+    } else if (!fleet->waitIdle(std::chrono::milliseconds(options.value("timeout").toLongLong()))) {
+        fleet->stopAll();
+        fleet->waitIdle(std::chrono::seconds(5));
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    qint64 outcomes[5] = {};
+    double steps = 0.0;
+    for (qint64 i = 0; i < instances; ++i) {
+        const auto id = static_cast<FsmFleet::InstanceId>(i);
+        ++outcomes[static_cast<size_t>(fleet->outcome(id))];
+        steps += fleet->steps(id);
+    }
+
+    printLine({{"type", "FLEET"},
+               {"payload", QJsonObject{{"instances", instances},
+                                       {"threads", static_cast<int>(fleet->threadCount())},
+                                       {"running", outcomes[static_cast<size_t>(FleetOutcome::Running)]},
+                                       {"finished", outcomes[static_cast<size_t>(FleetOutcome::Finished)]},
+                                       {"stuck", outcomes[static_cast<size_t>(FleetOutcome::Stuck)]},
+                                       {"error", outcomes[static_cast<size_t>(FleetOutcome::Error)]},
+                                       {"stopped", outcomes[static_cast<size_t>(FleetOutcome::Stopped)]},
+                                       {"mean_steps", instances > 0 ? steps / static_cast<double>(instances) : 0.0},
+                                       {"bytes_per_instance", static_cast<qint64>(fleet->bytesPerInstance())},
+                                       {"seconds", seconds}}}});
+    std::fflush(stdout);
+    return outcomes[static_cast<size_t>(FleetOutcome::Error)] > 0 ? kExitFailed : kExitOk;
+}
+
+/**
+ * @brief Runs the automaton until it finishes, prints its messages.
+ * @return The exit code of the tool.
+ */
+static int runAutomaton(int argc, char* argv[], const Automaton& automaton, const QCommandLineParser& options)
+{
+    QCoreApplication app(argc, argv);
+    const QString mode = options.value("run");
+    int exitCode = kExitOk;
+
+    FsmRun run(1);
+    QObject::connect(&run, &FsmRun::messageReceived, [&exitCode](int, const QJsonObject& message) {
+        const QString type = message["type"].toString();
+        if (type == "FSM_ERROR")
+            exitCode = kExitFailed;
+        printLine(message);
+        if (type == "FSM_ERROR" || type == "FSM_FINISHED" || type == "FSM_STUCK" || type == "FSM_STOPPED")
+            std::fflush(stdout);
+    });
+    if (options.isSet("verbose"))
+        QObject::connect(&run, &FsmRun::logMessage, [](int, const QString& line) { printError(line); });
+    QObject::connect(&run, &FsmRun::finished, &app, [&app]() { app.quit(); });
+
+    if (options.isSet("timeout")) {
+        // the FSM is asked to stop, a process that does not react is killed at exit
+        QTimer::singleShot(options.value("timeout").toInt(), &app, [&run, &app]() {
+            run.stop();
+            QTimer::singleShot(1000, &app, [&app]() { app.quit(); });
+        });
+    }
+
+    const bool virtualTime = options.isSet("virtual-time");
+    if (mode == "native") {
+        QByteArray checkpoint;
+        if (options.isSet("restore")) {
+            QFile file(options.value("restore"));
+            if (!file.open(QIODevice::ReadOnly)) {
+                printError("Cannot read " + file.fileName() + ".");
+                return kExitFailed;
+            }
+            checkpoint = file.readAll();
+        }
+        if (options.isSet("checkpoint"))
+            run.setCheckpointFile(options.value("checkpoint"), options.value("checkpoint-interval").toInt());
+        if (!run.startEngine(automaton, virtualTime, options.isSet("profile"), options.isSet("compiled"), checkpoint))
+            return kExitFailed;
+    } else {
+        // the script is piped to the interpreter, fsm_core is found in the runtime directory
+        InterpretGenerator generator;
+        generator.setTableDriven(options.isSet("table-driven"));
+        generator.setLazyFunctions(options.isSet("lazy-functions"));
+        generator.setVirtualTime(virtualTime);
+        generator.setThroughputMode(options.isSet("throughput"));
+        const QByteArray script = generator.generateScript(automaton);
+
+        const QString runtimeDir = options.isSet("runtime-dir") ? options.value("runtime-dir")
+                                                                : QCoreApplication::applicationDirPath() + "/interpret";
+        QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+        const QString pythonPath = env.value("PYTHONPATH");
+        env.insert("PYTHONPATH", pythonPath.isEmpty() ? runtimeDir : runtimeDir + QDir::listSeparator() + pythonPath);
+
+        const QString logFilePath = options.isSet("log") ? options.value("log")
+                                                         : QDir::tempPath() + "/icp-cli-" + QString::number(QCoreApplication::applicationPid()) + ".log";
+        if (!run.startPython(options.value("python"), {"-"}, env, logFilePath, script, false)) {
+            printError("Cannot start " + options.value("python") + ".");
+            return kExitFailed;
+        }
+    }
+
+    app.exec();
+    std::fflush(stdout);
+    return exitCode;
+}
+
+int main(int argc, char* argv[])
+{
+    QStringList arguments;
+    for (int i = 0; i < argc; ++i)
+        arguments << QString::fromLocal8Bit(argv[i]);
+
+    QCommandLineParser options;
+    options.setApplicationDescription("Loads an automaton, converts, validates, generates and runs it without the editor.");
+    options.addHelpOption();
+    options.addPositionalArgument("file", "The automaton, .fsm text or .fsmb binary.");
+    options.addOptions({
+        {"convert", "Write the automaton to <out>, .fsmb is binary, anything else .fsm text.", "out"},
+        {"validate", "Check the automaton, print a VALIDATION line, fail if it has problems."},
+        {"generate", "Write the Python interpret to <out>, - for the standard output.", "out"},
+        {"generate-cpp", "Write the C++ of the compiled native engine to <out>, - for the standard output.", "out"},
+        {"table-driven", "Generate the table driven interpret."},
+        {"lazy-functions", "The interpret compiles a function the first time it is called."},
+        {"run", "Run the automaton natively or in the Python runtime, print its messages.", "native|python"},
+        {"virtual-time", "Delays advance a simulated clock instead of waiting."},
+        {"throughput", "The Python runtime skips the per-step logging and events, the state is sampled."},
+        {"profile", "The native engine sends PROFILE messages."},
+        {"compiled", "The native engine runs the automaton compiled to C++, cached by its content."},
+        {"checkpoint", "The native engine saves its checkpoints to <file>, removed when the automaton finishes.", "file"},
+        {"checkpoint-interval", "Checkpoint the native run every <ms> milliseconds and when it is stopped.", "ms", "0"},
+        {"restore", "The native run resumes from the checkpoint <file>.", "file"},
+        {"fleet", "Run <n> instances natively on a few threads, print a FLEET line.", "n"},
+        {"threads", "Worker threads of --fleet, one per hardware thread by default.", "n"},
+        {"timeout", "Stop the run after <ms> milliseconds.", "ms"},
+        {"python", "The Python interpreter of --run python.", "exe", "python"},
+        {"runtime-dir", "Directory with fsm_core, <executable dir>/interpret by default.", "dir"},
+        {"log", "Output of the Python process, a temporary file by default.", "file"},
+        {"verbose", "Print the run events and the library diagnostics to the standard error."},
+    });
+
+    if (!options.parse(arguments)) {
+        printError(options.errorText());
+        return kExitUsage;
+    }
+    if (options.isSet("help")) {
+        std::fputs(qPrintable(options.helpText()), stdout);
+        return kExitOk;
+    }
+    if (options.positionalArguments().size() != 1) {
+        printError("Expected one automaton file, see --help.");
+        return kExitUsage;
+    }
+    if (options.isSet("run") && options.value("run") != "native" && options.value("run") != "python") {
+        printError("--run expects native or python.");
+        return kExitUsage;
+    }
+    if ((options.isSet("checkpoint") || options.isSet("restore")) && options.value("run") != "native") {
+        printError("--checkpoint and --restore expect --run native.");
+        return kExitUsage;
+    }
+    if (options.isSet("fleet") && options.value("fleet").toLongLong() <= 0) {
+        printError("--fleet expects a positive instance count.");
+        return kExitUsage;
+    }
+    if (!options.isSet("verbose"))
+        QLoggingCategory::setFilterRules("*.debug=false\n*.info=false");
+
+    const QString input = options.positionalArguments().first();
+    const std::string filename = QFileInfo(input).absoluteFilePath().toStdString();
+
+    if (options.isSet("convert") && !convertAutomaton(filename, options.value("convert"))) {
+        printError("Cannot convert " + input + " to " + options.value("convert") + ".");
+        return kExitFailed;
+    }
+
+    const bool needsAutomaton = options.isSet("validate") || options.isSet("generate") || options.isSet("generate-cpp")
+                                || options.isSet("run") || options.isSet("fleet");
+    if (!needsAutomaton)
+        return kExitOk;
+
+    Automaton automaton;
+    if (!readAutomaton(filename, automaton, nullptr)) {
+        printError("Cannot read " + input + ".");
+        return kExitFailed;
+    }
+
+    if (options.isSet("validate") && validateAutomaton(automaton) > 0)
+        return kExitFailed;
+
+    if (options.isSet("generate")) {
+        InterpretGenerator generator;
+        generator.setTableDriven(options.isSet("table-driven"));
+        generator.setLazyFunctions(options.isSet("lazy-functions"));
+        generator.setVirtualTime(options.isSet("virtual-time"));
+        generator.setThroughputMode(options.isSet("throughput"));
+        const QString output = options.value("generate");
+        if (output == "-") {
+            const QByteArray script = generator.generateScript(automaton);
+            std::fwrite(script.constData(), 1, static_cast<size_t>(script.size()), stdout);
+        } else if (!generator.generate(automaton, output)) {
+            printError("Cannot write " + output + ".");
+            return kExitFailed;
+        }
+    }
+
+    if (options.isSet("generate-cpp") && !generateCpp(automaton, options.value("generate-cpp")))
+        return kExitFailed;
+
+    if (options.isSet("fleet"))
+        return runFleet(automaton, options);
+    if (options.isSet("run"))
+        return runAutomaton(argc, argv, automaton, options);
+    return kExitOk;
+}
@@ -27,14 +27,92 @@
  * @signal messageReceived(const QJsonObject &message) Emitted when a valid JSON message is received.
  */
 #include "client.hpp"
+#include "transport/shared-ring.hpp"
+
+#include <QCborArray>
+#include <QCborMap>
+#include <QHash>
+#include <QJsonArray>
+#include <QTimer>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cctype>
+
+namespace {
+
+/// Type codes of the CBOR encoding are the positions in this table starting at 1, same as MESSAGE_TYPES in fsm_core/wire.py.
+const char* const kMessageTypes[] = {
+    "FSM_CONNECTED",
+    "FSM_STARTED",
+    "FSM_ERROR",
+    "CURRENT_STATE",
+    "STATE_ACTION_EXECUTED",
+    "TRANSITION_TAKEN",
+    "TRANSITION_ACTION_EXECUTED",
+    "VARIABLE_UPDATE",
+    "FSM_FINISHED",
+    "FSM_STUCK",
+    "FSM_STOPPED",
+    "AUTOMATON_LOADED",
+    "SET_VARIABLE",
+    "STOP_FSM",
+    "LOAD_AUTOMATON",
+    "SHUTDOWN",
+    "SET_ENCODING",
+    "ENCODING_SET",
+    "VARIABLES_BATCH",
+    "SET_VARIABLES",
+    "GET_STATS",
+    "STATS",
+    "SET_TRANSPORT",
+    "TRANSPORT_SET",
+    "RELOAD_FUNCTIONS",
+    "FUNCTIONS_RELOADED",
+    "SET_MULTIPLEX",
+    "MULTIPLEX_SET",
+    "BATCH",
+    "CREDIT",
+    "CLOSE_INSTANCE",
+};
+constexpr int kMessageTypeCount = sizeof(kMessageTypes) / sizeof(kMessageTypes[0]);
+constexpr int kProtocolVersion = 1;
+constexpr int kMaxRingReads = 16;   ///< ring reads per event loop pass, a busy runtime cannot starve the UI
+const char kDoorbell = 1;
+
+QCborValue typeCode(const QString &type)
+{
+    static const QHash<QString, int> codes = []() {
+        QHash<QString, int> result;
+        for (int i = 0; i < kMessageTypeCount; ++i)
+            result.insert(QString::fromLatin1(kMessageTypes[i]), i + 1);
+        return result;
+    }();
+
+    const auto it = codes.constFind(type);
+    return it != codes.constEnd() ? QCborValue(*it) : QCborValue(type); // unknown types go by name
+}
+
+/// Type of a BATCH entry, a code in the CBOR encoding and a name in JSON.
+QString typeName(const QJsonValue &code)
+{
+    const int index = code.toInt();
+    if (code.isDouble() && index > 0 && index <= kMessageTypeCount)
+        return QString::fromLatin1(kMessageTypes[index - 1]);
+    return code.toString();
+}
+
+} // namespace
 
 FsmClient::FsmClient(QObject *parent)
-    : QObject(parent), m_socket(new QTcpSocket(this))
+    : QObject(parent), m_tcpSocket(new QTcpSocket(this))
 {
-    connect(m_socket, &QTcpSocket::connected, this, &FsmClient::onConnected);
-    connect(m_socket, &QTcpSocket::disconnected, this, &FsmClient::onDisconnected);
-    connect(m_socket, &QTcpSocket::errorOccurred, this, &FsmClient::onErrorOccurred);
-    connect(m_socket, &QTcpSocket::readyRead, this, &FsmClient::onReadyRead);
+    m_socket = m_tcpSocket;
+    connect(m_tcpSocket, &QTcpSocket::connected, this, &FsmClient::onConnected);
+    connect(m_tcpSocket, &QTcpSocket::disconnected, this, &FsmClient::onDisconnected);
+    connect(m_tcpSocket, &QTcpSocket::errorOccurred, this, &FsmClient::onErrorOccurred);
+    connect(m_tcpSocket, &QTcpSocket::readyRead, this, &FsmClient::onReadyRead);
+    connect(m_tcpSocket, &QTcpSocket::bytesWritten, this, &FsmClient::flushWriteQueue);
 }
 
 FsmClient::~FsmClient()
@@ -45,34 +123,105 @@ FsmClient::~FsmClient()
 
 void FsmClient::connectToServer(const QString &host, quint16 port)
 {
-    if (m_socket->state() == QAbstractSocket::UnconnectedState) {
+    if (isUnconnected()) {
         qInfo() << "[Client] Attempting to connect to" << host << ":" << port;
-        m_socket->connectToHost(host, port);
+        m_socket = m_tcpSocket;
+        m_tcpSocket->connectToHost(host, port);
     } else {
         qWarning() << "[Client] Already connected or connecting.";
     }
 }
 
+bool FsmClient::connectToEndpoint(const QString &endpoint)
+{
+    if (endpoint.startsWith("unix:")) {
+        // unix:/path and unix:///path name the same socket file
+        QString path = endpoint.mid(5);
+        if (path.startsWith("///"))
+            path = path.mid(2);
+        if (path.isEmpty() || !isUnconnected()) {
+            qWarning() << "[Client] Cannot connect to" << endpoint;
+            return false;
+        }
+        if (!m_localSocket) {
+            m_localSocket = new QLocalSocket(this);
+            connect(m_localSocket, &QLocalSocket::connected, this, &FsmClient::onConnected);
+            connect(m_localSocket, &QLocalSocket::disconnected, this, &FsmClient::onDisconnected);
+            connect(m_localSocket, &QLocalSocket::errorOccurred, this, &FsmClient::onLocalErrorOccurred);
+            connect(m_localSocket, &QLocalSocket::readyRead, this, &FsmClient::onReadyRead);
+            connect(m_localSocket, &QLocalSocket::bytesWritten, this, &FsmClient::flushWriteQueue);
+        }
+        qInfo() << "[Client] Attempting to connect to" << path;
+        m_socket = m_localSocket;
+        m_localSocket->connectToServer(path);
+        return true;
+    }
+
+    // tcp://host:port, a bare port is on localhost
+    QString host = "localhost";
+    QString port = endpoint;
+    if (endpoint.startsWith("tcp://")) {
+        const QString address = endpoint.mid(6);
+        const qsizetype colon = address.lastIndexOf(':');
+        host = address.left(colon).remove('[').remove(']'); // [::1]:port
+        port = address.mid(colon + 1);
+    }
+    bool ok = false;
+    const quint16 number = port.toUShort(&ok);
+    if (!ok || number == 0 || host.isEmpty()) {
+        qWarning() << "[Client] Invalid endpoint" << endpoint;
+        return false;
+    }
+    connectToServer(host, number);
+    return true;
+}
+
 bool FsmClient::isConnected() const
 {
-    return m_socket->state() == QAbstractSocket::ConnectedState;
+    if (m_socket == m_localSocket)
+        return m_localSocket->state() == QLocalSocket::ConnectedState;
+    return m_tcpSocket->state() == QAbstractSocket::ConnectedState;
+}
+
+bool FsmClient::isUnconnected() const
+{
+    if (m_socket == m_localSocket)
+        return m_localSocket->state() == QLocalSocket::UnconnectedState;
+    return m_tcpSocket->state() == QAbstractSocket::UnconnectedState;
+}
+
+bool FsmClient::isLocalPeer() const
+{
+    return m_socket == m_localSocket || m_tcpSocket->peerAddress().isLoopback();
+}
+
+FsmClient::Transport FsmClient::transport() const
+{
+    return m_shared ? Transport::SharedMemory : Transport::Tcp;
 }
 
 void FsmClient::disconnectFromServer()
 {
-    if (m_socket->state() != QAbstractSocket::UnconnectedState) {
+    if (!isUnconnected()) {
         qInfo() << "[Client] Disconnecting from server.";
-        m_socket->disconnectFromHost();
-        if (m_socket->state() == QAbstractSocket::UnconnectedState) {
-            // If already disconnected (e.g. server closed connection), ensure our signal fires.
-            // onDisconnected will be called by the socket if it was connected.
-        }
+        // the socket writes what it has before it closes, give it the whole queue
+        if (m_shared)
+            flushSharedRing(); // what does not fit into the ring is lost
+        else if (isConnected() && m_writeOffset < m_writeQueue.size())
+            m_socket->write(m_writeQueue.constData() + m_writeOffset, m_writeQueue.size() - m_writeOffset);
+        m_writeQueue.clear();
+        m_writeOffset = 0;
+        // onDisconnected will be called by the socket if it was connected
+        if (m_socket == m_localSocket)
+            m_localSocket->disconnectFromServer();
+        else
+            m_tcpSocket->disconnectFromHost();
     }
 }
 
-void FsmClient::sendSetVariable(const QString &variableName, const QJsonValue &value)
+void FsmClient::sendSetVariable(const QString &variableName, const QJsonValue &value, int instance)
 {
-    if (m_socket->state() != QAbstractSocket::ConnectedState) {
+    if (!isConnected() && instance < 0) {
         qWarning() << "[Client] Cannot send message: Not connected.";
         return;
     }
@@ -84,13 +233,34 @@ void FsmClient::sendSetVariable(const QString &variableName, const QJsonValue &v
     QJsonObject message;
     message["type"] = "SET_VARIABLE";
     message["payload"] = payload;
+    if (instance >= 0)
+        message["instance"] = instance;
 
     sendMessage(message);
 }
 
-void FsmClient::sendStopFsm()
+void FsmClient::sendSetVariables(const QJsonObject &values, int instance)
 {
-    if (m_socket->state() != QAbstractSocket::ConnectedState) {
+    if (!isConnected() && instance < 0) {
+        qWarning() << "[Client] Cannot send message: Not connected.";
+        return;
+    }
+
+    QJsonObject payload;
+    payload["variables"] = values;
+
+    QJsonObject message;
+    message["type"] = "SET_VARIABLES";
+    message["payload"] = payload;
+    if (instance >= 0)
+        message["instance"] = instance;
+
+    sendMessage(message);
+}
+
+void FsmClient::sendStopFsm(int instance)
+{
+    if (!isConnected() && instance < 0) {
         qWarning() << "[Client] Cannot send message: Not connected.";
         return;
     }
@@ -98,29 +268,169 @@ void FsmClient::sendStopFsm()
     QJsonObject message;
     message["type"] = "STOP_FSM";
     message["payload"] = QJsonObject(); // Empty payload
+    if (instance >= 0)
+        message["instance"] = instance;
 
     sendMessage(message);
 }
 
+void FsmClient::sendGetStats(double intervalSeconds, int instance)
+{
+    if (!isConnected() && instance < 0) {
+        qWarning() << "[Client] Cannot send message: Not connected.";
+        return;
+    }
+
+    QJsonObject payload;
+    if (intervalSeconds >= 0)
+        payload["interval"] = intervalSeconds;
+
+    QJsonObject message;
+    message["type"] = "GET_STATS";
+    message["payload"] = payload;
+    if (instance >= 0)
+        message["instance"] = instance;
+
+    sendMessage(message);
+}
+
+void FsmClient::sendLoadAutomaton(const QByteArray &code, int instance)
+{
+    if (!isConnected() && instance < 0) {
+        qWarning() << "[Client] Cannot send message: Not connected.";
+        return;
+    }
+
+    QJsonObject payload;
+    payload["code"] = QString::fromUtf8(code);
+
+    QJsonObject message;
+    message["type"] = "LOAD_AUTOMATON";
+    message["payload"] = payload;
+    if (instance >= 0)
+        message["instance"] = instance;
+
+    sendMessage(message);
+}
+
+void FsmClient::sendReloadFunctions(const QByteArray &code, int instance)
+{
+    if (!isConnected() && instance < 0) {
+        qWarning() << "[Client] Cannot send message: Not connected.";
+        return;
+    }
+
+    QJsonObject payload;
+    payload["code"] = QString::fromUtf8(code);
+
+    QJsonObject message;
+    message["type"] = "RELOAD_FUNCTIONS";
+    message["payload"] = payload;
+    if (instance >= 0)
+        message["instance"] = instance;
+
+    sendMessage(message);
+}
+
+
+void FsmClient::encodeMessage(QByteArray &out, const QJsonObject &message, Encoding encoding)
+{
+    if (encoding == Encoding::Cbor) {
+        QCborArray frame{typeCode(message["type"].toString()),
+                         QCborMap::fromJsonObject(message["payload"].toObject())};
+        if (message.contains("instance"))
+            frame.append(message["instance"].toInt());
+        const QByteArray body = frame.toCborValue().toCbor();
+        const qsizetype header = out.size();
+        out.resize(header + 4);
+        qToBigEndian<quint32>(quint32(body.size()), out.data() + header);
+        out += body;
+    } else {
+        QJsonDocument doc(message);
+        out += doc.toJson(QJsonDocument::Compact);
+        out += '\n'; // Add newline delimiter
+    }
+}
 
 void FsmClient::sendMessage(const QJsonObject &message)
 {
-    if (m_socket->state() != QAbstractSocket::ConnectedState) {
+    if (message.contains("instance")) {
+        // the commands of an instance wait for SET_MULTIPLEX, those of a closed one are dropped
+        const int instance = message["instance"].toInt();
+        if (!m_instances.contains(instance)) {
+            qWarning() << "[Client] Error sending: Instance" << instance << "is not open.";
+            return;
+        }
+        if (!m_multiplexing) {
+            m_heldInstanceMessages.append(message);
+            return;
+        }
+    }
+
+    if (!isConnected()) {
         qWarning() << "[Client] Error sending: Not connected.";
         return;
     }
-    QJsonDocument doc(message);
-    QByteArray data = doc.toJson(QJsonDocument::Compact) + "\n"; // Add newline delimiter
-    qint64 bytesWritten = m_socket->write(data);
+
+    // messages are queued and written together once per event loop pass; while the
+    // transport is switched they are held back, the server reads nothing after SET_TRANSPORT
+    encodeMessage(m_transportPending ? m_heldQueue : m_writeQueue, message, m_sendEncoding);
+    // qInfo() << "[Client -> FSM] Queued:" << message; // Can be verbose
+    if (m_transportPending)
+        return;
+
+    if (isWriteQueueFull())
+        m_queueWasFull = true;
+
+    if (!m_flushScheduled) {
+        m_flushScheduled = true;
+        QMetaObject::invokeMethod(this, &FsmClient::flushWriteQueue, Qt::QueuedConnection);
+    }
+}
+
+void FsmClient::flushWriteQueue()
+{
+    m_flushScheduled = false;
+    if (m_writeOffset == m_writeQueue.size() || !isConnected())
+        return;
+
+    if (m_shared) {
+        flushSharedRing();
+        if (m_writeOffset < m_writeQueue.size() && !m_flushScheduled) {
+            // the ring is full, the runtime frees it soon
+            m_flushScheduled = true;
+            QTimer::singleShot(1, this, &FsmClient::flushWriteQueue);
+        }
+        return;
+    }
+
+    // the socket buffers everything it gets, so it only gets the next chunk once it has written
+    // the previous one; bytesWritten() calls this again
+    const qint64 room = kMaxSocketBuffer - m_socket->bytesToWrite();
+    if (room <= 0)
+        return;
+
+    const qint64 chunk = qMin<qint64>(room, m_writeQueue.size() - m_writeOffset);
+    const qint64 bytesWritten = m_socket->write(m_writeQueue.constData() + m_writeOffset, chunk);
     if (bytesWritten == -1) {
         qWarning() << "[Client] Error writing to socket:" << m_socket->errorString();
-    } else if (bytesWritten < data.size()) {
-        qWarning() << "[Client] Not all data written to socket. Wrote" << bytesWritten << "of" << data.size();
-        // Handle partial writes if necessary, though for small JSON it's less common
-    } else {
-        qInfo() << "[Client -> FSM] Sent:" << message; // Can be verbose
+        return;
+    }
+    m_writeOffset += bytesWritten; // partial writes stay queued
+
+    // the written part is only moved out once it is at least half of the queue
+    if (m_writeOffset == m_writeQueue.size()) {
+        m_writeQueue.truncate(0);
+        m_writeOffset = 0;
+    } else if (m_writeOffset >= m_writeQueue.size() / 2) {
+        m_writeQueue.remove(0, m_writeOffset);
+        m_writeOffset = 0;
+    }
+
+    if (m_queueWasFull && !isWriteQueueFull()) {
+        m_queueWasFull = false;
+        emit writeQueueDrained();
     }
-    m_socket->flush(); // Ensure data is sent immediately
 }
 
 
@@ -128,12 +438,31 @@ void FsmClient::onConnected()
 {
     qInfo() << "[Client] Successfully connected to FSM server.";
     m_buffer.clear(); // Clear buffer on new connection
+    m_readOffset = 0;
+    m_sendEncoding = Encoding::Json; // every connection starts with JSON
+    m_receiveEncoding = Encoding::Json;
+    m_writeQueue.clear();
+    m_writeOffset = 0;
+    m_queueWasFull = false;
+    m_shared.reset(); // every connection starts on TCP
+    m_transportPending = false;
+    m_heldQueue.clear();
+    m_multiplexing = false; // the instances opened meanwhile are multiplexed after FSM_CONNECTED
+    m_window = kMultiplexWindow;
+    m_consumed.clear();
     emit connected();
 }
 
 void FsmClient::onDisconnected()
 {
     qInfo() << "[Client] Disconnected from FSM server.";
+    m_shared.reset();
+    m_transportPending = false;
+    // the daemon has stopped the automata of the instances
+    m_multiplexing = false;
+    m_instances.clear();
+    m_consumed.clear();
+    m_heldInstanceMessages.clear();
     emit disconnected();
 }
 
@@ -151,25 +480,142 @@ void FsmClient::onErrorOccurred(QAbstractSocket::SocketError socketError)
     // The disconnected() signal will usually follow an error that causes disconnection.
 }
 
+void FsmClient::onLocalErrorOccurred(QLocalSocket::LocalSocketError socketError)
+{
+    if (socketError == QLocalSocket::PeerClosedError) {
+        qInfo() << "[Client] Server closed the local connection (normal disconnect).";
+        return;
+    }
+
+    qWarning() << "[Client] Local socket error:" << m_socket->errorString();
+    emit fsmError(m_socket->errorString());
+}
+
 void FsmClient::onReadyRead()
 {
+    if (m_shared) {
+        m_socket->readAll(); // doorbell bytes
+        drainSharedRing();
+        return;
+    }
+
+    // consumed messages are only moved out once they are at least half of the buffer,
+    // so every byte is moved a constant number of times on average
+    if (m_readOffset > 0 && m_readOffset >= m_buffer.size() / 2) {
+        m_buffer.remove(0, m_readOffset);
+        m_readOffset = 0;
+    }
     m_buffer.append(m_socket->readAll());
+    processBuffer();
+
+    // TRANSPORT_SET was in the data, the rest comes through the ring
+    if (m_shared)
+        drainSharedRing();
+}
 
-    // Process all complete JSON messages in the buffer
-    // Messages are expected to be newline-terminated
+void FsmClient::drainSharedRing()
+{
+    if (!m_shared)
+        return;
+
+    SharedRing &ring = m_shared->incoming();
+    for (int reads = 0; reads < kMaxRingReads; ++reads) {
+        if (m_readOffset > 0 && m_readOffset >= m_buffer.size() / 2) {
+            m_buffer.remove(0, m_readOffset);
+            m_readOffset = 0;
+        }
+        if (ring.readAll(m_buffer) == 0) {
+            if (ring.sleepIfEmpty())
+                return; // the runtime rings once it has written again
+            continue;
+        }
+        processBuffer();
+        if (!m_shared)
+            return; // disconnected by a receiver
+    }
+
+    // still busy, the rest is read in the next pass; the flag stays clear, no doorbell is needed
+    QMetaObject::invokeMethod(this, &FsmClient::drainSharedRing, Qt::QueuedConnection);
+}
+
+void FsmClient::flushSharedRing()
+{
+    SharedRing &ring = m_shared->outgoing();
+    m_writeOffset += ring.write(m_writeQueue.constData() + m_writeOffset, size_t(m_writeQueue.size() - m_writeOffset));
+    if (ring.takeWaiting())
+        m_socket->write(&kDoorbell, 1);
+
+    if (m_writeOffset == m_writeQueue.size()) {
+        m_writeQueue.truncate(0);
+        m_writeOffset = 0;
+    }
+    if (m_queueWasFull && !isWriteQueueFull()) {
+        m_queueWasFull = false;
+        emit writeQueueDrained();
+    }
+}
+
+void FsmClient::switchTransport(const QJsonObject &payload)
+{
+    m_transportPending = false;
+    if (payload["transport"].toString() == "shm") {
+        auto segment = std::make_unique<SharedSegment>();
+        if (!segment->attach(payload["name"].toString().toStdString())) {
+            // the server has switched already, the connection cannot go on over TCP
+            qWarning() << "[Client] Cannot map the shared memory transport" << payload["name"].toString();
+            emit fsmError("Cannot map the shared memory transport of the FSM.");
+            m_heldQueue.clear();
+            disconnectFromServer();
+            return;
+        }
+        m_shared = std::move(segment);
+        // the rest of the socket data are doorbell bytes
+        m_readOffset = m_buffer.size();
+        qInfo() << "[Client] Transport switched to shared memory" << payload["name"].toString();
+    }
+
+    m_writeQueue += m_heldQueue;
+    m_heldQueue.clear();
+    if (m_writeOffset < m_writeQueue.size() && !m_flushScheduled) {
+        m_flushScheduled = true;
+        QMetaObject::invokeMethod(this, &FsmClient::flushWriteQueue, Qt::QueuedConnection);
+    }
+}
+
+void FsmClient::processBuffer()
+{
+    // Process all complete messages in the buffer
+    // JSON messages are expected to be newline-terminated, CBOR frames are length-prefixed
     while (true) {
-        int newlinePos = m_buffer.indexOf('\n');
+        if (m_receiveEncoding == Encoding::Cbor) {
+            const qsizetype available = m_buffer.size() - m_readOffset;
+            if (available < 4)
+                break;
+            const quint32 length = qFromBigEndian<quint32>(m_buffer.constData() + m_readOffset);
+            if (available - 4 < qsizetype(length))
+                break; // No complete frame yet
+
+            const char* begin = m_buffer.constData() + m_readOffset + 4;
+            m_readOffset += 4 + length;
+            handleCborFrame(QByteArray::fromRawData(begin, length));
+            continue;
+        }
+
+        const qsizetype newlinePos = m_buffer.indexOf('\n', m_readOffset);
         if (newlinePos == -1) {
             break; // No complete message yet
         }
 
-        QByteArray jsonData = m_buffer.left(newlinePos);
-        m_buffer = m_buffer.mid(newlinePos + 1); // Remove processed message (and the newline)
+        // the message is parsed from a view over the buffer, nothing is copied
+        const char* begin = m_buffer.constData() + m_readOffset;
+        const qsizetype length = newlinePos - m_readOffset;
+        m_readOffset = newlinePos + 1; // Skip processed message (and the newline)
 
-        if (jsonData.trimmed().isEmpty()) { // Skip if it was just a newline or whitespace
+        if (isBlank(begin, length)) { // Skip if it was just a newline or whitespace
             continue;
         }
 
+        const QByteArray jsonData = QByteArray::fromRawData(begin, length);
         QJsonParseError parseError;
         QJsonDocument doc = QJsonDocument::fromJson(jsonData, &parseError);
 
@@ -182,9 +628,180 @@ void FsmClient::onReadyRead()
 
         if (doc.isObject()) {
             // qInfo() << "[FSM -> Client] Received:" << doc.object(); // Can be verbose
-            emit messageReceived(doc.object());
+            handleMessage(doc.object());
         } else {
             qWarning() << "[Client] Received JSON is not an object:" << QString::fromUtf8(jsonData);
         }
     }
+
+    // everything consumed, the capacity is kept for the next burst
+    if (m_readOffset == m_buffer.size()) {
+        m_buffer.truncate(0);
+        m_readOffset = 0;
+    }
+}
+
+bool FsmClient::isBlank(const char *data, qsizetype length)
+{
+    for (qsizetype i = 0; i < length; ++i) {
+        if (!std::isspace(static_cast<unsigned char>(data[i])))
+            return false;
+    }
+    return true;
+}
+
+void FsmClient::handleCborFrame(const QByteArray &frame)
+{
+    QCborParserError parseError;
+    const QCborValue value = QCborValue::fromCbor(frame, &parseError);
+    if (parseError.error != QCborError::NoError || !value.isArray()) {
+        qWarning() << "[Client] Failed to parse CBOR frame:" << parseError.errorString();
+        emit fsmError("Received corrupted CBOR data from FSM.");
+        return;
+    }
+
+    const QCborArray array = value.toArray();
+    const QCborValue code = array.at(0);
+    QString type;
+    if (code.isInteger() && code.toInteger() > 0 && code.toInteger() <= kMessageTypeCount)
+        type = QString::fromLatin1(kMessageTypes[code.toInteger() - 1]);
+    else
+        type = code.toString();
+
+    QJsonObject message;
+    message["type"] = type;
+    message["payload"] = array.at(1).toMap().toJsonObject();
+    handleMessage(message);
+}
+
+void FsmClient::handleMessage(const QJsonObject &message)
+{
+    const QString type = message["type"].toString();
+
+    if (type == "FSM_CONNECTED") {
+        // the server offers its encodings, older servers offer none and stay with JSON
+        const QJsonObject payload = message["payload"].toObject();
+        if (m_preferredEncoding == Encoding::Cbor && m_sendEncoding == Encoding::Json
+            && payload["encodings"].toArray().contains(QJsonValue("cbor"))
+            && payload["version"].toInt() >= kProtocolVersion) {
+            QJsonObject request;
+            request["type"] = "SET_ENCODING";
+            request["payload"] = QJsonObject{{"encoding", "cbor"}, {"version", kProtocolVersion}};
+            sendMessage(request);
+            m_sendEncoding = Encoding::Cbor;
+        }
+        // shared memory only for a server on this host, remote runs stay on TCP
+        if (m_preferredTransport == Transport::SharedMemory && !m_shared && !m_transportPending
+            && SharedSegment::isSupported() && isLocalPeer()
+            && payload["transports"].toArray().contains(QJsonValue("shm"))) {
+            QJsonObject request;
+            request["type"] = "SET_TRANSPORT";
+            request["payload"] = QJsonObject{{"transport", "shm"}};
+            sendMessage(request);
+            m_transportPending = true;
+        }
+        // the daemon multiplexes, the runtime of a single automaton does not
+        if (m_multiplexRequested && !m_multiplexing) {
+            if (payload["multiplex"].toBool()) {
+                QJsonObject request;
+                request["type"] = "SET_MULTIPLEX";
+                request["payload"] = QJsonObject{{"window", kMultiplexWindow}};
+                sendMessage(request);
+                m_multiplexing = true;
+                QList<QJsonObject> held;
+                held.swap(m_heldInstanceMessages);
+                for (const QJsonObject &command : std::as_const(held))
+                    sendMessage(command);
+            } else {
+                qWarning() << "[Client] The FSM server does not multiplex automata.";
+                emit fsmError("The FSM server does not multiplex automata, connect to the runtime daemon.");
+                m_heldInstanceMessages.clear();
+                disconnectFromServer(); // the instances end with the connection
+            }
+        }
+    } else if (type == "MULTIPLEX_SET") {
+        m_window = qMax(1, message["payload"].toObject()["window"].toInt(kMultiplexWindow));
+        qInfo() << "[Client] Connection multiplexed, window of" << m_window << "messages";
+        return;
+    } else if (type == "BATCH") {
+        handleBatch(message["payload"].toObject());
+        return;
+    } else if (type == "TRANSPORT_SET") {
+        switchTransport(message["payload"].toObject());
+        return;
+    } else if (type == "ENCODING_SET") {
+        // everything after the confirmation is in the new encoding
+        const QString encoding = message["payload"].toObject()["encoding"].toString();
+        m_receiveEncoding = encoding == "cbor" ? Encoding::Cbor : Encoding::Json;
+        if (m_receiveEncoding == Encoding::Json)
+            m_sendEncoding = Encoding::Json;
+        qInfo() << "[Client] Wire encoding switched to" << encoding;
+        return;
+    }
+
+    emit messageReceived(message);
+}
+
+void FsmClient::openInstance(int instance, InstanceHandler handler)
+{
+    m_instances.insert(instance, std::move(handler));
+    m_consumed.remove(instance);
+}
+
+void FsmClient::closeInstance(int instance)
+{
+    if (!m_instances.contains(instance))
+        return;
+
+    if (m_multiplexing && isConnected()) {
+        QJsonObject message;
+        message["type"] = "CLOSE_INSTANCE";
+        message["payload"] = QJsonObject();
+        message["instance"] = instance;
+        sendMessage(message);
+    }
+    m_instances.remove(instance);
+    m_consumed.remove(instance);
+    m_heldInstanceMessages.erase(std::remove_if(m_heldInstanceMessages.begin(), m_heldInstanceMessages.end(),
+                                                [instance](const QJsonObject &message) {
+                                                    return message["instance"].toInt() == instance;
+                                                }),
+                                 m_heldInstanceMessages.end());
+}
+
+void FsmClient::handleBatch(const QJsonObject &payload)
+{
+    // the credit of all instances goes back in one CREDIT, half a window at a time
+    const int threshold = qMax(1, m_window / 2);
+    QJsonArray credits;
+
+    const QJsonArray messages = payload["messages"].toArray();
+    for (const QJsonValue &entry : messages) {
+        const QJsonArray item = entry.toArray();
+        const int instance = item.at(0).toInt(-1);
+        const auto it = m_instances.constFind(instance);
+        if (it == m_instances.constEnd())
+            continue; // closed meanwhile, the daemon has stopped its automaton
+
+        QJsonObject message;
+        message["type"] = typeName(item.at(1));
+        message["payload"] = item.at(2).toObject();
+        const InstanceHandler handler = *it; // the handler may close instances
+        handler(message);
+
+        if (!m_instances.contains(instance))
+            continue;
+        int &consumed = m_consumed[instance];
+        if (++consumed >= threshold) {
+            credits.append(QJsonArray{instance, consumed});
+            consumed = 0;
+        }
+    }
+
+    if (!credits.isEmpty()) {
+        QJsonObject message;
+        message["type"] = "CREDIT";
+        message["payload"] = QJsonObject{{"credits", credits}};
+        sendMessage(message);
+    }
 }
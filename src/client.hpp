@@ -3,8 +3,11 @@
  * @brief Declaration of the FsmClient class for TCP communication with the Python FSM server.
  *
  * The FsmClient class provides methods to connect to the FSM server, send commands,
- * and receive messages using Qt's QTcpSocket. It emits signals for connection events,
- * received messages, and errors.
+ * and receive messages using Qt's QTcpSocket, or a QLocalSocket for a server on the same
+ * host. It emits signals for connection events, received messages, and errors.
+ *
+ * A multiplexed connection to the runtime daemon carries many automata, each an instance
+ * with its own id, handler and flow control, so a few sockets serve thousands of remote runs.
  * 
  * @author Josef Ambruz
  * @date 2025-5-11
@@ -14,10 +17,20 @@
 #define FSMCLIENT_HPP
 
 #include <QObject>
+#include <QIODevice>
+#include <QLocalSocket>
 #include <QTcpSocket>
 #include <QJsonObject>
 #include <QJsonDocument>
+#include <QCborValue>
 #include <QDebug> // For qInfo, qWarning, etc.
+#include <QHash>
+#include <QList>
+
+#include <functional>
+#include <memory>
+
+class SharedSegment;
 
 /**
  * @class FsmClient
@@ -32,10 +45,40 @@ class FsmClient : public QObject
 {
     Q_OBJECT
 public:
+    /**
+     * @brief Encoding of the messages on the wire.
+     *
+     * Json is newline-delimited JSON. Cbor frames are a 4 byte big-endian length and the
+     * CBOR array [type code, payload], see fsm_core/wire.py for the type codes.
+     */
+    enum class Encoding
+    {
+        Json,
+        Cbor
+    };
+
     /**
      * @brief Constructs the FsmClient object.
      * @param parent The parent QObject.
      */
+    /**
+     * @brief Transport of the messages once the connection is up.
+     *
+     * Tcp keeps everything on the socket. SharedMemory moves the messages to the rings
+     * of a segment created by a runtime on the same host, see transport/shared-ring.hpp;
+     * the socket then only carries the doorbell bytes.
+     */
+    enum class Transport
+    {
+        Tcp,
+        SharedMemory
+    };
+
+    /**
+     * @brief Receives the messages of one instance of a multiplexed connection.
+     */
+    using InstanceHandler = std::function<void(const QJsonObject &message)>;
+
     explicit FsmClient(QObject *parent = nullptr);
 
     /**
@@ -50,6 +93,17 @@ public:
      */
     void connectToServer(const QString &host, quint16 port);
 
+    /**
+     * @brief Connects to the endpoint announced by the server.
+     *
+     * `tcp://host:port` (a bare port is on localhost) connects over TCP, `unix:/path`
+     * over the local socket at the path, without the TCP stack and port allocation.
+     *
+     * @param endpoint The endpoint of the READY line.
+     * @return False if the endpoint is invalid or the client is already connected.
+     */
+    bool connectToEndpoint(const QString &endpoint);
+
     /**
      * @brief Checks if the client is currently connected to the server.
      * @return True if connected, false otherwise.
@@ -65,13 +119,126 @@ public:
      * @brief Sends a command to set a variable on the FSM server.
      * @param variableName The name of the variable.
      * @param value The value to set.
+     * @param instance Instance of a multiplexed connection, -1 for the FSM of the connection.
+     */
+    void sendSetVariable(const QString &variableName, const QJsonValue &value, int instance = -1);
+
+    /**
+     * @brief Sends many variable assignments in one SET_VARIABLES message.
+     * @param values Variable names and their new values.
+     * @param instance Instance of a multiplexed connection, -1 for the FSM of the connection.
      */
-    void sendSetVariable(const QString &variableName, const QJsonValue &value);
+    void sendSetVariables(const QJsonObject &values, int instance = -1);
 
     /**
      * @brief Sends a command to stop the FSM on the server.
+     * @param instance Instance of a multiplexed connection, -1 for the FSM of the connection.
+     */
+    void sendStopFsm(int instance = -1);
+
+    /**
+     * @brief Asks the FSM for a STATS message.
+     * @param intervalSeconds A positive value also pushes STATS every that many seconds,
+     *                        0 stops the push, a negative value keeps the current interval.
+     * @param instance Instance of a multiplexed connection, -1 for the FSM of the connection.
      */
-    void sendStopFsm();
+    void sendGetStats(double intervalSeconds = -1, int instance = -1);
+
+    /**
+     * @brief Sends a generated interpret to the runtime daemon, which replaces the running FSM by it.
+     * @param code The Python script, has to define build_fsm().
+     * @param instance Instance of a multiplexed connection, which the daemon creates for
+     *                 its first automaton; -1 for the FSM of the connection.
+     */
+    void sendLoadAutomaton(const QByteArray &code, int instance = -1);
+
+    /**
+     * @brief Replaces functions of the running interpret, which keeps its state and variables.
+     * @param code Python definitions of functions the interpret already has, answered by FUNCTIONS_RELOADED.
+     * @param instance Instance of a multiplexed connection, -1 for the FSM of the connection.
+     */
+    void sendReloadFunctions(const QByteArray &code, int instance = -1);
+
+    /**
+     * @brief Sets the encoding asked for after FSM_CONNECTED, JSON is kept if the server does not offer it.
+     */
+    void setPreferredEncoding(Encoding encoding) { m_preferredEncoding = encoding; }
+
+    /**
+     * @brief Returns the encoding of the messages received from the server.
+     */
+    Encoding encoding() const { return m_receiveEncoding; }
+
+    /**
+     * @brief Sets the transport asked for after FSM_CONNECTED.
+     *
+     * Shared memory is only asked for when the server is on the loopback interface,
+     * offers it and this platform supports it; TCP is kept otherwise.
+     */
+    void setPreferredTransport(Transport transport) { m_preferredTransport = transport; }
+
+    /**
+     * @brief Returns the transport the messages currently go through.
+     */
+    Transport transport() const;
+
+    /**
+     * @brief Asks the daemon to multiplex the connection after FSM_CONNECTED, see fsm_core/mux.py.
+     *
+     * The daemon then runs one automaton per instance and sends their messages in BATCH
+     * frames. Every instance may be a window of messages ahead of the editor; they are
+     * returned by CREDIT once its handler has seen them, so a busy instance waits and the
+     * others go on.
+     */
+    void setMultiplexed(bool multiplexed) { m_multiplexRequested = multiplexed; }
+
+    /**
+     * @brief Checks if SET_MULTIPLEX is sent, the messages of the instances go out.
+     */
+    bool isMultiplexed() const { return m_multiplexing; }
+
+    /**
+     * @brief Opens an instance of a multiplexed connection, its messages go to the handler.
+     *
+     * The commands of the instance may be sent right away, they are held until the
+     * connection is multiplexed. The instances are closed when the connection ends.
+     * @param instance Id of the instance, unique on the connection.
+     */
+    void openInstance(int instance, InstanceHandler handler);
+
+    /**
+     * @brief Stops the automaton of the instance on the daemon and forgets its handler.
+     */
+    void closeInstance(int instance);
+
+    /**
+     * @brief Checks if the instance is open.
+     */
+    bool hasInstance(int instance) const { return m_instances.contains(instance); }
+
+    /**
+     * @brief Appends a message in the encoding, a line of JSON or a length prefixed CBOR frame.
+     *
+     * The runtimes frame their messages the same way, so a test server can use it too.
+     */
+    static void encodeMessage(QByteArray &out, const QJsonObject &message, Encoding encoding);
+
+    /**
+     * @brief Returns the bytes queued by the client and not yet handed to the socket.
+     */
+    qint64 pendingBytes() const { return m_writeQueue.size() - m_writeOffset + m_heldQueue.size(); }
+
+    /**
+     * @brief Checks if the write queue is over its limit, senders should then wait for writeQueueDrained().
+     *
+     * Nothing is dropped when the queue is full, it only grows further.
+     */
+    bool isWriteQueueFull() const { return pendingBytes() >= kMaxWriteQueue; }
+
+    /**
+     * @brief Returns the capacity of the read and write buffers, what they take from the heap.
+     */
+    qint64 bufferBytes() const { return m_buffer.capacity() + m_writeQueue.capacity() + m_heldQueue.capacity(); }
 
 signals:
     /**
@@ -96,6 +263,11 @@ signals:
      */
     void fsmError(const QString &errorMessage);
 
+    /**
+     * @brief Emitted when the write queue was full and has dropped below its limit.
+     */
+    void writeQueueDrained();
+
 private slots:
     /**
      * @brief Slot called when the socket successfully connects.
@@ -113,20 +285,107 @@ private slots:
      */
     void onErrorOccurred(QAbstractSocket::SocketError socketError);
 
+    /**
+     * @brief Slot called when a local socket error occurs.
+     * @param socketError The socket error code.
+     */
+    void onLocalErrorOccurred(QLocalSocket::LocalSocketError socketError);
+
     /**
      * @brief Slot called when data is available to read from the socket.
      */
     void onReadyRead();
 
+    /**
+     * @brief Hands the queued messages to the socket, as much as the socket buffer limit allows.
+     */
+    void flushWriteQueue();
+
+    /**
+     * @brief Reads the ring of the shared memory transport until it is empty, then flags the sleep.
+     */
+    void drainSharedRing();
+
 private:
-    QTcpSocket *m_socket;   ///< The TCP socket for communication.
+    QTcpSocket *m_tcpSocket;                ///< The TCP socket for communication.
+    QLocalSocket *m_localSocket = nullptr;  ///< Created by the first unix: endpoint.
+    QIODevice *m_socket;                    ///< The socket of the current connection, one of the two.
     QByteArray m_buffer;    ///< Buffer for incoming data.
+    qsizetype m_readOffset = 0; ///< Start of the first unprocessed message in m_buffer.
+    Encoding m_preferredEncoding = Encoding::Cbor;  ///< Asked for when the server offers it.
+    Encoding m_sendEncoding = Encoding::Json;       ///< Switched right after SET_ENCODING is sent.
+    Encoding m_receiveEncoding = Encoding::Json;    ///< Switched after the server confirms with ENCODING_SET.
+
+    static constexpr qint64 kMaxSocketBuffer = 256 * 1024;      ///< Bytes handed to the socket and not yet written.
+    static constexpr qint64 kMaxWriteQueue = 16 * 1024 * 1024;  ///< Queue size from which isWriteQueueFull() is true.
+    QByteArray m_writeQueue;           ///< Encoded messages not yet handed to the socket.
+    qsizetype m_writeOffset = 0;       ///< Start of the unwritten part of m_writeQueue.
+    bool m_flushScheduled = false;     ///< flushWriteQueue() is queued for this event loop pass.
+    bool m_queueWasFull = false;       ///< writeQueueDrained() is emitted once the queue is below the limit.
+
+    Transport m_preferredTransport = Transport::SharedMemory;  ///< Asked for when the server offers it.
+    std::unique_ptr<SharedSegment> m_shared;  ///< Mapped segment of the shared memory transport, null on TCP.
+    bool m_transportPending = false;   ///< SET_TRANSPORT is sent, messages wait in m_heldQueue for TRANSPORT_SET.
+    QByteArray m_heldQueue;            ///< Messages queued while the transport is switched.
+
+    static constexpr int kMultiplexWindow = 256;  ///< Messages an instance may send ahead, asked for by SET_MULTIPLEX.
+    bool m_multiplexRequested = false;  ///< SET_MULTIPLEX is sent after FSM_CONNECTED.
+    bool m_multiplexing = false;        ///< SET_MULTIPLEX is sent.
+    int m_window = kMultiplexWindow;    ///< Window of MULTIPLEX_SET.
+    QHash<int, InstanceHandler> m_instances;    ///< Handlers of the open instances.
+    QHash<int, int> m_consumed;                 ///< Messages of an instance handled since its last credit.
+    QList<QJsonObject> m_heldInstanceMessages;  ///< Commands of the instances sent before SET_MULTIPLEX.
 
     /**
      * @brief Sends a JSON message to the server.
      * @param message The JSON object to send.
      */
     void sendMessage(const QJsonObject &message);
+
+    /**
+     * @brief Checks if the current socket is neither connected nor connecting.
+     */
+    bool isUnconnected() const;
+
+    /**
+     * @brief Checks if the server runs on this host, the shared memory transport is only asked for then.
+     */
+    bool isLocalPeer() const;
+
+    /**
+     * @brief Checks if the bytes are whitespace only.
+     */
+    static bool isBlank(const char *data, qsizetype length);
+
+    /**
+     * @brief Negotiates the encoding and emits messageReceived() for the other messages.
+     */
+    void handleMessage(const QJsonObject &message);
+
+    /**
+     * @brief Hands the messages of a BATCH to the handlers of their instances, returns their credit.
+     */
+    void handleBatch(const QJsonObject &payload);
+
+    /**
+     * @brief Decodes one CBOR frame without its length prefix.
+     */
+    void handleCborFrame(const QByteArray &frame);
+
+    /**
+     * @brief Parses the complete messages in m_buffer.
+     */
+    void processBuffer();
+
+    /**
+     * @brief Maps the segment of TRANSPORT_SET and moves the held messages to its ring.
+     */
+    void switchTransport(const QJsonObject &payload);
+
+    /**
+     * @brief Writes the queue to the ring of the shared memory transport, rings the doorbell if needed.
+     */
+    void flushSharedRing();
 };
 
 #endif // FSMCLIENT_HPP
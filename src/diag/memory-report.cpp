@@ -0,0 +1,39 @@
+/**
+ * @file memory-report.cpp
+ * @brief Implementation of the MemoryReport class.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#include "memory-report.hpp"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <utility>
+
+void MemoryReport::add(std::string name, std::size_t objects, std::size_t bytes)
+{
+    m_categories.push_back(MemoryCategory{std::move(name), objects, bytes});
+}
+
+std::size_t MemoryReport::totalBytes() const
+{
+    std::size_t total = 0;
+    for (const MemoryCategory& category : m_categories)
+        total += category.bytes;
+    return total;
+}
+
+std::string MemoryReport::toJson() const
+{
+    QJsonArray categories;
+    for (const MemoryCategory& category : m_categories)
+        categories.append(QJsonObject{{"name", QString::fromStdString(category.name)},
+                                      {"objects", static_cast<qint64>(category.objects)},
+                                      {"bytes", static_cast<qint64>(category.bytes)}});
+    const QJsonObject report{{"total", static_cast<qint64>(totalBytes())}, {"categories", categories}};
+    return QJsonDocument(report).toJson(QJsonDocument::Compact).toStdString();
+}
@@ -0,0 +1,80 @@
+/**
+ * @file memory-report.hpp
+ * @brief Declaration of the MemoryReport class, memory of the editor by subsystem.
+ *
+ * The subsystems add their categories when a report is collected, nothing is counted
+ * while the editor runs. The sizes are estimates from the sizes and capacities of the
+ * containers: a hash map node is taken as its value and two pointers, a string as its
+ * capacity. Data shared between copies (QString, std::shared_ptr) is counted by every
+ * holder, so the total overstates it; the report is meant to compare the categories.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#ifndef MEMORY_REPORT_HPP
+#define MEMORY_REPORT_HPP
+
+#include <QString>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Bytes and objects of one category.
+ */
+struct MemoryCategory
+{
+    std::string name;       ///< "Subsystem: part"
+    std::size_t objects = 0;
+    std::size_t bytes = 0;
+};
+
+/**
+ * @class MemoryReport
+ * @brief The categories of one collection, in the order they were added.
+ */
+class MemoryReport
+{
+public:
+    void add(std::string name, std::size_t objects, std::size_t bytes);
+
+    const std::vector<MemoryCategory>& categories() const { return m_categories; }
+
+    std::size_t totalBytes() const;
+
+    /**
+     * @brief The report as one JSON object, {"total": bytes, "categories": [{name, objects, bytes}]}.
+     */
+    std::string toJson() const;
+
+    /// Heap bytes of a vector.
+    template <typename T>
+    static std::size_t vectorBytes(const std::vector<T>& values) { return values.capacity() * sizeof(T); }
+
+    /// Heap bytes of a std::unordered_map or std::unordered_set, without what the values own.
+    template <typename Hashed>
+    static std::size_t hashedBytes(const Hashed& hashed)
+    {
+        return hashed.bucket_count() * sizeof(void*)
+               + hashed.size() * (sizeof(typename Hashed::value_type) + 2 * sizeof(void*));
+    }
+
+    /// Heap bytes of a string, 0 while it fits the small string buffer.
+    static std::size_t stringBytes(const std::string& text)
+    {
+        return text.capacity() > sizeof(std::string) - 1 ? text.capacity() + 1 : 0;
+    }
+
+    /// Heap bytes of a QString, its header and UTF-16 capacity.
+    static std::size_t stringBytes(const QString& text)
+    {
+        return text.isNull() ? 0 : 2 * sizeof(void*) + static_cast<std::size_t>(text.capacity() + 1) * sizeof(QChar);
+    }
+
+private:
+    std::vector<MemoryCategory> m_categories;
+};
+
+#endif // MEMORY_REPORT_HPP
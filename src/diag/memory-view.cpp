@@ -0,0 +1,103 @@
+/**
+ * @file memory-view.cpp
+ * @brief Implementation of the MemoryView class.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#include "memory-view.hpp"
+
+#include <QApplication>
+#include <QClipboard>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QLocale>
+#include <QPushButton>
+#include <QTableWidget>
+#include <QVBoxLayout>
+
+namespace {
+
+enum Column { Category, Objects, Bytes, ColumnCount };
+
+QTableWidgetItem* textItem(const QString &text)
+{
+    auto *item = new QTableWidgetItem(text);
+    item->setFlags(Qt::ItemIsSelectable | Qt::ItemIsEnabled);
+    return item;
+}
+
+/// The value is kept as a number, the column sorts numerically.
+QTableWidgetItem* numberItem(qulonglong value)
+{
+    auto *item = new QTableWidgetItem();
+    item->setData(Qt::DisplayRole, value);
+    item->setFlags(Qt::ItemIsSelectable | Qt::ItemIsEnabled);
+    item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+    return item;
+}
+
+} // namespace
+
+MemoryView::MemoryView(Collector collect, QWidget *parent)
+    : QWidget(parent)
+    , m_collect(std::move(collect))
+    , m_summary(new QLabel(this))
+    , m_table(new QTableWidget(0, ColumnCount, this))
+{
+    m_table->setHorizontalHeaderLabels({tr("Category"), tr("Objects"), tr("Bytes")});
+    m_table->horizontalHeader()->setSectionResizeMode(Category, QHeaderView::Stretch);
+    m_table->verticalHeader()->hide();
+    m_table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    m_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_table->setSortingEnabled(true);
+    m_table->sortByColumn(Bytes, Qt::DescendingOrder);
+
+    auto *refreshButton = new QPushButton(tr("Refresh"), this);
+    auto *copyButton = new QPushButton(tr("Copy JSON"), this);
+    connect(refreshButton, &QPushButton::clicked, this, &MemoryView::refresh);
+    connect(copyButton, &QPushButton::clicked, this, &MemoryView::copyJson);
+
+    auto *buttons = new QHBoxLayout();
+    buttons->addWidget(m_summary, 1);
+    buttons->addWidget(refreshButton);
+    buttons->addWidget(copyButton);
+
+    auto *layout = new QVBoxLayout(this);
+    layout->addLayout(buttons);
+    layout->addWidget(m_table);
+}
+
+void MemoryView::refresh()
+{
+    m_report = m_collect();
+    const auto &categories = m_report.categories();
+
+    m_summary->setText(tr("%1 in %2 categories, estimated")
+                           .arg(QLocale().formattedDataSize(static_cast<qint64>(m_report.totalBytes())))
+                           .arg(categories.size()));
+
+    // the rows are filled unsorted, the order of the header is applied once at the end
+    m_table->setSortingEnabled(false);
+    m_table->setRowCount(static_cast<int>(categories.size()));
+    for (int row = 0; row < static_cast<int>(categories.size()); ++row) {
+        const MemoryCategory &category = categories[row];
+        m_table->setItem(row, Category, textItem(QString::fromStdString(category.name)));
+        m_table->setItem(row, Objects, numberItem(category.objects));
+        m_table->setItem(row, Bytes, numberItem(category.bytes));
+    }
+    m_table->setSortingEnabled(true);
+}
+
+void MemoryView::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+    refresh();
+}
+
+void MemoryView::copyJson() const
+{
+    QApplication::clipboard()->setText(QString::fromStdString(m_report.toJson()));
+}
@@ -0,0 +1,58 @@
+/**
+ * @file memory-view.hpp
+ * @brief Declaration of the MemoryView class, the diagnostics panel of the memory report.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#ifndef MEMORY_VIEW_HPP
+#define MEMORY_VIEW_HPP
+
+#include <QWidget>
+
+#include <functional>
+
+#include "memory-report.hpp"
+
+class QLabel;
+class QTableWidget;
+
+/**
+ * @class MemoryView
+ * @brief Table of the categories of a MemoryReport, collected when the panel is shown or refreshed.
+ *
+ * The report is collected by the function given to the constructor, the panel does not
+ * know the subsystems. Nothing is collected while the panel is hidden.
+ */
+class MemoryView : public QWidget
+{
+    Q_OBJECT
+public:
+    using Collector = std::function<MemoryReport()>;
+
+    /**
+     * @brief Constructs the MemoryView object.
+     * @param collect Collects a new report, called on the GUI thread.
+     * @param parent The parent widget.
+     */
+    explicit MemoryView(Collector collect, QWidget *parent = nullptr);
+
+    /**
+     * @brief Collects a new report and shows it.
+     */
+    void refresh();
+
+protected:
+    void showEvent(QShowEvent *event) override;
+
+private:
+    void copyJson() const;   ///< Puts MemoryReport::toJson() of the last report on the clipboard.
+
+    Collector m_collect;
+    MemoryReport m_report;   ///< The report shown.
+    QLabel *m_summary;
+    QTableWidget *m_table;
+};
+
+#endif // MEMORY_VIEW_HPP
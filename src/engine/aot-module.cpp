@@ -0,0 +1,187 @@
+/**
+ * @file aot-module.cpp
+ * @brief Implementation of the AotModule class.
+ *
+ * A library is built next to its source under a temporary name and renamed into place,
+ * so an engine of another process never loads a half written library; if two builds of
+ * the same source race, the second rename fails and its library is dropped.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#include "aot-module.hpp"
+#include "cpp-generator.hpp"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QLibrary>
+#include <QProcess>
+#include <QStandardPaths>
+
+#include <mutex>
+#include <unordered_map>
+
+static constexpr int kBuildTimeoutMs = 5 * 60 * 1000;
+static constexpr int kPollMs = 100;                 ///< between two checks of the cancel callback
+static constexpr int kCompilerOutputChars = 4000;   ///< of a failed build, in the error
+
+// 64 bit FNV-1a, continued from `seed`
+static uint64_t fingerprint(const QByteArray& data, uint64_t seed = 14695981039346656037ull)
+{
+    uint64_t h = seed;
+    for (const char c : data) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+static QString cacheDirectory()
+{
+    const QString configured = qEnvironmentVariable("ICP_AOT_CACHE");
+    if (!configured.isEmpty())
+        return configured;
+    const QString cache = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation);
+    return (cache.isEmpty() ? QDir::tempPath() : cache) + "/icp-aot";
+}
+
+static QString librarySuffix()
+{
+#if defined(Q_OS_WIN)
+    return ".dll";
+#elif defined(Q_OS_MACOS)
+    return ".dylib";
+#else
+    return ".so";
+#endif
+}
+
+static bool build(const QString& compiler, const QStringList& flags, const QString& sourcePath,
+                  const QString& libraryPath, std::string* error, const std::function<bool()>& cancelled)
+{
+    const QString temporary = libraryPath + "." + QString::number(QCoreApplication::applicationPid()) + ".tmp";
+
+    QProcess process;
+    process.setProcessChannelMode(QProcess::MergedChannels);
+    process.start(compiler, QStringList(flags) << "-o" << temporary << sourcePath);
+    if (!process.waitForStarted()) {
+        *error = "Cannot start the C++ compiler " + compiler.toStdString() + " (set ICP_AOT_CXX).";
+        return false;
+    }
+    QElapsedTimer elapsed;
+    elapsed.start();
+    while (!process.waitForFinished(kPollMs) && process.state() != QProcess::NotRunning) {
+        const bool stop = cancelled && cancelled();
+        if (!stop && elapsed.elapsed() < kBuildTimeoutMs)
+            continue;
+        process.kill();
+        process.waitForFinished();
+        QFile::remove(temporary);
+        *error = stop ? "The build was cancelled." : "The C++ compiler did not finish in time.";
+        return false;
+    }
+    if (process.exitStatus() != QProcess::NormalExit || process.exitCode() != 0) {
+        QFile::remove(temporary);
+        *error = "The C++ compiler failed:\n" + QString::fromLocal8Bit(process.readAll()).left(kCompilerOutputChars).toStdString();
+        return false;
+    }
+
+    if (!QFile::rename(temporary, libraryPath))
+        QFile::remove(temporary);   // built by someone else meanwhile
+    return true;
+}
+
+std::shared_ptr<AotModule> AotModule::load(const std::string& source, std::string* error,
+                                           const std::function<bool()>& cancelled)
+{
+    // one build of a source at a time, the engines of the process share its library
+    static std::mutex mutex;
+    static std::unordered_map<uint64_t, std::weak_ptr<AotModule>> loaded;
+
+    const QString compiler = qEnvironmentVariableIsEmpty("ICP_AOT_CXX") ? QString("c++") : qEnvironmentVariable("ICP_AOT_CXX");
+    const QStringList flags = {"-std=c++17", "-O2", "-fPIC", "-shared"};
+    const QByteArray bytes = QByteArray::fromStdString(source);
+    const uint64_t hash = fingerprint((compiler + flags.join(' ')).toUtf8(), fingerprint(bytes));
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::weak_ptr<AotModule>& entry = loaded[hash];
+    if (std::shared_ptr<AotModule> module = entry.lock())
+        return module;
+
+    const QString dir = cacheDirectory();
+    const QString base = dir + "/fsm-" + QString::number(hash, 16).rightJustified(16, '0');
+    const QString libraryPath = base + librarySuffix();
+    if (!QFile::exists(libraryPath)) {
+        if (!QDir().mkpath(dir)) {
+            *error = "Cannot create the cache directory " + dir.toStdString() + ".";
+            return nullptr;
+        }
+        // the source stays next to the library, for a look at the generated code
+        QFile file(base + ".cpp");
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(bytes) != bytes.size()) {
+            *error = "Cannot write " + file.fileName().toStdString() + ".";
+            return nullptr;
+        }
+        file.close();
+        if (!build(compiler, flags, file.fileName(), libraryPath, error, cancelled))
+            return nullptr;
+    }
+
+    std::shared_ptr<AotModule> module(new AotModule());
+    module->m_library = std::make_unique<QLibrary>(libraryPath);
+    if (!module->m_library->load()) {
+        *error = "Cannot load " + libraryPath.toStdString() + ": " + module->m_library->errorString().toStdString();
+        return nullptr;
+    }
+    using EntryFunction = const IcpAotModule* (*)();
+    auto function = reinterpret_cast<EntryFunction>(module->m_library->resolve("icp_aot_module"));
+    module->m_entry = function ? function() : nullptr;
+    if (!module->m_entry || module->m_entry->abi != CppGenerator::kAbi || module->m_entry->size != sizeof(IcpAotModule)) {
+        *error = libraryPath.toStdString() + " is not a compiled automaton of this version.";
+        return nullptr;
+    }
+
+    entry = module;
+    return module;
+}
+
+AotModule::AotModule() = default;
+
+AotModule::~AotModule()
+{
+    if (m_library)
+        m_library->unload();
+}
+
+FsmValue AotModule::get(const void* vars, int slot) const
+{
+    IcpAotValue value{};
+    m_entry->get(vars, slot, &value);
+    switch (value.type) {
+    case 1: return value.integer != 0;
+    case 2: return static_cast<int64_t>(value.integer);
+    case 3: return value.real;
+    case 4: return std::string(value.text, value.length);
+    default: return FsmValue();
+    }
+}
+
+bool AotModule::set(void* vars, int slot, const FsmValue& value) const
+{
+    IcpAotValue in{};
+    in.type = static_cast<int32_t>(value.index());
+    switch (value.index()) {
+    case 1: in.integer = std::get<bool>(value); break;
+    case 2: in.integer = std::get<int64_t>(value); break;
+    case 3: in.real = std::get<double>(value); break;
+    case 4:
+        in.text = std::get<std::string>(value).data();
+        in.length = std::get<std::string>(value).size();
+        break;
+    default: break;
+    }
+    return m_entry->set(vars, slot, &in) == 0;
+}
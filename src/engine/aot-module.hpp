@@ -0,0 +1,116 @@
+/**
+ * @file aot-module.hpp
+ * @brief Declaration of the AotModule class, an automaton compiled ahead of time into a shared library.
+ *
+ * CppGenerator writes the automaton as C++, AotModule builds the source with the C++
+ * compiler of the system and loads the library. The libraries are cached by the hash of
+ * their source and the compiler, an automaton that did not change is loaded without a
+ * build, also by the next editor session.
+ *
+ * The cache directory is $ICP_AOT_CACHE, by default icp-aot in the cache directory of
+ * the user; the compiler is $ICP_AOT_CXX, by default c++ (any compiler taking the gcc
+ * options). Only the functions below cross the library boundary, as plain C.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#ifndef AOT_MODULE_HPP
+#define AOT_MODULE_HPP
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "fsm-expression.hpp"
+
+class QLibrary;
+
+extern "C" {
+
+/// A variable value between the engine and the library, the FsmValue alternative in type.
+struct IcpAotValue
+{
+    int32_t type;        ///< 0 None, 1 bool, 2 int, 3 float, 4 str
+    int64_t integer;     ///< bool and int
+    double real;
+    const char* text;    ///< str, valid until the variables change
+    uint64_t length;
+};
+
+/// What the library calls back, given to every call that may print or fail.
+struct IcpAotHost
+{
+    void* context;
+    void (*print)(void* context, const char* text, uint64_t length);
+    char* error;         ///< receives the message of a failed call
+    uint64_t errorSize;
+};
+
+/// The entry points of a library, returned by its icp_aot_module().
+struct IcpAotModule
+{
+    uint32_t abi;        ///< CppGenerator::kAbi of the generator
+    uint32_t size;       ///< sizeof(IcpAotModule)
+    uint32_t stateCount;
+    uint32_t slotCount;
+    void* (*create)();                                                       ///< variables with their initial values
+    void (*destroy)(void* vars);
+    int32_t (*action)(void* vars, int32_t state, const IcpAotHost* host);       ///< 0, -1 on an error
+    int32_t (*select)(const void* vars, int32_t state, const IcpAotHost* host); ///< transition index, -1 none, -2 error
+    void (*get)(const void* vars, int32_t slot, IcpAotValue* value);
+    int32_t (*set)(void* vars, int32_t slot, const IcpAotValue* value);         ///< 0, -1 if the type does not fit
+};
+
+}
+
+/**
+ * @class AotModule
+ * @brief A loaded library of a compiled automaton, shared by the engines running the same source.
+ */
+class AotModule
+{
+public:
+    /// The variables of a run, a struct of the library.
+    using Variables = std::unique_ptr<void, void (*)(void*)>;
+
+    /**
+     * @brief Loads the library of the source, builds it first if it is not in the cache.
+     *
+     * Blocks for the build, call it on a worker thread.
+     * @param source The output of CppGenerator::generate().
+     * @param error Receives the reason if null is returned (the compiler output for a failed build).
+     * @param cancelled Polled during the build, the compiler is killed once it returns true.
+     */
+    static std::shared_ptr<AotModule> load(const std::string& source, std::string* error,
+                                           const std::function<bool()>& cancelled = {});
+
+    ~AotModule();
+
+    AotModule(const AotModule&) = delete;
+    AotModule& operator=(const AotModule&) = delete;
+
+    const IcpAotModule& entry() const { return *m_entry; }
+
+    /**
+     * @brief New variables with the initial values of the automaton.
+     */
+    Variables createVariables() const { return Variables(m_entry->create(), m_entry->destroy); }
+
+    FsmValue get(const void* vars, int slot) const;
+
+    /**
+     * @brief Sets a variable, a float takes an int.
+     * @return False if the value has another type than the variable.
+     */
+    bool set(void* vars, int slot, const FsmValue& value) const;
+
+private:
+    AotModule();
+
+    std::unique_ptr<QLibrary> m_library;
+    const IcpAotModule* m_entry = nullptr;
+};
+
+#endif // AOT_MODULE_HPP
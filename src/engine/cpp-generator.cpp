@@ -0,0 +1,677 @@
+/**
+ * @file cpp-generator.cpp
+ * @brief Implementation of the CppGenerator class.
+ *
+ * The helpers of the generated code repeat the evaluator of fsm-expression.cpp for one
+ * pair of types each: the same int wrap around, the same Python floor division and
+ * modulo and the same error messages, so a compiled run prints and fails like an
+ * interpreted one. The types are known, so the type checks of the evaluator become
+ * compile time errors of the generator.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#include "cpp-generator.hpp"
+#include "fsm-expression-tree.hpp"
+#include "fsm-number-ops.hpp"
+#include "../spec_parser/compiled-automaton.hpp"
+#include "../spec_parser/sub-automaton.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <optional>
+#include <sstream>
+
+// The declarations of aot-module.hpp, the generated source includes nothing of the editor
+static const char* const kPrelude = R"CPP(#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cerrno>
+#include <cctype>
+#include <algorithm>
+#include <initializer_list>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+extern "C" {
+
+struct IcpAotValue
+{
+    int32_t type;
+    int64_t integer;
+    double real;
+    const char* text;
+    uint64_t length;
+};
+
+struct IcpAotHost
+{
+    void* context;
+    void (*print)(void* context, const char* text, uint64_t length);
+    char* error;
+    uint64_t errorSize;
+};
+
+struct IcpAotModule
+{
+    uint32_t abi;
+    uint32_t size;
+    uint32_t stateCount;
+    uint32_t slotCount;
+    void* (*create)();
+    void (*destroy)(void* vars);
+    int32_t (*action)(void* vars, int32_t state, const IcpAotHost* host);
+    int32_t (*select)(const void* vars, int32_t state, const IcpAotHost* host);
+    void (*get)(const void* vars, int32_t slot, IcpAotValue* value);
+    int32_t (*set)(void* vars, int32_t slot, const IcpAotValue* value);
+};
+
+}
+
+namespace {
+
+struct Error : std::runtime_error
+{
+    using std::runtime_error::runtime_error;
+};
+
+[[noreturn]] void fail(const std::string& message) { throw Error(message); }
+
+inline bool truthy(bool x) { return x; }
+inline bool truthy(int64_t x) { return x != 0; }
+inline bool truthy(double x) { return x != 0.0; }
+inline bool truthy(const std::string& x) { return !x.empty(); }
+
+// the numbers of the engine: ints wrap around without the undefined behaviour, floats
+// divide and print like Python
+)CPP";
+
+// After the number helpers of fsm-number-ops.hpp
+static const char* const kPreludeTail = R"CPP(
+inline double f_div(double x, double y)
+{
+    if (y == 0.0) fail("division by zero");
+    return x / y;
+}
+
+inline std::string to_str(bool x) { return x ? "True" : "False"; }
+inline std::string to_str(int64_t x) { return std::to_string(x); }
+inline const std::string& to_str(const std::string& x) { return x; }
+
+inline std::string to_str(double x) { return f_to_str(x); }
+
+// parseVariableValue(): 1 bool, 2 int, 3 float, 4 str
+inline int parse_literal(const std::string& text, int64_t& i, double& d)
+{
+    if (text.empty())
+        return 0;
+    std::string lower = text;
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    if (lower == "true" || lower == "false")
+        return 1;
+
+    const char* begin = text.c_str();
+    const char* end = begin + text.size();
+    char* parsed = nullptr;
+    errno = 0;
+    const long long ll = std::strtoll(begin, &parsed, 10);
+    if (parsed == end && errno != ERANGE) {
+        i = ll;
+        return 2;
+    }
+    errno = 0;
+    d = std::strtod(begin, &parsed);
+    if (parsed == end && errno != ERANGE)
+        return 3;
+    return 4;
+}
+
+inline int64_t s_to_int(const std::string& s)
+{
+    int64_t i = 0;
+    double d = 0.0;
+    if (parse_literal(s, i, d) == 2) return i;
+    fail("invalid literal for int(): '" + s + "'");
+}
+
+inline double s_to_float(const std::string& s)
+{
+    int64_t i = 0;
+    double d = 0.0;
+    const int kind = parse_literal(s, i, d);
+    if (kind == 2) return static_cast<double>(i);
+    if (kind == 3) return d;
+    fail("could not convert string to float: '" + s + "'");
+}
+
+template <class T>
+T v_min(std::initializer_list<T> values)
+{
+    auto it = values.begin();
+    T best = *it;
+    for (++it; it != values.end(); ++it)
+        if (*it < best) best = *it;
+    return best;
+}
+
+template <class T>
+T v_max(std::initializer_list<T> values)
+{
+    auto it = values.begin();
+    T best = *it;
+    for (++it; it != values.end(); ++it)
+        if (*it > best) best = *it;
+    return best;
+}
+
+inline void print(const IcpAotHost* host, const std::string& line)
+{
+    if (host && host->print)
+        host->print(host->context, line.data(), line.size());
+}
+
+inline void report(const IcpAotHost* host, const char* message)
+{
+    if (host && host->error && host->errorSize > 0)
+        std::snprintf(host->error, host->errorSize, "%s", message);
+}
+
+)CPP";
+
+// a name in a // comment, a line break or a trailing backslash would end or extend it
+static std::string comment(const std::string& text)
+{
+    std::string out = text;
+    for (char& c : out) {
+        if (c == '\n' || c == '\r') c = ' ';
+        else if (c == '\\') c = '/';
+    }
+    return out;
+}
+
+static std::string field(int slot)
+{
+    return "v.v" + std::to_string(slot);
+}
+
+std::string CppGenerator::generate(const Automaton& source)
+{
+    std::optional<Automaton> expanded;
+    if (!source.getInstances().empty())
+        expanded.emplace(expandSubAutomata(source));
+    return CppGenerator(expanded ? *expanded : source).source();
+}
+
+CppGenerator::CppGenerator(const Automaton& automaton)
+    : m_automaton(automaton)
+{
+    // the slots of FsmEngine::compile(), in declaration order
+    for (const auto& var : automaton.getVariables()) {
+        if (m_slots.count(var.name))
+            continue;
+        m_slots[var.name] = static_cast<int>(m_varNames.size());
+        m_varNames.push_back(var.name);
+        m_initial.push_back(var.parsed);
+        m_types.push_back(static_cast<Type>(var.parsed.index()));
+    }
+}
+
+const char* CppGenerator::typeName(Type type)
+{
+    switch (type) {
+    case Type::None: return "NoneType";
+    case Type::Bool: return "bool";
+    case Type::Int: return "int";
+    case Type::Float: return "float";
+    default: return "str";
+    }
+}
+
+const char* CppGenerator::cppType(Type type)
+{
+    switch (type) {
+    case Type::Bool: return "bool";
+    case Type::Int: return "int64_t";
+    case Type::Float: return "double";
+    default: return "std::string";
+    }
+}
+
+std::string CppGenerator::literal(const FsmValue& value)
+{
+    switch (value.index()) {
+    case 1:
+        return std::get<bool>(value) ? "true" : "false";
+    case 2: {
+        const int64_t i = std::get<int64_t>(value);
+        if (i == INT64_MIN)
+            return "(-INT64_C(9223372036854775807) - 1)";
+        return "INT64_C(" + std::to_string(i) + ")";
+    }
+    case 3: {
+        const double d = std::get<double>(value);
+        if (std::isnan(d))
+            return "std::nan(\"\")";
+        if (std::isinf(d))
+            return d > 0 ? "HUGE_VAL" : "(-HUGE_VAL)";
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.17g", d);
+        std::string text = buffer;
+        if (text.find_first_of(".en") == std::string::npos)
+            text += ".0";
+        return text;
+    }
+    case 4: {
+        // octal escapes, a following digit cannot extend them past three digits
+        const std::string& s = std::get<std::string>(value);
+        std::string text = "std::string(\"";
+        for (unsigned char c : s) {
+            if (c == '"' || c == '\\') {
+                text += '\\';
+                text += static_cast<char>(c);
+            } else if (c >= 0x20 && c < 0x7f && c != '?') {
+                text += static_cast<char>(c);
+            } else {
+                char escape[8];
+                std::snprintf(escape, sizeof(escape), "\\%03o", c);
+                text += escape;
+            }
+        }
+        return text + "\", " + std::to_string(s.size()) + ")";
+    }
+    default:
+        throw ExpressionError("None is not supported by the compiled backend");
+    }
+}
+
+static bool isNumericType(int type)
+{
+    return type >= 1 && type <= 3;
+}
+
+// a numeric operand as the C++ type of the operation
+static std::string asInt(const std::string& code, bool isBool)
+{
+    return isBool ? "static_cast<int64_t>(" + code + ")" : code;
+}
+
+static std::string asDouble(const std::string& code, bool isFloat)
+{
+    return isFloat ? code : "static_cast<double>(" + code + ")";
+}
+
+CppGenerator::Code CppGenerator::expression(const ExprNode& node) const
+{
+    switch (node.op) {
+    case ExprOp::Literal:
+        return {static_cast<Type>(node.literal.index()), literal(node.literal)};
+
+    case ExprOp::Variable: {
+        if (node.slot < 0 || node.slot >= static_cast<int>(m_types.size()))
+            throw ExpressionError("The event channels are not supported by the compiled backend");
+        const Type type = m_types[node.slot];
+        if (type == Type::None)
+            throw ExpressionError("Variable '" + node.name + "' is None, the compiled backend needs a typed initial value");
+        return {type, field(node.slot)};
+    }
+
+    case ExprOp::Neg: {
+        const Code operand = expression(*node.args[0]);
+        if (operand.type == Type::Float)
+            return {Type::Float, "(-" + operand.text + ")"};
+        if (operand.type == Type::Str)
+            throw ExpressionError("bad operand type for unary -: 'str'");
+        return {Type::Int, "i_neg(" + asInt(operand.text, operand.type == Type::Bool) + ")"};
+    }
+
+    case ExprOp::Not:
+        return {Type::Bool, "(!" + truth(*node.args[0]) + ")"};
+
+    case ExprOp::And:
+    case ExprOp::Or: {
+        const Code lhs = expression(*node.args[0]);
+        const Code rhs = expression(*node.args[1]);
+        const bool isAnd = node.op == ExprOp::And;
+        if (lhs.type != rhs.type)
+            throw ExpressionError(std::string("The value of '") + (isAnd ? "and" : "or") + "' is a "
+                                  + typeName(lhs.type) + " or a " + typeName(rhs.type)
+                                  + ", the compiled backend needs one type");
+        if (lhs.type == Type::Bool)
+            return {Type::Bool, "(" + lhs.text + (isAnd ? " && " : " || ") + rhs.text + ")"};
+        // Python returns the operand that decides, the right one is evaluated only then
+        const std::string type = cppType(lhs.type);
+        return {lhs.type, "[&]() -> " + type + " { " + type + " l = " + lhs.text + "; return truthy(l) ? "
+                              + (isAnd ? type + "(" + rhs.text + ") : l" : "l : " + type + "(" + rhs.text + ")")
+                              + "; }()"};
+    }
+
+    case ExprOp::Eq:
+    case ExprOp::Ne:
+    case ExprOp::Lt:
+    case ExprOp::Le:
+    case ExprOp::Gt:
+    case ExprOp::Ge:
+        return comparison(node);
+
+    case ExprOp::Call:
+        return call(node);
+
+    default:
+        return arithmetic(node);
+    }
+}
+
+std::string CppGenerator::truth(const ExprNode& node) const
+{
+    // only the truth is needed, the operands of and/or may have different types
+    if (node.op == ExprOp::And || node.op == ExprOp::Or)
+        return "(" + truth(*node.args[0]) + (node.op == ExprOp::And ? " && " : " || ") + truth(*node.args[1]) + ")";
+    if (node.op == ExprOp::Not)
+        return "(!" + truth(*node.args[0]) + ")";
+
+    const Code value = expression(node);
+    if (value.type == Type::Bool)
+        return value.text;
+    return "truthy(" + value.text + ")";
+}
+
+CppGenerator::Code CppGenerator::arithmetic(const ExprNode& node) const
+{
+    const Code a = expression(*node.args[0]);
+    const Code b = expression(*node.args[1]);
+
+    if (node.op == ExprOp::Add && a.type == Type::Str && b.type == Type::Str)
+        return {Type::Str, "(" + a.text + " + " + b.text + ")"};
+
+    const char* sym = node.op == ExprOp::Add ? "+" : node.op == ExprOp::Sub ? "-" : node.op == ExprOp::Mul ? "*"
+                    : node.op == ExprOp::Div ? "/" : node.op == ExprOp::FloorDiv ? "//" : node.op == ExprOp::Mod ? "%" : "**";
+    if (!isNumericType(static_cast<int>(a.type)) || !isNumericType(static_cast<int>(b.type)))
+        throw ExpressionError(std::string("unsupported operand type(s) for ") + sym + ": '"
+                              + typeName(a.type) + "' and '" + typeName(b.type) + "'");
+
+    const bool useDouble = a.type == Type::Float || b.type == Type::Float;
+    const std::string x = useDouble ? asDouble(a.text, a.type == Type::Float) : asInt(a.text, a.type == Type::Bool);
+    const std::string y = useDouble ? asDouble(b.text, b.type == Type::Float) : asInt(b.text, b.type == Type::Bool);
+
+    if (node.op == ExprOp::Div)
+        return {Type::Float, "f_div(" + asDouble(a.text, a.type == Type::Float) + ", " + asDouble(b.text, b.type == Type::Float) + ")"};
+
+    if (node.op == ExprOp::Pow) {
+        if (useDouble)
+            return {Type::Float, "f_pow(" + x + ", " + y + ")"};
+        // an int power is an int for a non-negative exponent only
+        const ExprNode& exponent = *node.args[1];
+        if (exponent.op != ExprOp::Literal)
+            throw ExpressionError("The type of an int '**' depends on the sign of the exponent, "
+                                  "the compiled backend needs a constant exponent");
+        const int64_t e = exponent.literal.index() == 1 ? std::get<bool>(exponent.literal) : std::get<int64_t>(exponent.literal);
+        if (e >= 0)
+            return {Type::Int, "i_pow(" + x + ", " + y + ")"};
+        return {Type::Float, "f_pow(" + asDouble(a.text, false) + ", " + asDouble(b.text, false) + ")"};
+    }
+
+    if (useDouble) {
+        switch (node.op) {
+        case ExprOp::Add: return {Type::Float, "(" + x + " + " + y + ")"};
+        case ExprOp::Sub: return {Type::Float, "(" + x + " - " + y + ")"};
+        case ExprOp::Mul: return {Type::Float, "(" + x + " * " + y + ")"};
+        case ExprOp::FloorDiv: return {Type::Float, "f_floordiv(" + x + ", " + y + ")"};
+        default: return {Type::Float, "f_mod(" + x + ", " + y + ")"};
+        }
+    }
+
+    switch (node.op) {
+    case ExprOp::Add: return {Type::Int, "i_add(" + x + ", " + y + ")"};
+    case ExprOp::Sub: return {Type::Int, "i_sub(" + x + ", " + y + ")"};
+    case ExprOp::Mul: return {Type::Int, "i_mul(" + x + ", " + y + ")"};
+    case ExprOp::FloorDiv: return {Type::Int, "i_floordiv(" + x + ", " + y + ")"};
+    default: return {Type::Int, "i_mod(" + x + ", " + y + ")"};
+    }
+}
+
+CppGenerator::Code CppGenerator::comparison(const ExprNode& node) const
+{
+    const Code a = expression(*node.args[0]);
+    const Code b = expression(*node.args[1]);
+    const char* op = node.op == ExprOp::Eq ? "==" : node.op == ExprOp::Ne ? "!=" : node.op == ExprOp::Lt ? "<"
+                   : node.op == ExprOp::Le ? "<=" : node.op == ExprOp::Gt ? ">" : ">=";
+
+    const bool numeric = isNumericType(static_cast<int>(a.type)) && isNumericType(static_cast<int>(b.type));
+    if (numeric) {
+        const bool useDouble = a.type == Type::Float || b.type == Type::Float;
+        const std::string x = useDouble ? asDouble(a.text, a.type == Type::Float) : asInt(a.text, a.type == Type::Bool);
+        const std::string y = useDouble ? asDouble(b.text, b.type == Type::Float) : asInt(b.text, b.type == Type::Bool);
+        return {Type::Bool, "(" + x + " " + op + " " + y + ")"};
+    }
+    if (a.type == Type::Str && b.type == Type::Str)
+        return {Type::Bool, "(" + a.text + " " + op + " " + b.text + ")"};
+
+    // a str never equals a number, the operands still run for their errors
+    if (node.op == ExprOp::Eq || node.op == ExprOp::Ne)
+        return {Type::Bool, "((void)(" + a.text + "), (void)(" + b.text + "), " + (node.op == ExprOp::Ne ? "true" : "false") + ")"};
+    throw ExpressionError(std::string("'<' not supported between instances of '") + typeName(a.type) + "' and '" + typeName(b.type) + "'");
+}
+
+CppGenerator::Code CppGenerator::call(const ExprNode& node) const
+{
+    const std::string& f = node.name;
+    std::vector<Code> args;
+    for (const auto& arg : node.args)
+        args.push_back(expression(*arg));
+
+    if ((f == "min" || f == "max") && args.size() > 1) {
+        // the result is one of the arguments, with its type
+        std::string list;
+        for (const Code& arg : args) {
+            if (arg.type != args[0].type)
+                throw ExpressionError(f + "() of a " + typeName(args[0].type) + " and a " + typeName(arg.type)
+                                      + ", the compiled backend needs one type");
+            list += (list.empty() ? "" : ", ") + arg.text;
+        }
+        return {args[0].type, std::string(f == "min" ? "v_min" : "v_max") + "<" + cppType(args[0].type) + ">({" + list + "})"};
+    }
+
+    if (args.size() != 1)
+        throw ExpressionError(f + "() takes exactly one argument");
+    const Code& v = args[0];
+
+    if (f == "abs") {
+        if (v.type == Type::Float) return {Type::Float, "std::fabs(" + v.text + ")"};
+        if (v.type != Type::Str) return {Type::Int, "i_abs(" + asInt(v.text, v.type == Type::Bool) + ")"};
+    } else if (f == "int") {
+        if (v.type == Type::Float) return {Type::Int, "static_cast<int64_t>(" + v.text + ")"};
+        if (v.type == Type::Str) return {Type::Int, "s_to_int(" + v.text + ")"};
+        return {Type::Int, asInt(v.text, v.type == Type::Bool)};
+    } else if (f == "float") {
+        if (v.type == Type::Str) return {Type::Float, "s_to_float(" + v.text + ")"};
+        return {Type::Float, asDouble(v.text, v.type == Type::Float)};
+    } else if (f == "str") {
+        return {Type::Str, "to_str(" + v.text + ")"};
+    } else if (f == "len") {
+        if (v.type == Type::Str) return {Type::Int, "static_cast<int64_t>(" + v.text + ".size())"};
+    }
+    throw ExpressionError(f + "() argument of type '" + typeName(v.type) + "' is not supported");
+}
+
+std::string CppGenerator::statements(const FsmAction& action) const
+{
+    std::string out;
+    for (const auto& st : action.m_statements) {
+        if (st.kind == FsmAction::StatementKind::Assign) {
+            const Code value = expression(*st.args[0].m_root);
+            const Type target = m_types[st.slot];
+            if (value.type != target)
+                throw ExpressionError("Assignment to '" + m_varNames[st.slot] + "' changes its type from "
+                                      + typeName(target) + " to " + typeName(value.type)
+                                      + ", the compiled backend needs fixed types");
+            out += "        " + field(st.slot) + " = " + value.text + ";\n";
+        } else if (st.kind == FsmAction::StatementKind::Print) {
+            std::string line;
+            for (const FsmExpression& arg : st.args) {
+                const std::string text = "to_str(" + expression(*arg.m_root).text + ")";
+                line = line.empty() ? "std::string(" + text + ")" : line + " + ' ' + " + text;
+            }
+            out += "        print(host, " + (line.empty() ? std::string("std::string()") : line) + ");\n";
+        } else {
+            throw ExpressionError("The event channels are not supported by the compiled backend");
+        }
+    }
+    return out;
+}
+
+std::string CppGenerator::source() const
+{
+    const CompiledAutomaton compiled = CompiledAutomaton::FromAutomaton(m_automaton);
+    if (compiled.startState() == InvalidStateId)
+        throw ExpressionError("Start state '" + m_automaton.getStartName().str() + "' not found.");
+
+    auto rejectChannels = [](const std::string& code) {
+        const FsmChannelUse use = fsmChannelsUsed(code);
+        const std::vector<std::string>& names = use.sent.empty() ? use.received : use.sent;
+        if (!names.empty())
+            throw ExpressionError("Channel '" + names.front() + "' is not supported by the compiled backend");
+    };
+
+    std::ostringstream out;
+    out << "// Generated from the automaton " << comment(m_automaton.getName()) << " for the compiled backend of\n"
+        << "// the native engine, " << compiled.stateCount() << " states, " << m_varNames.size() << " variables.\n\n"
+        << kPrelude << kFsmNumberOpsSource << "\n" << kPreludeTail;
+
+    // 1) the variables, one typed member per slot
+    out << "struct Vars\n{\n";
+    for (size_t slot = 0; slot < m_varNames.size(); ++slot) {
+        if (m_types[slot] == Type::None)
+            continue;
+        out << "    " << cppType(m_types[slot]) << " v" << slot << " = " << literal(m_initial[slot])
+            << ";   // " << comment(m_varNames[slot]) << "\n";
+    }
+    out << "};\n\n";
+
+    // 2) the actions, a case per state
+    out << "void action(Vars& v, int32_t state, const IcpAotHost* host)\n{\n"
+        << "    (void)v;\n    (void)host;\n    switch (state) {\n";
+    for (StateId id = 0; id < static_cast<StateId>(compiled.stateCount()); ++id) {
+        const std::string& name = compiled.stateName(id);
+        std::string body;
+        try {
+            rejectChannels(compiled.stateAction(id));
+            body = statements(FsmAction::compile(compiled.stateAction(id), m_slots));
+        } catch (const ExpressionError& e) {
+            throw ExpressionError("Action of state '" + name + "': " + e.what());
+        }
+        if (body.empty())
+            continue;
+        out << "    case " << id << ": {   // " << comment(name) << "\n" << body << "        break;\n    }\n";
+    }
+    out << "    default:\n        break;\n    }\n}\n\n";
+
+    // 3) the transition selection, the first enabled one in the automaton order
+    out << "int32_t select(const Vars& v, int32_t state)\n{\n"
+        << "    (void)v;\n    switch (state) {\n";
+    for (StateId id = 0; id < static_cast<StateId>(compiled.stateCount()); ++id) {
+        const uint32_t first = compiled.firstTransition(id);
+        const uint32_t last = compiled.lastTransition(id);
+        if (first == last || compiled.isFinalState(id))
+            continue;
+        out << "    case " << id << ":   // " << comment(compiled.stateName(id)) << "\n";
+        for (uint32_t i = first; i < last; ++i) {
+            const Transition& t = compiled.transition(i);
+            std::string condition;
+            try {
+                rejectChannels(std::string(t.condition));
+                const FsmExpression expression = FsmExpression::compile(std::string(t.condition), m_slots);
+                condition = expression.m_root ? truth(*expression.m_root) : "true";
+            } catch (const ExpressionError& e) {
+                throw ExpressionError("Condition of transition " + t.fromState.str() + " -> " + t.toState.str() + ": " + e.what());
+            }
+            out << "        if (" << condition << ")\n            return " << (i - first) << ";\n";
+        }
+        out << "        return -1;\n";
+    }
+    out << "    default:\n        return -1;\n    }\n}\n\n";
+
+    // 4) the values of the slots for the engine
+    out << "void get(const Vars& v, int32_t slot, IcpAotValue* value)\n{\n"
+        << "    *value = IcpAotValue{};\n    switch (slot) {\n";
+    for (size_t slot = 0; slot < m_varNames.size(); ++slot) {
+        const std::string member = field(static_cast<int>(slot));
+        switch (m_types[slot]) {
+        case Type::None: continue;
+        case Type::Bool: out << "    case " << slot << ": value->type = 1; value->integer = " << member << "; break;\n"; break;
+        case Type::Int: out << "    case " << slot << ": value->type = 2; value->integer = " << member << "; break;\n"; break;
+        case Type::Float: out << "    case " << slot << ": value->type = 3; value->real = " << member << "; break;\n"; break;
+        case Type::Str:
+            out << "    case " << slot << ": value->type = 4; value->text = " << member << ".data(); value->length = "
+                << member << ".size(); break;\n";
+            break;
+        }
+    }
+    out << "    default: break;\n    }\n}\n\n";
+
+    // a float takes an int, a JSON number of the editor is an int if it has no fraction
+    out << "int32_t set(Vars& v, int32_t slot, const IcpAotValue* value)\n{\n"
+        << "    switch (slot) {\n";
+    for (size_t slot = 0; slot < m_varNames.size(); ++slot) {
+        const std::string member = field(static_cast<int>(slot));
+        switch (m_types[slot]) {
+        case Type::None: continue;
+        case Type::Bool:
+            out << "    case " << slot << ": if (value->type != 1) return -1; " << member << " = value->integer != 0; return 0;\n";
+            break;
+        case Type::Int:
+            out << "    case " << slot << ": if (value->type != 2) return -1; " << member << " = value->integer; return 0;\n";
+            break;
+        case Type::Float:
+            out << "    case " << slot << ": if (value->type == 2) " << member << " = static_cast<double>(value->integer); "
+                << "else if (value->type == 3) " << member << " = value->real; else return -1; return 0;\n";
+            break;
+        case Type::Str:
+            out << "    case " << slot << ": if (value->type != 4) return -1; " << member
+                << ".assign(value->text, value->length); return 0;\n";
+            break;
+        }
+    }
+    out << "    default: return -1;\n    }\n}\n\n";
+
+    // 5) the entry points, an error does not cross the library boundary as an exception
+    out << R"CPP(void* create_vars() { return new Vars(); }
+void destroy_vars(void* vars) { delete static_cast<Vars*>(vars); }
+
+int32_t run_action(void* vars, int32_t state, const IcpAotHost* host)
+{
+    try {
+        action(*static_cast<Vars*>(vars), state, host);
+        return 0;
+    } catch (const std::exception& e) {
+        report(host, e.what());
+        return -1;
+    }
+}
+
+int32_t run_select(const void* vars, int32_t state, const IcpAotHost* host)
+{
+    try {
+        return select(*static_cast<const Vars*>(vars), state);
+    } catch (const std::exception& e) {
+        report(host, e.what());
+        return -2;
+    }
+}
+
+void get_value(const void* vars, int32_t slot, IcpAotValue* value) { get(*static_cast<const Vars*>(vars), slot, value); }
+int32_t set_value(void* vars, int32_t slot, const IcpAotValue* value) { return set(*static_cast<Vars*>(vars), slot, value); }
+
+} // namespace
+
+extern "C" const IcpAotModule* icp_aot_module()
+{
+    static const IcpAotModule module = {
+)CPP";
+    out << "        " << kAbi << ", sizeof(IcpAotModule), " << compiled.stateCount() << ", " << m_varNames.size() << ",\n"
+        << "        create_vars, destroy_vars, run_action, run_select, get_value, set_value\n"
+        << "    };\n    return &module;\n}\n";
+    return out.str();
+}
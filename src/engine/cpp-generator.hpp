@@ -0,0 +1,92 @@
+/**
+ * @file cpp-generator.hpp
+ * @brief Declaration of the CppGenerator class, writes an automaton as C++ for the native engine.
+ *
+ * The sibling of InterpretGenerator for the compiled backend of FsmEngine. The actions and
+ * conditions have to be written in the expression language of fsm-expression.hpp; they
+ * are parsed and folded as the engine does and printed as C++ over a struct with one typed
+ * member per variable. A state action and the transition selection of a state are a case
+ * of a switch on the state id, the state ids and variable slots are the ones FsmEngine
+ * compiles the automaton to.
+ *
+ * The generated source is self-contained, it only needs the C++17 standard library, and
+ * exports icp_aot_module() (see aot-module.hpp). It is the same for the same automaton,
+ * so its hash names the cached library.
+ *
+ * A variable keeps the type of its initial value, so the automaton is typed statically:
+ * an assignment of another type, an operation whose result type depends on the values
+ * (min() over an int and a float, `and` of a str and an int outside a condition, an int
+ * power with a variable exponent) or the event channels cannot be compiled.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#ifndef CPP_GENERATOR_HPP
+#define CPP_GENERATOR_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "fsm-expression.hpp"
+#include "../spec_parser/automaton-data.hpp"
+
+struct ExprNode;
+
+/**
+ * @class CppGenerator
+ * @brief Generates the C++ source of the compiled backend from an automaton.
+ */
+class CppGenerator
+{
+public:
+    static constexpr uint32_t kAbi = 1;   ///< Version of the IcpAotModule layout a library is built for.
+
+    /**
+     * @brief Generates the source of the automaton, its sub-automata expanded first.
+     * @throws ExpressionError if an action or condition cannot be compiled to C++.
+     */
+    static std::string generate(const Automaton& automaton);
+
+private:
+    /// The static type of a variable or expression, numbered like the FsmValue alternatives.
+    enum class Type
+    {
+        None = 0,
+        Bool,
+        Int,
+        Float,
+        Str
+    };
+
+    /// A C++ expression and its type.
+    struct Code
+    {
+        Type type;
+        std::string text;
+    };
+
+    explicit CppGenerator(const Automaton& automaton);
+
+    std::string source() const;
+
+    Code expression(const ExprNode& node) const;
+    std::string truth(const ExprNode& node) const;           ///< as a C++ bool, the Python truthiness
+    Code arithmetic(const ExprNode& node) const;
+    Code comparison(const ExprNode& node) const;
+    Code call(const ExprNode& node) const;
+    std::string statements(const FsmAction& action) const;
+
+    static const char* typeName(Type type);
+    static const char* cppType(Type type);
+    static std::string literal(const FsmValue& value);
+
+    const Automaton& m_automaton;
+    FsmSlotMap m_slots;
+    std::vector<std::string> m_varNames;   ///< by slot
+    std::vector<FsmValue> m_initial;       ///< by slot
+    std::vector<Type> m_types;             ///< by slot
+};
+
+#endif // CPP_GENERATOR_HPP
@@ -0,0 +1,99 @@
+/**
+ * @file event-channel.cpp
+ * @brief Implementation of the EventChannel class.
+ *
+ * A cell at position p is free for the sender claiming p when its sequence is p, and
+ * holds the message of p for the receiver when its sequence is p + 1; taking it sets the
+ * sequence to p + kCapacity, the position the cell is reused for.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#include "event-channel.hpp"
+
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+static_assert((EventChannel::kCapacity & (EventChannel::kCapacity - 1)) == 0, "the capacity is a power of two");
+
+EventChannel::EventChannel(std::string name)
+    : m_name(std::move(name))
+    , m_cells(kCapacity)
+{
+    for (size_t i = 0; i < kCapacity; ++i)
+        m_cells[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+std::shared_ptr<EventChannel> EventChannel::open(const std::string& name)
+{
+    // only opening takes the lock, the engines keep their channels for the whole run
+    static std::mutex mutex;
+    static std::unordered_map<std::string, std::weak_ptr<EventChannel>> channels;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::weak_ptr<EventChannel>& entry = channels[name];
+    std::shared_ptr<EventChannel> channel = entry.lock();
+    if (!channel) {
+        channel = std::make_shared<EventChannel>(name);
+        entry = channel;
+    }
+    return channel;
+}
+
+bool EventChannel::send(FsmValue value)
+{
+    size_t position = m_tail.load(std::memory_order_relaxed);
+    Cell* cell;
+    for (;;) {
+        cell = &m_cells[position & (kCapacity - 1)];
+        const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        const intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+        if (difference == 0) {
+            if (m_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                break;
+        } else if (difference < 0) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        } else {
+            position = m_tail.load(std::memory_order_relaxed);
+        }
+    }
+    cell->value = std::move(value);
+    cell->sequence.store(position + 1, std::memory_order_release);
+
+    // the receiver detaches only once no sender is inside messageAvailable()
+    m_notifying.fetch_add(1);
+    if (Receiver* receiver = m_receiver.load())
+        receiver->messageAvailable(*this);
+    m_notifying.fetch_sub(1);
+    return true;
+}
+
+bool EventChannel::receive(FsmValue& value)
+{
+    if (!hasMessage())
+        return false;
+    Cell& cell = m_cells[m_head & (kCapacity - 1)];
+    value = std::move(cell.value);
+    cell.value = FsmValue();
+    cell.sequence.store(m_head + kCapacity, std::memory_order_release);
+    ++m_head;
+    return true;
+}
+
+bool EventChannel::attach(Receiver* receiver)
+{
+    Receiver* expected = nullptr;
+    return m_receiver.compare_exchange_strong(expected, receiver);
+}
+
+void EventChannel::detach(Receiver* receiver)
+{
+    Receiver* expected = receiver;
+    if (!m_receiver.compare_exchange_strong(expected, nullptr))
+        return;
+    while (m_notifying.load() > 0)
+        std::this_thread::yield();
+}
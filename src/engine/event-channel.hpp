@@ -0,0 +1,116 @@
+/**
+ * @file event-channel.hpp
+ * @brief Declaration of the EventChannel class, named message queues between running automata.
+ *
+ * A channel is a bounded multi-producer single-consumer ring of FsmValues. Any number of
+ * engines send to it, one engine receives from it. send() and receive() take no lock: the
+ * cells are claimed by a compare-and-swap on the tail and published by a per cell sequence
+ * number (D. Vyukov's bounded queue), the receiver owns the head. After a send the channel
+ * wakes its receiver directly, so a message goes from the worker thread of one engine to
+ * the worker thread of another without passing through the editor.
+ *
+ * Channels are found by name in a registry of the process; a channel lives while an
+ * engine uses it, the messages of a channel nobody uses any more are dropped with it.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#ifndef EVENT_CHANNEL_HPP
+#define EVENT_CHANNEL_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "fsm-expression.hpp"
+
+/**
+ * @class EventChannel
+ * @brief A named bounded MPSC queue of messages, see the file comment.
+ */
+class EventChannel
+{
+public:
+    static constexpr size_t kCapacity = 1024;   ///< Messages a channel holds, a power of two.
+
+    /**
+     * @brief Woken after every send, on the thread of the sender.
+     *
+     * It should only note that a message is pending and wake its owner.
+     */
+    class Receiver
+    {
+    public:
+        virtual ~Receiver() = default;
+        virtual void messageAvailable(EventChannel& channel) = 0;
+    };
+
+    explicit EventChannel(std::string name);
+
+    EventChannel(const EventChannel&) = delete;
+    EventChannel& operator=(const EventChannel&) = delete;
+
+    /**
+     * @brief The channel of the name, created on first use.
+     */
+    static std::shared_ptr<EventChannel> open(const std::string& name);
+
+    const std::string& name() const { return m_name; }
+
+    /**
+     * @brief Queues a message, from any thread.
+     * @return False if the channel is full, the message is dropped and counted then.
+     */
+    bool send(FsmValue value);
+
+    /**
+     * @brief Takes the oldest message, from the receiver only.
+     * @return False if the channel is empty.
+     */
+    bool receive(FsmValue& value);
+
+    /**
+     * @brief Checks if receive() would take a message, from the receiver only.
+     */
+    bool hasMessage() const
+    {
+        return m_cells[m_head & (kCapacity - 1)].sequence.load(std::memory_order_acquire) == m_head + 1;
+    }
+
+    /**
+     * @brief Makes the receiver the only one of the channel.
+     * @return False if the channel has a receiver already.
+     */
+    bool attach(Receiver* receiver);
+
+    /**
+     * @brief Removes the receiver, no messageAvailable() call is running once it returns.
+     */
+    void detach(Receiver* receiver);
+
+    /**
+     * @brief Messages dropped because the channel was full.
+     */
+    uint64_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    struct Cell
+    {
+        std::atomic<size_t> sequence{0};
+        FsmValue value;
+    };
+
+    std::string m_name;
+    std::vector<Cell> m_cells;
+    alignas(64) std::atomic<size_t> m_tail{0};      ///< next position to claim, by the senders
+    alignas(64) size_t m_head = 0;                  ///< next position to take, by the receiver
+    alignas(64) std::atomic<Receiver*> m_receiver{nullptr};
+    std::atomic<unsigned> m_notifying{0};           ///< senders inside messageAvailable()
+    std::atomic<uint64_t> m_dropped{0};
+};
+
+#endif // EVENT_CHANNEL_HPP
@@ -0,0 +1,229 @@
+/**
+ * @file fsm-batch.cpp
+ * @brief Implementation of the FsmBatch class.
+ *
+ * An instance steps like FsmEngine::run(): run the action of the state, end in a final
+ * state, otherwise take the first enabled transition and add its delay to the
+ * simulated time.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#include "fsm-batch.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <optional>
+#include <thread>
+
+#include "../spec_parser/compiled-automaton.hpp"
+#include "../spec_parser/sub-automaton.hpp"
+
+FsmBatch::FsmBatch(const Automaton& source)
+{
+    // the instances run as the states of their definitions
+    std::optional<Automaton> expanded;
+    if (!source.getInstances().empty())
+        expanded.emplace(expandSubAutomata(source));
+    const Automaton& automaton = expanded ? *expanded : source;
+
+    FsmSlotMap slots;
+    for (const auto& var : automaton.getVariables()) {
+        if (slots.count(var.name))
+            continue;
+        slots[var.name] = static_cast<int>(m_varNames.size());
+        m_varNames.push_back(var.name);
+        m_defaults.push_back(var.parsed);
+    }
+    m_initializers.resize(m_varNames.size());
+
+    const CompiledAutomaton compiled = CompiledAutomaton::FromAutomaton(automaton);
+    m_states.resize(compiled.stateCount());
+    for (StateId id = 0; id < static_cast<StateId>(compiled.stateCount()); ++id) {
+        BatchState& state = m_states[id];
+        state.name = compiled.stateName(id);
+        state.isFinal = compiled.isFinalState(id);
+        try {
+            state.action = FsmAction::compile(compiled.stateAction(id), slots);
+        } catch (const ExpressionError& e) {
+            throw ExpressionError("Action of state '" + state.name + "': " + e.what());
+        }
+
+        for (uint32_t i = compiled.firstTransition(id); i < compiled.lastTransition(id); ++i) {
+            const Transition& t = compiled.transition(i);
+            if (!compiled.isDeclaredState(id) || !compiled.isDeclaredState(compiled.target(i)))
+                throw ExpressionError("Transition " + t.fromState.str() + " -> " + t.toState.str() + " refers to an unknown state");
+            BatchTransition transition;
+            transition.target = compiled.target(i);
+            transition.delay = t.delay;
+            try {
+                transition.condition = FsmExpression::compile(std::string(t.condition), slots);
+            } catch (const ExpressionError& e) {
+                throw ExpressionError("Condition of transition " + t.fromState.str() + " -> " + t.toState.str() + ": " + e.what());
+            }
+            state.transitions.push_back(std::move(transition));
+        }
+    }
+
+    if (compiled.startState() == InvalidStateId)
+        throw ExpressionError("Start state '" + automaton.getStartName().str() + "' not found.");
+    m_startState = compiled.startState();
+}
+
+bool FsmBatch::setInitializer(const std::string& variable, Initializer initializer)
+{
+    auto it = std::find(m_varNames.begin(), m_varNames.end(), variable);
+    if (it == m_varNames.end())
+        return false;
+    m_initializers[it - m_varNames.begin()] = std::move(initializer);
+    return true;
+}
+
+BatchResult FsmBatch::run(uint64_t instances, uint64_t maxSteps, unsigned threads)
+{
+    const auto started = std::chrono::steady_clock::now();
+
+    m_columns.assign(m_varNames.size(), std::vector<FsmValue>());
+    for (auto& column : m_columns)
+        column.resize(instances);
+    m_state.assign(instances, m_startState);
+    m_steps.assign(instances, 0);
+    m_timeMs.assign(instances, 0);
+    m_outcome.assign(instances, BatchOutcome::Running);
+    m_nextChunk = 0;
+    m_cancel = false;
+
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    const uint64_t chunks = (instances + kChunkSize - 1) / kChunkSize;
+    threads = static_cast<unsigned>(std::min<uint64_t>(threads, std::max<uint64_t>(chunks, 1)));
+
+    // chunks are claimed on demand, a worker done early takes over the rest
+    auto worker = [this, instances, maxSteps, chunks]() {
+        for (;;) {
+            const uint64_t chunk = m_nextChunk.fetch_add(1, std::memory_order_relaxed);
+            if (chunk >= chunks || m_cancel)
+                return;
+            const uint64_t first = chunk * kChunkSize;
+            runChunk(first, std::min(first + kChunkSize, instances), maxSteps);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    for (unsigned i = 1; i < threads; ++i)
+        pool.emplace_back(worker);
+    worker();
+    for (auto& thread : pool)
+        thread.join();
+
+    BatchResult result = aggregate(instances);
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    return result;
+}
+
+void FsmBatch::runChunk(uint64_t first, uint64_t last, uint64_t maxSteps)
+{
+    const size_t slotCount = m_varNames.size();
+    std::vector<FsmValue> row(slotCount);
+    std::vector<int> assigned;
+    std::vector<std::string> output;
+
+    for (uint64_t instance = first; instance < last; ++instance) {
+        // the row of the instance lives in the worker until the instance ends
+        for (size_t slot = 0; slot < slotCount; ++slot)
+            row[slot] = m_initializers[slot] ? m_initializers[slot](instance) : m_defaults[slot];
+
+        int32_t state = m_startState;
+        uint64_t steps = 0;
+        int64_t timeMs = 0;
+        BatchOutcome outcome = BatchOutcome::Running;
+
+        try {
+            for (;;) {
+                const BatchState& current = m_states[state];
+                if (!current.action.isEmpty()) {
+                    assigned.clear();
+                    output.clear();
+                    current.action.execute(row, assigned, output);
+                }
+                if (current.isFinal) {
+                    outcome = BatchOutcome::Finished;
+                    break;
+                }
+                if (steps >= maxSteps)
+                    break;
+
+                const BatchTransition* taken = nullptr;
+                for (const BatchTransition& t : current.transitions) {
+                    if (t.condition.test(row)) {
+                        taken = &t;
+                        break;
+                    }
+                }
+                if (!taken) {
+                    outcome = BatchOutcome::Stuck;
+                    break;
+                }
+
+                timeMs += taken->delay;
+                state = taken->target;
+                ++steps;
+            }
+        } catch (const ExpressionError&) {
+            outcome = BatchOutcome::Error;
+        }
+
+        for (size_t slot = 0; slot < slotCount; ++slot)
+            m_columns[slot][instance] = std::move(row[slot]);
+        m_state[instance] = state;
+        m_steps[instance] = static_cast<uint32_t>(std::min<uint64_t>(steps, std::numeric_limits<uint32_t>::max()));
+        m_timeMs[instance] = timeMs;
+        m_outcome[instance] = outcome;
+    }
+}
+
+BatchResult FsmBatch::aggregate(uint64_t instances) const
+{
+    BatchResult result;
+    result.instances = instances;
+    result.finalStates.assign(m_states.size(), 0);
+    for (const BatchState& state : m_states)
+        result.stateNames.push_back(state.name);
+
+    double steps = 0.0, timeMs = 0.0;
+    for (uint64_t i = 0; i < instances; ++i) {
+        ++result.outcomes[static_cast<size_t>(m_outcome[i])];
+        ++result.finalStates[m_state[i]];
+        steps += m_steps[i];
+        timeMs += static_cast<double>(m_timeMs[i]);
+    }
+    if (instances > 0) {
+        result.meanSteps = steps / static_cast<double>(instances);
+        result.meanTimeMs = timeMs / static_cast<double>(instances);
+    }
+
+    // one pass over each column
+    for (size_t slot = 0; slot < m_columns.size(); ++slot) {
+        BatchVariableStats stats;
+        stats.name = m_varNames[slot];
+        double sum = 0.0;
+        for (const FsmValue& value : m_columns[slot]) {
+            double x;
+            if (value.index() == 2) x = static_cast<double>(std::get<int64_t>(value));
+            else if (value.index() == 3) x = std::get<double>(value);
+            else if (value.index() == 1) x = std::get<bool>(value) ? 1.0 : 0.0;
+            else continue;
+            if (stats.numericCount == 0 || x < stats.min) stats.min = x;
+            if (stats.numericCount == 0 || x > stats.max) stats.max = x;
+            sum += x;
+            ++stats.numericCount;
+        }
+        if (stats.numericCount > 0)
+            stats.mean = sum / static_cast<double>(stats.numericCount);
+        result.variables.push_back(std::move(stats));
+    }
+    return result;
+}
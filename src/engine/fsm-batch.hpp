@@ -0,0 +1,150 @@
+/**
+ * @file fsm-batch.hpp
+ * @brief Declaration of the FsmBatch class, runs many instances of one automaton at once.
+ *
+ * A batch is meant for Monte-Carlo style sweeps: the same automaton runs from many
+ * different initial values and only aggregate statistics are of interest. Instances
+ * are independent, so the batch is split into chunks that worker threads claim one
+ * after another; a chunk runs every one of its instances to the end.
+ *
+ * The batch does not emit messages and does not wait: delays only advance the
+ * simulated time of an instance (see FsmEngine::setVirtualTime).
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#ifndef FSM_BATCH_HPP
+#define FSM_BATCH_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "fsm-expression.hpp"
+#include "../spec_parser/automaton-data.hpp"
+
+/**
+ * @brief How an instance of the batch ended.
+ */
+enum class BatchOutcome : uint8_t
+{
+    Running = 0,  ///< hit the step limit
+    Finished,     ///< reached a final state
+    Stuck,        ///< no transition enabled
+    Error         ///< an action or condition failed
+};
+
+/**
+ * @brief Min, max and mean of a numeric variable over the finished batch.
+ */
+struct BatchVariableStats
+{
+    std::string name;
+    uint64_t numericCount = 0;  ///< instances with a numeric final value
+    double min = 0.0;
+    double max = 0.0;
+    double mean = 0.0;
+};
+
+/**
+ * @brief Aggregate result of a batch run.
+ */
+struct BatchResult
+{
+    uint64_t instances = 0;
+    uint64_t outcomes[4] = {};              ///< instance count by BatchOutcome
+    std::vector<uint64_t> finalStates;      ///< instance count by the state it ended in
+    std::vector<std::string> stateNames;    ///< by state id
+    double meanSteps = 0.0;
+    double meanTimeMs = 0.0;                ///< mean simulated time spent in delays
+    std::vector<BatchVariableStats> variables;
+    double seconds = 0.0;                   ///< wall time of the run
+};
+
+/**
+ * @class FsmBatch
+ * @brief Structure-of-arrays batch of automaton instances.
+ *
+ * Every variable is a column with one value per instance, next to the current state,
+ * step count, simulated time and outcome columns. A worker copies the row of an
+ * instance into its registers once, runs it with the compiled bytecode of the engine
+ * and writes the row back.
+ */
+class FsmBatch
+{
+public:
+    /// Initial value of a variable for an instance, given the instance index.
+    using Initializer = std::function<FsmValue(uint64_t instance)>;
+
+    static constexpr uint64_t kChunkSize = 1024;  ///< Instances claimed by a worker at once.
+
+    /**
+     * @brief Compiles the automaton.
+     * @throws ExpressionError if an action or condition cannot be compiled.
+     */
+    explicit FsmBatch(const Automaton& automaton);
+
+    /**
+     * @brief Overrides the initial value of a variable, by default it is the declared one.
+     * @return False if the automaton has no such variable.
+     */
+    bool setInitializer(const std::string& variable, Initializer initializer);
+
+    /**
+     * @brief Runs the instances until they finish or take maxSteps steps.
+     * @param instances Number of instances.
+     * @param maxSteps Transitions taken at most by an instance.
+     * @param threads Worker threads, 0 for one per hardware thread.
+     */
+    BatchResult run(uint64_t instances, uint64_t maxSteps, unsigned threads = 0);
+
+    /**
+     * @brief Stops the running batch, the instances keep the state they reached.
+     */
+    void cancel() { m_cancel = true; }
+
+    // Columns of the last run, indexed by instance
+    const std::vector<int32_t>& stateColumn() const { return m_state; }
+    const std::vector<FsmValue>& variableColumn(size_t slot) const { return m_columns[slot]; }
+    const std::vector<BatchOutcome>& outcomeColumn() const { return m_outcome; }
+
+private:
+    struct BatchTransition
+    {
+        int32_t target = -1;
+        int32_t delay = 0;
+        FsmExpression condition;
+    };
+
+    struct BatchState
+    {
+        std::string name;
+        bool isFinal = false;
+        FsmAction action;
+        std::vector<BatchTransition> transitions;
+    };
+
+    void runChunk(uint64_t first, uint64_t last, uint64_t maxSteps);
+    BatchResult aggregate(uint64_t instances) const;
+
+    std::vector<BatchState> m_states;
+    int32_t m_startState = -1;
+    std::vector<std::string> m_varNames;          ///< by slot
+    std::vector<FsmValue> m_defaults;             ///< declared initial values, by slot
+    std::vector<Initializer> m_initializers;      ///< by slot, empty for the declared value
+
+    // structure of arrays, one entry per instance
+    std::vector<std::vector<FsmValue>> m_columns; ///< by slot
+    std::vector<int32_t> m_state;
+    std::vector<uint32_t> m_steps;
+    std::vector<int64_t> m_timeMs;
+    std::vector<BatchOutcome> m_outcome;
+
+    std::atomic<uint64_t> m_nextChunk{0};
+    std::atomic<bool> m_cancel{false};
+};
+
+#endif // FSM_BATCH_HPP
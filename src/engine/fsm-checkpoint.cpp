@@ -0,0 +1,128 @@
+/**
+ * @file fsm-checkpoint.cpp
+ * @brief Implementation of the FsmCheckpoint encoding.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#include "fsm-checkpoint.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+template<typename T>
+static void append(std::string& out, const T& value)
+{
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template<typename T>
+static bool take(std::string_view& in, T& value)
+{
+    if (in.size() < sizeof(value))
+        return false;
+    std::memcpy(&value, in.data(), sizeof(value));
+    in.remove_prefix(sizeof(value));
+    return true;
+}
+
+std::string FsmCheckpoint::encode() const
+{
+    FsmCheckpointHeader header{};
+    std::memcpy(header.magic, FsmCheckpointMagic, sizeof(header.magic));
+    header.version = FsmCheckpointVersion;
+    header.byteOrder = FsmCheckpointByteOrderMark;
+    header.state = state;
+    header.program = program;
+    header.transition = transition;
+    header.valueCount = static_cast<uint32_t>(values.size());
+    header.remainingMs = remainingMs;
+    header.steps = steps;
+    header.transitions = transitions;
+    header.virtualTimeMs = virtualTimeMs;
+
+    std::string out;
+    out.reserve(sizeof(header) + values.size() * 9);
+    append(out, header);
+    for (const FsmValue& value : values) {
+        out.push_back(static_cast<char>(value.index()));
+        switch (value.index()) {
+        case 1: out.push_back(std::get<bool>(value) ? 1 : 0); break;
+        case 2: append(out, std::get<int64_t>(value)); break;
+        case 3: append(out, std::get<double>(value)); break;
+        case 4: {
+            const std::string& text = std::get<std::string>(value);
+            append(out, static_cast<uint32_t>(text.size()));
+            out += text;
+            break;
+        }
+        default: break;
+        }
+    }
+    return out;
+}
+
+bool FsmCheckpoint::decode(std::string_view data, FsmCheckpoint& checkpoint, std::string* error)
+{
+    FsmCheckpointHeader header;
+    if (!take(data, header) || std::memcmp(header.magic, FsmCheckpointMagic, sizeof(FsmCheckpointMagic)) != 0) {
+        *error = "Not a checkpoint.";
+        return false;
+    }
+    if (header.version != FsmCheckpointVersion || header.byteOrder != FsmCheckpointByteOrderMark) {
+        *error = "The checkpoint is of another version or byte order.";
+        return false;
+    }
+
+    checkpoint.program = header.program;
+    checkpoint.state = header.state;
+    checkpoint.transition = header.transition;
+    checkpoint.remainingMs = header.remainingMs;
+    checkpoint.steps = header.steps;
+    checkpoint.transitions = header.transitions;
+    checkpoint.virtualTimeMs = header.virtualTimeMs;
+    checkpoint.values.clear();
+    // a value takes at least its type byte, a count beyond the data is not reserved
+    checkpoint.values.reserve(std::min<size_t>(header.valueCount, data.size()));
+
+    for (uint32_t i = 0; i < header.valueCount; ++i) {
+        uint8_t type = 0;
+        bool read = take(data, type);
+        int64_t integer = 0;
+        double real = 0;
+        uint32_t length = 0;
+        switch (type) {
+        case 0: checkpoint.values.emplace_back(); break;
+        case 1:
+            read = read && take(data, type);
+            checkpoint.values.emplace_back(type != 0);
+            break;
+        case 2:
+            read = read && take(data, integer);
+            checkpoint.values.emplace_back(integer);
+            break;
+        case 3:
+            read = read && take(data, real);
+            checkpoint.values.emplace_back(real);
+            break;
+        case 4:
+            read = read && take(data, length) && data.size() >= length;
+            if (read) {
+                checkpoint.values.emplace_back(std::string(data.substr(0, length)));
+                data.remove_prefix(length);
+            }
+            break;
+        default: read = false; break;
+        }
+        if (!read) {
+            *error = "The checkpoint is truncated or corrupted.";
+            return false;
+        }
+    }
+    if (!data.empty()) {
+        *error = "The checkpoint is corrupted.";
+        return false;
+    }
+    return true;
+}
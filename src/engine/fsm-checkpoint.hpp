@@ -0,0 +1,76 @@
+/**
+ * @file fsm-checkpoint.hpp
+ * @brief Declaration of FsmCheckpoint, the progress of a native engine run.
+ *
+ * The worker thread of FsmEngine takes a checkpoint between two steps: the state whose
+ * action has run, the variable values, the delayed transition and the time left of a
+ * delay in progress, and the step counters. A run started with it continues there
+ * instead of the start state. The blob is compact, a fixed header followed by the values:
+ *
+ *   header | value | value | ...
+ *
+ * A value is its FsmValue type index in one byte, followed by one byte for a bool, 8 bytes
+ * for an int or a float, a 32 bit length and the bytes for a str and nothing for None.
+ * Integers are stored in the native byte order, the header records it so foreign blobs
+ * are rejected.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#ifndef FSM_CHECKPOINT_HPP
+#define FSM_CHECKPOINT_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "fsm-expression.hpp"
+
+constexpr char FsmCheckpointMagic[4] = {'F', 'S', 'M', 'C'};
+constexpr uint32_t FsmCheckpointVersion = 1;
+constexpr uint32_t FsmCheckpointByteOrderMark = 0x01020304;
+
+struct FsmCheckpointHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t byteOrder;
+    int32_t state;
+    uint64_t program;
+    int32_t transition;
+    uint32_t valueCount;
+    int64_t remainingMs;
+    uint64_t steps;
+    uint64_t transitions;
+    int64_t virtualTimeMs;
+};
+
+static_assert(sizeof(FsmCheckpointHeader) == 64, "FsmCheckpointHeader must stay 64 bytes");
+
+/**
+ * @struct FsmCheckpoint
+ * @brief A decoded checkpoint, the indices are the ones FsmEngine compiles the automaton to.
+ */
+struct FsmCheckpoint
+{
+    uint64_t program = 0;       ///< Hash of the states, transitions and variables the indices refer to.
+    int32_t state = -1;         ///< The state, its action has run.
+    int32_t transition = -1;    ///< Delayed transition of the state, -1 before the transition selection.
+    int64_t remainingMs = 0;    ///< Time left of the delay.
+    uint64_t steps = 0;         ///< States entered since the start.
+    uint64_t transitions = 0;   ///< Transitions taken since the start.
+    int64_t virtualTimeMs = 0;  ///< Simulated time of a virtual time run.
+    std::vector<FsmValue> values;  ///< By slot.
+
+    std::string encode() const;
+
+    /**
+     * @brief Reads a blob of encode().
+     * @param error Receives the reason if false is returned.
+     */
+    static bool decode(std::string_view data, FsmCheckpoint& checkpoint, std::string* error);
+};
+
+#endif // FSM_CHECKPOINT_HPP
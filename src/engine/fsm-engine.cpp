@@ -0,0 +1,831 @@
+/**
+ * @file fsm-engine.cpp
+ * @brief Implementation of the FsmEngine class, a native in-process FSM interpreter.
+ *
+ * The main loop mirrors FSM.run() from fsm_core.py: enter a state, run its action, stop
+ * if it is final, otherwise take the first transition whose condition holds. A delayed
+ * transition is re-evaluated when a variable changes during the delay.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#include "fsm-engine.hpp"
+#include "cpp-generator.hpp"
+#include "timer-wheel.hpp"
+#include "../spec_parser/sub-automaton.hpp"
+
+#include <QDebug>
+#include <QJsonArray>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <optional>
+
+using ProfileClock = std::chrono::steady_clock;
+static constexpr auto kProfileInterval = std::chrono::milliseconds(500); ///< between two PROFILE messages
+
+static uint64_t elapsedNs(ProfileClock::time_point since)
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(ProfileClock::now() - since).count());
+}
+
+// 64 bit FNV-1a
+static uint64_t fingerprint(const std::string& data)
+{
+    uint64_t h = 14695981039346656037ull;
+    for (const char c : data) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+// IcpAotHost::print of a compiled action, the context is the output of the step
+static void collectLine(void* context, const char* text, uint64_t length)
+{
+    static_cast<std::vector<std::string>*>(context)->emplace_back(text, static_cast<size_t>(length));
+}
+
+FsmEngine::FsmEngine(QObject *parent)
+    : QObject(parent)
+{
+}
+
+FsmEngine::~FsmEngine()
+{
+    stop();
+}
+
+QJsonValue FsmEngine::toJson(const FsmValue& value)
+{
+    switch (value.index()) {
+    case 1: return QJsonValue(std::get<bool>(value));
+    case 2: return QJsonValue(static_cast<qint64>(std::get<int64_t>(value)));
+    case 3: return QJsonValue(std::get<double>(value));
+    case 4: return QJsonValue(QString::fromStdString(std::get<std::string>(value)));
+    default: return QJsonValue(QJsonValue::Null);
+    }
+}
+
+void FsmEngine::compile(const Automaton& source)
+{
+    // the instances run as the states of their definitions
+    std::optional<Automaton> expanded;
+    if (!source.getInstances().empty())
+        expanded.emplace(expandSubAutomata(source));
+    const Automaton& automaton = expanded ? *expanded : source;
+
+    m_states.clear();
+    m_varNames.clear();
+    m_slots.clear();
+    m_inputs.clear();
+    m_outputs.clear();
+    m_compiledSource.clear();
+    m_compiledError.clear();
+    m_startState = -1;
+
+    // Variables get slots in declaration order
+    std::vector<FsmValue> values;
+    for (const auto& var : automaton.getVariables()) {
+        if (m_slots.count(var.name))
+            continue;
+        m_slots[var.name] = static_cast<int>(values.size());
+        m_varNames.push_back(QString::fromStdString(var.name));
+        values.push_back(var.parsed);
+    }
+
+    // States use the dense ids of the compiled automaton, transitions its CSR rows
+    const CompiledAutomaton compiled = CompiledAutomaton::FromAutomaton(automaton);
+
+    // Channels get their slots after the variables, the names cannot clash with them
+    auto addChannels = [&](const FsmChannelUse& use) {
+        for (const std::string& name : use.received) {
+            const std::string receivedSlot = fsmReceivedSlot(name);
+            if (m_slots.count(receivedSlot))
+                continue;
+            InputChannel input;
+            input.channel = EventChannel::open(name);
+            input.receivedSlot = static_cast<int>(values.size());
+            input.messageSlot = input.receivedSlot + 1;
+            m_slots[receivedSlot] = input.receivedSlot;
+            m_slots[fsmMessageSlot(name)] = input.messageSlot;
+            m_varNames.push_back(QString::fromStdString(receivedSlot));
+            m_varNames.push_back(QString::fromStdString(fsmMessageSlot(name)));
+            values.push_back(false);
+            values.push_back(FsmValue());
+            m_inputs.push_back(std::move(input));
+        }
+        for (const std::string& name : use.sent) {
+            if (m_slots.emplace(fsmSendSlot(name), static_cast<int>(m_outputs.size())).second)
+                m_outputs.push_back({EventChannel::open(name)});
+        }
+    };
+    for (StateId id = 0; id < static_cast<StateId>(compiled.stateCount()); ++id) {
+        addChannels(fsmChannelsUsed(compiled.stateAction(id)));
+        for (uint32_t i = compiled.firstTransition(id); i < compiled.lastTransition(id); ++i)
+            addChannels(fsmChannelsUsed(std::string(compiled.transition(i).condition)));
+    }
+    m_store.reset(std::move(values));
+    m_moduleVersion = m_store.version();
+
+    m_states.resize(compiled.stateCount());
+    for (StateId id = 0; id < static_cast<StateId>(compiled.stateCount()); ++id) {
+        const std::string& name = compiled.stateName(id);
+        CompiledState& state = m_states[id];
+        state.name = QString::fromStdString(name);
+        state.isFinal = compiled.isFinalState(id);
+        try {
+            state.action = FsmAction::compile(compiled.stateAction(id), m_slots);
+        } catch (const ExpressionError& e) {
+            throw ExpressionError("Action of state '" + name + "': " + e.what());
+        }
+        state.assigned = state.action.assignedSlots();
+
+        state.transitions.reserve(compiled.lastTransition(id) - compiled.firstTransition(id));
+        for (uint32_t i = compiled.firstTransition(id); i < compiled.lastTransition(id); ++i) {
+            const Transition& t = compiled.transition(i);
+            if (!compiled.isDeclaredState(id) || !compiled.isDeclaredState(compiled.target(i)))
+                throw ExpressionError("Transition " + t.fromState.str() + " -> " + t.toState.str() + " refers to an unknown state");
+            CompiledTransition transition;
+            transition.target = compiled.target(i);
+            transition.delay = t.delay;
+            try {
+                transition.condition = FsmExpression::compile(std::string(t.condition), m_slots);
+            } catch (const ExpressionError& e) {
+                throw ExpressionError("Condition of transition " + t.fromState.str() + " -> " + t.toState.str() + ": " + e.what());
+            }
+            for (const std::string& name : fsmChannelsUsed(std::string(t.condition)).received) {
+                const int receivedSlot = m_slots[fsmReceivedSlot(name)];
+                for (size_t input = 0; input < m_inputs.size(); ++input) {
+                    if (m_inputs[input].receivedSlot == receivedSlot)
+                        transition.consumes.push_back(static_cast<int>(input));
+                }
+            }
+            state.transitions.push_back(std::move(transition));
+        }
+    }
+
+    if (compiled.startState() == InvalidStateId)
+        throw ExpressionError("Start state '" + automaton.getStartName().str() + "' not found.");
+    m_startState = compiled.startState();
+
+    // a checkpoint refers to the states, transitions and slots by index, the code may change;
+    // the layout is described by names only, so it is the same in the next run of the editor
+    std::string layout;
+    for (const CompiledState& state : m_states) {
+        layout += state.name.toStdString() + '\n';
+        for (const CompiledTransition& transition : state.transitions)
+            layout += m_states[transition.target].name.toStdString() + ',';
+        layout += '\n';
+    }
+    for (const QString& name : m_varNames)
+        layout += name.toStdString() + '\n';
+    m_program = fingerprint(layout);
+
+    // the interpreted program is the fallback, it is compiled in any case
+    if (m_compiled) {
+        try {
+            m_compiledSource = CppGenerator::generate(automaton);
+        } catch (const ExpressionError& e) {
+            m_compiledError = e.what();
+        }
+    }
+}
+
+bool FsmEngine::start(const Automaton& automaton, const QByteArray& checkpoint)
+{
+    stop();
+
+    try {
+        compile(automaton);
+    } catch (const ExpressionError& e) {
+        qWarning() << "[Engine] Compilation failed:" << e.what();
+        emit fsmError(QString::fromStdString(e.what()));
+        return false;
+    }
+
+    m_resume.reset();
+    if (!checkpoint.isEmpty() && !restore(checkpoint))
+        return false;
+
+    // a channel has one receiver, the first engine started on it
+    for (InputChannel& input : m_inputs) {
+        if (!input.channel->attach(this)) {
+            detachChannels();
+            const QString message = "Channel '" + QString::fromStdString(input.channel->name()) + "' already has a receiver.";
+            qWarning() << "[Engine]" << message;
+            emit fsmError(message);
+            return false;
+        }
+    }
+
+    m_stopRequested = false;
+    m_reevaluate = false;
+    m_messageArrived = false;
+    m_checkpointRequested = false;
+    m_virtualNowMs = m_resume ? m_resume->virtualTimeMs : 0;
+    m_steps = m_resume ? m_resume->steps : 0;
+    m_transitionsTaken = m_resume ? m_resume->transitions : 0;
+    m_running = true;
+    m_thread = std::thread(&FsmEngine::run, this);
+    return true;
+}
+
+void FsmEngine::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopRequested = true;
+    }
+    m_wakeUp.notify_all();
+
+    if (m_thread.joinable())
+        m_thread.join();
+}
+
+void FsmEngine::requestCheckpoint()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_checkpointRequested = true;
+    }
+    m_wakeUp.notify_all();
+}
+
+void FsmEngine::setVariable(const QString &variableName, const QJsonValue &value)
+{
+    auto it = m_slots.find(variableName.toStdString());
+    if (!m_running || it == m_slots.end()) {
+        qWarning() << "[Engine] Cannot set variable" << variableName;
+        return;
+    }
+
+    FsmValue newValue;
+    {
+        const FsmValue& slot = m_store.snapshot()->values[it->second];
+
+        if (value.isBool()) {
+            newValue = value.toBool();
+        } else if (value.isDouble()) {
+            double d = value.toDouble();
+            // keep ints as ints, JSON does not distinguish them
+            if ((slot.index() == 2 || slot.index() == 0) && std::floor(d) == d)
+                newValue = static_cast<int64_t>(d);
+            else
+                newValue = d;
+        } else if (value.isString()) {
+            newValue = value.toString().toStdString();
+        }
+    }
+
+    if (!m_store.set(it->second, newValue))
+        return; // unchanged values are not reported
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_reevaluate = true;
+    }
+    m_wakeUp.notify_all();
+
+    sendVariableUpdate(it->second, newValue);
+}
+
+void FsmEngine::messageAvailable(EventChannel&)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_messageArrived = true;
+    }
+    m_wakeUp.notify_all();
+}
+
+bool FsmEngine::deliverMessages()
+{
+    // most steps find nothing new, the slots are only copied for a delivery
+    bool ready = false;
+    for (const InputChannel& input : m_inputs)
+        ready = ready || (!input.pending && input.channel->hasMessage());
+    if (!ready)
+        return false;
+
+    return m_store.update([this](std::vector<FsmValue>& values) {
+        bool delivered = false;
+        for (InputChannel& input : m_inputs) {
+            FsmValue message;
+            if (input.pending || !input.channel->receive(message))
+                continue;
+            values[input.messageSlot] = std::move(message);
+            values[input.receivedSlot] = true;
+            input.pending = true;
+            delivered = true;
+        }
+        return delivered;
+    });
+}
+
+void FsmEngine::consumeMessages(const CompiledTransition& transition)
+{
+    if (transition.consumes.empty())
+        return;
+    m_store.update([&](std::vector<FsmValue>& values) {
+        bool consumed = false;
+        for (int index : transition.consumes) {
+            InputChannel& input = m_inputs[index];
+            if (!input.pending)
+                continue;
+            values[input.receivedSlot] = false;
+            input.pending = false;
+            consumed = true;
+        }
+        return consumed;
+    });
+}
+
+void FsmEngine::detachChannels()
+{
+    for (InputChannel& input : m_inputs)
+        input.channel->detach(this);
+}
+
+bool FsmEngine::restore(const QByteArray& data)
+{
+    FsmCheckpoint checkpoint;
+    std::string error;
+    if (FsmCheckpoint::decode(std::string_view(data.constData(), static_cast<size_t>(data.size())), checkpoint, &error)) {
+        if (checkpoint.program != m_program || checkpoint.values.size() != m_varNames.size()
+            || checkpoint.state < 0 || checkpoint.state >= static_cast<int>(m_states.size())
+            || checkpoint.transition < -1
+            || checkpoint.transition >= static_cast<int>(m_states[checkpoint.state].transitions.size()))
+            error = "The checkpoint is of another automaton (states, transitions or variables differ).";
+    }
+    if (!error.empty()) {
+        const QString message = "Cannot resume the run: " + QString::fromStdString(error);
+        qWarning() << "[Engine]" << message;
+        emit fsmError(message);
+        return false;
+    }
+
+    // a delivered message stays pending until a transition consumes it
+    for (InputChannel& input : m_inputs)
+        input.pending = checkpoint.values[input.receivedSlot] == FsmValue(true);
+    m_store.reset(checkpoint.values);
+    m_resume = std::move(checkpoint);
+    return true;
+}
+
+AotModule::Variables FsmEngine::loadCompiled()
+{
+    std::string error = m_compiledError;
+    if (!m_compiledSource.empty()) {
+        m_module = AotModule::load(m_compiledSource, &error, [this] {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_stopRequested;
+        });
+    }
+    if (m_module && (m_module->entry().stateCount != m_states.size() || m_module->entry().slotCount != m_varNames.size())) {
+        error = "The library does not match the automaton.";
+        m_module.reset();
+    }
+    if (!m_module) {
+        emit outputReady(QString("[Engine] The automaton runs interpreted: %1").arg(QString::fromStdString(error)));
+        return AotModule::Variables(nullptr, nullptr);
+    }
+    return m_module->createVariables();
+}
+
+void FsmEngine::syncCompiledVariables(void* vars)
+{
+    const VariableStore::SnapshotPtr snapshot = m_store.snapshot();
+    if (snapshot->version == m_moduleVersion)
+        return;
+
+    std::vector<std::pair<int, FsmValue>> refused;
+    for (size_t slot = 0; slot < snapshot->values.size(); ++slot) {
+        const FsmValue& value = snapshot->values[slot];
+        FsmValue current = m_module->get(vars, static_cast<int>(slot));
+        if (value == current || m_module->set(vars, static_cast<int>(slot), value))
+            continue;
+        emit outputReady(QString("[Engine] Variable '%1' keeps its type in a compiled run, the value is refused.")
+                             .arg(m_varNames[slot]));
+        refused.emplace_back(static_cast<int>(slot), std::move(current));
+    }
+    m_moduleVersion = snapshot->version;
+
+    if (refused.empty())
+        return;
+    m_store.update([&](std::vector<FsmValue>& values) {
+        for (const auto& [slot, value] : refused)
+            values[slot] = value;
+        return true;
+    });
+    for (const auto& [slot, value] : refused)
+        sendVariableUpdate(slot, value);
+}
+
+void FsmEngine::send(const char* type, const QJsonObject& payload)
+{
+    QJsonObject message;
+    message["type"] = QString::fromLatin1(type);
+    message["payload"] = payload;
+    emit messageReceived(message);
+}
+
+void FsmEngine::sendCheckpoint(const CompiledState& state, int transition, int64_t remainingMs)
+{
+    FsmCheckpoint checkpoint;
+    checkpoint.program = m_program;
+    checkpoint.state = static_cast<int32_t>(&state - m_states.data());
+    checkpoint.transition = transition;
+    checkpoint.remainingMs = remainingMs;
+    checkpoint.steps = m_steps;
+    checkpoint.transitions = m_transitionsTaken;
+    checkpoint.virtualTimeMs = m_virtualNowMs;
+    checkpoint.values = m_store.snapshot()->values;
+
+    const std::string data = checkpoint.encode();
+    send("CHECKPOINT", QJsonObject{{"state", state.name},
+                                   {"steps", static_cast<qint64>(m_steps)},
+                                   {"data", QString::fromLatin1(QByteArray(data.data(), static_cast<int>(data.size())).toBase64())}});
+}
+
+void FsmEngine::sendVariableUpdate(int slot, const FsmValue& value)
+{
+    send("VARIABLE_UPDATE", QJsonObject{{"name", m_varNames[slot]}, {"value", toJson(value)}});
+}
+
+void FsmEngine::sendProfile()
+{
+    auto ms = [](uint64_t ns) { return static_cast<double>(ns) / 1e6; };
+
+    QJsonArray states;
+    QJsonArray transitions;
+    for (const CompiledState& state : m_states) {
+        states.append(QJsonObject{{"name", state.name},
+                                  {"entries", static_cast<qint64>(state.entries)},
+                                  {"action_ms", ms(state.actionNs)},
+                                  {"delay_ms", ms(state.delayNs)}});
+        for (size_t i = 0; i < state.transitions.size(); ++i) {
+            const CompiledTransition& t = state.transitions[i];
+            transitions.append(QJsonObject{{"from_state", state.name},
+                                           {"to_state", m_states[t.target].name},
+                                           {"priority", static_cast<int>(i)},
+                                           {"evaluations", static_cast<qint64>(t.evaluations)},
+                                           {"successes", static_cast<qint64>(t.successes)},
+                                           {"condition_ms", ms(t.conditionNs)}});
+        }
+    }
+    send("PROFILE", QJsonObject{{"states", states}, {"transitions", transitions}});
+}
+
+void FsmEngine::run()
+{
+    send("FSM_CONNECTED", QJsonObject{{"message", "Running in the native engine."}});
+
+    const bool profiling = m_profiling;
+    ProfileClock::time_point lastProfile = ProfileClock::now();
+
+    // periodic checkpoints are also taken in a long delay or wait, checkpointDue() needs m_mutex
+    const std::chrono::milliseconds checkpointInterval(m_checkpointIntervalMs);
+    ProfileClock::time_point nextCheckpoint = ProfileClock::now() + checkpointInterval;
+    auto checkpointDue = [&] {
+        return m_checkpointRequested || (checkpointInterval.count() > 0 && ProfileClock::now() >= nextCheckpoint);
+    };
+    auto checkpointTaken = [&] {
+        m_checkpointRequested = false;
+        nextCheckpoint = ProfileClock::now() + checkpointInterval;
+    };
+
+    // the build may take a while, stop() ends it
+    bool stoppedByUser = false;
+    AotModule::Variables compiledVars(nullptr, nullptr);
+    if (m_compiled) {
+        compiledVars = loadCompiled();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        stoppedByUser = m_stopRequested;
+    }
+    char compiledError[512] = "";
+
+    // a resumed run continues after the action of its state, in the delay it was in
+    std::optional<FsmCheckpoint> resume = std::move(m_resume);
+    m_resume.reset();
+    int stopTransition = resume ? resume->transition : -1;   // where a stopped run is checkpointed
+    int64_t stopRemainingMs = resume ? resume->remainingMs : 0;
+
+    CompiledState* current = stoppedByUser ? nullptr : &m_states[resume ? resume->state : m_startState];
+    if (current && resume) {
+        send("FSM_STARTED", QJsonObject{{"start_state", current->name}, {"resumed", true}});
+        const VariableStore::SnapshotPtr vars = m_store.snapshot();
+        for (size_t slot = 0; slot < vars->values.size(); ++slot)
+            sendVariableUpdate(static_cast<int>(slot), vars->values[slot]);
+    } else if (current) {
+        send("FSM_STARTED", QJsonObject{{"start_state", current->name}});
+    }
+
+    std::vector<int> assigned;
+    std::vector<std::string> output;
+    std::vector<std::pair<int, FsmValue>> updates;
+    std::vector<FsmSentMessage> sent;
+
+    while (current) {
+        send("CURRENT_STATE", QJsonObject{{"name", current->name}, {"is_finish", current->isFinal}});
+
+        if (profiling) {
+            if (ProfileClock::now() - lastProfile >= kProfileInterval) {
+                sendProfile();
+                lastProfile = ProfileClock::now();
+            }
+            current->entries++;
+        }
+
+        // 1. State action, a resumed run has run it before the checkpoint
+        if (!resume) {
+            m_steps++;
+            assigned.clear();
+            output.clear();
+            updates.clear();
+            sent.clear();
+            const ProfileClock::time_point actionStart = profiling ? ProfileClock::now() : ProfileClock::time_point();
+            if (compiledVars) {
+                // the library runs on its variables, the assigned ones are published after it
+                syncCompiledVariables(compiledVars.get());
+                const IcpAotHost host{&output, collectLine, compiledError, sizeof(compiledError)};
+                if (m_module->entry().action(compiledVars.get(), static_cast<int32_t>(current - m_states.data()), &host) != 0) {
+                    send("FSM_ERROR", QJsonObject{{"message", "Action error in state " + current->name + ": " + compiledError}});
+                    break;
+                }
+                for (int slot : current->assigned)
+                    updates.emplace_back(slot, m_module->get(compiledVars.get(), slot));
+                if (!updates.empty()) {
+                    // the library stays in sync if nobody else published meanwhile
+                    const uint64_t before = m_store.version();
+                    m_store.update([&](std::vector<FsmValue>& values) {
+                        for (const auto& [slot, value] : updates)
+                            values[slot] = value;
+                        return true;
+                    });
+                    if (before == m_moduleVersion && m_store.version() == before + 1)
+                        m_moduleVersion = before + 1;
+                }
+            } else {
+                try {
+                    // the action runs on a copy, published as one new version
+                    m_store.update([&](std::vector<FsmValue>& values) {
+                        current->action.execute(values, assigned, output, &sent);
+                        for (int slot : assigned)
+                            updates.emplace_back(slot, values[slot]);
+                        return !assigned.empty();
+                    });
+                } catch (const ExpressionError& e) {
+                    send("FSM_ERROR", QJsonObject{{"message", "Action error in state " + current->name + ": " + e.what()}});
+                    break;
+                }
+            }
+            if (profiling)
+                current->actionNs += elapsedNs(actionStart);
+
+            for (const auto& line : output)
+                emit outputReady(QString::fromStdString(line));
+            for (const auto& [slot, value] : updates)
+                sendVariableUpdate(slot, value);
+
+            // the receivers are woken by the channels, a full channel drops the message
+            for (auto& [channel, value] : sent) {
+                OutputChannel& output = m_outputs[channel];
+                if (!output.channel->send(std::move(value)) && !output.warned) {
+                    output.warned = true;
+                    emit outputReady(QString("[Engine] Channel '%1' is full, messages are dropped.")
+                                         .arg(QString::fromStdString(output.channel->name())));
+                }
+            }
+            send("STATE_ACTION_EXECUTED", QJsonObject{{"state_name", current->name}});
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_stopRequested) {
+                stoppedByUser = true;
+                break;
+            }
+        }
+
+        if (current->isFinal) {
+            send("FSM_FINISHED", QJsonObject{{"finish_state", current->name}});
+            break;
+        }
+
+        // 2. Transition selection, repeated if a variable changes during a delay
+        CompiledState* next = nullptr;
+        bool failed = false;
+        while (!next && !failed) {
+            const CompiledTransition* taken = nullptr;
+            int delay = -1;   // of the taken transition, the time left of a resumed delay
+            bool checkpoint = false;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_reevaluate = false;
+                m_messageArrived = false;
+                if (m_stopRequested) {
+                    stoppedByUser = true;
+                    break;
+                }
+                checkpoint = !resume && checkpointDue();
+                if (checkpoint)
+                    checkpointTaken();
+            }
+            if (checkpoint)
+                sendCheckpoint(*current, -1, 0);
+            // a message sent after this sets m_messageArrived again
+            deliverMessages();
+
+            if (resume && resume->transition >= 0) {
+                // the transition was taken before the checkpoint, its delay goes on
+                taken = &current->transitions[resume->transition];
+                delay = static_cast<int>(std::clamp<int64_t>(resume->remainingMs, 0, taken->delay));
+            } else if (compiledVars) {
+                // a change published after the sync sets m_reevaluate again
+                syncCompiledVariables(compiledVars.get());
+                const ProfileClock::time_point selectStart = profiling ? ProfileClock::now() : ProfileClock::time_point();
+                const IcpAotHost host{nullptr, nullptr, compiledError, sizeof(compiledError)};
+                const int index = m_module->entry().select(compiledVars.get(), static_cast<int32_t>(current - m_states.data()), &host);
+                if (index == -2) {
+                    failed = true;
+                    send("FSM_ERROR", QJsonObject{{"message", "Condition error for transition from " + current->name + ": " + compiledError}});
+                    break;
+                }
+                if (index >= 0)
+                    taken = &current->transitions[index];
+                if (profiling && !current->transitions.empty()) {
+                    // the first enabled transition is taken, the ones before it were evaluated
+                    const size_t evaluated = index >= 0 ? static_cast<size_t>(index) + 1 : current->transitions.size();
+                    for (size_t i = 0; i < evaluated; ++i)
+                        current->transitions[i].evaluations++;
+                    current->transitions[evaluated - 1].conditionNs += elapsedNs(selectStart);
+                    if (taken)
+                        current->transitions[index].successes++;
+                }
+            } else {
+                // a change published after this snapshot sets m_reevaluate again
+                const VariableStore::SnapshotPtr vars = m_store.snapshot();
+                try {
+                    for (auto& t : current->transitions) {
+                        if (!profiling) {
+                            if (t.condition.test(vars->values)) {
+                                taken = &t;
+                                break;
+                            }
+                            continue;
+                        }
+
+                        t.evaluations++;
+                        const ProfileClock::time_point conditionStart = ProfileClock::now();
+                        const bool holds = t.condition.test(vars->values);
+                        t.conditionNs += elapsedNs(conditionStart);
+                        if (holds) {
+                            t.successes++;
+                            taken = &t;
+                            break;
+                        }
+                    }
+                } catch (const ExpressionError& e) {
+                    failed = true;
+                    send("FSM_ERROR", QJsonObject{{"message", "Condition error for transition from " + current->name + ": " + e.what()}});
+                    break;
+                }
+            }
+
+            resume.reset();
+            stopTransition = -1;
+            stopRemainingMs = 0;
+
+            if (!taken && !m_inputs.empty()) {
+                // waits for a message, a variable change or stop() to enable a transition
+                std::unique_lock<std::mutex> lock(m_mutex);
+                auto woken = [&] { return m_stopRequested || m_reevaluate || m_messageArrived || checkpointDue(); };
+                if (checkpointInterval.count() > 0)
+                    m_wakeUp.wait_until(lock, nextCheckpoint, woken);
+                else
+                    m_wakeUp.wait(lock, woken);
+                continue;
+            }
+            if (!taken) {
+                send("FSM_STUCK", QJsonObject{{"state_name", current->name}});
+                failed = true;
+                break;
+            }
+
+            if (delay < 0)
+                delay = taken->delay;
+            const int transitionIndex = static_cast<int>(taken - current->transitions.data());
+
+            CompiledState& target = m_states[taken->target];
+            send("TRANSITION_TAKEN", QJsonObject{{"from_state", current->name},
+                                                 {"to_state", target.name},
+                                                 {"delay", taken->delay}});
+
+            // 3. Delay, interrupted by stop() or a variable change
+            if (delay > 0) {
+                int64_t remainingMs = delay;
+                std::unique_lock<std::mutex> lock(m_mutex);
+                if (m_virtualTime) {
+                    // the simulated clock jumps to the end of the delay
+                    if (!m_stopRequested && !m_reevaluate) {
+                        m_virtualNowMs += delay;
+                        remainingMs = 0;
+                        if (profiling)
+                            current->delayNs += static_cast<uint64_t>(delay) * 1000000u;
+                    }
+                } else {
+                    const ProfileClock::time_point delayStart = ProfileClock::now();
+                    auto left = [&] {
+                        const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(ProfileClock::now() - delayStart);
+                        return std::max<int64_t>(0, delay - elapsed.count());
+                    };
+                    // the wheel thread ends the delay, the worker sleeps without a deadline
+                    const uint64_t delayId = ++m_delayId;
+                    m_delayExpired = false;
+                    const TimerWheel::TimerId timer = TimerWheel::shared().schedule(
+                        std::chrono::milliseconds(delay), [this, delayId] {
+                            {
+                                std::lock_guard<std::mutex> timerLock(m_mutex);
+                                if (m_delayId != delayId)
+                                    return;
+                                m_delayExpired = true;
+                            }
+                            m_wakeUp.notify_all();
+                        });
+                    auto woken = [&] {
+                        return m_stopRequested || m_reevaluate || m_delayExpired || m_messageArrived || checkpointDue();
+                    };
+                    for (;;) {
+                        if (checkpointInterval.count() > 0)
+                            m_wakeUp.wait_until(lock, nextCheckpoint, woken);
+                        else
+                            m_wakeUp.wait(lock, woken);
+                        if (m_stopRequested || m_reevaluate || m_delayExpired)
+                            break;
+                        if (checkpointDue()) {
+                            // the delay goes on, a run resumed from the checkpoint waits for the rest
+                            checkpointTaken();
+                            lock.unlock();
+                            sendCheckpoint(*current, transitionIndex, left());
+                            lock.lock();
+                            continue;
+                        }
+                        // a message interrupts the delay like a variable change if it is delivered
+                        m_messageArrived = false;
+                        lock.unlock();
+                        const bool delivered = deliverMessages();
+                        lock.lock();
+                        if (delivered) {
+                            m_reevaluate = true;
+                            break;
+                        }
+                    }
+                    // also after the expiry, cancel() returns once the callback is done with this;
+                    // it waits for a running callback, which takes m_mutex
+                    lock.unlock();
+                    TimerWheel::shared().cancel(timer);
+                    lock.lock();
+                    remainingMs = m_delayExpired ? 0 : left();
+                    if (profiling)
+                        current->delayNs += elapsedNs(delayStart);
+                }
+                if (m_stopRequested) {
+                    stoppedByUser = true;
+                    stopTransition = transitionIndex;
+                    stopRemainingMs = remainingMs;
+                    break;
+                }
+                if (m_reevaluate)
+                    continue;
+            }
+
+            consumeMessages(*taken);
+            m_transitionsTaken++;
+            next = &target;
+        }
+
+        if (failed || stoppedByUser)
+            break;
+        current = next;
+    }
+
+    // the totals of the whole run
+    if (profiling)
+        sendProfile();
+
+    // a periodically checkpointed run can be resumed where it was stopped
+    if (stoppedByUser && current && checkpointInterval.count() > 0)
+        sendCheckpoint(*current, stopTransition, stopRemainingMs);
+
+    if (stoppedByUser)
+        send("FSM_STOPPED", QJsonObject{{"message", "FSM was stopped."}});
+
+    // the messages left in the channels wait for the next receiver
+    detachChannels();
+    compiledVars.reset();
+    m_module.reset();
+    m_running = false;
+    emit finished();
+}
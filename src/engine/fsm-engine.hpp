@@ -0,0 +1,350 @@
+/**
+ * @file fsm-engine.hpp
+ * @brief Declaration of the FsmEngine class, a native in-process FSM interpreter.
+ *
+ * FsmEngine is an alternative to the generated Python runtime (fsm_core). It compiles an
+ * Automaton into an index based program and runs it on its own worker thread inside the
+ * editor process. The engine emits the same messages as the Python runtime sends over TCP
+ * (see CommunicationProtocol.md), so the editor can handle both the same way.
+ *
+ * Actions and conditions have to be written in the expression subset supported by
+ * fsm-expression.hpp.
+ *
+ * The engines of the process talk through named event channels (see event-channel.hpp):
+ * an action sends with send("name", value), a transition waits for a message with a
+ * condition on received("name") and message("name"), and taking it consumes the message.
+ * A state none of whose transitions is enabled waits for a message instead of being
+ * stuck while the automaton receives on a channel. One engine receives on a channel, the
+ * messages are handed from worker thread to worker thread.
+ *
+ * With setCompiled(), the automaton is compiled ahead of time instead: CppGenerator writes
+ * it as C++, the worker thread builds it into a shared library (or loads it from the cache,
+ * see aot-module.hpp) and the actions and transition selection run in the library on typed
+ * variables. The variables are still published to the store and reported, a value set
+ * by the editor is copied into the library before the next step. An automaton the
+ * generator rejects or a failed build runs interpreted, the reason is printed.
+ *
+ * A run can be checkpointed: between two steps the worker thread sends a CHECKPOINT message
+ * with the current state, the variables, the delay in progress and the step counters as a
+ * blob of fsm-checkpoint.hpp. A run started with the blob continues from there. The
+ * checkpoints are taken on request and, with an interval, periodically and once more
+ * when the run is stopped; the receiver writes them, the worker only encodes the values.
+ *
+ * With profiling on, the engine counts the entries, the action time and the delay time
+ * of every state and the evaluations, successes and condition time of every transition,
+ * and reports them in PROFILE messages.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#ifndef FSM_ENGINE_HPP
+#define FSM_ENGINE_HPP
+
+#include <QObject>
+#include <QByteArray>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <QString>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "aot-module.hpp"
+#include "event-channel.hpp"
+#include "fsm-checkpoint.hpp"
+#include "fsm-expression.hpp"
+#include "variable-store.hpp"
+#include "../spec_parser/automaton-data.hpp"
+#include "../spec_parser/compiled-automaton.hpp"
+
+/**
+ * @class FsmEngine
+ * @brief Runs an Automaton natively on a worker thread.
+ *
+ * Messages are emitted through messageReceived() from the worker thread, Qt queues them
+ * to receivers living in other threads.
+ */
+class FsmEngine : public QObject, private EventChannel::Receiver
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief Constructs the FsmEngine object.
+     * @param parent The parent QObject.
+     */
+    explicit FsmEngine(QObject *parent = nullptr);
+
+    /**
+     * @brief Destructor, stops the worker thread if it is still running.
+     */
+    ~FsmEngine();
+
+    /**
+     * @brief Compiles the automaton and starts running it on the worker thread.
+     * @param automaton The automaton to run.
+     * @param checkpoint The data of a CHECKPOINT message (same as RESTORE), the run resumes
+     *                   from it instead of the start state if not empty.
+     * @return False if the automaton could not be compiled or the checkpoint is not one of
+     *         its states, transitions and variables (fsmError() is emitted).
+     */
+    bool start(const Automaton& automaton, const QByteArray& checkpoint = QByteArray());
+
+    /**
+     * @brief Requests the running automaton to stop and waits for the worker thread.
+     */
+    void stop();
+
+    /**
+     * @brief Checks if the worker thread is running an automaton.
+     */
+    bool isRunning() const { return m_running; }
+
+    /**
+     * @brief Sets a variable of the running automaton (same as SET_VARIABLE).
+     * @param variableName The name of the variable.
+     * @param value The value to set.
+     */
+    void setVariable(const QString &variableName, const QJsonValue &value);
+
+    /**
+     * @brief Snapshot of the variable values, indexed like variableNames().
+     *
+     * Never blocks the worker thread, the snapshot stays valid while it is held.
+     */
+    VariableStore::SnapshotPtr variables() const { return m_store.snapshot(); }
+
+    /**
+     * @brief Variable names of the compiled automaton, indexed by slot.
+     */
+    const std::vector<QString>& variableNames() const { return m_varNames; }
+
+    /**
+     * @brief Runs the next start() on a virtual clock, delays do not wait.
+     *
+     * A delay advances the simulated clock at once. Stop and variable changes are still
+     * checked at every delay, so the steps are the same as in real time.
+     */
+    void setVirtualTime(bool virtualTime) { m_virtualTime = virtualTime; }
+
+    /**
+     * @brief Simulated time of a virtual time run in milliseconds.
+     */
+    qint64 virtualTimeMs() const { return m_virtualNowMs; }
+
+    /**
+     * @brief Profiles the next start(), sends a PROFILE message periodically and at the end.
+     *
+     * The counters are kept by the worker thread, the messages carry the totals since
+     * the start.
+     */
+    void setProfiling(bool profiling) { m_profiling = profiling; }
+
+    /**
+     * @brief Runs the next start() compiled to C++ in a shared library, see the file comment.
+     *
+     * A profile of a compiled run counts the evaluations of the transitions, the time of
+     * a selection goes to the last transition evaluated.
+     */
+    void setCompiled(bool compiled) { m_compiled = compiled; }
+
+    /**
+     * @brief Asks the worker for a CHECKPOINT message at its next step (same as CHECKPOINT).
+     *
+     * Returns at once, a waiting worker is woken; a delay goes on afterwards.
+     */
+    void requestCheckpoint();
+
+    /**
+     * @brief Checkpoints the next start() every interval and when it is stopped, 0 only on request.
+     */
+    void setCheckpointInterval(int intervalMs) { m_checkpointIntervalMs = intervalMs; }
+
+    /**
+     * @brief Converts an engine value to a JSON value.
+     */
+    static QJsonValue toJson(const FsmValue& value);
+
+signals:
+    /**
+     * @brief Emitted for every runtime event, in the format of CommunicationProtocol.md.
+     * @param message The JSON message ({type, payload}).
+     */
+    void messageReceived(const QJsonObject &message);
+
+    /**
+     * @brief Emitted for every line printed by an action.
+     * @param line The printed line.
+     */
+    void outputReady(const QString &line);
+
+    /**
+     * @brief Emitted when the automaton cannot be compiled.
+     * @param errorMessage The error message.
+     */
+    void fsmError(const QString &errorMessage);
+
+    /**
+     * @brief Emitted when the worker thread has finished running the automaton.
+     */
+    void finished();
+
+private:
+    /// Compiled transition, target is an index into m_states.
+    struct CompiledTransition
+    {
+        int target = -1;
+        int delay = 0;
+        FsmExpression condition;
+        std::vector<int> consumes;  ///< m_inputs whose message taking the transition consumes
+
+        // profile, written by the worker thread only
+        uint64_t evaluations = 0;
+        uint64_t successes = 0;
+        uint64_t conditionNs = 0;
+    };
+
+    /// Compiled state, transitions are kept in the automaton order.
+    struct CompiledState
+    {
+        QString name;
+        bool isFinal = false;
+        FsmAction action;
+        std::vector<int> assigned;  ///< slots written by the action, published after a compiled one
+        std::vector<CompiledTransition> transitions;
+
+        // profile, written by the worker thread only
+        uint64_t entries = 0;
+        uint64_t actionNs = 0;
+        uint64_t delayNs = 0;
+    };
+
+    /**
+     * @brief Builds the compiled program from the automaton.
+     * @throws ExpressionError if an action or condition cannot be compiled.
+     */
+    void compile(const Automaton& automaton);
+
+    /// A channel the automaton receives on.
+    struct InputChannel
+    {
+        std::shared_ptr<EventChannel> channel;
+        int receivedSlot = -1;   ///< received(), true while a delivered message is not consumed
+        int messageSlot = -1;    ///< message(), the last delivered message
+        bool pending = false;    ///< the value of receivedSlot, kept by the worker thread
+    };
+
+    /// A channel the automaton sends to, by the index of send().
+    struct OutputChannel
+    {
+        std::shared_ptr<EventChannel> channel;
+        bool warned = false;     ///< a dropped message has been reported
+    };
+
+    /**
+     * @brief Worker thread main loop.
+     */
+    void run();
+
+    /**
+     * @brief Called by the channels when a message is sent, on the thread of the sender.
+     */
+    void messageAvailable(EventChannel& channel) override;
+
+    /**
+     * @brief Delivers the next message of every input channel whose message has been consumed.
+     * @return True if a message was delivered.
+     */
+    bool deliverMessages();
+
+    /**
+     * @brief Consumes the messages the transition waited for.
+     */
+    void consumeMessages(const CompiledTransition& transition);
+
+    void detachChannels();
+
+    /**
+     * @brief Checks the checkpoint against the compiled program and makes it the start of the run.
+     * @return False if it does not fit (fsmError() is emitted).
+     */
+    bool restore(const QByteArray& data);
+
+    /**
+     * @brief Emits a CHECKPOINT message, on the worker thread between two steps.
+     * @param state The current state, its action has run.
+     * @param transition The delayed transition, -1 before the transition selection.
+     * @param remainingMs The time left of the delay.
+     */
+    void sendCheckpoint(const CompiledState& state, int transition, int64_t remainingMs);
+
+    /**
+     * @brief Builds or loads the library of m_compiledSource, on the worker thread.
+     * @return The variables of the run, null if the automaton is interpreted.
+     */
+    AotModule::Variables loadCompiled();
+
+    /**
+     * @brief Copies the values set by the editor since the last step into the library.
+     *
+     * A value of another type than the variable is refused and the store is set back.
+     */
+    void syncCompiledVariables(void* vars);
+
+    /**
+     * @brief Emits a message with the given type and payload.
+     */
+    void send(const char* type, const QJsonObject& payload = QJsonObject());
+
+    /**
+     * @brief Emits a VARIABLE_UPDATE message for the given slot.
+     */
+    void sendVariableUpdate(int slot, const FsmValue& value);
+
+    /**
+     * @brief Emits a PROFILE message with the counters of all states and transitions.
+     */
+    void sendProfile();
+
+    std::vector<CompiledState> m_states;   ///< States of the compiled program.
+    int m_startState = -1;                 ///< Index of the start state.
+    std::vector<QString> m_varNames;       ///< Variable names, indexed by slot.
+    FsmSlotMap m_slots;                    ///< Variable name to slot map.
+    std::vector<InputChannel> m_inputs;    ///< Channels received on, attached while running.
+    std::vector<OutputChannel> m_outputs;  ///< Channels sent to.
+
+    VariableStore m_store;                 ///< Variable values, read through snapshots.
+    std::mutex m_mutex;                    ///< Guards the flags below.
+    std::condition_variable m_wakeUp;      ///< Wakes the worker during delays.
+    bool m_stopRequested = false;          ///< Set by stop().
+    bool m_reevaluate = false;             ///< Set when a variable changes during a delay.
+    bool m_delayExpired = false;           ///< Set by the TimerWheel callback of the current delay.
+    bool m_messageArrived = false;         ///< Set by messageAvailable().
+    bool m_checkpointRequested = false;    ///< Set by requestCheckpoint().
+    uint64_t m_delayId = 0;                ///< Numbers the delays, a late callback of an old one is ignored.
+
+    std::thread m_thread;                  ///< The worker thread.
+    std::atomic<bool> m_running{false};    ///< True while the worker thread runs.
+    bool m_virtualTime = false;            ///< see setVirtualTime()
+    bool m_profiling = false;              ///< see setProfiling()
+    bool m_compiled = false;               ///< see setCompiled()
+    std::string m_compiledSource;          ///< C++ of the automaton, empty if it cannot be compiled
+    std::string m_compiledError;           ///< why m_compiledSource is empty
+    std::shared_ptr<AotModule> m_module;   ///< Library of a compiled run, used by the worker.
+    uint64_t m_moduleVersion = 0;          ///< Store version the library variables are in sync with.
+    std::atomic<qint64> m_virtualNowMs{0}; ///< Simulated time of the run.
+    int m_checkpointIntervalMs = 0;        ///< see setCheckpointInterval()
+    uint64_t m_program = 0;                ///< FsmCheckpoint::program of the compiled program.
+    std::optional<FsmCheckpoint> m_resume; ///< Where the next run starts, the start state if empty.
+    uint64_t m_steps = 0;                  ///< States entered, kept by the worker thread.
+    uint64_t m_transitionsTaken = 0;       ///< Transitions taken, kept by the worker thread.
+};
+
+#endif // FSM_ENGINE_HPP
@@ -0,0 +1,54 @@
+/**
+ * @file fsm-expression-tree.hpp
+ * @brief The parsed tree of an FsmExpression, shared by the evaluator and the C++ generator.
+ *
+ * A condition or a statement is parsed into ExprNodes and constant folded; the engine
+ * compiles the tree into bytecode (fsm-expression.cpp), CppGenerator prints it as C++.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#ifndef FSM_EXPRESSION_TREE_HPP
+#define FSM_EXPRESSION_TREE_HPP
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "fsm-expression.hpp"
+
+enum class ExprOp
+{
+    Literal,
+    Variable,
+    Neg,
+    Not,
+    Add,
+    Sub,
+    Mul,
+    Div,
+    FloorDiv,
+    Mod,
+    Pow,
+    Eq,
+    Ne,
+    Lt,
+    Le,
+    Gt,
+    Ge,
+    And,
+    Or,
+    Call
+};
+
+struct ExprNode
+{
+    ExprOp op = ExprOp::Literal;
+    FsmValue literal;
+    int slot = -1;
+    std::string name;                              ///< Builtin name for calls.
+    std::vector<std::unique_ptr<ExprNode>> args;   ///< Operands.
+};
+
+#endif // FSM_EXPRESSION_TREE_HPP
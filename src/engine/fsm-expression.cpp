@@ -0,0 +1,1265 @@
+/**
+ * @file fsm-expression.cpp
+ * @brief Implementation of the expression language used by the native FSM engine.
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#include "fsm-expression.hpp"
+#include "fsm-expression-tree.hpp"
+#include "fsm-number-ops.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstdio>
+#include <string>
+
+namespace {
+
+[[noreturn]] void fail(const std::string& message) { throw ExpressionError(message); }
+
+// the same numbers as the compiled backend: ints wrap around, INT64_MIN // -1 included,
+// floats divide and print like Python
+FSM_INT_OPS
+FSM_FLOAT_OPS
+
+} // namespace
+
+/**
+ *    VALUES
+ *  ========================================================================
+ */
+
+FsmValue parseFsmValueLiteral(const std::string& text)
+{
+    return parseVariableValue(text);
+}
+
+bool fsmValueIsTrue(const FsmValue& value)
+{
+    switch (value.index()) {
+    case 0: return false;
+    case 1: return std::get<bool>(value);
+    case 2: return std::get<int64_t>(value) != 0;
+    case 3: return std::get<double>(value) != 0.0;
+    default: return !std::get<std::string>(value).empty();
+    }
+}
+
+std::string fsmValueToString(const FsmValue& value)
+{
+    switch (value.index()) {
+    case 0: return "None";
+    case 1: return std::get<bool>(value) ? "True" : "False";
+    case 2: return std::to_string(std::get<int64_t>(value));
+    case 3: return f_to_str(std::get<double>(value));
+    default: return std::get<std::string>(value);
+    }
+}
+
+namespace {
+
+bool isNumeric(const FsmValue& v) { return v.index() == 1 || v.index() == 2 || v.index() == 3; }
+
+int64_t asInt(const FsmValue& v)
+{
+    if (v.index() == 1) return std::get<bool>(v) ? 1 : 0;
+    return std::get<int64_t>(v);
+}
+
+double asDouble(const FsmValue& v)
+{
+    if (v.index() == 3) return std::get<double>(v);
+    return static_cast<double>(asInt(v));
+}
+
+const char* typeName(const FsmValue& v)
+{
+    switch (v.index()) {
+    case 0: return "NoneType";
+    case 1: return "bool";
+    case 2: return "int";
+    case 3: return "float";
+    default: return "str";
+    }
+}
+
+/**
+ *    TOKENIZER
+ *  ========================================================================
+ */
+
+enum class Tok
+{
+    End,
+    Number,
+    String,
+    Ident,
+    Op,
+    LParen,
+    RParen,
+    Comma,
+    Semicolon,
+    Newline
+};
+
+struct Token
+{
+    Tok kind = Tok::End;
+    std::string text;
+    FsmValue literal;
+};
+
+std::vector<Token> tokenize(const std::string& src)
+{
+    std::vector<Token> tokens;
+    size_t i = 0;
+    const size_t n = src.size();
+
+    while (i < n) {
+        char c = src[i];
+
+        if (c == '#') { // comment until the end of line
+            while (i < n && src[i] != '\n') i++;
+            continue;
+        }
+        if (c == '\n') {
+            tokens.push_back({Tok::Newline, "\n", {}});
+            i++;
+            continue;
+        }
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            i++;
+            continue;
+        }
+
+        if (std::isdigit(static_cast<unsigned char>(c))
+            || (c == '.' && i + 1 < n && std::isdigit(static_cast<unsigned char>(src[i + 1])))) {
+            size_t start = i;
+            bool isFloat = false;
+            while (i < n && std::isdigit(static_cast<unsigned char>(src[i]))) i++;
+            if (i < n && src[i] == '.') {
+                isFloat = true;
+                i++;
+                while (i < n && std::isdigit(static_cast<unsigned char>(src[i]))) i++;
+            }
+            if (i < n && (src[i] == 'e' || src[i] == 'E')) {
+                size_t save = i;
+                i++;
+                if (i < n && (src[i] == '+' || src[i] == '-')) i++;
+                if (i < n && std::isdigit(static_cast<unsigned char>(src[i]))) {
+                    isFloat = true;
+                    while (i < n && std::isdigit(static_cast<unsigned char>(src[i]))) i++;
+                } else {
+                    i = save;
+                }
+            }
+            std::string text = src.substr(start, i - start);
+            Token t{Tok::Number, text, {}};
+            try {
+                if (isFloat)
+                    t.literal = std::stod(text);
+                else
+                    t.literal = static_cast<int64_t>(std::stoll(text));
+            } catch (const std::out_of_range&) {
+                throw ExpressionError("Number literal out of range: " + text);
+            }
+            tokens.push_back(std::move(t));
+            continue;
+        }
+
+        if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
+            size_t start = i;
+            while (i < n && (std::isalnum(static_cast<unsigned char>(src[i])) || src[i] == '_')) i++;
+            tokens.push_back({Tok::Ident, src.substr(start, i - start), {}});
+            continue;
+        }
+
+        if (c == '"' || c == '\'') {
+            char quote = c;
+            std::string value;
+            i++;
+            while (i < n && src[i] != quote) {
+                if (src[i] == '\n')
+                    throw ExpressionError("Unterminated string literal");
+                if (src[i] == '\\' && i + 1 < n) {
+                    char e = src[++i];
+                    switch (e) {
+                    case 'n': value += '\n'; break;
+                    case 't': value += '\t'; break;
+                    default: value += e; break;
+                    }
+                } else {
+                    value += src[i];
+                }
+                i++;
+            }
+            if (i >= n)
+                throw ExpressionError("Unterminated string literal");
+            i++; // closing quote
+            tokens.push_back({Tok::String, value, value});
+            continue;
+        }
+
+        switch (c) {
+        case '(': tokens.push_back({Tok::LParen, "(", {}}); i++; continue;
+        case ')': tokens.push_back({Tok::RParen, ")", {}}); i++; continue;
+        case ',': tokens.push_back({Tok::Comma, ",", {}}); i++; continue;
+        case ';': tokens.push_back({Tok::Semicolon, ";", {}}); i++; continue;
+        default: break;
+        }
+
+        static const char* const ops[] = {"**", "//", "==", "!=", "<=", ">=", "&&", "||",
+                                          "+=", "-=", "*=", "/=", "%=",
+                                          "+", "-", "*", "/", "%", "<", ">", "=", "!"};
+        bool matched = false;
+        for (const char* op : ops) {
+            size_t len = std::char_traits<char>::length(op);
+            if (src.compare(i, len, op) == 0) {
+                tokens.push_back({Tok::Op, op, {}});
+                i += len;
+                matched = true;
+                break;
+            }
+        }
+        if (!matched)
+            throw ExpressionError(std::string("Unexpected character '") + c + "'");
+    }
+
+    tokens.push_back({Tok::End, "", {}});
+    return tokens;
+}
+
+} // namespace
+
+/**
+ *    EXPRESSION TREE
+ *  ========================================================================
+ */
+
+namespace {
+
+std::unique_ptr<ExprNode> makeNode(ExprOp op)
+{
+    auto node = std::make_unique<ExprNode>();
+    node->op = op;
+    return node;
+}
+
+std::unique_ptr<ExprNode> makeBinary(ExprOp op, std::unique_ptr<ExprNode> lhs, std::unique_ptr<ExprNode> rhs)
+{
+    auto node = makeNode(op);
+    node->args.push_back(std::move(lhs));
+    node->args.push_back(std::move(rhs));
+    return node;
+}
+
+std::unique_ptr<ExprNode> cloneNode(const ExprNode& node)
+{
+    auto copy = makeNode(node.op);
+    copy->literal = node.literal;
+    copy->slot = node.slot;
+    copy->name = node.name;
+    for (const auto& a : node.args)
+        copy->args.push_back(cloneNode(*a));
+    return copy;
+}
+
+/**
+ * @brief Recursive descent parser over the token stream.
+ */
+class Parser
+{
+public:
+    Parser(std::vector<Token> tokens, const FsmSlotMap& slots)
+        : m_tokens(std::move(tokens)), m_slots(slots)
+    {}
+
+    const Token& peek(size_t offset = 0) const
+    {
+        size_t idx = std::min(m_pos + offset, m_tokens.size() - 1);
+        return m_tokens[idx];
+    }
+
+    bool atOp(const char* op) const { return peek().kind == Tok::Op && peek().text == op; }
+    bool atWord(const char* word) const { return peek().kind == Tok::Ident && peek().text == word; }
+
+    void skipSeparators()
+    {
+        while (peek().kind == Tok::Newline || peek().kind == Tok::Semicolon) m_pos++;
+    }
+
+    bool atEnd() const { return peek().kind == Tok::End; }
+
+    // the name of a channel, the string literal argument of send(), received() and message()
+    std::string channelName()
+    {
+        const Token& t = peek();
+        if (t.kind != Tok::String)
+            throw ExpressionError("Expected the name of a channel as a string, found '" + t.text + "'");
+        m_pos++;
+        return std::get<std::string>(t.literal);
+    }
+
+    int resolveChannelSlot(const std::string& slotName, const std::string& channel) const
+    {
+        auto it = m_slots.find(slotName);
+        if (it == m_slots.end())
+            throw ExpressionError("Channel '" + channel + "' is only available in the native engine");
+        return it->second;
+    }
+
+    int resolveSlot(const std::string& name) const
+    {
+        auto it = m_slots.find(name);
+        if (it == m_slots.end())
+            throw ExpressionError("Unknown variable '" + name + "'");
+        return it->second;
+    }
+
+    std::unique_ptr<ExprNode> parseExpression() { return parseOr(); }
+
+    std::unique_ptr<ExprNode> parseOr()
+    {
+        auto lhs = parseAnd();
+        while (atWord("or") || atOp("||")) {
+            m_pos++;
+            lhs = makeBinary(ExprOp::Or, std::move(lhs), parseAnd());
+        }
+        return lhs;
+    }
+
+    std::unique_ptr<ExprNode> parseAnd()
+    {
+        auto lhs = parseNot();
+        while (atWord("and") || atOp("&&")) {
+            m_pos++;
+            lhs = makeBinary(ExprOp::And, std::move(lhs), parseNot());
+        }
+        return lhs;
+    }
+
+    std::unique_ptr<ExprNode> parseNot()
+    {
+        if (atWord("not") || atOp("!")) {
+            m_pos++;
+            auto node = makeNode(ExprOp::Not);
+            node->args.push_back(parseNot());
+            return node;
+        }
+        return parseComparison();
+    }
+
+    bool comparisonOp(ExprOp& op) const
+    {
+        if (peek().kind != Tok::Op) return false;
+        const std::string& t = peek().text;
+        if (t == "==") op = ExprOp::Eq;
+        else if (t == "!=") op = ExprOp::Ne;
+        else if (t == "<") op = ExprOp::Lt;
+        else if (t == "<=") op = ExprOp::Le;
+        else if (t == ">") op = ExprOp::Gt;
+        else if (t == ">=") op = ExprOp::Ge;
+        else return false;
+        return true;
+    }
+
+    std::unique_ptr<ExprNode> parseComparison()
+    {
+        auto lhs = parseAdditive();
+        ExprOp op;
+        if (!comparisonOp(op))
+            return lhs;
+
+        // Python style chaining: a < b < c  ==  (a < b) and (b < c)
+        std::unique_ptr<ExprNode> result;
+        while (comparisonOp(op)) {
+            m_pos++;
+            auto rhs = parseAdditive();
+            auto rhsCopy = cloneNode(*rhs);
+            auto cmp = makeBinary(op, std::move(lhs), std::move(rhs));
+            result = result ? makeBinary(ExprOp::And, std::move(result), std::move(cmp)) : std::move(cmp);
+            lhs = std::move(rhsCopy);
+        }
+        return result;
+    }
+
+    std::unique_ptr<ExprNode> parseAdditive()
+    {
+        auto lhs = parseTerm();
+        while (atOp("+") || atOp("-")) {
+            ExprOp op = atOp("+") ? ExprOp::Add : ExprOp::Sub;
+            m_pos++;
+            lhs = makeBinary(op, std::move(lhs), parseTerm());
+        }
+        return lhs;
+    }
+
+    std::unique_ptr<ExprNode> parseTerm()
+    {
+        auto lhs = parseUnary();
+        while (atOp("*") || atOp("/") || atOp("//") || atOp("%")) {
+            ExprOp op = atOp("*") ? ExprOp::Mul : atOp("/") ? ExprOp::Div : atOp("//") ? ExprOp::FloorDiv : ExprOp::Mod;
+            m_pos++;
+            lhs = makeBinary(op, std::move(lhs), parseUnary());
+        }
+        return lhs;
+    }
+
+    std::unique_ptr<ExprNode> parseUnary()
+    {
+        if (atOp("-")) {
+            m_pos++;
+            auto node = makeNode(ExprOp::Neg);
+            node->args.push_back(parseUnary());
+            return node;
+        }
+        if (atOp("+")) {
+            m_pos++;
+            return parseUnary();
+        }
+        return parsePower();
+    }
+
+    std::unique_ptr<ExprNode> parsePower()
+    {
+        auto base = parsePrimary();
+        if (atOp("**")) {
+            m_pos++;
+            return makeBinary(ExprOp::Pow, std::move(base), parseUnary());
+        }
+        return base;
+    }
+
+    std::unique_ptr<ExprNode> parsePrimary()
+    {
+        const Token& t = peek();
+
+        if (t.kind == Tok::Number || t.kind == Tok::String) {
+            auto node = makeNode(ExprOp::Literal);
+            node->literal = t.literal;
+            m_pos++;
+            return node;
+        }
+
+        if (t.kind == Tok::LParen) {
+            m_pos++;
+            auto inner = parseExpression();
+            expect(Tok::RParen, ")");
+            return inner;
+        }
+
+        if (t.kind == Tok::Ident) {
+            std::string name = t.text;
+            m_pos++;
+
+            if (name == "True" || name == "true") return literal(true);
+            if (name == "False" || name == "false") return literal(false);
+            if (name == "None") return literal(std::monostate{});
+
+            if ((name == "received" || name == "message") && peek().kind == Tok::LParen) {
+                m_pos++;
+                const std::string channel = channelName();
+                expect(Tok::RParen, ")");
+                auto node = makeNode(ExprOp::Variable);
+                node->name = name == "received" ? fsmReceivedSlot(channel) : fsmMessageSlot(channel);
+                node->slot = resolveChannelSlot(node->name, channel);
+                return node;
+            }
+
+            if (peek().kind == Tok::LParen) {
+                static const char* const builtins[] = {"abs", "min", "max", "int", "float", "str", "len"};
+                if (std::find_if(std::begin(builtins), std::end(builtins),
+                                 [&](const char* b) { return name == b; }) == std::end(builtins))
+                    throw ExpressionError("Unsupported function '" + name + "'");
+
+                m_pos++;
+                auto node = makeNode(ExprOp::Call);
+                node->name = name;
+                if (peek().kind != Tok::RParen) {
+                    node->args.push_back(parseExpression());
+                    while (peek().kind == Tok::Comma) {
+                        m_pos++;
+                        node->args.push_back(parseExpression());
+                    }
+                }
+                expect(Tok::RParen, ")");
+                return node;
+            }
+
+            auto node = makeNode(ExprOp::Variable);
+            node->slot = resolveSlot(name);
+            node->name = name;
+            return node;
+        }
+
+        if (t.kind == Tok::End || t.kind == Tok::Newline)
+            throw ExpressionError("Unexpected end of expression");
+        throw ExpressionError("Unexpected token '" + t.text + "'");
+    }
+
+    void expect(Tok kind, const char* text)
+    {
+        if (peek().kind != kind)
+            throw ExpressionError(std::string("Expected '") + text + "'");
+        m_pos++;
+    }
+
+    std::vector<Token> m_tokens;
+    size_t m_pos = 0;
+    const FsmSlotMap& m_slots;
+
+private:
+    static std::unique_ptr<ExprNode> literal(FsmValue v)
+    {
+        auto node = makeNode(ExprOp::Literal);
+        node->literal = std::move(v);
+        return node;
+    }
+};
+
+/**
+ *    EVALUATION
+ *  ========================================================================
+ */
+
+FsmValue eval(const ExprNode& node, const std::vector<FsmValue>& vars);
+
+[[noreturn]] void typeError(const char* op, const FsmValue& a, const FsmValue& b)
+{
+    throw ExpressionError(std::string("unsupported operand type(s) for ") + op + ": '"
+                          + typeName(a) + "' and '" + typeName(b) + "'");
+}
+
+FsmValue arithmetic(ExprOp op, const FsmValue& a, const FsmValue& b)
+{
+    if (op == ExprOp::Add && a.index() == 4 && b.index() == 4)
+        return std::get<std::string>(a) + std::get<std::string>(b);
+
+    const char* sym = op == ExprOp::Add ? "+" : op == ExprOp::Sub ? "-" : op == ExprOp::Mul ? "*"
+                    : op == ExprOp::Div ? "/" : op == ExprOp::FloorDiv ? "//" : op == ExprOp::Mod ? "%" : "**";
+
+    if (!isNumeric(a) || !isNumeric(b))
+        typeError(sym, a, b);
+
+    bool useDouble = a.index() == 3 || b.index() == 3;
+
+    if (op == ExprOp::Div) {
+        double d = asDouble(b);
+        if (d == 0.0) throw ExpressionError("division by zero");
+        return asDouble(a) / d;
+    }
+
+    if (op == ExprOp::Pow) {
+        if (!useDouble && asInt(b) >= 0)
+            return i_pow(asInt(a), asInt(b));
+        return f_pow(asDouble(a), asDouble(b));
+    }
+
+    if (useDouble) {
+        double x = asDouble(a), y = asDouble(b);
+        switch (op) {
+        case ExprOp::Add: return x + y;
+        case ExprOp::Sub: return x - y;
+        case ExprOp::Mul: return x * y;
+        case ExprOp::FloorDiv: return f_floordiv(x, y);
+        default: return f_mod(x, y);
+        }
+    }
+
+    int64_t x = asInt(a), y = asInt(b);
+    switch (op) {
+    case ExprOp::Add: return i_add(x, y);
+    case ExprOp::Sub: return i_sub(x, y);
+    case ExprOp::Mul: return i_mul(x, y);
+    case ExprOp::FloorDiv: return i_floordiv(x, y);
+    default: return i_mod(x, y);
+    }
+}
+
+bool equals(const FsmValue& a, const FsmValue& b)
+{
+    if (isNumeric(a) && isNumeric(b)) {
+        if (a.index() == 3 || b.index() == 3) return asDouble(a) == asDouble(b);
+        return asInt(a) == asInt(b);
+    }
+    return a == b;
+}
+
+bool compare(ExprOp op, const FsmValue& a, const FsmValue& b)
+{
+    if (op == ExprOp::Eq) return equals(a, b);
+    if (op == ExprOp::Ne) return !equals(a, b);
+
+    int cmp;
+    if (isNumeric(a) && isNumeric(b)) {
+        if (a.index() == 3 || b.index() == 3) {
+            double x = asDouble(a), y = asDouble(b);
+            cmp = x < y ? -1 : (x > y ? 1 : 0);
+        } else {
+            int64_t x = asInt(a), y = asInt(b);
+            cmp = x < y ? -1 : (x > y ? 1 : 0);
+        }
+    } else if (a.index() == 4 && b.index() == 4) {
+        cmp = std::get<std::string>(a).compare(std::get<std::string>(b));
+    } else {
+        throw ExpressionError(std::string("'<' not supported between instances of '")
+                              + typeName(a) + "' and '" + typeName(b) + "'");
+    }
+
+    switch (op) {
+    case ExprOp::Lt: return cmp < 0;
+    case ExprOp::Le: return cmp <= 0;
+    case ExprOp::Gt: return cmp > 0;
+    default: return cmp >= 0;
+    }
+}
+
+FsmValue callBuiltin(const std::string& f, const FsmValue* args, size_t count)
+{
+    if ((f == "min" || f == "max") && count > 0) {
+        FsmValue best = args[0];
+        for (size_t i = 1; i < count; i++) {
+            bool less = compare(ExprOp::Lt, args[i], best);
+            if ((f == "min" && less) || (f == "max" && compare(ExprOp::Gt, args[i], best)))
+                best = args[i];
+        }
+        return best;
+    }
+
+    if (count != 1)
+        throw ExpressionError(f + "() takes exactly one argument");
+    const FsmValue& v = args[0];
+
+    if (f == "abs") {
+        if (v.index() == 3) return std::fabs(std::get<double>(v));
+        if (isNumeric(v)) return i_abs(asInt(v));
+    } else if (f == "int") {
+        if (v.index() == 3) return static_cast<int64_t>(std::get<double>(v));
+        if (isNumeric(v)) return asInt(v);
+        if (v.index() == 4) {
+            FsmValue parsed = parseFsmValueLiteral(std::get<std::string>(v));
+            if (parsed.index() == 2) return parsed;
+            throw ExpressionError("invalid literal for int(): '" + std::get<std::string>(v) + "'");
+        }
+    } else if (f == "float") {
+        if (isNumeric(v)) return asDouble(v);
+        if (v.index() == 4) {
+            FsmValue parsed = parseFsmValueLiteral(std::get<std::string>(v));
+            if (parsed.index() == 2 || parsed.index() == 3) return asDouble(parsed);
+            throw ExpressionError("could not convert string to float: '" + std::get<std::string>(v) + "'");
+        }
+    } else if (f == "str") {
+        return fsmValueToString(v);
+    } else if (f == "len") {
+        if (v.index() == 4) return static_cast<int64_t>(std::get<std::string>(v).size());
+    }
+
+    throw ExpressionError(f + "() argument of type '" + typeName(v) + "' is not supported");
+}
+
+FsmValue callBuiltin(const ExprNode& node, const std::vector<FsmValue>& vars)
+{
+    std::vector<FsmValue> args;
+    args.reserve(node.args.size());
+    for (const auto& a : node.args)
+        args.push_back(eval(*a, vars));
+    return callBuiltin(node.name, args.data(), args.size());
+}
+
+FsmValue eval(const ExprNode& node, const std::vector<FsmValue>& vars)
+{
+    switch (node.op) {
+    case ExprOp::Literal:
+        return node.literal;
+
+    case ExprOp::Variable:
+        return vars[node.slot];
+
+    case ExprOp::Neg: {
+        FsmValue v = eval(*node.args[0], vars);
+        if (v.index() == 3) return -std::get<double>(v);
+        if (isNumeric(v)) return i_neg(asInt(v));
+        throw ExpressionError(std::string("bad operand type for unary -: '") + typeName(v) + "'");
+    }
+
+    case ExprOp::Not:
+        return !fsmValueIsTrue(eval(*node.args[0], vars));
+
+    case ExprOp::And: {
+        FsmValue lhs = eval(*node.args[0], vars);
+        return fsmValueIsTrue(lhs) ? eval(*node.args[1], vars) : lhs;
+    }
+
+    case ExprOp::Or: {
+        FsmValue lhs = eval(*node.args[0], vars);
+        return fsmValueIsTrue(lhs) ? lhs : eval(*node.args[1], vars);
+    }
+
+    case ExprOp::Eq:
+    case ExprOp::Ne:
+    case ExprOp::Lt:
+    case ExprOp::Le:
+    case ExprOp::Gt:
+    case ExprOp::Ge:
+        return compare(node.op, eval(*node.args[0], vars), eval(*node.args[1], vars));
+
+    case ExprOp::Call:
+        return callBuiltin(node, vars);
+
+    default:
+        return arithmetic(node.op, eval(*node.args[0], vars), eval(*node.args[1], vars));
+    }
+}
+
+
+/**
+ *    CONSTANT FOLDING
+ *  ========================================================================
+ */
+
+bool isLiteral(const ExprNode& node) { return node.op == ExprOp::Literal; }
+
+/**
+ * @brief Replaces the subtrees without variables by their value.
+ *
+ * A subtree that fails to evaluate (e.g. 1/0) is kept, so the error is still raised
+ * when the expression runs, as in Python.
+ */
+void fold(std::unique_ptr<ExprNode>& node)
+{
+    for (auto& arg : node->args)
+        fold(arg);
+
+    switch (node->op) {
+    case ExprOp::Literal:
+    case ExprOp::Variable:
+        return;
+
+    case ExprOp::And:
+    case ExprOp::Or: {
+        // a constant left side decides which side the result is
+        if (!isLiteral(*node->args[0]))
+            return;
+        const bool lhsTrue = fsmValueIsTrue(node->args[0]->literal);
+        const bool takeLhs = node->op == ExprOp::And ? !lhsTrue : lhsTrue;
+        std::unique_ptr<ExprNode> taken = std::move(node->args[takeLhs ? 0 : 1]);
+        node = std::move(taken);
+        return;
+    }
+
+    default:
+        break;
+    }
+
+    for (const auto& arg : node->args) {
+        if (!isLiteral(*arg))
+            return;
+    }
+
+    try {
+        FsmValue value = eval(*node, {});
+        auto literal = makeNode(ExprOp::Literal);
+        literal->literal = std::move(value);
+        node = std::move(literal);
+    } catch (const ExpressionError&) {
+    }
+}
+
+/**
+ *    BYTECODE
+ *  ========================================================================
+ */
+
+enum class Code : uint8_t
+{
+    Move,         ///< dst = a
+    Neg,          ///< dst = -a
+    Not,          ///< dst = not a
+    Arithmetic,   ///< dst = a op b, op in target
+    Compare,      ///< dst = a op b, op in target
+    JumpIfFalse,  ///< if not dst: pc = target
+    JumpIfTrue,   ///< if dst: pc = target
+    Call,         ///< dst = builtin(names[target], registers a.index .. a.index + b.index - 1)
+    Return        ///< result is a
+};
+
+/// Where an operand is read from.
+enum class Source : uint8_t
+{
+    Register,
+    Variable,
+    Constant
+};
+
+struct Operand
+{
+    Source source = Source::Register;
+    uint16_t index = 0;
+};
+
+struct Instruction
+{
+    Code code = Code::Return;
+    uint8_t dst = 0;
+    uint16_t target = 0;   ///< jump target, ExprOp of Arithmetic and Compare, builtin of Call
+    Operand a;
+    Operand b;
+};
+
+constexpr int kMaxRegisters = 255;
+constexpr size_t kMaxOperandIndex = 0xffff;
+
+} // namespace
+
+struct ExprProgram
+{
+    std::vector<Instruction> code;
+    std::vector<FsmValue> constants;
+    std::vector<std::string> builtins;
+    int registers = 0;
+};
+
+namespace {
+
+/**
+ * @brief Compiles a folded tree into bytecode, registers are allocated like a stack.
+ *
+ * Literals and variables are read in place by the instruction using them, only the
+ * results of operations take a register.
+ */
+class ProgramCompiler
+{
+public:
+    explicit ProgramCompiler(ExprProgram& program) : m_program(program) {}
+
+    void compileRoot(const ExprNode& root)
+    {
+        Instruction ret{};
+        ret.code = Code::Return;
+        ret.a = operand(root);
+        m_program.code.push_back(ret);
+        m_program.registers = m_maxRegisters;
+    }
+
+private:
+    int allocate()
+    {
+        if (m_nextRegister >= kMaxRegisters)
+            throw ExpressionError("Expression is too deep for the bytecode");
+        m_maxRegisters = std::max(m_maxRegisters, m_nextRegister + 1);
+        return m_nextRegister++;
+    }
+
+    Operand constant(const FsmValue& value)
+    {
+        if (m_program.constants.size() >= kMaxOperandIndex)
+            throw ExpressionError("Too many constants for the bytecode");
+        m_program.constants.push_back(value);
+        return Operand{Source::Constant, static_cast<uint16_t>(m_program.constants.size() - 1)};
+    }
+
+    Operand operand(const ExprNode& node)
+    {
+        if (node.op == ExprOp::Literal)
+            return constant(node.literal);
+        if (node.op == ExprOp::Variable && node.slot >= 0 && static_cast<size_t>(node.slot) < kMaxOperandIndex)
+            return Operand{Source::Variable, static_cast<uint16_t>(node.slot)};
+
+        const int reg = allocate();
+        compileInto(node, reg);
+        return Operand{Source::Register, static_cast<uint16_t>(reg)};
+    }
+
+    void emit(Code code, int dst, Operand a = {}, Operand b = {}, uint16_t target = 0)
+    {
+        Instruction in{};
+        in.code = code;
+        in.dst = static_cast<uint8_t>(dst);
+        in.a = a;
+        in.b = b;
+        in.target = target;
+        m_program.code.push_back(in);
+    }
+
+    void compileInto(const ExprNode& node, int dst)
+    {
+        const int saved = m_nextRegister;
+
+        switch (node.op) {
+        case ExprOp::Literal:
+        case ExprOp::Variable:
+            emit(Code::Move, dst, operand(node));
+            break;
+
+        case ExprOp::Neg:
+        case ExprOp::Not:
+            emit(node.op == ExprOp::Neg ? Code::Neg : Code::Not, dst, operand(*node.args[0]));
+            break;
+
+        case ExprOp::And:
+        case ExprOp::Or: {
+            // the left value is the result if it decides, as in Python
+            compileInto(*node.args[0], dst);
+            const size_t jump = m_program.code.size();
+            emit(node.op == ExprOp::And ? Code::JumpIfFalse : Code::JumpIfTrue, dst);
+            compileInto(*node.args[1], dst);
+            m_program.code[jump].target = static_cast<uint16_t>(m_program.code.size());
+            break;
+        }
+
+        case ExprOp::Eq:
+        case ExprOp::Ne:
+        case ExprOp::Lt:
+        case ExprOp::Le:
+        case ExprOp::Gt:
+        case ExprOp::Ge: {
+            const Operand a = operand(*node.args[0]);
+            const Operand b = operand(*node.args[1]);
+            emit(Code::Compare, dst, a, b, static_cast<uint16_t>(node.op));
+            break;
+        }
+
+        case ExprOp::Call: {
+            // the arguments go to consecutive registers
+            const int first = m_nextRegister;
+            for (const auto& arg : node.args)
+                compileInto(*arg, allocate());
+            m_program.builtins.push_back(node.name);
+            emit(Code::Call, dst, Operand{Source::Register, static_cast<uint16_t>(first)},
+                 Operand{Source::Register, static_cast<uint16_t>(node.args.size())},
+                 static_cast<uint16_t>(m_program.builtins.size() - 1));
+            break;
+        }
+
+        default: {
+            const Operand a = operand(*node.args[0]);
+            const Operand b = operand(*node.args[1]);
+            emit(Code::Arithmetic, dst, a, b, static_cast<uint16_t>(node.op));
+            break;
+        }
+        }
+
+        if (m_program.code.size() > kMaxOperandIndex)
+            throw ExpressionError("Expression is too long for the bytecode");
+        m_nextRegister = saved;
+    }
+
+    ExprProgram& m_program;
+    int m_nextRegister = 0;
+    int m_maxRegisters = 0;
+};
+
+/**
+ * @brief Runs the bytecode, the hot path of the engine.
+ *
+ * Integer comparisons and integer arithmetic without overflow concerns are done inline,
+ * everything else goes through the same helpers as the tree evaluation.
+ */
+FsmValue run(const ExprProgram& program, const std::vector<FsmValue>& vars)
+{
+    // registers are reused by every evaluation on the thread
+    thread_local std::vector<FsmValue> registers;
+    if (registers.size() < static_cast<size_t>(program.registers))
+        registers.resize(program.registers);
+
+    auto read = [&](const Operand& o) -> const FsmValue& {
+        switch (o.source) {
+        case Source::Register: return registers[o.index];
+        case Source::Variable: return vars[o.index];
+        default: return program.constants[o.index];
+        }
+    };
+
+    const Instruction* code = program.code.data();
+    size_t pc = 0;
+    for (;;) {
+        const Instruction& in = code[pc++];
+        switch (in.code) {
+        case Code::Move:
+            registers[in.dst] = read(in.a);
+            break;
+
+        case Code::Neg: {
+            const FsmValue& v = read(in.a);
+            if (v.index() == 2) registers[in.dst] = i_neg(std::get<int64_t>(v));
+            else if (v.index() == 3) registers[in.dst] = -std::get<double>(v);
+            else if (isNumeric(v)) registers[in.dst] = i_neg(asInt(v));
+            else throw ExpressionError(std::string("bad operand type for unary -: '") + typeName(v) + "'");
+            break;
+        }
+
+        case Code::Not:
+            registers[in.dst] = !fsmValueIsTrue(read(in.a));
+            break;
+
+        case Code::Compare: {
+            const FsmValue& a = read(in.a);
+            const FsmValue& b = read(in.b);
+            const ExprOp op = static_cast<ExprOp>(in.target);
+            if (a.index() == 2 && b.index() == 2) {
+                const int64_t x = std::get<int64_t>(a), y = std::get<int64_t>(b);
+                bool r;
+                switch (op) {
+                case ExprOp::Eq: r = x == y; break;
+                case ExprOp::Ne: r = x != y; break;
+                case ExprOp::Lt: r = x < y; break;
+                case ExprOp::Le: r = x <= y; break;
+                case ExprOp::Gt: r = x > y; break;
+                default: r = x >= y; break;
+                }
+                registers[in.dst] = r;
+            } else {
+                registers[in.dst] = compare(op, a, b);
+            }
+            break;
+        }
+
+        case Code::Arithmetic: {
+            const FsmValue& a = read(in.a);
+            const FsmValue& b = read(in.b);
+            const ExprOp op = static_cast<ExprOp>(in.target);
+            if (a.index() == 2 && b.index() == 2 && (op == ExprOp::Add || op == ExprOp::Sub || op == ExprOp::Mul)) {
+                const int64_t x = std::get<int64_t>(a), y = std::get<int64_t>(b);
+                registers[in.dst] = op == ExprOp::Add ? i_add(x, y) : op == ExprOp::Sub ? i_sub(x, y) : i_mul(x, y);
+            } else {
+                registers[in.dst] = arithmetic(op, a, b);
+            }
+            break;
+        }
+
+        case Code::JumpIfFalse:
+            if (!fsmValueIsTrue(registers[in.dst])) pc = in.target;
+            break;
+
+        case Code::JumpIfTrue:
+            if (fsmValueIsTrue(registers[in.dst])) pc = in.target;
+            break;
+
+        case Code::Call:
+            registers[in.dst] = callBuiltin(program.builtins[in.target], &registers[in.a.index], in.b.index);
+            break;
+
+        case Code::Return:
+            return read(in.a);
+        }
+    }
+}
+
+} // namespace
+
+/**
+ *    FsmExpression
+ *  ========================================================================
+ */
+
+FsmExpression::FsmExpression() = default;
+FsmExpression::~FsmExpression() = default;
+FsmExpression::FsmExpression(FsmExpression&&) noexcept = default;
+FsmExpression& FsmExpression::operator=(FsmExpression&&) noexcept = default;
+
+FsmExpression FsmExpression::compile(const std::string& source, const FsmSlotMap& slots)
+{
+    Parser parser(tokenize(source), slots);
+    parser.skipSeparators();
+
+    FsmExpression result;
+    if (parser.atEnd())
+        return result; // empty condition is always true
+
+    result.m_root = parser.parseExpression();
+    parser.skipSeparators();
+    if (!parser.atEnd())
+        throw ExpressionError("Unexpected token '" + parser.peek().text + "' after expression");
+
+    result.build();
+    return result;
+}
+
+void FsmExpression::build()
+{
+    m_program.reset();
+    if (!m_root)
+        return;
+
+    fold(m_root);
+
+    auto program = std::make_unique<ExprProgram>();
+    try {
+        ProgramCompiler(*program).compileRoot(*m_root);
+    } catch (const ExpressionError&) {
+        return; // too large for the registers, the tree is evaluated instead
+    }
+    m_program = std::move(program);
+}
+
+size_t FsmExpression::instructionCount() const
+{
+    return m_program ? m_program->code.size() : 0;
+}
+
+FsmValue FsmExpression::evaluate(const std::vector<FsmValue>& vars) const
+{
+    if (m_program)
+        return run(*m_program, vars);
+    if (!m_root)
+        return true;
+    return eval(*m_root, vars);
+}
+
+FsmChannelUse fsmChannelsUsed(const std::string& source)
+{
+    FsmChannelUse use;
+    if (source.find("send") == std::string::npos && source.find("received") == std::string::npos
+        && source.find("message") == std::string::npos)
+        return use;
+
+    // code outside the subset is reported by the compilation, with the state or transition
+    std::vector<Token> tokens;
+    try {
+        tokens = tokenize(source);
+    } catch (const ExpressionError&) {
+        return use;
+    }
+    for (size_t i = 0; i + 2 < tokens.size(); ++i) {
+        const Token& t = tokens[i];
+        if (t.kind != Tok::Ident || tokens[i + 1].kind != Tok::LParen || tokens[i + 2].kind != Tok::String)
+            continue;
+        std::vector<std::string>* names = t.text == "send" ? &use.sent
+                                        : (t.text == "received" || t.text == "message") ? &use.received
+                                        : nullptr;
+        const std::string& channel = std::get<std::string>(tokens[i + 2].literal);
+        if (names && std::find(names->begin(), names->end(), channel) == names->end())
+            names->push_back(channel);
+    }
+    return use;
+}
+
+/**
+ *    FsmAction
+ *  ========================================================================
+ */
+
+FsmAction FsmAction::compile(const std::string& source, const FsmSlotMap& slots)
+{
+    Parser parser(tokenize(source), slots);
+    FsmAction action;
+
+    parser.skipSeparators();
+    while (!parser.atEnd()) {
+        const Token& t = parser.peek();
+        if (t.kind != Tok::Ident)
+            throw ExpressionError("Expected a statement, found '" + t.text + "'");
+
+        if (t.text == "pass") {
+            parser.m_pos++;
+        } else if (t.text == "print" && parser.peek(1).kind == Tok::LParen) {
+            parser.m_pos += 2;
+            Statement st;
+            st.kind = StatementKind::Print;
+            if (parser.peek().kind != Tok::RParen) {
+                FsmExpression arg;
+                arg.m_root = parser.parseExpression();
+                arg.build();
+                st.args.push_back(std::move(arg));
+                while (parser.peek().kind == Tok::Comma) {
+                    parser.m_pos++;
+                    FsmExpression next;
+                    next.m_root = parser.parseExpression();
+                    next.build();
+                    st.args.push_back(std::move(next));
+                }
+            }
+            parser.expect(Tok::RParen, ")");
+            action.m_statements.push_back(std::move(st));
+        } else if (t.text == "send" && parser.peek(1).kind == Tok::LParen) {
+            parser.m_pos += 2;
+            Statement st;
+            st.kind = StatementKind::Send;
+            const std::string channel = parser.channelName();
+            st.slot = parser.resolveChannelSlot(fsmSendSlot(channel), channel);
+            parser.expect(Tok::Comma, ",");
+            FsmExpression value;
+            value.m_root = parser.parseExpression();
+            value.build();
+            st.args.push_back(std::move(value));
+            parser.expect(Tok::RParen, ")");
+            action.m_statements.push_back(std::move(st));
+        } else {
+            std::string name = t.text;
+            int slot = parser.resolveSlot(name);
+            parser.m_pos++;
+
+            const Token& op = parser.peek();
+            if (op.kind != Tok::Op)
+                throw ExpressionError("Expected assignment to '" + name + "'");
+
+            Statement st;
+            st.kind = StatementKind::Assign;
+            st.slot = slot;
+
+            FsmExpression value;
+            if (op.text == "=") {
+                parser.m_pos++;
+                value.m_root = parser.parseExpression();
+            } else if (op.text == "+=" || op.text == "-=" || op.text == "*=" || op.text == "/=" || op.text == "%=") {
+                ExprOp binOp = op.text == "+=" ? ExprOp::Add : op.text == "-=" ? ExprOp::Sub
+                             : op.text == "*=" ? ExprOp::Mul : op.text == "/=" ? ExprOp::Div : ExprOp::Mod;
+                parser.m_pos++;
+                auto target = makeNode(ExprOp::Variable);
+                target->slot = slot;
+                target->name = name;
+                value.m_root = makeBinary(binOp, std::move(target), parser.parseExpression());
+            } else {
+                throw ExpressionError("Expected assignment to '" + name + "', found '" + op.text + "'");
+            }
+
+            value.build();
+            st.args.push_back(std::move(value));
+            action.m_statements.push_back(std::move(st));
+        }
+
+        if (!parser.atEnd() && parser.peek().kind != Tok::Newline && parser.peek().kind != Tok::Semicolon)
+            throw ExpressionError("Unexpected token '" + parser.peek().text + "' after statement");
+        parser.skipSeparators();
+    }
+
+    return action;
+}
+
+std::vector<int> FsmAction::assignedSlots() const
+{
+    std::vector<int> slots;
+    for (const auto& st : m_statements) {
+        if (st.kind == StatementKind::Assign && std::find(slots.begin(), slots.end(), st.slot) == slots.end())
+            slots.push_back(st.slot);
+    }
+    return slots;
+}
+
+void FsmAction::execute(std::vector<FsmValue>& vars,
+                        std::vector<int>& assigned,
+                        std::vector<std::string>& output,
+                        std::vector<FsmSentMessage>* sent) const
+{
+    for (const auto& st : m_statements) {
+        if (st.kind == StatementKind::Assign) {
+            vars[st.slot] = st.args[0].evaluate(vars);
+            if (std::find(assigned.begin(), assigned.end(), st.slot) == assigned.end())
+                assigned.push_back(st.slot);
+        } else if (st.kind == StatementKind::Send) {
+            FsmValue value = st.args[0].evaluate(vars);
+            if (sent)
+                sent->emplace_back(st.slot, std::move(value));
+        } else {
+            std::string line;
+            for (size_t i = 0; i < st.args.size(); i++) {
+                if (i) line += ' ';
+                line += fsmValueToString(st.args[i].evaluate(vars));
+            }
+            output.push_back(std::move(line));
+        }
+    }
+}
@@ -0,0 +1,227 @@
+/**
+ * @file fsm-expression.hpp
+ * @brief Expression language used by the native FSM engine for conditions and actions.
+ *
+ * The native engine cannot execute arbitrary Python, so state actions and transition
+ * conditions are compiled from a small Python-compatible subset:
+ * - literals (ints, floats, strings, True/False/None),
+ * - variable references,
+ * - arithmetic (+ - * / // % **), comparison (== != < <= > >=) and boolean logic
+ *   (and/or/not, also &&/||/!),
+ * - a handful of builtins (abs, min, max, int, float, str, len).
+ *
+ * Action bodies are a list of statements separated by newlines or ';': assignments
+ * (`x = expr`, `x += expr`, ...), `print(...)` and `pass`. Comments are ignored.
+ *
+ * The native engine adds the event channels between automata (see event-channel.hpp):
+ * `send("name", expr)` as a statement, `received("name")` (a message is pending) and
+ * `message("name")` (the last message delivered) in expressions. They compile only where
+ * the slot map has the entries named by fsmSendSlot(), fsmReceivedSlot() and fsmMessageSlot().
+ *
+ * Variables are resolved to slot indices when compiling, so evaluation never touches
+ * variable names. The parsed tree is constant folded and compiled into register based
+ * bytecode, which is what evaluate() runs.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#ifndef FSM_EXPRESSION_HPP
+#define FSM_EXPRESSION_HPP
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "../spec_parser/variable-value.hpp"
+
+/**
+ * @brief Runtime value of an FSM variable or expression (None, bool, int, float, str).
+ *
+ * The same type as the typed VariableInfo value, initial values are used as they are.
+ */
+using FsmValue = VariableValue;
+
+/**
+ * @brief Error raised when an expression cannot be compiled or evaluated.
+ */
+class ExpressionError : public std::runtime_error
+{
+public:
+    using std::runtime_error::runtime_error;
+};
+
+/**
+ * @brief Parses a literal the same way variable values are parsed (see parseVariableValue()):
+ *        bool, then int, then float, otherwise string.
+ * @param text The text to parse.
+ * @return The parsed value, None for an empty string.
+ */
+FsmValue parseFsmValueLiteral(const std::string& text);
+
+/**
+ * @brief Python truthiness of a value.
+ */
+bool fsmValueIsTrue(const FsmValue& value);
+
+/**
+ * @brief Python-like textual representation of a value (as `str()` would print it).
+ */
+std::string fsmValueToString(const FsmValue& value);
+
+/// Maps variable names to the slot indices used during evaluation.
+using FsmSlotMap = std::unordered_map<std::string, int>;
+
+/**
+ * @brief The channels an action or condition sends to and receives from, each once.
+ */
+struct FsmChannelUse
+{
+    std::vector<std::string> sent;       ///< send("name", ...)
+    std::vector<std::string> received;   ///< received("name") and message("name")
+};
+
+/**
+ * @brief Finds the channels used by the source, without compiling it.
+ */
+FsmChannelUse fsmChannelsUsed(const std::string& source);
+
+/// Slot of the bool "a message of the channel is pending", the names cannot clash with variables.
+inline std::string fsmReceivedSlot(const std::string& channel) { return "received:" + channel; }
+/// Slot of the last message of the channel delivered to the automaton.
+inline std::string fsmMessageSlot(const std::string& channel) { return "message:" + channel; }
+/// Not a variable slot, the index of the channel in the messages sent by FsmAction::execute().
+inline std::string fsmSendSlot(const std::string& channel) { return "send:" + channel; }
+
+/// A message sent by an action, the channel as given by fsmSendSlot().
+using FsmSentMessage = std::pair<int, FsmValue>;
+
+struct ExprNode;
+struct ExprProgram;
+
+/**
+ * @class FsmExpression
+ * @brief A compiled expression which can be evaluated against a slot array.
+ */
+class FsmExpression
+{
+public:
+    FsmExpression();
+    ~FsmExpression();
+    FsmExpression(FsmExpression&&) noexcept;
+    FsmExpression& operator=(FsmExpression&&) noexcept;
+
+    /**
+     * @brief Compiles an expression. An empty (or comment only) source compiles to True.
+     * @param source The expression text.
+     * @param slots Variable name to slot index map.
+     * @throws ExpressionError on syntax errors or unknown variables.
+     */
+    static FsmExpression compile(const std::string& source, const FsmSlotMap& slots);
+
+    /**
+     * @brief Evaluates the expression.
+     * @param vars The variable slots.
+     * @throws ExpressionError on runtime errors (type mismatch, division by zero...).
+     */
+    FsmValue evaluate(const std::vector<FsmValue>& vars) const;
+
+    /**
+     * @brief Evaluates the expression and applies Python truthiness.
+     */
+    bool test(const std::vector<FsmValue>& vars) const { return fsmValueIsTrue(evaluate(vars)); }
+
+    /**
+     * @brief Number of bytecode instructions, 0 if the expression runs on the tree.
+     */
+    size_t instructionCount() const;
+
+private:
+    /**
+     * @brief Folds the constant subtrees of m_root and compiles it into m_program.
+     */
+    void build();
+
+    std::unique_ptr<ExprNode> m_root;  ///< Root of the expression tree, null means True.
+    std::unique_ptr<ExprProgram> m_program;  ///< Bytecode of m_root, null if it does not fit the registers.
+
+    friend class FsmAction;
+    friend class CppGenerator;
+};
+
+/**
+ * @class FsmAction
+ * @brief A compiled state action (list of statements).
+ */
+class FsmAction
+{
+public:
+    /**
+     * @brief Compiles an action body.
+     * @param source The action text (one statement per line or separated by ';').
+     * @param slots Variable name to slot index map.
+     * @throws ExpressionError on syntax errors or unknown variables.
+     */
+    static FsmAction compile(const std::string& source, const FsmSlotMap& slots);
+
+    /**
+     * @brief Executes the action.
+     * @param vars The variable slots, modified in place.
+     * @param assigned Receives the slot indices written by the action (in order, unique).
+     * @param output Receives the lines produced by print().
+     * @throws ExpressionError on runtime errors.
+     */
+    void execute(std::vector<FsmValue>& vars,
+                 std::vector<int>& assigned,
+                 std::vector<std::string>& output) const
+    {
+        execute(vars, assigned, output, nullptr);
+    }
+
+    /**
+     * @brief Executes the action, also collecting the messages of send().
+     * @param sent Receives the messages in order, they are dropped if null.
+     */
+    void execute(std::vector<FsmValue>& vars,
+                 std::vector<int>& assigned,
+                 std::vector<std::string>& output,
+                 std::vector<FsmSentMessage>* sent) const;
+
+    /**
+     * @brief Returns true if the action has no statements.
+     */
+    bool isEmpty() const { return m_statements.empty(); }
+
+    /**
+     * @brief The slots the action assigns, in the order of their first assignment.
+     *
+     * The statements run in order, so a run without an error assigns exactly these.
+     */
+    std::vector<int> assignedSlots() const;
+
+private:
+    enum class StatementKind
+    {
+        Assign,
+        Print,
+        Send
+    };
+
+    struct Statement
+    {
+        StatementKind kind = StatementKind::Assign;
+        int slot = -1;                     ///< Target slot for assignments, the channel of send().
+        std::vector<FsmExpression> args;   ///< Assigned value, or print() arguments.
+    };
+
+    std::vector<Statement> m_statements;
+
+    friend class CppGenerator;
+};
+
+#endif // FSM_EXPRESSION_HPP
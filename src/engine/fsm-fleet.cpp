@@ -0,0 +1,408 @@
+/**
+ * @file fsm-fleet.cpp
+ * @brief Implementation of the FsmFleet class.
+ *
+ * A task is resumed with the events that woke it, taken from Instance::flags so that
+ * Scheduled stays set while it runs; events arriving meanwhile are taken by the same
+ * worker before it lets the task go, so an instance never runs on two workers at once.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#include "fsm-fleet.hpp"
+
+#include <algorithm>
+#include <optional>
+
+#include "../spec_parser/compiled-automaton.hpp"
+#include "../spec_parser/sub-automaton.hpp"
+
+namespace {
+
+// the fleet and the queue of the worker running on this thread, a task it wakes stays there
+thread_local const FsmFleet* t_fleet = nullptr;
+thread_local unsigned t_worker = 0;
+
+} // namespace
+
+FsmFleet::FsmFleet(const Automaton& automaton, unsigned threads)
+{
+    compile(automaton);
+
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<WorkerQueue>(threads).swap(m_queues);
+    m_workers.reserve(threads);
+    for (unsigned i = 0; i < threads; ++i)
+        m_workers.emplace_back(&FsmFleet::workerMain, this, i);
+}
+
+FsmFleet::~FsmFleet()
+{
+    m_closing = true;
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+    }
+    m_wakeWorker.notify_all();
+    for (auto& worker : m_workers)
+        worker.join();
+
+    // no worker schedules a timer any more, a cancelled one never calls back
+    for (Instance& instance : m_instances) {
+        if (instance.timer)
+            TimerWheel::shared().cancel(instance.timer);
+    }
+}
+
+void FsmFleet::compile(const Automaton& source)
+{
+    // the instances run as the states of their definitions
+    std::optional<Automaton> expanded;
+    if (!source.getInstances().empty())
+        expanded.emplace(expandSubAutomata(source));
+    const Automaton& automaton = expanded ? *expanded : source;
+
+    for (const auto& var : automaton.getVariables()) {
+        if (m_slots.count(var.name))
+            continue;
+        m_slots[var.name] = static_cast<int>(m_varNames.size());
+        m_varNames.push_back(var.name);
+        m_defaults.push_back(var.parsed);
+    }
+
+    const CompiledAutomaton compiled = CompiledAutomaton::FromAutomaton(automaton);
+    m_states.resize(compiled.stateCount());
+    for (StateId id = 0; id < static_cast<StateId>(compiled.stateCount()); ++id) {
+        FleetState& state = m_states[id];
+        state.name = compiled.stateName(id);
+        state.isFinal = compiled.isFinalState(id);
+        try {
+            state.action = FsmAction::compile(compiled.stateAction(id), m_slots);
+        } catch (const ExpressionError& e) {
+            throw ExpressionError("Action of state '" + state.name + "': " + e.what());
+        }
+
+        for (uint32_t i = compiled.firstTransition(id); i < compiled.lastTransition(id); ++i) {
+            const Transition& t = compiled.transition(i);
+            if (!compiled.isDeclaredState(id) || !compiled.isDeclaredState(compiled.target(i)))
+                throw ExpressionError("Transition " + t.fromState.str() + " -> " + t.toState.str() + " refers to an unknown state");
+            FleetTransition transition;
+            transition.target = compiled.target(i);
+            transition.delay = t.delay;
+            try {
+                transition.condition = FsmExpression::compile(std::string(t.condition), m_slots);
+            } catch (const ExpressionError& e) {
+                throw ExpressionError("Condition of transition " + t.fromState.str() + " -> " + t.toState.str() + ": " + e.what());
+            }
+            state.transitions.push_back(std::move(transition));
+        }
+    }
+
+    if (compiled.startState() == InvalidStateId)
+        throw ExpressionError("Start state '" + automaton.getStartName().str() + "' not found.");
+    m_startState = compiled.startState();
+}
+
+FsmFleet::InstanceId FsmFleet::spawn(std::vector<FsmValue> values)
+{
+    // missing values are the declared ones
+    for (size_t slot = values.size(); slot < m_defaults.size(); ++slot)
+        values.push_back(m_defaults[slot]);
+    values.resize(m_defaults.size());
+
+    Instance* instance;
+    InstanceId id;
+    {
+        std::lock_guard<std::mutex> lock(m_instancesMutex);
+        id = static_cast<InstanceId>(m_instances.size());
+        instance = &m_instances.emplace_back();
+    }
+    instance->id = id;
+    instance->vars = std::move(values);
+    instance->virtualTime = m_virtualTime;
+    instance->state.store(m_startState, std::memory_order_relaxed);
+
+    m_running.fetch_add(1, std::memory_order_acq_rel);
+    wake(*instance, kWakeStart);
+    return id;
+}
+
+FsmFleet::Instance* FsmFleet::find(InstanceId instance) const
+{
+    std::lock_guard<std::mutex> lock(m_instancesMutex);
+    if (instance >= m_instances.size())
+        return nullptr;
+    return const_cast<Instance*>(&m_instances[instance]);
+}
+
+bool FsmFleet::setVariable(InstanceId instance, const std::string& name, FsmValue value)
+{
+    auto slot = m_slots.find(name);
+    Instance* target = find(instance);
+    if (slot == m_slots.end() || !target)
+        return false;
+
+    {
+        std::lock_guard<std::mutex> lock(m_commandMutexes[instance % kCommandStripes]);
+        target->commands.emplace_back(slot->second, std::move(value));
+    }
+    wake(*target, kWakeChanged);
+    return true;
+}
+
+void FsmFleet::stop(InstanceId instance)
+{
+    if (Instance* target = find(instance))
+        wake(*target, kWakeStop);
+}
+
+void FsmFleet::stopAll()
+{
+    const size_t count = size();
+    for (size_t i = 0; i < count; ++i)
+        stop(static_cast<InstanceId>(i));
+}
+
+bool FsmFleet::waitIdle(std::chrono::milliseconds timeout)
+{
+    std::unique_lock<std::mutex> lock(m_idleMutex);
+    return m_idle.wait_for(lock, timeout, [this] { return running() == 0; });
+}
+
+int32_t FsmFleet::state(InstanceId instance) const
+{
+    const Instance* target = find(instance);
+    return target ? target->state.load(std::memory_order_acquire) : -1;
+}
+
+FleetOutcome FsmFleet::outcome(InstanceId instance) const
+{
+    const Instance* target = find(instance);
+    return target ? static_cast<FleetOutcome>(target->outcome.load(std::memory_order_acquire)) : FleetOutcome::Running;
+}
+
+uint32_t FsmFleet::steps(InstanceId instance) const
+{
+    const Instance* target = find(instance);
+    return target ? target->steps.load(std::memory_order_acquire) : 0;
+}
+
+size_t FsmFleet::size() const
+{
+    std::lock_guard<std::mutex> lock(m_instancesMutex);
+    return m_instances.size();
+}
+
+void FsmFleet::wake(Instance& instance, uint32_t events)
+{
+    const uint32_t before = instance.flags.fetch_or(events | kScheduled, std::memory_order_acq_rel);
+    if (!(before & kScheduled))
+        push(&instance);
+}
+
+void FsmFleet::push(Instance* instance)
+{
+    const unsigned queue = t_fleet == this
+                               ? t_worker
+                               : m_nextQueue.fetch_add(1, std::memory_order_relaxed) % m_queues.size();
+
+    // counted first, a thief never sees a task the count misses
+    m_queued.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> lock(m_queues[queue].mutex);
+        m_queues[queue].tasks.push_back(instance);
+    }
+    if (m_sleepers.load() > 0) {
+        {
+            std::lock_guard<std::mutex> lock(m_sleepMutex);
+        }
+        m_wakeWorker.notify_one();
+    }
+}
+
+FsmFleet::Instance* FsmFleet::pop(unsigned worker)
+{
+    const unsigned count = static_cast<unsigned>(m_queues.size());
+    for (unsigned i = 0; i < count; ++i) {
+        WorkerQueue& queue = m_queues[(worker + i) % count];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty())
+            continue;
+        Instance* instance;
+        if (i == 0) {
+            instance = queue.tasks.back();   // the newest task still has its frame in the cache
+            queue.tasks.pop_back();
+        } else {
+            instance = queue.tasks.front();
+            queue.tasks.pop_front();
+        }
+        m_queued.fetch_sub(1);
+        return instance;
+    }
+    return nullptr;
+}
+
+void FsmFleet::workerMain(unsigned worker)
+{
+    t_fleet = this;
+    t_worker = worker;
+    Scratch scratch;
+
+    while (!m_closing.load(std::memory_order_acquire)) {
+        if (Instance* instance = pop(worker)) {
+            resume(*instance, scratch);
+            continue;
+        }
+
+        // a pusher sees the sleeper or the sleeper sees the queued task
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_sleepers.fetch_add(1);
+        m_wakeWorker.wait(lock, [this] { return m_closing.load() || m_queued.load() > 0; });
+        m_sleepers.fetch_sub(1);
+    }
+}
+
+void FsmFleet::resume(Instance& instance, Scratch& scratch)
+{
+    uint32_t events = instance.flags.fetch_and(kScheduled, std::memory_order_acq_rel) & ~kScheduled;
+    for (;;) {
+        if (step(instance, events, scratch)) {
+            push(&instance); // Scheduled stays set, the events wait for the next turn
+            return;
+        }
+        uint32_t expected = kScheduled;
+        if (instance.flags.compare_exchange_strong(expected, 0, std::memory_order_acq_rel))
+            return;
+        events = instance.flags.fetch_and(kScheduled, std::memory_order_acq_rel) & ~kScheduled;
+    }
+}
+
+bool FsmFleet::step(Instance& instance, uint32_t events, Scratch& scratch)
+{
+    if (events & kWakeChanged) {
+        std::vector<std::pair<int, FsmValue>> commands;
+        {
+            std::lock_guard<std::mutex> lock(m_commandMutexes[instance.id % kCommandStripes]);
+            commands.swap(instance.commands);
+        }
+        bool changed = false;
+        for (auto& [slot, value] : commands) {
+            if (instance.vars[slot] == value)
+                continue; // unchanged values do not re-evaluate the delay
+            instance.vars[slot] = std::move(value);
+            changed = true;
+        }
+        if (changed && instance.phase == Phase::Delay) {
+            cancelTimer(instance);
+            events &= ~kWakeTimer;
+            instance.phase = Phase::Select;
+        }
+    }
+
+    if (instance.phase == Phase::Done)
+        return false;
+
+    if (events & kWakeStop) {
+        cancelTimer(instance);
+        end(instance, FleetOutcome::Stopped);
+        return false;
+    }
+
+    if (instance.phase == Phase::Delay) {
+        if (!(events & kWakeTimer))
+            return false;
+        cancelTimer(instance); // returns once the callback that woke the task is done with the fleet
+        instance.state.store(instance.target, std::memory_order_release);
+        ++instance.stepCount;
+        instance.phase = Phase::Enter;
+    }
+
+    uint32_t budget = kStepsPerResume;
+    for (;;) {
+        const int32_t stateId = instance.state.load(std::memory_order_relaxed);
+        const FleetState& current = m_states[stateId];
+
+        if (instance.phase == Phase::Enter) {
+            if (m_listener)
+                m_listener(instance.id, stateId, FleetOutcome::Running);
+            if (!current.action.isEmpty()) {
+                scratch.assigned.clear();
+                scratch.output.clear();
+                try {
+                    current.action.execute(instance.vars, scratch.assigned, scratch.output);
+                } catch (const ExpressionError&) {
+                    end(instance, FleetOutcome::Error);
+                    return false;
+                }
+            }
+            if (current.isFinal) {
+                end(instance, FleetOutcome::Finished);
+                return false;
+            }
+            instance.phase = Phase::Select;
+        }
+
+        const FleetTransition* taken = nullptr;
+        try {
+            for (const FleetTransition& t : current.transitions) {
+                if (t.condition.test(instance.vars)) {
+                    taken = &t;
+                    break;
+                }
+            }
+        } catch (const ExpressionError&) {
+            end(instance, FleetOutcome::Error);
+            return false;
+        }
+        if (!taken) {
+            end(instance, FleetOutcome::Stuck);
+            return false;
+        }
+
+        if (taken->delay > 0) {
+            if (!instance.virtualTime) {
+                // suspended until the wheel calls back, or a variable change or stop wakes it first
+                instance.target = taken->target;
+                instance.phase = Phase::Delay;
+                Instance* suspended = &instance;
+                instance.timer = TimerWheel::shared().schedule(std::chrono::milliseconds(taken->delay),
+                                                               [this, suspended] { wake(*suspended, kWakeTimer); });
+                return false;
+            }
+            instance.timeMs += taken->delay;
+        }
+
+        instance.state.store(taken->target, std::memory_order_release);
+        ++instance.stepCount;
+        instance.phase = Phase::Enter;
+        if (--budget == 0)
+            return true;
+    }
+}
+
+void FsmFleet::end(Instance& instance, FleetOutcome outcome)
+{
+    instance.phase = Phase::Done;
+    instance.steps.store(instance.stepCount, std::memory_order_release);
+    instance.outcome.store(static_cast<uint8_t>(outcome), std::memory_order_release);
+    if (m_listener)
+        m_listener(instance.id, instance.state.load(std::memory_order_relaxed), outcome);
+
+    if (m_running.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        {
+            std::lock_guard<std::mutex> lock(m_idleMutex);
+        }
+        m_idle.notify_all();
+    }
+}
+
+void FsmFleet::cancelTimer(Instance& instance)
+{
+    if (!instance.timer)
+        return;
+    // waits for a running callback, after it no expiry of this timer comes
+    TimerWheel::shared().cancel(instance.timer);
+    instance.timer = 0;
+    instance.flags.fetch_and(~uint32_t(kWakeTimer), std::memory_order_acq_rel);
+}
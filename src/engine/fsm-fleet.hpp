@@ -0,0 +1,288 @@
+/**
+ * @file fsm-fleet.hpp
+ * @brief Declaration of the FsmFleet class, many live instances of one automaton on a few threads.
+ *
+ * FsmEngine gives every automaton a worker thread, which sleeps through the delays; that
+ * does not scale to fleet simulations of thousands of automata. A fleet instance has no
+ * thread and no stack of its own: it is a resumable task, the current state, the phase it
+ * is suspended in (entering a state, in a delay) and the events it waits for. A timer of
+ * the shared TimerWheel, a variable change or a stop command wakes the task, a worker of
+ * the fleet resumes it where it was suspended and it runs until it waits again.
+ *
+ * The workers form a small work-stealing pool: an instance woken by a worker goes to the
+ * queue of that worker, others to the queues in turn, and an idle worker takes the oldest
+ * task of another queue. An instance holds its variables and a few words besides, so a
+ * host runs 100k mostly idle instances in a few tens of megabytes.
+ *
+ * The steps are the same as those of FsmEngine::run(). The fleet sends no messages, the
+ * listener is told about the states entered and how an instance ended. It does not depend
+ * on Qt.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#ifndef FSM_FLEET_HPP
+#define FSM_FLEET_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "fsm-expression.hpp"
+#include "timer-wheel.hpp"
+#include "../spec_parser/automaton-data.hpp"
+
+/**
+ * @brief How an instance of the fleet ended, Running while it has not.
+ */
+enum class FleetOutcome : uint8_t
+{
+    Running = 0,
+    Finished,     ///< reached a final state
+    Stuck,        ///< no transition enabled
+    Error,        ///< an action or condition failed
+    Stopped       ///< stopped by stop() or stopAll()
+};
+
+/**
+ * @class FsmFleet
+ * @brief Runs many instances of an automaton as tasks on a work-stealing pool.
+ */
+class FsmFleet
+{
+public:
+    using InstanceId = uint32_t;
+
+    /**
+     * @brief Called on a worker thread when an instance enters a state (outcome Running)
+     *        and when it ends, with the state it ended in.
+     */
+    using Listener = std::function<void(InstanceId instance, int32_t state, FleetOutcome outcome)>;
+
+    static constexpr uint32_t kStepsPerResume = 64;  ///< Steps an instance runs before other tasks get the worker.
+
+    /**
+     * @brief Compiles the automaton and starts the workers.
+     * @param threads Worker threads, 0 for one per hardware thread.
+     * @throws ExpressionError if an action or condition cannot be compiled.
+     */
+    explicit FsmFleet(const Automaton& automaton, unsigned threads = 0);
+
+    /**
+     * @brief Destructor, drops the instances without reporting them and joins the workers.
+     */
+    ~FsmFleet();
+
+    FsmFleet(const FsmFleet&) = delete;
+    FsmFleet& operator=(const FsmFleet&) = delete;
+
+    /**
+     * @brief The listener of all instances, none by default; set it before the first spawn().
+     */
+    void setListener(Listener listener) { m_listener = std::move(listener); }
+
+    /**
+     * @brief Delays of the instances spawned from now on advance their simulated clock, see FsmEngine::setVirtualTime().
+     */
+    void setVirtualTime(bool virtualTime) { m_virtualTime = virtualTime; }
+
+    /**
+     * @brief Starts an instance with the declared initial values.
+     */
+    InstanceId spawn() { return spawn(m_defaults); }
+
+    /**
+     * @brief Starts an instance with the given values, indexed like variableNames().
+     */
+    InstanceId spawn(std::vector<FsmValue> values);
+
+    /**
+     * @brief Sets a variable of an instance (same as SET_VARIABLE), a delay it is in is re-evaluated.
+     * @return False if there is no such instance or variable.
+     */
+    bool setVariable(InstanceId instance, const std::string& name, FsmValue value);
+
+    /**
+     * @brief Stops an instance, it ends Stopped unless it has ended already.
+     */
+    void stop(InstanceId instance);
+
+    /**
+     * @brief Stops all instances.
+     */
+    void stopAll();
+
+    /**
+     * @brief Waits until no instance runs.
+     * @return False if some still run after the timeout.
+     */
+    bool waitIdle(std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Last state entered by an instance, -1 if there is no such instance.
+     */
+    int32_t state(InstanceId instance) const;
+
+    FleetOutcome outcome(InstanceId instance) const;
+
+    /**
+     * @brief Transitions taken by an ended instance, 0 while it runs.
+     */
+    uint32_t steps(InstanceId instance) const;
+
+    const std::string& stateName(int32_t state) const { return m_states[state].name; }
+    const std::vector<std::string>& variableNames() const { return m_varNames; }
+    unsigned threadCount() const { return static_cast<unsigned>(m_workers.size()); }
+
+    /**
+     * @brief Instances spawned so far.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Instances that have not ended.
+     */
+    size_t running() const { return m_running.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Bytes an instance with the declared values takes, strings and pending commands aside.
+     */
+    size_t bytesPerInstance() const { return sizeof(Instance) + m_defaults.size() * sizeof(FsmValue); }
+
+private:
+    struct FleetTransition
+    {
+        int32_t target = -1;
+        int32_t delay = 0;
+        FsmExpression condition;
+    };
+
+    struct FleetState
+    {
+        std::string name;
+        bool isFinal = false;
+        FsmAction action;
+        std::vector<FleetTransition> transitions;
+    };
+
+    /// Where a suspended instance continues.
+    enum class Phase : uint8_t
+    {
+        Enter,     ///< run the action of the state
+        Select,    ///< take the first enabled transition
+        Delay,     ///< wait for the timer of the delay to target
+        Done
+    };
+
+    /// Events of Instance::flags, Scheduled is set while the task is queued or running.
+    enum : uint32_t
+    {
+        kScheduled = 1u << 0,
+        kWakeTimer = 1u << 1,
+        kWakeChanged = 1u << 2,
+        kWakeStop = 1u << 3,
+        kWakeStart = 1u << 4
+    };
+
+    /// One instance, the frame of its task.
+    struct Instance
+    {
+        std::atomic<uint32_t> flags{0};
+        std::atomic<int32_t> state{-1};
+        std::atomic<uint8_t> outcome{0};        ///< FleetOutcome
+        Phase phase = Phase::Enter;             ///< touched by the worker running the task only
+        bool virtualTime = false;
+        int32_t target = -1;                    ///< target of the transition whose delay runs
+        InstanceId id = 0;
+        uint32_t stepCount = 0;                 ///< transitions taken
+        std::atomic<uint32_t> steps{0};         ///< stepCount, published when the instance ends
+        TimerWheel::TimerId timer = 0;          ///< timer of the delay, 0 if none
+        int64_t timeMs = 0;                     ///< simulated time of a virtual time instance
+        std::vector<FsmValue> vars;             ///< by slot
+        std::vector<std::pair<int, FsmValue>> commands;  ///< variables to set, under the stripe of the id
+    };
+
+    /// Tasks of one worker, the worker takes the newest, thieves the oldest.
+    struct alignas(64) WorkerQueue
+    {
+        std::mutex mutex;
+        std::deque<Instance*> tasks;
+    };
+
+    /// Per worker buffers of the actions.
+    struct Scratch
+    {
+        std::vector<int> assigned;
+        std::vector<std::string> output;
+    };
+
+    static constexpr size_t kCommandStripes = 64;
+
+    void compile(const Automaton& automaton);
+
+    Instance* find(InstanceId instance) const;
+
+    /**
+     * @brief Sets the events and queues the task unless it is queued or running already.
+     */
+    void wake(Instance& instance, uint32_t events);
+
+    void push(Instance* instance);
+    Instance* pop(unsigned worker);
+
+    void workerMain(unsigned worker);
+
+    /**
+     * @brief Resumes the task until it waits or ends, again while events arrived meanwhile.
+     */
+    void resume(Instance& instance, Scratch& scratch);
+
+    /**
+     * @brief Runs the task for the events.
+     * @return True if the task used up its steps and has to be queued again.
+     */
+    bool step(Instance& instance, uint32_t events, Scratch& scratch);
+
+    void end(Instance& instance, FleetOutcome outcome);
+
+    /**
+     * @brief Cancels the timer of the delay, a late expiry is dropped with it.
+     */
+    void cancelTimer(Instance& instance);
+
+    std::vector<FleetState> m_states;
+    int32_t m_startState = -1;
+    std::vector<std::string> m_varNames;      ///< by slot
+    FsmSlotMap m_slots;
+    std::vector<FsmValue> m_defaults;         ///< declared initial values, by slot
+    Listener m_listener;
+    bool m_virtualTime = false;
+
+    mutable std::mutex m_instancesMutex;      ///< guards the container, not the instances
+    std::deque<Instance> m_instances;         ///< by id, never moved
+    std::array<std::mutex, kCommandStripes> m_commandMutexes;
+    std::atomic<size_t> m_running{0};
+    std::mutex m_idleMutex;
+    std::condition_variable m_idle;           ///< signalled when the last instance ends
+
+    std::vector<WorkerQueue> m_queues;
+    std::vector<std::thread> m_workers;
+    std::atomic<size_t> m_queued{0};          ///< tasks in all the queues
+    std::atomic<unsigned> m_sleepers{0};
+    std::atomic<unsigned> m_nextQueue{0};     ///< round robin of the wakes from other threads
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wakeWorker;
+    std::atomic<bool> m_closing{false};
+};
+
+#endif // FSM_FLEET_HPP
@@ -0,0 +1,130 @@
+/**
+ * @file fsm-number-ops.hpp
+ * @brief The int and float arithmetic of the expression language, shared by both backends.
+ *
+ * An int of the language is an int64_t that wraps around on overflow, with the floor
+ * division and modulo of Python. A float divides, raises to a power and prints like a
+ * Python float: the floor division and modulo are the ones of CPython, a power fails
+ * where Python raises and a float prints in the shortest form that reads back the same.
+ *
+ * The helpers are written once as macros: the interpreter expands FSM_INT_OPS and
+ * FSM_FLOAT_OPS, the compiled backend copies kFsmNumberOpsSource into the generated
+ * source, which includes nothing of the editor. Both places declare
+ * `[[noreturn]] void fail(const std::string&)` before the helpers and include <cmath>,
+ * <cstdio>, <cstdlib> and <string>.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#ifndef FSM_NUMBER_OPS_HPP
+#define FSM_NUMBER_OPS_HPP
+
+#define FSM_INT_OPS \
+inline int64_t i_add(int64_t x, int64_t y) { return static_cast<int64_t>(static_cast<uint64_t>(x) + static_cast<uint64_t>(y)); } \
+inline int64_t i_sub(int64_t x, int64_t y) { return static_cast<int64_t>(static_cast<uint64_t>(x) - static_cast<uint64_t>(y)); } \
+inline int64_t i_mul(int64_t x, int64_t y) { return static_cast<int64_t>(static_cast<uint64_t>(x) * static_cast<uint64_t>(y)); } \
+inline int64_t i_neg(int64_t x) { return static_cast<int64_t>(0u - static_cast<uint64_t>(x)); } \
+inline int64_t i_abs(int64_t x) { return x < 0 ? i_neg(x) : x; } \
+inline int64_t i_pow(int64_t base, int64_t exponent) \
+{ \
+    uint64_t result = 1, factor = static_cast<uint64_t>(base); \
+    for (uint64_t e = static_cast<uint64_t>(exponent); e > 0; e >>= 1) { \
+        if (e & 1) \
+            result *= factor; \
+        factor *= factor; \
+    } \
+    return static_cast<int64_t>(result); \
+} \
+inline int64_t i_floordiv(int64_t x, int64_t y) \
+{ \
+    if (y == 0) fail("integer division or modulo by zero"); \
+    if (y == -1) return i_neg(x); \
+    int64_t q = x / y; \
+    if ((x % y != 0) && ((x < 0) != (y < 0))) q--; \
+    return q; \
+} \
+inline int64_t i_mod(int64_t x, int64_t y) \
+{ \
+    if (y == 0) fail("integer division or modulo by zero"); \
+    if (y == -1) return 0; \
+    int64_t r = x % y; \
+    if (r != 0 && ((r < 0) != (y < 0))) r += y; \
+    return r; \
+}
+
+#define FSM_FLOAT_OPS \
+inline double f_floordiv(double x, double y) \
+{ \
+    if (y == 0.0) fail("float floor division by zero"); \
+    double mod = std::fmod(x, y); \
+    double div = (x - mod) / y; \
+    if (mod != 0.0 && ((y < 0.0) != (mod < 0.0))) \
+        div -= 1.0; \
+    if (div == 0.0) \
+        return std::copysign(0.0, x / y); \
+    double floordiv = std::floor(div); \
+    if (div - floordiv > 0.5) \
+        floordiv += 1.0; \
+    return floordiv; \
+} \
+inline double f_mod(double x, double y) \
+{ \
+    if (y == 0.0) fail("float modulo"); \
+    double mod = std::fmod(x, y); \
+    if (mod == 0.0) \
+        return std::copysign(0.0, y); \
+    if ((y < 0.0) != (mod < 0.0)) \
+        mod += y; \
+    return mod; \
+} \
+inline double f_pow(double x, double y) \
+{ \
+    if (x == 0.0 && y < 0.0) fail("0.0 cannot be raised to a negative power"); \
+    double result = std::pow(x, y); \
+    if (std::isinf(result) && std::isfinite(x) && std::isfinite(y)) \
+        fail("(34, 'Numerical result out of range')"); \
+    return result; \
+} \
+inline std::string f_to_str(double x) \
+{ \
+    if (std::isnan(x)) return "nan"; \
+    if (std::isinf(x)) return x < 0.0 ? "-inf" : "inf"; \
+    char text[32]; \
+    for (int precision = 0; precision <= 16; ++precision) { \
+        std::snprintf(text, sizeof(text), "%.*e", precision, x); \
+        if (std::strtod(text, nullptr) == x) \
+            break; \
+    } \
+    std::string digits; \
+    const char* c = text + (text[0] == '-' ? 1 : 0); \
+    for (; *c != 'e'; ++c) \
+        if (*c != '.') digits += *c; \
+    const int exponent = std::atoi(c + 1); \
+    while (digits.size() > 1 && digits.back() == '0') \
+        digits.pop_back(); \
+    std::string s = text[0] == '-' ? "-" : ""; \
+    if (exponent < -4 || exponent >= 16) { \
+        s += digits.substr(0, 1); \
+        if (digits.size() > 1) s += "." + digits.substr(1); \
+        s += exponent < 0 ? "e-" : "e+"; \
+        const int magnitude = exponent < 0 ? -exponent : exponent; \
+        if (magnitude < 10) s += "0"; \
+        s += std::to_string(magnitude); \
+    } else if (exponent < 0) { \
+        s += "0." + std::string(static_cast<size_t>(-exponent - 1), '0') + digits; \
+    } else if (static_cast<size_t>(exponent) + 1 >= digits.size()) { \
+        s += digits + std::string(static_cast<size_t>(exponent) + 1 - digits.size(), '0') + ".0"; \
+    } else { \
+        s += digits.substr(0, static_cast<size_t>(exponent) + 1) + "." + digits.substr(static_cast<size_t>(exponent) + 1); \
+    } \
+    return s; \
+}
+
+#define FSM_NUMBER_OPS_STRINGIFY_(...) #__VA_ARGS__
+#define FSM_NUMBER_OPS_STRINGIFY(...) FSM_NUMBER_OPS_STRINGIFY_(__VA_ARGS__)
+
+/// FSM_INT_OPS and FSM_FLOAT_OPS as source text, on one line
+constexpr const char* kFsmNumberOpsSource = FSM_NUMBER_OPS_STRINGIFY(FSM_INT_OPS FSM_FLOAT_OPS);
+
+#endif // FSM_NUMBER_OPS_HPP
@@ -0,0 +1,253 @@
+/**
+ * @file timer-wheel.cpp
+ * @brief Implementation of the TimerWheel class.
+ *
+ * Slots are indexed by the absolute expiry bits, the slot of level k holding a timer is
+ * due when the current tick enters its range (the lower 6k bits are zero). All timers of
+ * a due slot are placed again relative to the new tick: they move down a level or, on
+ * level 0, into the expired list. Because every occupied slot lies after the current
+ * tick, the next tick with work is found from the lowest occupancy bit of each level and
+ * the wheel jumps there directly instead of stepping through idle ticks.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#include "timer-wheel.hpp"
+
+#include <algorithm>
+
+TimerWheel::TimerWheel()
+    : m_epoch(std::chrono::steady_clock::now())
+{
+    std::fill(std::begin(m_heads), std::end(m_heads), kNil);
+    m_thread = std::thread(&TimerWheel::run, this);
+}
+
+TimerWheel::~TimerWheel()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wakeUp.notify_all();
+    if (m_thread.joinable())
+        m_thread.join();
+}
+
+TimerWheel& TimerWheel::shared()
+{
+    static TimerWheel wheel;
+    return wheel;
+}
+
+/**
+ *    TIMERS
+ *  ===========================================================================
+ */
+
+TimerWheel::TimerId TimerWheel::schedule(std::chrono::milliseconds delay, Callback callback)
+{
+    const auto elapsed = std::chrono::steady_clock::now() - m_epoch + std::max(delay, std::chrono::milliseconds(0));
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    int32_t index = m_free;
+    if (index != kNil) {
+        m_free = m_nodes[index].next;
+    } else {
+        index = static_cast<int32_t>(m_nodes.size());
+        m_nodes.emplace_back();
+    }
+
+    Node& node = m_nodes[index];
+    node.expiry = tickAfter(elapsed);
+    node.callback = std::move(callback);
+    node.state = NodeState::Pending;
+    place(index);
+    m_pending++;
+
+    // the timer thread sleeps past the new expiry
+    if (node.list == kExpiredList || node.expiry < m_wakeTick)
+        m_wakeUp.notify_one();
+
+    return (static_cast<TimerId>(node.generation) << 32) | static_cast<uint32_t>(index + 1);
+}
+
+bool TimerWheel::cancel(TimerId id)
+{
+    const uint32_t generation = static_cast<uint32_t>(id >> 32);
+    const int64_t index = static_cast<int64_t>(id & 0xffffffffu) - 1;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (index < 0 || index >= static_cast<int64_t>(m_nodes.size()) || m_nodes[index].generation != generation)
+        return false; // already fired or cancelled
+
+    Node& node = m_nodes[index];
+    if (node.state == NodeState::Pending || node.state == NodeState::Expired) {
+        unlink(static_cast<int32_t>(index));
+        releaseNode(static_cast<int32_t>(index));
+        m_pending--;
+        return true;
+    }
+
+    if (node.state == NodeState::Firing && std::this_thread::get_id() != m_thread.get_id()) {
+        m_fired.wait(lock, [&] {
+            return m_nodes[index].generation != generation;
+        });
+    }
+    return false;
+}
+
+size_t TimerWheel::pendingCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_pending;
+}
+
+/**
+ *    WHEEL
+ *  ===========================================================================
+ */
+
+uint64_t TimerWheel::tickAfter(std::chrono::steady_clock::duration elapsed) const
+{
+    const auto ms = std::chrono::ceil<std::chrono::milliseconds>(elapsed).count();
+    return static_cast<uint64_t>(std::max<int64_t>(ms, 0));
+}
+
+void TimerWheel::link(int32_t index, int32_t list)
+{
+    Node& node = m_nodes[index];
+    node.list = list;
+    node.prev = kNil;
+    node.next = m_heads[list];
+    if (node.next != kNil)
+        m_nodes[node.next].prev = index;
+    m_heads[list] = index;
+
+    if (list != kExpiredList)
+        m_occupied[list / kSlots] |= uint64_t(1) << (list % kSlots);
+}
+
+void TimerWheel::unlink(int32_t index)
+{
+    Node& node = m_nodes[index];
+    if (node.prev != kNil)
+        m_nodes[node.prev].next = node.next;
+    else
+        m_heads[node.list] = node.next;
+    if (node.next != kNil)
+        m_nodes[node.next].prev = node.prev;
+
+    if (node.list != kExpiredList && m_heads[node.list] == kNil)
+        m_occupied[node.list / kSlots] &= ~(uint64_t(1) << (node.list % kSlots));
+    node.list = kNil;
+}
+
+void TimerWheel::place(int32_t index)
+{
+    Node& node = m_nodes[index];
+    if (node.expiry <= m_now) {
+        node.state = NodeState::Expired;
+        link(index, kExpiredList);
+        return;
+    }
+
+    // the highest 6 bit group in which the expiry differs from the current tick
+    const int highestBit = 63 - __builtin_clzll(node.expiry ^ m_now);
+    const int level = highestBit / kLevelBits;
+    const int slot = static_cast<int>((node.expiry >> (level * kLevelBits)) & (kSlots - 1));
+    link(index, level * kSlots + slot);
+}
+
+uint64_t TimerWheel::nextEventTick() const
+{
+    uint64_t next = kNoTick;
+    for (int level = 0; level < kLevels; ++level) {
+        if (!m_occupied[level])
+            continue;
+        // the slot range starts inside the current range of the level above
+        const int blockShift = (level + 1) * kLevelBits;
+        const uint64_t block = blockShift >= 64 ? 0 : (m_now >> blockShift) << blockShift;
+        const uint64_t slot = static_cast<uint64_t>(__builtin_ctzll(m_occupied[level]));
+        next = std::min(next, block | (slot << (level * kLevelBits)));
+    }
+    return next;
+}
+
+void TimerWheel::advance(uint64_t target)
+{
+    while (true) {
+        const uint64_t next = nextEventTick();
+        if (next > target) {
+            m_now = std::max(m_now, target);
+            return;
+        }
+        m_now = next;
+
+        // from the top, a cascaded timer may land in a lower slot due at the same tick
+        for (int level = kLevels - 1; level >= 0; --level) {
+            const int shift = level * kLevelBits;
+            if (shift && (m_now & ((uint64_t(1) << shift) - 1)))
+                continue;
+            const int slot = static_cast<int>((m_now >> shift) & (kSlots - 1));
+            if (!(m_occupied[level] & (uint64_t(1) << slot)))
+                continue;
+
+            const int32_t list = level * kSlots + slot;
+            int32_t index = m_heads[list];
+            m_heads[list] = kNil;
+            m_occupied[level] &= ~(uint64_t(1) << slot);
+            while (index != kNil) {
+                const int32_t next = m_nodes[index].next;
+                place(index);
+                index = next;
+            }
+        }
+    }
+}
+
+void TimerWheel::releaseNode(int32_t index)
+{
+    Node& node = m_nodes[index];
+    node.callback = nullptr;
+    node.generation++;
+    node.state = NodeState::Free;
+    node.next = m_free;
+    m_free = index;
+}
+
+void TimerWheel::run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stop) {
+        m_wakeTick = 0; // awake, schedule() does not need to notify
+        const auto elapsed = std::chrono::steady_clock::now() - m_epoch;
+        advance(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count()));
+
+        while (!m_stop && m_heads[kExpiredList] != kNil) {
+            const int32_t index = m_heads[kExpiredList];
+            unlink(index);
+            m_pending--;
+
+            Node& node = m_nodes[index];
+            node.state = NodeState::Firing;
+            Callback callback = std::move(node.callback);
+
+            lock.unlock();
+            callback();
+            lock.lock();
+
+            releaseNode(index);
+            m_fired.notify_all();
+        }
+        if (m_stop)
+            break;
+
+        m_wakeTick = nextEventTick();
+        if (m_wakeTick == kNoTick)
+            m_wakeUp.wait(lock);
+        else
+            m_wakeUp.wait_until(lock, m_epoch + std::chrono::milliseconds(m_wakeTick));
+    }
+}
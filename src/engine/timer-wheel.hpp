@@ -0,0 +1,165 @@
+/**
+ * @file timer-wheel.hpp
+ * @brief Declaration of the TimerWheel class, a hierarchical timer wheel for transition delays.
+ *
+ * The wheel has 11 levels of 64 slots, a slot of level k covers 64^k milliseconds, so
+ * the levels cover the whole 64 bit tick range. A timer is linked into the slot of the
+ * highest 6 bit group in which its expiry differs from the current tick; when the wheel
+ * reaches that slot the timer moves down a level, on level 0 it expires. Insert and
+ * cancel are O(1), the timers are intrusive lists in a node pool.
+ *
+ * One thread serves all timers of the wheel. It sleeps until the next tick with work
+ * (an expiry or a cascade), found from the slot occupancy masks, and not at all while
+ * no timer is pending.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#ifndef TIMER_WHEEL_HPP
+#define TIMER_WHEEL_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @class TimerWheel
+ * @brief Runs callbacks after a delay with millisecond precision on one timer thread.
+ */
+class TimerWheel
+{
+public:
+    /// Handle of a scheduled timer, 0 is never a valid timer.
+    using TimerId = uint64_t;
+    using Callback = std::function<void()>;
+
+    TimerWheel();
+
+    /**
+     * @brief Destructor, drops the pending timers and joins the timer thread.
+     */
+    ~TimerWheel();
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    /**
+     * @brief The wheel shared by all FSM engines of the process.
+     */
+    static TimerWheel& shared();
+
+    /**
+     * @brief Schedules a callback.
+     *
+     * The callback runs on the timer thread no earlier than @p delay from now, usually
+     * within a millisecond after it. It should only hand the expiry to its owner.
+     *
+     * @param delay Delay before the callback runs.
+     * @param callback The callback.
+     * @return Handle for cancel().
+     */
+    TimerId schedule(std::chrono::milliseconds delay, Callback callback);
+
+    /**
+     * @brief Cancels a timer.
+     *
+     * If the callback is running on the timer thread, waits until it returns (unless
+     * called from the callback itself), so the callback never runs after cancel().
+     * The caller must not hold a lock the callback takes.
+     *
+     * @param id Handle returned by schedule().
+     * @return True if the timer was pending and will not run.
+     */
+    bool cancel(TimerId id);
+
+    /**
+     * @brief Number of timers waiting to expire.
+     */
+    size_t pendingCount() const;
+
+private:
+    static constexpr int kLevelBits = 6;
+    static constexpr int kSlots = 1 << kLevelBits;
+    static constexpr int kLevels = 11;
+    static constexpr uint64_t kNoTick = UINT64_MAX;
+    static constexpr int32_t kNil = -1;
+
+    /// Where a node is linked.
+    enum class NodeState : uint8_t
+    {
+        Free,     ///< In the free list.
+        Pending,  ///< In a wheel slot.
+        Expired,  ///< In the expired list, the callback runs next.
+        Firing    ///< The callback is running.
+    };
+
+    /// Timer node, linked into a slot list by indices into m_nodes.
+    struct Node
+    {
+        uint64_t expiry = 0;      ///< Tick (milliseconds since m_epoch) the timer expires at.
+        Callback callback;
+        int32_t prev = kNil;
+        int32_t next = kNil;
+        int32_t list = kNil;      ///< Index of the list head in m_heads.
+        uint32_t generation = 0;  ///< Incremented when the node is reused, part of the TimerId.
+        NodeState state = NodeState::Free;
+    };
+
+    /// Index of the expired list in m_heads, after the wheel slots.
+    static constexpr int32_t kExpiredList = kLevels * kSlots;
+
+    /**
+     * @brief Milliseconds since m_epoch, rounded up.
+     */
+    uint64_t tickAfter(std::chrono::steady_clock::duration elapsed) const;
+
+    void link(int32_t node, int32_t list);
+    void unlink(int32_t node);
+
+    /**
+     * @brief Links a pending node into its slot relative to m_now, or into the expired
+     *        list if it is due.
+     */
+    void place(int32_t node);
+
+    /**
+     * @brief First tick after m_now that expires or cascades a slot, kNoTick if none.
+     */
+    uint64_t nextEventTick() const;
+
+    /**
+     * @brief Advances m_now to @p target, moving the due timers to the expired list.
+     */
+    void advance(uint64_t target);
+
+    void releaseNode(int32_t node);
+
+    /**
+     * @brief Timer thread main loop.
+     */
+    void run();
+
+    const std::chrono::steady_clock::time_point m_epoch;  ///< Tick 0.
+
+    mutable std::mutex m_mutex;          ///< Guards everything below.
+    std::condition_variable m_wakeUp;    ///< Wakes the timer thread.
+    std::condition_variable m_fired;     ///< Signalled when a callback returns.
+
+    std::vector<Node> m_nodes;           ///< Node pool.
+    int32_t m_free = kNil;               ///< Head of the free node list (linked by next).
+    int32_t m_heads[kLevels * kSlots + 1]; ///< Heads of the slot lists and of the expired list.
+    uint64_t m_occupied[kLevels] = {};   ///< Per level a bit for every non-empty slot.
+    uint64_t m_now = 0;                  ///< Last processed tick.
+    uint64_t m_wakeTick = kNoTick;       ///< Tick the timer thread sleeps until.
+    size_t m_pending = 0;                ///< Number of pending timers.
+    bool m_stop = false;
+
+    std::thread m_thread;                ///< The timer thread, started last.
+};
+
+#endif // TIMER_WHEEL_HPP
@@ -0,0 +1,39 @@
+/**
+ * @file variable-store.cpp
+ * @brief Implementation of the VariableStore class.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#include "variable-store.hpp"
+
+VariableStore::VariableStore()
+    : m_current(std::make_shared<const Snapshot>())
+{
+}
+
+void VariableStore::reset(std::vector<FsmValue> values)
+{
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    publish(std::move(values));
+}
+
+bool VariableStore::set(int slot, FsmValue value)
+{
+    return update([&](std::vector<FsmValue>& values) {
+        FsmValue& current = values[slot];
+        if (current == value)
+            return false;
+        current = std::move(value);
+        return true;
+    });
+}
+
+void VariableStore::publish(std::vector<FsmValue> values)
+{
+    auto next = std::make_shared<Snapshot>();
+    next->version = std::atomic_load(&m_current)->version + 1;
+    next->values = std::move(values);
+    std::atomic_store(&m_current, SnapshotPtr(std::move(next)));
+}
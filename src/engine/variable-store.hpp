@@ -0,0 +1,96 @@
+/**
+ * @file variable-store.hpp
+ * @brief Declaration of the VariableStore class, versioned copy-on-write variable slots.
+ *
+ * The values are published as immutable snapshots. A reader takes the current snapshot
+ * (an atomic shared_ptr load) and evaluates on it as long as it likes without a lock and
+ * without copying. A writer copies the slots of the current snapshot, modifies the copy
+ * and publishes it with the next version number; writers are serialized by a mutex,
+ * readers never wait for it.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#ifndef VARIABLE_STORE_HPP
+#define VARIABLE_STORE_HPP
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "fsm-expression.hpp"
+
+/**
+ * @class VariableStore
+ * @brief Variable slots of a running automaton, read through snapshots.
+ */
+class VariableStore
+{
+public:
+    /// One published version of the slots, never modified after publishing.
+    struct Snapshot
+    {
+        uint64_t version = 0;
+        std::vector<FsmValue> values;  ///< Indexed by slot.
+    };
+
+    using SnapshotPtr = std::shared_ptr<const Snapshot>;
+
+    VariableStore();
+
+    /**
+     * @brief Replaces all slots, the version number continues.
+     */
+    void reset(std::vector<FsmValue> values);
+
+    /**
+     * @brief The current snapshot, does not block.
+     */
+    SnapshotPtr snapshot() const { return std::atomic_load(&m_current); }
+
+    /**
+     * @brief Version of the current snapshot, incremented by every published write.
+     */
+    uint64_t version() const { return snapshot()->version; }
+
+    /**
+     * @brief Modifies a copy of the current slots and publishes it.
+     *
+     * @param modify Called with the copy under the writer mutex, returns false if it
+     *               changed nothing (the copy is dropped then). May throw, nothing is
+     *               published then.
+     * @return True if a new version was published.
+     */
+    template<typename Modify>
+    bool update(Modify modify);
+
+    /**
+     * @brief Sets one slot.
+     * @return False if the slot already had the value.
+     */
+    bool set(int slot, FsmValue value);
+
+private:
+    /**
+     * @brief Publishes the slots as the next version, m_writeMutex is held.
+     */
+    void publish(std::vector<FsmValue> values);
+
+    std::mutex m_writeMutex;  ///< Serializes the writers.
+    SnapshotPtr m_current;    ///< Accessed with the atomic shared_ptr functions only.
+};
+
+template<typename Modify>
+bool VariableStore::update(Modify modify)
+{
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    std::vector<FsmValue> values = std::atomic_load(&m_current)->values;
+    if (!modify(values))
+        return false;
+    publish(std::move(values));
+    return true;
+}
+
+#endif // VARIABLE_STORE_HPP
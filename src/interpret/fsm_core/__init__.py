@@ -1 +1 @@
-from .fsm_core import State, Transition, FSM
\ No newline at end of file
+from .fsm_core import State, Transition, FSM, RealClock, VirtualClock, LazyFunctions
@@ -0,0 +1,224 @@
+"""
+Long-lived FSM runtime reused across runs.
+
+The editor starts the daemon once per session and keeps one connection to it. Every Run
+sends a LOAD_AUTOMATON message with the generated script; the daemon stops the running
+FSM, builds the new one with the script's build_fsm() and runs it on a worker thread.
+The FSM sends its messages on the editor connection, SET_VARIABLE, STOP_FSM and
+RELOAD_FUNCTIONS are forwarded to the FSM that is currently running.
+
+GET_STATS is answered for the current (or last) FSM. With --metrics-port the daemon
+also serves its statistics as Prometheus text on http://HOST:PORT/metrics, so unattended
+runs can be scraped without the editor.
+
+An editor monitoring many automata asks for a multiplexed connection with SET_MULTIPLEX;
+the daemon then runs one automaton per instance of the connection, see mux.py.
+
+The daemon listens on --endpoint (`tcp://host:port` or `unix:/path`, default $FSM_ENDPOINT),
+on --host and --port without one.
+
+Usage: python -m fsm_core.daemon [--endpoint URI] [--host HOST] [--port PORT] [--metrics-port PORT]
+"""
+
+import argparse
+import logging
+import os
+import socket
+import threading
+
+from .fsm_core import FSM
+from .stats import RuntimeStats, start_metrics_server
+from .wire import Channel, EncodeError, listen, remove_socket_file
+
+
+class RuntimeDaemon:
+    def __init__(self, host='localhost', port=0, endpoint=None):
+        self.host = host
+        self.port = port
+        self.endpoint = endpoint
+        self._client_socket = None
+        self._channel = None
+        self._fsm = None
+        self._fsm_thread = None
+        self._shutdown = False
+        self._idle_stats = RuntimeStats() # reported before the first automaton is loaded
+        self._instances = None # mux.InstanceTable of a multiplexed connection
+
+    def stats_payload(self):
+        """STATS of the current or last FSM, with the counters of the editor connection."""
+        fsm = self._fsm
+        if fsm is not None:
+            return fsm.stats.snapshot(self._channel)
+        return self._idle_stats.snapshot(self._channel)
+
+    def serve(self):
+        """Accepts editor connections one after another until SHUTDOWN is received."""
+        server_socket, self.endpoint, socket_file = listen(self.endpoint, self.host, self.port)
+        print(f"READY {self.endpoint}", flush=True) # the editor connects once it reads the endpoint
+        logging.info(f"FSM runtime daemon listening on {self.endpoint}")
+        print(f"FSM runtime daemon: Waiting for a client connection on {self.endpoint}...", flush=True)
+
+        try:
+            while not self._shutdown:
+                conn, addr = server_socket.accept()
+                logging.info(f"Client connected from {addr}")
+                self._client_socket = conn
+                self._channel = Channel(conn)
+                hello = self._channel.hello_payload("Connected to the FSM runtime daemon.")
+                hello["multiplex"] = True
+                self._send("FSM_CONNECTED", hello)
+                self._serve_client()
+                self._stop_fsm()
+                if self._instances is not None:
+                    self._instances.close()
+                    self._instances = None
+                self._channel.close()
+                self._client_socket = None
+                self._channel = None
+                try:
+                    conn.close()
+                except socket.error:
+                    pass
+        finally:
+            server_socket.close()
+            remove_socket_file(socket_file)
+            logging.info("FSM runtime daemon has shut down.")
+
+    def _send(self, message_type, payload=None):
+        try:
+            self._channel.send(message_type, payload)
+        except EncodeError as e:
+            logging.error(f"{message_type} is not sent: {e}")
+        except (socket.error, AttributeError) as e:
+            logging.error(f"Error sending message to client: {e}")
+
+    def _serve_client(self):
+        # the timeout lets the loop push the statistics of the running FSM
+        self._client_socket.settimeout(0.5)
+        while not self._shutdown:
+            if self._fsm:
+                self._fsm.push_stats()
+            if self._instances is not None:
+                self._instances.push_stats()
+            try:
+                data = self._client_socket.recv(65536)
+            except socket.timeout:
+                data = None # the shared memory ring is checked for a missed doorbell
+            except socket.error as e:
+                logging.error(f"Socket error: {e}")
+                return
+            if data == b"":
+                logging.info("Client disconnected.")
+                return
+
+            for message in self._channel.feed(data or b""):
+                self._dispatch(message)
+
+    def _dispatch(self, message):
+        message_type = message.get("type")
+        payload = message.get("payload", {}) or {}
+
+        # CREDIT is for the instances of the connection, the other messages name theirs
+        if "instance" in message or message_type == "CREDIT":
+            if self._instances is None:
+                logging.warning(f"{message_type} on a connection that is not multiplexed is dropped.")
+            else:
+                self._instances.dispatch(message)
+            return
+
+        if message_type == "SET_MULTIPLEX":
+            self._multiplex(payload)
+        elif message_type == "LOAD_AUTOMATON":
+            self._load(payload.get("code", ""))
+        elif message_type == "SET_VARIABLE":
+            if self._fsm and payload.get("name") is not None:
+                self._fsm.set_variable(payload.get("name"), payload.get("value"))
+        elif message_type == "SET_VARIABLES":
+            if self._fsm:
+                self._fsm.set_variables(payload.get("variables") or {})
+        elif message_type == "STOP_FSM":
+            logging.info("Received STOP_FSM command from client.")
+            if self._fsm:
+                self._fsm.stop()
+        elif message_type == "GET_STATS":
+            if self._fsm:
+                self._fsm.handle_get_stats(payload)
+            else:
+                self._send("STATS", self.stats_payload())
+        elif message_type == "RELOAD_FUNCTIONS":
+            if self._fsm:
+                self._fsm.handle_reload_functions(payload)
+            else:
+                self._send("FUNCTIONS_RELOADED", {"functions": [], "error": "No automaton is loaded."})
+        elif message_type == "SHUTDOWN":
+            logging.info("Received SHUTDOWN command from client.")
+            self._shutdown = True
+            self._stop_fsm()
+        else:
+            logging.warning(f"Unknown message type: {message_type}")
+
+    def _multiplex(self, payload):
+        """Runs the automata of the instances from now on, the FSM of the connection stays."""
+        from .mux import DEFAULT_WINDOW, BATCH_INTERVAL, InstanceTable # mux builds on this module
+
+        if self._instances is None:
+            self._instances = InstanceTable(self._channel, payload.get("window") or DEFAULT_WINDOW)
+            logging.info(f"Connection multiplexed, window of {self._instances.mux.window} messages.")
+        self._send("MULTIPLEX_SET", {"window": self._instances.mux.window, "batch_ms": BATCH_INTERVAL * 1000})
+
+    def _stop_fsm(self):
+        if self._fsm:
+            self._fsm.stop()
+        if self._fsm_thread and self._fsm_thread.is_alive():
+            self._fsm_thread.join(timeout=5.0)
+        self._fsm = None
+        self._fsm_thread = None
+
+    def _load(self, code):
+        """Replaces the running FSM by the one built by the script."""
+        self._stop_fsm()
+
+        # the script runs as a module, its main block is skipped
+        namespace = {"__name__": "fsm_program"}
+        try:
+            exec(compile(code, "<automaton>", "exec"), namespace)
+            fsm = namespace["build_fsm"]()
+            if not isinstance(fsm, FSM):
+                raise TypeError("build_fsm() did not return an FSM")
+        except Exception as e:
+            logging.error(f"Failed to load automaton: {e}")
+            self._send("FSM_ERROR", {"message": f"Failed to load automaton: {e}"})
+            return
+
+        # the initial values were set before the client was attached, send them now
+        fsm.attach_client(self._channel)
+        if fsm.variable_batch_interval is None:
+            for name, value in list(fsm.variables.items()):
+                self._send("VARIABLE_UPDATE", {"name": name, "value": value})
+        else:
+            fsm._flush_variables(force=True)
+
+        self._send("AUTOMATON_LOADED", {"states": len(fsm._table[0]) if fsm._table else len(fsm.states)})
+        self._fsm = fsm
+        self._fsm_thread = threading.Thread(target=fsm.run, daemon=True)
+        self._fsm_thread.start()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Long-lived FSM runtime.")
+    parser.add_argument("--endpoint", default=os.environ.get("FSM_ENDPOINT"),
+                        help="tcp://host:port or unix:/path (default: $FSM_ENDPOINT, else --host and --port)")
+    parser.add_argument("--host", default="localhost")
+    parser.add_argument("--port", type=int, default=0, help="0 lets the OS pick a free port")
+    parser.add_argument("--metrics-port", type=int, default=os.environ.get("FSM_METRICS_PORT"),
+                        help="serve Prometheus metrics on this port (default: $FSM_METRICS_PORT, off if unset)")
+    args = parser.parse_args()
+
+    daemon = RuntimeDaemon(args.host, args.port, args.endpoint)
+    if args.metrics_port is not None:
+        start_metrics_server(int(args.metrics_port), daemon.stats_payload, args.host)
+    daemon.serve()
+
+
+if __name__ == "__main__":
+    main()
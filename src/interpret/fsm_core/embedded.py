@@ -0,0 +1,103 @@
+"""
+FSM runtime embedded in the editor process.
+
+The editor links the Python interpreter in, imports this module once per session and
+opens one EmbeddedRuntime per run. A runtime accepts the same commands as the daemon
+(LOAD_AUTOMATON, SET_VARIABLE, STOP_FSM, ...), handed over as dicts by the interpreter
+thread of the editor; the FSM runs on its own thread and every message it sends is
+passed to the builtin _icp.post() as the dict itself. Nothing is encoded, no process is
+started and no socket is opened.
+
+The module is imported by the editor only, _icp does not exist in a standalone Python.
+"""
+
+import logging
+
+from .daemon import RuntimeDaemon
+
+try:
+    import _icp
+except ImportError: # imported outside the editor, open() fails
+    _icp = None
+
+
+class LocalChannel:
+    """The part of wire.Channel the FSM and the daemon use, posting to the editor."""
+
+    def __init__(self, run_id, post):
+        self.run_id = run_id
+        self.sock = self # the FSM sends only while it has a client socket
+        self.messages_sent = 0
+        self.messages_received = 0
+        self._post = post
+
+    def send(self, message_type, payload=None):
+        self._post(self.run_id, message_type, payload if payload is not None else {})
+        self.messages_sent += 1
+
+    def hello_payload(self, message):
+        """Payload of FSM_CONNECTED, there is nothing to negotiate in process."""
+        return {"message": message, "encodings": [], "transports": ["embedded"]}
+
+    def send_queue_bytes(self):
+        return 0 # posted messages are queued by the editor, not here
+
+    def close(self):
+        pass
+
+
+class EmbeddedRuntime(RuntimeDaemon):
+    """A daemon without the connection: commands come from dispatch(), messages go to the channel."""
+
+    def __init__(self, run_id, post):
+        super().__init__()
+        self._channel = LocalChannel(run_id, post)
+
+    def dispatch(self, message_type, payload):
+        self._channel.messages_received += 1
+        self._dispatch({"type": message_type, "payload": payload})
+
+    def push_stats(self):
+        if self._fsm:
+            self._fsm.push_stats()
+
+    def close(self):
+        self._stop_fsm()
+
+
+_runtimes = {}
+
+
+def open(run_id):
+    """Creates the runtime of a run, it sends FSM_CONNECTED like the daemon does."""
+    if _icp is None:
+        raise RuntimeError("fsm_core.embedded is imported outside the editor")
+    runtime = EmbeddedRuntime(run_id, _icp.post)
+    _runtimes[run_id] = runtime
+    runtime._send("FSM_CONNECTED", runtime._channel.hello_payload("Connected to the embedded FSM runtime."))
+
+
+def dispatch(run_id, message_type, payload):
+    runtime = _runtimes.get(run_id)
+    if runtime is None:
+        logging.warning(f"No embedded runtime for run {run_id}, {message_type} is dropped.")
+        return
+    runtime.dispatch(message_type, payload)
+
+
+def close(run_id):
+    """Stops the FSM of the run and forgets its runtime."""
+    runtime = _runtimes.pop(run_id, None)
+    if runtime is not None:
+        runtime.close()
+
+
+def push_stats():
+    """Sends the periodic STATS of all runtimes, called while the editor has no commands."""
+    for runtime in list(_runtimes.values()):
+        runtime.push_stats()
+
+
+def shutdown():
+    for run_id in list(_runtimes):
+        close(run_id)
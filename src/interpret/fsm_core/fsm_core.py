@@ -1,12 +1,112 @@
 import time
 import socket
 import json
+import os
 import threading
 import logging
+import types
+
+from .stats import RuntimeStats
+from .wire import Channel, EncodeError, listen, remove_socket_file
 
 # Configure basic logging
 logging.basicConfig(level=logging.INFO, format='%(asctime)s - %(levelname)s - FSM - %(message)s')
 
+_MISSING = object() # marks a variable that was never set
+
+def _union_reads(reads):
+    """Union of condition read-sets, None (any variable) if one of them is None."""
+    union = frozenset()
+    for r in reads:
+        if r is None:
+            return None
+        union |= r
+    return union
+
+class RealClock:
+    """Wall-clock time, delays really wait."""
+
+    def now(self):
+        return time.monotonic()
+
+    def wait(self, event, seconds):
+        """Waits for the delay, returns True if the event was set during it."""
+        return event.wait(timeout=seconds)
+
+class VirtualClock:
+    """
+    Simulated time for fast regression runs: a delay advances the clock at once, so the
+    FSM runs as fast as the CPU allows and takes the same steps as in real time.
+    """
+
+    def __init__(self, start=0.0):
+        self._now = start
+
+    def now(self):
+        return self._now
+
+    def wait(self, event, seconds):
+        if event.is_set():
+            return True
+        self._now += max(0.0, seconds)
+        return False
+
+def _lazy_stub(fsm, variables, _lazy_name=None, _lazy_functions=None):
+    """Code of a function that has not been compiled yet, see LazyFunctions."""
+    return _lazy_functions.materialize(_lazy_name)(fsm, variables)
+
+class LazyFunctions:
+    """
+    Generated functions that are compiled when first called.
+
+    A script generated with lazy functions defines its actions and conditions as source
+    strings. Every function is a stub in the namespace of the script that compiles its
+    source at the first call and takes over the compiled code, so the same function object
+    is called from then on. The FSM, the state table and RELOAD_FUNCTIONS see plain
+    functions with the generated names, and a large automaton starts without compiling the
+    functions a run never reaches.
+    """
+
+    def __init__(self, namespace, functions):
+        """
+        Defines a stub for every function in the namespace.
+
+        Args:
+            namespace (dict): Globals of the script, the functions are compiled in them.
+            functions (tuple): (name, source) of an action, (name, source, reads) of a condition.
+        """
+        self._namespace = namespace
+        self._sources = {}
+        self._stubs = {}
+        self._lock = threading.Lock()
+        for entry in functions:
+            name, source = entry[0], entry[1]
+            code = _lazy_stub.__code__.replace(co_name=name)
+            stub = types.FunctionType(code, namespace, name, (name, self))
+            if len(entry) > 2:
+                stub.reads = entry[2]
+            self._sources[name] = source
+            self._stubs[name] = stub
+            namespace[name] = stub
+
+    def materialize(self, name):
+        """Compiles the function if it has not been compiled yet, returns it."""
+        with self._lock:
+            stub = self._stubs[name]
+            source = self._sources.pop(name, None)
+            if source is not None:
+                scope = {}
+                exec(compile(source, f"<{name}>", "exec"), self._namespace, scope)
+                compiled = scope[name]
+                stub.__code__ = compiled.__code__
+                stub.__defaults__ = compiled.__defaults__
+            return stub
+
+    def pending(self):
+        """Number of functions not compiled yet."""
+        with self._lock:
+            return len(self._sources)
+
 class Transition:
     def __init__(self, target_state_name, condition=None, action=None, delay=0.0):
         """
@@ -22,10 +122,18 @@ class Transition:
             delay (float, optional): Time in miliseconds to wait before completing the transition.
 
                                      Defaults to 0.0.
+
+        The `reads` attribute of the condition (set by the generator) is the frozenset of
+        variables it depends on; without it the condition may depend on any variable.
         """
         self.target_state_name = target_state_name
         # Condition now expects (fsm_instance, variables_dict)
-        self.condition = condition if callable(condition) else lambda _fsm, _variables: True
+        if callable(condition):
+            self.condition = condition
+            self.reads = getattr(condition, 'reads', None)
+        else:
+            self.condition = lambda _fsm, _variables: True
+            self.reads = frozenset()
         self.action = action
         self.delay = delay # Assumed to be in seconds
 
@@ -49,12 +157,14 @@ class State:
         self.is_start_state = is_start_state
         self.is_finish_state = is_finish_state
         self.transitions = []
+        self.reads = frozenset() # variables the conditions depend on, None for any
 
     def add_transition(self, transition):
         """Adds a transition originating from this state."""
         if not isinstance(transition, Transition):
             raise TypeError("transition must be an instance of Transition class")
         self.transitions.append(transition)
+        self.reads = _union_reads((self.reads, transition.reads))
 
     def __repr__(self):
         return f"<State '{self.name}' Start={self.is_start_state} Finish={self.is_finish_state}>"
@@ -66,15 +176,48 @@ class FSM:
         self.current_state = None
         self.start_state_name = None
         self._client_socket = None
+        self._channel = None # encodes the messages for _client_socket
         self._client_address = None
         self._stop_event = threading.Event()
         self._variable_lock = threading.Lock() # To protect access to self.variables
         self._client_handler_thread = None
+        self._owns_client = True # False if the socket belongs to the runtime daemon
 
         # For interruptible delays
         self._re_evaluate_event = threading.Event()
         self._current_delay_target_transition = None # Stores the Transition object being delayed
         self._current_delay_end_time = None          # Stores the end time for the current delay
+        # Only changes of the variables read by the conditions of the delayed state
+        # interrupt a delay (None: any variable); the changed names are collected in
+        # _changed_variables, guarded by _variable_lock
+        self._watched_variables = None
+        self._changed_variables = set()
+
+        # State table loaded by load_table(), run() then uses the table driven loop
+        self._table = None
+        self._table_start = None
+        self._table_reads = None # read-set union of the conditions of every state
+
+        # None sends a VARIABLE_UPDATE per change, 0 one VARIABLES_BATCH per step,
+        # a positive value (seconds) at most one batch per interval
+        self.variable_batch_interval = None
+        self._dirty_variables = {} # changed since the last batch, guarded by _variable_lock
+        self._last_variable_flush = 0.0
+
+        # delays and the batch interval are measured on this clock, VirtualClock skips them
+        self.clock = RealClock()
+
+        # None logs and reports every step; a number (seconds) is the throughput mode:
+        # no per-step logging, no STATE_ACTION_EXECUTED, TRANSITION_TAKEN and
+        # TRANSITION_ACTION_EXECUTED, CURRENT_STATE at most once per interval
+        # (and before FSM_STOPPED); the messages ending the run are always sent
+        self.state_event_interval = None
+        self._last_state_event = 0.0
+
+        # answered by GET_STATS, pushed every stats_interval seconds (None: only on request)
+        self.stats = RuntimeStats()
+        self.stats_interval = None
+        self._last_stats_push = 0.0
 
     def add_state(self, state):
         if not isinstance(state, State):
@@ -88,67 +231,278 @@ class FSM:
             self.start_state_name = state.name
         logging.info(f"Added state: {state.name}")
 
+    def load_table(self, names, actions, finals, transitions, start):
+        """
+        Loads the automaton as a state table with dense integer state ids.
+
+        Args:
+            names (tuple): State names, indexed by state id.
+            actions (tuple): Action callable (or None) of every state, called with
+                             (fsm_instance, variables_dict_copy).
+            finals (tuple): True for the finish states.
+            transitions (tuple): Per state a tuple of (condition, target_id, delay)
+                                 tuples in priority order. Conditions are called with
+                                 (fsm_instance, variables_dict) and get the live
+                                 dictionary, so they must not modify it. The `reads`
+                                 attribute of a condition is the set of variables it
+                                 depends on (see Transition).
+            start (int): Id of the start state, None if there is none.
+        """
+        if not (len(names) == len(actions) == len(finals) == len(transitions)):
+            raise ValueError("State table columns differ in length.")
+        rows = tuple(tuple((t[0], t[1], t[2], getattr(t[0], 'reads', None)) for t in row) for row in transitions)
+        self._table = (tuple(names), tuple(actions), tuple(finals), rows)
+        self._table_reads = tuple(_union_reads(t[3] for t in row) for row in rows)
+        self._table_start = start
+        self.start_state_name = names[start] if start is not None else None
+        logging.info(f"Loaded state table with {len(names)} states.")
+
+    def attach_client(self, channel):
+        """
+        Uses an already connected client owned by someone else (the runtime daemon).
+        The FSM only sends on it; incoming messages are read by the owner, which
+        forwards them to set_variable() and stop(). The socket is not closed when
+        the FSM stops.
+
+        Args:
+            channel (wire.Channel): The connection, shared by everyone sending on it.
+        """
+        self._client_socket = channel.sock
+        self._channel = channel
+        self._owns_client = False
+
     def set_variable(self, name, value):
         with self._variable_lock:
+            old = self.variables.get(name, _MISSING)
+            # unchanged values are not reported, 1, 1.0 and True count as different
+            if type(old) is type(value) and old == value:
+                return
             self.variables[name] = value
+            batched = self.variable_batch_interval is not None
+            if batched:
+                if name in self._dirty_variables:
+                    self.stats.coalesced_updates += 1
+                self._dirty_variables[name] = value
+            watched = self._watched_variables
+            relevant = watched is None or name in watched
+            if relevant:
+                self._changed_variables.add(name)
         logging.info(f"Variable '{name}' set to '{value}'")
-        self._send_to_client("VARIABLE_UPDATE", {"name": name, "value": value})
+        if not batched:
+            self._send_to_client("VARIABLE_UPDATE", {"name": name, "value": value})
 
-        # If FSM is in a delay, signal re-evaluation
+        # If FSM is in a delay and a condition reads the variable, signal re-evaluation
         # Check stop_event to avoid signaling if FSM is already stopping
-        if self._current_delay_target_transition and not self._stop_event.is_set():
-            logging.debug(f"Signaling re-evaluation for state {self.current_state.name} due to variable change during delay.")
+        if relevant and self._current_delay_target_transition and not self._stop_event.is_set():
+            logging.debug("Signaling re-evaluation due to variable change during delay.")
             self._re_evaluate_event.set()
 
 
+    def set_variables(self, values):
+        """Sets many variables at once, the FSM re-evaluates its transitions once."""
+        changed = []
+        relevant = False
+        with self._variable_lock:
+            batched = self.variable_batch_interval is not None
+            watched = self._watched_variables
+            for name, value in values.items():
+                old = self.variables.get(name, _MISSING)
+                if type(old) is type(value) and old == value:
+                    continue
+                self.variables[name] = value
+                if watched is None or name in watched:
+                    self._changed_variables.add(name)
+                    relevant = True
+                if batched:
+                    if name in self._dirty_variables:
+                        self.stats.coalesced_updates += 1
+                    self._dirty_variables[name] = value
+                else:
+                    changed.append((name, value))
+        logging.info(f"{len(values)} variables set by the client")
+        for name, value in changed:
+            self._send_to_client("VARIABLE_UPDATE", {"name": name, "value": value})
+
+        if relevant and self._current_delay_target_transition and not self._stop_event.is_set():
+            self._re_evaluate_event.set()
+
     def get_variable(self, name, default=None):
         with self._variable_lock:
             return self.variables.get(name, default)
 
+    def _flush_variables(self, force=False):
+        """Sends the variables changed since the last batch as one VARIABLES_BATCH."""
+        interval = self.variable_batch_interval
+        if interval is None:
+            return
+        now = self.clock.now()
+        if not force and interval > 0 and now - self._last_variable_flush < interval:
+            return # sent with a later step
+        with self._variable_lock:
+            if not self._dirty_variables:
+                return
+            changed, self._dirty_variables = self._dirty_variables, {}
+        self._last_variable_flush = now
+        self._send_to_client("VARIABLES_BATCH", {"variables": changed})
+
     def _send_to_client(self, message_type, payload=None):
         if self._client_socket:
             try:
-                message = {"type": message_type, "payload": payload or {}}
-                self._client_socket.sendall((json.dumps(message) + "\n").encode('utf-8'))
+                self._channel.send(message_type, payload)
+            except EncodeError as e:
+                logging.error(f"{message_type} is not sent: {e}")
+                self.stats.dropped_messages += 1
             except (socket.error, BrokenPipeError) as e:
                 logging.error(f"Error sending message to client: {e}. Client might have disconnected.")
+                self.stats.dropped_messages += 1
                 self._handle_disconnection()
 
+    def _sample_state(self, name, is_finish, force=False):
+        """CURRENT_STATE in the throughput mode, at most once per state_event_interval."""
+        now = time.monotonic()
+        if force or now - self._last_state_event >= self.state_event_interval:
+            self._last_state_event = now
+            self._send_to_client("CURRENT_STATE", {"name": name, "is_finish": is_finish})
+
+    def _functions(self):
+        """The generated functions the FSM calls, by name."""
+        if self._table is not None:
+            _, actions, _, rows = self._table
+            candidates = list(actions) + [t[0] for row in rows for t in row]
+        else:
+            candidates = []
+            for state in self.states.values():
+                candidates.append(state.action)
+                for t in state.transitions:
+                    candidates += (t.condition, t.action)
+        return {f.__name__: f for f in candidates if isinstance(f, types.FunctionType)}
+
+    def reload_functions(self, code):
+        """
+        Replaces the bodies of generated functions while the FSM runs (RELOAD_FUNCTIONS).
+
+        The code defines functions with the names the FSM already calls. Their code
+        objects are swapped into the existing functions, so the states, transitions and
+        the state table keep referring to them and the current state and the variables
+        stay. The next call of a function runs the new body.
+
+        Args:
+            code (str): The new definitions, with the `reads` lines of the conditions.
+
+        Returns:
+            list: Names of the replaced functions.
+
+        Raises:
+            ValueError: A function is not called by this FSM, nothing is replaced then.
+        """
+        functions = self._functions()
+        namespace = dict(next(iter(functions.values())).__globals__) if functions else {}
+        exec(compile(code, "<reload>", "exec"), namespace)
+        new = {name: f for name, f in namespace.items()
+               if isinstance(f, types.FunctionType) and f.__code__.co_filename == "<reload>"}
+        for name, f in new.items():
+            if name not in functions:
+                raise ValueError(f"Function '{name}' is not part of the running automaton.")
+            if len(f.__code__.co_freevars) != len(functions[name].__code__.co_freevars):
+                raise ValueError(f"Function '{name}' cannot be replaced in place.")
+
+        for name, f in new.items():
+            old = functions[name]
+            old.__code__ = f.__code__
+            old.__defaults__ = f.__defaults__
+            if hasattr(f, 'reads') or hasattr(old, 'reads'):
+                old.reads = getattr(f, 'reads', None)
+
+        # the read-sets of the conditions may have changed
+        if self._table is not None:
+            names, actions, finals, rows = self._table
+            rows = tuple(tuple((t[0], t[1], t[2], getattr(t[0], 'reads', None)) for t in row) for row in rows)
+            self._table_reads = tuple(_union_reads(t[3] for t in row) for row in rows)
+            self._table = (names, actions, finals, rows) # picked up by _run_table() at its next scan
+        else:
+            for state in self.states.values():
+                for t in state.transitions:
+                    if t.condition.__name__ in new:
+                        t.reads = getattr(t.condition, 'reads', None)
+                state.reads = _union_reads(t.reads for t in state.transitions)
+
+        # the conditions of the current state are evaluated again, an active delay restarts
+        with self._variable_lock:
+            self._changed_variables.update(self.variables)
+            for f in new.values():
+                self._changed_variables.update(getattr(f, 'reads', None) or ())
+        if any(hasattr(f, 'reads') for f in new.values()):
+            self._re_evaluate_event.set()
+        logging.info(f"Reloaded functions: {', '.join(sorted(new))}")
+        return sorted(new)
+
+    def handle_reload_functions(self, payload):
+        """Answers RELOAD_FUNCTIONS with FUNCTIONS_RELOADED, which has an `error` if nothing was replaced."""
+        try:
+            names = self.reload_functions(payload.get("code", ""))
+        except Exception as e:
+            logging.error(f"Failed to reload functions: {e}")
+            self._send_to_client("FUNCTIONS_RELOADED", {"functions": [], "error": str(e)})
+            return
+        self._send_to_client("FUNCTIONS_RELOADED", {"functions": names})
+
+    def stats_payload(self):
+        """Payload of the STATS message."""
+        return self.stats.snapshot(self._channel)
+
+    def handle_get_stats(self, payload):
+        """Answers GET_STATS, a positive `interval` (seconds) also pushes STATS periodically, 0 stops it."""
+        interval = payload.get("interval")
+        if interval is not None:
+            self.stats_interval = interval if interval > 0 else None
+        self._last_stats_push = time.monotonic()
+        self._send_to_client("STATS", self.stats_payload())
+
+    def push_stats(self):
+        """Sends STATS if the push interval has passed, called by the thread reading the client."""
+        interval = self.stats_interval
+        if interval is None or self._stop_event.is_set():
+            return
+        now = time.monotonic()
+        if now - self._last_stats_push >= interval:
+            self._last_stats_push = now
+            self._send_to_client("STATS", self.stats_payload())
+
 
     def _handle_client_messages(self):
-        buffer = ""
         try:
             while not self._stop_event.is_set() and self._client_socket:
+                self.push_stats()
                 try:
                     self._client_socket.settimeout(0.5)
-                    data = self._client_socket.recv(1024)
-                    if not data:
+                    try:
+                        data = self._client_socket.recv(65536)
+                    except socket.timeout:
+                        data = None # the shared memory ring is checked for a missed doorbell
+                    if data == b"":
                         logging.info("Client disconnected gracefully.")
                         self._handle_disconnection()
                         break
-                    
-                    buffer += data.decode('utf-8')
-                    
-                    while '\n' in buffer:
-                        message_str, buffer = buffer.split('\n', 1)
-                        if not message_str.strip(): continue
+
+                    for message in self._channel.feed(data or b""):
                         try:
-                            message = json.loads(message_str)
                             logging.info(f"Received from client: {message}")
                             if message.get("type") == "SET_VARIABLE":
                                 var_name = message.get("payload", {}).get("name")
                                 var_value = message.get("payload", {}).get("value")
                                 if var_name is not None:
                                     self.set_variable(var_name, var_value)
+                            elif message.get("type") == "SET_VARIABLES":
+                                self.set_variables(message.get("payload", {}).get("variables") or {})
                             elif message.get("type") == "STOP_FSM":
                                 logging.info("Received STOP_FSM command from client.")
                                 self.stop()
-                        except json.JSONDecodeError:
-                            logging.warning(f"Invalid JSON received from client: {message_str}")
+                            elif message.get("type") == "GET_STATS":
+                                self.handle_get_stats(message.get("payload") or {})
+                            elif message.get("type") == "RELOAD_FUNCTIONS":
+                                self.handle_reload_functions(message.get("payload") or {})
                         except Exception as e:
                             logging.error(f"Error processing client message: {e}")
-                except socket.timeout:
-                    continue 
                 except socket.error as e:
                     logging.error(f"Socket error in client handler: {e}")
                     self._handle_disconnection()
@@ -160,7 +514,11 @@ class FSM:
 
 
     def _handle_disconnection(self):
-        if self._client_socket:
+        if self._client_socket and not self._owns_client:
+            # the owner of the socket notices the disconnection itself
+            self.stop()
+            self._client_socket = None
+        elif self._client_socket:
             logging.info(f"Handling disconnection from {self._client_address}")
             # self._send_to_client("FSM_ERROR", {"message": "Client disconnected or connection lost."}) # Might fail if socket is bad
             self.stop() 
@@ -168,27 +526,39 @@ class FSM:
                 self._client_socket.close()
             except socket.error:
                 pass 
+            self._channel.close()
             self._client_socket = None
 
 
-    def connect_to_client(self, host='localhost', port=12345):
-        server_socket = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
-        server_socket.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    def connect_to_client(self, host='localhost', port=0, endpoint=None):
+        """
+        Waits for the editor to connect. The endpoint (`tcp://host:port` or `unix:/path`,
+        see wire.listen()) defaults to $FSM_ENDPOINT, without it the socket listens on host
+        and port; with port 0 the OS picks a free port. The endpoint is printed as
+        'READY <endpoint>' once the socket listens, the editor connects after reading it.
+        """
+        socket_file = None
         try:
-            server_socket.bind((host, port))
-            server_socket.listen(1)
-            logging.info(f"FSM Server listening on {host}:{port}")
-            print(f"FSM Server: Waiting for a client connection on {host}:{port}...")
+            server_socket, endpoint, socket_file = listen(endpoint or os.environ.get("FSM_ENDPOINT"), host, port)
+        except (OSError, ValueError) as e:
+            logging.error(f"Could not start FSM server: {e}")
+            self.stop()
+            return
+        try:
+            print(f"READY {endpoint}", flush=True)
+            logging.info(f"FSM Server listening on {endpoint}")
+            print(f"FSM Server: Waiting for a client connection on {endpoint}...")
             
             server_socket.settimeout(1.0) 
             while not self._stop_event.is_set():
                 try:
                     conn, addr = server_socket.accept()
                     self._client_socket = conn
+                    self._channel = Channel(conn)
                     self._client_address = addr
                     logging.info(f"Client connected from {addr}")
                     print(f"FSM Server: Client connected from {addr}")
-                    self._send_to_client("FSM_CONNECTED", {"message": "Successfully connected to FSM."})
+                    self._send_to_client("FSM_CONNECTED", self._channel.hello_payload("Successfully connected to FSM."))
                     
                     self._client_handler_thread = threading.Thread(target=self._handle_client_messages, daemon=True)
                     self._client_handler_thread.start()
@@ -204,6 +574,7 @@ class FSM:
             self.stop() 
         finally:
             server_socket.close() 
+            remove_socket_file(socket_file) # the accepted connection stays open
 
         if not self._client_socket and not self._stop_event.is_set():
             logging.error("Failed to connect to any client. FSM cannot run.")
@@ -211,6 +582,10 @@ class FSM:
 
 
     def run(self):
+        if self._table is not None:
+            self._run_table()
+            return
+
         if not self.start_state_name:
             logging.error("No start state defined for the FSM.")
             self._send_to_client("FSM_ERROR", {"message": "No start state defined."})
@@ -224,18 +599,24 @@ class FSM:
         self.current_state = self.states[self.start_state_name]
         logging.info(f"FSM starting at state: {self.current_state.name}")
         self._send_to_client("FSM_STARTED", {"start_state": self.current_state.name})
+        verbose = self.state_event_interval is None # see state_event_interval
 
         # Outer FSM loop: continues as long as FSM is not stopped and has a current state
         while not self._stop_event.is_set() and self.current_state:
-            logging.info(f"--- Processing state: {self.current_state.name} ---")
-            self._send_to_client("CURRENT_STATE", {"name": self.current_state.name, "is_finish": self.current_state.is_finish_state})
+            self.stats.steps += 1
+            if verbose:
+                logging.info(f"--- Processing state: {self.current_state.name} ---")
+                self._send_to_client("CURRENT_STATE", {"name": self.current_state.name, "is_finish": self.current_state.is_finish_state})
+            else:
+                self._sample_state(self.current_state.name, self.current_state.is_finish_state)
 
             if self.current_state.action:
-                logging.info(f"Executing action for state {self.current_state.name}")
+                if verbose: logging.info(f"Executing action for state {self.current_state.name}")
                 try:
                     with self._variable_lock: vars_copy = self.variables.copy()
                     self.current_state.action(self, vars_copy) # Pass FSM instance and vars copy
-                    self._send_to_client("STATE_ACTION_EXECUTED", {"state_name": self.current_state.name})
+                    self._flush_variables()
+                    if verbose: self._send_to_client("STATE_ACTION_EXECUTED", {"state_name": self.current_state.name})
                 except Exception as e:
                     logging.error(f"Error executing action for state {self.current_state.name}: {e}")
                     self._send_to_client("FSM_ERROR", {"message": f"Action error in state {self.current_state.name}: {str(e)}"})
@@ -251,16 +632,32 @@ class FSM:
             # Inner loop for transition evaluation and execution for the self.current_state.
             # This loop continues until a state transition occurs, FSM stops, or gets stuck.
             # It can be re-entered if a delay is interrupted by _re_evaluate_event.
+            # After an interrupted delay the conditions up to the delayed transition that
+            # read none of the changed variables keep their result and are not called.
+            interrupted_index = -1
             while not self._stop_event.is_set():
                 self._re_evaluate_event.clear() # Clear before evaluating transitions for this iteration
+                self._flush_variables() # changes of transition actions and of the client
+                with self._variable_lock:
+                    self._watched_variables = self.current_state.reads
+                    changed, self._changed_variables = self._changed_variables, set()
 
                 # 1. Evaluate transitions to find one to take
                 transition_to_take = None
-                for t in self.current_state.transitions:
+                taken_index = -1
+                for index, t in enumerate(self.current_state.transitions):
+                    if index <= interrupted_index and t.reads is not None and t.reads.isdisjoint(changed):
+                        if index == interrupted_index:
+                            transition_to_take, taken_index = t, index # still true
+                            break
+                        continue # still false
+
                     with self._variable_lock: vars_copy = self.variables.copy()
                     can_transit = False
                     try:
+                        started = time.perf_counter_ns()
                         can_transit = t.condition(self, vars_copy) # Pass FSM instance and vars copy
+                        self.stats.conditions.observe(time.perf_counter_ns() - started)
                     except Exception as e:
                         logging.error(f"Error evaluating condition for transition to {t.target_state_name} from {self.current_state.name}: {e}")
                         self._send_to_client("FSM_ERROR", {"message": f"Condition error for transition from {self.current_state.name}: {str(e)}"})
@@ -269,7 +666,7 @@ class FSM:
                     if self._stop_event.is_set(): break
 
                     if can_transit:
-                        transition_to_take = t
+                        transition_to_take, taken_index = t, index
                         break # Found the first (highest priority) valid transition
                 
                 if self._stop_event.is_set(): break # from this inner transition processing loop
@@ -280,22 +677,25 @@ class FSM:
                     self.stop(); break # Break from inner transition processing loop, FSM will stop
 
                 # 2. A transition_to_take has been selected.
-                logging.info(f"Selected transition: {self.current_state.name} -> {transition_to_take.target_state_name}")
-                self._send_to_client("TRANSITION_TAKEN", {
-                    "from_state": self.current_state.name,
-                    "to_state": transition_to_take.target_state_name,
-                    "delay": transition_to_take.delay
-                })
+                self.stats.transitions += 1
+                if verbose:
+                    logging.info(f"Selected transition: {self.current_state.name} -> {transition_to_take.target_state_name}")
+                    self._send_to_client("TRANSITION_TAKEN", {
+                        "from_state": self.current_state.name,
+                        "to_state": transition_to_take.target_state_name,
+                        "delay": transition_to_take.delay
+                    })
 
                 if transition_to_take.action:
-                    logging.info(f"Executing action for transition: {self.current_state.name} -> {transition_to_take.target_state_name}")
+                    if verbose: logging.info(f"Executing action for transition: {self.current_state.name} -> {transition_to_take.target_state_name}")
                     try:
                         with self._variable_lock: # Action might read/write live vars
                             transition_to_take.action(self.variables) 
-                        self._send_to_client("TRANSITION_ACTION_EXECUTED", {
-                            "from_state": self.current_state.name,
-                            "to_state": transition_to_take.target_state_name
-                        })
+                        if verbose:
+                            self._send_to_client("TRANSITION_ACTION_EXECUTED", {
+                                "from_state": self.current_state.name,
+                                "to_state": transition_to_take.target_state_name
+                            })
                     except Exception as e:
                         logging.error(f"Error executing transition action: {e}")
                         self._send_to_client("FSM_ERROR", {"message": f"Transition action error: {str(e)}"})
@@ -308,19 +708,17 @@ class FSM:
                     self._current_delay_target_transition = transition_to_take
                     # transition.delay is in seconds
                     delay_seconds = transition_to_take.delay / 1000.0 # Convert milliseconds to seconds
-                    self._current_delay_end_time = time.time() + delay_seconds
+                    self._current_delay_end_time = self.clock.now() + delay_seconds
                     
-                    logging.info(f"Starting delay for {delay_seconds:.2f}ms for transition to {transition_to_take.target_state_name}")
+                    if verbose: logging.info(f"Starting delay for {delay_seconds:.2f}ms for transition to {transition_to_take.target_state_name}")
                     
                     needs_re_evaluation = False
-                    while not self._stop_event.is_set() and time.time() < self._current_delay_end_time:
-                        remaining_delay = self._current_delay_end_time - time.time()
+                    while not self._stop_event.is_set() and self.clock.now() < self._current_delay_end_time:
+                        remaining_delay = self._current_delay_end_time - self.clock.now()
                         if remaining_delay <= 0: break # Delay naturally ended
 
-                        wait_duration = min(0.1, remaining_delay) # Check frequently
-                        
-                        # _re_evaluate_event.wait clears the event if it returns True
-                        if self._re_evaluate_event.wait(timeout=wait_duration):
+                        # stop() sets _re_evaluate_event too, so the whole delay is waited at once
+                        if self.clock.wait(self._re_evaluate_event, remaining_delay):
                             if self._stop_event.is_set(): break # Prioritize stop event
                             
                             logging.info(f"Re-evaluation signaled during delay for transition to "
@@ -335,6 +733,8 @@ class FSM:
                     if self._stop_event.is_set(): break # Break from inner transition processing loop
 
                     if needs_re_evaluation:
+                        # a transition action writes the variables directly, its changes are not tracked
+                        interrupted_index = taken_index if transition_to_take.action is None else -1
                         # _re_evaluate_event is already cleared by wait().
                         # Continue to the top of this inner "Transition evaluation..." loop
                         # to re-scan all transitions from self.current_state.
@@ -342,12 +742,13 @@ class FSM:
 
                     # If we are here, delay completed naturally (or was very short) without stop or re-evaluation.
                     # Check if time is up, effectively.
-                    if time.time() < self._current_delay_end_time if self._current_delay_end_time else False: # Defensive check, should mean loop exited for other reason
+                    if self.clock.now() < self._current_delay_end_time if self._current_delay_end_time else False: # Defensive check, should mean loop exited for other reason
                         logging.warning("Delay loop for transition exited prematurely without re-evaluation or stop signal, before time was up. Re-evaluating.")
+                        interrupted_index = -1
                         continue
 
 
-                    logging.info(f"Delay completed for transition to {transition_to_take.target_state_name}.")
+                    if verbose: logging.info(f"Delay completed for transition to {transition_to_take.target_state_name}.")
                     # Proceed to change state (handled below this if-block)
 
                 # 4. If delay is zero or completed (and not re-evaluating/stopped), perform the state change.
@@ -357,7 +758,7 @@ class FSM:
                     self._send_to_client("FSM_ERROR", {"message": f"Target state '{transition_to_take.target_state_name}' not found."})
                     self.stop(); break # Break from inner transition processing loop
 
-                logging.info(f"Completing transition: {self.current_state.name} -> {transition_to_take.target_state_name}")
+                if verbose: logging.info(f"Completing transition: {self.current_state.name} -> {transition_to_take.target_state_name}")
                 self.current_state = self.states[transition_to_take.target_state_name]
                 # Successfully transitioned, break inner loop to process the new current_state in outer loop
                 break 
@@ -373,10 +774,157 @@ class FSM:
                         not any(t.condition(self, self.variables.copy()) for t in self.current_state.transitions))
             if not is_stuck : # Avoid duplicate FSM_STUCK vs FSM_STOPPED messages if stuck caused stop.
                 logging.info("FSM run loop terminated by stop event.")
+                if not verbose: # the editor shows where the run stopped
+                    self._sample_state(self.current_state.name, False, force=True)
                 self._send_to_client("FSM_STOPPED", {"message": "FSM was stopped."})
         
         self._cleanup()
 
+    def _run_table(self):
+        """
+        Runs the table loaded by load_table(). Sends the same messages as run(), a step
+        costs a tuple index and the condition calls.
+        """
+        table = self._table
+        names, actions, finals, transitions = table
+        s = self._table_start
+        if s is None or not 0 <= s < len(names):
+            logging.error("No start state defined for the FSM.")
+            self._send_to_client("FSM_ERROR", {"message": "No start state defined."})
+            return
+
+        send = self._send_to_client
+        flush_variables = self._flush_variables
+        stop_event = self._stop_event
+        re_evaluate_event = self._re_evaluate_event
+        variables = self.variables
+        variable_lock = self._variable_lock
+        clock = self.clock
+        table_reads = self._table_reads
+        stats = self.stats
+        observe_condition = stats.conditions.observe
+        perf_counter_ns = time.perf_counter_ns
+        ended = False # finished, stuck or failed, FSM_STOPPED is not sent then
+        verbose = self.state_event_interval is None # see state_event_interval
+        sample_interval = self.state_event_interval
+        monotonic = time.monotonic
+        last_sample = self._last_state_event
+
+        logging.info(f"FSM starting at state: {names[s]}")
+        send("FSM_STARTED", {"start_state": names[s]})
+
+        while not stop_event.is_set():
+            name = names[s]
+            stats.steps += 1
+            if verbose:
+                send("CURRENT_STATE", {"name": name, "is_finish": finals[s]})
+            else:
+                now = monotonic()
+                if now - last_sample >= sample_interval:
+                    last_sample = now
+                    send("CURRENT_STATE", {"name": name, "is_finish": finals[s]})
+
+            action = actions[s]
+            if action is not None:
+                try:
+                    with variable_lock: vars_copy = variables.copy()
+                    action(self, vars_copy)
+                    flush_variables()
+                    if verbose: send("STATE_ACTION_EXECUTED", {"state_name": name})
+                except Exception as e:
+                    logging.error(f"Error executing action for state {name}: {e}")
+                    send("FSM_ERROR", {"message": f"Action error in state {name}: {str(e)}"})
+                    ended = True
+                    self.stop(); break
+
+            if stop_event.is_set(): break
+
+            if finals[s]:
+                logging.info(f"Reached finish state: {name}")
+                send("FSM_FINISHED", {"finish_state": name})
+                ended = True
+                break
+
+            # Transition selection, repeated when a variable changes during a delay; the
+            # conditions up to the delayed one that read none of the changed variables
+            # keep their result then
+            row = transitions[s]
+            next_state = None
+            interrupted_index = -1
+            while not stop_event.is_set():
+                if self._table is not table: # reload_functions() has new read-sets
+                    table = self._table
+                    transitions, table_reads = table[3], self._table_reads
+                    row = transitions[s]
+                re_evaluate_event.clear()
+                flush_variables() # changes made by the client during a delay
+                with variable_lock:
+                    self._watched_variables = table_reads[s]
+                    changed, self._changed_variables = self._changed_variables, set()
+
+                taken = None
+                taken_index = -1
+                try:
+                    for index, t in enumerate(row):
+                        reads = t[3]
+                        if index <= interrupted_index and reads is not None and reads.isdisjoint(changed):
+                            if index == interrupted_index:
+                                taken, taken_index = t, index # still true
+                                break
+                            continue # still false
+                        started = perf_counter_ns()
+                        holds = t[0](self, variables)
+                        observe_condition(perf_counter_ns() - started)
+                        if holds:
+                            taken, taken_index = t, index
+                            break
+                except Exception as e:
+                    logging.error(f"Error evaluating condition for transition from {name}: {e}")
+                    send("FSM_ERROR", {"message": f"Condition error for transition from {name}: {str(e)}"})
+                    ended = True
+                    self.stop(); break
+
+                if taken is None:
+                    logging.warning(f"FSM stuck in state {name}: No valid transitions.")
+                    send("FSM_STUCK", {"state_name": name})
+                    ended = True
+                    self.stop(); break
+
+                _, target, delay, _ = taken
+                stats.transitions += 1
+                if verbose: send("TRANSITION_TAKEN", {"from_state": name, "to_state": names[target], "delay": delay})
+
+                if delay > 0:
+                    self._current_delay_target_transition = taken
+                    end_time = clock.now() + delay / 1000.0 # delay is in milliseconds
+                    interrupted = False
+                    while not stop_event.is_set():
+                        remaining = end_time - clock.now()
+                        if remaining <= 0: break
+                        if clock.wait(re_evaluate_event, remaining):
+                            interrupted = True
+                            break
+                    self._current_delay_target_transition = None
+
+                    if stop_event.is_set(): break
+                    if interrupted:
+                        interrupted_index = taken_index
+                        continue # re-scan the transitions of this state
+
+                next_state = target
+                break
+
+            if next_state is None: break
+            s = next_state
+
+        if stop_event.is_set() and not ended:
+            logging.info("FSM run loop terminated by stop event.")
+            if not verbose: # the editor shows where the run stopped
+                send("CURRENT_STATE", {"name": names[s], "is_finish": finals[s]})
+            send("FSM_STOPPED", {"message": "FSM was stopped."})
+
+        self._cleanup()
+
     def stop(self):
         logging.info("Stop requested for FSM.")
         self._stop_event.set()
@@ -385,11 +933,15 @@ class FSM:
 
     def _cleanup(self):
         logging.info("FSM cleaning up...")
+        self._flush_variables(force=True) # the last values always reach the client
         # Clear any pending delay info, FSM is stopping.
         self._current_delay_target_transition = None
         self._current_delay_end_time = None
 
-        if self._client_socket:
+        owned_channel = None # its shared segment is removed once the reader thread is done
+        if self._client_socket and not self._owns_client:
+            self._client_socket = None # the socket stays open for the next automaton
+        elif self._client_socket:
             try:
                 # Avoid sending if socket already seems problematic or FSM ended with specific message
                 # self._send_to_client("FSM_SHUTTING_DOWN", {}) # Consider if this is needed
@@ -398,10 +950,13 @@ class FSM:
             except (socket.error, AttributeError):
                 pass 
             self._client_socket = None
+            owned_channel = self._channel
         
         if self._client_handler_thread and self._client_handler_thread.is_alive():
             self._client_handler_thread.join(timeout=1.0) 
             if self._client_handler_thread.is_alive():
                 logging.warning("Client handler thread did not terminate gracefully.")
+        if owned_channel is not None:
+            owned_channel.close()
         
         logging.info("FSM has shut down.")
\ No newline at end of file
@@ -0,0 +1,235 @@
+"""
+Many automata on one editor connection.
+
+An editor that monitors a remote host answers FSM_CONNECTED of the daemon with
+SET_MULTIPLEX {window}; the daemon confirms with MULTIPLEX_SET {window, batch_ms}. From
+then on every command that carries an `instance` goes to the automaton of that instance:
+LOAD_AUTOMATON creates it, CLOSE_INSTANCE stops and forgets it, the other commands are
+the ones of the daemon. Each instance runs on its own thread like the FSM of the daemon.
+
+The messages of all instances are collected and sent together, at most every BATCH_INTERVAL
+seconds, as BATCH {messages: [[instance, type, payload], ...]}; the type is a type code
+in the CBOR encoding and a name in JSON. An instance may send `window` messages ahead of
+the editor, which returns them with CREDIT {credits: [[instance, messages], ...]} once it
+has handled them. An instance out of credit waits in send(), the others go on; the thread
+reading the editor never waits, it would not read the credit.
+"""
+
+import logging
+import threading
+
+from .daemon import RuntimeDaemon
+from .wire import TYPE_CODES, EncodeError, cbor_dumps
+
+DEFAULT_WINDOW = 256
+MAX_WINDOW = 65536
+BATCH_INTERVAL = 0.005 # seconds a message waits for others to share its frame
+MAX_BATCH = 1024       # messages of one BATCH
+
+
+class Multiplexer:
+    """Batches the messages of the instances onto the channel, counts the credit of each one."""
+
+    def __init__(self, channel, window=DEFAULT_WINDOW):
+        self._channel = channel
+        self.window = max(1, min(int(window), MAX_WINDOW))
+        self._reader = threading.get_ident() # created by the thread reading the editor
+        self._condition = threading.Condition()
+        self._queue = []
+        self._credits = {}
+        self._closed = False
+        self.batches_sent = 0
+        self._thread = threading.Thread(target=self._send_batches, daemon=True)
+        self._thread.start()
+
+    def open(self, instance, credit=None):
+        with self._condition:
+            self._credits[instance] = self.window if credit is None else credit
+
+    def forget(self, instance):
+        """Stops counting the instance, returns its credit; a waiting sender goes on without it."""
+        with self._condition:
+            credit = self._credits.pop(instance, None)
+            self._condition.notify_all() # a sender of the instance stops waiting
+            return credit
+
+    def send(self, instance, message_type, payload):
+        """Queues a message of the instance, waits while the instance has no credit."""
+        code = TYPE_CODES.get(message_type, message_type) if self._channel.send_encoding == "cbor" else message_type
+        with self._condition:
+            if threading.get_ident() != self._reader:
+                while not self._closed and self._credits.get(instance, 1) <= 0:
+                    self._condition.wait(0.5)
+            if self._closed:
+                raise ConnectionError("The editor connection is closed.")
+            if instance in self._credits:
+                self._credits[instance] -= 1
+            self._queue.append([instance, code, payload])
+            if len(self._queue) == 1 or len(self._queue) >= MAX_BATCH:
+                self._condition.notify_all()
+
+    def grant(self, credits):
+        """Adds the credit of a CREDIT message, [[instance, messages], ...]."""
+        with self._condition:
+            for entry in credits:
+                try:
+                    instance, messages = entry[0], int(entry[1])
+                except (TypeError, ValueError, IndexError):
+                    continue
+                if instance in self._credits:
+                    # never more than a window ahead, a duplicate credit cannot flood the editor
+                    self._credits[instance] = min(self._credits[instance] + messages, self.window)
+            self._condition.notify_all()
+
+    def pending(self):
+        with self._condition:
+            return len(self._queue)
+
+    def close(self):
+        """Wakes the waiting senders, they fail like on a closed socket."""
+        with self._condition:
+            self._closed = True
+            self._condition.notify_all()
+        self._thread.join(timeout=1.0)
+
+    def _send_batches(self):
+        while True:
+            with self._condition:
+                while not self._queue and not self._closed:
+                    self._condition.wait()
+                if self._closed:
+                    return
+                # the first message waits a little for the others
+                if len(self._queue) < MAX_BATCH:
+                    self._condition.wait(BATCH_INTERVAL)
+                batch, self._queue = self._queue[:MAX_BATCH], self._queue[MAX_BATCH:]
+            try:
+                try:
+                    self._channel.send("BATCH", {"messages": batch})
+                except EncodeError:
+                    self._channel.send("BATCH", {"messages": self._encodable(batch)})
+                self.batches_sent += 1
+            except OSError as e:
+                logging.error(f"Error sending a batch to the client: {e}")
+                with self._condition:
+                    self._closed = True
+                    self._condition.notify_all()
+                return
+
+    @staticmethod
+    def _encodable(batch):
+        """The messages of a batch that failed to encode, without the ones that cannot be."""
+        messages = []
+        for message in batch:
+            try:
+                cbor_dumps(message)
+            except EncodeError as e:
+                logging.error(f"A message of instance {message[0]} is not sent: {e}")
+                continue
+            messages.append(message)
+        return messages
+
+
+class InstanceChannel:
+    """The part of wire.Channel the FSM and the daemon use, sending through the multiplexer."""
+
+    def __init__(self, instance, mux, channel):
+        self.instance = instance
+        self.sock = self # the FSM sends only while it has a client socket
+        self.messages_sent = 0
+        self.messages_received = 0
+        self._mux = mux
+        self._channel = channel
+
+    def send(self, message_type, payload=None):
+        self._mux.send(self.instance, message_type, payload if payload is not None else {})
+        self.messages_sent += 1
+
+    def send_queue_bytes(self):
+        return self._channel.send_queue_bytes() # the socket is shared by all instances
+
+    def close(self):
+        pass
+
+
+class InstanceRuntime(RuntimeDaemon):
+    """A daemon without the connection for one instance, like the embedded runtime."""
+
+    def __init__(self, instance, mux, channel):
+        super().__init__()
+        self._mux = mux
+        self._channel = InstanceChannel(instance, mux, channel)
+
+    def dispatch(self, message_type, payload):
+        self._channel.messages_received += 1
+        self._dispatch({"type": message_type, "payload": payload})
+
+    def push_stats(self):
+        if self._fsm:
+            self._fsm.push_stats()
+
+    def stop(self):
+        if self._fsm:
+            self._fsm.stop()
+
+    def close(self):
+        """Stops the FSM of an instance the multiplexer has forgotten already."""
+        super()._stop_fsm()
+
+    def _stop_fsm(self):
+        # the FSM may wait in send() for the credit this very thread reads, it goes on
+        # uncounted until it has stopped; the next FSM gets the credit that was left
+        instance = self._channel.instance
+        credit = self._mux.forget(instance)
+        super()._stop_fsm()
+        self._mux.open(instance, credit)
+
+
+class InstanceTable:
+    """The instances of one multiplexed connection, used by the thread reading the editor."""
+
+    def __init__(self, channel, window):
+        self._channel = channel
+        self.mux = Multiplexer(channel, window)
+        self._instances = {}
+
+    def dispatch(self, message):
+        message_type = message.get("type")
+        instance = message.get("instance")
+        payload = message.get("payload", {}) or {}
+
+        if message_type == "CREDIT":
+            self.mux.grant(payload.get("credits") or [])
+            return
+        runtime = self._instances.get(instance)
+        if message_type == "CLOSE_INSTANCE":
+            if runtime is not None:
+                del self._instances[instance]
+                self.mux.forget(instance) # an FSM out of credit stops waiting, it is stopped next
+                runtime.close()
+            return
+        if runtime is None:
+            if message_type != "LOAD_AUTOMATON":
+                logging.warning(f"No automaton instance {instance}, {message_type} is dropped.")
+                return
+            self.mux.open(instance)
+            runtime = InstanceRuntime(instance, self.mux, self._channel)
+            self._instances[instance] = runtime
+        runtime.dispatch(message_type, payload)
+
+    def push_stats(self):
+        for runtime in list(self._instances.values()):
+            runtime.push_stats()
+
+    def close(self):
+        """Stops every instance, all of them are asked first so they end together."""
+        self.mux.close()
+        runtimes = list(self._instances.values())
+        self._instances.clear()
+        for runtime in runtimes:
+            runtime.stop()
+        for runtime in runtimes:
+            runtime.close()
+
+    def __len__(self):
+        return len(self._instances)
@@ -0,0 +1,161 @@
+"""
+Shared memory transport for an editor on the same host.
+
+After SET_TRANSPORT {transport: "shm"} the runtime creates a segment with two single
+producer, single consumer byte rings: one carries the messages of the runtime to the
+editor, the other the commands of the editor. The bytes in a ring are the same stream
+the socket would carry (JSON lines or CBOR frames of the negotiated encoding). The TCP
+connection stays open, it detects the disconnection and is the doorbell: a producer
+writes one byte to it only when the consumer has flagged that it sleeps.
+
+Layout, native byte order, all positions are free running byte counters:
+
+    0    magic, version, capacity of each ring (3 x u32)
+    64   ring 0 (runtime -> editor), 128 + capacity bytes
+         +0 head u64 (written by the producer), +64 tail u64 and +72 waiting u32
+         (written by the consumer), +128 data
+    ...  ring 1 (editor -> runtime), same layout
+
+Must match src/transport/shared-ring.hpp.
+
+The rings rely on aligned 8 byte stores being atomic and stores becoming visible in
+program order, so the transport is only offered on x86-64.
+"""
+
+import platform
+import struct
+import sys
+import threading
+
+try:
+    from multiprocessing import shared_memory
+except ImportError: # Python < 3.8
+    shared_memory = None
+
+MAGIC = 0x52534D46 # "FMSR" in memory
+VERSION = 1
+RING_CAPACITY = 1 << 22
+HEADER_SIZE = 64
+RING_CONTROL_SIZE = 128
+
+# native formats, struct copies the value with one memcpy (the "<" formats store byte by byte)
+_U32 = struct.Struct("I")
+_U64 = struct.Struct("Q")
+
+
+def supported():
+    """Checks if the shared memory transport can be offered on this host."""
+    return (shared_memory is not None and sys.platform.startswith("linux")
+            and platform.machine().lower() in ("x86_64", "amd64"))
+
+
+_fence_lock = threading.Lock()
+
+
+def _fence():
+    # an uncontended lock is a locked instruction, which is a full barrier on x86-64;
+    # it orders the store of a position before the load of the other side's flag
+    with _fence_lock:
+        pass
+
+
+class SharedRing:
+    """One direction of the transport, used either as the producer or the consumer."""
+
+    def __init__(self, buf, offset, capacity):
+        self._buf = buf
+        self._head = offset
+        self._tail = offset + 64
+        self._waiting = offset + 72
+        self._data = offset + RING_CONTROL_SIZE
+        self._capacity = capacity
+
+    def _load(self, offset):
+        return _U64.unpack_from(self._buf, offset)[0]
+
+    def pending(self):
+        """Bytes written and not yet read."""
+        return self._load(self._head) - self._load(self._tail)
+
+    def is_empty(self):
+        return self.pending() == 0
+
+    def write(self, data):
+        """Copies as much of data as fits, returns the number of bytes written."""
+        head = self._load(self._head)
+        free = self._capacity - (head - self._load(self._tail))
+        n = min(free, len(data))
+        if n <= 0:
+            return 0
+        start = head % self._capacity
+        first = min(n, self._capacity - start)
+        base = self._data
+        self._buf[base + start:base + start + first] = data[:first]
+        if first < n:
+            self._buf[base:base + n - first] = data[first:n]
+        _U64.pack_into(self._buf, self._head, head + n) # publishes the bytes
+        return n
+
+    def read(self):
+        """Returns all bytes written so far and frees their space."""
+        tail = self._load(self._tail)
+        n = self._load(self._head) - tail
+        if n == 0:
+            return b""
+        start = tail % self._capacity
+        first = min(n, self._capacity - start)
+        base = self._data
+        data = bytes(self._buf[base + start:base + start + first])
+        if first < n:
+            data += bytes(self._buf[base:base + n - first])
+        _U64.pack_into(self._buf, self._tail, tail + n)
+        return data
+
+    def set_waiting(self, waiting):
+        _U32.pack_into(self._buf, self._waiting, 1 if waiting else 0)
+
+    def take_waiting(self):
+        """Producer side: checks if the consumer sleeps and clears the flag, the caller rings."""
+        _fence()
+        if _U32.unpack_from(self._buf, self._waiting)[0]:
+            _U32.pack_into(self._buf, self._waiting, 0)
+            return True
+        return False
+
+    def sleep_if_empty(self):
+        """Consumer side: flags the sleep, returns False (flag cleared) if data arrived meanwhile."""
+        self.set_waiting(True)
+        _fence()
+        if self.is_empty():
+            return True
+        self.set_waiting(False)
+        return False
+
+
+class SharedSegment:
+    """The segment of one connection, created by the runtime."""
+
+    def __init__(self, capacity=RING_CAPACITY):
+        size = HEADER_SIZE + 2 * (RING_CONTROL_SIZE + capacity)
+        self.memory = shared_memory.SharedMemory(create=True, size=size)
+        self.capacity = capacity
+        buf = self.memory.buf # a new segment is zeroed, the rings start empty
+        struct.pack_into("III", buf, 0, MAGIC, VERSION, capacity)
+        self.outgoing = SharedRing(buf, HEADER_SIZE, capacity)
+        self.incoming = SharedRing(buf, HEADER_SIZE + RING_CONTROL_SIZE + capacity, capacity)
+
+    @property
+    def name(self):
+        return self.memory.name
+
+    def close(self):
+        """Unmaps and removes the segment, the editor keeps its own mapping until it detaches."""
+        self.outgoing = self.incoming = None
+        try:
+            self.memory.close()
+        except BufferError:
+            pass # a memoryview of the ring is still alive, the mapping goes with the process
+        try:
+            self.memory.unlink()
+        except FileNotFoundError:
+            pass
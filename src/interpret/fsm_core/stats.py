@@ -0,0 +1,168 @@
+"""
+Runtime statistics of a running FSM.
+
+The counters are plain integers updated by the FSM thread, reading them needs no lock.
+snapshot() turns them into the payload of the STATS message; prometheus_text() renders
+the same values in the Prometheus text exposition format, served by
+start_metrics_server() when the runtime runs without the editor watching it.
+"""
+
+import logging
+import threading
+import time
+from collections import deque
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+
+class LatencyHistogram:
+    """Durations in nanoseconds in power of two buckets, percentiles are interpolated."""
+
+    def __init__(self):
+        self.count = 0
+        self.total_ns = 0
+        self.buckets = [0] * 65 # bucket i holds durations of bit length i
+
+    def observe(self, ns):
+        self.count += 1
+        self.total_ns += ns
+        self.buckets[ns.bit_length()] += 1
+
+    def average_ns(self):
+        return self.total_ns / self.count if self.count else 0.0
+
+    def percentile_ns(self, fraction):
+        if not self.count:
+            return 0.0
+        rank = fraction * self.count
+        seen = 0
+        for length, n in enumerate(self.buckets):
+            if n and seen + n >= rank:
+                low = (1 << (length - 1)) if length else 0
+                high = (1 << length) - 1
+                return low + (high - low) * (rank - seen) / n
+            seen += n
+        return float(1 << 64)
+
+
+class RuntimeStats:
+    """Throughput and latency counters of one FSM."""
+
+    RATE_WINDOW = 10.0 # seconds the steps/s and transitions/s are averaged over
+
+    def __init__(self):
+        self.started = time.monotonic()
+        self.steps = 0              # states entered
+        self.transitions = 0        # transitions taken
+        self.conditions = LatencyHistogram()
+        self.coalesced_updates = 0  # variable changes merged into a pending batch
+        self.dropped_messages = 0   # messages not sent because the connection was lost
+        self._samples = deque(maxlen=64) # (time, steps, transitions) of the earlier snapshots
+        self._samples_lock = threading.Lock()
+
+    def _rates(self, now):
+        """Steps and transitions per second over the last RATE_WINDOW seconds."""
+        with self._samples_lock:
+            samples = self._samples
+            if not samples or now - samples[-1][0] >= 1.0:
+                samples.append((now, self.steps, self.transitions))
+            base = (self.started, 0, 0)
+            for sample in samples:
+                if now - sample[0] <= self.RATE_WINDOW:
+                    break
+                base = sample
+        elapsed = now - base[0]
+        if elapsed <= 0:
+            return 0.0, 0.0
+        return (self.steps - base[1]) / elapsed, (self.transitions - base[2]) / elapsed
+
+    def snapshot(self, channel=None):
+        """Payload of the STATS message, channel adds the counters of the connection."""
+        now = time.monotonic()
+        steps_per_s, transitions_per_s = self._rates(now)
+        conditions = self.conditions
+        payload = {
+            "uptime_s": now - self.started,
+            "steps": self.steps,
+            "transitions": self.transitions,
+            "steps_per_s": steps_per_s,
+            "transitions_per_s": transitions_per_s,
+            "condition_evaluations": conditions.count,
+            "condition_avg_us": conditions.average_ns() / 1000.0,
+            "condition_p99_us": conditions.percentile_ns(0.99) / 1000.0,
+            "coalesced_updates": self.coalesced_updates,
+            "dropped_messages": self.dropped_messages,
+            "messages_sent": 0,
+            "messages_received": 0,
+            "send_queue_bytes": None,
+        }
+        if channel is not None:
+            payload["messages_sent"] = channel.messages_sent
+            payload["messages_received"] = channel.messages_received
+            payload["send_queue_bytes"] = channel.send_queue_bytes()
+        return payload
+
+
+# (payload key, metric name, type, help, scale)
+_METRICS = (
+    ("uptime_s", "fsm_uptime_seconds", "gauge", "Seconds since the FSM was built.", 1.0),
+    ("steps", "fsm_steps_total", "counter", "States entered.", 1.0),
+    ("transitions", "fsm_transitions_total", "counter", "Transitions taken.", 1.0),
+    ("steps_per_s", "fsm_steps_per_second", "gauge", "States entered per second, recent average.", 1.0),
+    ("transitions_per_s", "fsm_transitions_per_second", "gauge", "Transitions taken per second, recent average.", 1.0),
+    ("condition_evaluations", "fsm_condition_evaluations_total", "counter", "Transition conditions evaluated.", 1.0),
+    ("condition_avg_us", "fsm_condition_seconds_average", "gauge", "Average condition evaluation time.", 1e-6),
+    ("condition_p99_us", "fsm_condition_seconds_p99", "gauge", "99th percentile of the condition evaluation time.", 1e-6),
+    ("messages_sent", "fsm_messages_sent_total", "counter", "Messages sent to the client.", 1.0),
+    ("messages_received", "fsm_messages_received_total", "counter", "Messages received from the client.", 1.0),
+    ("send_queue_bytes", "fsm_send_queue_bytes", "gauge", "Bytes in the socket send queue.", 1.0),
+    ("coalesced_updates", "fsm_coalesced_updates_total", "counter", "Variable updates merged into a batch.", 1.0),
+    ("dropped_messages", "fsm_dropped_messages_total", "counter", "Messages lost with the connection.", 1.0),
+)
+
+
+def prometheus_text(payload):
+    """Renders a STATS payload in the Prometheus text exposition format."""
+    lines = []
+    for key, name, kind, help_text, scale in _METRICS:
+        value = payload.get(key)
+        if value is None:
+            continue # not known on this platform or without a client
+        lines.append(f"# HELP {name} {help_text}")
+        lines.append(f"# TYPE {name} {kind}")
+        lines.append(f"{name} {value * scale:.9g}")
+    return "\n".join(lines) + "\n"
+
+
+def start_metrics_server(port, snapshot, host="localhost"):
+    """
+    Serves GET /metrics on a daemon thread.
+
+    Args:
+        port (int): Port of the HTTP server, 0 lets the OS pick one.
+        snapshot (callable): Returns the current STATS payload.
+        host (str): Interface to listen on.
+
+    Returns:
+        ThreadingHTTPServer: The running server, server_address has the port.
+    """
+
+    class MetricsHandler(BaseHTTPRequestHandler):
+        def do_GET(self):
+            if self.path.split("?", 1)[0] != "/metrics":
+                self.send_error(404)
+                return
+            body = prometheus_text(snapshot()).encode("utf-8")
+            self.send_response(200)
+            self.send_header("Content-Type", "text/plain; version=0.0.4; charset=utf-8")
+            self.send_header("Content-Length", str(len(body)))
+            self.end_headers()
+            self.wfile.write(body)
+
+        def log_message(self, format, *args):
+            logging.debug("Metrics: " + format % args)
+
+    server = ThreadingHTTPServer((host, port), MetricsHandler)
+    server.daemon_threads = True
+    threading.Thread(target=server.serve_forever, daemon=True).start()
+    logging.info(f"Prometheus metrics on http://{host}:{server.server_address[1]}/metrics")
+    return server
@@ -0,0 +1,495 @@
+"""
+Wire encodings of the editor protocol.
+
+Messages start as JSON lines. FSM_CONNECTED lists the encodings the runtime speaks;
+the editor may answer SET_ENCODING {encoding, version}, everything it sends after that
+line uses the new encoding. The runtime confirms with ENCODING_SET, its last JSON line.
+
+In the CBOR encoding every message is a frame: a 4 byte big-endian length followed by
+the CBOR array [type code, payload]. The type codes are the positions in MESSAGE_TYPES
+(starting at 1) and have to match the table in client.cpp; unknown types are sent by
+name. Only the CBOR subset needed by the protocol is implemented (integers, floats,
+strings, byte strings, arrays, maps, booleans and null), so no package is required.
+An int beyond 64 bits has no CBOR head, its message fails with EncodeError and is dropped
+by the sender; the JSON encoding sends it as it is.
+
+FSM_CONNECTED also lists the transports. An editor on the same host may answer
+SET_TRANSPORT {transport: "shm"}; the runtime then creates a shared segment (shm.py)
+and confirms with TRANSPORT_SET {transport, name, capacity}, its last message on the
+socket. From then on the messages of both sides go through the rings and the socket
+only carries doorbell bytes. The editor sends nothing after SET_TRANSPORT until the
+confirmation arrives.
+
+On a multiplexed connection (mux.py) a message of the editor addressed to one automaton
+carries its `instance`, a key of the JSON object or the third element of the CBOR array.
+"""
+
+import json
+import logging
+import os
+import socket
+import stat
+import struct
+import threading
+import time
+
+import sys
+
+from . import shm
+
+# the unsent bytes of a socket are only asked for on Linux (ioctl TIOCOUTQ)
+if sys.platform.startswith("linux"):
+    import fcntl
+    _TIOCOUTQ = 0x5411
+else:
+    fcntl = None
+
+PROTOCOL_VERSION = 1
+ENCODINGS = ("json", "cbor")
+
+MESSAGE_TYPES = (
+    "FSM_CONNECTED",
+    "FSM_STARTED",
+    "FSM_ERROR",
+    "CURRENT_STATE",
+    "STATE_ACTION_EXECUTED",
+    "TRANSITION_TAKEN",
+    "TRANSITION_ACTION_EXECUTED",
+    "VARIABLE_UPDATE",
+    "FSM_FINISHED",
+    "FSM_STUCK",
+    "FSM_STOPPED",
+    "AUTOMATON_LOADED",
+    "SET_VARIABLE",
+    "STOP_FSM",
+    "LOAD_AUTOMATON",
+    "SHUTDOWN",
+    "SET_ENCODING",
+    "ENCODING_SET",
+    "VARIABLES_BATCH",
+    "SET_VARIABLES",
+    "GET_STATS",
+    "STATS",
+    "SET_TRANSPORT",
+    "TRANSPORT_SET",
+    "RELOAD_FUNCTIONS",
+    "FUNCTIONS_RELOADED",
+    "SET_MULTIPLEX",
+    "MULTIPLEX_SET",
+    "BATCH",
+    "CREDIT",
+    "CLOSE_INSTANCE",
+)
+TYPE_CODES = {name: code for code, name in enumerate(MESSAGE_TYPES, 1)}
+
+_FRAME_HEADER = struct.Struct(">I")
+
+_DOORBELL = b"\x01"
+_RING_FULL_TIMEOUT = 10.0 # seconds a send waits for the editor to free ring space
+
+
+# --- CBOR ---
+
+class EncodeError(ValueError):
+    """A value of the payload has no form in the encoding, the message is not sent."""
+
+
+def _encode_head(out, major, value):
+    if value < 24:
+        out.append((major << 5) | value)
+    elif value < 0x100:
+        out += bytes(((major << 5) | 24, value))
+    elif value < 0x10000:
+        out.append((major << 5) | 25)
+        out += struct.pack(">H", value)
+    elif value < 0x100000000:
+        out.append((major << 5) | 26)
+        out += struct.pack(">I", value)
+    elif value < 0x10000000000000000:
+        out.append((major << 5) | 27)
+        out += struct.pack(">Q", value)
+    else:
+        raise EncodeError(f"the int {value if major == 0 else -1 - value} does not fit the 64 bits of CBOR")
+
+
+def _encode_item(out, value):
+    if value is None:
+        out.append(0xf6)
+    elif value is True:
+        out.append(0xf5)
+    elif value is False:
+        out.append(0xf4)
+    elif isinstance(value, int):
+        if value >= 0:
+            _encode_head(out, 0, value)
+        else:
+            _encode_head(out, 1, -1 - value)
+    elif isinstance(value, float):
+        out.append(0xfb)
+        out += struct.pack(">d", value)
+    elif isinstance(value, str):
+        data = value.encode('utf-8')
+        _encode_head(out, 3, len(data))
+        out += data
+    elif isinstance(value, (bytes, bytearray)):
+        _encode_head(out, 2, len(value))
+        out += value
+    elif isinstance(value, (list, tuple)):
+        _encode_head(out, 4, len(value))
+        for item in value:
+            _encode_item(out, item)
+    elif isinstance(value, dict):
+        _encode_head(out, 5, len(value))
+        for key, item in value.items():
+            _encode_item(out, str(key))
+            _encode_item(out, item)
+    else:
+        _encode_item(out, str(value))
+
+
+def cbor_dumps(value):
+    out = bytearray()
+    _encode_item(out, value)
+    return bytes(out)
+
+
+def _decode_item(data, pos):
+    initial = data[pos]
+    pos += 1
+    major, info = initial >> 5, initial & 0x1f
+
+    if major == 7:
+        if info == 20:
+            return False, pos
+        if info == 21:
+            return True, pos
+        if info in (22, 23):
+            return None, pos
+        if info == 25:
+            return _decode_half(data[pos:pos + 2]), pos + 2
+        if info == 26:
+            return struct.unpack_from(">f", data, pos)[0], pos + 4
+        if info == 27:
+            return struct.unpack_from(">d", data, pos)[0], pos + 8
+        raise ValueError(f"unsupported CBOR simple value {info}")
+
+    if info < 24:
+        value = info
+    elif info == 24:
+        value = data[pos]
+        pos += 1
+    elif info == 25:
+        value = struct.unpack_from(">H", data, pos)[0]
+        pos += 2
+    elif info == 26:
+        value = struct.unpack_from(">I", data, pos)[0]
+        pos += 4
+    elif info == 27:
+        value = struct.unpack_from(">Q", data, pos)[0]
+        pos += 8
+    else:
+        raise ValueError("indefinite CBOR lengths are not supported")
+
+    if major == 0:
+        return value, pos
+    if major == 1:
+        return -1 - value, pos
+    if major == 2:
+        return bytes(data[pos:pos + value]), pos + value
+    if major == 3:
+        return bytes(data[pos:pos + value]).decode('utf-8'), pos + value
+    if major == 4:
+        items = []
+        for _ in range(value):
+            item, pos = _decode_item(data, pos)
+            items.append(item)
+        return items, pos
+    if major == 5:
+        items = {}
+        for _ in range(value):
+            key, pos = _decode_item(data, pos)
+            item, pos = _decode_item(data, pos)
+            items[key] = item
+        return items, pos
+    if major == 6:
+        return _decode_item(data, pos) # tags are ignored
+    raise ValueError(f"unsupported CBOR major type {major}")
+
+
+def _decode_half(data):
+    half = (data[0] << 8) | data[1]
+    exponent = (half >> 10) & 0x1f
+    mantissa = half & 0x3ff
+    if exponent == 0:
+        value = mantissa * 2.0 ** -24
+    elif exponent == 31:
+        value = float('inf') if mantissa == 0 else float('nan')
+    else:
+        value = (mantissa + 1024) * 2.0 ** (exponent - 25)
+    return -value if half & 0x8000 else value
+
+
+def cbor_loads(data):
+    value, _ = _decode_item(memoryview(data), 0)
+    return value
+
+
+# --- Endpoints ---
+
+def listen(endpoint=None, host="localhost", port=0):
+    """
+    Opens the listening socket of the runtime.
+
+    Args:
+        endpoint (str): `tcp://host:port` or `unix:/path` (a local socket, no TCP stack and
+            no port); None listens on host and port. Without AF_UNIX (Windows) a unix
+            endpoint falls back to TCP on any free port.
+        host (str): Interface of the TCP socket without an endpoint.
+        port (int): Port of the TCP socket without an endpoint, 0 lets the OS pick one.
+
+    Returns:
+        tuple: (server socket, endpoint for the READY line, socket file to remove or None).
+    """
+    if endpoint and endpoint.startswith("unix:"):
+        path = endpoint[5:]
+        if path.startswith("///"):
+            path = path[2:]
+        if hasattr(socket, "AF_UNIX"):
+            try:
+                if stat.S_ISSOCK(os.stat(path).st_mode):
+                    os.unlink(path) # left by a runtime that did not end cleanly
+            except FileNotFoundError:
+                pass
+            server_socket = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+            server_socket.bind(path)
+            server_socket.listen(1)
+            return server_socket, "unix:" + path, path
+        logging.warning(f"Local sockets are not available, listening on TCP instead of {endpoint}.")
+        endpoint = None
+        port = 0
+
+    if endpoint:
+        if not endpoint.startswith("tcp://"):
+            raise ValueError(f"Unknown endpoint {endpoint}, expected tcp://host:port or unix:/path")
+        host, _, port_text = endpoint[6:].rpartition(":")
+        host = host.strip("[]") or "localhost"
+        port = int(port_text)
+    server_socket = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    server_socket.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    server_socket.bind((host, port))
+    server_socket.listen(1)
+    return server_socket, f"tcp://{host}:{server_socket.getsockname()[1]}", None
+
+
+def remove_socket_file(path):
+    """Removes the socket file returned by listen(), None is ignored."""
+    if path:
+        try:
+            os.unlink(path)
+        except OSError:
+            pass
+
+
+# --- Messages ---
+
+def type_name(code):
+    """Name of a message type sent by its code, unknown types are sent by name."""
+    return MESSAGE_TYPES[code - 1] if isinstance(code, int) and 0 < code <= len(MESSAGE_TYPES) else code
+
+
+def encode_message(message_type, payload, encoding="json"):
+    """Returns the bytes of one message in the given encoding."""
+    if encoding == "cbor":
+        body = cbor_dumps([TYPE_CODES.get(message_type, message_type), payload])
+        return _FRAME_HEADER.pack(len(body)) + body
+    return (json.dumps({"type": message_type, "payload": payload}) + "\n").encode('utf-8')
+
+
+class Channel:
+    """
+    Connection to the editor with its negotiated encodings. send() may be called from
+    several threads; feed() is called by the one thread reading the socket.
+    """
+
+    def __init__(self, sock):
+        self.sock = sock
+        self._send_lock = threading.Lock()
+        self._send_encoding = "json"
+        self._receive_encoding = "json"
+        self._buffer = bytearray()
+        self._offset = 0
+        self.messages_sent = 0
+        self.messages_received = 0
+        self._segment = None # shared memory transport, None while the socket carries the messages
+
+    @property
+    def send_encoding(self):
+        """Encoding of the messages sent from now on, json or cbor."""
+        return self._send_encoding
+
+    def hello_payload(self, message):
+        """Payload of FSM_CONNECTED, offers the encodings and transports to the editor."""
+        transports = ["tcp", "shm"] if shm.supported() else ["tcp"]
+        return {"message": message, "version": PROTOCOL_VERSION, "encodings": list(ENCODINGS),
+                "transports": transports}
+
+    def send(self, message_type, payload=None):
+        """
+        Sends one message, raises socket.error when the connection is lost and EncodeError,
+        before anything is sent, when the payload has no form in the encoding.
+        """
+        with self._send_lock:
+            data = encode_message(message_type, payload or {}, self._send_encoding)
+            if self._segment is not None:
+                self._write_shared(data)
+            else:
+                self.sock.sendall(data)
+            self.messages_sent += 1
+
+    def _write_shared(self, data):
+        ring = self._segment.outgoing
+        view = memoryview(data)
+        deadline = None
+        while True:
+            written = ring.write(view)
+            view = view[written:]
+            if ring.take_waiting():
+                self.sock.sendall(_DOORBELL)
+            if not view:
+                return
+            # the ring is full, the editor is woken and frees it
+            now = time.monotonic()
+            if deadline is None:
+                deadline = now + _RING_FULL_TIMEOUT
+            elif now > deadline:
+                raise ConnectionError("The editor does not read the shared memory transport.")
+            time.sleep(0.0002)
+
+    def close(self):
+        """Removes the shared segment, called once the connection has ended."""
+        with self._send_lock:
+            if self._segment is not None:
+                self._segment.close()
+                self._segment = None
+
+    def send_queue_bytes(self):
+        """Bytes sent but not yet acknowledged by the client, None if the OS does not tell."""
+        if self._segment is not None:
+            return self._segment.outgoing.pending()
+        if fcntl is None:
+            return None
+        try:
+            queued = fcntl.ioctl(self.sock.fileno(), _TIOCOUTQ, b"\0\0\0\0")
+        except (OSError, ValueError):
+            return None
+        return struct.unpack("i", queued)[0]
+
+    def feed(self, data):
+        """
+        Returns the complete messages of the received data, SET_ENCODING and SET_TRANSPORT
+        are handled here. With the shared memory transport the data are doorbell bytes and
+        the messages are read from the ring; the readers also call feed(b"") when they time
+        out, so a missed doorbell only delays the commands.
+        """
+        messages = []
+        if self._segment is None:
+            self._buffer += data
+            self._parse(messages)
+        segment = self._segment
+        while segment is not None:
+            try:
+                chunk = segment.incoming.read()
+                if not chunk and segment.incoming.sleep_if_empty():
+                    break
+            except (AttributeError, ValueError):
+                break # closed by another thread, the connection has ended
+            self._buffer += chunk
+            self._parse(messages)
+            segment = self._segment
+        return messages
+
+    def _parse(self, messages):
+        while True:
+            message = self._next_message()
+            if message is None:
+                break
+            self.messages_received += 1
+            if message.get("type") == "SET_ENCODING":
+                self._set_encoding(message.get("payload") or {})
+                continue
+            if message.get("type") == "SET_TRANSPORT":
+                self._set_transport(message.get("payload") or {})
+                continue
+            messages.append(message)
+
+        # consumed messages are dropped once they are most of the buffer
+        if self._offset and self._offset * 2 >= len(self._buffer):
+            del self._buffer[:self._offset]
+            self._offset = 0
+
+    def _next_message(self):
+        while True:
+            if self._receive_encoding == "cbor":
+                if len(self._buffer) - self._offset < _FRAME_HEADER.size:
+                    return None
+                (length,) = _FRAME_HEADER.unpack_from(self._buffer, self._offset)
+                start = self._offset + _FRAME_HEADER.size
+                if len(self._buffer) - start < length:
+                    return None
+                self._offset = start + length
+                try:
+                    frame = cbor_loads(bytes(self._buffer[start:start + length]))
+                    code, payload = frame[0], frame[1]
+                except (ValueError, TypeError, IndexError, KeyError, struct.error) as e:
+                    logging.warning(f"Invalid CBOR frame received from client: {e}")
+                    continue
+                message = {"type": type_name(code), "payload": payload}
+                if len(frame) > 2:
+                    message["instance"] = frame[2]
+                return message
+
+            newline = self._buffer.find(b"\n", self._offset)
+            if newline < 0:
+                return None
+            line = bytes(self._buffer[self._offset:newline])
+            self._offset = newline + 1
+            if not line.strip():
+                continue
+            try:
+                return json.loads(line.decode('utf-8'))
+            except (json.JSONDecodeError, UnicodeDecodeError):
+                logging.warning(f"Invalid JSON received from client: {line[:200]!r}")
+
+    def _set_encoding(self, payload):
+        encoding = payload.get("encoding", "json")
+        if encoding not in ENCODINGS:
+            logging.warning(f"Client asked for the unknown encoding {encoding}, staying with JSON.")
+            encoding = "json"
+        # the editor sends in the new encoding from the next message on
+        self._receive_encoding = encoding
+        with self._send_lock:
+            # the confirmation is the last message in the old encoding
+            self.sock.sendall(encode_message("ENCODING_SET", {"encoding": encoding, "version": PROTOCOL_VERSION}, self._send_encoding))
+            self._send_encoding = encoding
+        logging.info(f"Wire encoding switched to {encoding}.")
+
+    def _set_transport(self, payload):
+        confirmation = {"transport": "tcp"}
+        segment = None
+        if payload.get("transport") == "shm" and self._segment is None and shm.supported():
+            try:
+                segment = shm.SharedSegment()
+            except OSError as e:
+                logging.warning(f"Cannot create the shared memory transport, staying with TCP: {e}")
+        if segment is not None:
+            # the editor sleeps until the first command, it rings then
+            segment.incoming.set_waiting(True)
+            confirmation = {"transport": "shm", "name": segment.name, "capacity": segment.capacity,
+                            "version": shm.VERSION}
+        with self._send_lock:
+            # the confirmation is the last message on the socket, the editor held back the rest
+            self.sock.sendall(encode_message("TRANSPORT_SET", confirmation, self._send_encoding))
+            self._segment = segment
+        if segment is not None:
+            del self._buffer[self._offset:]
+            logging.info(f"Transport switched to shared memory {segment.name}.")
@@ -6,10 +6,17 @@
  */
 
 #include "interpret_generator.h"
+#include "spec_parser/automaton-optimizer.hpp"
+#include "spec_parser/compiled-automaton.hpp"
+#include "spec_parser/sub-automaton.hpp"
+#include "trace/scope-trace.hpp"
 #include <QDebug>
 #include <QDir>
 #include <QFileInfo>
+#include <QHash>
 #include <QRegularExpression>
+#include <optional>
+#include <thread>
 
 // Helper to make a string safe as a Python identifier
 QString sanitize_python_identifier(std::string name) {
@@ -75,48 +82,54 @@ QString to_python_string_literal(const std::string& s) {
     return "\"" + QString::fromStdString(escaped_s) + "\"";
 }
 
-// Helper to convert string value to Python literal (bool, int, float, or string)
-QString to_python_value_literal(const std::string& val_str) {
-    if (val_str.empty()) return "None"; // Maybe error instead?
-
-    std::string lower_val = val_str;
-    std::transform(lower_val.begin(), lower_val.end(), lower_val.begin(), ::tolower);
-
-    if (lower_val == "true") return "True";
-    if (lower_val == "false") return "False";
-
-    // Try to parse as int
-    try {
-        size_t processed_chars;
-        int i_val = std::stoi(val_str, &processed_chars);
-        if (processed_chars == val_str.length()) { // Ensure entire string was parsed
-            return QString::fromStdString(std::to_string(i_val));
+// Helper to create a Python string literal of source code, the line breaks escaped
+QString to_python_source_literal(const std::string& s) {
+    std::string escaped;
+    escaped.reserve(s.size() + s.size() / 8 + 2);
+    escaped += '"';
+    for (char c : s) {
+        switch (c) {
+        case '\\': escaped += "\\\\"; break;
+        case '"': escaped += "\\\""; break;
+        case '\n': escaped += "\\n"; break;
+        case '\r': escaped += "\\r"; break;
+        default: escaped += c;
         }
-    } catch (const std::invalid_argument&) {
-    } catch (const std::out_of_range&) {}
-
-    // Try to parse as float
-    try {
-        size_t processed_chars;
-        double d_val = std::stod(val_str, &processed_chars);
-        if (processed_chars == val_str.length()) { // Ensure entire string was parsed
-            std::ostringstream oss;
-            oss << d_val; // Let C++ decide precision, or use std::fixed, std::setprecision
-            return QString::fromStdString(oss.str());
-        }
-    } catch (const std::invalid_argument&) {
-    } catch (const std::out_of_range&) {}
+    }
+    escaped += '"';
+    return QString::fromStdString(escaped);
+}
 
-    // Default to string literal
-    return to_python_string_literal(val_str);
+// Helper to convert a typed value to Python literal (None, bool, int, float, or string)
+QString to_python_value_literal(const VariableValue& value) {
+    switch (value.index()) {
+    case 0: return "None";
+    case 1: return std::get<bool>(value) ? "True" : "False";
+    case 2: return QString::fromStdString(std::to_string(std::get<int64_t>(value)));
+    case 3: {
+        std::ostringstream oss;
+        oss << std::get<double>(value); // Let C++ decide precision, or use std::fixed, std::setprecision
+        return QString::fromStdString(oss.str());
+    }
+    default: return to_python_string_literal(std::get<std::string>(value));
+    }
 }
 
 QString transform_to_local_vars(const QString& code, const std::vector<VariableInfo>& variables) {
+    // one prologue and one epilogue line per variable, sized up front
+    qsizetype names_length = 0;
+    for (const auto& var_info : variables)
+        names_length += static_cast<qsizetype>(var_info.name.size());
+
     QString result;
+    result.reserve(code.size() + 2 * names_length + static_cast<qsizetype>(variables.size()) * 44 + 2);
 
     for (const auto& var_info : variables) {
         QString var_name = QString::fromStdString(var_info.name);
-        result += result +  var_name + " = variables.get('" + var_name + "')\n";
+        result += var_name;
+        result += " = variables.get('";
+        result += var_name;
+        result += "')\n";
     }
     result += "\n";
 
@@ -126,7 +139,11 @@ QString transform_to_local_vars(const QString& code, const std::vector<VariableI
 
     for (const auto& var_info : variables) {
         QString var_name = QString::fromStdString(var_info.name);
-        result += "fsm.set_variable('" + var_name + "', " + var_name + ")\n";
+        result += "fsm.set_variable('";
+        result += var_name;
+        result += "', ";
+        result += var_name;
+        result += ")\n";
     }
 
     //for (const auto& var_pair : variables) {
@@ -136,16 +153,181 @@ QString transform_to_local_vars(const QString& code, const std::vector<VariableI
     return result;
 }
 
+VariableNameSet make_variable_name_set(const std::vector<VariableInfo>& variables) {
+    VariableNameSet names;
+    names.reserve(variables.size());
+    for (const auto& var_info : variables)
+        names.insert(var_info.name);
+    return names;
+}
+
+// Identifier characters, bytes of multi byte UTF-8 sequences count as letters
+static bool is_identifier_char(unsigned char c) {
+    return isalnum(c) || c == '_' || c >= 0x80;
+}
+
 // Helper to replace variable names in code with variables.get('<name>')
+QString replace_variables_with_get(const std::string& code, const VariableNameSet& names, VariableReads* reads) {
+    static const std::string_view get_prefix = "variables.get('";
+    static const std::string_view get_suffix = "')";
+
+    std::string out;
+    out.reserve(code.size() + code.size() / 2);
+
+    const size_t n = code.size();
+    size_t i = 0;
+    while (i < n) {
+        const unsigned char c = static_cast<unsigned char>(code[i]);
+
+        // string literal, copied with its quotes (triple quoted strings included)
+        if (c == '"' || c == '\'') {
+            const bool triple = i + 2 < n && code[i + 1] == code[i] && code[i + 2] == code[i];
+            const size_t quote_length = triple ? 3 : 1;
+            size_t end = i + quote_length;
+            while (end < n) {
+                if (code[end] == '\\') {
+                    end += 2;
+                    continue;
+                }
+                if (code[end] == code[i] && (!triple || code.compare(end, 3, code, i, 3) == 0)) {
+                    end += quote_length;
+                    break;
+                }
+                if (!triple && code[end] == '\n')
+                    break;
+                end++;
+            }
+            end = std::min(end, n);
+            out.append(code, i, end - i);
+            i = end;
+            continue;
+        }
+
+        // comment up to the end of the line
+        if (c == '#') {
+            size_t end = code.find('\n', i);
+            if (end == std::string::npos)
+                end = n;
+            out.append(code, i, end - i);
+            i = end;
+            continue;
+        }
+
+        if (is_identifier_char(c)) {
+            size_t end = i + 1;
+            while (end < n && is_identifier_char(static_cast<unsigned char>(code[end])))
+                end++;
+
+            const std::string_view word(code.data() + i, end - i);
+            // numbers and attributes are never variables
+            const bool attribute = !out.empty() && out.back() == '.';
+            if (!isdigit(c) && !attribute && names.count(word)) {
+                out.append(get_prefix);
+                out.append(word);
+                out.append(get_suffix);
+                if (reads)
+                    reads->names.emplace(word);
+            } else {
+                // the arguments of the generated function reach every variable
+                if (reads && !attribute && (word == "variables" || word == "fsm"))
+                    reads->dynamic = true;
+                out.append(word);
+            }
+            i = end;
+            continue;
+        }
+
+        out.push_back(static_cast<char>(c));
+        i++;
+    }
+
+    return QString::fromStdString(out);
+}
+
 QString replace_variables_with_get(const QString& code, const std::vector<VariableInfo>& variables) {
-    QString result = code;
-    for (const auto& var_info : variables) {
-        QString var_name = QString::fromStdString(var_info.name);
-        // Using word boundaries to avoid partial replacements
-        QRegularExpression re("\\b" + QRegularExpression::escape(var_name) + "\\b");
-        result.replace(re, "variables.get('" + var_name + "')");
+    return replace_variables_with_get(code.toStdString(), make_variable_name_set(variables));
+}
+
+QString variable_read_set_literal(const std::string& code, const VariableNameSet& names) {
+    VariableReads reads;
+    replace_variables_with_get(code, names, &reads);
+    if (reads.dynamic)
+        return "None";
+    if (reads.names.empty())
+        return "frozenset()";
+
+    QString literal = "frozenset((";
+    for (const auto& name : reads.names)
+        literal += to_python_string_literal(name) + ", ";
+    literal += "))";
+    return literal;
+}
+
+
+// Gives every distinct body one function. Names derived from code are cut to a
+// readable length and get a numeric suffix when two bodies end up with the same name.
+class FunctionNames {
+public:
+    // Name of the body (keyed by kind and code), true if the body is new
+    std::pair<QString, bool> name(const std::string& key, QString base) {
+        auto it = m_byKey.find(key);
+        if (it != m_byKey.end())
+            return {it->second, false};
+
+        static constexpr int max_length = 64;
+        if (base.size() > max_length)
+            base.truncate(max_length);
+        QString name = base;
+        for (int n = 2; m_used.count(name); ++n)
+            name = base + "_" + QString::number(n);
+
+        m_used.insert(name);
+        m_byKey.emplace(key, name);
+        return {name, true};
     }
-    return result;
+
+private:
+    std::unordered_map<std::string, QString> m_byKey;
+    std::set<QString> m_used;
+};
+
+// 64 bit FNV-1a, continued from `seed`
+static uint64_t fingerprint(std::string_view data, uint64_t seed = 14695981039346656037ull) {
+    uint64_t h = seed;
+    for (unsigned char c : data) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    // separates consecutive fields, so ("ab", "c") and ("a", "bc") differ
+    h ^= 0xff;
+    h *= 1099511628211ull;
+    return h;
+}
+
+static uint64_t fingerprint(uint64_t value, uint64_t seed) {
+    return fingerprint(std::string_view(reinterpret_cast<const char*>(&value), sizeof(value)), seed);
+}
+
+/// Calls f(first, last) on disjoint chunks of [0, n), the last chunk on the calling thread.
+template<typename F>
+static void parallelFor(size_t n, unsigned threads, const F& f) {
+    // a few hundred functions are generated faster than threads are started
+    const size_t min_chunk = 256;
+    threads = static_cast<unsigned>(std::min<size_t>(threads, std::max<size_t>(1, n / min_chunk)));
+    if (threads <= 1) {
+        f(size_t(0), n);
+        return;
+    }
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    const size_t chunk = (n + threads - 1) / threads;
+    for (unsigned t = 0; t + 1 < threads; ++t)
+        workers.emplace_back(f, t * chunk, std::min(n, (t + 1) * chunk));
+    f((threads - 1) * chunk, n);
+
+    for (auto& worker : workers)
+        worker.join();
 }
 
 
@@ -155,59 +337,408 @@ InterpretGenerator::InterpretGenerator(QObject *parent)
 
 }
 
-void InterpretGenerator::generate(const Automaton& automaton, const QString& output_filename) {
-    QDir().mkpath(QFileInfo(output_filename).absolutePath()); // Ensure directory exists
+void InterpretGenerator::clearCache() {
+    m_bodies.clear();
+    m_lastScript.clear();
+    m_lastScriptFingerprint = 0;
+    m_lastScriptFunctions = ScriptFunctions();
+    m_lastFunctionsFingerprint = 0;
+    m_lastFingerprint = 0;
+    m_lastFilename.clear();
+    m_lastFileSize = -1;
+}
+
+const QString* InterpretGenerator::cachedBody(uint64_t fingerprint, std::function<QString()> make,
+                                              std::vector<MissingBody>& missing) {
+    // the entries of the cache stay where they are, the pointer is valid until the bodies are dropped
+    auto [it, inserted] = m_bodies.try_emplace(fingerprint);
+    if (inserted)
+        missing.push_back({&it->second.body, std::move(make)});
+    it->second.lastUse = m_generation;
+    return &it->second.body;
+}
+
+void InterpretGenerator::makeMissingBodies(std::vector<MissingBody>& missing, unsigned threads) {
+    ICP_TRACE_SCOPE("InterpretGenerator::makeMissingBodies");
+
+    // every body is made from its own code into its own entry, nothing is shared
+    parallelFor(missing.size(), threads, [&missing](size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i)
+            *missing[i].body = missing[i].make();
+    });
+    missing.clear();
+}
+
+uint64_t InterpretGenerator::automatonFingerprint(const Automaton& automaton) {
+    uint64_t h = fingerprint(automaton.getName());
+    h = fingerprint(automaton.getDescription(), h);
+    h = fingerprint(automaton.getStartName().str(), h);
+
+    // states are unordered, their fingerprints are summed
+    uint64_t states = 0;
+    for (const auto& [name, action] : automaton.getStates()) {
+        uint64_t s = fingerprint(name.str());
+        s = fingerprint(action, s);
+        states += fingerprint(automaton.isFinalState(name) ? 1 : 0, s);
+    }
+    h = fingerprint(states, h);
+
+    // transitions are evaluated in order
+    for (const auto& t : automaton.getTransitions()) {
+        h = fingerprint(t.fromState.str(), h);
+        h = fingerprint(t.toState.str(), h);
+        h = fingerprint(t.condition, h);
+        h = fingerprint(static_cast<uint64_t>(t.delay), h);
+    }
+    for (const auto& var_info : automaton.getVariables()) {
+        h = fingerprint(var_info.name, h);
+        h = fingerprint(var_info.value, h);
+    }
+
+    // an edited definition changes every instance of it
+    for (const auto& definition : automaton.getDefinitions())
+        h = fingerprint(automatonFingerprint(*definition), h);
+    for (const auto& instance : automaton.getInstances()) {
+        h = fingerprint(instance.name, h);
+        h = fingerprint(instance.definition, h);
+        for (const auto& [parameter, variable] : instance.bindings)
+            h = fingerprint(variable, fingerprint(parameter, h));
+    }
+    return h;
+}
+
+void InterpretGenerator::writeStateTable(QTextStream& outfile, const Automaton& automaton, const QString& fsm_name,
+                                         const std::map<QString, QString>& state_action,
+                                         const std::function<QString(const std::string&)>& condition_name) {
+    // dense state ids, transitions of a state are a CSR row in priority order
+    const CompiledAutomaton compiled = CompiledAutomaton::FromAutomaton(automaton);
+    const StateId state_count = static_cast<StateId>(compiled.stateCount());
+
+    outfile << "    # 2. State table, a state is referred to by its index\n";
+    outfile << "    " << fsm_name << ".load_table(\n";
+
+    outfile << "        names=(\n";
+    for (StateId id = 0; id < state_count; ++id)
+        outfile << "            " << to_python_string_literal(compiled.stateName(id)) << ",\n";
+    outfile << "        ),\n";
+
+    outfile << "        actions=(\n";
+    for (StateId id = 0; id < state_count; ++id) {
+        // states used only by transitions have no action
+        auto it = state_action.find(QString::fromStdString(compiled.stateName(id)));
+        outfile << "            " << (it != state_action.end() ? it->second : QString("None")) << ",\n";
+    }
+    outfile << "        ),\n";
+
+    outfile << "        finals=(";
+    for (StateId id = 0; id < state_count; ++id)
+        outfile << (compiled.isFinalState(id) ? "True" : "False") << ", ";
+    outfile << "),\n";
+
+    outfile << "        transitions=(\n";
+    for (StateId id = 0; id < state_count; ++id) {
+        outfile << "            (";
+        for (uint32_t i = compiled.firstTransition(id); i < compiled.lastTransition(id); ++i) {
+            const Transition& t = compiled.transition(i);
+            outfile << "(" << condition_name(std::string(t.condition)) << ", " << compiled.target(i) << ", " << t.delay << ".0), ";
+        }
+        outfile << "), # " << QString::fromStdString(compiled.stateName(id)) << "\n";
+    }
+    outfile << "        ),\n";
+
+    outfile << "        start=" << (compiled.startState() == InvalidStateId ? QString("None") : QString::number(compiled.startState())) << ",\n";
+    outfile << "    )\n\n";
+}
+
+bool InterpretGenerator::generate(const Automaton& automaton, const QString& output_filename) {
+    ICP_TRACE_SCOPE("InterpretGenerator::generate");
+
+    // --- Skip the whole run if the file from the last run is still valid ---
+    const uint64_t automaton_fingerprint = scriptFingerprint(automaton);
+    QFileInfo output_info(output_filename);
+    if (automaton_fingerprint == m_lastFingerprint && output_filename == m_lastFilename
+        && output_info.exists() && output_info.size() == m_lastFileSize) {
+        qDebug() << "Generated interpret is up to date:" << output_filename;
+        return false;
+    }
+
+    QDir().mkpath(output_info.absolutePath()); // Ensure directory exists
 
     QFile file(output_filename);
 
     if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
         qWarning() << "Failed to open file for writing:" << output_filename;
-        return;
+        return false;
     }
 
     QTextStream outfile(&file);
+    writeScript(outfile, automaton);
+    outfile.flush();
+    file.close();
+
+    m_lastFingerprint = automaton_fingerprint;
+    m_lastFilename = output_filename;
+    m_lastFileSize = QFileInfo(output_filename).size();
+    return true;
+}
+
+QByteArray InterpretGenerator::generateScript(const Automaton& automaton) {
+    const uint64_t automaton_fingerprint = scriptFingerprint(automaton);
+    if (automaton_fingerprint == m_lastScriptFingerprint && !m_lastScript.isEmpty())
+        return m_lastScript;
+
+    QString script;
+    script.reserve(m_lastScript.size());
+    QTextStream outfile(&script);
+    writeScript(outfile, automaton);
+    outfile.flush();
+
+    m_lastScript = script.toUtf8();
+    m_lastScriptFingerprint = automaton_fingerprint;
+    return m_lastScript;
+}
+
+const InterpretGenerator::ScriptFunctions& InterpretGenerator::scriptFunctions(const Automaton& automaton) {
+    const uint64_t automaton_fingerprint = scriptFingerprint(automaton);
+    if (automaton_fingerprint == m_lastFunctionsFingerprint && !m_lastScriptFunctions.functions.empty())
+        return m_lastScriptFunctions;
+
+    QString script;
+    QTextStream outfile(&script);
+    ScriptFunctions result;
+    writeScript(outfile, automaton, &result);
+    outfile.flush();
+
+    // the definitions are written one after another, the layout is everything around them
+    QString section;
+    if (m_lazyFunctions) {
+        section = lazyFunctionTable(result.functions);
+    } else {
+        for (const auto& function : result.functions)
+            section += functionDefinition(function);
+    }
+    const qsizetype begin = script.indexOf(section);
+    const QString layout = script.left(begin) + script.mid(begin + section.size());
+
+    // function names depend on the code (conditions) and on sharing, so every name in the
+    // layout is replaced by the index of its first use; equal layouts pair the functions
+    QHash<QString, size_t> by_name;
+    for (size_t i = 0; i < result.functions.size(); ++i)
+        by_name.insert(result.functions[i].name, i);
+    std::vector<size_t> order;
+    QHash<QString, size_t> slot;
+    QString canonical;
+    canonical.reserve(layout.size());
+    static const QRegularExpression identifier("[A-Za-z_][A-Za-z0-9_]*");
+    qsizetype copied = 0;
+    for (auto it = identifier.globalMatch(layout); it.hasNext();) {
+        const QRegularExpressionMatch match = it.next();
+        const auto function = by_name.constFind(match.captured());
+        if (function == by_name.constEnd())
+            continue;
+        auto used = slot.constFind(function.key());
+        if (used == slot.constEnd()) {
+            used = slot.insert(function.key(), order.size());
+            order.push_back(function.value());
+        }
+        canonical += QStringView(layout).mid(copied, match.capturedStart() - copied);
+        canonical += "@" + QString::number(used.value());
+        copied = match.capturedEnd();
+    }
+    canonical += QStringView(layout).mid(copied);
+    for (size_t i = 0; i < result.functions.size(); ++i) {
+        if (!slot.contains(result.functions[i].name))
+            order.push_back(i); // never referred to, kept in name order
+    }
+
+    m_lastScriptFunctions.functions.clear();
+    for (size_t i : order)
+        m_lastScriptFunctions.functions.push_back(std::move(result.functions[i]));
+    const QByteArray canonical_utf8 = canonical.toUtf8();
+    m_lastScriptFunctions.layout = fingerprint(std::string_view(canonical_utf8.constData(), canonical_utf8.size()));
+    m_lastFunctionsFingerprint = automaton_fingerprint;
+    return m_lastScriptFunctions;
+}
+
+QString InterpretGenerator::lazyFunctionTable(const std::vector<ScriptFunction>& functions) {
+    QString table = "LazyFunctions(globals(), (\n";
+    for (const auto& function : functions) {
+        // the definition without the reads line, a condition gets its read set as the third item
+        const QString source = functionDefinition({function.name, function.body, QString()});
+        table += "    (" + to_python_string_literal(function.name.toStdString()) + ", "
+                 + to_python_source_literal(source.toStdString());
+        if (!function.reads.isEmpty())
+            table += ", " + function.reads;
+        table += "),\n";
+    }
+    table += "))\n\n\n";
+    return table;
+}
+
+QString InterpretGenerator::functionDefinition(const ScriptFunction& function) {
+    QString definition = "def " + function.name + "(fsm, variables):\n";
+    for (const auto& line : function.body.split('\n')) {
+        definition += "    " + line + "\n";
+    }
+    // the runtime re-evaluates a condition only when a variable it reads changes
+    if (!function.reads.isEmpty())
+        definition += function.name + ".reads = " + function.reads + "\n";
+    definition += "\n\n";
+    return definition;
+}
+
+uint64_t InterpretGenerator::scriptFingerprint(const Automaton& automaton) const {
+    const uint64_t options = fingerprint(static_cast<uint64_t>(static_cast<int64_t>(m_variableBatchInterval)),
+                                         (m_tableDriven ? 1 : 0) | (m_virtualTime ? 2 : 0)
+                                             | (m_throughputMode ? 4 : 0) | (m_lazyFunctions ? 8 : 0));
+    return fingerprint(options, automatonFingerprint(automaton));
+}
+
+void InterpretGenerator::writeScript(QTextStream& outfile, const Automaton& source, ScriptFunctions* script_functions) {
+    ICP_TRACE_SCOPE("InterpretGenerator::writeScript");
+
+    m_generation++;
+
+    // --- Drop what can never run ---
+    // the optimized copy only lives while the script is written, it is freed at once
+    std::pmr::monotonic_buffer_resource arena;
+    OptimizationStats stats;
+
+    // --- Expand the sub-automata ---
+    // instances with the same bindings get the same code, their functions are shared below
+    std::optional<Automaton> expanded;
+    if (!source.getInstances().empty()) {
+        std::vector<std::string> errors;
+        expanded.emplace(expandSubAutomata(source, &errors, &arena));
+        for (const std::string& error : errors)
+            qWarning() << QString::fromStdString(error);
+    }
+    const Automaton automaton = optimizeAutomaton(expanded ? *expanded : source, &stats, &arena);
+    if (stats.removedStates || stats.removedTransitions || stats.trivialConditions)
+        qDebug() << "Optimized automaton:" << stats.removedStates << "unreachable states,"
+                 << stats.removedTransitions << "dead transitions," << stats.trivialConditions << "trivial guards";
 
     // --- Collect all function names ---
     std::map<QString, QString> functions;
     std::map<QString, QString> state_action;
+    std::map<QString, QString> condition_reads; // condition to the variables it depends on
+    std::unordered_map<std::string, QString> condition_function; // condition code to its function
+    FunctionNames names;
     functions["condition_always_true"] = "return True"; // default condition with no action
+    condition_reads["condition_always_true"] = "frozenset()";
+    names.name("condition:", "condition_always_true");
+
+    const auto& variables = automaton.getVariables();
+    const VariableNameSet variable_names = make_variable_name_set(variables);
+
+    // bodies depend on their code and on the variable names (not on the values)
+    uint64_t names_fingerprint = fingerprint("variables");
+    for (const auto& var_info : variables)
+        names_fingerprint = fingerprint(var_info.name, names_fingerprint);
+
+    const unsigned threads = m_threads ? m_threads : std::max(1u, std::thread::hardware_concurrency());
+
+    // states with the same action share its function, named after the first state by name
+    std::vector<std::pair<Symbol, const std::pmr::string*>> sorted_states;
+    sorted_states.reserve(automaton.getStates().size());
+    for (const auto& pair : automaton.getStates())
+        sorted_states.emplace_back(pair.first, &pair.second);
+    std::sort(sorted_states.begin(), sorted_states.end());
+
+    // sanitize every state name once, transitions refer to the same interned names;
+    // the declared states are sanitized in parallel, the others when first used
+    std::unordered_map<Symbol, QString> py_names;
+    {
+        std::vector<QString> sanitized(sorted_states.size());
+        parallelFor(sorted_states.size(), threads, [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i)
+                sanitized[i] = sanitize_python_identifier(sorted_states[i].first);
+        });
+        py_names.reserve(sorted_states.size());
+        for (size_t i = 0; i < sorted_states.size(); ++i)
+            py_names.emplace(sorted_states[i].first, std::move(sanitized[i]));
+    }
+    auto py_name = [&py_names](Symbol name) -> const QString& {
+        auto it = py_names.find(name);
+        if (it == py_names.end())
+            it = py_names.emplace(name, sanitize_python_identifier(name)).first;
+        return it->second;
+    };
 
-    for (const auto& pair : automaton.getStates()) {
-        if (!pair.second.empty()) { // action
-            QString function_name = "action_" + sanitize_python_identifier(pair.first);
-            QString action_code = transform_to_local_vars(QString::fromStdString(pair.second), automaton.getVariables());;
-            QStringList lines = QString::fromStdString(pair.second).split('\n');
-
-            if (!lines.isEmpty() && lines.first().startsWith("#name=")) {
-                function_name = lines.first().mid(6).trimmed(); // Extract function name after %name=
-            } else if (!lines.isEmpty() && lines.first().startsWith("# Enter code here:")) {
-                action_code = "pass";
-            } else if (action_code.isEmpty()) {
-                action_code = "pass";
-            }
+    // the functions are named in order, the bodies missing in the cache are made
+    // afterwards in parallel and assigned to their functions
+    std::vector<MissingBody> missing;
+    std::vector<std::pair<QString, const QString*>> function_bodies;
+    std::vector<std::pair<QString, const QString*>> function_reads;
+
+    for (const auto& [state, action] : sorted_states) {
+        const std::string code(*action);
+        const bool placeholder = code.empty() || code.compare(0, 18, "# Enter code here:") == 0;
+
+        QString base = "action_" + py_name(state);
+        if (code.compare(0, 6, "#name=") == 0) {
+            // Extract function name after #name=
+            base = QString::fromStdString(code.substr(6, code.find('\n') - 6)).trimmed();
+        } else if (placeholder) {
+            base = "action_pass";
+        }
+
+        // the empty actions are one shared function
+        auto [function_name, inserted] = names.name(placeholder ? std::string("action:") : "action:" + code, base);
+        state_action[QString::fromStdString(state)] = function_name; // state to action name map
+        if (!inserted)
+            continue;
 
-            functions[function_name] = action_code;   // function to function body map
-            state_action[QString::fromStdString(pair.first)] = function_name; // state to action name map
-        } else {
-            QString function_name = "action_" + sanitize_python_identifier(pair.first);
-            
-            functions[function_name] = "pass";   // function to function body map
-            state_action[QString::fromStdString(pair.first)] = function_name; // state to action name map
+        if (placeholder) {
+            functions[function_name] = "pass";
+            continue;
         }
+        function_bodies.emplace_back(function_name, cachedBody(fingerprint(code, fingerprint("action", names_fingerprint)), [code, &variables]() {
+            return transform_to_local_vars(QString::fromStdString(code), variables);
+        }, missing));
     }
 
-    for (const auto& transition : automaton.getTransitions()) {
-        if (!transition.condition.empty()) {
-            QString function_name = "condition_" + sanitize_python_identifier(transition.condition);
-            QString condition_code = replace_variables_with_get(QString::fromStdString(transition.condition), automaton.getVariables());
-            condition_code = "return (" + condition_code + ")";
-
-            functions[function_name] = condition_code;
+    // many transitions share a condition, each one is named and rewritten once
+    std::vector<std::string> conditions;
+    {
+        std::unordered_set<std::string_view> seen;
+        for (const auto& transition : automaton.getTransitions()) {
+            if (!transition.condition.empty() && seen.emplace(transition.condition).second)
+                conditions.emplace_back(transition.condition.data(), transition.condition.size());
         }
     }
+    std::vector<QString> condition_bases(conditions.size());
+    parallelFor(conditions.size(), threads, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i)
+            condition_bases[i] = "condition_" + sanitize_python_identifier(conditions[i]);
+    });
+
+    for (size_t i = 0; i < conditions.size(); ++i) {
+        const std::string& code = conditions[i];
+        auto [function_name, inserted] = names.name("condition:" + code, std::move(condition_bases[i]));
+        if (!inserted)
+            continue;
+        condition_function.emplace(code, function_name);
+
+        function_bodies.emplace_back(function_name, cachedBody(fingerprint(code, fingerprint("condition", names_fingerprint)), [code, &variable_names]() {
+            return "return (" + replace_variables_with_get(code, variable_names) + ")";
+        }, missing));
+        function_reads.emplace_back(function_name, cachedBody(fingerprint(code, fingerprint("reads", names_fingerprint)), [code, &variable_names]() {
+            return variable_read_set_literal(code, variable_names);
+        }, missing));
+    }
+
+    makeMissingBodies(missing, threads);
+    for (const auto& [function_name, body] : function_bodies)
+        functions[function_name] = body->isEmpty() ? QString("pass") : *body;   // function to function body map
+    for (const auto& [function_name, reads] : function_reads)
+        condition_reads[function_name] = *reads;
+    auto condition_name = [&condition_function](const std::string& condition) {
+        return condition.empty() ? QString("condition_always_true") : condition_function.at(condition);
+    };
 
     // --- Python code generation ---
-    outfile << "from fsm_core import FSM, State, Transition\n";
+    outfile << "from fsm_core import FSM, State, Transition, VirtualClock" << (m_lazyFunctions ? ", LazyFunctions" : "") << "\n";
     outfile << "import time\n";
     outfile << "import logging\n\n";
 
@@ -219,98 +750,131 @@ void InterpretGenerator::generate(const Automaton& automaton, const QString& out
 
     outfile << "# --- Define FSM Actions and Conditions ---\n\n";
 
+    // the definitions are indented into separate buffers, written in name order
+    std::vector<ScriptFunction> script_function_list;
+    script_function_list.reserve(functions.size());
     for (const auto& func : functions) {
-        outfile << "def " << func.first << "(fsm, variables):\n";
-        for (const auto& line : func.second.split('\n')) {
-            outfile << "    " << line << "\n";
-        }
-        outfile << "\n\n";
+        auto reads = condition_reads.find(func.first);
+        script_function_list.push_back({func.first, func.second, reads != condition_reads.end() ? reads->second : QString()});
     }
+    if (m_lazyFunctions) {
+        // the sources are only parsed as strings at startup, see fsm_core.LazyFunctions
+        outfile << lazyFunctionTable(script_function_list);
+    } else {
+        std::vector<QString> definitions(script_function_list.size());
+        parallelFor(script_function_list.size(), threads, [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i)
+                definitions[i] = functionDefinition(script_function_list[i]);
+        });
+        for (const QString& definition : definitions)
+            outfile << definition;
+    }
+    if (script_functions)
+        script_functions->functions = std::move(script_function_list);
 
-    outfile << "# --- Main FSM Execution ---\n";
-    outfile << "if __name__ == \"__main__\":\n";
+    // the FSM is built by build_fsm(), so the runtime daemon can load the script
+    // without running the main block
+    outfile << "# --- FSM Construction ---\n";
+    outfile << "def build_fsm():\n";
     outfile << "    # 1. Create the FSM instance\n";
 
     QString fsm_name = sanitize_python_identifier(automaton.getName());
     outfile << "    " << fsm_name << " = FSM()\n\n";
 
-    outfile << "    # 2. Define States\n";
-    std::unordered_map<string, string> states = automaton.getStates();
+    if (m_tableDriven) {
+        writeStateTable(outfile, automaton, fsm_name, state_action, condition_name);
+    } else {
+        outfile << "    # 2. Define States\n";
+        const auto& states = automaton.getStates();
 
-    for (const auto& state : states) {
-        QString py_state_name = sanitize_python_identifier(state.first);
-        outfile << "    state_" << py_state_name << " = State(\n";
-        outfile << "        name=" << to_python_string_literal(state.first) << ",\n";
+        for (const auto& state : states) {
+            QString py_state_name = py_name(state.first);
+            outfile << "    state_" << py_state_name << " = State(\n";
+            outfile << "        name=" << to_python_string_literal(state.first) << ",\n";
 
 
-        outfile << "        action=" << state_action[QString::fromStdString(state.first)] << ",\n";
-        outfile << "        is_start_state=" << (state.first == automaton.getStartName() ? "True" : "False") << ",\n";
-        outfile << "        is_finish_state=" << (automaton.isFinalState(state.first) ? "True" : "False") << "\n";
-        outfile << "    )\n";
-    }
+            outfile << "        action=" << state_action[QString::fromStdString(state.first)] << ",\n";
+            outfile << "        is_start_state=" << (state.first == automaton.getStartName() ? "True" : "False") << ",\n";
+            outfile << "        is_finish_state=" << (automaton.isFinalState(state.first) ? "True" : "False") << "\n";
+            outfile << "    )\n";
+        }
 
-    outfile << "\n";
+        outfile << "\n";
 
-    outfile << "    # 3. Define Transitions\n";
+        outfile << "    # 3. Define Transitions\n";
 
-    int tr_counter = 0;
-    for (const auto& t : automaton.getTransitions()) {
-        QString py_from_state = sanitize_python_identifier(t.fromState);
-        QString py_to_state = sanitize_python_identifier(t.toState);
-        QString tr_var_name = "tr_" + py_from_state + "_to_" + py_to_state + "_" + QString::number(tr_counter++);
+        int tr_counter = 0;
+        for (const auto& t : automaton.getTransitions()) {
+            const QString& py_from_state = py_name(t.fromState);
+            const QString& py_to_state = py_name(t.toState);
+            QString tr_var_name = "tr_" + py_from_state + "_to_" + py_to_state + "_" + QString::number(tr_counter++);
 
-        outfile << "    " << tr_var_name << " = Transition(\n";
-        outfile << "        target_state_name=" << to_python_string_literal(t.toState) << ",\n";
+            outfile << "    " << tr_var_name << " = Transition(\n";
+            outfile << "        target_state_name=" << to_python_string_literal(t.toState) << ",\n";
 
-        QString cond_func = "condition_always_true"; // Default
-        if (!t.condition.empty()) {
-            cond_func = "condition_" + sanitize_python_identifier(t.condition); // this is error prone but whatever
-        }
-        outfile << "        condition=" << cond_func << ",\n";
+            outfile << "        condition=" << condition_name(std::string(t.condition)) << ",\n";
 
-        outfile << "        delay=" << t.delay << ".0\n"; // Ensure it's a float
-        outfile << "    )\n";
-    }
-    outfile << "\n";
+            outfile << "        delay=" << t.delay << ".0\n"; // Ensure it's a float
+            outfile << "    )\n";
+        }
+        outfile << "\n";
 
 
-    outfile << "    # 4. Add Transitions to States\n";
+        outfile << "    # 4. Add Transitions to States\n";
 
-    tr_counter = 0; // Reset for matching variable names
-    for (const auto& t : automaton.getTransitions()) {
-        QString py_from_state_var = "state_" + sanitize_python_identifier(t.fromState);
-        QString py_from_state_name_sanitized = sanitize_python_identifier(t.fromState);
-        QString py_to_state_name_sanitized = sanitize_python_identifier(t.toState);
-        QString tr_var_name = "tr_" + py_from_state_name_sanitized + "_to_" + py_to_state_name_sanitized + "_" + QString::number(tr_counter++);
-        outfile << "    " << py_from_state_var << ".add_transition(" << tr_var_name << ")\n";
-    }
-    outfile << "\n";
+        tr_counter = 0; // Reset for matching variable names
+        for (const auto& t : automaton.getTransitions()) {
+            QString py_from_state_var = "state_" + py_name(t.fromState);
+            const QString& py_from_state_name_sanitized = py_name(t.fromState);
+            const QString& py_to_state_name_sanitized = py_name(t.toState);
+            QString tr_var_name = "tr_" + py_from_state_name_sanitized + "_to_" + py_to_state_name_sanitized + "_" + QString::number(tr_counter++);
+            outfile << "    " << py_from_state_var << ".add_transition(" << tr_var_name << ")\n";
+        }
+        outfile << "\n";
 
 
-    outfile << "    # 5. Add States to FSM\n";
+        outfile << "    # 5. Add States to FSM\n";
 
-    for (const auto& state : states) {
-        QString state_name = sanitize_python_identifier(state.first);
-        QString py_state_var = "state_" + state_name;
-        outfile << "    " << fsm_name << ".add_state(" << py_state_var << ")\n";
+        for (const auto& state : states) {
+            const QString& state_name = py_name(state.first);
+            QString py_state_var = "state_" + state_name;
+            outfile << "    " << fsm_name << ".add_state(" << py_state_var << ")\n";
+        }
+        outfile << "\n";
     }
-    outfile << "\n";
-
 
     outfile << "    # 6. Set Initial Variables\n";
-    if (automaton.getVariables().empty()) {
+    if (variables.empty()) {
         outfile << "    # No initial variables defined in specification.\n";
     }
-    for (const auto& var_info : automaton.getVariables()) {
+    for (const auto& var_info : variables) {
         outfile << "    " << fsm_name << ".set_variable("
                 << to_python_string_literal(var_info.name) << ", "
-                << to_python_value_literal(var_info.value) << ")\n";
+                << to_python_value_literal(var_info.parsed) << ")\n";
     }
-    outfile << "\n";
+    if (m_variableBatchInterval >= 0) {
+        // changed variables go out as one VARIABLES_BATCH per step (or interval)
+        outfile << "    " << fsm_name << ".variable_batch_interval = "
+                << QString::number(m_variableBatchInterval / 1000.0, 'g', 6) << "\n";
+    }
+    if (m_virtualTime) {
+        // delays advance a simulated clock, the run does not wait
+        outfile << "    " << fsm_name << ".clock = VirtualClock()\n";
+    }
+    if (m_throughputMode) {
+        // no per-step logging and events, the current state is sampled
+        outfile << "    " << fsm_name << ".state_event_interval = "
+                << QString::number(kStateSampleIntervalMs / 1000.0, 'g', 6) << "\n";
+    }
+    outfile << "    return " << fsm_name << "\n\n\n";
+
+    outfile << "# --- Main FSM Execution ---\n";
+    outfile << "if __name__ == \"__main__\":\n";
+    outfile << "    " << fsm_name << " = build_fsm()\n\n";
 
     outfile << "    # 7. Connect to client and Run the FSM\n";
     outfile << "    client_host = 'localhost'\n";
-    outfile << "    client_port = 65432 # Default port, change if needed\n\n";
+    outfile << "    client_port = 0 # the OS picks a free port, $FSM_ENDPOINT overrides both; printed as READY <endpoint>\n\n";
     outfile << "    print(f\"Starting FSM '" << fsm_name << "'...\")\n";
     outfile << "    " << fsm_name << ".connect_to_client(host=client_host, port=client_port)\n\n";
     outfile << "    if " << fsm_name << "._client_socket: # Check if connection was successful\n";
@@ -328,5 +892,11 @@ void InterpretGenerator::generate(const Automaton& automaton, const QString& out
     outfile << "    else:\n";
     outfile << "        print(\"FSM did not connect to a client. Exiting.\")\n";
 
-    file.close();
+    // bodies not used by this automaton any more
+    for (auto it = m_bodies.begin(); it != m_bodies.end();) {
+        if (it->second.lastUse != m_generation)
+            it = m_bodies.erase(it);
+        else
+            ++it;
+    }
 }
@@ -31,6 +31,13 @@
 #include <QTextStream>
 #include <algorithm> // For std::replace, std::remove_if
 #include <set>       // For ordered unique function names
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include "spec_parser/automaton-data.hpp"
 
@@ -54,12 +61,22 @@ QString sanitize_python_identifier(std::string name);
 QString to_python_string_literal(const std::string& s);
 
 /**
- * @brief Converts a string value to a Python literal (bool, int, float, or string).
+ * @brief Escapes source code to be a single line Python string literal.
+ *
+ * Like to_python_string_literal(), the line breaks are escaped too.
+ *
+ * @param s The source code.
+ * @return QString The escaped Python string literal.
+ */
+QString to_python_source_literal(const std::string& s);
+
+/**
+ * @brief Converts a typed variable value to a Python literal (None, bool, int, float, or string).
  * 
- * @param val_str The input value as string.
+ * @param value The value, parsed when the variable was declared.
  * @return QString The Python literal representation.
  */
-QString to_python_value_literal(const std::string& val_str);
+QString to_python_value_literal(const VariableValue& value);
 
 /**
  * @brief Generates Python code that creates local variables from the variables dictionary,
@@ -71,6 +88,56 @@ QString to_python_value_literal(const std::string& val_str);
  */
 QString transform_to_local_vars(const QString& code, const std::vector<VariableInfo>& variables);
 
+/**
+ * @brief Set of variable names used by replace_variables_with_get().
+ *
+ * The views point into the names of the VariableInfo list the set was made from,
+ * the list has to outlive the set.
+ */
+using VariableNameSet = std::unordered_set<std::string_view>;
+
+/**
+ * @brief Builds the variable name set once for all code fragments of an automaton.
+ *
+ * @param variables The list of variables.
+ * @return VariableNameSet The set of variable names.
+ */
+VariableNameSet make_variable_name_set(const std::vector<VariableInfo>& variables);
+
+/**
+ * @brief Variables a code fragment reads, collected by replace_variables_with_get().
+ */
+struct VariableReads
+{
+    std::set<std::string> names;  ///< Referenced variables, sorted.
+    bool dynamic = false;         ///< The code uses `variables` or `fsm` itself, it may read any variable.
+};
+
+/**
+ * @brief Replaces variable names in code with variables.get('<name>').
+ *
+ * The code is scanned once: identifiers are looked up in the name set, string
+ * literals, comments, numbers and attribute names (`obj.name`) are copied unchanged.
+ *
+ * @param code The code in which to replace variable names.
+ * @param names The variable names.
+ * @param reads If not null, receives the replaced variables.
+ * @return QString The code with variables replaced by variables.get().
+ */
+QString replace_variables_with_get(const std::string& code, const VariableNameSet& names,
+                                   VariableReads* reads = nullptr);
+
+/**
+ * @brief Python literal of the variables a condition reads.
+ *
+ * The runtime re-evaluates a condition only when one of these variables changes.
+ *
+ * @param code The condition code.
+ * @param names The variable names.
+ * @return QString A frozenset of the names, None if the condition may read any variable.
+ */
+QString variable_read_set_literal(const std::string& code, const VariableNameSet& names);
+
 /**
  * @brief Replaces variable names in code with variables.get('<name>').
  * 
@@ -84,6 +151,28 @@ class InterpretGenerator : public QObject
 {
     Q_OBJECT
 public:
+    /**
+     * @brief An action or condition function of a generated script.
+     */
+    struct ScriptFunction
+    {
+        QString name;
+        QString body;   ///< Python statements, not indented
+        QString reads;  ///< read-set literal of a condition, empty for an action
+    };
+
+    /**
+     * @brief The functions of a generated script, what a running interpret can be patched with.
+     *
+     * The functions are in the order the rest of the script first refers to them. Two
+     * scripts with the same layout differ only in the bodies and names of their functions,
+     * function i of one takes the place of function i of the other.
+     */
+    struct ScriptFunctions
+    {
+        std::vector<ScriptFunction> functions;
+        uint64_t layout = 0;  ///< fingerprint of the rest of the script, the function names replaced by their index
+    };
 
     /**
      * @brief Constructor for InterpretGenerator.
@@ -98,12 +187,226 @@ public:
      * The generated script includes state and transition definitions, action and condition functions,
      * and code to run the FSM and connect to a client.
      * 
+     * Function bodies are cached by the fingerprint of their code and of the variable
+     * names, so only changed actions and conditions are transformed again. If the whole
+     * automaton has the fingerprint of the previous call and the file written then is
+     * still there, nothing is generated at all.
+     *
      * @param automaton The Automaton to generate the Python script from.
      * @param output_filename The path to the output Python file.
+     * @return True if the file was written, false if it was up to date or could not be opened.
+     */
+    bool generate(const Automaton& automaton, const QString& output_filename);
+
+    /**
+     * @brief Generates the Python FSM script into memory, e.g. to pipe it to the interpreter.
+     *
+     * Uses the same body cache as generate(), the script of an unchanged automaton is
+     * returned without generating it again.
+     *
+     * @param automaton The Automaton to generate the Python script from.
+     * @return QByteArray The UTF-8 encoded script.
+     */
+    QByteArray generateScript(const Automaton& automaton);
+
+    /**
+     * @brief Splits the script generated for the automaton into its functions and its layout.
+     *
+     * If the layout equals the one of a running script, the running interpret can be
+     * patched with the changed functions (RELOAD_FUNCTIONS) instead of being restarted.
+     * The result of an unchanged automaton is returned without generating it again.
+     *
+     * @param automaton The Automaton to generate the Python script from.
+     */
+    const ScriptFunctions& scriptFunctions(const Automaton& automaton);
+
+    /**
+     * @brief Returns the Python definition of a function, as it is written to the script.
+     */
+    static QString functionDefinition(const ScriptFunction& function);
+
+    /**
+     * @brief Returns the LazyFunctions table of the functions, as it is written to a lazy script.
+     */
+    static QString lazyFunctionTable(const std::vector<ScriptFunction>& functions);
+
+    /**
+     * @brief Drops the cached function bodies and the fingerprint of the last file.
+     */
+    void clearCache();
+
+    /**
+     * @brief Selects the table driven form of the generated script.
+     *
+     * States get dense integer ids and every state a tuple of (condition, target id,
+     * delay) transitions, loaded with FSM.load_table(). The runtime then runs the
+     * table without looking states up by name. Otherwise State and Transition
+     * objects are built by name.
+     *
+     * @param table_driven True for the table driven script.
+     */
+    void setTableDriven(bool table_driven) { m_tableDriven = table_driven; }
+
+    /**
+     * @brief Checks if the table driven script is generated.
      */
-    void generate(const Automaton& automaton, const QString& output_filename);
+    bool tableDriven() const { return m_tableDriven; }
+
+    /**
+     * @brief Sets how the runtime reports variable changes.
+     *
+     * Unchanged values are never reported. With an interval of 0 the changed values are
+     * sent as one VARIABLES_BATCH per step, a positive interval sends at most one batch
+     * per interval. A negative interval sends a VARIABLE_UPDATE for every change.
+     *
+     * @param interval_ms The minimal time between two batches in milliseconds.
+     */
+    void setVariableBatchInterval(int interval_ms) { m_variableBatchInterval = interval_ms; }
+
+    /**
+     * @brief Returns the interval set by setVariableBatchInterval().
+     */
+    int variableBatchInterval() const { return m_variableBatchInterval; }
+
+    /**
+     * @brief Runs the generated automaton on a virtual clock.
+     *
+     * Delays advance a simulated clock instead of waiting, so the automaton runs as
+     * fast as possible and takes the same transitions as in real time.
+     *
+     * @param virtual_time True for the virtual clock.
+     */
+    void setVirtualTime(bool virtual_time) { m_virtualTime = virtual_time; }
+
+    /**
+     * @brief Checks if the generated automaton runs on a virtual clock.
+     */
+    bool virtualTime() const { return m_virtualTime; }
+
+    /**
+     * @brief Selects the throughput mode of the runtime.
+     *
+     * The runtime does not log the steps and does not report the executed actions and
+     * the taken transitions; CURRENT_STATE is sampled every kStateSampleIntervalMs.
+     * FSM_FINISHED, FSM_STUCK, FSM_ERROR and FSM_STOPPED are sent as usual.
+     *
+     * @param throughput_mode True for the throughput mode.
+     */
+    void setThroughputMode(bool throughput_mode) { m_throughputMode = throughput_mode; }
+
+    /**
+     * @brief Checks if the generated automaton runs in the throughput mode.
+     */
+    bool throughputMode() const { return m_throughputMode; }
+
+    static constexpr int kStateSampleIntervalMs = 100;  ///< CURRENT_STATE interval of the throughput mode
+
+    /**
+     * @brief Selects the lazily compiled functions of the generated script.
+     *
+     * The functions are written as source strings and loaded by fsm_core.LazyFunctions,
+     * which compiles a function the first time it is called. Python then only parses the
+     * strings at startup, the time to the first step hardly depends on the size of the
+     * automaton. A syntax error of a function shows up when it is first called.
+     *
+     * @param lazy_functions True for the lazily compiled functions.
+     */
+    void setLazyFunctions(bool lazy_functions) { m_lazyFunctions = lazy_functions; }
+
+    /**
+     * @brief Checks if the functions of the generated script are compiled lazily.
+     */
+    bool lazyFunctions() const { return m_lazyFunctions; }
+
+    /**
+     * @brief Sets the number of threads generating the functions of a script.
+     *
+     * The bodies and definitions of the functions and the sanitized state names are
+     * made in parallel, and written in the order of the serial generator, so the script
+     * does not depend on the number of threads. Small automata are always generated
+     * on the calling thread.
+     *
+     * @param threads The number of threads, 0 for std::thread::hardware_concurrency(), 1 for serial.
+     */
+    void setThreads(unsigned threads) { m_threads = threads; }
+
+    /**
+     * @brief Returns the number of threads set by setThreads().
+     */
+    unsigned threads() const { return m_threads; }
 
 signals:
+
+private:
+    /// Cached function body and the generate() call that used it last.
+    struct CachedBody
+    {
+        QString body;
+        unsigned lastUse = 0;
+    };
+
+    /// Body of a cache entry that is made by makeMissingBodies().
+    struct MissingBody
+    {
+        QString* body;
+        std::function<QString()> make;
+    };
+
+    /**
+     * @brief Returns the cached body for the fingerprint, an empty one on a cache miss.
+     * @param make Creates the body on a worker thread, it must not use the generator.
+     * @param missing Gets the body made by makeMissingBodies() on a cache miss.
+     */
+    const QString* cachedBody(uint64_t fingerprint, std::function<QString()> make, std::vector<MissingBody>& missing);
+
+    /**
+     * @brief Makes the missing bodies in parallel, each into its cache entry.
+     */
+    static void makeMissingBodies(std::vector<MissingBody>& missing, unsigned threads);
+
+    /**
+     * @brief Fingerprint of everything the generated file depends on.
+     */
+    static uint64_t automatonFingerprint(const Automaton& automaton);
+
+    /**
+     * @brief Fingerprint of the automaton and of the generator mode.
+     */
+    uint64_t scriptFingerprint(const Automaton& automaton) const;
+
+    /**
+     * @brief Writes the whole script to the stream.
+     *
+     * The script is generated from optimizeAutomaton() of the source, so unreachable
+     * states and shadowed transitions are left out.
+     * @param script_functions Gets the written functions in name order, if not nullptr.
+     */
+    void writeScript(QTextStream& outfile, const Automaton& source, ScriptFunctions* script_functions = nullptr);
+
+    /**
+     * @brief Writes the FSM.load_table() call of the table driven script.
+     * @param state_action The action function of every declared state.
+     * @param condition_name Function name of a condition.
+     */
+    static void writeStateTable(QTextStream& outfile, const Automaton& automaton, const QString& fsm_name,
+                                const std::map<QString, QString>& state_action,
+                                const std::function<QString(const std::string&)>& condition_name);
+
+    std::unordered_map<uint64_t, CachedBody> m_bodies;  ///< function bodies by fingerprint
+    bool m_tableDriven = false;                         ///< see setTableDriven()
+    int m_variableBatchInterval = 0;                    ///< see setVariableBatchInterval()
+    bool m_virtualTime = false;                         ///< see setVirtualTime()
+    bool m_throughputMode = false;                      ///< see setThroughputMode()
+    bool m_lazyFunctions = false;                       ///< see setLazyFunctions()
+    unsigned m_threads = 0;                             ///< see setThreads()
+    unsigned m_generation = 0;                          ///< number of generate() calls
+    uint64_t m_lastFingerprint = 0;                     ///< fingerprint of the last written file
+    QString m_lastFilename;                             ///< path of the last written file
+    qint64 m_lastFileSize = -1;                         ///< size of the last written file
+    QByteArray m_lastScript;                            ///< script of the last generateScript() call
+    uint64_t m_lastScriptFingerprint = 0;               ///< fingerprint of m_lastScript
+    ScriptFunctions m_lastScriptFunctions;              ///< result of the last scriptFunctions() call
+    uint64_t m_lastFunctionsFingerprint = 0;            ///< fingerprint of m_lastScriptFunctions
 };
 
 #endif // INTERPRET_GENERATOR_H
@@ -0,0 +1,578 @@
+/**
+ * @file graph-layout.cpp
+ * @brief Implementation of the layered and force-directed graph layouts.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#include "graph-layout.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+
+namespace {
+
+bool cancelled(const LayoutOptions& options)
+{
+    return options.cancel && options.cancel->load(std::memory_order_relaxed);
+}
+
+unsigned threadCount(const LayoutOptions& options)
+{
+    unsigned threads = options.threads ? options.threads : std::thread::hardware_concurrency();
+    return std::max(1u, threads);
+}
+
+/// Calls f(first, last) on disjoint chunks of [0, n), the last chunk on the calling thread.
+template<typename F>
+void parallelFor(uint32_t n, unsigned threads, const F& f)
+{
+    // small inputs are not worth starting threads for
+    const uint32_t minChunk = 512;
+    threads = std::min<unsigned>(threads, std::max<uint32_t>(1, n / minChunk));
+    if (threads <= 1) {
+        f(0u, n);
+        return;
+    }
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    const uint32_t chunk = (n + threads - 1) / threads;
+    for (unsigned t = 0; t + 1 < threads; ++t)
+        workers.emplace_back(f, t * chunk, std::min(n, (t + 1) * chunk));
+    f((threads - 1) * chunk, n);
+
+    for (auto& worker : workers)
+        worker.join();
+}
+
+/// Moves the layout so that its top left corner is (0, 0).
+void normalize(std::vector<LayoutPoint>& points)
+{
+    if (points.empty())
+        return;
+
+    double minX = std::numeric_limits<double>::max();
+    double minY = std::numeric_limits<double>::max();
+    for (const auto& p : points) {
+        minX = std::min(minX, p.x);
+        minY = std::min(minY, p.y);
+    }
+    for (auto& p : points) {
+        p.x -= minX;
+        p.y -= minY;
+    }
+}
+
+/// Region quadtree over the node positions, cells keep their mass and center of mass.
+class QuadTree
+{
+public:
+    struct Cell
+    {
+        double x0, y0, size;        ///< square covered by the cell
+        double sumX = 0.0, sumY = 0.0;
+        uint32_t mass = 0;
+        int32_t firstChild = -1;    ///< the 4 children are stored consecutively
+        int32_t body = -1;          ///< node of a leaf
+    };
+
+    void build(const std::vector<LayoutPoint>& points)
+    {
+        m_cells.clear();
+        m_points = &points;
+
+        double minX = std::numeric_limits<double>::max(), minY = minX;
+        double maxX = std::numeric_limits<double>::lowest(), maxY = maxX;
+        for (const auto& p : points) {
+            minX = std::min(minX, p.x);
+            minY = std::min(minY, p.y);
+            maxX = std::max(maxX, p.x);
+            maxY = std::max(maxY, p.y);
+        }
+
+        Cell root;
+        root.x0 = minX;
+        root.y0 = minY;
+        root.size = std::max({maxX - minX, maxY - minY, 1.0}) * 1.0001;
+        m_cells.reserve(points.size() * 2 + 1);
+        m_cells.push_back(root);
+
+        for (uint32_t i = 0; i < points.size(); ++i)
+            insert(i);
+    }
+
+    /// Repulsion of all nodes acting on node i, `strength / distance` per unit of mass.
+    void repulsion(uint32_t i, double strength, double theta, double& fx, double& fy) const
+    {
+        const LayoutPoint& p = (*m_points)[i];
+        int32_t stack[256];
+        int top = 0;
+        stack[top++] = 0;
+
+        while (top > 0) {
+            const Cell& cell = m_cells[stack[--top]];
+            if (cell.mass == 0)
+                continue;
+
+            const double cx = cell.sumX / cell.mass;
+            const double cy = cell.sumY / cell.mass;
+            double dx = p.x - cx;
+            double dy = p.y - cy;
+            double d2 = dx * dx + dy * dy;
+
+            if (cell.firstChild < 0) {
+                if (cell.body == static_cast<int32_t>(i))
+                    continue;
+            } else if (cell.size * cell.size >= theta * theta * d2) {
+                // too close to be approximated, open the cell
+                for (int c = 0; c < 4 && top < 256; ++c)
+                    stack[top++] = cell.firstChild + c;
+                continue;
+            }
+
+            if (d2 < 1e-4) {
+                // coincident nodes, push apart in a direction given by the index
+                dx = (i % 2) ? 0.01 : -0.01;
+                dy = (i % 3) ? 0.01 : -0.01;
+                d2 = dx * dx + dy * dy;
+            }
+            const double f = cell.mass * strength / d2;
+            fx += dx * f;
+            fy += dy * f;
+        }
+    }
+
+    /// Center of mass of all nodes.
+    LayoutPoint centroid() const
+    {
+        const Cell& root = m_cells[0];
+        if (root.mass == 0)
+            return LayoutPoint();
+        return LayoutPoint{root.sumX / root.mass, root.sumY / root.mass};
+    }
+
+private:
+    static constexpr int MaxDepth = 40;
+
+    void insert(uint32_t i)
+    {
+        const LayoutPoint& p = (*m_points)[i];
+        int32_t index = 0;
+        int depth = 0;
+
+        while (true) {
+            Cell& cell = m_cells[index];
+            if (cell.firstChild < 0) {
+                if (cell.mass == 0 || depth >= MaxDepth) {
+                    // empty leaf, or too deep to split (coincident nodes share the leaf)
+                    if (cell.mass == 0)
+                        cell.body = static_cast<int32_t>(i);
+                    add(cell, p);
+                    return;
+                }
+                subdivide(index);
+                continue;
+            }
+
+            add(cell, p);
+            index = child(index, p);
+            ++depth;
+        }
+    }
+
+    void subdivide(int32_t index)
+    {
+        const int32_t first = static_cast<int32_t>(m_cells.size());
+        const Cell parent = m_cells[index];
+        const double half = parent.size / 2.0;
+
+        for (int c = 0; c < 4; ++c) {
+            Cell cell;
+            cell.x0 = parent.x0 + ((c & 1) ? half : 0.0);
+            cell.y0 = parent.y0 + ((c & 2) ? half : 0.0);
+            cell.size = half;
+            m_cells.push_back(cell);
+        }
+
+        Cell& cell = m_cells[index];
+        cell.firstChild = first;
+
+        // move the body of the former leaf one level down
+        const int32_t body = cell.body;
+        cell.body = -1;
+        Cell& target = m_cells[child(index, (*m_points)[body])];
+        target.body = body;
+        target.mass = cell.mass;
+        target.sumX = cell.sumX;
+        target.sumY = cell.sumY;
+    }
+
+    int32_t child(int32_t index, const LayoutPoint& p) const
+    {
+        const Cell& cell = m_cells[index];
+        const double half = cell.size / 2.0;
+        const int c = ((p.x >= cell.x0 + half) ? 1 : 0) | ((p.y >= cell.y0 + half) ? 2 : 0);
+        return cell.firstChild + c;
+    }
+
+    static void add(Cell& cell, const LayoutPoint& p)
+    {
+        cell.mass++;
+        cell.sumX += p.x;
+        cell.sumY += p.y;
+    }
+
+    std::vector<Cell> m_cells;
+    const std::vector<LayoutPoint>* m_points = nullptr;
+};
+
+/**
+ * Pushes apart nodes closer than `distance`, which the forces alone leave around
+ * nodes with many neighbours. Close pairs are found with a uniform grid of cells of
+ * the size `distance`, one pass is O(n) for a spread out layout.
+ */
+void removeOverlaps(std::vector<LayoutPoint>& points, double distance, int passes, const LayoutOptions& options)
+{
+    const double d2Min = distance * distance;
+    std::unordered_map<uint64_t, std::vector<uint32_t>> grid;
+    grid.reserve(points.size());
+
+    auto key = [](int64_t cx, int64_t cy) {
+        return (static_cast<uint64_t>(cx) << 32) ^ static_cast<uint32_t>(cy);
+    };
+
+    for (int pass = 0; pass < passes && !cancelled(options); ++pass) {
+        grid.clear();
+        for (uint32_t i = 0; i < points.size(); ++i) {
+            grid[key(static_cast<int64_t>(std::floor(points[i].x / distance)),
+                     static_cast<int64_t>(std::floor(points[i].y / distance)))].push_back(i);
+        }
+
+        bool moved = false;
+        for (uint32_t i = 0; i < points.size(); ++i) {
+            const int64_t cx = static_cast<int64_t>(std::floor(points[i].x / distance));
+            const int64_t cy = static_cast<int64_t>(std::floor(points[i].y / distance));
+
+            for (int64_t gx = cx - 1; gx <= cx + 1; ++gx) {
+                for (int64_t gy = cy - 1; gy <= cy + 1; ++gy) {
+                    auto it = grid.find(key(gx, gy));
+                    if (it == grid.end())
+                        continue;
+
+                    for (uint32_t j : it->second) {
+                        if (j <= i)
+                            continue;
+                        double dx = points[j].x - points[i].x;
+                        double dy = points[j].y - points[i].y;
+                        double d2 = dx * dx + dy * dy;
+                        if (d2 >= d2Min)
+                            continue;
+                        if (d2 < 1e-9) {
+                            dx = 1.0;
+                            dy = 0.0;
+                            d2 = 1.0;
+                        }
+                        const double d = std::sqrt(d2);
+                        const double push = (distance - d) / (2.0 * d);
+                        points[i].x -= dx * push;
+                        points[i].y -= dy * push;
+                        points[j].x += dx * push;
+                        points[j].y += dy * push;
+                        moved = true;
+                    }
+                }
+            }
+        }
+
+        if (!moved)
+            break;
+    }
+}
+
+/// Edges of every node in CSR form.
+struct Adjacency
+{
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> edges;   ///< edge indices
+
+    Adjacency(uint32_t nodeCount, const std::vector<std::pair<uint32_t, uint32_t>>& list)
+        : offsets(nodeCount + 1, 0), edges(list.size())
+    {
+        for (const auto& e : list)
+            offsets[e.first + 1]++;
+        for (uint32_t i = 0; i < nodeCount; ++i)
+            offsets[i + 1] += offsets[i];
+        std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+        for (uint32_t i = 0; i < list.size(); ++i)
+            edges[cursor[list[i].first]++] = i;
+    }
+};
+
+} // namespace
+
+std::vector<char> GraphLayout::backEdges(const LayoutGraph& graph)
+{
+    const uint32_t n = graph.nodeCount;
+    std::vector<char> back(graph.edges.size(), 0);
+    Adjacency out(n, graph.edges);
+
+    enum : char { White, Gray, Black };
+    std::vector<char> color(n, White);
+    std::vector<std::pair<uint32_t, uint32_t>> stack;   // (node, next edge cursor)
+
+    for (uint32_t root = 0; root < n; ++root) {
+        if (color[root] != White)
+            continue;
+
+        color[root] = Gray;
+        stack.emplace_back(root, out.offsets[root]);
+        while (!stack.empty()) {
+            auto& [v, cursor] = stack.back();
+            if (cursor == out.offsets[v + 1]) {
+                color[v] = Black;
+                stack.pop_back();
+                continue;
+            }
+
+            const uint32_t e = out.edges[cursor++];
+            const uint32_t w = graph.edges[e].second;
+            if (color[w] == Gray) {
+                back[e] = 1;
+            } else if (color[w] == White) {
+                color[w] = Gray;
+                stack.emplace_back(w, out.offsets[w]);
+            }
+        }
+    }
+
+    return back;
+}
+
+std::vector<LayoutPoint> GraphLayout::compute(const LayoutGraph& graph, const LayoutOptions& options)
+{
+    LayoutAlgorithm algorithm = options.algorithm;
+
+    if (algorithm == LayoutAlgorithm::Automatic) {
+        const std::vector<char> back = backEdges(graph);
+        const size_t backCount = std::count(back.begin(), back.end(), 1);
+        algorithm = (!graph.edges.empty() && backCount * 10 <= graph.edges.size())
+                        ? LayoutAlgorithm::Layered
+                        : LayoutAlgorithm::ForceDirected;
+    }
+
+    return (algorithm == LayoutAlgorithm::Layered) ? layered(graph, options)
+                                                   : forceDirected(graph, options);
+}
+
+std::vector<LayoutPoint> GraphLayout::layered(const LayoutGraph& graph, const LayoutOptions& options)
+{
+    const uint32_t n = graph.nodeCount;
+    std::vector<LayoutPoint> result(n);
+    if (n == 0)
+        return result;
+
+    // 1) make the graph acyclic by reversing the back edges, self loops do not matter
+    const std::vector<char> back = backEdges(graph);
+    std::vector<std::pair<uint32_t, uint32_t>> dag;
+    dag.reserve(graph.edges.size());
+    for (size_t i = 0; i < graph.edges.size(); ++i) {
+        auto [from, to] = graph.edges[i];
+        if (from == to)
+            continue;
+        dag.emplace_back(back[i] ? std::make_pair(to, from) : std::make_pair(from, to));
+    }
+
+    // 2) longest path layering in topological order
+    Adjacency out(n, dag);
+    std::vector<uint32_t> inDegree(n, 0);
+    for (const auto& e : dag)
+        inDegree[e.second]++;
+
+    std::vector<uint32_t> order;
+    order.reserve(n);
+    for (uint32_t v = 0; v < n; ++v)
+        if (inDegree[v] == 0)
+            order.push_back(v);
+
+    std::vector<uint32_t> layer(n, 0);
+    for (size_t i = 0; i < order.size(); ++i) {
+        const uint32_t v = order[i];
+        for (uint32_t k = out.offsets[v]; k < out.offsets[v + 1]; ++k) {
+            const uint32_t w = dag[out.edges[k]].second;
+            layer[w] = std::max(layer[w], layer[v] + 1);
+            if (--inDegree[w] == 0)
+                order.push_back(w);
+        }
+    }
+
+    const uint32_t layerCount = *std::max_element(layer.begin(), layer.end()) + 1;
+    std::vector<std::vector<uint32_t>> layers(layerCount);
+    for (uint32_t v : order)
+        layers[layer[v]].push_back(v);
+
+    // 3) crossing reduction, alternating barycenter sweeps over the neighbours in
+    //    the previous layers (down) and in the following layers (up)
+    std::vector<double> rank(n);
+    auto updateRanks = [&rank](const std::vector<uint32_t>& nodes) {
+        const double middle = (static_cast<double>(nodes.size()) - 1.0) / 2.0;
+        for (size_t i = 0; i < nodes.size(); ++i)
+            rank[nodes[i]] = static_cast<double>(i) - middle;
+    };
+    for (const auto& nodes : layers)
+        updateRanks(nodes);
+
+    Adjacency in(n, [&dag] {
+        std::vector<std::pair<uint32_t, uint32_t>> reversed;
+        reversed.reserve(dag.size());
+        for (const auto& e : dag)
+            reversed.emplace_back(e.second, e.first);
+        return reversed;
+    }());
+
+    std::vector<double> barycenter(n);
+    for (int sweep = 0; sweep < options.orderingSweeps && !cancelled(options); ++sweep) {
+        const bool down = (sweep % 2) == 0;
+        const Adjacency& neighbours = down ? in : out;
+
+        for (uint32_t l = 1; l < layerCount; ++l) {
+            auto& nodes = layers[down ? l : layerCount - 1 - l];
+            for (uint32_t v : nodes) {
+                double sum = 0.0;
+                uint32_t count = 0;
+                for (uint32_t k = neighbours.offsets[v]; k < neighbours.offsets[v + 1]; ++k) {
+                    const auto& e = dag[neighbours.edges[k]];
+                    sum += rank[down ? e.first : e.second];
+                    count++;
+                }
+                barycenter[v] = count ? sum / count : rank[v];
+            }
+            std::stable_sort(nodes.begin(), nodes.end(), [&barycenter](uint32_t a, uint32_t b) {
+                return barycenter[a] < barycenter[b];
+            });
+            updateRanks(nodes);
+        }
+    }
+
+    // 4) coordinates, layers are columns centered on the y axis
+    for (uint32_t v = 0; v < n; ++v) {
+        result[v].x = layer[v] * options.layerSpacing;
+        result[v].y = rank[v] * options.nodeSpacing;
+    }
+
+    normalize(result);
+    return result;
+}
+
+std::vector<LayoutPoint> GraphLayout::forceDirected(const LayoutGraph& graph, const LayoutOptions& options)
+{
+    const uint32_t n = graph.nodeCount;
+    std::vector<LayoutPoint> points(n);
+    if (n == 0)
+        return points;
+
+    const double k = options.nodeSpacing;
+    const double side = std::sqrt(static_cast<double>(n)) * k;
+    std::mt19937 random(n);
+
+    // start from the current positions, nodes sharing a position are spread out
+    // (new or imported nodes all sit at the origin)
+    std::uniform_real_distribution<double> place(0.0, side);
+    uint32_t duplicates = n;
+    std::vector<uint32_t> sorted;
+    if (graph.positions.size() == n) {
+        points = graph.positions;
+
+        sorted.resize(n);
+        std::iota(sorted.begin(), sorted.end(), 0);
+        std::sort(sorted.begin(), sorted.end(), [&points](uint32_t a, uint32_t b) {
+            return std::tie(points[a].x, points[a].y) < std::tie(points[b].x, points[b].y);
+        });
+
+        duplicates = 0;
+        for (uint32_t i = 1; i < n; ++i) {
+            const LayoutPoint& a = points[sorted[i - 1]];
+            const LayoutPoint& b = points[sorted[i]];
+            if (a.x == b.x && a.y == b.y)
+                duplicates++;
+        }
+    }
+
+    if (duplicates * 4 >= n) {
+        // mostly collapsed, start from a random placement
+        for (auto& p : points)
+            p = LayoutPoint{place(random), place(random)};
+    } else {
+        std::uniform_real_distribution<double> jitter(-k, k);
+        for (uint32_t i = 1; i < n; ++i) {
+            const LayoutPoint& a = graph.positions[sorted[i - 1]];
+            const LayoutPoint& b = graph.positions[sorted[i]];
+            if (a.x == b.x && a.y == b.y) {
+                points[sorted[i]].x += jitter(random);
+                points[sorted[i]].y += jitter(random);
+            }
+        }
+    }
+
+    const unsigned threads = threadCount(options);
+    const double strength = k * k;
+    const double gravity = 0.05;
+    const double startTemperature = std::max(k, side / 10.0);
+
+    std::vector<LayoutPoint> displacement(n);
+    QuadTree tree;
+
+    for (int iteration = 0; iteration < options.iterations && !cancelled(options); ++iteration) {
+        tree.build(points);
+        const LayoutPoint center = tree.centroid();
+
+        // repulsion (Barnes-Hut) and gravity towards the center, in parallel
+        parallelFor(n, threads, [&](uint32_t first, uint32_t last) {
+            for (uint32_t i = first; i < last; ++i) {
+                double fx = 0.0, fy = 0.0;
+                tree.repulsion(i, strength, options.theta, fx, fy);
+                fx -= (points[i].x - center.x) * gravity;
+                fy -= (points[i].y - center.y) * gravity;
+                displacement[i] = LayoutPoint{fx, fy};
+            }
+        });
+
+        // attraction along the edges, d^2 / k
+        for (const auto& [from, to] : graph.edges) {
+            if (from == to)
+                continue;
+            const double dx = points[from].x - points[to].x;
+            const double dy = points[from].y - points[to].y;
+            const double f = std::sqrt(dx * dx + dy * dy) / k;
+            displacement[from].x -= dx * f;
+            displacement[from].y -= dy * f;
+            displacement[to].x += dx * f;
+            displacement[to].y += dy * f;
+        }
+
+        // move by at most the temperature, which cools down linearly
+        const double temperature = startTemperature * (1.0 - static_cast<double>(iteration) / options.iterations) + 1.0;
+        parallelFor(n, threads, [&](uint32_t first, uint32_t last) {
+            for (uint32_t i = first; i < last; ++i) {
+                const double length = std::hypot(displacement[i].x, displacement[i].y);
+                if (length < 1e-9)
+                    continue;
+                const double step = std::min(length, temperature) / length;
+                points[i].x += displacement[i].x * step;
+                points[i].y += displacement[i].y * step;
+            }
+        });
+    }
+
+    removeOverlaps(points, 0.75 * k, 20, options);
+
+    normalize(points);
+    return points;
+}
@@ -0,0 +1,57 @@
+/**
+ * @file layout-job.cpp
+ * @brief Implementation of the LayoutJob class.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#include "layout-job.hpp"
+
+LayoutJob::LayoutJob(QObject *parent)
+    : QObject(parent)
+{
+}
+
+LayoutJob::~LayoutJob()
+{
+    cancel();
+
+    if (m_thread.joinable())
+        m_thread.join();
+}
+
+bool LayoutJob::start(LayoutGraph graph, LayoutOptions options)
+{
+    if (m_running)
+        return false;
+
+    if (m_thread.joinable())
+        m_thread.join();
+
+    m_cancel = false;
+    m_running = true;
+    options.cancel = &m_cancel;
+
+    m_thread = std::thread([this, graph = std::move(graph), options]() {
+        std::vector<LayoutPoint> result = GraphLayout::compute(graph, options);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_result = std::move(result);
+        }
+        m_running = false;
+        emit finished();
+    });
+    return true;
+}
+
+void LayoutJob::cancel()
+{
+    m_cancel = true;
+}
+
+std::vector<LayoutPoint> LayoutJob::takeResult()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return std::move(m_result);
+}
@@ -0,0 +1,85 @@
+/**
+ * @file layout-job.hpp
+ * @brief Declaration of the LayoutJob class, runs GraphLayout on a worker thread.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#ifndef LAYOUT_JOB_HPP
+#define LAYOUT_JOB_HPP
+
+#include <QObject>
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "graph-layout.hpp"
+
+/**
+ * @class LayoutJob
+ * @brief Computes a layout without blocking the UI.
+ *
+ * finished() is emitted from the worker thread, Qt queues it to receivers living
+ * in other threads. The result is then picked up with takeResult().
+ */
+class LayoutJob : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief Constructs the LayoutJob object.
+     * @param parent The parent QObject.
+     */
+    explicit LayoutJob(QObject *parent = nullptr);
+
+    /**
+     * @brief Destructor, cancels the running layout and waits for the worker thread.
+     */
+    ~LayoutJob();
+
+    /**
+     * @brief Starts computing the layout on the worker thread.
+     * @param graph The graph to lay out.
+     * @param options The layout parameters, options.cancel is set by the job.
+     * @return False if a layout is already running.
+     */
+    bool start(LayoutGraph graph, LayoutOptions options);
+
+    /**
+     * @brief Requests the running layout to stop, finished() is still emitted.
+     */
+    void cancel();
+
+    /**
+     * @brief Checks if a layout is being computed.
+     */
+    bool isRunning() const { return m_running; }
+
+    /**
+     * @brief Checks if the last layout was cancelled.
+     */
+    bool wasCancelled() const { return m_cancel; }
+
+    /**
+     * @brief Returns the positions of the finished layout, one per node of the graph.
+     */
+    std::vector<LayoutPoint> takeResult();
+
+signals:
+    /**
+     * @brief Emitted when the worker thread has finished the layout.
+     */
+    void finished();
+
+private:
+    std::thread m_thread;                  ///< The worker thread.
+    std::atomic<bool> m_running{false};    ///< True while the worker thread runs.
+    std::atomic<bool> m_cancel{false};     ///< Set by cancel().
+    std::mutex m_mutex;                    ///< Guards m_result.
+    std::vector<LayoutPoint> m_result;     ///< Result of the last layout.
+};
+
+#endif // LAYOUT_JOB_HPP
@@ -0,0 +1,41 @@
+/**
+ * @file autosave-job.cpp
+ * @brief Implementation of the AutosaveJob class.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#include "autosave-job.hpp"
+
+AutosaveJob::AutosaveJob(QObject *parent)
+    : QObject(parent)
+{
+}
+
+AutosaveJob::~AutosaveJob()
+{
+    // a save is never interrupted, the file would stay at the previous snapshot anyway
+    if (m_thread.joinable())
+        m_thread.join();
+}
+
+bool AutosaveJob::start(FsmSnapshot snapshot, const QString& filename)
+{
+    if (m_running)
+        return false;
+
+    if (m_thread.joinable())
+        m_thread.join();
+
+    m_running = true;
+
+    m_thread = std::thread([this, snapshot = std::move(snapshot), filename = filename.toStdString()]() {
+        const bool ok = writeFsmText(snapshot, filename);
+        if (ok)
+            m_savedGeneration = snapshot.generation;
+        m_running = false;
+        emit finished(ok);
+    });
+    return true;
+}
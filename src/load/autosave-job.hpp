@@ -0,0 +1,75 @@
+/**
+ * @file autosave-job.hpp
+ * @brief Declaration of the AutosaveJob class, writes model snapshots on a worker thread.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#ifndef AUTOSAVE_JOB_HPP
+#define AUTOSAVE_JOB_HPP
+
+#include <QObject>
+#include <QString>
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#include "fsm-snapshot.hpp"
+
+/**
+ * @class AutosaveJob
+ * @brief Saves a snapshot of the model without blocking the UI.
+ *
+ * The snapshot is taken on the UI thread with DynamicPortsModel::TakeSnapshot() and
+ * written with writeFsmText(), so a crash during the save leaves the previous
+ * autosave intact. finished() is emitted from the worker thread.
+ */
+class AutosaveJob : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief Constructs the AutosaveJob object.
+     * @param parent The parent QObject.
+     */
+    explicit AutosaveJob(QObject *parent = nullptr);
+
+    /**
+     * @brief Destructor, waits for the running save.
+     */
+    ~AutosaveJob();
+
+    /**
+     * @brief Starts writing the snapshot on the worker thread.
+     * @param snapshot The snapshot to write.
+     * @param filename The file replaced by the snapshot.
+     * @return False if a save is already running.
+     */
+    bool start(FsmSnapshot snapshot, const QString& filename);
+
+    /**
+     * @brief Checks if a snapshot is being written.
+     */
+    bool isRunning() const { return m_running; }
+
+    /**
+     * @brief Generation of the last successfully written snapshot, 0 if none.
+     */
+    uint64_t savedGeneration() const { return m_savedGeneration; }
+
+signals:
+    /**
+     * @brief Emitted when the worker thread has finished the save.
+     * @param ok False if the file could not be written.
+     */
+    void finished(bool ok);
+
+private:
+    std::thread m_thread;                      ///< The worker thread.
+    std::atomic<bool> m_running{false};        ///< True while the worker thread runs.
+    std::atomic<uint64_t> m_savedGeneration{0}; ///< See savedGeneration().
+};
+
+#endif // AUTOSAVE_JOB_HPP
@@ -0,0 +1,76 @@
+/**
+ * @file buffered-writer.cpp
+ * @brief Implementation of the BufferedWriter class.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#include "buffered-writer.hpp"
+
+#include <charconv>
+#include <cstring>
+
+BufferedWriter::BufferedWriter(const std::string& filename, size_t bufferSize)
+    : m_file(std::fopen(filename.c_str(), "wb")),
+      m_buffer(bufferSize > 0 ? bufferSize : DefaultBufferSize)
+{
+    // the stdio buffer would only copy the data a second time
+    if (m_file)
+        std::setvbuf(m_file, nullptr, _IONBF, 0);
+}
+
+BufferedWriter::~BufferedWriter()
+{
+    close();
+}
+
+BufferedWriter& BufferedWriter::operator<<(std::string_view text)
+{
+    if (text.size() > m_buffer.size() - m_used) {
+        flush();
+        // a text larger than the buffer is written in place
+        if (text.size() >= m_buffer.size()) {
+            if (m_file && std::fwrite(text.data(), 1, text.size(), m_file) != text.size())
+                m_failed = true;
+            return *this;
+        }
+    }
+    std::memcpy(m_buffer.data() + m_used, text.data(), text.size());
+    m_used += text.size();
+    return *this;
+}
+
+BufferedWriter& BufferedWriter::operator<<(char c)
+{
+    if (m_used == m_buffer.size())
+        flush();
+    m_buffer[m_used++] = c;
+    return *this;
+}
+
+BufferedWriter& BufferedWriter::operator<<(int64_t value)
+{
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    return *this << std::string_view(digits, static_cast<size_t>(result.ptr - digits));
+}
+
+bool BufferedWriter::close()
+{
+    if (!m_file)
+        return false;
+
+    flush();
+    if (std::fclose(m_file) != 0)
+        m_failed = true;
+    m_file = nullptr;
+    return !m_failed;
+}
+
+void BufferedWriter::flush()
+{
+    if (m_file && m_used > 0 && std::fwrite(m_buffer.data(), 1, m_used, m_file) != m_used)
+        m_failed = true;
+    m_used = 0;
+}
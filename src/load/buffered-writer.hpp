@@ -0,0 +1,70 @@
+/**
+ * @file buffered-writer.hpp
+ * @brief Declaration of the BufferedWriter class, writes a file through one large buffer.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#ifndef BUFFERED_WRITER_HPP
+#define BUFFERED_WRITER_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @class BufferedWriter
+ * @brief Appends text to a file, the OS is called once per full buffer.
+ *
+ * The memory used does not depend on the amount of written data. Errors are sticky,
+ * close() reports whether everything was written.
+ */
+class BufferedWriter
+{
+public:
+    static constexpr size_t DefaultBufferSize = 1 << 20;
+
+    /**
+     * @brief Opens (truncates) the file.
+     * @param filename The file to write.
+     * @param bufferSize Bytes collected before they are written to the file.
+     */
+    explicit BufferedWriter(const std::string& filename, size_t bufferSize = DefaultBufferSize);
+
+    /**
+     * @brief Flushes and closes the file.
+     */
+    ~BufferedWriter();
+
+    BufferedWriter(const BufferedWriter&) = delete;
+    BufferedWriter& operator=(const BufferedWriter&) = delete;
+
+    /**
+     * @brief Checks if the file is open and no write has failed.
+     */
+    bool ok() const { return m_file && !m_failed; }
+
+    BufferedWriter& operator<<(std::string_view text);
+    BufferedWriter& operator<<(char c);
+    BufferedWriter& operator<<(int64_t value);
+    BufferedWriter& operator<<(int value) { return *this << static_cast<int64_t>(value); }
+
+    /**
+     * @brief Flushes the buffer and closes the file.
+     * @return False if the file could not be opened or a write failed.
+     */
+    bool close();
+
+private:
+    void flush();
+
+    std::FILE* m_file = nullptr;
+    bool m_failed = false;
+    std::vector<char> m_buffer;
+    size_t m_used = 0;
+};
+
+#endif // BUFFERED_WRITER_HPP
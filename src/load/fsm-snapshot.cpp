@@ -0,0 +1,182 @@
+/**
+ * @file fsm-snapshot.cpp
+ * @brief Implementation of writeFsmText().
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#include "fsm-snapshot.hpp"
+#include "buffered-writer.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <system_error>
+#include <unordered_set>
+
+// "INSTANCE name : Definition (parameter = variable, ...)"
+static void writeInstance(BufferedWriter& out, const SubAutomatonInstance& instance)
+{
+    out << "INSTANCE " << instance.name << " : " << instance.definition;
+    if (!instance.bindings.empty()) {
+        out << " (";
+        for (size_t i = 0; i < instance.bindings.size(); ++i)
+            out << (i ? ", " : "") << instance.bindings[i].first << " = " << instance.bindings[i].second;
+        out << ')';
+    }
+    out << '\n';
+}
+
+// MACHINE block of a definition, laid out as the automaton itself from START on
+static void writeDefinition(BufferedWriter& out, const Automaton& definition)
+{
+    out << "MACHINE " << definition.getName() << '\n';
+    out << "    START " << definition.getStartName().str() << '\n';
+    out << "    FINISH [";
+    for (size_t i = 0; i < definition.getFinalStates().size(); ++i)
+        out << (i ? ", " : "") << definition.getFinalStates()[i].str();
+    out << "]\n";
+    out << "    VARS\n";
+    for (const auto& varInfo : definition.getVariables())
+        out << "        " << Automaton::varDataTypeAsString(varInfo.type) << ' ' << varInfo.name << " = " << varInfo.value << '\n';
+    out << "    END\n\n";
+
+    for (const auto& nested : definition.getDefinitions())
+        writeDefinition(out, *nested);
+    for (const SubAutomatonInstance& instance : definition.getInstances())
+        writeInstance(out, instance);
+
+    // the states by name, so a saved definition does not change from save to save
+    std::vector<Symbol> names;
+    names.reserve(definition.getStates().size());
+    for (const auto& state : definition.getStates())
+        names.push_back(state.first);
+    std::sort(names.begin(), names.end());
+    for (Symbol name : names) {
+        out << "STATE " << name.str() << '\n';
+        out << "    ACTION\n";
+        std::string_view rest = definition.getStates().at(name);
+        rest.remove_prefix(std::min(rest.size(), rest.find_first_not_of(" \t\r\n")));
+        while (!rest.empty()) {
+            const size_t newline = rest.find('\n');
+            out << "        " << rest.substr(0, newline) << '\n';
+            rest = (newline == std::string_view::npos) ? std::string_view() : rest.substr(newline + 1);
+        }
+        out << "    END\n\n";
+    }
+
+    for (const Transition& t : definition.getTransitions()) {
+        out << "TRANSITION " << t.fromState.str() << " -> " << t.toState.str() << '\n';
+        out << "    CONDITION " << std::string_view(t.condition) << '\n';
+        out << "    DELAY " << t.delay << "\n\n";
+    }
+    out << "END\n\n";
+}
+
+static void writeText(BufferedWriter& out, const FsmSnapshot& snapshot)
+{
+    // one name or code is converted at a time
+    auto action = [&snapshot](const SnapshotNode& node) {
+        return node.lazyActionSet ? snapshot.source->action(node.lazyAction) : node.action.toStdString();
+    };
+    auto condition = [&snapshot](const SnapshotConnection& connection) {
+        return connection.lazyConditionSet ? snapshot.source->condition(connection.lazyCondition) : connection.condition.toStdString();
+    };
+
+    // nodes data at the begining of the file in the following format:
+    // #state_name;pos_x;pos_y;in_port_count;out_port_count
+    for (const SnapshotNode& node : snapshot.nodes)
+        out << '#' << node.name.toStdString() << ';' << node.posX << ';' << node.posY
+            << ';' << node.inPortCount << ';' << node.outPortCount << '\n';
+
+    // AUTOMATON block
+    out << "AUTOMATON " << snapshot.name.toStdString() << '\n';
+    out << "    DESCRIPTION " << (snapshot.description.isEmpty() ? std::string("\"\"") : snapshot.description.toStdString()) << '\n';
+    out << "    START " << snapshot.nodes[snapshot.startNode].name.toStdString() << '\n';
+
+    // Final states
+    out << "    FINISH [";
+    bool firstFinal = true;
+    for (const SnapshotNode& node : snapshot.nodes) {
+        if (!node.isFinal)
+            continue;
+        if (!firstFinal)
+            out << ", ";
+        out << node.name.toStdString();
+        firstFinal = false;
+    }
+    out << "]\n";
+
+    // Variables block
+    out << "    VARS\n";
+    for (const auto& varInfo : snapshot.variables)
+        out << "        " << Automaton::varDataTypeAsString(varInfo.type) << ' ' << varInfo.name << " = " << varInfo.value << '\n';
+    out << "    END\n\n";
+
+    // Sub-automata, before the states as the parser expects them
+    for (const auto& definition : snapshot.definitions)
+        writeDefinition(out, *definition);
+    std::unordered_set<std::string> instanceNames;
+    for (const SubAutomatonInstance& instance : snapshot.instances) {
+        writeInstance(out, instance);
+        instanceNames.insert(instance.name);
+    }
+    if (!snapshot.instances.empty())
+        out << '\n';
+
+    // States, the action line by line
+    for (const SnapshotNode& node : snapshot.nodes) {
+        if (!instanceNames.empty() && instanceNames.count(node.name.toStdString()))
+            continue;
+        out << "STATE " << node.name.toStdString() << '\n';
+        out << "    ACTION\n";
+
+        const std::string code = action(node);
+        std::string_view rest = code;
+        while (!rest.empty()) {
+            const size_t newline = rest.find('\n');
+            out << "        " << rest.substr(0, newline) << '\n';
+            rest = (newline == std::string_view::npos) ? std::string_view() : rest.substr(newline + 1);
+        }
+
+        out << "    END\n\n";
+    }
+
+    // Transitions
+    for (const SnapshotConnection& connection : snapshot.connections) {
+        out << "TRANSITION " << snapshot.nodes[connection.outNode].name.toStdString()
+            << " -> " << snapshot.nodes[connection.inNode].name.toStdString() << '\n';
+        out << "    CONDITION " << condition(connection) << '\n';
+        out << "    DELAY " << connection.delay << "\n\n";
+    }
+
+    out << "END\n";
+}
+
+bool writeFsmText(const FsmSnapshot& snapshot, const std::string& filename)
+{
+    if (snapshot.startNode < 0 || static_cast<size_t>(snapshot.startNode) >= snapshot.nodes.size())
+        return false;
+
+    const std::string temporary = filename + ".tmp";
+    {
+        BufferedWriter out(temporary);
+        if (!out.ok())
+            return false;
+        writeText(out, snapshot);
+        if (!out.close()) {
+            std::remove(temporary.c_str());
+            return false;
+        }
+    }
+
+    // replaces the old file at once, also where it exists
+    std::error_code error;
+    std::filesystem::rename(temporary, filename, error);
+    if (error) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
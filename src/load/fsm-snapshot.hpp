@@ -0,0 +1,84 @@
+/**
+ * @file fsm-snapshot.hpp
+ * @brief A copy of the graph model that can be saved on any thread.
+ *
+ * The names and codes are QStrings, copying them only shares their data, so taking
+ * a snapshot on the UI thread costs a few words per node and connection. Texts of a
+ * lazy load stay references into the shared LoadedSource.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#ifndef FSM_SNAPSHOT_HPP
+#define FSM_SNAPSHOT_HPP
+
+#include <QString>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "graph-loader.hpp"
+
+/**
+ * @brief A node with the data of its state.
+ */
+struct SnapshotNode
+{
+    QString name;
+    int posX = 0;
+    int posY = 0;
+    int inPortCount = 0;
+    int outPortCount = 0;
+    bool isFinal = false;
+    QString action;
+    std::string_view lazyAction;   ///< Used instead of action if lazyActionSet.
+    bool lazyActionSet = false;
+};
+
+/**
+ * @brief A transition between two nodes.
+ */
+struct SnapshotConnection
+{
+    uint32_t outNode = 0;          ///< Index into FsmSnapshot::nodes.
+    uint32_t inNode = 0;           ///< Index into FsmSnapshot::nodes.
+    QString condition;
+    std::string_view lazyCondition; ///< Used instead of condition if lazyConditionSet.
+    bool lazyConditionSet = false;
+    int delay = 0;
+};
+
+/**
+ * @brief Everything the .fsm text format stores.
+ */
+struct FsmSnapshot
+{
+    uint64_t generation = 0;       ///< DynamicPortsModel::Generation() when the snapshot was taken.
+    QString name;
+    QString description;           ///< As written after DESCRIPTION, quotes included.
+    int startNode = -1;            ///< Index into nodes, -1 if the start state is not set.
+    std::vector<SnapshotNode> nodes;
+    std::vector<SnapshotConnection> connections;
+    std::vector<VariableInfo> variables;
+    std::vector<std::shared_ptr<const Automaton>> definitions; ///< Sub-automata, written as MACHINE blocks.
+    std::vector<SubAutomatonInstance> instances; ///< Named by their nodes, these have no STATE block.
+    std::shared_ptr<const LoadedSource> source; ///< Keeps the lazy texts mapped.
+};
+
+/**
+ * @brief Writes the snapshot in the .fsm text format.
+ *
+ * The text is written to filename + ".tmp", which then replaces the file in one
+ * rename, so the file is never left half written.
+ *
+ * @param snapshot The snapshot, startNode has to be set.
+ * @param filename The file to replace.
+ * @return False if the file could not be written, the old file is kept then.
+ */
+bool writeFsmText(const FsmSnapshot& snapshot, const std::string& filename);
+
+#endif // FSM_SNAPSHOT_HPP
@@ -0,0 +1,188 @@
+/**
+ * @file graph-loader.cpp
+ * @brief Implementation of loadGraph() and the LoadedSource class.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#include "graph-loader.hpp"
+
+#include "../spec_parser/automaton-binary.hpp"
+#include "../spec_parser/automaton-parser.hpp"
+#include "../spec_parser/compiled-automaton.hpp"
+#include "../spec_parser/mapped-file.hpp"
+#include "../trace/scope-trace.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+
+// parsing is most of the work, resolving the rest of the bar
+static constexpr int kParsedPercent = 60;
+static constexpr size_t kProgressStep = 4096;  ///< nodes between two progress reports
+
+static std::string trimLeadingWhitespace(std::string_view text)
+{
+    auto first = std::find_if(text.begin(), text.end(), [](unsigned char c) { return !std::isspace(c); });
+    return std::string(first, text.end());
+}
+
+LoadedSource::LoadedSource(const std::string& filename)
+    : m_filename(filename)
+{
+    if (AutomatonBinary::IsBinaryFile(filename))
+        m_binary = std::make_unique<MappedAutomaton>(filename);
+    else
+        m_text = std::make_unique<MappedFile>(filename);
+}
+
+LoadedSource::~LoadedSource() = default;
+
+bool LoadedSource::isValid() const
+{
+    return m_binary ? m_binary->isValid() : m_text->ok();
+}
+
+std::string LoadedSource::action(std::string_view ref) const
+{
+    if (m_text)
+        return trimLeadingWhitespace(AutomatonParser::DecodeAction(ref));
+    return trimLeadingWhitespace(ref);
+}
+
+bool loadGraph(const std::string& filename, LoadedGraph& graph,
+               const std::atomic<bool>* cancel, const LoadProgress& progress, bool lazyText)
+{
+    ICP_TRACE_SCOPE("loadGraph");
+
+    auto cancelled = [cancel]() { return cancel && cancel->load(std::memory_order_relaxed); };
+    auto report = [&progress](int percent) {
+        if (progress)
+            progress(percent);
+    };
+
+    graph = LoadedGraph();
+    report(0);
+
+    // read the file once, the node header and the automaton are parsed in the same pass;
+    // the automaton is dropped at the end of the load, its strings are freed in one go
+    std::pmr::monotonic_buffer_resource arena;
+    Automaton automaton(&arena);
+    std::vector<StateInfo> statesInfo;
+    SourceText text;
+    if (lazyText) {
+        auto source = std::make_shared<LoadedSource>(filename);
+        if (!source->isValid())
+            std::cerr << "Failed to open file: " << filename << std::endl;
+        else if (source->binary())
+            source->binary()->toAutomaton(automaton, &statesInfo, &text);
+        else
+            AutomatonParser::FromBuffer(source->text()->view(), automaton, &statesInfo, 0, &text);
+        graph.source = std::move(source);
+    } else if (AutomatonBinary::IsBinaryFile(filename)) {
+        AutomatonBinary::FromFile(filename, automaton, &statesInfo);
+    } else {
+        AutomatonParser::FromFile(filename, automaton, &statesInfo);
+    }
+    if (cancelled())
+        return false;
+    report(kParsedPercent);
+
+    const CompiledAutomaton compiled = CompiledAutomaton::FromAutomaton(automaton);
+    graph.name = automaton.getName();
+    graph.description = automaton.getDescription();
+    graph.variables = automaton.getVariables();
+    graph.definitions = automaton.getDefinitions();
+    graph.instances = automaton.getInstances();
+
+    // 1) nodes of the header, with the data of their state
+    std::vector<int32_t> stateNodes(compiled.stateCount(), -1);
+    std::vector<StateId> nodeStates(statesInfo.size(), InvalidStateId);
+    graph.nodes.resize(statesInfo.size());
+    for (size_t i = 0; i < statesInfo.size(); ++i) {
+        const StateInfo& info = statesInfo[i];
+        LoadedNode& node = graph.nodes[i];
+        node.name = info.name;
+        node.posX = info.posX;
+        node.posY = info.posY;
+        node.inPortCount = info.inPortCount;
+        node.outPortCount = info.outPortCount;
+
+        // an instance has no STATE block, it may have no transitions either
+        const bool instance = automaton.findInstance(info.name) != nullptr;
+        if (instance) {
+            node.isFinal = automaton.isFinalState(info.name);
+            if (automaton.getStartName().str() == info.name)
+                graph.startNode = static_cast<int>(i);
+        }
+
+        const StateId state = compiled.stateId(info.name);
+        nodeStates[i] = state;
+        if (state == InvalidStateId)
+            continue;
+        stateNodes[state] = static_cast<int32_t>(i);
+        if (instance)
+            continue;
+
+        if (lazyText) {
+            auto action = text.actions.find(compiled.stateSymbol(state));
+            if (action != text.actions.end())
+                node.actionRef = action->second;
+        } else {
+            node.action = trimLeadingWhitespace(compiled.stateAction(state));
+        }
+        node.isFinal = compiled.isFinalState(state);
+        if (state == compiled.startState())
+            graph.startNode = static_cast<int>(i);
+    }
+
+    // the conditions of a lazy load follow the file order, the compiled rows are a stable sort of it
+    std::vector<std::string_view> conditionRefs;
+    if (lazyText) {
+        conditionRefs.resize(compiled.transitionCount());
+        std::vector<uint32_t> cursor(compiled.stateCount());
+        for (size_t state = 0; state < compiled.stateCount(); ++state)
+            cursor[state] = compiled.firstTransition(static_cast<StateId>(state));
+        const auto& transitions = automaton.getTransitions();
+        for (size_t t = 0; t < transitions.size(); ++t)
+            conditionRefs[cursor[compiled.stateId(transitions[t].fromState)]++] = text.conditions[t];
+    }
+
+    // 2) transitions, out-ports in priority order, in-ports in the order they are taken
+    std::vector<uint32_t> nextInPort(graph.nodes.size(), 0);
+    graph.connections.reserve(compiled.transitionCount());
+    for (size_t i = 0; i < graph.nodes.size(); ++i) {
+        if (i % kProgressStep == 0) {
+            if (cancelled())
+                return false;
+            report(kParsedPercent + static_cast<int>((100 - kParsedPercent) * i / graph.nodes.size()));
+        }
+
+        const StateId state = nodeStates[i];
+        if (state == InvalidStateId || stateNodes[state] != static_cast<int32_t>(i))
+            continue; // a later node with the same name gets the transitions
+
+        uint32_t outPort = 0;
+        for (uint32_t t = compiled.firstTransition(state); t < compiled.lastTransition(state); ++t, ++outPort) {
+            const int32_t target = stateNodes[compiled.target(t)];
+            if (target < 0)
+                continue;
+
+            LoadedConnection connection;
+            connection.outNode = static_cast<uint32_t>(i);
+            connection.outPort = outPort;
+            connection.inNode = static_cast<uint32_t>(target);
+            connection.inPort = nextInPort[target]++;
+            if (lazyText)
+                connection.conditionRef = conditionRefs[t];
+            else
+                connection.condition = compiled.transition(t).condition;
+            connection.delay = compiled.transition(t).delay;
+            graph.connections.push_back(std::move(connection));
+        }
+    }
+
+    report(100);
+    return true;
+}
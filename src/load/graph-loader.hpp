@@ -0,0 +1,137 @@
+/**
+ * @file graph-loader.hpp
+ * @brief Parses a saved automaton into the plain data the graph model is built from.
+ *
+ * Loading a file has two parts: parsing and resolving the transitions to node ports,
+ * which needs no Qt and runs on any thread (loadGraph()), and creating the nodes and
+ * connections, which is done by DynamicPortsModel::ApplyLoadedGraph() on the UI thread
+ * in one batch.
+ *
+ * A lazy load leaves the action and condition texts in the mapped file, the nodes and
+ * connections only reference them and the model materializes a text when it is first
+ * needed, so the memory of a huge automaton scales with its structure.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#ifndef GRAPH_LOADER_HPP
+#define GRAPH_LOADER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../spec_parser/automaton-data.hpp"
+
+class MappedFile;
+class MappedAutomaton;
+
+/// Files of at least this size are loaded lazily by the editor.
+constexpr uint64_t LazyTextThreshold = 16ull << 20;
+
+/**
+ * @brief The mapped file the texts of a lazily loaded graph point into.
+ *
+ * The file has to stay unchanged while it is mapped, DynamicPortsModel materializes
+ * the remaining texts before it overwrites the file.
+ */
+class LoadedSource
+{
+public:
+    /// Maps the file, isValid() is false if it cannot be opened or is not a valid .fsmb file.
+    explicit LoadedSource(const std::string& filename);
+    ~LoadedSource();
+
+    LoadedSource(const LoadedSource&) = delete;
+    LoadedSource& operator=(const LoadedSource&) = delete;
+
+    bool isValid() const;
+    const std::string& filename() const { return m_filename; }
+
+    /// The action referenced by LoadedNode::actionRef, leading whitespace removed.
+    std::string action(std::string_view ref) const;
+    /// The condition referenced by LoadedConnection::conditionRef.
+    std::string condition(std::string_view ref) const { return std::string(ref); }
+
+    const MappedFile* text() const { return m_text.get(); }
+    const MappedAutomaton* binary() const { return m_binary.get(); }
+
+private:
+    std::string m_filename;
+    std::unique_ptr<MappedFile> m_text;         ///< .fsm file, actions are raw ACTION block lines
+    std::unique_ptr<MappedAutomaton> m_binary;  ///< .fsmb file, texts are stored as they are
+};
+
+/**
+ * @brief A node of the node header with the data of its state.
+ */
+struct LoadedNode
+{
+    std::string name;
+    int posX = 0;
+    int posY = 0;
+    int inPortCount = 0;
+    int outPortCount = 0;
+    std::string action;       ///< State action, leading whitespace removed.
+    std::string_view actionRef; ///< Lazy load: the action in LoadedGraph::source, action is empty.
+    bool isFinal = false;
+};
+
+/**
+ * @brief A transition resolved to the ports of two nodes.
+ */
+struct LoadedConnection
+{
+    uint32_t outNode = 0;     ///< Index into LoadedGraph::nodes.
+    uint32_t outPort = 0;
+    uint32_t inNode = 0;      ///< Index into LoadedGraph::nodes.
+    uint32_t inPort = 0;
+    std::string condition;
+    std::string_view conditionRef; ///< Lazy load: the condition in LoadedGraph::source, condition is empty.
+    int delay = 0;
+};
+
+/**
+ * @brief Everything DynamicPortsModel needs to show a loaded automaton.
+ */
+struct LoadedGraph
+{
+    std::string name;
+    std::string description;  ///< As written after DESCRIPTION, quotes included.
+    std::vector<LoadedNode> nodes;
+    std::vector<LoadedConnection> connections;
+    std::vector<VariableInfo> variables;
+    std::vector<std::shared_ptr<const Automaton>> definitions; ///< Sub-automata of the file.
+    std::vector<SubAutomatonInstance> instances; ///< Named by their nodes.
+    int startNode = -1;       ///< Index into nodes, -1 if no node is the start state.
+    std::shared_ptr<const LoadedSource> source; ///< Set by a lazy load, keeps the referenced texts mapped.
+};
+
+/**
+ * @brief Reports the progress of loadGraph() in percent.
+ */
+using LoadProgress = std::function<void(int percent)>;
+
+/**
+ * @brief Parses a text (.fsm) or binary (.fsmb) automaton file and resolves it to nodes.
+ *
+ * Transitions go out of the ports of their state in priority order and come into the
+ * first free in-port of the target; transitions to states without a node are skipped.
+ *
+ * @param filename The file to load.
+ * @param graph Receives the loaded graph.
+ * @param cancel If set during the load, loadGraph() returns early.
+ * @param progress Called with the progress, may be empty.
+ * @param lazyText Reference the actions and conditions instead of copying them.
+ * @return False if the load was cancelled.
+ */
+bool loadGraph(const std::string& filename, LoadedGraph& graph,
+               const std::atomic<bool>* cancel = nullptr, const LoadProgress& progress = LoadProgress(),
+               bool lazyText = false);
+
+#endif // GRAPH_LOADER_HPP
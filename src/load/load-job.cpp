@@ -0,0 +1,64 @@
+/**
+ * @file load-job.cpp
+ * @brief Implementation of the LoadJob class.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#include "load-job.hpp"
+
+LoadJob::LoadJob(QObject *parent)
+    : QObject(parent)
+{
+}
+
+LoadJob::~LoadJob()
+{
+    cancel();
+
+    if (m_thread.joinable())
+        m_thread.join();
+}
+
+bool LoadJob::start(const QString& filename, bool lazyText)
+{
+    if (m_running)
+        return false;
+
+    if (m_thread.joinable())
+        m_thread.join();
+
+    m_cancel = false;
+    m_running = true;
+
+    m_thread = std::thread([this, filename = filename.toStdString(), lazyText]() {
+        LoadedGraph graph;
+        int lastPercent = -1;
+        const bool loaded = loadGraph(filename, graph, &m_cancel, [this, &lastPercent](int percent) {
+            // one queued signal per percent
+            if (percent != lastPercent) {
+                lastPercent = percent;
+                emit progressChanged(percent);
+            }
+        }, lazyText);
+        if (loaded) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_result = std::move(graph);
+        }
+        m_running = false;
+        emit finished();
+    });
+    return true;
+}
+
+void LoadJob::cancel()
+{
+    m_cancel = true;
+}
+
+LoadedGraph LoadJob::takeResult()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return std::move(m_result);
+}
@@ -0,0 +1,92 @@
+/**
+ * @file load-job.hpp
+ * @brief Declaration of the LoadJob class, loads an automaton file on a worker thread.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#ifndef LOAD_JOB_HPP
+#define LOAD_JOB_HPP
+
+#include <QObject>
+#include <QString>
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+#include "graph-loader.hpp"
+
+/**
+ * @class LoadJob
+ * @brief Parses and resolves a file without blocking the UI.
+ *
+ * progressChanged() and finished() are emitted from the worker thread, Qt queues them
+ * to receivers living in other threads. The result is then picked up with takeResult()
+ * and applied with DynamicPortsModel::ApplyLoadedGraph().
+ */
+class LoadJob : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief Constructs the LoadJob object.
+     * @param parent The parent QObject.
+     */
+    explicit LoadJob(QObject *parent = nullptr);
+
+    /**
+     * @brief Destructor, cancels the running load and waits for the worker thread.
+     */
+    ~LoadJob();
+
+    /**
+     * @brief Starts loading the file on the worker thread.
+     * @param filename The .fsm or .fsmb file.
+     * @param lazyText Leave the actions and conditions in the mapped file, see loadGraph().
+     * @return False if a load is already running.
+     */
+    bool start(const QString& filename, bool lazyText = false);
+
+    /**
+     * @brief Requests the running load to stop, finished() is still emitted.
+     */
+    void cancel();
+
+    /**
+     * @brief Checks if a file is being loaded.
+     */
+    bool isRunning() const { return m_running; }
+
+    /**
+     * @brief Checks if the last load was cancelled.
+     */
+    bool wasCancelled() const { return m_cancel; }
+
+    /**
+     * @brief Returns the graph of the finished load.
+     */
+    LoadedGraph takeResult();
+
+signals:
+    /**
+     * @brief Emitted when the progress advances.
+     * @param percent The progress, 0 to 100.
+     */
+    void progressChanged(int percent);
+
+    /**
+     * @brief Emitted when the worker thread has finished the load.
+     */
+    void finished();
+
+private:
+    std::thread m_thread;                  ///< The worker thread.
+    std::atomic<bool> m_running{false};    ///< True while the worker thread runs.
+    std::atomic<bool> m_cancel{false};     ///< Set by cancel().
+    std::mutex m_mutex;                    ///< Guards m_result.
+    LoadedGraph m_result;                  ///< Result of the last load.
+};
+
+#endif // LOAD_JOB_HPP
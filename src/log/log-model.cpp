@@ -0,0 +1,139 @@
+/**
+ * @file log-model.cpp
+ * @brief Implementation of the LogModel and LogFilterModel classes.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#include "log-model.hpp"
+
+#include "../diag/memory-report.hpp"
+
+#include <QBrush>
+#include <QColor>
+#include <algorithm>
+
+LogModel::LogModel(QObject *parent)
+    : QAbstractListModel(parent)
+{
+}
+
+int LogModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_count;
+}
+
+QVariant LogModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_count)
+        return QVariant();
+
+    const LogEntry &entry = entryAt(index.row());
+    switch (role) {
+    case Qt::DisplayRole:
+        return entry.text;
+    case Qt::ForegroundRole:
+        if (entry.category == LogCategory::Error)
+            return QBrush(QColor(200, 30, 30));
+        return QVariant();
+    case CategoryRole:
+        return static_cast<int>(entry.category);
+    default:
+        return QVariant();
+    }
+}
+
+void LogModel::setCapacity(int capacity)
+{
+    capacity = std::max(1, capacity);
+    if (capacity == m_capacity)
+        return;
+
+    // the ring is unrolled, the newest lines that fit are kept
+    beginResetModel();
+    const int kept = std::min(m_count, capacity);
+    QVector<LogEntry> entries;
+    entries.reserve(kept);
+    for (int row = m_count - kept; row < m_count; ++row)
+        entries.append(entryAt(row));
+    m_entries = std::move(entries);
+    m_head = 0;
+    m_count = kept;
+    m_capacity = capacity;
+    endResetModel();
+}
+
+void LogModel::append(const QVector<LogEntry> &entries)
+{
+    if (entries.isEmpty())
+        return;
+
+    // more lines than the ring holds, only the newest ones are kept
+    if (entries.size() >= m_capacity) {
+        beginResetModel();
+        m_entries = entries.mid(entries.size() - m_capacity);
+        m_head = 0;
+        m_count = m_capacity;
+        endResetModel();
+        return;
+    }
+
+    const int overflow = m_count + entries.size() - m_capacity;
+    if (overflow > 0) {
+        beginRemoveRows(QModelIndex(), 0, overflow - 1);
+        m_head = (m_head + overflow) % m_entries.size();
+        m_count -= overflow;
+        endRemoveRows();
+    }
+
+    beginInsertRows(QModelIndex(), m_count, m_count + entries.size() - 1);
+    for (const LogEntry &entry : entries) {
+        // the storage grows until the capacity, then the slots of dropped lines are reused
+        if (m_entries.size() < m_capacity)
+            m_entries.append(entry);
+        else
+            m_entries[(m_head + m_count) % m_entries.size()] = entry;
+        ++m_count;
+    }
+    endInsertRows();
+}
+
+void LogModel::clear()
+{
+    beginResetModel();
+    m_entries.clear();
+    m_head = 0;
+    m_count = 0;
+    endResetModel();
+}
+
+std::size_t LogModel::byteSize() const
+{
+    std::size_t bytes = static_cast<std::size_t>(m_entries.capacity()) * sizeof(LogEntry);
+    for (const LogEntry &entry : m_entries)
+        bytes += MemoryReport::stringBytes(entry.text);
+    return bytes;
+}
+
+LogFilterModel::LogFilterModel(QObject *parent)
+    : QSortFilterProxyModel(parent)
+{
+}
+
+void LogFilterModel::setCategoryVisible(LogCategory category, bool visible)
+{
+    const int mask = visible ? m_visibleCategories | static_cast<int>(category)
+                             : m_visibleCategories & ~static_cast<int>(category);
+    if (mask == m_visibleCategories)
+        return;
+
+    m_visibleCategories = mask;
+    invalidateFilter();
+}
+
+bool LogFilterModel::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const
+{
+    const QModelIndex index = sourceModel()->index(sourceRow, 0, sourceParent);
+    return (index.data(LogModel::CategoryRole).toInt() & m_visibleCategories) != 0;
+}
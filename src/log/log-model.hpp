@@ -0,0 +1,119 @@
+/**
+ * @file log-model.hpp
+ * @brief Declaration of the LogModel and LogFilterModel classes, the bounded run log.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#ifndef LOG_MODEL_HPP
+#define LOG_MODEL_HPP
+
+#include <QAbstractListModel>
+#include <QSortFilterProxyModel>
+#include <QString>
+#include <QVector>
+
+#include <cstddef>
+
+/**
+ * @brief Kind of a log line, the log view filters by it.
+ */
+enum class LogCategory
+{
+    Info       = 0x01,  ///< process, client and protocol events
+    State      = 0x02,  ///< the FSM entered a state
+    Transition = 0x04,  ///< the FSM took a transition
+    Variable   = 0x08,  ///< a variable changed
+    Error      = 0x10   ///< errors of the FSM, the process or the client
+};
+
+/**
+ * @brief One line of the log.
+ */
+struct LogEntry
+{
+    LogCategory category;
+    QString text;
+};
+
+/**
+ * @class LogModel
+ * @brief Ring buffer of the last log lines as a list model.
+ *
+ * Once the capacity is reached, every append drops the oldest lines, so the memory
+ * of the log stays bounded however long the automata run.
+ */
+class LogModel : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    static constexpr int kDefaultCapacity = 10000;  ///< Lines kept by default.
+    static constexpr int CategoryRole = Qt::UserRole + 1;  ///< The LogCategory of the line as int.
+
+    /**
+     * @brief Constructs the LogModel object.
+     * @param parent The parent QObject.
+     */
+    explicit LogModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    /**
+     * @brief Number of lines kept, older lines are dropped.
+     */
+    int capacity() const { return m_capacity; }
+
+    /**
+     * @brief Changes the number of lines kept, drops the oldest lines above it.
+     */
+    void setCapacity(int capacity);
+
+    /**
+     * @brief Appends the lines of a frame with one insert and at most one remove.
+     */
+    void append(const QVector<LogEntry> &entries);
+
+    /**
+     * @brief Removes all lines.
+     */
+    void clear();
+
+    /**
+     * @brief Heap bytes of the ring and the texts of its lines, an estimate for the memory report.
+     */
+    std::size_t byteSize() const;
+
+private:
+    const LogEntry& entryAt(int row) const { return m_entries[(m_head + row) % m_entries.size()]; }
+
+    QVector<LogEntry> m_entries;  ///< Storage of the ring, grows up to the capacity.
+    int m_head = 0;               ///< Slot of the oldest line.
+    int m_count = 0;              ///< Lines in the ring.
+    int m_capacity = kDefaultCapacity;
+};
+
+/**
+ * @class LogFilterModel
+ * @brief Shows the lines of the enabled categories only.
+ */
+class LogFilterModel : public QSortFilterProxyModel
+{
+    Q_OBJECT
+public:
+    explicit LogFilterModel(QObject *parent = nullptr);
+
+    /**
+     * @brief Shows or hides the lines of the category.
+     */
+    void setCategoryVisible(LogCategory category, bool visible);
+
+protected:
+    bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const override;
+
+private:
+    int m_visibleCategories = 0xff;  ///< Mask of the shown LogCategory values.
+};
+
+#endif // LOG_MODEL_HPP
@@ -0,0 +1,81 @@
+/**
+ * @file log-view.cpp
+ * @brief Implementation of the LogView class.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#include "log-view.hpp"
+
+#include <QCheckBox>
+#include <QHBoxLayout>
+#include <QListView>
+#include <QScrollBar>
+#include <QVBoxLayout>
+#include <utility>
+
+LogView::LogView(QWidget *parent)
+    : QWidget(parent)
+    , m_model(new LogModel(this))
+    , m_filter(new LogFilterModel(this))
+    , m_list(new QListView(this))
+{
+    m_filter->setSourceModel(m_model);
+
+    m_list->setModel(m_filter);
+    m_list->setUniformItemSizes(true); // rows are not measured one by one
+    m_list->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_list->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    m_list->setHorizontalScrollBarPolicy(Qt::ScrollBarAsNeeded);
+
+    auto *filters = new QHBoxLayout();
+    filters->setContentsMargins(0, 0, 0, 0);
+    const std::pair<LogCategory, const char*> categories[] = {
+        {LogCategory::State, "State"},
+        {LogCategory::Transition, "Transition"},
+        {LogCategory::Variable, "Variable"},
+        {LogCategory::Error, "Error"},
+        {LogCategory::Info, "Other"},
+    };
+    for (const auto &[category, label] : categories) {
+        auto *checkBox = new QCheckBox(tr(label), this);
+        checkBox->setChecked(true);
+        connect(checkBox, &QCheckBox::toggled, this, [this, category = category](bool checked) {
+            m_filter->setCategoryVisible(category, checked);
+        });
+        filters->addWidget(checkBox);
+    }
+    filters->addStretch();
+
+    auto *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->setSpacing(2);
+    layout->addLayout(filters);
+    layout->addWidget(m_list);
+}
+
+void LogView::append(const QVector<LogEntry> &entries)
+{
+    if (entries.isEmpty())
+        return;
+
+    // the view follows the log only if the user did not scroll up
+    QScrollBar *bar = m_list->verticalScrollBar();
+    const bool atBottom = bar->value() == bar->maximum();
+
+    m_model->append(entries);
+
+    if (atBottom)
+        m_list->scrollToBottom();
+}
+
+void LogView::appendLine(LogCategory category, const QString &text)
+{
+    append({LogEntry{category, text}});
+}
+
+void LogView::clear()
+{
+    m_model->clear();
+}
@@ -0,0 +1,61 @@
+/**
+ * @file log-view.hpp
+ * @brief Declaration of the LogView class, the live log of the runs.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#ifndef LOG_VIEW_HPP
+#define LOG_VIEW_HPP
+
+#include <QWidget>
+#include <QString>
+#include <QVector>
+
+#include "log-model.hpp"
+
+class QListView;
+
+/**
+ * @class LogView
+ * @brief List of the log lines with a category filter.
+ *
+ * The lines are kept by a LogModel and drawn by a QListView with uniform item sizes,
+ * so only the visible rows are laid out. The view follows the newest line unless the
+ * user scrolled up.
+ */
+class LogView : public QWidget
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief Constructs the LogView object.
+     * @param parent The parent widget.
+     */
+    explicit LogView(QWidget *parent = nullptr);
+
+    LogModel* model() const { return m_model; }
+
+    /**
+     * @brief Appends the lines of a frame.
+     */
+    void append(const QVector<LogEntry> &entries);
+
+    /**
+     * @brief Appends one line, prefer append() of the whole frame.
+     */
+    void appendLine(LogCategory category, const QString &text);
+
+    /**
+     * @brief Removes all lines.
+     */
+    void clear();
+
+private:
+    LogModel *m_model;
+    LogFilterModel *m_filter;
+    QListView *m_list;
+};
+
+#endif // LOG_VIEW_HPP
@@ -11,7 +11,8 @@
  * - Initializing and managing the node editor and FSM model.
  * - Handling user actions such as adding states, editing transitions, and saving/loading scenes.
  * - Generating Python FSM scripts and launching the Python interpreter process.
- * - Managing TCP communication with the Python FSM server via FsmClient.
+ * - Keeping a pool of FsmRun objects, each with its own Python process and FsmClient
+ *   or native engine, so several automata run at once.
  * - Updating the UI in response to FSM and process events.
  *
  * @author Josef Ambruz, Jakub Kovařík
@@ -20,8 +21,30 @@
 
 #include "mainwindow.h"
 #include "./ui_mainwindow.h"
+#include "client.hpp"
+#include "diag/memory-view.hpp"
+#include <QDockWidget>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QInputDialog>
+#include <QJsonArray>
+#include <QProcessEnvironment>
+#include <QSignalBlocker>
+#include <QStandardPaths>
+#include <QtNodes/MinimapWidget>
+#include <QtNodes/internal/ConnectionGraphicsObject.hpp>
+#include <QtNodes/internal/NodeGraphicsObject.hpp>
+#include <QtNodes/internal/ScopeTraceHook.hpp>
+#include <algorithm>
+#include <limits>
+#include <tuple>
+#include <utility>
 #include "qcombobox.h"
 #include "qmessagebox.h"
+#include "run/profile-view.hpp"
+#include "search/state-search.hpp"
+#include "trace/scope-trace.hpp"
 
 using QtNodes::BasicGraphicsScene;
 using QtNodes::ConnectionStyle;
@@ -30,6 +53,27 @@ using QtNodes::NodeRole;
 using QtNodes::StyleCollection;
 using QtNodes::NodeId;
 
+static constexpr int kAutosaveIntervalMs = 30000;
+static constexpr int kTransitionFlashMs = 250;  ///< how long a taken transition stays highlighted
+static constexpr int kValidationDelayMs = 400;  ///< pause in the edits before the automaton is validated
+static constexpr std::size_t kVirtualizedSceneNodes = 2000;  ///< larger automata get objects for the visible states only
+static constexpr std::size_t kLazyFunctionStates = 2000;  ///< larger automata compile their functions when first called
+static constexpr int kCheckpointIntervalMs = 10000;  ///< between two checkpoints of a native run
+
+/// Records the scopes of the editor and of the node editor library.
+static void startPerformanceTrace()
+{
+    ScopeTrace::start();
+    QtNodes::setScopeTraceHook(&ScopeTrace::record);
+}
+
+static void stopPerformanceTrace()
+{
+    // without the hook the library scopes do not even read the clock
+    QtNodes::setScopeTraceHook(nullptr);
+    ScopeTrace::stop();
+}
+
 void MainWindow::initializeModel()
 {
     NodeId id1 = graphModel->addNode();
@@ -59,6 +103,41 @@ QAction *createNodeAction(DynamicPortsModel &graphModel, GraphicsView &view)
     return action;
 }
 
+QAction *createInstanceAction(DynamicPortsModel &graphModel, GraphicsView &view)
+{
+    auto action = new QAction(QStringLiteral("Insert Sub-automaton"), &view);
+    QObject::connect(action, &QAction::triggered, [&]() {
+        QPointF posView = view.mapToScene(view.mapFromGlobal(QCursor::pos()));
+
+        // the definitions come from the MACHINE blocks of the loaded file
+        QStringList names;
+        for (const auto &definition : graphModel.Definitions())
+            names << QString::fromStdString(definition->getName());
+        if (names.isEmpty()) {
+            QMessageBox::information(&view, "Insert sub-automaton", "The automaton has no MACHINE definitions.");
+            return;
+        }
+        bool ok = false;
+        const QString definition = QInputDialog::getItem(&view, "Insert sub-automaton", "Definition:", names, 0, false, &ok);
+        if (!ok)
+            return;
+
+        // the first free name of the form <definition><n>, the variables are shared by name
+        QString name;
+        for (int n = 1; name.isEmpty() || graphModel.findNodeByName(name) != QtNodes::InvalidNodeId; ++n)
+            name = definition + QString::number(n);
+
+        NodeId const newId = graphModel.addNode();
+        graphModel.setNodeData(newId, NodeRole::Position, posView);
+        graphModel.setNodeData(newId, NodeRole::InPortCount, 1);
+        graphModel.setNodeData(newId, NodeRole::OutPortCount, 1);
+        graphModel.SetNodeName(newId, name);
+        graphModel.SetNodeInstance(newId, SubAutomatonInstance{name.toStdString(), definition.toStdString(), {}});
+    });
+
+    return action;
+}
+
 void MainWindow::initNodeCanvas()
 {
     graphModel = new DynamicPortsModel();
@@ -67,18 +146,82 @@ void MainWindow::initNodeCanvas()
 
     // Create the QtNode scene
     nodeScene = new BasicGraphicsScene(*graphModel, this);
+    nodeScene->setVirtualizationThreshold(kVirtualizedSceneNodes);
 
     qWarning() << "MODEF FROM SCENE " << &(nodeScene->graphModel());
 
     // Create a View for the scene
-    auto* view = new GraphicsView(nodeScene, this);
-    view->setContextMenuPolicy(Qt::ActionsContextMenu);
-    view->insertAction(view->actions().front(), createNodeAction(*graphModel, *view));
+    nodeView = new GraphicsView(nodeScene, this);
+    nodeView->setContextMenuPolicy(Qt::ActionsContextMenu);
+    nodeView->insertAction(nodeView->actions().front(), createNodeAction(*graphModel, *nodeView));
+    nodeView->addAction(createInstanceAction(*graphModel, *nodeView));
 
     // Add the view with the QtNode scene to our UI
     auto* layout = new QVBoxLayout(ui->nodeCanvasContainer);
     layout->setContentsMargins(0, 0, 0, 0);
-    layout->addWidget(view);
+    layout->addWidget(nodeView);
+
+    // overview of the whole automaton, a click centers the view on the point
+    auto* minimapDock = new QDockWidget("Overview", this);
+    minimapDock->setObjectName("minimapDock");
+    minimapDock->setWidget(new QtNodes::MinimapWidget(*nodeView, minimapDock));
+    addDockWidget(Qt::RightDockWidgetArea, minimapDock);
+    ui->menuView->addAction(minimapDock->toggleViewAction());
+
+    // search of the states, a chosen result is centered in the view
+    searchDock = new QDockWidget("Find state", this);
+    searchDock->setObjectName("searchDock");
+    auto* stateSearch = new StateSearch(*graphModel, searchDock);
+    searchDock->setWidget(stateSearch);
+    addDockWidget(Qt::RightDockWidgetArea, searchDock);
+    searchDock->hide();
+    connect(stateSearch, &StateSearch::stateActivated, this, &MainWindow::showNode);
+    connect(ui->actionFind_state, &QAction::triggered, this, [this, stateSearch]() {
+        searchDock->show();
+        searchDock->raise();
+        stateSearch->activate();
+    });
+
+    // estimated memory by subsystem, collected when the dock is shown or refreshed
+    auto* memoryDock = new QDockWidget("Memory", this);
+    memoryDock->setObjectName("memoryDock");
+    memoryDock->setWidget(new MemoryView([this]() { return collectMemoryReport(); }, memoryDock));
+    addDockWidget(Qt::RightDockWidgetArea, memoryDock);
+    memoryDock->hide();
+    ui->menuView->addAction(memoryDock->toggleViewAction());
+}
+
+MemoryReport MainWindow::collectMemoryReport() const
+{
+    MemoryReport report;
+    graphModel->AddMemoryUsage(report);
+
+    const auto graphics = nodeScene->graphicsMemoryUsage();
+    report.add("Scene: graphics objects", graphics.nodeObjects + graphics.connectionObjects + graphics.pooledObjects,
+               graphics.objectBytes);
+    report.add("Scene: item caches", graphics.cachedNodes, graphics.cacheBytes);
+    report.add("Undo history", static_cast<std::size_t>(nodeScene->undoStack().count()), nodeScene->undoMemoryUsage());
+
+    report.add("Log", static_cast<std::size_t>(ui->logView->model()->rowCount()), ui->logView->model()->byteSize());
+
+    qint64 bufferBytes = 0;
+    for (const FsmRun* run : runs)
+        bufferBytes += run->clientBufferBytes();
+    for (const FsmClient* client : remoteClients)
+        bufferBytes += client->bufferBytes();
+    report.add("Runs: connection buffers", static_cast<std::size_t>(runs.size()), static_cast<std::size_t>(bufferBytes));
+    return report;
+}
+
+void MainWindow::showNode(NodeId const nodeId)
+{
+    // a virtualized scene creates the graphics object once the node is in view
+    nodeView->centerOn(nodeScene->nodeSceneRect(nodeId).center());
+
+    nodeScene->clearSelection();
+    if (auto* node = nodeScene->nodeGraphicsObject(nodeId))
+        node->setSelected(true);
+    onNodeClicked(nodeId);
 }
 
 inline std::string trimToStdString(const QString& str) {
@@ -113,10 +256,17 @@ std::vector<VariableInfo> MainWindow::getVariableRowsAsVector()
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
-    // client and fsm interpret initialization
-    , fsmClient(new FsmClient(this))
-    , pythonFsmProcess(new QProcess(this))
+    , layoutJob(new LayoutJob(this))
+    , loadJob(new LoadJob(this))
+    , autosaveJob(new AutosaveJob(this))
+    , interpretGenerator(new InterpretGenerator(this))
+    , validationJob(new ValidationJob(this))
 {
+    // a trace of the whole session, the scene is built below
+    performanceTraceFile = qEnvironmentVariable("ICP_TRACE_FILE");
+    if (!performanceTraceFile.isEmpty())
+        startPerformanceTrace();
+
     // qt mandatory call
     ui->setupUi(this);
 
@@ -136,247 +286,1023 @@ MainWindow::MainWindow(QWidget *parent)
     // Set up a shortcut for Ctrl+L to clean the log output text edit
     QShortcut *shortcut = new QShortcut(QKeySequence("Ctrl+L"), this);
     connect(shortcut, &QShortcut::activated, this, [this]() {
-        ui->textEdit_logOut->setText("");
+        pendingLogEntries.clear();
+        ui->logView->clear();
     });
 
     connect(nodeScene, &BasicGraphicsScene::nodeClicked, this, &MainWindow::onNodeClicked);
     connect(nodeScene, &BasicGraphicsScene::selectionChanged, this, &MainWindow::onNodeSelectionChanged);
     connect(nodeScene, &BasicGraphicsScene::connectionClicked, this, & MainWindow::onConnectionClicked);
+    // painted [+]/[-] port controls, same semantics as PortAddRemoveWidget
+    connect(nodeScene, &BasicGraphicsScene::portControlClicked, this,
+            [this](NodeId nodeId, QtNodes::PortType portType, QtNodes::PortIndex portIndex, QtNodes::PortControl control) {
+        if (control == QtNodes::PortControl::Add)
+            graphModel->addPort(nodeId, portType, portIndex + 1);
+        else
+            graphModel->removePort(nodeId, portType, portIndex);
+    });
     connect(ui->actionSave_to_file, &QAction::triggered, this, &MainWindow::onSaveToFileClicked);
     connect(ui->actionOpen_from_file, &QAction::triggered, this, &MainWindow::onLoadFromFileClicked);
+    connect(ui->actionOpen_trace, &QAction::triggered, this, &MainWindow::onOpenTraceClicked);
+    ui->actionRecord_performance_trace->setChecked(ScopeTrace::isEnabled());
+    connect(ui->actionRecord_performance_trace, &QAction::toggled, this, &MainWindow::onRecordPerformanceTraceToggled);
+    connect(ui->actionBatch_simulation, &QAction::triggered, this, &MainWindow::onBatchSimulationClicked);
+    connect(ui->actionRun_on_remote_daemons, &QAction::triggered, this, &MainWindow::onRunOnRemoteDaemonsClicked);
+    connect(ui->actionShow_hot_spots, &QAction::triggered, this, &MainWindow::onShowHotSpotsClicked);
+    connect(ui->actionRuntime_statistics, &QAction::triggered, this, &MainWindow::onRuntimeStatisticsClicked);
+    connect(ui->actionResume_from_checkpoint, &QAction::triggered, this, &MainWindow::onResumeFromCheckpointClicked);
+    connect(ui->actionCheckpoint_now, &QAction::triggered, this, &MainWindow::onCheckpointNowClicked);
+    ui->slider_replay->hide(); // shown while a trace is replayed
+
+    // the generated interpret runs on integer state ids
+    interpretGenerator->setTableDriven(true);
+
+    // state, variable and log updates of the runs are drawn at most once per frame
+    uiUpdateTimer.setSingleShot(true);
+    uiUpdateTimer.setInterval(16);
+    connect(&uiUpdateTimer, &QTimer::timeout, this, &MainWindow::flushUiUpdates);
+    transitionFlashTimer.setSingleShot(true);
+    transitionFlashTimer.setInterval(kTransitionFlashMs);
+    connect(&transitionFlashTimer, &QTimer::timeout, this, [this]() { setLiveConnection(std::nullopt); });
+
+    // --- Automatic layout ---
+    connect(layoutJob, &LayoutJob::finished, this, &MainWindow::onLayoutFinished);
+    connect(ui->actionLayout_automatic, &QAction::triggered, this, [this]() { startLayout(LayoutAlgorithm::Automatic); });
+    connect(ui->actionLayout_layered, &QAction::triggered, this, [this]() { startLayout(LayoutAlgorithm::Layered); });
+    connect(ui->actionLayout_force_directed, &QAction::triggered, this, [this]() { startLayout(LayoutAlgorithm::ForceDirected); });
+
+    // --- View ---
+    connect(ui->actionOpenGL_viewport, &QAction::toggled, this, [this](bool checked) {
+        if (!nodeView->setOpenGLViewport(checked)) {
+            ui->actionOpenGL_viewport->setChecked(false);
+            ui->statusbar->showMessage("OpenGL is not available, the view keeps the raster viewport.");
+            return;
+        }
+        nodeView->setBatchedConnections(checked);
+    });
 
-    // --- Connect FsmClient signals ---
-    connect(fsmClient, &FsmClient::connected, this, &MainWindow::onFsmClientConnected);
-    connect(fsmClient, &FsmClient::disconnected, this, &MainWindow::onFsmClientDisconnected);
-    connect(fsmClient, &FsmClient::messageReceived, this, &MainWindow::onFsmClientMessageReceived);
-    connect(fsmClient, &FsmClient::fsmError, this, &MainWindow::onFsmClientError);
+    // --- Embedded Python, only in a build with ICP_EMBEDDED_PYTHON ---
+    ui->actionEmbedded_Python->setEnabled(FsmRun::embeddedAvailable());
 
-    // --- Connect QProcess signals ---
-    connect(pythonFsmProcess, &QProcess::finished, this, &MainWindow::onPythonProcessFinished);
-    connect(pythonFsmProcess, &QProcess::errorOccurred, this, &MainWindow::onPythonProcessError);
-    connect(pythonFsmProcess, &QProcess::stateChanged, this, &MainWindow::onPythonProcessStateChanged);
-    connect(pythonFsmProcess, &QProcess::readyReadStandardOutput, this, &MainWindow::onPythonReadyReadStdOut);
-    connect(pythonFsmProcess, &QProcess::readyReadStandardError, this, &MainWindow::onPythonReadyReadStdErr);
+    // --- File loading ---
+    connect(loadJob, &LoadJob::finished, this, &MainWindow::onLoadFinished);
+
+    // --- Autosave ---
+    savedGeneration = graphModel->Generation();
+    autosaveTimer.setInterval(kAutosaveIntervalMs);
+    connect(&autosaveTimer, &QTimer::timeout, this, &MainWindow::onAutosaveTimeout);
+    connect(autosaveJob, &AutosaveJob::finished, this, [this](bool ok) {
+        if (!ok)
+            ui->logView->appendLine(LogCategory::Error, "AUTOSAVE: Failed to write " + autosavePath());
+    });
+    autosaveTimer.start();
+
+    // --- Validation ---
+    // the edits only mark what changed, the job re-checks those texts and the structure
+    validationTimer.setSingleShot(true);
+    validationTimer.setInterval(kValidationDelayMs);
+    connect(&validationTimer, &QTimer::timeout, this, &MainWindow::startValidation);
+    connect(validationJob, &ValidationJob::finished, this, &MainWindow::onValidationFinished);
+    connect(graphModel, &DynamicPortsModel::nodeCreated, this, [this](NodeId nodeId) {
+        dirtyActions.insert(nodeId);
+        scheduleValidation();
+    });
+    connect(graphModel, &DynamicPortsModel::connectionCreated, this, [this](ConnectionId connId) {
+        dirtyConditions.insert(connId);
+        scheduleValidation();
+    });
+    connect(graphModel, &DynamicPortsModel::nodeDeleted, this, &MainWindow::scheduleValidation);
+    connect(graphModel, &DynamicPortsModel::connectionDeleted, this, &MainWindow::scheduleValidation);
+    connect(graphModel, &DynamicPortsModel::connectionReindexed, this, [this](ConnectionId oldId, ConnectionId newId) {
+        // the condition is validated under the new transition, the old one reads as deleted
+        dirtyConditions.insert(oldId);
+        dirtyConditions.insert(newId);
+        if (lastSelectedConnId == oldId)
+            lastSelectedConnId = newId;
+        scheduleValidation();
+    });
+    connect(graphModel, &DynamicPortsModel::modelReset, this, [this]() {
+        validationResetPending = true;
+        dirtyActions.clear();
+        dirtyConditions.clear();
+        scheduleValidation();
+    });
+    validationLabel = new QLabel(this);
+    ui->statusbar->addPermanentWidget(validationLabel);
+    scheduleValidation();
 }
 
 MainWindow::~MainWindow()
 {
-    // Ensure Python process is terminated if running
-    if (pythonFsmProcess && pythonFsmProcess->state() != QProcess::NotRunning) {
-        qInfo() << "MainWindow destructor: Terminating Python FSM process.";
-        pythonFsmProcess->terminate();
-        if (!pythonFsmProcess->waitForFinished(1000)) {
-            pythonFsmProcess->kill();
-            pythonFsmProcess->waitForFinished();
-        }
-    }
-    // FsmClient and QProcess will be deleted due to parent-child relationship
-    // if fsmClient is connected, its destructor should handle disconnection, hopefully.
+    if (batch)
+        batch->cancel();
+    if (batchThread.joinable())
+        batchThread.join();
+
+    // every run kills its Python process, before the UI it reports to is gone
+    qDeleteAll(runs);
+    runs.clear();
+    // the remote connections close without reporting it
+    for (FsmClient* client : std::as_const(remoteClients))
+        client->disconnect(this);
+    qDeleteAll(remoteClients);
+    remoteClients.clear();
     delete ui;
+
+    if (!performanceTraceFile.isEmpty() && ScopeTrace::isEnabled()) {
+        stopPerformanceTrace();
+        if (!ScopeTrace::writeChromeTrace(performanceTraceFile.toStdString()))
+            qWarning() << "[MainWindow] Failed to write the performance trace" << performanceTraceFile;
+    }
 }
 
 
 /**
- *    FSMCLIENT SLOTS
+ *    FSM RUN SLOTS
  *  ========================================================================
  *  ========================================================================
  */
 
 
-void MainWindow::onFsmClientConnected() {
-    qInfo() << "[MainWindow] Connected to FSM server!";
-    // Update UI (e.g., enable "Send Variable" button, change status label)
-    ui->textEdit_logOut->append("CLIENT: Connected to FSM server.");
+FsmRun* MainWindow::shownRun() const
+{
+    return runs.value(shownRunId, nullptr);
 }
 
-void MainWindow::onFsmClientDisconnected() {
-    qInfo() << "[MainWindow] Disconnected from FSM server.";
-    // Update UI
-    ui->textEdit_logOut->append("CLIENT: Disconnected from FSM server.");
+FsmRun* MainWindow::createRun()
+{
+    auto* run = new FsmRun(++runCounter, this);
+    connect(run, &FsmRun::messageReceived, this, &MainWindow::onRunMessageReceived);
+    connect(run, &FsmRun::logMessage, this, &MainWindow::onRunLogMessage);
+    connect(run, &FsmRun::finished, this, &MainWindow::onRunFinished);
+
+    runs.insert(run->id(), run);
+    ui->comboBox_runs->addItem(run->name(), run->id());
+    showRun(run->id());
+    return run;
 }
 
-void MainWindow::onFsmClientMessageReceived(const QJsonObject& msg) {
-    qInfo() << "[MainWindow] Message from FSM:" << msg;
+void MainWindow::removeRun(int runId)
+{
+    FsmRun* run = runs.take(runId);
+    if (!run)
+        return;
+
+    // the log is kept for a look after the run, it is dropped by the next Run
+    if (!run->logFilePath().isEmpty())
+        staleLogFiles << run->logFilePath();
 
-    QJsonDocument doc(msg);
-    //ui->textEdit_logOut->append("FSM -> CLIENT: " + doc.toJson(QJsonDocument::Compact));
+    const int index = ui->comboBox_runs->findData(runId);
+    if (index >= 0)
+        ui->comboBox_runs->removeItem(index);
 
-    // Connected to FSM
-    if (msg.contains("type") && msg["type"].toString() == "FSM_CONNECTED") {
-        if (msg.contains("payload") && msg["payload"].isObject()) {
-            QJsonObject payload = msg["payload"].toObject();
-            if (payload.contains("message")) {
-                ui->textEdit_logOut->append("FSM: " + payload["message"].toString());
-            }
-        }
+    if (runId == shownRunId) {
+        hasPendingState = false;
+        hasPendingTransition = false;
+        showLiveState(QString());
+        setLiveConnection(std::nullopt);
     }
 
-    // Fsm Start
-    if (msg.contains("type") && msg["type"].toString() == "FSM_STARTED") {
-        if (msg.contains("payload") && msg["payload"].isObject()) {
-            QJsonObject payload = msg["payload"].toObject();
-            if (payload.contains("start_state")) {
-                ui->textEdit_logOut->append("FSM: Started");
-            }
-        }
+    // the run may be the sender of the current signal
+    run->deleteLater();
+}
+
+void MainWindow::stopRuns(FsmRun* keep)
+{
+    const QList<int> ids = runs.keys();
+    for (int id : ids) {
+        FsmRun* run = runs.value(id);
+        if (run == keep)
+            continue;
+        qInfo() << "[MainWindow] Stopping" << run->name();
+        run->terminate();
+        removeRun(id);
     }
+}
 
-    // State changed
-    if (msg.contains("type") && msg["type"].toString() == "CURRENT_STATE") {
-        if (msg.contains("payload") && msg["payload"].isObject()) {
-            QJsonObject payload = msg["payload"].toObject();
-            if (payload.contains("name")) {
-                QString currentStateName = payload["name"].toString();
-                ui->textEdit_logOut->append("FSM: Current State: " + currentStateName);                            // Logging
-                ui->label_currentState->setText("Current State: " + currentStateName);  // Current State label
+void MainWindow::showRun(int runId)
+{
+    shownRunId = runId;
+
+    // the updates of the previously shown run are stale
+    hasPendingState = false;
+    hasPendingTransition = false;
+    hasPendingProfile = false;
+    pendingVariables.clear();
+    setLiveConnection(std::nullopt);
+
+    const int index = ui->comboBox_runs->findData(runId);
+    if (index >= 0 && index != ui->comboBox_runs->currentIndex()) {
+        QSignalBlocker blocker(ui->comboBox_runs);
+        ui->comboBox_runs->setCurrentIndex(index);
+    }
 
-                NodeId currentFsmNodeId = graphModel->findNodeByName(currentStateName);
-                if (currentFsmNodeId != QtNodes::InvalidNodeId) {
+    // the panel shows the state and the variables of this run only
+    FsmRun* run = shownRun();
+    showLiveState(run ? run->currentState() : QString());
+    if (!run)
+        return;
+    applyProfile(run->profile()); // empty for a run that is not profiled
 
-                }
-            }
+    ui->label_currentState->setText(run->currentState().isEmpty() ? QString() : "Current State: " + run->currentState());
+    for (auto it = run->variableValues().constBegin(); it != run->variableValues().constEnd(); ++it) {
+        if (variables.contains(it.key()))
+            onVariableUpdate(it.key(), it.value());
+    }
+}
+
+void MainWindow::appendRunLog(int runId, const QString& line, LogCategory category)
+{
+    // appended by flushUiUpdates, together with the other lines of the frame
+    pendingLogEntries.append(LogEntry{category, "[Run " + QString::number(runId) + "] " + line});
+    scheduleUiUpdate();
+}
+
+void MainWindow::onRunLogMessage(int runId, const QString& line)
+{
+    qInfo() << "[MainWindow] Run" << runId << line;
+    // CLIENT ERROR, ENGINE ERROR and PYTHON PROCESS ERROR lines
+    appendRunLog(runId, line, line.contains("ERROR") ? LogCategory::Error : LogCategory::Info);
+}
+
+void MainWindow::onRunFinished(int runId)
+{
+    qInfo() << "[MainWindow] Run" << runId << "finished.";
+    removeRun(runId);
+}
+
+void MainWindow::on_comboBox_runs_currentIndexChanged(int index)
+{
+    if (index >= 0)
+        showRun(ui->comboBox_runs->itemData(index).toInt());
+}
+
+const QHash<QString, MainWindow::MessageHandler>& MainWindow::messageHandlers()
+{
+    // built once, a message costs one hash lookup instead of a chain of string compares
+    static const QHash<QString, MessageHandler> handlers = {
+        {QStringLiteral("FSM_CONNECTED"),    &MainWindow::onFsmConnected},
+        {QStringLiteral("AUTOMATON_LOADED"), &MainWindow::onAutomatonLoaded},
+        {QStringLiteral("FSM_STARTED"),      &MainWindow::onFsmStarted},
+        {QStringLiteral("CURRENT_STATE"),    &MainWindow::onCurrentState},
+        {QStringLiteral("TRANSITION_TAKEN"), &MainWindow::onTransitionTaken},
+        {QStringLiteral("FSM_STUCK"),        &MainWindow::onFsmStuck},
+        {QStringLiteral("FSM_FINISHED"),     &MainWindow::onFsmFinished},
+        {QStringLiteral("FSM_ERROR"),        &MainWindow::onFsmError},
+        {QStringLiteral("VARIABLES_BATCH"),  &MainWindow::onVariablesBatch},
+        {QStringLiteral("VARIABLE_UPDATE"),  &MainWindow::onVariableUpdateMessage},
+        {QStringLiteral("PROFILE"),          &MainWindow::onProfile},
+        {QStringLiteral("STATS"),            &MainWindow::onStats},
+        {QStringLiteral("FUNCTIONS_RELOADED"), &MainWindow::onFunctionsReloaded},
+    };
+    return handlers;
+}
+
+void MainWindow::onRunMessageReceived(int runId, const QJsonObject& msg) {
+    qDebug() << "[MainWindow] Message from FSM" << runId << ":" << msg;
+
+    const MessageHandler handler = messageHandlers().value(msg["type"].toString());
+    if (handler)
+        (this->*handler)(runId, msg["payload"].toObject());
+}
+
+void MainWindow::onFsmConnected(int runId, const QJsonObject& payload)
+{
+    if (payload.contains("message"))
+        appendRunLog(runId, "FSM: " + payload["message"].toString());
+}
+
+void MainWindow::onAutomatonLoaded(int runId, const QJsonObject&)
+{
+    appendRunLog(runId, "FSM: Automaton loaded");
+}
+
+void MainWindow::onFsmStarted(int runId, const QJsonObject& payload)
+{
+    if (payload.contains("start_state"))
+        appendRunLog(runId, "FSM: Started");
+}
+
+void MainWindow::onCurrentState(int runId, const QJsonObject& payload)
+{
+    if (!payload.contains("name"))
+        return;
+
+    const QString currentStateName = payload["name"].toString();
+    appendRunLog(runId, "FSM: Current State: " + currentStateName, LogCategory::State);
+
+    // only the last state of the frame is drawn
+    if (runId == shownRunId) {
+        pendingState = currentStateName;
+        hasPendingState = true;
+        scheduleUiUpdate();
+    }
+}
+
+void MainWindow::onTransitionTaken(int runId, const QJsonObject& payload)
+{
+    if (payload.contains("delay") && payload.contains("from_state") && payload.contains("to_state")) {
+        QString currentStateName = payload["from_state"].toString();
+        QString nextStateName = payload["to_state"].toString();
+        QString delayMs = QString::number(payload["delay"].toInt());
+        appendRunLog(runId, "FSM: Transitioning: " + currentStateName + " -> " + nextStateName + ", delay: " + delayMs, LogCategory::Transition);
+
+        // like the state, only the last transition of the frame is flashed
+        if (runId == shownRunId) {
+            pendingTransitionFrom = currentStateName;
+            pendingTransitionTo = nextStateName;
+            hasPendingTransition = true;
+            scheduleUiUpdate();
         }
     }
+}
 
-    // Transitioning
-    if (msg.contains("type") && msg["type"].toString() == "TRANSITION_TAKEN") {
-        if (msg.contains("payload") && msg["payload"].isObject()) {
-            QJsonObject payload = msg["payload"].toObject();
-            if (payload.contains("delay") && payload.contains("from_state") && payload.contains("to_state")) {
-                QString currentStateName = payload["from_state"].toString();
-                QString nextStateName = payload["to_state"].toString();
-                QString delayMs = QString::number(payload["delay"].toInt());
-                ui->textEdit_logOut->append("FSM: Transitioning: " + currentStateName + " -> " + nextStateName + ", delay: " + delayMs);
-            }
+void MainWindow::onFsmStuck(int runId, const QJsonObject& payload)
+{
+    if (payload.contains("state_name"))
+        appendRunLog(runId, "FSM: Stuck on " + payload["state_name"].toString() + " state. No valid transition possible.", LogCategory::State);
+}
+
+void MainWindow::onFsmFinished(int runId, const QJsonObject& payload)
+{
+    if (payload.contains("finish_state"))
+        appendRunLog(runId, "FSM: Finished, final state is " + payload["finish_state"].toString(), LogCategory::State);
+}
+
+void MainWindow::onFsmError(int runId, const QJsonObject& payload)
+{
+    if (payload.contains("message"))
+        appendRunLog(runId, "FSM: Error occured: " + payload["message"].toString(), LogCategory::Error);
+}
+
+void MainWindow::onVariablesBatch(int runId, const QJsonObject& payload)
+{
+    // changed variables of one step
+    const QJsonObject changed = payload["variables"].toObject();
+    const bool shown = runId == shownRunId;
+
+    QStringList logged;
+    logged.reserve(changed.size());
+    for (auto it = changed.constBegin(); it != changed.constEnd(); ++it) {
+        const QString value = FsmRun::valueToString(it.value());
+        logged << it.key() + " = " + value;
+        if (shown && variables.contains(it.key()))
+            pendingVariables.insert(it.key(), value);
+    }
+    appendRunLog(runId, "FSM: Variables changed: " + logged.join(", "), LogCategory::Variable);
+
+    if (shown)
+        scheduleUiUpdate();
+}
+
+void MainWindow::onVariableUpdateMessage(int runId, const QJsonObject& payload)
+{
+    if (!payload.contains("name") || !payload.contains("value"))
+        return;
+
+    const QString name = payload["name"].toString();
+    const QJsonValue val = payload["value"];
+    appendRunLog(runId, "FSM: Variable " + name + " changed to: " + val.toString(), LogCategory::Variable);
+
+    // handle the variable change, other runs keep it until they are shown
+    if (runId == shownRunId && variables.contains(name)) {
+        pendingVariables.insert(name, FsmRun::valueToString(val)); // the last value wins
+        scheduleUiUpdate();
+    }
+}
+
+void MainWindow::onProfile(int runId, const QJsonObject& payload)
+{
+    // the counters only grow, the last profile of the frame is drawn
+    if (runId == shownRunId) {
+        pendingProfile = payload;
+        hasPendingProfile = true;
+        scheduleUiUpdate();
+    }
+}
+
+void MainWindow::onStats(int runId, const QJsonObject& payload)
+{
+    auto number = [&payload](const char* key, int precision = 0) {
+        return QString::number(payload[key].toDouble(), 'f', precision);
+    };
+
+    QString line = "FSM: Stats: " + number("steps_per_s", 1) + " steps/s, "
+                   + number("transitions_per_s", 1) + " transitions/s, conditions avg "
+                   + number("condition_avg_us", 2) + " us p99 " + number("condition_p99_us", 2) + " us, "
+                   + number("messages_sent") + " messages sent, " + number("messages_received") + " received";
+    if (!payload["send_queue_bytes"].isNull())
+        line += ", send queue " + number("send_queue_bytes") + " B";
+    if (FsmRun* run = runs.value(runId))
+        line += ", editor queue " + QString::number(run->pendingClientBytes()) + " B";
+    line += ", " + number("coalesced_updates") + " coalesced, " + number("dropped_messages") + " dropped";
+    appendRunLog(runId, line);
+}
+
+void MainWindow::onFunctionsReloaded(int runId, const QJsonObject& payload)
+{
+    if (payload.contains("error")) {
+        appendRunLog(runId, "FSM: Reload failed, the next run restarts the automaton: " + payload["error"].toString(),
+                     LogCategory::Error);
+        return;
+    }
+    QStringList names;
+    for (const QJsonValue& name : payload["functions"].toArray())
+        names << name.toString();
+    appendRunLog(runId, "FSM: Reloaded " + names.join(", "));
+}
+
+void MainWindow::scheduleUiUpdate()
+{
+    if (!uiUpdateTimer.isActive())
+        uiUpdateTimer.start();
+}
+
+void MainWindow::flushUiUpdates()
+{
+    if (!pendingLogEntries.isEmpty()) {
+        // one insert into the log model for the frame
+        ui->logView->append(pendingLogEntries);
+        pendingLogEntries.clear();
+    }
+
+    if (hasPendingState) {
+        ui->label_currentState->setText("Current State: " + pendingState);
+        showLiveState(pendingState);
+        hasPendingState = false;
+    }
+
+    if (hasPendingTransition) {
+        showLiveTransition(pendingTransitionFrom, pendingTransitionTo);
+        hasPendingTransition = false;
+    }
+
+    if (hasPendingProfile) {
+        applyProfile(pendingProfile);
+        hasPendingProfile = false;
+    }
+
+    if (!pendingVariables.isEmpty()) {
+        QWidget* panel = ui->hlayout_variables->parentWidget();
+        if (panel)
+            panel->setUpdatesEnabled(false); // repainted once for all variables
+        for (auto it = pendingVariables.constBegin(); it != pendingVariables.constEnd(); ++it) {
+            if (variables.contains(it.key()))
+                onVariableUpdate(it.key(), it.value());
         }
+        pendingVariables.clear();
+        if (panel)
+            panel->setUpdatesEnabled(true);
     }
+}
 
-    // Fsm stuck
-    if (msg.contains("type") && msg["type"].toString() == "FSM_STUCK") {
-        if (msg.contains("payload") && msg["payload"].isObject()) {
-            QJsonObject payload = msg["payload"].toObject();
-            if (payload.contains("state_name")) {
-                QString currentStateName = payload["state_name"].toString();
-                ui->textEdit_logOut->append("FSM: Stuck on " + currentStateName + " state. No valid transition possible.");
-            }
+void MainWindow::showLiveState(const QString& stateName)
+{
+    const NodeId node = stateName.isEmpty() ? QtNodes::InvalidNodeId : graphModel->findNodeByName(stateName);
+    const NodeId previous = graphModel->SetLiveNode(node);
+    if (previous == node)
+        return;
+
+    // only the two nodes are repainted, the rest of the scene is left alone
+    for (NodeId id : {previous, node}) {
+        if (id == QtNodes::InvalidNodeId)
+            continue;
+        if (auto* ngo = nodeScene->nodeGraphicsObject(id))
+            ngo->update();
+    }
+}
+
+void MainWindow::showLiveTransition(const QString& fromState, const QString& toState)
+{
+    // the messages name the states only, of parallel transitions the one with the highest priority is shown
+    std::optional<ConnectionId> taken;
+    const NodeId fromNode = graphModel->findNodeByName(fromState);
+    const NodeId toNode = graphModel->findNodeByName(toState);
+    if (fromNode != QtNodes::InvalidNodeId && toNode != QtNodes::InvalidNodeId) {
+        for (const ConnectionId& connId : graphModel->allConnectionIds(fromNode)) {
+            if (connId.outNodeId == fromNode && connId.inNodeId == toNode
+                && (!taken || connId.outPortIndex < taken->outPortIndex))
+                taken = connId;
         }
     }
 
-    // Fsm finished
-    if (msg.contains("type") && msg["type"].toString() == "FSM_FINISHED") {
-        if (msg.contains("payload") && msg["payload"].isObject()) {
-            QJsonObject payload = msg["payload"].toObject();
-            if (payload.contains("finish_state")) {
-                QString currentStateName = payload["finish_state"].toString();
-                ui->textEdit_logOut->append("FSM: Finished, final state is " + currentStateName);
-            }
+    setLiveConnection(taken);
+    if (taken)
+        transitionFlashTimer.start();
+}
+
+void MainWindow::setLiveConnection(std::optional<ConnectionId> connId)
+{
+    const std::optional<ConnectionId> previous = graphModel->SetLiveConnection(connId);
+    if (previous == connId)
+        return;
+
+    for (const std::optional<ConnectionId>& id : {previous, connId}) {
+        if (!id)
+            continue;
+        if (auto* cgo = nodeScene->connectionGraphicsObject(*id))
+            cgo->update();
+    }
+}
+
+void MainWindow::applyProfile(const QJsonObject& profile)
+{
+    // nodes are hot by the time spent in the state, connections by the time of their condition
+    std::unordered_map<NodeId, float> nodeHeat;
+    std::unordered_map<ConnectionId, float> connectionHeat;
+
+    const QJsonArray states = profile["states"].toArray();
+    double maxStateMs = 0;
+    for (const QJsonValue& value : states) {
+        const QJsonObject state = value.toObject();
+        maxStateMs = std::max(maxStateMs, state["action_ms"].toDouble() + state["delay_ms"].toDouble());
+    }
+    if (maxStateMs > 0) {
+        for (const QJsonValue& value : states) {
+            const QJsonObject state = value.toObject();
+            const double ms = state["action_ms"].toDouble() + state["delay_ms"].toDouble();
+            const NodeId node = graphModel->findNodeByName(state["name"].toString());
+            if (ms > 0 && node != QtNodes::InvalidNodeId)
+                nodeHeat[node] = static_cast<float>(ms / maxStateMs);
         }
     }
 
-    // Fsm error
-    if (msg.contains("type") && msg["type"].toString() == "FSM_ERROR") {
-        if (msg.contains("payload") && msg["payload"].isObject()) {
-            QJsonObject payload = msg["payload"].toObject();
-            if (payload.contains("message")) {
-                QString error = payload["message"].toString();
-                ui->textEdit_logOut->append("FSM: Error occured: " + error);
+    // the conditions are too fast to time on a coarse clock, then the evaluations count
+    const QJsonArray transitions = profile["transitions"].toArray();
+    const char* metric = "condition_ms";
+    double maxTransition = 0;
+    for (const QJsonValue& value : transitions)
+        maxTransition = std::max(maxTransition, value.toObject()[metric].toDouble());
+    if (maxTransition <= 0) {
+        metric = "evaluations";
+        for (const QJsonValue& value : transitions)
+            maxTransition = std::max(maxTransition, value.toObject()[metric].toDouble());
+    }
+    if (maxTransition > 0) {
+        // the priority of a transition is its index among the out-connections of the state, see ToAutomaton()
+        QHash<NodeId, std::vector<ConnectionId>> outgoing;
+        for (const QJsonValue& value : transitions) {
+            const QJsonObject transition = value.toObject();
+            const double heat = transition[metric].toDouble() / maxTransition;
+            const NodeId fromNode = graphModel->findNodeByName(transition["from_state"].toString());
+            if (heat <= 0 || fromNode == QtNodes::InvalidNodeId)
+                continue;
+
+            auto row = outgoing.find(fromNode);
+            if (row == outgoing.end()) {
+                std::vector<ConnectionId> connections;
+                for (const ConnectionId& connId : graphModel->allConnectionIds(fromNode)) {
+                    if (connId.outNodeId == fromNode)
+                        connections.push_back(connId);
+                }
+                std::sort(connections.begin(), connections.end(), [](const ConnectionId& a, const ConnectionId& b) {
+                    return std::tie(a.outPortIndex, a.inNodeId, a.inPortIndex)
+                           < std::tie(b.outPortIndex, b.inNodeId, b.inPortIndex);
+                });
+                row = outgoing.insert(fromNode, std::move(connections));
             }
+
+            const int priority = transition["priority"].toInt();
+            if (priority < 0 || priority >= static_cast<int>(row->size()))
+                continue; // the graph changed since the run started
+            const ConnectionId& connId = (*row)[priority];
+            if (graphModel->GetNodeName(connId.inNodeId) == transition["to_state"].toString())
+                connectionHeat[connId] = static_cast<float>(heat);
         }
     }
 
-    // Variable update
-    if (msg.contains("type") && msg["type"].toString() == "VARIABLE_UPDATE") {
-        if (msg.contains("payload") && msg["payload"].isObject()) {
-            QJsonObject payload = msg["payload"].toObject();
-            if (payload.contains("name") && payload.contains("value")) {
-                QString name = payload["name"].toString();
-
-                QJsonValue val = payload["value"];
-                QString value;
-                if (val.isString()) {
-                    value = val.toString();
-                } else if (val.isDouble()) {
-                    value = QString::number(val.toDouble());
-                } else if (val.isBool()) {
-                    value = val.toBool() ? "true" : "false";
-                } else if (val.isNull()) {
-                    value = "null";
-                } else {
-                    value = QString::fromUtf8(QJsonDocument(QJsonObject{{"unknown_type", val}}).toJson(QJsonDocument::Compact));
-                }
+    // the items of the previous and the new heatmap are repainted, the rest of the scene is left alone
+    std::vector<NodeId> nodes;
+    std::vector<ConnectionId> connections;
+    for (const auto& [node, heat] : graphModel->NodeHeat())
+        nodes.push_back(node);
+    for (const auto& [connId, heat] : graphModel->ConnectionHeat())
+        connections.push_back(connId);
+    for (const auto& [node, heat] : nodeHeat)
+        nodes.push_back(node);
+    for (const auto& [connId, heat] : connectionHeat)
+        connections.push_back(connId);
+
+    graphModel->SetHeat(std::move(nodeHeat), std::move(connectionHeat));
+    for (NodeId node : nodes) {
+        if (auto* ngo = nodeScene->nodeGraphicsObject(node))
+            ngo->update();
+    }
+    for (const ConnectionId& connId : connections) {
+        if (auto* cgo = nodeScene->connectionGraphicsObject(connId))
+            cgo->update();
+    }
 
-                ui->textEdit_logOut->append("FSM: Variable " + name + " changed to: " + val.toString());
+    shownProfile = profile;
+    if (profileView)
+        profileView->setProfile(profile);
+}
 
-                // handle the variable change
-                onVariableUpdate(name, value);
-            }
-        }
+void MainWindow::onShowHotSpotsClicked()
+{
+    if (!profileView)
+        profileView = new ProfileView(this);
+
+    // the heatmap of a finished run stays, and so does its table
+    profileView->setProfile(shownProfile);
+    profileView->show();
+    profileView->raise();
+    profileView->activateWindow();
+}
+
+void MainWindow::onRuntimeStatisticsClicked()
+{
+    FsmRun* run = shownRun();
+    if (!run) {
+        ui->logView->appendLine(LogCategory::Info, "No run to ask for statistics.");
+        return;
     }
+    run->requestStats();
+}
 
+void MainWindow::onResumeFromCheckpointClicked()
+{
+    QFile file(checkpointPath());
+    if (!file.open(QIODevice::ReadOnly)) {
+        QMessageBox::warning(this, "Resume from checkpoint", "The automaton has no checkpoint: " + file.fileName());
+        return;
+    }
+    startRun(file.readAll());
 }
 
-/**
- *    QPROCESS SLOTS
- *  ========================================================================
- *  ========================================================================
- */
+void MainWindow::onCheckpointNowClicked()
+{
+    FsmRun* run = shownRun();
+    if (!run) {
+        ui->logView->appendLine(LogCategory::Info, "No run to checkpoint.");
+        return;
+    }
+    if (run->requestCheckpoint())
+        ui->logView->appendLine(LogCategory::Info, "Checkpointing " + run->name() + " to " + checkpointPath());
+}
+
+void MainWindow::onOpenTraceClicked()
+{
+    const QString path = QFileDialog::getOpenFileName(this, "Replay trace", QDir::currentPath() + "/interpret",
+                                                      "FSM traces (*.fsmtrace);;All files (*)");
+    if (path.isEmpty())
+        return;
 
-void MainWindow::onPythonProcessFinished(int exitCode, QProcess::ExitStatus exitStatus) {
-    qInfo() << "[MainWindow] Python FSM process finished. Exit code:" << exitCode << "Status:" << exitStatus;
-    QString stdOut = pythonFsmProcess->readAllStandardOutput();
-    QString stdErr = pythonFsmProcess->readAllStandardError();
-    if(!stdOut.isEmpty()) ui->textEdit_logOut->append("PYTHON STDOUT (on finish):\n" + stdOut);
-    if(!stdErr.isEmpty()) ui->textEdit_logOut->append("PYTHON STDERR (on finish):\n" + stdErr);
+    // the live runs would overwrite the replayed state
+    stopRuns(nullptr);
 
-    // If client was connected, it will likely disconnect now or soon
-    // Update UI to show FSM is not running
-    // TODO: add correct label
-    // ui->label_currentState->setText("Current FSM State: Not Running");
+    auto reader = std::make_unique<TraceReader>();
+    if (!reader->open(path.toStdString()) || reader->eventCount() == 0) {
+        QMessageBox::warning(this, "Replay trace", "The file is not a trace or has no events: " + path);
+        return;
+    }
+
+    traceReplay = std::move(reader);
+    const uint64_t events = std::min<uint64_t>(traceReplay->eventCount(), std::numeric_limits<int>::max());
+    {
+        QSignalBlocker blocker(ui->slider_replay);
+        ui->slider_replay->setRange(0, static_cast<int>(events - 1));
+        ui->slider_replay->setValue(0);
+    }
+    ui->slider_replay->setVisible(true);
+    on_slider_replay_valueChanged(0);
+    ui->logView->appendLine(LogCategory::Info, "Replaying " + path + ", " + QString::number(traceReplay->eventCount()) + " events");
 }
 
-void MainWindow::onPythonProcessError(QProcess::ProcessError error) {
-    qWarning() << "[MainWindow] Python FSM process error:" << error << pythonFsmProcess->errorString();
-    ui->textEdit_logOut->append("PYTHON PROCESS ERROR: " + pythonFsmProcess->errorString());
-    // Update UI
+void MainWindow::onRecordPerformanceTraceToggled(bool checked)
+{
+    if (checked) {
+        startPerformanceTrace();
+        ui->logView->appendLine(LogCategory::Info, "Recording a performance trace");
+        return;
+    }
+
+    stopPerformanceTrace();
+    const QString path = QFileDialog::getSaveFileName(this, "Save performance trace", QDir::currentPath(),
+                                                      "Chrome traces (*.json);;All files (*)");
+    if (path.isEmpty())
+        return;
+    if (!ScopeTrace::writeChromeTrace(path.toStdString())) {
+        QMessageBox::warning(this, "Save performance trace", "Failed to write " + path);
+        return;
+    }
+
+    QString line = "Performance trace saved to " + path;
+    if (const uint64_t dropped = ScopeTrace::droppedEvents())
+        line += ", " + QString::number(dropped) + " events dropped";
+    ui->logView->appendLine(LogCategory::Info, line);
 }
 
-void MainWindow::onPythonProcessStateChanged(QProcess::ProcessState newState) {
-    qInfo() << "[MainWindow] Python FSM process state changed to:" << newState;
-    // You can update UI based on this, e.g., "Starting...", "Running..."
-    switch (newState) {
-        case QProcess::NotRunning:
-            ui->textEdit_logOut->append("Python FSM process is not running.");
-            break;
-        case QProcess::Starting:
-            ui->textEdit_logOut->append("Python FSM process is starting...");
-            break;
-        case QProcess::Running:
-            ui->textEdit_logOut->append("Python FSM process is running.");
-            break;
-        default:
-            ui->textEdit_logOut->append("Unknown Python FSM process state.");
-            break;
+void MainWindow::on_slider_replay_valueChanged(int event)
+{
+    if (!traceReplay)
+        return;
+
+    const TraceSnapshot snapshot = traceReplay->snapshotAtEvent(static_cast<uint64_t>(event));
+    const QString state = QString::fromStdString(traceReplay->stateName(snapshot.stateId));
+    ui->label_currentState->setText(state.isEmpty() ? QString() : "Current State: " + state);
+    ui->statusbar->showMessage("Replay: event " + QString::number(snapshot.event + 1) + " of "
+                               + QString::number(traceReplay->eventCount()) + ", "
+                               + QString::number(snapshot.timestampUs / 1000.0, 'f', 1) + " ms");
+
+    QWidget* panel = ui->hlayout_variables->parentWidget();
+    if (panel)
+        panel->setUpdatesEnabled(false);
+    for (uint32_t id = 0; id < snapshot.variables.size(); ++id) {
+        const TraceSlot& slot = snapshot.variables[id];
+        const QString name = QString::fromStdString(traceReplay->variableName(id));
+        if (slot.isSet && variables.contains(name))
+            onVariableUpdate(name, QString::fromStdString(traceReplay->valueToString(slot)));
+    }
+    if (panel)
+        panel->setUpdatesEnabled(true);
+
+    // the replayed state is selected in the graph
+    nodeScene->clearSelection();
+    const NodeId nodeId = graphModel->findNodeByName(state);
+    if (nodeId != QtNodes::InvalidNodeId) {
+        if (auto* node = nodeScene->nodeGraphicsObject(nodeId))
+            node->setSelected(true);
     }
 }
 
-void MainWindow::onPythonReadyReadStdOut() {
-    QByteArray data = pythonFsmProcess->readAllStandardOutput();
-    qInfo() << "[PYTHON STDOUT] " << data.trimmed(); // Log to console/debug output
-    ui->textEdit_logOut->append("PYTHON STDOUT: " + QString::fromUtf8(data)); // Also show in UI log
-    // You could parse this for "Server ready" messages
+void MainWindow::onBatchSimulationClicked()
+{
+    if (batch)
+        return;
+
+    graphModel->SetVariables(getVariableRowsAsVector());
+    std::unique_ptr<Automaton> automaton = graphModel->ToAutomaton();
+    if (!automaton)
+        return;
+
+    bool ok = false;
+    const int instances = QInputDialog::getInt(this, "Batch simulation", "Instances:", 10000, 1, 100000000, 1, &ok);
+    if (!ok)
+        return;
+    const int maxSteps = QInputDialog::getInt(this, "Batch simulation", "Steps per instance:", 1000, 1, 100000000, 1, &ok);
+    if (!ok)
+        return;
+
+    try {
+        batch = std::make_unique<FsmBatch>(*automaton);
+    } catch (const ExpressionError& e) {
+        QMessageBox::warning(this, "Batch simulation", QString::fromStdString(e.what()));
+        return;
+    }
+
+    ui->actionBatch_simulation->setEnabled(false);
+    ui->statusbar->showMessage("Simulating " + QString::number(instances) + " instances...");
+
+    if (batchThread.joinable())
+        batchThread.join();
+    batchThread = std::thread([this, instances, maxSteps]() {
+        const BatchResult result = batch->run(static_cast<uint64_t>(instances), static_cast<uint64_t>(maxSteps));
+        QMetaObject::invokeMethod(this, [this, result]() { onBatchFinished(result); }, Qt::QueuedConnection);
+    });
+}
+
+void MainWindow::onRunOnRemoteDaemonsClicked()
+{
+    bool ok = false;
+    const QString endpoints = QInputDialog::getText(this, "Run on remote daemons",
+                                                    "Runtime daemons, tcp://host:port separated by spaces:",
+                                                    QLineEdit::Normal, remoteEndpoints, &ok).simplified();
+    if (!ok || endpoints.isEmpty())
+        return;
+    const int instances = QInputDialog::getInt(this, "Run on remote daemons", "Instances:", 100, 1, 100000, 1, &ok);
+    if (!ok)
+        return;
+    remoteEndpoints = endpoints;
+
+    graphModel->SetVariables(getVariableRowsAsVector());
+    std::unique_ptr<Automaton> automaton = graphModel->ToAutomaton();
+    if (!automaton)
+        return;
+
+    // one connection per daemon, the instances are spread over them
+    QList<FsmClient*> clients;
+    for (const QString& endpoint : endpoints.split(' ', Qt::SkipEmptyParts)) {
+        if (FsmClient* client = remoteClient(endpoint))
+            clients << client;
+    }
+    if (clients.isEmpty()) {
+        QMessageBox::warning(this, "Run on remote daemons", "No valid endpoint: " + endpoints);
+        return;
+    }
+
+    closeReplay();
+    if (!ui->actionRun_concurrently->isChecked())
+        stopRuns(nullptr);
+
+    interpretGenerator->setVirtualTime(ui->actionVirtual_time->isChecked());
+    interpretGenerator->setThroughputMode(ui->actionThroughput_mode->isChecked());
+    interpretGenerator->setLazyFunctions(automaton->getStates().size() >= kLazyFunctionStates);
+    const QByteArray script = interpretGenerator->generateScript(*automaton);
+
+    for (int i = 0; i < instances; ++i)
+        createRun()->startRemote(clients[i % clients.size()], script);
+    ui->logView->appendLine(LogCategory::Info, "Started " + QString::number(instances) + " instances on "
+                                                   + QString::number(clients.size()) + " remote daemon(s).");
 }
 
-void MainWindow::onPythonReadyReadStdErr() {
-    QByteArray data = pythonFsmProcess->readAllStandardError();
-    qWarning() << "[PYTHON STDERR] " << data.trimmed(); // Log to console/debug output
-    ui->textEdit_logOut->append("PYTHON STDERR: " + QString::fromUtf8(data)); // Also show in UI log
+FsmClient* MainWindow::remoteClient(const QString& endpoint)
+{
+    if (FsmClient* client = remoteClients.value(endpoint))
+        return client;
+
+    auto* client = new FsmClient(this);
+    client->setMultiplexed(true);
+    if (!client->connectToEndpoint(endpoint)) {
+        delete client;
+        return nullptr;
+    }
+    remoteClients.insert(endpoint, client);
+
+    // a lost connection ends its runs, the next remote run connects again
+    const auto drop = [this, endpoint, client]() {
+        if (remoteClients.value(endpoint) == client)
+            remoteClients.remove(endpoint);
+        client->deleteLater();
+    };
+    connect(client, &FsmClient::connected, this, [this, endpoint]() {
+        ui->logView->appendLine(LogCategory::Info, "Connected to the remote daemon " + endpoint);
+    });
+    connect(client, &FsmClient::disconnected, this, [this, endpoint, drop]() {
+        ui->logView->appendLine(LogCategory::Info, "Disconnected from the remote daemon " + endpoint);
+        drop();
+    });
+    connect(client, &FsmClient::fsmError, this, [this, endpoint, client, drop](const QString& error) {
+        ui->logView->appendLine(LogCategory::Error, "Remote daemon " + endpoint + ": " + error);
+        if (!client->isConnected())
+            drop();
+    });
+    return client;
 }
 
+void MainWindow::onBatchFinished(const BatchResult& result)
+{
+    if (batchThread.joinable())
+        batchThread.join();
+    batch.reset();
+    ui->actionBatch_simulation->setEnabled(true);
+    ui->statusbar->clearMessage();
+
+    QVector<LogEntry> lines;
+    lines.append({LogCategory::Info, QString("BATCH: %1 instances in %2 s, %3 finished, %4 stuck, %5 at the step limit, %6 failed")
+                                         .arg(result.instances).arg(result.seconds, 0, 'f', 2)
+                                         .arg(result.outcomes[static_cast<int>(BatchOutcome::Finished)])
+                                         .arg(result.outcomes[static_cast<int>(BatchOutcome::Stuck)])
+                                         .arg(result.outcomes[static_cast<int>(BatchOutcome::Running)])
+                                         .arg(result.outcomes[static_cast<int>(BatchOutcome::Error)])});
+    lines.append({LogCategory::Info, QString("BATCH: %1 steps and %2 ms of delays per instance on average")
+                                         .arg(result.meanSteps, 0, 'f', 1).arg(result.meanTimeMs, 0, 'f', 1)});
+    for (size_t id = 0; id < result.finalStates.size(); ++id) {
+        if (result.finalStates[id] > 0)
+            lines.append({LogCategory::State, "BATCH: ended in " + QString::fromStdString(result.stateNames[id])
+                                                  + ": " + QString::number(result.finalStates[id])});
+    }
+    for (const BatchVariableStats& stats : result.variables) {
+        if (stats.numericCount > 0)
+            lines.append({LogCategory::Variable, QString("BATCH: %1 min %2, max %3, mean %4")
+                                                     .arg(QString::fromStdString(stats.name)).arg(stats.min)
+                                                     .arg(stats.max).arg(stats.mean)});
+    }
+    ui->logView->append(lines);
+}
+
+void MainWindow::closeReplay()
+{
+    if (!traceReplay)
+        return;
 
-void MainWindow::onFsmClientError(const QString& err) {
-    qWarning() << "[MainWindow] FSM Client error:" << err;
-    ui->textEdit_logOut->append("CLIENT ERROR: " + err);
-    // Update UI
+    traceReplay.reset();
+    ui->slider_replay->setVisible(false);
+    ui->statusbar->clearMessage();
+}
+
+void MainWindow::startLayout(LayoutAlgorithm algorithm)
+{
+    if (layoutJob->isRunning())
+        return;
+
+    LayoutOptions options;
+    options.algorithm = algorithm;
+
+    // the layout runs on a copy of the graph, the editor stays responsive
+    if (!layoutJob->start(graphModel->BuildLayoutGraph(layoutNodeIds), options))
+        return;
+
+    ui->menuLayout->setEnabled(false);
+    ui->statusbar->showMessage("Computing the layout...");
+}
+
+void MainWindow::onLayoutFinished()
+{
+    ui->menuLayout->setEnabled(true);
+    ui->statusbar->clearMessage();
+
+    std::vector<LayoutPoint> positions = layoutJob->takeResult();
+    if (layoutJob->wasCancelled())
+        return;
+
+    graphModel->ApplyLayout(layoutNodeIds, positions);
+    layoutNodeIds.clear();
+}
+
+void MainWindow::scheduleValidation()
+{
+    // every keystroke restarts the timer, typing is never slowed down by a validation
+    validationTimer.start();
+}
+
+void MainWindow::startValidation()
+{
+    if (validationJob->isRunning()) {
+        validationQueued = true;
+        return;
+    }
+
+    ValidationRequest request;
+    request.graph = graphModel->ToValidationGraph();
+    request.reset = validationResetPending;
+
+    if (validationResetPending) {
+        request.actions.reserve(request.graph.states.size());
+        for (const auto& state : request.graph.states)
+            request.actions.emplace_back(state.id, graphModel->GetNodeActionCodeUtf8(state.id));
+        for (const TransitionKey& key : request.graph.transitions) {
+            const ConnectionId connId{key.from, key.fromPort, key.to, key.toPort};
+            request.conditions.emplace_back(key, graphModel->GetConnectionCodeUtf8(connId));
+        }
+    } else {
+        // the texts of deleted elements read as empty, the validator drops them
+        for (NodeId nodeId : dirtyActions)
+            request.actions.emplace_back(nodeId, graphModel->GetNodeActionCodeUtf8(nodeId));
+        for (const ConnectionId& connId : dirtyConditions)
+            request.conditions.emplace_back(DynamicPortsModel::ToTransitionKey(connId),
+                                            graphModel->GetConnectionCodeUtf8(connId));
+    }
+
+    validationResetPending = false;
+    dirtyActions.clear();
+    dirtyConditions.clear();
+    validationJob->start(std::move(request));
+}
+
+void MainWindow::onValidationFinished()
+{
+    std::vector<ValidationProblem> problems = validationJob->takeResult();
+
+    if (validationQueued) {
+        validationQueued = false;
+        scheduleValidation();
+    }
+    // the node ids of the result may belong to the automaton before a reset
+    if (validationResetPending)
+        return;
+
+    std::unordered_map<NodeId, QString> nodeProblems;
+    QStringList automatonProblems;
+    for (const ValidationProblem& problem : problems) {
+        const QString message = QString::fromStdString(problem.message);
+        if (problem.stateId == 0) {
+            automatonProblems << message;
+            continue;
+        }
+        QString& text = nodeProblems[problem.stateId];
+        if (!text.isEmpty())
+            text += '\n';
+        text += message;
+    }
+
+    // only the nodes whose badge appears, changes or goes away are repainted
+    std::vector<NodeId> changed;
+    const auto& previous = graphModel->NodeProblems();
+    for (const auto& [nodeId, text] : previous) {
+        auto it = nodeProblems.find(nodeId);
+        if (it == nodeProblems.end() || it->second != text)
+            changed.push_back(nodeId);
+    }
+    for (const auto& [nodeId, text] : nodeProblems) {
+        if (previous.find(nodeId) == previous.end())
+            changed.push_back(nodeId);
+    }
+
+    graphModel->SetNodeProblems(std::move(nodeProblems));
+    for (NodeId nodeId : changed) {
+        if (auto* ngo = nodeScene->nodeGraphicsObject(nodeId))
+            ngo->update();
+    }
+
+    if (problems.empty()) {
+        validationLabel->setText("No problems");
+    } else {
+        QString text = problems.size() == 1 ? QString("1 problem") : QString::number(problems.size()) + " problems";
+        if (!automatonProblems.isEmpty())
+            text = automatonProblems.join(", ") + " | " + text;
+        validationLabel->setText("⚠ " + text);
+    }
 }
 
 
@@ -476,20 +1402,64 @@ void MainWindow::onConnectionClicked(ConnectionId const connId)
 void MainWindow::onSaveToFileClicked()
 {
     // parse the variable definition textbox contents
-    graphModel->variables = getVariableRowsAsVector();
+    graphModel->SetVariables(getVariableRowsAsVector());
 
     QString filename = QFileDialog::getSaveFileName(nullptr,
                                                     "Open Fsm File",
                                                     QDir::homePath(),
-                                                    "Fsm File (*.fsm)");
+                                                    "Fsm File (*.fsm);;Fsm Binary File (*.fsmb)");
 
     if (filename.isEmpty())
         return;
 
-    if (!filename.endsWith("fsm", Qt::CaseInsensitive))
+    if (!filename.endsWith("fsm", Qt::CaseInsensitive) && !filename.endsWith("fsmb", Qt::CaseInsensitive))
         filename += ".fsm";
 
     graphModel->ToFile(filename.toStdString());
+
+    // the autosave of the saved file is outdated now
+    if (!autosaveJob->isRunning() && currentFile == filename)
+        QFile::remove(autosavePath());
+    currentFile = filename;
+    savedGeneration = graphModel->Generation();
+}
+
+QString MainWindow::autosavePath() const
+{
+    if (currentFile.isEmpty()) {
+        const QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+        QDir().mkpath(dir);
+        return dir + "/untitled.autosave.fsm";
+    }
+    const QFileInfo info(currentFile);
+    return info.dir().filePath(info.completeBaseName() + ".autosave.fsm");
+}
+
+QString MainWindow::checkpointPath() const
+{
+    if (currentFile.isEmpty()) {
+        const QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+        QDir().mkpath(dir);
+        return dir + "/untitled.fsmcheckpoint";
+    }
+    const QFileInfo info(currentFile);
+    return info.dir().filePath(info.completeBaseName() + ".fsmcheckpoint");
+}
+
+void MainWindow::onAutosaveTimeout()
+{
+    graphModel->SetVariables(getVariableRowsAsVector());
+
+    // nothing changed since the last save or autosave
+    const uint64_t generation = graphModel->Generation();
+    if (generation == savedGeneration || generation == autosaveJob->savedGeneration() || autosaveJob->isRunning())
+        return;
+
+    FsmSnapshot snapshot = graphModel->TakeSnapshot();
+    if (snapshot.startNode < 0)
+        return; // the text format needs a start state
+
+    autosaveJob->start(std::move(snapshot), autosavePath());
 }
 
 void MainWindow::updateUiFromGraphModel()
@@ -532,19 +1502,54 @@ void MainWindow::updateUiFromGraphModel()
 void MainWindow::onLoadFromFileClicked()
 {
     // Open .fsm file via file explorer:
-    QString filename = QFileDialog::getOpenFileName(nullptr, "Open Fsm File", QDir::homePath(),"Fsm File (*.fsm)");
+    QString filename = QFileDialog::getOpenFileName(nullptr, "Open Fsm File", QDir::homePath(),"Fsm File (*.fsm *.fsmb)");
 
     if (filename.isEmpty())
         return;
 
-    if (!filename.endsWith("fsm", Qt::CaseInsensitive))
+    if (!filename.endsWith("fsm", Qt::CaseInsensitive) && !filename.endsWith("fsmb", Qt::CaseInsensitive))
         filename += ".fsm";
 
-    // 1) load the node scene from the provided file:
-    graphModel->FromFile(filename.toStdString());
+    // the texts of huge files stay in the mapped file until a node or connection is opened
+    const bool lazyText = static_cast<uint64_t>(QFileInfo(filename).size()) >= LazyTextThreshold;
+    if (!loadJob->start(filename, lazyText))
+        return; // a file is being loaded
+    loadingFile = filename;
+
+    // the running layout belongs to the old graph
+    layoutJob->cancel();
+
+    // 1) parse the file on the worker thread, the UI shows the progress
+    loadProgress = new QProgressDialog("Loading " + QFileInfo(filename).fileName() + "...", "Cancel", 0, 100, this);
+    loadProgress->setWindowModality(Qt::WindowModal);
+    loadProgress->setMinimumDuration(200); // small files load without a dialog
+    loadProgress->setAutoClose(false);
+    loadProgress->setAutoReset(false);
+    connect(loadJob, &LoadJob::progressChanged, loadProgress, &QProgressDialog::setValue);
+    connect(loadProgress, &QProgressDialog::canceled, loadJob, &LoadJob::cancel);
+}
+
+void MainWindow::onLoadFinished()
+{
+    if (loadProgress) {
+        loadProgress->deleteLater();
+        loadProgress = nullptr;
+    }
+
+    LoadedGraph graph = loadJob->takeResult();
+    if (loadJob->wasCancelled())
+        return;
+
+    // 2) build the node scene in one batch
+    graphModel->ApplyLoadedGraph(graph);
 
-    // 2) setup ui elements with the loaded automaton data
+    // 3) setup ui elements with the loaded automaton data
     updateUiFromGraphModel();
+
+    // the loaded file is saved, in the order the variable panel keeps the variables
+    graphModel->SetVariables(getVariableRowsAsVector());
+    currentFile = loadingFile;
+    savedGeneration = graphModel->Generation();
 }
 
 
@@ -556,84 +1561,167 @@ void MainWindow::onLoadFromFileClicked()
 
 void MainWindow::on_button_Run_clicked()
 {
-    // --- 0. Stop any existing FSM and client ---
-    if (pythonFsmProcess->state() != QProcess::NotRunning) {
-        qInfo() << "[MainWindow] Stopping existing FSM process...";
-        pythonFsmProcess->terminate(); // Or pythonFsmProcess->kill();
-        if (!pythonFsmProcess->waitForFinished(3000)) { // Wait 3s
-            qWarning() << "[MainWindow] Python FSM process did not terminate gracefully. Forcing kill.";
-            pythonFsmProcess->kill();
-            pythonFsmProcess->waitForFinished(); // Wait for kill
-        }
-        qInfo() << "[MainWindow] Previous FSM process stopped.";
-    }
-
-    // TODO: implement the isConnected method
-    if (fsmClient->isConnected()) {
-        qInfo() << "[MainWindow] Disconnecting existing client...";
-        fsmClient->disconnectFromServer();
-        // Wait for disconnection or just proceed, as new connection will override
-    }
+    startRun();
+}
 
-    // here update UI to maybe reflect "not running"
+void MainWindow::startRun(const QByteArray& checkpoint)
+{
+    const bool concurrent = ui->actionRun_concurrently->isChecked();
+    const bool warmRuntime = ui->actionWarm_runtime->isChecked();
+    // only the native engine resumes from a checkpoint
+    const bool nativeEngine = ui->actionUse_native_engine->isChecked() || !checkpoint.isEmpty();
+    const bool embeddedPython = ui->actionEmbedded_Python->isChecked() && FsmRun::embeddedAvailable();
+    closeReplay();
 
     // --- 1. Get Automaton Data ---
 
     // --- Variables ---
 
-    graphModel->variables = getVariableRowsAsVector();
+    graphModel->SetVariables(getVariableRowsAsVector());
 
-    std::unique_ptr<Automaton> automaton(graphModel->ToAutomaton());
+    std::unique_ptr<Automaton> automaton = graphModel->ToAutomaton();
     if (!automaton) {
         qWarning() << "[MainWindow] Failed to get automaton data from model.";
         // Show error to user
         return;
     }
 
+    // the generator options are part of the script, a patched run has to match them
+    interpretGenerator->setVirtualTime(ui->actionVirtual_time->isChecked());
+    interpretGenerator->setThroughputMode(ui->actionThroughput_mode->isChecked());
+    interpretGenerator->setLazyFunctions(automaton->getStates().size() >= kLazyFunctionStates);
+    const bool hotReload = ui->actionHot_reload->isChecked() && !nativeEngine;
+
+    // --- 1a. Patch the shown run if only the code of actions and conditions has changed ---
+    if (hotReload) {
+        FsmRun* shown = shownRun();
+        if (shown && shown->reloadFunctions(interpretGenerator->scriptFunctions(*automaton)))
+            return;
+    }
+
+    // --- 1b. Stop the existing runs, unless the new run joins them ---
+    // a warm daemon or an embedded runtime stays, it replaces its FSM when it gets the new automaton
+    FsmRun* daemon = nullptr;
+    if (!concurrent) {
+        FsmRun* shown = shownRun();
+        const FsmRun::Kind reusable = embeddedPython ? FsmRun::Kind::Embedded : FsmRun::Kind::Daemon;
+        if ((warmRuntime || embeddedPython) && !nativeEngine && shown && shown->isDaemon() && shown->kind() == reusable)
+            daemon = shown;
+        stopRuns(daemon);
+    }
+
+    // logs of the finished runs are dropped
+    for (const QString& path : std::as_const(staleLogFiles))
+        QFile::remove(path);
+    staleLogFiles.clear();
+
+    // --- 2a. Run in the native engine, no code generation needed ---
+    if (nativeEngine) {
+        FsmRun* run = createRun();
+        qInfo() << "[MainWindow] Starting native FSM engine for" << run->name();
+        if (ui->actionRecord_trace->isChecked())
+            run->startTrace(QDir::currentPath() + "/interpret/trace-" + QString::number(QCoreApplication::applicationPid())
+                            + "-" + QString::number(run->id()) + ".fsmtrace");
+        run->setCheckpointFile(checkpointPath(), ui->actionCheckpoint_native_runs->isChecked() ? kCheckpointIntervalMs : 0);
+        if (!run->startEngine(*automaton, ui->actionVirtual_time->isChecked(), ui->actionProfile_run->isChecked(),
+                              ui->actionCompile_native->isChecked(), checkpoint))
+            removeRun(run->id());
+        return;
+    }
+
     // --- 2. Generate Python FSM Code ---
-    InterpretGenerator generator;
-    QString pythonFilePath = QDir::currentPath() + "/interpret/output.py";
-    QDir().mkpath(QFileInfo(pythonFilePath).path()); // Ensure directory exists
+    // paths are unique per editor instance (script) and per run (log)
+    const QString interpretDir = QDir::currentPath() + "/interpret";
+    const QString instanceId = QString::number(QCoreApplication::applicationPid());
+    QDir().mkpath(interpretDir); // Ensure directory exists
+
+    const bool streamInterpret = ui->actionStream_interpret->isChecked();
+    QString pythonFilePath;
+    QByteArray pythonScript;
+    QStringList pythonArguments;
+
+    if (embeddedPython) {
+        // fsm_core is imported once per session, the run only opens a runtime in the interpreter
+        qDebug() << "[MainWindow] Generating Python FSM for the embedded runtime";
+        pythonScript = interpretGenerator->generateScript(*automaton);
+
+        if (daemon) {
+            daemon->loadAutomaton(pythonScript);
+            if (hotReload)
+                daemon->setScriptFunctions(interpretGenerator->scriptFunctions(*automaton));
+            return;
+        }
 
-    qDebug() << "[MainWindow] Generating Python FSM at:" << pythonFilePath;
-    generator.generate(*automaton, pythonFilePath);
+        FsmRun* run = createRun();
+        if (ui->actionRecord_trace->isChecked())
+            run->startTrace(interpretDir + "/trace-" + instanceId + "-" + QString::number(run->id()) + ".fsmtrace");
+        if (!run->startEmbedded(interpretDir)) {
+            qWarning() << "[MainWindow] Failed to start the embedded Python runtime!";
+            removeRun(run->id());
+            return;
+        }
+        run->loadAutomaton(pythonScript);
+        if (hotReload)
+            run->setScriptFunctions(interpretGenerator->scriptFunctions(*automaton));
+        return;
+    }
 
-    // --- 3. Run the generated Python file ---
-    QString pythonExe = "python"; // this could be configurable
-    QString logFilePath = QDir::currentPath() + "/interpret/output.log";
-    QDir().mkpath(QFileInfo(logFilePath).path()); // Ensure directory exists
+    if (warmRuntime) {
+        // the daemon builds the FSM from the script, nothing is started when it already runs
+        qDebug() << "[MainWindow] Generating Python FSM for the runtime daemon";
+        pythonScript = interpretGenerator->generateScript(*automaton);
 
-    // Clear previous log content
-    QFile logFile(logFilePath);
-    if (logFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
-        logFile.close();
+        if (daemon) {
+            daemon->loadAutomaton(pythonScript);
+            if (hotReload)
+                daemon->setScriptFunctions(interpretGenerator->scriptFunctions(*automaton));
+            return;
+        }
+
+        pythonArguments << "-m" << "fsm_core.daemon";
+    } else if (streamInterpret) {
+        // the script never touches the disk, python reads it from stdin
+        qDebug() << "[MainWindow] Generating Python FSM into memory";
+        pythonScript = interpretGenerator->generateScript(*automaton);
+        pythonArguments << "-";
+    } else {
+        pythonFilePath = interpretDir + "/output-" + instanceId + ".py";
+        qDebug() << "[MainWindow] Generating Python FSM at:" << pythonFilePath;
+        interpretGenerator->generate(*automaton, pythonFilePath); // unchanged automata are not generated again
+        pythonArguments << pythonFilePath;
     }
 
-    pythonFsmProcess->setStandardOutputFile(logFilePath, QIODevice::Append); // Append for multiple runs in one session
-    pythonFsmProcess->setStandardErrorFile(logFilePath, QIODevice::Append);
+    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+    if (warmRuntime || streamInterpret) {
+        // fsm_core is found next to the script otherwise
+        QString pythonPath = env.value("PYTHONPATH");
+        env.insert("PYTHONPATH", pythonPath.isEmpty() ? interpretDir : interpretDir + QDir::listSeparator() + pythonPath);
+    }
 
-    qInfo() << "[MainWindow] Starting Python FSM server process:" << pythonExe << pythonFilePath;
+    // --- 3. Run the generated Python file ---
+    // every run has its own process, client and log; the client connects on the READY line
+    QString pythonExe = "python"; // this could be configurable
 
-    pythonFsmProcess->start(pythonExe, QStringList() << pythonFilePath);
-    if (!pythonFsmProcess->waitForStarted(5000)) { // 5 sec
+    FsmRun* run = createRun();
+    const QString logFilePath = interpretDir + "/output-" + instanceId + "-" + QString::number(run->id()) + ".log";
+    // the trace is kept after the run, it is meant for later analysis
+    if (ui->actionRecord_trace->isChecked())
+        run->startTrace(interpretDir + "/trace-" + instanceId + "-" + QString::number(run->id()) + ".fsmtrace");
+
+    if (!run->startPython(pythonExe, pythonArguments, env, logFilePath,
+                          streamInterpret && !warmRuntime ? pythonScript : QByteArray(), warmRuntime)) {
         qWarning() << "[MainWindow] Failed to start Python process!";
-        qWarning() << "[MainWindow] Python Process Error:" << pythonFsmProcess->errorString();
-        qWarning() << "[MainWindow] Stderr:" << pythonFsmProcess->readAllStandardError();
-        qWarning() << "[MainWindow] Stdout:" << pythonFsmProcess->readAllStandardOutput();
         // Show error to user
+        removeRun(run->id());
         return;
     }
 
-    qInfo() << "[MainWindow] Python FSM process started successfully.";
+    if (warmRuntime)
+        run->loadAutomaton(pythonScript);
+    if (hotReload)
+        run->setScriptFunctions(interpretGenerator->scriptFunctions(*automaton));
 
-    // --- 4. Connect C++ client to the interpret ---
-    QTimer::singleShot(2000, this, [this]() { // QTimer means non-blocking delay
-        qInfo() << "[MainWindow] Attempting to connect client to FSM server...";
-        fsmClient->connectToServer("localhost", 65432);
-    });
-
-    // process.waitForFinished(-1); // Wait until finished
-    // qDebug() << "Python script finished. Output written to:" << logFilePath;
+    qInfo() << "[MainWindow] Python FSM process started successfully.";
 }
 
 void MainWindow::on_button_addState_clicked()
@@ -651,6 +1739,8 @@ void MainWindow::on_textEdit_actionCode_textChanged()
     // update the code of selected node:
     auto textEditContent = ui->textEdit_actionCode->toPlainText();
     graphModel->SetNodeActionCode(lastSelectedNode, textEditContent);
+    dirtyActions.insert(lastSelectedNode);
+    scheduleValidation();
 }
 
 void MainWindow::on_lineEdit_stateName_textChanged(const QString &text)
@@ -658,6 +1748,7 @@ void MainWindow::on_lineEdit_stateName_textChanged(const QString &text)
     qWarning() << "Node name update!";
     // update the name of selected node:
     graphModel->SetNodeName(lastSelectedNode, text);
+    scheduleValidation();
 }
 
 
@@ -665,6 +1756,8 @@ void MainWindow::on_textEdit_connCond_textChanged()
 {
     auto connCode = ui->textEdit_connCond->toPlainText();
     graphModel->SetConnectionCode(lastSelectedConnId, connCode);
+    dirtyConditions.insert(lastSelectedConnId);
+    scheduleValidation();
 }
 
 
@@ -675,12 +1768,14 @@ void MainWindow::on_checkBox_isFinal_stateChanged(int state)
     // 2 = checked
     auto isChecked = (state == 2);
     graphModel->SetNodeFinalState(lastSelectedNode, isChecked);
+    scheduleValidation();
 }
 
 
 void MainWindow::on_pushButton_setStartState_clicked()
 {
     graphModel->SetStartNode(lastSelectedNode);
+    scheduleValidation();
     // disable the Start State button if this state is already set as start
     if(graphModel->IsStartNode(lastSelectedNode))
     {
@@ -692,23 +1787,21 @@ void MainWindow::on_pushButton_setStartState_clicked()
 
 void MainWindow::on_button_Stop_clicked()
 {
-    if (fsmClient && fsmClient->isConnected()) { // Check if client exists and is connected
-        qInfo() << "[MainWindow] Sending STOP_FSM command to Python interpreter.";
-        ui->textEdit_logOut->append("CLIENT -> FSM: Sending STOP_FSM command.");
-        fsmClient->sendStopFsm();
-        // The Python FSM should then shut down, which will likely cause
-        // pythonFsmProcess to finish and the m_fsmClient to disconnect.
-        // The onFsmClientDisconnected and onPythonProcessFinished slots will handle UI updates.
+    // only the shown run is stopped, the others keep running
+    if (FsmRun* run = shownRun()) {
+        qInfo() << "[MainWindow] Stopping" << run->name();
+        run->stop();
+        // A Python FSM then shuts down, its process finishes and onRunFinished removes the run.
     } else {
         qWarning() << "[MainWindow] Cannot send STOP_FSM: Client not connected.";
-        ui->textEdit_logOut->append("CLIENT: Cannot send STOP_FSM - not connected.");
+        ui->logView->appendLine(LogCategory::Error, "CLIENT: Cannot send STOP_FSM - not connected.");
     }
 }
 
 
 void MainWindow::on_lineEdit_fsmName_textChanged(const QString &text)
 {
-    graphModel->fsmName = text;
+    graphModel->SetFsmName(text);
 }
 
 
@@ -810,7 +1903,8 @@ void MainWindow::onVariableValueChangedByUser(const QString& variableName, const
             jsonValue = QJsonValue(newValue);
             break;
     }
-    fsmClient->sendSetVariable(variableName, jsonValue);
+    if (FsmRun* run = shownRun())
+        run->setVariable(variableName, jsonValue);
 
     qWarning() << "User updated a variable " << variableName << ", new val: " << newValue;
 }
@@ -22,6 +22,7 @@
 #include <QtNodes/BasicGraphicsScene>
 #include <QProcess>
 #include <QTimer>
+#include <QProgressDialog>
 #include "DynamicPortsModel.hpp"
 
 #include <QtNodes/ConnectionStyle>
@@ -49,8 +50,23 @@
 #include "qlabel.h"
 #include "qlineedit.h"
 #include "spec_parser/automaton-data.hpp"
-#include "client.hpp"
+#include "run/fsm-run.hpp"
+#include "layout/layout-job.hpp"
+#include "load/autosave-job.hpp"
+#include "load/load-job.hpp"
+#include "validate/validation-job.hpp"
+#include "log/log-model.hpp"
+#include "diag/memory-report.hpp"
+#include "trace/trace-reader.hpp"
+#include "engine/fsm-batch.hpp"
 
+#include <memory>
+#include <thread>
+#include <unordered_set>
+
+
+class ProfileView;
+class QDockWidget;
 
 QT_BEGIN_NAMESPACE
 namespace Ui {
@@ -131,6 +147,12 @@ private slots:
      */
     void on_button_Run_clicked();
 
+    /**
+     * @brief Starts a run of the automaton, like the "Run" button.
+     * @param checkpoint A checkpoint the native run resumes from, a run from the start if empty.
+     */
+    void startRun(const QByteArray& checkpoint = QByteArray());
+
     /**
      * @brief Slot called when the action code text is changed.
      */
@@ -164,61 +186,104 @@ private slots:
      */
     void on_lineEdit_fsmName_textChanged(const QString &arg1);
 
-    // Slots for FSM Client
+    // Slots for the FSM runs
 
     /**
-     * @brief Slot called when the FSM client connects.
+     * @brief Slot called when a message is received from the FSM of a run.
+     * @param runId The run.
+     * @param msg The received JSON message.
      */
-    void onFsmClientConnected();
+    void onRunMessageReceived(int runId, const QJsonObject& msg);
 
     /**
-     * @brief Slot called when the FSM client disconnects.
+     * @brief Slot called for the process, client and engine events of a run.
+     * @param runId The run.
+     * @param line The event, logged with the run name.
      */
-    void onFsmClientDisconnected();
+    void onRunLogMessage(int runId, const QString& line);
 
     /**
-     * @brief Slot called when a message is received from the FSM client.
-     * @param msg The received JSON message.
+     * @brief Slot called when the process or the engine of a run has finished, removes the run.
+     * @param runId The run.
+     */
+    void onRunFinished(int runId);
+
+    /**
+     * @brief Slot called when another run is selected, shows its state and variables.
+     * @param index The index of the run in the combo box.
+     */
+    void on_comboBox_runs_currentIndexChanged(int index);
+
+    // Slots for the trace replay
+
+    /**
+     * @brief Slot called when the "Replay trace" action is triggered, opens a trace.
+     */
+    void onOpenTraceClicked();
+
+    /**
+     * @brief Slot called when the "Record performance trace" action is toggled.
+     * @param checked Starts the trace, unchecked asks for a file and writes the trace to it.
+     */
+    void onRecordPerformanceTraceToggled(bool checked);
+
+    /**
+     * @brief Slot called when the replay slider moves, shows the state after the event.
+     * @param event The index of the event in the trace.
+     */
+    void on_slider_replay_valueChanged(int event);
+
+    /**
+     * @brief Slot called when the "Batch simulation" action is triggered, runs a batch of instances.
+     */
+    void onBatchSimulationClicked();
+
+    /**
+     * @brief Slot called when the "Run on remote daemons" action is triggered, runs many instances remotely.
      */
-    void onFsmClientMessageReceived(const QJsonObject& msg);
+    void onRunOnRemoteDaemonsClicked();
 
     /**
-     * @brief Slot called when an error occurs in the FSM client.
-     * @param err The error message.
+     * @brief Slot called when the "Hot spots" action is triggered, shows the profile of the shown run.
      */
-    void onFsmClientError(const QString& err);
+    void onShowHotSpotsClicked();
 
-    // Slots for Python Process
+    /**
+     * @brief Slot called when the "Runtime statistics" action is triggered, asks the shown run for STATS.
+     */
+    void onRuntimeStatisticsClicked();
 
     /**
-     * @brief Slot called when the Python process finishes.
-     * @param exitCode The exit code.
-     * @param exitStatus The exit status.
+     * @brief Slot called when the "Resume from checkpoint" action is triggered, resumes a native run.
      */
-    void onPythonProcessFinished(int exitCode, QProcess::ExitStatus exitStatus);
+    void onResumeFromCheckpointClicked();
 
     /**
-     * @brief Slot called when an error occurs in the Python process.
-     * @param error The process error.
+     * @brief Slot called when the "Checkpoint now" action is triggered, checkpoints the shown run.
      */
-    void onPythonProcessError(QProcess::ProcessError error);
+    void onCheckpointNowClicked();
+
+    // Slots for the automatic layout
 
     /**
-     * @brief Slot called when the Python process state changes.
-     * @param newState The new process state.
+     * @brief Slot called when the layout job has finished, moves the nodes.
      */
-    void onPythonProcessStateChanged(QProcess::ProcessState newState);
+    void onLayoutFinished();
 
+    /**
+     * @brief Slot called when the load job has finished, shows the loaded graph.
+     */
+    void onLoadFinished();
 
     /**
-     * @brief Slot called when there is standard output from the Python process.
+     * @brief Slot called by the autosave timer, saves a snapshot if the model has changed.
      */
-    void onPythonReadyReadStdOut();
+    void onAutosaveTimeout();
 
     /**
-     * @brief Slot called when there is standard error output from the Python process.
+     * @brief Slot called when the validation job has finished, shows the problems as node badges.
      */
-    void onPythonReadyReadStdErr();
+    void onValidationFinished();
 
     /**
      * @brief Slot for the "Stop" button click.
@@ -233,6 +298,29 @@ private slots:
 
 
 private:
+    /// Handles the payload of one FSM message type, see messageHandlers().
+    using MessageHandler = void (MainWindow::*)(int runId, const QJsonObject& payload);
+    static const QHash<QString, MessageHandler>& messageHandlers();  ///< Handler of every message type.
+    void onFsmConnected(int runId, const QJsonObject& payload);
+    void onAutomatonLoaded(int runId, const QJsonObject& payload);
+    void onFsmStarted(int runId, const QJsonObject& payload);
+    void onCurrentState(int runId, const QJsonObject& payload);
+    void onTransitionTaken(int runId, const QJsonObject& payload);
+    void onFsmStuck(int runId, const QJsonObject& payload);
+    void onFsmFinished(int runId, const QJsonObject& payload);
+    void onFsmError(int runId, const QJsonObject& payload);
+    void onVariablesBatch(int runId, const QJsonObject& payload);
+    void onVariableUpdateMessage(int runId, const QJsonObject& payload);
+    void onProfile(int runId, const QJsonObject& payload);
+    void onStats(int runId, const QJsonObject& payload);
+    void onFunctionsReloaded(int runId, const QJsonObject& payload);
+    void scheduleUiUpdate();                 ///< Starts the frame timer if it does not run.
+    void flushUiUpdates();                   ///< Draws the pending log lines, state and variables.
+    void showLiveState(const QString& stateName);  ///< Highlights the node of the state of the shown run.
+    void showLiveTransition(const QString& fromState, const QString& toState);  ///< Flashes the transition taken by the shown run.
+    void setLiveConnection(std::optional<ConnectionId> connId);  ///< Highlights the connection, repaints it and the previous one.
+    void applyProfile(const QJsonObject& profile);  ///< Shows a PROFILE payload as the heatmap and in the hot spots.
+
     void onVariableValueChangedByUser(const QString& varName, const QString& value);
     QMap<QString, VariableEntry> variables;
     std::vector<VariableInfo> getVariableRowsAsVector();
@@ -241,16 +329,74 @@ private:
 
     Ui::MainWindow *ui;                      ///< The UI object.
     void initNodeCanvas();                   ///< Initializes the node canvas.
+    MemoryReport collectMemoryReport() const;  ///< Estimated memory of the model, the scene, the undo history, the log and the runs.
+    void showNode(NodeId const nodeId);      ///< Centers the view on the node, selects it and shows its properties.
     void initializeModel();                  ///< Initializes the FSM model.
     void updateUiFromGraphModel();
+    void startLayout(LayoutAlgorithm algorithm);  ///< Lays out the graph on the layout job.
+    void scheduleValidation();               ///< Validates the automaton once the edits pause.
+    void startValidation();                  ///< Sends the changes since the last validation to the validation job.
+    FsmRun* shownRun() const;                ///< The run shown in the panel, nullptr if none.
+    FsmRun* createRun();                     ///< Adds a new run to the pool and shows it.
+    void removeRun(int runId);               ///< Removes the run from the pool, keeps its log until the next Run.
+    void stopRuns(FsmRun* keep);             ///< Terminates and removes all runs but keep.
+    void showRun(int runId);                 ///< Shows the state and the variables of the run.
+    void onBatchFinished(const BatchResult& result);  ///< Logs the statistics of the batch.
+    void closeReplay();                      ///< Hides the replay slider and drops the trace.
+    QString autosavePath() const;            ///< File the autosave replaces, next to currentFile.
+    QString checkpointPath() const;          ///< Checkpoint of the native runs, next to currentFile.
+    FsmClient* remoteClient(const QString& endpoint);  ///< Multiplexed connection to the daemon, opened on first use.
+    void appendRunLog(int runId, const QString& line, LogCategory category = LogCategory::Info);  ///< Logs a line of the run.
     DynamicPortsModel* graphModel;           ///< The graph model for the node editor.
     QtNodes::BasicGraphicsScene* nodeScene;  ///< The graphics scene for the node editor.
+    QtNodes::GraphicsView* nodeView;         ///< The view of nodeScene.
+    QDockWidget* searchDock;                 ///< Holds the StateSearch of the states.
 
     NodeId lastSelectedNode;                 ///< The last selected node ID.
     ConnectionId lastSelectedConnId;         ///< The last selected connection ID.
 
-    FsmClient* fsmClient;                    ///< The FSM client for communication.
-    QProcess* pythonFsmProcess;              ///< The Python FSM process.
+    LayoutJob* layoutJob;                    ///< Computes the automatic layout.
+    LoadJob* loadJob;                        ///< Parses the opened file.
+    QProgressDialog* loadProgress = nullptr; ///< Progress of the running load, nullptr if none.
+    QString loadingFile;                     ///< File of the running load.
+    AutosaveJob* autosaveJob;                ///< Writes the autosave snapshots.
+    QTimer autosaveTimer;                    ///< Starts an autosave periodically.
+    QString currentFile;                     ///< Last saved or loaded file, empty for a new automaton.
+    uint64_t savedGeneration = 0;            ///< Model generation written to currentFile.
+    InterpretGenerator* interpretGenerator;  ///< Generates the Python interpret, caches it between runs.
+    ValidationJob* validationJob;            ///< Checks the automaton while it is edited.
+    QTimer validationTimer;                  ///< Waits for a pause in the edits before a validation.
+    std::unordered_set<NodeId> dirtyActions;            ///< Actions changed since the last validation.
+    std::unordered_set<ConnectionId> dirtyConditions;   ///< Conditions changed since the last validation.
+    bool validationResetPending = true;      ///< All the texts are checked again, after a load or a reset.
+    bool validationQueued = false;           ///< Something changed while the validation job was running.
+    QLabel* validationLabel;                 ///< Problems of the automaton in the status bar.
+    std::vector<NodeId> layoutNodeIds;       ///< Nodes of the running layout, in layout order.
+    QMap<int, FsmRun*> runs;                 ///< Running automata by run id, each with its own process or engine.
+    int shownRunId = 0;                      ///< Run shown in the state label and the variable panel.
+    int runCounter = 0;                      ///< Last run id, makes the run names and log paths unique.
+    QStringList staleLogFiles;               ///< Logs of the finished runs, removed by the next Run.
+    QHash<QString, FsmClient*> remoteClients;  ///< Connections of the remote runs by endpoint, shared by their instances.
+    QString remoteEndpoints;                 ///< Endpoints last asked for by "Run on remote daemons".
+    QString performanceTraceFile;            ///< ICP_TRACE_FILE, the trace of the session is written to it on exit.
+
+    std::unique_ptr<TraceReader> traceReplay; ///< Trace being replayed, nullptr if none.
+    std::unique_ptr<FsmBatch> batch;          ///< Running batch simulation, nullptr if none.
+    std::thread batchThread;                  ///< Runs the batch, the editor stays responsive.
+
+    QTimer uiUpdateTimer;                    ///< Coalesces the run updates, fires at most once per frame.
+    QVector<LogEntry> pendingLogEntries;     ///< Log lines not appended yet.
+    QString pendingState;                    ///< Last state of the shown run not drawn yet.
+    bool hasPendingState = false;            ///< pendingState is set.
+    QString pendingTransitionFrom;           ///< Source state of the last transition of the shown run not drawn yet.
+    QString pendingTransitionTo;             ///< Target state of that transition.
+    bool hasPendingTransition = false;       ///< pendingTransitionFrom and pendingTransitionTo are set.
+    QTimer transitionFlashTimer;             ///< Ends the highlight of the taken transition.
+    QJsonObject pendingProfile;              ///< Last PROFILE of the shown run not drawn yet.
+    bool hasPendingProfile = false;          ///< pendingProfile is set.
+    QJsonObject shownProfile;                ///< Profile of the heatmap on the canvas.
+    ProfileView* profileView = nullptr;      ///< Hot spots dialog, created when first shown.
+    QHash<QString, QString> pendingVariables; ///< Last value of every variable of the shown run not drawn yet.
 
     QString automatonName;                   ///< The name of the automaton.
     QString automatonDescription;            ///< The description of the automaton.
@@ -4,6 +4,8 @@
 
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include <QtCore/QJsonObject>
 #include <QtCore/QObject>
@@ -117,6 +119,48 @@ public:
         return NodeFlag::NoFlags;
     }
 
+    /**
+   * Checks if the connection is painted highlighted, e.g. the transition a
+   * running automaton has just taken. The model repaints it itself, no
+   * signal is emitted for a change.
+   */
+    virtual bool connectionHighlighted(ConnectionId const connectionId) const
+    {
+        Q_UNUSED(connectionId);
+        return false;
+    }
+
+    /**
+   * Heat of the node in [0, 1], painted as an overlay from cold to hot;
+   * 0 paints nothing. The model repaints the node itself, no signal is
+   * emitted for a change.
+   */
+    virtual float nodeHeat(NodeId const nodeId) const
+    {
+        Q_UNUSED(nodeId);
+        return 0.0f;
+    }
+
+    /**
+   * Heat of the connection in [0, 1], see nodeHeat().
+   */
+    virtual float connectionHeat(ConnectionId const connectionId) const
+    {
+        Q_UNUSED(connectionId);
+        return 0.0f;
+    }
+
+    /**
+   * Problems of the node found by a validation of the model, one per line;
+   * an empty text paints no badge. The model repaints the node itself, no
+   * signal is emitted for a change.
+   */
+    virtual QString nodeProblems(NodeId const nodeId) const
+    {
+        Q_UNUSED(nodeId);
+        return QString();
+    }
+
     /// @brief Sets node properties.
     /**
    * Sets: Node Caption, Node Caption Visibility,
@@ -152,6 +196,43 @@ public:
 
     virtual bool deleteConnection(ConnectionId const connectionId) = 0;
 
+    /// A connection is about to move to other port indices of the same nodes.
+    /**
+   * Called by portsAboutToBeInserted() and portsAboutToBeDeleted() for the
+   * connections whose ports are shifted, while the ports still have their
+   * old indices.
+   *
+   * The default implementation deletes the connection, reindexConnection()
+   * adds it under the new id once the ports are shifted. A model overriding
+   * reindexConnection() to keep the connection in place overrides this
+   * function as well, to keep the connection.
+   */
+    virtual void connectionAboutToBeReindexed(ConnectionId const oldConnectionId,
+                                              ConnectionId const newConnectionId)
+    {
+        Q_UNUSED(newConnectionId);
+        deleteConnection(oldConnectionId);
+    }
+
+    /// Moves a connection to other port indices of the same nodes.
+    /**
+   * Called by portsInserted() and portsDeleted() for the connections whose
+   * ports are shifted, see connectionAboutToBeReindexed(). `newConnectionId`
+   * must not exist yet.
+   *
+   * The default implementation adds the connection under the new id. A model
+   * keeping the connection data in place overrides the function and emits
+   * `connectionReindexed(oldConnectionId, newConnectionId)`, the scene then
+   * keeps the graphics object of the connection.
+   */
+    virtual bool reindexConnection(ConnectionId const oldConnectionId,
+                                   ConnectionId const newConnectionId)
+    {
+        Q_UNUSED(oldConnectionId);
+        addConnection(newConnectionId);
+        return true;
+    }
+
     virtual bool deleteNode(NodeId const nodeId) = 0;
 
     /**
@@ -202,6 +283,9 @@ public:
     /**
    * Signal emitted when model no longer has the old data associated with the
    * given port indices and when the node must be repainted.
+   *
+   * Function re-indexes the connections that were shifted during the port
+   * deletion.
    */
     void portsDeleted();
 
@@ -220,8 +304,8 @@ public:
                                 PortIndex const last);
 
     /**
-   * Function re-creates the connections that were shifted during the port
-   * insertion. After that the node is updated.
+   * Function re-indexes the connections that were shifted during the port
+   * insertion, see reindexConnection(). After that the node is updated.
    */
     void portsInserted();
 
@@ -230,6 +314,10 @@ Q_SIGNALS:
 
     void connectionDeleted(ConnectionId const connectionId);
 
+    /// The connection moved to other ports of its nodes, see reindexConnection().
+    void connectionReindexed(ConnectionId const oldConnectionId,
+                             ConnectionId const newConnectionId);
+
     void nodeCreated(NodeId const nodeId);
 
     void nodeDeleted(NodeId const nodeId);
@@ -243,7 +331,8 @@ Q_SIGNALS:
     void modelReset();
 
 private:
-    std::vector<ConnectionId> _shiftedByDynamicPortsConnections;
+    /// The old and the new ids of the shifted connections, in the order they are re-indexed.
+    std::vector<std::pair<ConnectionId, ConnectionId>> _shiftedByDynamicPortsConnections;
 };
 
 } // namespace QtNodes
@@ -36,6 +36,12 @@ public:
    */
     virtual void recomputeSize(NodeId const nodeId) const = 0;
 
+    /**
+   * Drops measurements cached for the node. Called by the scene when the node
+   * was updated (caption or port data may have changed) or deleted.
+   */
+    virtual void invalidateNode(NodeId const nodeId) const { Q_UNUSED(nodeId); }
+
     /// Port position in node's coordinate system.
     virtual QPointF portPosition(NodeId const nodeId,
                                  PortType const portType,
@@ -72,6 +78,23 @@ public:
 
     virtual QRect resizeHandleRect(NodeId const nodeId) const = 0;
 
+    /**
+   * Rectangle of a painted port control for nodes with `NodeFlag::PortControls`,
+   * in node's coordinate system. The default implementation returns an empty
+   * rectangle, i.e. the geometry does not support port controls.
+   */
+    virtual QRectF portControlRect(NodeId const nodeId,
+                                   PortType const portType,
+                                   PortIndex const portIndex,
+                                   PortControl const control) const;
+
+    /// @returns true and the hit control if `nodePoint` lies on a port control.
+    bool checkPortControlHit(NodeId const nodeId,
+                             QPointF const nodePoint,
+                             PortType &portType,
+                             PortIndex &portIndex,
+                             PortControl &control) const;
+
 protected:
     AbstractGraphModel &_graphModel;
 };
@@ -8,15 +8,19 @@
 #include <memory>
 #include <tuple>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include "AbstractGraphModel.hpp"
 #include "AbstractNodeGeometry.hpp"
 #include "ConnectionIdHash.hpp"
 #include "Definitions.hpp"
 #include "Export.hpp"
+#include "NodeSpatialIndex.hpp"
 
 #include "QUuidStdHash.hpp"
 
+class QTimer;
 class QUndoStack;
 
 namespace QtNodes {
@@ -58,6 +62,38 @@ public:
 
     QUndoStack &undoStack();
 
+    /// Limits the memory kept by the payloads of the undo history.
+    /**
+   * When the commands on the stack keep more than `bytes`, the payloads of
+   * the oldest ones are spilled to temporary files and read back on undo.
+   * 0 disables the limit.
+   */
+    void setUndoMemoryBudget(std::size_t bytes);
+
+    std::size_t undoMemoryBudget() const { return _undoMemoryBudget; }
+
+    /// @returns the bytes currently kept in memory by the undo history.
+    std::size_t undoMemoryUsage() const;
+
+    /// Estimated memory of the graphics objects, see `graphicsMemoryUsage`.
+    struct GraphicsMemoryUsage
+    {
+        std::size_t nodeObjects = 0;
+        std::size_t connectionObjects = 0;
+        std::size_t pooledObjects = 0;  ///< kept for reuse by the virtualized mode
+        std::size_t objectBytes = 0;    ///< the objects, their private data and the maps
+        std::size_t cachedNodes = 0;    ///< visible nodes with a device coordinate cache
+        std::size_t cacheBytes = 0;     ///< pixels of these caches at the current zoom
+    };
+
+    /// @returns the estimate, computed on every call.
+    /**
+   * A node caches its painting as an ARGB pixmap of its bounding rectangle at
+   * the zoom of the view. The pixmaps live in `QPixmapCache`, so `cacheBytes`
+   * is at most its limit.
+   */
+    GraphicsMemoryUsage graphicsMemoryUsage() const;
+
 public:
     /// Creates a "draft" instance of ConnectionGraphicsObject.
     /**
@@ -78,6 +114,15 @@ public:
    */
     void resetDraftConnection();
 
+    /// Scales the connection points near the loose end of the draft connection.
+    /**
+   * Called once per mouse move of the draft with the scene position of its
+   * loose end. Only the nodes the spatial index finds within snapping range
+   * are scanned, `connectionPossible` is asked once per port while the draft
+   * exists, and only the nodes whose points change are repainted.
+   */
+    void updateDraftReaction(QPointF const sceneEndPoint);
+
     /// Deletes all the nodes. Connections are removed automatically.
     void clearScene();
 
@@ -94,8 +139,112 @@ public:
    */
     ConnectionGraphicsObject *connectionGraphicsObject(ConnectionId connectionId);
 
+    /// @returns the topmost node whose shape contains `scenePos`, or nullptr.
+    /**
+   * The lookup goes through the spatial index of node bounding rectangles
+   * instead of testing every item of the scene.
+   */
+    NodeGraphicsObject *nodeAt(QPointF const scenePos);
+
+    /// @returns ids of the nodes whose bounding rectangle intersects `sceneRect`.
+    std::vector<NodeId> nodesInRect(QRectF const &sceneRect) const;
+
+    /// @returns the indexed bounding rectangle of the node, an empty one if it is unknown.
+    QRectF nodeSceneRect(NodeId const nodeId) const { return _nodeIndex.rect(nodeId); }
+
+    /// Updates the spatial index entry of the node after it moved or was resized.
+    void updateNodeIndex(NodeGraphicsObject const &ngo);
+
+    /// Marks the connections of the node to be moved on the next frame.
+    /**
+   * Used while nodes are dragged with the mouse: a connection between two
+   * dragged nodes is recomputed once per frame instead of once per node and
+   * mouse event.
+   */
+    void moveConnectionsDeferred(NodeId const nodeId);
+
+    /// Moves the connections marked by `moveConnectionsDeferred` right away.
+    void flushConnectionMoves();
+
     Qt::Orientation orientation() const { return _orientation; }
 
+    /// @returns the level of detail selected by the last `setViewScale` call.
+    LevelOfDetail levelOfDetail() const { return _levelOfDetail; }
+
+    /// Sets the scales below which the painters switch to a simpler rendering.
+    /**
+   * Below `reducedScale` nodes are drawn as flat rectangles without text,
+   * connections as straight lines and embedded widgets are hidden. Below
+   * `minimalScale` the ports and connection end points are skipped as well.
+   */
+    void setLevelOfDetailThresholds(double reducedScale, double minimalScale);
+
+    /// Called by the view while it pans or zooms and once more when it settled.
+    /**
+   * While the view moves the painters fill the nodes flat instead of with
+   * gradients, connections between different data types get one color and
+   * the node shadows are off. Every node is repainted on both changes, its
+   * device cache holds the other rendering.
+   */
+    void setViewMoving(bool moving);
+
+    bool isViewMoving() const { return _viewMoving; }
+
+    /// Lets the view draw the plain connections of the minimal level of detail.
+    /**
+   * The connections that are neither selected, hovered, highlighted nor
+   * being constructed are then skipped by their items and drawn by
+   * `drawBatchedConnections` as one set of lines behind the nodes. The view
+   * must not cache its background meanwhile.
+   */
+    void setBatchedConnections(bool enabled);
+
+    bool batchedConnections() const { return _batchedConnections; }
+
+    /// @returns true if the connection is drawn in the batch instead of by its item.
+    bool isBatchedConnection(ConnectionGraphicsObject const &cgo) const;
+
+    /// Draws the batched connections intersecting `sceneRect` with one call.
+    void drawBatchedConnections(QPainter *painter, QRectF const &sceneRect) const;
+
+    /// Shows graphs of at least `nodeCount` nodes in the virtualized mode, 0 never does.
+    /**
+   * In the virtualized mode only the nodes and connections intersecting the
+   * rectangle set by `setVisibleSceneRect` plus a margin have graphics
+   * objects, selected and grabbed ones keep theirs. The rest is kept in
+   * spatial indexes built from the model geometry. Objects leaving the area
+   * are pooled and rebound to the items entering it, so panning through a
+   * huge graph does not allocate. `nodeGraphicsObject` and
+   * `connectionGraphicsObject` return nullptr for the items without an
+   * object. Nodes with an embedded widget keep their object once it exists.
+   *
+   * The mode is chosen again on every model reset.
+   */
+    void setVirtualizationThreshold(std::size_t nodeCount);
+
+    std::size_t virtualizationThreshold() const { return _virtualizationThreshold; }
+
+    bool isVirtualized() const { return _virtualized; }
+
+    /// Called by the view when the visible part of the scene changes.
+    void setVisibleSceneRect(QRectF const &sceneRect);
+
+    /// @returns the rectangle around all the nodes, with or without graphics objects.
+    QRectF nodesBoundingRect() const;
+
+    /// Number of released node and of released connection objects kept for reuse.
+    /**
+   * Deleted nodes and connections, a model reset and the virtualized mode
+   * put their objects into pools, new items take them from there and rebind
+   * them instead of allocating, so undo, redo and reloading of large edits
+   * do not churn the items. The embedded widget of a deleted node is deleted
+   * with it, the model creates a new one for the next node. A lower capacity
+   * frees the surplus objects.
+   */
+    void setGraphicsObjectPoolCapacity(std::size_t capacity);
+
+    std::size_t graphicsObjectPoolCapacity() const { return _poolCapacity; }
+
     void setOrientation(Qt::Orientation const orientation);
 
 public:
@@ -129,6 +278,12 @@ Q_SIGNALS:
 
     void connectionClicked(ConnectionId const connectionId);
 
+    /// A painted port control of a node with `NodeFlag::PortControls` was clicked.
+    void portControlClicked(NodeId const nodeId,
+                            PortType const portType,
+                            PortIndex const portIndex,
+                            PortControl const control);
+
 private:
     /// @brief Creates Node and Connection graphics objects.
     /**
@@ -141,6 +296,44 @@ private:
     /// Redraws adjacent nodes for given `connectionId`
     void updateAttachedNodes(ConnectionId const connectionId, PortType const portType);
 
+    /// Spills the oldest undo payloads until the history fits the budget.
+    void enforceUndoMemoryBudget();
+
+    /// Stores the model geometry of the node in the node index.
+    void indexNode(NodeId const nodeId);
+
+    /// Stores the rectangle around both end nodes in the connection index.
+    void indexConnection(ConnectionId const connectionId);
+
+    void indexNodeConnections(NodeId const nodeId);
+
+    void unindexConnection(ConnectionId const connectionId);
+
+    /// The visible rectangle plus the margin of materialized items.
+    QRectF materializedArea() const;
+
+    void scheduleMaterialization();
+
+    /// Creates, recycles and releases objects to match the materialized area.
+    void updateMaterializedItems();
+
+    void materializeNode(NodeId const nodeId);
+
+    void materializeConnection(ConnectionId const connectionId);
+
+    /// Moves the object of the node to the pool, it stays owned by the scene.
+    void dematerializeNode(NodeId const nodeId);
+
+    void dematerializeConnection(ConnectionId const connectionId);
+
+    /// Takes the object out of the scene into the pool, deletes it if the pool is full.
+    void recycleNode(std::unique_ptr<NodeGraphicsObject> ngo);
+
+    void recycleConnection(std::unique_ptr<ConnectionGraphicsObject> cgo);
+
+    /// Restores the connection points of the reacting nodes, forgets the cached possibilities.
+    void resetDraftReaction();
+
 public Q_SLOTS:
     /// Slot called when the `connectionId` is erased form the AbstractGraphModel.
     void onConnectionDeleted(ConnectionId const connectionId);
@@ -148,6 +341,10 @@ public Q_SLOTS:
     /// Slot called when the `connectionId` is created in the AbstractGraphModel.
     void onConnectionCreated(ConnectionId const connectionId);
 
+    /// Slot called when a connection moved to other ports, its object is kept.
+    void onConnectionReindexed(ConnectionId const oldConnectionId,
+                               ConnectionId const newConnectionId);
+
     void onNodeDeleted(NodeId const nodeId);
 
     void onNodeCreated(NodeId const nodeId);
@@ -160,6 +357,9 @@ public Q_SLOTS:
 
     void onModelReset();
 
+    /// Called by the view when its zoom changes, selects the level of detail.
+    void setViewScale(double scale);
+
 private:
     AbstractGraphModel &_graphModel;
 
@@ -173,6 +373,45 @@ private:
 
     std::unique_ptr<ConnectionGraphicsObject> _draftConnection;
 
+    /// Nodes with connection points scaled by `updateDraftReaction`.
+    std::vector<NodeId> _reactingNodes;
+
+    /// `connectionPossible` of the complete ids of the draft, asked once per port.
+    std::unordered_map<ConnectionId, bool> _draftPossible;
+
+    NodeSpatialIndex _nodeIndex;
+
+    /// Connections of the virtualized mode, keyed by `_connectionKeys`.
+    NodeSpatialIndex _connectionIndex;
+
+    std::unordered_map<ConnectionId, NodeId> _connectionKeys;
+
+    std::unordered_map<NodeId, ConnectionId> _connectionsByKey;
+
+    NodeId _nextConnectionKey;
+
+    std::vector<UniqueNodeGraphicsObject> _nodePool;
+
+    std::vector<UniqueConnectionGraphicsObject> _connectionPool;
+
+    QRectF _visibleSceneRect;
+
+    QTimer *_materializeTimer;
+
+    std::size_t _virtualizationThreshold;
+
+    bool _virtualized;
+
+    bool _viewMoving;
+
+    bool _batchedConnections;
+
+    std::size_t _poolCapacity;
+
+    std::unordered_set<ConnectionId> _dirtyConnections;
+
+    QTimer *_connectionMoveTimer;
+
     std::unique_ptr<AbstractNodeGeometry> _nodeGeometry;
 
     std::unique_ptr<AbstractNodePainter> _nodePainter;
@@ -183,7 +422,29 @@ private:
 
     QUndoStack *_undoStack;
 
+    std::size_t _undoMemoryBudget;
+
     Qt::Orientation _orientation;
+
+    LevelOfDetail _levelOfDetail;
+
+    double _viewScale;
+
+    double _reducedDetailScale;
+
+    double _minimalDetailScale;
+
+    /// Scene units around the visible rectangle that are materialized as well.
+    static constexpr qreal kMaterializedMargin = 400.0;
+
+    /// Distance of the loose end within which a possible connection point grows.
+    static constexpr double kSnapRange = 40.0;
+
+    /// Distance within which an impossible connection point shrinks, the range of the scan.
+    static constexpr double kRejectRange = 80.0;
+
+    /// Default of `setGraphicsObjectPoolCapacity`.
+    static constexpr std::size_t kDefaultPoolCapacity = 2048;
 };
 
 } // namespace QtNodes
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <QtCore/QRect>
+#include <QtCore/QString>
+#include <QtGui/QFont>
+
+#include <memory>
+
+#include "Export.hpp"
+
+namespace QtNodes {
+
+/// QFontMetrics with memoized text measurements.
+/**
+ * Node geometries measure the same captions and port labels on every size
+ * recomputation and paint. Measurements are cached per (font, text) and the
+ * cache of a font is shared by all the instances created for an equal font,
+ * e.g. by the horizontal and the vertical node geometry.
+ */
+class NODE_EDITOR_PUBLIC CachedFontMetrics
+{
+public:
+    explicit CachedFontMetrics(QFont const &font);
+
+    int height() const;
+
+    QRect boundingRect(QString const &text) const;
+
+    int horizontalAdvance(QString const &text) const;
+
+private:
+    struct FontCache;
+
+    std::shared_ptr<FontCache> _cache;
+};
+
+} // namespace QtNodes
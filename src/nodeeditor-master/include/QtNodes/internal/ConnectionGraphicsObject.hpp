@@ -3,6 +3,7 @@
 #include <utility>
 
 #include <QtCore/QUuid>
+#include <QtGui/QPainterPath>
 #include <QtWidgets/QGraphicsObject>
 
 #include "ConnectionState.hpp"
@@ -49,11 +50,27 @@ public:
 
     std::pair<QPointF, QPointF> pointsC1C2() const;
 
+    /// Cubic spline from `out()` to `in()`, cached until an end point changes.
+    QPainterPath const &cubicPath() const;
+
     void setEndPoint(PortType portType, QPointF const &point);
 
+    /// Drops the cached path, stroke and bounding rect.
+    /**
+   * Called whenever an end point changes. Has to be called explicitly when
+   * the connection painter or the connection style is replaced.
+   */
+    void invalidateGeometry();
+
     /// Updates the position of both ends
     void move();
 
+    /// Reuses a pooled object, which is not in a scene, for another connection.
+    void rebind(BasicGraphicsScene &scene, ConnectionId const connectionId);
+
+    /// Follows the connection to other ports of its nodes, keeps the selection and hover.
+    void reindex(ConnectionId const connectionId);
+
     ConnectionState const &connectionState() const;
 
     ConnectionState &connectionState();
@@ -91,6 +108,15 @@ private:
 
     mutable QPointF _out;
     mutable QPointF _in;
+
+    // Geometry derived from the end points, rebuilt lazily
+    mutable QPainterPath _cubicPath;
+    mutable QPainterPath _stroke;
+    mutable QRectF _boundingRect;
+
+    mutable bool _cubicPathValid = false;
+    mutable bool _strokeValid = false;
+    mutable bool _boundingRectValid = false;
 };
 
 } // namespace QtNodes
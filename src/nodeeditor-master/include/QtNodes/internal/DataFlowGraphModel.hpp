@@ -11,6 +11,9 @@
 #include <QJsonObject>
 
 #include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 namespace QtNodes {
 
@@ -106,6 +109,10 @@ private:
 
 private Q_SLOTS:
     /**
+   * Marks the port dirty and, unless a propagation is running, delivers the
+   * dirty ports with `propagate()`. A node computing during the propagation
+   * only marks its ports, they are delivered by the running propagation.
+   *
    * Fuction is called in three cases:
    *
    * - By underlying NodeDelegateModel when a node has new data to propagate.
@@ -121,6 +128,20 @@ private Q_SLOTS:
     void propagateEmptyDataTo(NodeId const nodeId, PortIndex const portIndex);
 
 private:
+    /// Delivers the data of the dirty output ports to the connected inputs.
+    /**
+   * The nodes downstream of the dirty ports are visited once in topological
+   * order, so a node receives the new data of all its upstream nodes before
+   * its own outputs are delivered. A diamond is not computed once per path,
+   * the work is linear in the size of the affected subgraph. Nodes on a cycle
+   * are visited after the others, a port dirtied again behind the visit is
+   * delivered by another round.
+   */
+    void propagate();
+
+    /// Adds or removes the connection from `_nodeConnections`.
+    void indexConnection(ConnectionId const connectionId, bool add);
+
     std::shared_ptr<NodeDelegateModelRegistry> _registry;
 
     NodeId _nextNodeId;
@@ -129,6 +150,14 @@ private:
 
     std::unordered_set<ConnectionId> _connectivity;
 
+    /// Connections by the node on either side, the index of `_connectivity`.
+    std::unordered_map<NodeId, std::unordered_set<ConnectionId>> _nodeConnections;
+
+    /// Output ports with data not delivered yet.
+    std::unordered_map<NodeId, std::vector<PortIndex>> _dirtyPorts;
+
+    bool _propagating = false;
+
     mutable std::unordered_map<NodeId, NodeGeometryData> _nodeGeometryData;
 };
 
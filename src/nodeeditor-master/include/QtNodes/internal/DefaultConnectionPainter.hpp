@@ -17,10 +17,11 @@ public:
     void paint(QPainter *painter, ConnectionGraphicsObject const &cgo) const override;
     QPainterPath getPainterStroke(ConnectionGraphicsObject const &cgo) const override;
 private:
-    QPainterPath cubicPath(ConnectionGraphicsObject const &connection) const;
+    QPainterPath const &cubicPath(ConnectionGraphicsObject const &connection) const;
     void drawSketchLine(QPainter *painter, ConnectionGraphicsObject const &cgo) const;
     void drawHoveredOrSelected(QPainter *painter, ConnectionGraphicsObject const &cgo) const;
     void drawNormalLine(QPainter *painter, ConnectionGraphicsObject const &cgo) const;
+    void drawSimplifiedLine(QPainter *painter, ConnectionGraphicsObject const &cgo, LevelOfDetail lod) const;
 #ifdef NODE_DEBUG_DRAWING
     void debugDrawing(QPainter *painter, ConnectionGraphicsObject const &cgo) const;
 #endif
@@ -2,7 +2,10 @@
 
 #include "AbstractNodeGeometry.hpp"
 
-#include <QtGui/QFontMetrics>
+#include "CachedFontMetrics.hpp"
+
+#include <array>
+#include <unordered_map>
 
 namespace QtNodes {
 
@@ -19,6 +22,8 @@ public:
 
     void recomputeSize(NodeId const nodeId) const override;
 
+    void invalidateNode(NodeId const nodeId) const override;
+
     QPointF portPosition(NodeId const nodeId,
                          PortType const portType,
                          PortIndex const index) const override;
@@ -34,6 +39,11 @@ public:
 
     QRect resizeHandleRect(NodeId const nodeId) const override;
 
+    QRectF portControlRect(NodeId const nodeId,
+                           PortType const portType,
+                           PortIndex const portIndex,
+                           PortControl const control) const override;
+
 private:
     QRectF portTextRect(NodeId const nodeId,
                         PortType const portType,
@@ -44,6 +54,11 @@ private:
 
     unsigned int maxPortsTextAdvance(NodeId const nodeId, PortType const portType) const;
 
+    unsigned int measurePortsTextAdvance(NodeId const nodeId, PortType const portType) const;
+
+    /// Size of one painted port control, derived from the port size.
+    QSizeF portControlSize() const;
+
 private:
     // Some variables are mutable because we need to change drawing
     // metrics corresponding to fontMetrics but this doesn't change
@@ -51,8 +66,19 @@ private:
 
     mutable unsigned int _portSize;
     unsigned int _portSpasing;
-    mutable QFontMetrics _fontMetrics;
-    mutable QFontMetrics _boldFontMetrics;
+    mutable CachedFontMetrics _fontMetrics;
+    mutable CachedFontMetrics _boldFontMetrics;
+
+    /// Widest port label of a node, valid while the port count stays the same.
+    struct PortTextAdvance
+    {
+        PortCount portCount = 0;
+        unsigned int advance = 0;
+        bool valid = false;
+    };
+
+    /// Indexed by `PortType::In` and `PortType::Out`.
+    mutable std::unordered_map<NodeId, std::array<PortTextAdvance, 2>> _portTextAdvances;
 };
 
 } // namespace QtNodes
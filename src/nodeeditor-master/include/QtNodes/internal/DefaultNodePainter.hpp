@@ -30,5 +30,14 @@ public:
     void drawEntryLabels(QPainter *painter, NodeGraphicsObject &ngo) const;
 
     void drawResizeRect(QPainter *painter, NodeGraphicsObject &ngo) const;
+
+    /// [+]/[-] controls of nodes with `NodeFlag::PortControls`.
+    void drawPortControls(QPainter *painter, NodeGraphicsObject &ngo) const;
+
+    /// Warning badge in the top right corner of nodes with `nodeProblems()`.
+    void drawProblemBadge(QPainter *painter, NodeGraphicsObject &ngo) const;
+
+    /// Flat rectangle used below full level of detail, no text or gradients.
+    void drawSimplifiedNode(QPainter *painter, NodeGraphicsObject &ngo, LevelOfDetail lod) const;
 };
 } // namespace QtNodes
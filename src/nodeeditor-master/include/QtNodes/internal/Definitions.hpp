@@ -41,7 +41,9 @@ Q_ENUM_NS(NodeRole)
 enum NodeFlag {
     NoFlags = 0x0,   ///< Default NodeFlag
     Resizable = 0x1, ///< Lets the node be resizable
-    Locked = 0x2
+    Locked = 0x2,
+    PortControls = 0x4, ///< Ports get painted [+]/[-] controls, see `BasicGraphicsScene::portControlClicked`
+    Live = 0x8          ///< The node is the current state of a running automaton, painted highlighted
 };
 
 Q_DECLARE_FLAGS(NodeFlags, NodeFlag)
@@ -80,6 +82,25 @@ enum class PortType {
 };
 Q_ENUM_NS(PortType)
 
+/**
+ * Painted controls next to a port of a node with `NodeFlag::PortControls`.
+ */
+enum class PortControl {
+    Add = 0,   ///< Inserts a new port after the port.
+    Remove = 1 ///< Removes the port.
+};
+Q_ENUM_NS(PortControl)
+
+/**
+ * Amount of detail the painters draw, selected by the zoom of the view.
+ */
+enum class LevelOfDetail {
+    Full = 0,    ///< Everything: captions, port labels, curved connections, widgets.
+    Reduced = 1, ///< Flat node rectangles with ports, straight connections, no text.
+    Minimal = 2  ///< Flat node rectangles only, thin straight connections.
+};
+Q_ENUM_NS(LevelOfDetail)
+
 using PortCount = unsigned int;
 
 /// ports are consecutively numbered starting from zero.
@@ -2,8 +2,12 @@
 
 #include <QtWidgets/QGraphicsView>
 
+#include <cstddef>
+
 #include "Export.hpp"
 
+class QTimer;
+
 namespace QtNodes {
 
 class BasicGraphicsScene;
@@ -43,6 +47,37 @@ public:
 
     double getScale() const;
 
+    /// Lowers the render quality while the view pans or zooms.
+    /**
+   * Antialiasing, the node gradients and the node shadows are turned off
+   * with the first frame of a pan or zoom and restored once the view has not
+   * moved for `kSettleMs`. Enabled by default.
+   */
+    void setAdaptiveQuality(bool enabled);
+
+    bool adaptiveQuality() const { return _adaptiveQuality; }
+
+    /// Renders the scene through OpenGL instead of the raster engine.
+    /**
+   * The painters are used unchanged, QPainter draws with the GL paint engine.
+   * @returns false and keeps the raster viewport when the library was built
+   * without QOpenGLWidget or no OpenGL context can be created. The GL
+   * viewport is always repainted as a whole.
+   */
+    bool setOpenGLViewport(bool enabled);
+
+    bool isOpenGLViewport() const { return _openGLViewport; }
+
+    /// @returns true if an OpenGL viewport can be used on this system.
+    static bool openGLAvailable();
+
+    /// Draws the plain connections at minimal detail as one batch of lines.
+    /**
+   * See `BasicGraphicsScene::setBatchedConnections`. The background is not
+   * cached meanwhile, the lines are drawn with it.
+   */
+    void setBatchedConnections(bool enabled);
+
 public Q_SLOTS:
     void scaleUp();
 
@@ -61,6 +96,9 @@ public Q_SLOTS:
 Q_SIGNALS:
     void scaleChanged(double scale);
 
+    /// The part of the scene shown by the viewport changed.
+    void visibleSceneRectChanged(QRectF const &sceneRect);
+
 protected:
     void contextMenuEvent(QContextMenuEvent *event) override;
 
@@ -78,12 +116,37 @@ protected:
 
     void showEvent(QShowEvent *event) override;
 
+    void resizeEvent(QResizeEvent *event) override;
+
+    void scrollContentsBy(int dx, int dy) override;
+
 protected:
     BasicGraphicsScene *nodeScene();
 
     /// Computes scene position for pasting the copied/duplicated node groups.
     QPointF scenePastePosition();
 
+private:
+    /// Tells the scene which part of it is shown, a virtualized scene materializes it.
+    void updateVisibleSceneRect();
+
+    /// Switches to the fast rendering, called for every frame of a pan or zoom.
+    void beginViewMove();
+
+    /// Restores the full quality after the view has settled.
+    void endViewMove();
+
+    /// Repaints the whole viewport when many nodes are shown, only the changed items otherwise.
+    void updateViewportUpdateMode();
+
+    static constexpr int kSettleMs = 150;
+
+    /// Visible nodes up to which only the changed region is repainted.
+    static constexpr std::size_t kSmartUpdateNodes = 30;
+
+    /// Visible nodes from which the whole viewport is repainted.
+    static constexpr std::size_t kFullUpdateNodes = 150;
+
 private:
     QAction *_clearSelectionAction = nullptr;
     QAction *_deleteSelectionAction = nullptr;
@@ -93,5 +156,11 @@ private:
 
     QPointF _clickPos;
     ScaleRange _scaleRange;
+
+    QTimer *_settleTimer = nullptr;
+    bool _adaptiveQuality = true;
+    bool _viewMoving = false;
+    bool _antialiasing = true;  ///< the hint before the view started moving
+    bool _openGLViewport = false;
 };
 } // namespace QtNodes
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <QtCore/QRectF>
+#include <QtGui/QImage>
+#include <QtGui/QTransform>
+#include <QtWidgets/QWidget>
+
+#include <unordered_map>
+#include <vector>
+
+#include "Definitions.hpp"
+#include "Export.hpp"
+
+class QTimer;
+
+namespace QtNodes {
+
+class BasicGraphicsScene;
+class GraphicsView;
+
+/// Overview of the whole scene of a `GraphicsView` with its visible rectangle.
+/**
+ * The nodes are drawn as flat rectangles into a cached image, from the node
+ * index of the scene, so nodes without graphics objects of a virtualized
+ * scene are shown as well and the scene items are never rendered. A node
+ * change repaints only the image regions of its old and new rectangle, the
+ * changes are collected for `kRenderDelayMs`. The image is rendered again as
+ * a whole when the widget is resized, the model is reset or a node leaves
+ * the area of the image. Clicking or dragging centers the view on the point.
+ */
+class NODE_EDITOR_PUBLIC MinimapWidget : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit MinimapWidget(GraphicsView &view, QWidget *parent = nullptr);
+
+    QSize sizeHint() const override;
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+    void resizeEvent(QResizeEvent *event) override;
+
+    void mousePressEvent(QMouseEvent *event) override;
+
+    void mouseMoveEvent(QMouseEvent *event) override;
+
+private:
+    /// Marks the old and the new rectangle of the node for repainting.
+    void onNodeChanged(NodeId const nodeId);
+
+    void onNodeDeleted(NodeId const nodeId);
+
+    void scheduleFullRender();
+
+    /// Renders what was marked since the last call.
+    void flush();
+
+    void renderAll();
+
+    void renderRegion(QRectF const &sceneRect);
+
+    void drawNodes(QPainter &painter, QRectF const &sceneRect);
+
+    void centerViewAt(QPointF const &widgetPos);
+
+    static constexpr int kRenderDelayMs = 50;
+
+private:
+    GraphicsView &_view;
+
+    BasicGraphicsScene *_scene;
+
+    QImage _image;
+
+    /// Scene area shown by the image.
+    QRectF _worldRect;
+
+    /// Scene to widget coordinates.
+    QTransform _sceneToWidget;
+
+    /// The rectangles the image shows, to repaint where a node was.
+    std::unordered_map<NodeId, QRectF> _nodeRects;
+
+    std::vector<QRectF> _dirtyRects;
+
+    bool _fullRenderPending = true;
+
+    QTimer *_renderTimer;
+
+    QRectF _visibleSceneRect;
+};
+
+} // namespace QtNodes
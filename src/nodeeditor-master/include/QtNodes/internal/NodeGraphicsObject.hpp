@@ -1,9 +1,12 @@
 #pragma once
 
+#include <memory>
+
 #include <QtCore/QUuid>
 #include <QtWidgets/QGraphicsObject>
 
 #include "NodeState.hpp"
+#include "NodeStyle.hpp"
 
 class QGraphicsProxyWidget;
 
@@ -47,11 +50,24 @@ public:
     /// their corresponding end points.
     void moveConnections() const;
 
-    /// Repaints the node once with reacting ports.
-    void reactToConnection(ConnectionGraphicsObject const *cgo);
-
     void updateQWidgetEmbedPos();
 
+    /// Shows the embedded widget only at full detail and repaints the node.
+    void updateLevelOfDetail();
+
+    /// The resolved style of the node. It is read from the model once and
+    /// cached until the global node style or the node itself changes.
+    NodeStyle const &nodeStyle() const;
+
+    /// Makes the next nodeStyle() call read the style from the model again.
+    void invalidateNodeStyle();
+
+    /// Reuses a pooled object, which is not in a scene, for another node.
+    void rebind(BasicGraphicsScene &scene, NodeId const nodeId);
+
+    /// Deletes the proxy with the embedded widget of a deleted node before the object is pooled.
+    void removeEmbeddedWidget();
+
 protected:
     void paint(QPainter *painter,
                QStyleOptionGraphicsItem const *option,
@@ -76,6 +92,9 @@ protected:
     void contextMenuEvent(QGraphicsSceneContextMenuEvent *event) override;
 
 private:
+    /// Sets up everything read from the model, used by the constructor and `rebind`.
+    void initializeForNode();
+
     void embedQWidget();
 
     void setLockedState();
@@ -89,5 +108,10 @@ private:
 
     // either nullptr or owned by parent QGraphicsItem
     QGraphicsProxyWidget *_proxyWidget;
+
+    // nodes using the global style share StyleCollection::sharedNodeStyle()
+    mutable std::shared_ptr<NodeStyle const> _nodeStyle;
+
+    mutable unsigned int _nodeStyleVersion = 0;
 };
 } // namespace QtNodes
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <QtCore/QPointF>
+#include <QtCore/QRectF>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "Definitions.hpp"
+#include "Export.hpp"
+
+namespace QtNodes {
+
+/// Uniform grid of node bounding rectangles in scene coordinates.
+/**
+ * Covers the nodes only and is updated incrementally when a node moves or
+ * changes size, so node lookups do not wait for the scene's BSP tree to be
+ * rebuilt after a drag. Lookups visit the cells overlapping the query and test
+ * the stored rectangles, so their cost depends on the local node density only.
+ */
+class NODE_EDITOR_PUBLIC NodeSpatialIndex
+{
+public:
+    explicit NodeSpatialIndex(qreal cellSize = 256.0);
+
+    /// Inserts the node or moves it to the new rectangle.
+    void update(NodeId const nodeId, QRectF const &sceneRect);
+
+    void remove(NodeId const nodeId);
+
+    void clear();
+
+    /// @returns nodes whose rectangle contains `scenePoint`.
+    std::vector<NodeId> nodesAt(QPointF const &scenePoint) const;
+
+    /// @returns nodes whose rectangle intersects `sceneRect`.
+    std::vector<NodeId> nodesIn(QRectF const &sceneRect) const;
+
+    std::size_t size() const { return _rects.size(); }
+
+    bool contains(NodeId const nodeId) const { return _rects.count(nodeId) > 0; }
+
+    /// @returns the stored rectangle of the node, an empty one for an unknown node.
+    QRectF rect(NodeId const nodeId) const;
+
+    /// @returns all the stored nodes.
+    std::vector<NodeId> nodes() const;
+
+    /// @returns the rectangle around all the stored rectangles.
+    QRectF boundingRect() const;
+
+private:
+    struct CellRange
+    {
+        int x0, y0, x1, y1;
+
+        bool operator==(CellRange const &other) const
+        {
+            return x0 == other.x0 && y0 == other.y0 && x1 == other.x1 && y1 == other.y1;
+        }
+    };
+
+    struct Entry
+    {
+        QRectF rect;
+        CellRange cells;
+    };
+
+    CellRange cellRange(QRectF const &rect) const;
+
+    static std::int64_t cellKey(int x, int y)
+    {
+        return (static_cast<std::int64_t>(x) << 32) ^ static_cast<std::uint32_t>(y);
+    }
+
+    void addToCells(NodeId const nodeId, CellRange const &range);
+
+    void removeFromCells(NodeId const nodeId, CellRange const &range);
+
+private:
+    qreal _cellSize;
+
+    std::unordered_map<NodeId, Entry> _rects;
+
+    std::unordered_map<std::int64_t, std::vector<NodeId>> _cells;
+};
+
+} // namespace QtNodes
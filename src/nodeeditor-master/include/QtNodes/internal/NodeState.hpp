@@ -4,7 +4,6 @@
 #include <vector>
 
 #include <QtCore/QPointF>
-#include <QtCore/QPointer>
 #include <QtCore/QUuid>
 
 #include "Export.hpp"
@@ -32,11 +31,20 @@ public:
 
     bool resizing() const;
 
-    ConnectionGraphicsObject const *connectionForReaction() const;
+    /// Sets the scales of the connection points near a draft connection.
+    /**
+   * `scales` has one entry per port of `portType`, 1.0 for the normal size.
+   * @returns false when the node already had the same scales, so it needs
+   * no repaint.
+   */
+    bool setReactingPorts(PortType portType, std::vector<double> scales);
 
-    void storeConnectionForReaction(ConnectionGraphicsObject const *cgo);
+    /// @returns the scale of the connection point, 1.0 when it does not react.
+    double connectionPointScale(PortType portType, PortIndex portIndex) const;
 
-    void resetConnectionForReaction();
+    bool reacting() const { return _reactionPort != PortType::None; }
+
+    void resetReactingPorts();
 
 private:
     NodeGraphicsObject &_ngo;
@@ -45,8 +53,9 @@ private:
 
     bool _resizing;
 
-    // QPointer tracks the QObject inside and is automatically cleared
-    // when the object is destroyed.
-    QPointer<ConnectionGraphicsObject const> _connectionForReaction;
+    /// Ports scaled by `_reactionScales`, `PortType::None` when none are.
+    PortType _reactionPort;
+
+    std::vector<double> _reactionScales;
 };
 } // namespace QtNodes
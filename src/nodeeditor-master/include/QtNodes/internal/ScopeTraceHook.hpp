@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+
+#include "Export.hpp"
+
+namespace QtNodes {
+
+/// Receives the timed scopes of the library, e.g. to write them to a trace.
+/**
+ * `name` is a string literal. The hook is called on the thread of the
+ * scope when the scope ends.
+ */
+using ScopeTraceHook = void (*)(char const *name,
+                                std::chrono::steady_clock::time_point begin,
+                                std::chrono::steady_clock::time_point end);
+
+/// Installs the hook, nullptr (the default) turns the scopes off.
+NODE_EDITOR_PUBLIC void setScopeTraceHook(ScopeTraceHook hook);
+
+NODE_EDITOR_PUBLIC ScopeTraceHook scopeTraceHook();
+
+/// Times its lifetime and reports it to the hook installed when it was created.
+class ScopeTraceTimer
+{
+public:
+    explicit ScopeTraceTimer(char const *name)
+        : _hook(scopeTraceHook())
+        , _name(name)
+    {
+        if (_hook)
+            _begin = std::chrono::steady_clock::now();
+    }
+
+    ~ScopeTraceTimer()
+    {
+        if (_hook)
+            _hook(_name, _begin, std::chrono::steady_clock::now());
+    }
+
+    ScopeTraceTimer(ScopeTraceTimer const &) = delete;
+    ScopeTraceTimer &operator=(ScopeTraceTimer const &) = delete;
+
+private:
+    ScopeTraceHook const _hook;
+    char const *const _name;
+    std::chrono::steady_clock::time_point _begin;
+};
+
+} // namespace QtNodes
+
+#define QTNODES_TRACE_CONCAT_(a, b) a##b
+#define QTNODES_TRACE_CONCAT(a, b) QTNODES_TRACE_CONCAT_(a, b)
+
+/// Times the rest of the block, compiled out with QTNODES_NO_SCOPE_TRACE.
+#ifdef QTNODES_NO_SCOPE_TRACE
+#define QTNODES_TRACE_SCOPE(name) ((void) 0)
+#else
+#define QTNODES_TRACE_SCOPE(name) \
+    ::QtNodes::ScopeTraceTimer QTNODES_TRACE_CONCAT(qtnodesTraceScope, __LINE__)(name)
+#endif
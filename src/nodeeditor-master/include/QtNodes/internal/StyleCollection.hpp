@@ -1,5 +1,9 @@
 #pragma once
 
+#include <memory>
+
+#include <QtCore/QJsonObject>
+
 #include "Export.hpp"
 
 #include "ConnectionStyle.hpp"
@@ -13,6 +17,15 @@ class NODE_EDITOR_PUBLIC StyleCollection
 public:
     static NodeStyle const &nodeStyle();
 
+    /// Shared instance of the current node style, for caches that hold on to it.
+    static std::shared_ptr<NodeStyle const> sharedNodeStyle();
+
+    /// The current node style serialized to JSON, serialized once per style version.
+    static QJsonObject const &nodeStyleJson();
+
+    /// Incremented on every setNodeStyle(), caches of resolved node styles compare it.
+    static unsigned int nodeStyleVersion();
+
     static ConnectionStyle const &connectionStyle();
 
     static GraphicsViewStyle const &flowViewStyle();
@@ -36,6 +49,14 @@ private:
 private:
     NodeStyle _nodeStyle;
 
+    unsigned int _nodeStyleVersion = 1;
+
+    mutable std::shared_ptr<NodeStyle const> _sharedNodeStyle;
+
+    mutable QJsonObject _nodeStyleJson;
+
+    mutable unsigned int _nodeStyleJsonVersion = 0;
+
     ConnectionStyle _connectionStyle;
 
     GraphicsViewStyle _flowViewStyle;
@@ -3,16 +3,117 @@
 #include "Definitions.hpp"
 
 #include <QUndoCommand>
+#include <QtCore/QByteArray>
 #include <QtCore/QJsonObject>
 #include <QtCore/QPointF>
 
+#include <functional>
+#include <memory>
 #include <unordered_set>
+#include <vector>
+
+class QTemporaryFile;
 
 namespace QtNodes {
 
+class AbstractGraphModel;
 class BasicGraphicsScene;
 
-class CreateCommand : public QUndoCommand
+/// Serialized group of nodes and connections kept by the undo commands.
+/**
+ * Ids and positions are stored as plain values, the rest of the node JSON
+ * returned by `AbstractGraphModel::saveNode` is kept as a CBOR blob. JSON is
+ * only produced when a node is handed back to `loadNode` or when another
+ * application asks the clipboard for it.
+ *
+ * A snapshot can be spilled to a temporary file to release its memory, it is
+ * read back by `restore()` before it is used again.
+ */
+class SceneSnapshot
+{
+public:
+    SceneSnapshot();
+    ~SceneSnapshot();
+
+    SceneSnapshot(SceneSnapshot &&);
+    SceneSnapshot &operator=(SceneSnapshot &&);
+
+    struct Node
+    {
+        NodeId id;
+        QPointF position;
+        QByteArray data; ///< CBOR of the saveNode() object without "id" and "position"
+    };
+
+    static SceneSnapshot fromJson(QJsonObject const &sceneJson);
+
+    QJsonObject toJson() const;
+
+    void addNode(QJsonObject const &nodeJson);
+
+    /// Compact binary form put on the clipboard by `CopyCommand`.
+    /**
+   * The node blobs are written as they are, the connections refer to the
+   * nodes by their index in the snapshot.
+   */
+    QByteArray toClipboardData() const;
+
+    /// Reads `toClipboardData()`.
+    /**
+   * With `newNodeId` every node gets the id it returns and the connections
+   * are remapped while they are read, the ids are replaced in one pass.
+   * @returns an empty snapshot if the data is not valid.
+   */
+    static SceneSnapshot fromClipboardData(QByteArray const &data,
+                                           std::function<NodeId()> const &newNodeId = {});
+
+    /// @returns the object passed to `AbstractGraphModel::loadNode`.
+    static QJsonObject nodeJson(Node const &node);
+
+    bool empty() const { return !_spillFile && nodes.empty() && connections.empty(); }
+
+    QPointF averagePosition() const;
+
+    void offset(QPointF const &diff);
+
+    /// Approximate heap usage of the snapshot in bytes, 0 when spilled.
+    std::size_t byteSize() const;
+
+    /// Writes the nodes and connections to a temporary file and frees them.
+    /**
+   * @returns false if the file could not be written, the snapshot is then
+   * kept in memory.
+   */
+    bool spill();
+
+    /// Reads a spilled snapshot back, does nothing when it is in memory.
+    void restore();
+
+    bool spilled() const { return _spillFile != nullptr; }
+
+public:
+    std::vector<Node> nodes;
+    std::vector<ConnectionId> connections;
+
+private:
+    std::unique_ptr<QTemporaryFile> _spillFile;
+};
+
+/// Undo command whose payload is accounted in the undo memory budget.
+/**
+ * See `BasicGraphicsScene::setUndoMemoryBudget`.
+ */
+class NODE_EDITOR_PUBLIC UndoPayloadCommand : public QUndoCommand
+{
+public:
+    /// @returns the bytes the command currently keeps in memory.
+    virtual std::size_t byteSize() const = 0;
+
+    /// Releases the payload memory, e.g. by spilling it to disk.
+    virtual void spill() {}
+};
+
+class CreateCommand : public UndoPayloadCommand
 {
 public:
     CreateCommand(BasicGraphicsScene *scene, QString const name, QPointF const &mouseScenePos);
@@ -20,17 +121,20 @@ public:
     void undo() override;
     void redo() override;
 
+    std::size_t byteSize() const override;
+    void spill() override;
+
 private:
     BasicGraphicsScene *_scene;
     NodeId _nodeId;
-    QJsonObject _sceneJson;
+    SceneSnapshot _snapshot;
 };
 
 /**
  * Selected scene objects are serialized and then removed from the scene.
  * The deleted elements could be restored in `undo`.
  */
-class DeleteCommand : public QUndoCommand
+class NODE_EDITOR_PUBLIC DeleteCommand : public UndoPayloadCommand
 {
 public:
     DeleteCommand(BasicGraphicsScene *scene);
@@ -38,9 +142,12 @@ public:
     void undo() override;
     void redo() override;
 
+    std::size_t byteSize() const override;
+    void spill() override;
+
 private:
     BasicGraphicsScene *_scene;
-    QJsonObject _sceneJson;
+    SceneSnapshot _snapshot;
 };
 
 class CopyCommand : public QUndoCommand
@@ -49,7 +156,7 @@ public:
     CopyCommand(BasicGraphicsScene *scene);
 };
 
-class PasteCommand : public QUndoCommand
+class PasteCommand : public UndoPayloadCommand
 {
 public:
     PasteCommand(BasicGraphicsScene *scene, QPointF const &mouseScenePos);
@@ -57,14 +164,18 @@ public:
     void undo() override;
     void redo() override;
 
+    std::size_t byteSize() const override;
+    void spill() override;
+
 private:
+    SceneSnapshot takeSnapshotFromClipboard();
     QJsonObject takeSceneJsonFromClipboard();
-    QJsonObject makeNewNodeIdsInScene(QJsonObject const &sceneJson);
+    void makeNewNodeIdsInScene(SceneSnapshot &snapshot);
 
 private:
     BasicGraphicsScene *_scene;
     QPointF const &_mouseScenePos;
-    QJsonObject _newSceneJson;
+    SceneSnapshot _newSnapshot;
 };
 
 class DisconnectCommand : public QUndoCommand
@@ -95,7 +206,7 @@ private:
     ConnectionId _connId;
 };
 
-class MoveNodeCommand : public QUndoCommand
+class NODE_EDITOR_PUBLIC MoveNodeCommand : public UndoPayloadCommand
 {
 public:
     MoveNodeCommand(BasicGraphicsScene *scene, QPointF const &diff);
@@ -103,6 +214,8 @@ public:
     void undo() override;
     void redo() override;
 
+    std::size_t byteSize() const override;
+
     /**
    * A command ID is used in command compression. It must be an integer unique to
    * this command's class, or -1 if the command doesn't support compression.
@@ -33,6 +33,7 @@ void AbstractGraphModel::portsAboutToBeDeleted(NodeId const nodeId,
 
     std::size_t const nRemovedPorts = clampedLast - first + 1;
 
+    // lowest port first, the port a connection moves to has been emptied before
     for (PortIndex portIndex = clampedLast + 1; portIndex < portCount; ++portIndex) {
         std::unordered_set<ConnectionId> conns = connections(nodeId, portType, portIndex);
 
@@ -42,17 +43,19 @@ void AbstractGraphModel::portsAboutToBeDeleted(NodeId const nodeId,
 
             c = makeCompleteConnectionId(c, nodeId, portIndex - nRemovedPorts);
 
-            _shiftedByDynamicPortsConnections.push_back(c);
-
-            deleteConnection(connectionId);
+            _shiftedByDynamicPortsConnections.emplace_back(connectionId, c);
         }
     }
+
+    for (auto const &shifted : _shiftedByDynamicPortsConnections) {
+        connectionAboutToBeReindexed(shifted.first, shifted.second);
+    }
 }
 
 void AbstractGraphModel::portsDeleted()
 {
-    for (auto const connectionId : _shiftedByDynamicPortsConnections) {
-        addConnection(connectionId);
+    for (auto const &shifted : _shiftedByDynamicPortsConnections) {
+        reindexConnection(shifted.first, shifted.second);
     }
 
     _shiftedByDynamicPortsConnections.clear();
@@ -77,7 +80,8 @@ void AbstractGraphModel::portsAboutToBeInserted(NodeId const nodeId,
 
     std::size_t const nNewPorts = last - first + 1;
 
-    for (PortIndex portIndex = first; portIndex < portCount; ++portIndex) {
+    // highest port first, the port a connection moves to has been emptied before
+    for (PortIndex portIndex = portCount; portIndex-- > first;) {
         std::unordered_set<ConnectionId> conns = connections(nodeId, portType, portIndex);
 
         for (auto connectionId : conns) {
@@ -86,17 +90,19 @@ void AbstractGraphModel::portsAboutToBeInserted(NodeId const nodeId,
 
             c = makeCompleteConnectionId(c, nodeId, portIndex + nNewPorts);
 
-            _shiftedByDynamicPortsConnections.push_back(c);
-
-            deleteConnection(connectionId);
+            _shiftedByDynamicPortsConnections.emplace_back(connectionId, c);
         }
     }
+
+    for (auto const &shifted : _shiftedByDynamicPortsConnections) {
+        connectionAboutToBeReindexed(shifted.first, shifted.second);
+    }
 }
 
 void AbstractGraphModel::portsInserted()
 {
-    for (auto const connectionId : _shiftedByDynamicPortsConnections) {
-        addConnection(connectionId);
+    for (auto const &shifted : _shiftedByDynamicPortsConnections) {
+        reindexConnection(shifted.first, shifted.second);
     }
 
     _shiftedByDynamicPortsConnections.clear();
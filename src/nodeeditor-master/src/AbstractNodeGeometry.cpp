@@ -41,6 +41,49 @@ QPointF AbstractNodeGeometry::portScenePosition(NodeId const nodeId,
     return t.map(result);
 }
 
+QRectF AbstractNodeGeometry::portControlRect(NodeId const nodeId,
+                                             PortType const portType,
+                                             PortIndex const portIndex,
+                                             PortControl const control) const
+{
+    Q_UNUSED(nodeId);
+    Q_UNUSED(portType);
+    Q_UNUSED(portIndex);
+    Q_UNUSED(control);
+
+    return QRectF();
+}
+
+bool AbstractNodeGeometry::checkPortControlHit(NodeId const nodeId,
+                                               QPointF const nodePoint,
+                                               PortType &portType,
+                                               PortIndex &portIndex,
+                                               PortControl &control) const
+{
+    if (!(_graphModel.nodeFlags(nodeId) & NodeFlag::PortControls))
+        return false;
+
+    for (PortType type : {PortType::In, PortType::Out}) {
+        PortCount const n = _graphModel.nodeData<PortCount>(nodeId,
+                                                            (type == PortType::Out)
+                                                                ? NodeRole::OutPortCount
+                                                                : NodeRole::InPortCount);
+
+        for (PortIndex index = 0; index < n; ++index) {
+            for (PortControl c : {PortControl::Add, PortControl::Remove}) {
+                if (portControlRect(nodeId, type, index, c).contains(nodePoint)) {
+                    portType = type;
+                    portIndex = index;
+                    control = c;
+                    return true;
+                }
+            }
+        }
+    }
+
+    return false;
+}
+
 PortIndex AbstractNodeGeometry::checkPortHit(NodeId const nodeId,
                                              PortType const portType,
                                              QPointF const nodePoint) const
@@ -9,11 +9,19 @@
 #include "DefaultVerticalNodeGeometry.hpp"
 #include "GraphicsView.hpp"
 #include "NodeGraphicsObject.hpp"
+#include "ScopeTraceHook.hpp"
+#include "StyleCollection.hpp"
+#include "UndoCommands.hpp"
 
 #include <QUndoStack>
 
+#include <QtGui/QPainter>
+#include <QtGui/QPixmapCache>
+
 #include <QtWidgets/QFileDialog>
+#include <QtWidgets/QGraphicsEffect>
 #include <QtWidgets/QGraphicsSceneMoveEvent>
+#include <QtWidgets/QWidget>
 
 #include <QtCore/QBuffer>
 #include <QtCore/QByteArray>
@@ -22,10 +30,15 @@
 #include <QtCore/QJsonArray>
 #include <QtCore/QJsonDocument>
 #include <QtCore/QJsonObject>
+#include <QtCore/QTimer>
+#include <QtCore/QVector>
 #include <QtCore/QtGlobal>
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <stdexcept>
+#include <type_traits>
 #include <unordered_set>
 #include <utility>
 #include <queue>
@@ -40,9 +53,24 @@ BasicGraphicsScene::BasicGraphicsScene(AbstractGraphModel &graphModel, QObject *
     , _connectionPainter(std::make_unique<DefaultConnectionPainter>())
     , _nodeDrag(false)
     , _undoStack(new QUndoStack(this))
+    , _undoMemoryBudget(64 * 1024 * 1024)
+    , _connectionMoveTimer(new QTimer(this))
     , _orientation(Qt::Horizontal)
+    , _levelOfDetail(LevelOfDetail::Full)
+    , _viewScale(1.0)
+    , _reducedDetailScale(0.5)
+    , _minimalDetailScale(0.35)
+    , _nextConnectionKey(0)
+    , _materializeTimer(new QTimer(this))
+    , _virtualizationThreshold(0)
+    , _virtualized(false)
+    , _viewMoving(false)
+    , _batchedConnections(false)
+    , _poolCapacity(kDefaultPoolCapacity)
 {
-    setItemIndexMethod(QGraphicsScene::NoIndex);
+    // rubber band selection and hover events look items up through the scene's own
+    // index, which NoIndex turns into a scan of every item
+    setItemIndexMethod(QGraphicsScene::BspTreeIndex);
 
     connect(&_graphModel,
             &AbstractGraphModel::connectionCreated,
@@ -54,6 +82,11 @@ BasicGraphicsScene::BasicGraphicsScene(AbstractGraphModel &graphModel, QObject *
             this,
             &BasicGraphicsScene::onConnectionDeleted);
 
+    connect(&_graphModel,
+            &AbstractGraphModel::connectionReindexed,
+            this,
+            &BasicGraphicsScene::onConnectionReindexed);
+
     connect(&_graphModel,
             &AbstractGraphModel::nodeCreated,
             this,
@@ -78,6 +111,20 @@ BasicGraphicsScene::BasicGraphicsScene(AbstractGraphModel &graphModel, QObject *
 
     connect(&_graphModel, &AbstractGraphModel::modelReset, this, &BasicGraphicsScene::onModelReset);
 
+    // roughly one repaint of the view
+    _connectionMoveTimer->setSingleShot(true);
+    _connectionMoveTimer->setInterval(16);
+    connect(_connectionMoveTimer, &QTimer::timeout, this, &BasicGraphicsScene::flushConnectionMoves);
+
+    // model changes of a virtualized scene are materialized together
+    _materializeTimer->setSingleShot(true);
+    _materializeTimer->setInterval(0);
+    connect(_materializeTimer, &QTimer::timeout, this, &BasicGraphicsScene::updateMaterializedItems);
+
+    connect(_undoStack, &QUndoStack::indexChanged, this, [this](int) {
+        enforceUndoMemoryBudget();
+    });
+
     traverseGraphAndPopulateGraphicsObjects();
 }
 
@@ -116,6 +163,12 @@ void BasicGraphicsScene::setNodePainter(std::unique_ptr<AbstractNodePainter> new
 void BasicGraphicsScene::setConnectionPainter(std::unique_ptr<AbstractConnectionPainter> newPainter)
 {
     _connectionPainter = std::move(newPainter);
+
+    // cached strokes were built by the previous painter
+    for (auto &it : _connectionGraphicsObjects) {
+        it.second->invalidateGeometry();
+        it.second->update();
+    }
 }
 
 QUndoStack &BasicGraphicsScene::undoStack()
@@ -123,9 +176,88 @@ QUndoStack &BasicGraphicsScene::undoStack()
     return *_undoStack;
 }
 
+void BasicGraphicsScene::setUndoMemoryBudget(std::size_t bytes)
+{
+    _undoMemoryBudget = bytes;
+
+    enforceUndoMemoryBudget();
+}
+
+std::size_t BasicGraphicsScene::undoMemoryUsage() const
+{
+    std::size_t usage = 0;
+
+    for (int i = 0; i < _undoStack->count(); ++i) {
+        if (auto c = dynamic_cast<UndoPayloadCommand const *>(_undoStack->command(i)))
+            usage += c->byteSize();
+    }
+
+    return usage;
+}
+
+BasicGraphicsScene::GraphicsMemoryUsage BasicGraphicsScene::graphicsMemoryUsage() const
+{
+    // QGraphicsItemPrivate and the QObject data of an item, roughly
+    constexpr std::size_t itemPrivateBytes = 512;
+    // a hash map node holds the value and two pointers, the buckets one pointer each
+    auto mapBytes = [](auto const &map) {
+        using Value = typename std::decay_t<decltype(map)>::value_type;
+        return map.bucket_count() * sizeof(void *) + map.size() * (sizeof(Value) + 2 * sizeof(void *));
+    };
+
+    GraphicsMemoryUsage usage;
+    usage.nodeObjects = _nodeGraphicsObjects.size();
+    usage.connectionObjects = _connectionGraphicsObjects.size();
+    usage.pooledObjects = _nodePool.size() + _connectionPool.size();
+    usage.objectBytes = (usage.nodeObjects + _nodePool.size()) * (sizeof(NodeGraphicsObject) + itemPrivateBytes)
+                        + (usage.connectionObjects + _connectionPool.size())
+                              * (sizeof(ConnectionGraphicsObject) + itemPrivateBytes)
+                        + mapBytes(_nodeGraphicsObjects) + mapBytes(_connectionGraphicsObjects)
+                        + mapBytes(_connectionKeys) + mapBytes(_connectionsByKey)
+                        + (_nodePool.capacity() + _connectionPool.capacity()) * sizeof(void *);
+
+    for (auto const &it : _nodeGraphicsObjects) {
+        NodeGraphicsObject const *ngo = it.second.get();
+        if (ngo->cacheMode() != QGraphicsItem::DeviceCoordinateCache || !ngo->isVisible())
+            continue;
+        QSizeF const size = ngo->boundingRect().size() * _viewScale;
+        usage.cacheBytes += static_cast<std::size_t>(std::ceil(size.width()))
+                            * static_cast<std::size_t>(std::ceil(size.height())) * 4;
+        ++usage.cachedNodes;
+    }
+    usage.cacheBytes = std::min(usage.cacheBytes, static_cast<std::size_t>(QPixmapCache::cacheLimit()) * 1024);
+
+    return usage;
+}
+
+void BasicGraphicsScene::enforceUndoMemoryBudget()
+{
+    if (_undoMemoryBudget == 0)
+        return;
+
+    std::size_t usage = undoMemoryUsage();
+
+    // QUndoStack cannot drop its oldest commands once it is not empty,
+    // so their payloads are moved out of memory instead
+    for (int i = 0; i < _undoStack->count() && usage > _undoMemoryBudget; ++i) {
+        // the stack owns non-const commands, command() just exposes them as const
+        auto c = const_cast<UndoPayloadCommand *>(
+            dynamic_cast<UndoPayloadCommand const *>(_undoStack->command(i)));
+
+        if (!c)
+            continue;
+
+        usage -= c->byteSize();
+        c->spill();
+        usage += c->byteSize();
+    }
+}
+
 std::unique_ptr<ConnectionGraphicsObject> const &BasicGraphicsScene::makeDraftConnection(
     ConnectionId const incompleteConnectionId)
 {
+    resetDraftReaction();
+
     _draftConnection = std::make_unique<ConnectionGraphicsObject>(*this, incompleteConnectionId);
 
     _draftConnection->grabMouse();
@@ -135,9 +267,91 @@ std::unique_ptr<ConnectionGraphicsObject> const &BasicGraphicsScene::makeDraftCo
 
 void BasicGraphicsScene::resetDraftConnection()
 {
+    resetDraftReaction();
+
     _draftConnection.reset();
 }
 
+void BasicGraphicsScene::updateDraftReaction(QPointF const sceneEndPoint)
+{
+    if (!_draftConnection)
+        return;
+
+    PortType const requiredPort = _draftConnection->connectionState().requiredPort();
+    if (requiredPort == PortType::None)
+        return;
+
+    ConnectionId const draftId = _draftConnection->connectionId();
+    NodeRole const countRole = (requiredPort == PortType::Out) ? NodeRole::OutPortCount
+                                                               : NodeRole::InPortCount;
+
+    QPointF const reach(kRejectRange, kRejectRange);
+    std::vector<NodeId> reacting;
+
+    for (NodeId const nodeId : _nodeIndex.nodesIn(QRectF(sceneEndPoint - reach, sceneEndPoint + reach))) {
+        auto *ngo = nodeGraphicsObject(nodeId);
+        if (!ngo)
+            continue;
+
+        // nodes are only translated, the port positions are relative to pos()
+        QPointF const endPoint = sceneEndPoint - ngo->pos();
+        unsigned const n = _graphModel.nodeData(nodeId, countRole).toUInt();
+
+        std::vector<double> scales(n, 1.0);
+        bool near = false;
+
+        for (PortIndex portIndex = 0; portIndex < n; ++portIndex) {
+            QPointF const diff = endPoint - _nodeGeometry->portPosition(nodeId, requiredPort, portIndex);
+            double const dist = std::sqrt(QPointF::dotProduct(diff, diff));
+            if (dist >= kRejectRange)
+                continue;
+
+            ConnectionId const possibleId = makeCompleteConnectionId(draftId, nodeId, portIndex);
+            auto it = _draftPossible.find(possibleId);
+            if (it == _draftPossible.end())
+                it = _draftPossible.emplace(possibleId, _graphModel.connectionPossible(possibleId)).first;
+
+            if (it->second)
+                scales[portIndex] = (dist < kSnapRange) ? (2.0 - dist / kSnapRange) : 1.0;
+            else
+                scales[portIndex] = dist / kRejectRange;
+            near = true;
+        }
+
+        if (!near)
+            continue;
+
+        if (ngo->nodeState().setReactingPorts(requiredPort, std::move(scales)))
+            ngo->update();
+        reacting.push_back(nodeId);
+    }
+
+    // the nodes left behind get their normal points back
+    for (NodeId const nodeId : _reactingNodes) {
+        if (std::find(reacting.begin(), reacting.end(), nodeId) != reacting.end())
+            continue;
+        if (auto *ngo = nodeGraphicsObject(nodeId)) {
+            ngo->nodeState().resetReactingPorts();
+            ngo->update();
+        }
+    }
+
+    _reactingNodes = std::move(reacting);
+}
+
+void BasicGraphicsScene::resetDraftReaction()
+{
+    for (NodeId const nodeId : _reactingNodes) {
+        if (auto *ngo = nodeGraphicsObject(nodeId)) {
+            ngo->nodeState().resetReactingPorts();
+            ngo->update();
+        }
+    }
+
+    _reactingNodes.clear();
+    _draftPossible.clear();
+}
+
 void BasicGraphicsScene::clearScene()
 {
     auto const &allNodeIds = graphModel().allNodeIds();
@@ -169,6 +383,388 @@ ConnectionGraphicsObject *BasicGraphicsScene::connectionGraphicsObject(Connectio
     return cgo;
 }
 
+NodeGraphicsObject *BasicGraphicsScene::nodeAt(QPointF const scenePos)
+{
+    NodeGraphicsObject *result = nullptr;
+
+    for (NodeId const nodeId : _nodeIndex.nodesAt(scenePos)) {
+        NodeGraphicsObject *ngo = nodeGraphicsObject(nodeId);
+
+        if (!ngo || !ngo->isVisible() || !ngo->contains(ngo->mapFromScene(scenePos)))
+            continue;
+
+        if (!result || ngo->zValue() > result->zValue())
+            result = ngo;
+    }
+
+    return result;
+}
+
+std::vector<NodeId> BasicGraphicsScene::nodesInRect(QRectF const &sceneRect) const
+{
+    return _nodeIndex.nodesIn(sceneRect);
+}
+
+void BasicGraphicsScene::updateNodeIndex(NodeGraphicsObject const &ngo)
+{
+    _nodeIndex.update(ngo.nodeId(), ngo.sceneBoundingRect());
+
+    if (_virtualized)
+        indexNodeConnections(ngo.nodeId());
+}
+
+void BasicGraphicsScene::moveConnectionsDeferred(NodeId const nodeId)
+{
+    for (auto const &cId : _graphModel.allConnectionIds(nodeId))
+        _dirtyConnections.insert(cId);
+
+    if (!_dirtyConnections.empty() && !_connectionMoveTimer->isActive())
+        _connectionMoveTimer->start();
+}
+
+void BasicGraphicsScene::flushConnectionMoves()
+{
+    _connectionMoveTimer->stop();
+
+    for (auto const &cId : _dirtyConnections) {
+        if (auto cgo = connectionGraphicsObject(cId))
+            cgo->move();
+    }
+
+    _dirtyConnections.clear();
+}
+
+void BasicGraphicsScene::setLevelOfDetailThresholds(double reducedScale, double minimalScale)
+{
+    _reducedDetailScale = reducedScale;
+    _minimalDetailScale = std::min(minimalScale, reducedScale);
+
+    setViewScale(_viewScale);
+}
+
+void BasicGraphicsScene::setViewScale(double scale)
+{
+    _viewScale = scale;
+
+    LevelOfDetail lod = LevelOfDetail::Full;
+    if (scale < _minimalDetailScale)
+        lod = LevelOfDetail::Minimal;
+    else if (scale < _reducedDetailScale)
+        lod = LevelOfDetail::Reduced;
+
+    if (lod == _levelOfDetail)
+        return;
+
+    _levelOfDetail = lod;
+
+    for (auto &it : _nodeGraphicsObjects)
+        it.second->updateLevelOfDetail();
+
+    for (auto &it : _connectionGraphicsObjects)
+        it.second->update();
+}
+
+void BasicGraphicsScene::setViewMoving(bool moving)
+{
+    if (moving == _viewMoving)
+        return;
+
+    _viewMoving = moving;
+
+    for (auto &it : _nodeGraphicsObjects) {
+        if (auto effect = it.second->graphicsEffect())
+            effect->setEnabled(!moving);
+
+        it.second->update();
+    }
+}
+
+void BasicGraphicsScene::setBatchedConnections(bool enabled)
+{
+    if (enabled == _batchedConnections)
+        return;
+
+    _batchedConnections = enabled;
+
+    for (auto &it : _connectionGraphicsObjects)
+        it.second->update();
+}
+
+bool BasicGraphicsScene::isBatchedConnection(ConnectionGraphicsObject const &cgo) const
+{
+    if (!_batchedConnections || _levelOfDetail != LevelOfDetail::Minimal)
+        return false;
+
+    ConnectionState const &state = cgo.connectionState();
+
+    return !cgo.isSelected() && !state.hovered() && !state.requiresPort()
+           && !_graphModel.connectionHighlighted(cgo.connectionId());
+}
+
+void BasicGraphicsScene::drawBatchedConnections(QPainter *painter, QRectF const &sceneRect) const
+{
+    QTNODES_TRACE_SCOPE("BasicGraphicsScene::drawBatchedConnections");
+
+    if (!_batchedConnections || _levelOfDetail != LevelOfDetail::Minimal)
+        return;
+
+    QVector<QLineF> lines;
+
+    for (auto const &it : _connectionGraphicsObjects) {
+        ConnectionGraphicsObject const &cgo = *it.second;
+
+        if (!cgo.isVisible() || !isBatchedConnection(cgo)
+            || !cgo.sceneBoundingRect().intersects(sceneRect))
+            continue;
+
+        lines.push_back(QLineF(cgo.mapToScene(cgo.out()), cgo.mapToScene(cgo.in())));
+    }
+
+    if (lines.isEmpty())
+        return;
+
+    // the same hairline DefaultConnectionPainter draws at minimal detail
+    QPen pen(StyleCollection::connectionStyle().normalColor());
+    pen.setWidth(0);
+
+    painter->save();
+    painter->setRenderHint(QPainter::Antialiasing, false);
+    painter->setPen(pen);
+    painter->setBrush(Qt::NoBrush);
+    painter->drawLines(lines);
+    painter->restore();
+}
+
+void BasicGraphicsScene::setVirtualizationThreshold(std::size_t nodeCount)
+{
+    _virtualizationThreshold = nodeCount;
+
+    bool const virtualized = nodeCount > 0 && _graphModel.allNodeIds().size() >= nodeCount;
+
+    if (virtualized != _virtualized)
+        onModelReset();
+}
+
+void BasicGraphicsScene::setVisibleSceneRect(QRectF const &sceneRect)
+{
+    if (sceneRect == _visibleSceneRect)
+        return;
+
+    _visibleSceneRect = sceneRect;
+
+    // right away, a deferred update would show the newly uncovered area empty for a frame
+    if (_virtualized)
+        updateMaterializedItems();
+}
+
+QRectF BasicGraphicsScene::nodesBoundingRect() const
+{
+    return _nodeIndex.boundingRect();
+}
+
+void BasicGraphicsScene::indexNode(NodeId const nodeId)
+{
+    QPointF const pos = _graphModel.nodeData<QPointF>(nodeId, NodeRole::Position);
+
+    _nodeIndex.update(nodeId, _nodeGeometry->boundingRect(nodeId).translated(pos));
+}
+
+void BasicGraphicsScene::indexConnection(ConnectionId const connectionId)
+{
+    auto it = _connectionKeys.find(connectionId);
+    if (it == _connectionKeys.end()) {
+        it = _connectionKeys.emplace(connectionId, _nextConnectionKey++).first;
+        _connectionsByKey.emplace(it->second, connectionId);
+    }
+
+    // the curve bulges out of this rectangle a little, the margin covers it
+    QRectF const rect = _nodeIndex.rect(connectionId.outNodeId)
+                            .united(_nodeIndex.rect(connectionId.inNodeId));
+
+    _connectionIndex.update(it->second, rect);
+}
+
+void BasicGraphicsScene::indexNodeConnections(NodeId const nodeId)
+{
+    for (auto const &cId : _graphModel.allConnectionIds(nodeId))
+        indexConnection(cId);
+}
+
+void BasicGraphicsScene::unindexConnection(ConnectionId const connectionId)
+{
+    auto it = _connectionKeys.find(connectionId);
+    if (it == _connectionKeys.end())
+        return;
+
+    _connectionIndex.remove(it->second);
+    _connectionsByKey.erase(it->second);
+    _connectionKeys.erase(it);
+}
+
+QRectF BasicGraphicsScene::materializedArea() const
+{
+    return _visibleSceneRect.adjusted(-kMaterializedMargin,
+                                      -kMaterializedMargin,
+                                      kMaterializedMargin,
+                                      kMaterializedMargin);
+}
+
+void BasicGraphicsScene::scheduleMaterialization()
+{
+    if (_virtualized && !_materializeTimer->isActive())
+        _materializeTimer->start();
+}
+
+void BasicGraphicsScene::updateMaterializedItems()
+{
+    QTNODES_TRACE_SCOPE("BasicGraphicsScene::updateMaterializedItems");
+
+    _materializeTimer->stop();
+
+    if (!_virtualized)
+        return;
+
+    QRectF const area = materializedArea();
+
+    std::unordered_set<NodeId> nodes;
+    if (!_visibleSceneRect.isEmpty()) {
+        for (NodeId const nodeId : _nodeIndex.nodesIn(area))
+            nodes.insert(nodeId);
+    }
+
+    std::unordered_set<ConnectionId> connections;
+    if (!_visibleSceneRect.isEmpty()) {
+        for (NodeId const key : _connectionIndex.nodesIn(area))
+            connections.insert(_connectionsByKey.at(key));
+    }
+
+    QGraphicsItem const *grabber = mouseGrabberItem();
+
+    // released first, so that the pools supply the items entering the area
+    std::vector<ConnectionId> releasedConnections;
+    for (auto const &it : _connectionGraphicsObjects) {
+        ConnectionGraphicsObject const *cgo = it.second.get();
+
+        if (!connections.count(it.first) && !cgo->isSelected() && cgo != grabber)
+            releasedConnections.push_back(it.first);
+    }
+
+    for (auto const &cId : releasedConnections)
+        dematerializeConnection(cId);
+
+    std::vector<NodeId> releasedNodes;
+    for (auto const &it : _nodeGraphicsObjects) {
+        NodeGraphicsObject const *ngo = it.second.get();
+
+        // an embedded widget would be deleted with the object, the node keeps it
+        bool const keep = ngo->isSelected() || ngo == grabber
+                          || _graphModel.nodeData(it.first, NodeRole::Widget).value<QWidget *>();
+
+        if (!nodes.count(it.first) && !keep)
+            releasedNodes.push_back(it.first);
+    }
+
+    for (NodeId const nodeId : releasedNodes)
+        dematerializeNode(nodeId);
+
+    // nodes before connections, the connection ends are read from the node objects
+    for (NodeId const nodeId : nodes) {
+        if (!_nodeGraphicsObjects.count(nodeId))
+            materializeNode(nodeId);
+    }
+
+    for (auto const &cId : connections) {
+        if (!_connectionGraphicsObjects.count(cId))
+            materializeConnection(cId);
+    }
+}
+
+void BasicGraphicsScene::materializeNode(NodeId const nodeId)
+{
+    if (_nodePool.empty()) {
+        _nodeGraphicsObjects[nodeId] = std::make_unique<NodeGraphicsObject>(*this, nodeId);
+        return;
+    }
+
+    UniqueNodeGraphicsObject ngo = std::move(_nodePool.back());
+    _nodePool.pop_back();
+
+    ngo->rebind(*this, nodeId);
+
+    _nodeGraphicsObjects[nodeId] = std::move(ngo);
+}
+
+void BasicGraphicsScene::materializeConnection(ConnectionId const connectionId)
+{
+    if (_connectionPool.empty()) {
+        _connectionGraphicsObjects[connectionId]
+            = std::make_unique<ConnectionGraphicsObject>(*this, connectionId);
+        return;
+    }
+
+    UniqueConnectionGraphicsObject cgo = std::move(_connectionPool.back());
+    _connectionPool.pop_back();
+
+    cgo->rebind(*this, connectionId);
+
+    _connectionGraphicsObjects[connectionId] = std::move(cgo);
+}
+
+void BasicGraphicsScene::dematerializeNode(NodeId const nodeId)
+{
+    auto it = _nodeGraphicsObjects.find(nodeId);
+    if (it == _nodeGraphicsObjects.end())
+        return;
+
+    UniqueNodeGraphicsObject ngo = std::move(it->second);
+    _nodeGraphicsObjects.erase(it);
+
+    recycleNode(std::move(ngo));
+}
+
+void BasicGraphicsScene::dematerializeConnection(ConnectionId const connectionId)
+{
+    auto it = _connectionGraphicsObjects.find(connectionId);
+    if (it == _connectionGraphicsObjects.end())
+        return;
+
+    UniqueConnectionGraphicsObject cgo = std::move(it->second);
+    _connectionGraphicsObjects.erase(it);
+
+    _dirtyConnections.erase(connectionId);
+
+    recycleConnection(std::move(cgo));
+}
+
+void BasicGraphicsScene::recycleNode(UniqueNodeGraphicsObject ngo)
+{
+    if (_nodePool.size() >= _poolCapacity)
+        return;
+
+    removeItem(ngo.get());
+    _nodePool.push_back(std::move(ngo));
+}
+
+void BasicGraphicsScene::recycleConnection(UniqueConnectionGraphicsObject cgo)
+{
+    if (_connectionPool.size() >= _poolCapacity)
+        return;
+
+    removeItem(cgo.get());
+    _connectionPool.push_back(std::move(cgo));
+}
+
+void BasicGraphicsScene::setGraphicsObjectPoolCapacity(std::size_t capacity)
+{
+    _poolCapacity = capacity;
+
+    if (_nodePool.size() > capacity)
+        _nodePool.resize(capacity);
+
+    if (_connectionPool.size() > capacity)
+        _connectionPool.resize(capacity);
+}
+
 void BasicGraphicsScene::setOrientation(Qt::Orientation const orientation)
 {
     if (_orientation != orientation) {
@@ -196,11 +792,35 @@ QMenu *BasicGraphicsScene::createSceneMenu(QPointF const scenePos)
 
 void BasicGraphicsScene::traverseGraphAndPopulateGraphicsObjects()
 {
+    QTNODES_TRACE_SCOPE("BasicGraphicsScene::traverseGraphAndPopulateGraphicsObjects");
+
     auto allNodeIds = _graphModel.allNodeIds();
 
+    _virtualized = _virtualizationThreshold > 0 && allNodeIds.size() >= _virtualizationThreshold;
+
+    if (_virtualized) {
+        // only the indexes are filled, the objects follow the visible area
+        for (NodeId const nodeId : allNodeIds) {
+            _nodeGeometry->recomputeSize(nodeId);
+            indexNode(nodeId);
+        }
+
+        for (NodeId const nodeId : allNodeIds) {
+            auto nOutPorts = _graphModel.nodeData<PortCount>(nodeId, NodeRole::OutPortCount);
+
+            for (PortIndex index = 0; index < nOutPorts; ++index) {
+                for (auto cid : _graphModel.connections(nodeId, PortType::Out, index))
+                    indexConnection(cid);
+            }
+        }
+
+        updateMaterializedItems();
+        return;
+    }
+
     // First create all the nodes.
     for (NodeId const nodeId : allNodeIds) {
-        _nodeGraphicsObjects[nodeId] = std::make_unique<NodeGraphicsObject>(*this, nodeId);
+        materializeNode(nodeId);
     }
 
     // Then for each node check output connections and insert them.
@@ -211,8 +831,7 @@ void BasicGraphicsScene::traverseGraphAndPopulateGraphicsObjects()
             auto const &outConnectionIds = _graphModel.connections(nodeId, PortType::Out, index);
 
             for (auto cid : outConnectionIds) {
-                _connectionGraphicsObjects[cid] = std::make_unique<ConnectionGraphicsObject>(*this,
-                                                                                             cid);
+                materializeConnection(cid);
             }
         }
     }
@@ -230,14 +849,13 @@ void BasicGraphicsScene::updateAttachedNodes(ConnectionId const connectionId,
 
 void BasicGraphicsScene::onConnectionDeleted(ConnectionId const connectionId)
 {
-    auto it = _connectionGraphicsObjects.find(connectionId);
-    if (it != _connectionGraphicsObjects.end()) {
-        _connectionGraphicsObjects.erase(it);
-    }
+    dematerializeConnection(connectionId);
+
+    unindexConnection(connectionId);
 
     // TODO: do we need it?
     if (_draftConnection && _draftConnection->connectionId() == connectionId) {
-        _draftConnection.reset();
+        resetDraftConnection();
     }
 
     updateAttachedNodes(connectionId, PortType::Out);
@@ -248,8 +866,14 @@ void BasicGraphicsScene::onConnectionDeleted(ConnectionId const connectionId)
 
 void BasicGraphicsScene::onConnectionCreated(ConnectionId const connectionId)
 {
-    _connectionGraphicsObjects[connectionId]
-        = std::make_unique<ConnectionGraphicsObject>(*this, connectionId);
+    if (!_virtualized) {
+        materializeConnection(connectionId);
+    } else {
+        indexConnection(connectionId);
+
+        if (_connectionIndex.rect(_connectionKeys.at(connectionId)).intersects(materializedArea()))
+            materializeConnection(connectionId);
+    }
 
     updateAttachedNodes(connectionId, PortType::Out);
     updateAttachedNodes(connectionId, PortType::In);
@@ -257,11 +881,48 @@ void BasicGraphicsScene::onConnectionCreated(ConnectionId const connectionId)
     Q_EMIT modified(this);
 }
 
+void BasicGraphicsScene::onConnectionReindexed(ConnectionId const oldConnectionId,
+                                               ConnectionId const newConnectionId)
+{
+    auto object = _connectionGraphicsObjects.extract(oldConnectionId);
+    if (object) {
+        object.key() = newConnectionId;
+        auto inserted = _connectionGraphicsObjects.insert(std::move(object));
+        inserted.position->second->reindex(newConnectionId);
+    }
+
+    // the end nodes are the same, the connection keeps its key and rectangle
+    auto key = _connectionKeys.extract(oldConnectionId);
+    if (key) {
+        _connectionsByKey[key.mapped()] = newConnectionId;
+        key.key() = newConnectionId;
+        _connectionKeys.insert(std::move(key));
+    }
+
+    if (_dirtyConnections.erase(oldConnectionId))
+        _dirtyConnections.insert(newConnectionId);
+
+    updateAttachedNodes(newConnectionId, PortType::Out);
+    updateAttachedNodes(newConnectionId, PortType::In);
+
+    Q_EMIT modified(this);
+}
+
 void BasicGraphicsScene::onNodeDeleted(NodeId const nodeId)
 {
     auto it = _nodeGraphicsObjects.find(nodeId);
-    if (it != _nodeGraphicsObjects.end()) {
-        _nodeGraphicsObjects.erase(it);
+    if (it != _nodeGraphicsObjects.end() || _nodeIndex.contains(nodeId)) {
+        if (it != _nodeGraphicsObjects.end()) {
+            UniqueNodeGraphicsObject ngo = std::move(it->second);
+            _nodeGraphicsObjects.erase(it);
+
+            ngo->removeEmbeddedWidget();
+            recycleNode(std::move(ngo));
+        }
+
+        _nodeIndex.remove(nodeId);
+
+        _nodeGeometry->invalidateNode(nodeId);
 
         Q_EMIT modified(this);
     }
@@ -269,7 +930,15 @@ void BasicGraphicsScene::onNodeDeleted(NodeId const nodeId)
 
 void BasicGraphicsScene::onNodeCreated(NodeId const nodeId)
 {
-    _nodeGraphicsObjects[nodeId] = std::make_unique<NodeGraphicsObject>(*this, nodeId);
+    if (!_virtualized) {
+        materializeNode(nodeId);
+    } else {
+        _nodeGeometry->recomputeSize(nodeId);
+        indexNode(nodeId);
+
+        if (_nodeIndex.rect(nodeId).intersects(materializedArea()))
+            materializeNode(nodeId);
+    }
 
     Q_EMIT modified(this);
 }
@@ -281,7 +950,12 @@ void BasicGraphicsScene::onNodePositionUpdated(NodeId const nodeId)
         node->setPos(_graphModel.nodeData(nodeId, NodeRole::Position).value<QPointF>());
         node->update();
         _nodeDrag = true;
+    } else if (_virtualized) {
+        indexNode(nodeId);
+        indexNodeConnections(nodeId);
     }
+
+    scheduleMaterialization();
 }
 
 void BasicGraphicsScene::onNodeUpdated(NodeId const nodeId)
@@ -289,13 +963,28 @@ void BasicGraphicsScene::onNodeUpdated(NodeId const nodeId)
     auto node = nodeGraphicsObject(nodeId);
 
     if (node) {
+        node->invalidateNodeStyle();
+
+        _nodeGeometry->invalidateNode(nodeId);
+
         node->setGeometryChanged();
 
         _nodeGeometry->recomputeSize(nodeId);
 
+        updateNodeIndex(*node);
+
         node->updateQWidgetEmbedPos();
         node->update();
         node->moveConnections();
+    } else if (_virtualized) {
+        _nodeGeometry->invalidateNode(nodeId);
+
+        _nodeGeometry->recomputeSize(nodeId);
+
+        indexNode(nodeId);
+        indexNodeConnections(nodeId);
+
+        scheduleMaterialization();
     }
 }
 
@@ -310,8 +999,28 @@ void BasicGraphicsScene::onNodeClicked(NodeId const nodeId)
 
 void BasicGraphicsScene::onModelReset()
 {
+    // the index also holds the nodes without objects of a virtualized scene
+    for (NodeId const nodeId : _nodeIndex.nodes())
+        _nodeGeometry->invalidateNode(nodeId);
+
+    // the objects are reused for the graph after the reset, the embedded
+    // widgets go with the proxies as when the objects were deleted
+    for (auto &it : _connectionGraphicsObjects)
+        recycleConnection(std::move(it.second));
+
+    for (auto &it : _nodeGraphicsObjects) {
+        it.second->removeEmbeddedWidget();
+        recycleNode(std::move(it.second));
+    }
+
     _connectionGraphicsObjects.clear();
     _nodeGraphicsObjects.clear();
+    _nodeIndex.clear();
+    _dirtyConnections.clear();
+
+    _connectionIndex.clear();
+    _connectionKeys.clear();
+    _connectionsByKey.clear();
 
     clear();
 
@@ -0,0 +1,83 @@
+#include "CachedFontMetrics.hpp"
+
+#include <QtCore/QHash>
+#include <QtGui/QFontMetrics>
+
+#include <unordered_map>
+
+#include "QStringStdHash.hpp"
+
+namespace QtNodes {
+
+struct CachedFontMetrics::FontCache
+{
+    explicit FontCache(QFont const &font)
+        : metrics(font)
+    {}
+
+    QFontMetrics metrics;
+
+    QHash<QString, QRect> rects;
+
+    QHash<QString, int> advances;
+};
+
+/// Guards against unbounded growth, e.g. captions typed character by character.
+static constexpr int MaxCachedTexts = 16384;
+
+CachedFontMetrics::CachedFontMetrics(QFont const &font)
+{
+    // one cache per distinct font, alive while some metrics object uses it
+    static std::unordered_map<QString, std::weak_ptr<FontCache>> caches;
+
+    QString const key = font.key();
+
+    auto &entry = caches[key];
+
+    _cache = entry.lock();
+    if (!_cache) {
+        _cache = std::make_shared<FontCache>(font);
+        entry = _cache;
+    }
+}
+
+int CachedFontMetrics::height() const
+{
+    return _cache->metrics.height();
+}
+
+QRect CachedFontMetrics::boundingRect(QString const &text) const
+{
+    auto it = _cache->rects.constFind(text);
+    if (it != _cache->rects.constEnd())
+        return it.value();
+
+    if (_cache->rects.size() >= MaxCachedTexts)
+        _cache->rects.clear();
+
+    QRect const rect = _cache->metrics.boundingRect(text);
+    _cache->rects.insert(text, rect);
+
+    return rect;
+}
+
+int CachedFontMetrics::horizontalAdvance(QString const &text) const
+{
+    auto it = _cache->advances.constFind(text);
+    if (it != _cache->advances.constEnd())
+        return it.value();
+
+    if (_cache->advances.size() >= MaxCachedTexts)
+        _cache->advances.clear();
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+    int const advance = _cache->metrics.horizontalAdvance(text);
+#else
+    int const advance = _cache->metrics.width(text);
+#endif
+    _cache->advances.insert(text, advance);
+
+    return advance;
+}
+
+} // namespace QtNodes
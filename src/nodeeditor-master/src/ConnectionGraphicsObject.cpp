@@ -9,6 +9,7 @@
 #include "ConnectionStyle.hpp"
 #include "NodeConnectionInteraction.hpp"
 #include "NodeGraphicsObject.hpp"
+#include "ScopeTraceHook.hpp"
 #include "StyleCollection.hpp"
 #include "locateNode.hpp"
 
@@ -81,6 +82,34 @@ void ConnectionGraphicsObject::initializePosition()
     move();
 }
 
+void ConnectionGraphicsObject::rebind(BasicGraphicsScene &scene, ConnectionId const connectionId)
+{
+    Q_ASSERT(!this->scene());
+
+    _connectionId = connectionId;
+
+    _connectionState.setHovered(false);
+    _connectionState.setLastHoveredNode(InvalidNodeId);
+
+    _out = QPointF(0, 0);
+    _in = QPointF(0, 0);
+    invalidateGeometry();
+
+    scene.addItem(this);
+
+    setSelected(false);
+    setPos(0, 0);
+
+    initializePosition();
+}
+
+void ConnectionGraphicsObject::reindex(ConnectionId const connectionId)
+{
+    _connectionId = connectionId;
+
+    move();
+}
+
 AbstractGraphModel &ConnectionGraphicsObject::graphModel() const
 {
     return _graphModel;
@@ -98,6 +127,9 @@ ConnectionId const &ConnectionGraphicsObject::connectionId() const
 
 QRectF ConnectionGraphicsObject::boundingRect() const
 {
+    if (_boundingRectValid)
+        return _boundingRect;
+
     auto points = pointsC1C2();
 
     // `normalized()` fixes inverted rects.
@@ -115,7 +147,10 @@ QRectF ConnectionGraphicsObject::boundingRect() const
     commonRect.setTopLeft(commonRect.topLeft() - cornerOffset);
     commonRect.setBottomRight(commonRect.bottomRight() + 2 * cornerOffset);
 
-    return commonRect;
+    _boundingRect = commonRect;
+    _boundingRectValid = true;
+
+    return _boundingRect;
 }
 
 QPainterPath ConnectionGraphicsObject::shape() const
@@ -128,10 +163,37 @@ QPainterPath ConnectionGraphicsObject::shape() const
     //return path;
 
 #else
-    return nodeScene()->connectionPainter().getPainterStroke(*this);
+    if (!_strokeValid) {
+        _stroke = nodeScene()->connectionPainter().getPainterStroke(*this);
+        _strokeValid = true;
+    }
+
+    return _stroke;
 #endif
 }
 
+QPainterPath const &ConnectionGraphicsObject::cubicPath() const
+{
+    if (!_cubicPathValid) {
+        auto const c1c2 = pointsC1C2();
+
+        QPainterPath cubic(_out);
+        cubic.cubicTo(c1c2.first, c1c2.second, _in);
+
+        _cubicPath = cubic;
+        _cubicPathValid = true;
+    }
+
+    return _cubicPath;
+}
+
+void ConnectionGraphicsObject::invalidateGeometry()
+{
+    _cubicPathValid = false;
+    _strokeValid = false;
+    _boundingRectValid = false;
+}
+
 QPointF const &ConnectionGraphicsObject::endPoint(PortType portType) const
 {
     Q_ASSERT(portType != PortType::None);
@@ -145,6 +207,8 @@ void ConnectionGraphicsObject::setEndPoint(PortType portType, QPointF const &poi
         _in = point;
     else
         _out = point;
+
+    invalidateGeometry();
 }
 
 void ConnectionGraphicsObject::move()
@@ -157,13 +221,22 @@ void ConnectionGraphicsObject::move()
 
         NodeGraphicsObject *ngo = nodeScene()->nodeGraphicsObject(nodeId);
 
-        if (ngo) {
+        // the far end of a virtualized scene may have no object, its model position is used
+        if (ngo || nodeScene()->isVirtualized()) {
             AbstractNodeGeometry &geometry = nodeScene()->nodeGeometry();
 
+            QTransform nodeSceneTransform;
+            if (ngo) {
+                nodeSceneTransform = ngo->sceneTransform();
+            } else {
+                QPointF const pos = _graphModel.nodeData<QPointF>(nodeId, NodeRole::Position);
+                nodeSceneTransform = QTransform::fromTranslate(pos.x(), pos.y());
+            }
+
             QPointF scenePos = geometry.portScenePosition(nodeId,
                                                           portType,
                                                           getPortIndex(portType, cId),
-                                                          ngo->sceneTransform());
+                                                          nodeSceneTransform);
 
             QPointF connectionPos = sceneTransform().inverted().map(scenePos);
 
@@ -196,6 +269,8 @@ void ConnectionGraphicsObject::paint(QPainter *painter,
     if (!scene())
         return;
 
+    QTNODES_TRACE_SCOPE("ConnectionGraphicsObject::paint");
+
     painter->setClipRect(option->exposedRect);
 
     nodeScene()->connectionPainter().paint(painter, *this);
@@ -215,8 +290,6 @@ void ConnectionGraphicsObject::mouseMoveEvent(QGraphicsSceneMouseEvent *event)
     auto view = static_cast<QGraphicsView *>(event->widget());
     auto ngo = locateNodeAt(event->scenePos(), *nodeScene(), view->transform());
     if (ngo) {
-        ngo->reactToConnection(this);
-
         _connectionState.setLastHoveredNode(ngo->nodeId());
     } else {
         _connectionState.resetLastHoveredNode();
@@ -228,6 +301,8 @@ void ConnectionGraphicsObject::mouseMoveEvent(QGraphicsSceneMouseEvent *event)
 
     if (requiredPort != PortType::None) {
         setEndPoint(requiredPort, event->pos());
+
+        nodeScene()->updateDraftReaction(event->scenePos());
     }
 
     //-------------------
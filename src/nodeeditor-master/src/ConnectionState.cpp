@@ -56,8 +56,8 @@ NodeId ConnectionState::lastHoveredNode() const
 void ConnectionState::resetLastHoveredNode()
 {
     if (_lastHoveredNode != InvalidNodeId) {
-        auto ngo = _cgo.nodeScene()->nodeGraphicsObject(_lastHoveredNode);
-        ngo->update();
+        if (auto ngo = _cgo.nodeScene()->nodeGraphicsObject(_lastHoveredNode))
+            ngo->update();
     }
 
     _lastHoveredNode = InvalidNodeId;
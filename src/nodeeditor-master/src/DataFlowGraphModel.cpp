@@ -3,6 +3,7 @@
 
 #include <QJsonArray>
 
+#include <algorithm>
 #include <stdexcept>
 
 namespace QtNodes {
@@ -22,16 +23,11 @@ std::unordered_set<NodeId> DataFlowGraphModel::allNodeIds() const
 
 std::unordered_set<ConnectionId> DataFlowGraphModel::allConnectionIds(NodeId const nodeId) const
 {
-    std::unordered_set<ConnectionId> result;
-
-    std::copy_if(_connectivity.begin(),
-                 _connectivity.end(),
-                 std::inserter(result, std::end(result)),
-                 [&nodeId](ConnectionId const &cid) {
-                     return cid.inNodeId == nodeId || cid.outNodeId == nodeId;
-                 });
+    auto it = _nodeConnections.find(nodeId);
+    if (it == _nodeConnections.end())
+        return std::unordered_set<ConnectionId>();
 
-    return result;
+    return it->second;
 }
 
 std::unordered_set<ConnectionId> DataFlowGraphModel::connections(NodeId nodeId,
@@ -40,8 +36,12 @@ std::unordered_set<ConnectionId> DataFlowGraphModel::connections(NodeId nodeId,
 {
     std::unordered_set<ConnectionId> result;
 
-    std::copy_if(_connectivity.begin(),
-                 _connectivity.end(),
+    auto it = _nodeConnections.find(nodeId);
+    if (it == _nodeConnections.end())
+        return result;
+
+    std::copy_if(it->second.begin(),
+                 it->second.end(),
                  std::inserter(result, std::end(result)),
                  [&portType, &portIndex, &nodeId](ConnectionId const &cid) {
                      return (getNodeId(portType, cid) == nodeId
@@ -51,6 +51,20 @@ std::unordered_set<ConnectionId> DataFlowGraphModel::connections(NodeId nodeId,
     return result;
 }
 
+void DataFlowGraphModel::indexConnection(ConnectionId const connectionId, bool add)
+{
+    for (NodeId const nodeId : {connectionId.outNodeId, connectionId.inNodeId}) {
+        if (add) {
+            _nodeConnections[nodeId].insert(connectionId);
+            continue;
+        }
+
+        auto it = _nodeConnections.find(nodeId);
+        if (it != _nodeConnections.end() && it->second.erase(connectionId) && it->second.empty())
+            _nodeConnections.erase(it);
+    }
+}
+
 bool DataFlowGraphModel::connectionExists(ConnectionId const connectionId) const
 {
     return (_connectivity.find(connectionId) != _connectivity.end());
@@ -131,6 +145,7 @@ bool DataFlowGraphModel::connectionPossible(ConnectionId const connectionId) con
 void DataFlowGraphModel::addConnection(ConnectionId const connectionId)
 {
     _connectivity.insert(connectionId);
+    indexConnection(connectionId, true);
 
     sendConnectionCreation(connectionId);
 
@@ -211,8 +226,7 @@ QVariant DataFlowGraphModel::nodeData(NodeId nodeId, NodeRole role) const
         break;
 
     case NodeRole::Style: {
-        auto style = StyleCollection::nodeStyle();
-        result = style.toJson().toVariantMap();
+        result = StyleCollection::nodeStyleJson().toVariantMap();
     } break;
 
     case NodeRole::InternalData: {
@@ -380,6 +394,7 @@ bool DataFlowGraphModel::deleteConnection(ConnectionId const connectionId)
         disconnected = true;
 
         _connectivity.erase(it);
+        indexConnection(connectionId, false);
     }
 
     if (disconnected) {
@@ -402,6 +417,7 @@ bool DataFlowGraphModel::deleteNode(NodeId const nodeId)
 
     _nodeGeometryData.erase(nodeId);
     _models.erase(nodeId);
+    _dirtyPorts.erase(nodeId);
 
     Q_EMIT nodeDeleted(nodeId);
 
@@ -511,15 +527,98 @@ void DataFlowGraphModel::load(QJsonObject const &jsonDocument)
 
 void DataFlowGraphModel::onOutPortDataUpdated(NodeId const nodeId, PortIndex const portIndex)
 {
-    std::unordered_set<ConnectionId> const &connected = connections(nodeId,
-                                                                    PortType::Out,
-                                                                    portIndex);
+    std::vector<PortIndex> &ports = _dirtyPorts[nodeId];
+    if (std::find(ports.begin(), ports.end(), portIndex) == ports.end())
+        ports.push_back(portIndex);
+
+    if (!_propagating)
+        propagate();
+}
+
+void DataFlowGraphModel::propagate()
+{
+    _propagating = true;
+
+    while (!_dirtyPorts.empty()) {
+        auto forEachOutgoing = [this](NodeId const nodeId, auto const &visit) {
+            auto it = _nodeConnections.find(nodeId);
+            if (it == _nodeConnections.end())
+                return;
+            for (ConnectionId const &cid : it->second) {
+                if (cid.outNodeId == nodeId)
+                    visit(cid);
+            }
+        };
+
+        // the nodes downstream of the dirty ports, with their inputs from each other
+        std::unordered_map<NodeId, std::size_t> inDegree;
+        std::vector<NodeId> stack;
+        for (auto const &dirty : _dirtyPorts) {
+            if (inDegree.emplace(dirty.first, 0).second)
+                stack.push_back(dirty.first);
+        }
+
+        while (!stack.empty()) {
+            NodeId const nodeId = stack.back();
+            stack.pop_back();
+
+            forEachOutgoing(nodeId, [&](ConnectionId const &cid) {
+                auto inserted = inDegree.emplace(cid.inNodeId, 0);
+                ++inserted.first->second;
+                if (inserted.second)
+                    stack.push_back(cid.inNodeId);
+            });
+        }
 
-    QVariant const portDataToPropagate = portData(nodeId, PortType::Out, portIndex, PortRole::Data);
+        std::vector<NodeId> order;
+        order.reserve(inDegree.size());
+        for (auto const &node : inDegree) {
+            if (node.second == 0)
+                order.push_back(node.first);
+        }
+
+        for (std::size_t i = 0; i < order.size(); ++i) {
+            forEachOutgoing(order[i], [&](ConnectionId const &cid) {
+                if (--inDegree[cid.inNodeId] == 0)
+                    order.push_back(cid.inNodeId);
+            });
+        }
 
-    for (auto const &cn : connected) {
-        setPortData(cn.inNodeId, PortType::In, cn.inPortIndex, portDataToPropagate, PortRole::Data);
+        // the nodes of a cycle never get to zero inputs
+        if (order.size() < inDegree.size()) {
+            for (auto const &node : inDegree) {
+                if (node.second > 0)
+                    order.push_back(node.first);
+            }
+        }
+
+        // computing a node marks its ports dirty, they are delivered when it is visited
+        for (NodeId const nodeId : order) {
+            auto dirty = _dirtyPorts.find(nodeId);
+            if (dirty == _dirtyPorts.end())
+                continue;
+
+            std::vector<PortIndex> const ports = std::move(dirty->second);
+            _dirtyPorts.erase(dirty);
+
+            for (PortIndex const portIndex : ports) {
+                QVariant const portDataToPropagate = portData(nodeId,
+                                                              PortType::Out,
+                                                              portIndex,
+                                                              PortRole::Data);
+
+                for (auto const &cn : connections(nodeId, PortType::Out, portIndex)) {
+                    setPortData(cn.inNodeId,
+                                PortType::In,
+                                cn.inPortIndex,
+                                portDataToPropagate,
+                                PortRole::Data);
+                }
+            }
+        }
     }
+
+    _propagating = false;
 }
 
 void DataFlowGraphModel::propagateEmptyDataTo(NodeId const nodeId, PortIndex const portIndex)
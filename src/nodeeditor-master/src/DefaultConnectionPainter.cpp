@@ -3,6 +3,7 @@
 #include <QtGui/QIcon>
 
 #include "AbstractGraphModel.hpp"
+#include "BasicGraphicsScene.hpp"
 #include "ConnectionGraphicsObject.hpp"
 #include "ConnectionState.hpp"
 #include "Definitions.hpp"
@@ -11,19 +12,28 @@
 
 namespace QtNodes {
 
-QPainterPath DefaultConnectionPainter::cubicPath(ConnectionGraphicsObject const &connection) const
-{
-    QPointF const &in = connection.endPoint(PortType::In);
-    QPointF const &out = connection.endPoint(PortType::Out);
-
-    auto const c1c2 = connection.pointsC1C2();
+/// Halo of a connection the model reports as highlighted.
+static QColor const highlightColor(255, 165, 0);
 
-    // cubic spline
-    QPainterPath cubic(out);
+/// Halo of a connection with a heat in (0, 1], from translucent yellow to opaque red.
+static QColor heatColor(float heat)
+{
+    return QColor::fromHsvF((1.0f - heat) / 6.0f, 1.0f, 1.0f, 0.25f + 0.5f * heat);
+}
 
-    cubic.cubicTo(c1c2.first, c1c2.second, in);
+/// Pen of the heat halo, as wide as the hover halo so it stays in the bounding rect.
+static QPen heatPen(float heat, double lineWidth)
+{
+    QPen pen(heatColor(heat));
+    pen.setWidthF(2 * lineWidth);
+    pen.setCapStyle(Qt::RoundCap);
+    return pen;
+}
 
-    return cubic;
+QPainterPath const &DefaultConnectionPainter::cubicPath(ConnectionGraphicsObject const &connection) const
+{
+    // the connection keeps the spline until one of its end points moves
+    return connection.cubicPath();
 }
 
 void DefaultConnectionPainter::drawSketchLine(QPainter *painter, ConnectionGraphicsObject const &cgo) const
@@ -41,7 +51,7 @@ void DefaultConnectionPainter::drawSketchLine(QPainter *painter, ConnectionGraph
         painter->setPen(pen);
         painter->setBrush(Qt::NoBrush);
 
-        auto cubic = cubicPath(cgo);
+        auto const &cubic = cubicPath(cgo);
 
         // cubic spline
         painter->drawPath(cubic);
@@ -52,23 +62,25 @@ void DefaultConnectionPainter::drawHoveredOrSelected(QPainter *painter, Connecti
 {
     bool const hovered = cgo.connectionState().hovered();
     bool const selected = cgo.isSelected();
+    bool const highlighted = cgo.graphModel().connectionHighlighted(cgo.connectionId());
 
     // drawn as a fat background
-    if (hovered || selected) {
+    if (hovered || selected || highlighted) {
         auto const &connectionStyle = QtNodes::StyleCollection::connectionStyle();
 
         double const lineWidth = connectionStyle.lineWidth();
 
         QPen pen;
         pen.setWidth(static_cast<int>(2 * lineWidth));
-        pen.setColor(selected ? connectionStyle.selectedHaloColor()
-                              : connectionStyle.hoveredColor());
+        pen.setColor(highlighted ? highlightColor
+                     : selected  ? connectionStyle.selectedHaloColor()
+                                 : connectionStyle.hoveredColor());
 
         painter->setPen(pen);
         painter->setBrush(Qt::NoBrush);
 
         // cubic spline
-        auto const cubic = cubicPath(cgo);
+        auto const &cubic = cubicPath(cgo);
         painter->drawPath(cubic);
     }
 }
@@ -108,7 +120,7 @@ void DefaultConnectionPainter::drawNormalLine(QPainter *painter, ConnectionGraph
             = graphModel.portData(cId.inNodeId, PortType::In, cId.inPortIndex, PortRole::DataType)
                   .value<NodeDataType>();
 
-        useGradientColor = (dataTypeOut.id != dataTypeIn.id);
+        useGradientColor = (dataTypeOut.id != dataTypeIn.id) && !cgo.nodeScene()->isViewMoving();
 
         normalColorOut = connectionStyle.normalColor(dataTypeOut.id);
         normalColorIn = connectionStyle.normalColor(dataTypeIn.id);
@@ -126,7 +138,7 @@ void DefaultConnectionPainter::drawNormalLine(QPainter *painter, ConnectionGraph
 
     bool const selected = cgo.isSelected();
 
-    auto cubic = cubicPath(cgo);
+    auto const &cubic = cubicPath(cgo);
     if (useGradientColor) {
         painter->setBrush(Qt::NoBrush);
 
@@ -175,8 +187,66 @@ void DefaultConnectionPainter::drawNormalLine(QPainter *painter, ConnectionGraph
     }
 }
 
+void DefaultConnectionPainter::drawSimplifiedLine(QPainter *painter,
+                                                  ConnectionGraphicsObject const &cgo,
+                                                  LevelOfDetail lod) const
+{
+    auto const &connectionStyle = QtNodes::StyleCollection::connectionStyle();
+
+    ConnectionState const &state = cgo.connectionState();
+
+    painter->setRenderHint(QPainter::Antialiasing, false);
+    painter->setBrush(Qt::NoBrush);
+
+    float const heat = cgo.graphModel().connectionHeat(cgo.connectionId());
+    if (heat > 0.0f && lod != LevelOfDetail::Minimal) {
+        painter->setPen(heatPen(heat, connectionStyle.lineWidth()));
+        painter->drawLine(cgo.endPoint(PortType::Out), cgo.endPoint(PortType::In));
+    }
+
+    QPen p;
+    if (state.requiresPort()) {
+        p.setColor(connectionStyle.constructionColor());
+        p.setStyle(Qt::DashLine);
+    } else if (cgo.graphModel().connectionHighlighted(cgo.connectionId())) {
+        p.setColor(highlightColor);
+    } else if (cgo.isSelected() || state.hovered()) {
+        p.setColor(connectionStyle.selectedColor());
+    } else {
+        p.setColor(connectionStyle.normalColor());
+    }
+
+    // at minimal detail a hairline is enough, otherwise keep the style width
+    if (lod == LevelOfDetail::Minimal) {
+        p.setWidth(0);
+    } else {
+        p.setWidthF(connectionStyle.lineWidth());
+    }
+
+    painter->setPen(p);
+
+    painter->drawLine(cgo.endPoint(PortType::Out), cgo.endPoint(PortType::In));
+}
+
 void DefaultConnectionPainter::paint(QPainter *painter, ConnectionGraphicsObject const &cgo) const
 {
+    // drawn by the view together with the other plain lines
+    if (cgo.nodeScene()->isBatchedConnection(cgo))
+        return;
+
+    LevelOfDetail const lod = cgo.nodeScene()->levelOfDetail();
+    if (lod != LevelOfDetail::Full) {
+        drawSimplifiedLine(painter, cgo, lod);
+        return;
+    }
+
+    float const heat = cgo.graphModel().connectionHeat(cgo.connectionId());
+    if (heat > 0.0f) {
+        painter->setPen(heatPen(heat, QtNodes::StyleCollection::connectionStyle().lineWidth()));
+        painter->setBrush(Qt::NoBrush);
+        painter->drawPath(cubicPath(cgo));
+    }
+
     drawHoveredOrSelected(painter, cgo);
 
     drawSketchLine(painter, cgo);
@@ -201,7 +271,7 @@ void DefaultConnectionPainter::paint(QPainter *painter, ConnectionGraphicsObject
 
 QPainterPath DefaultConnectionPainter::getPainterStroke(ConnectionGraphicsObject const &connection) const
 {
-    auto cubic = cubicPath(connection);
+    auto const &cubic = cubicPath(connection);
 
     QPointF const &out = connection.endPoint(PortType::Out);
     QPainterPath result(out);
@@ -18,7 +18,7 @@ DefaultHorizontalNodeGeometry::DefaultHorizontalNodeGeometry(AbstractGraphModel
 {
     QFont f;
     f.setBold(true);
-    _boldFontMetrics = QFontMetrics(f);
+    _boldFontMetrics = CachedFontMetrics(f);
 
     _portSize = _fontMetrics.height();
 }
@@ -52,6 +52,12 @@ void DefaultHorizontalNodeGeometry::recomputeSize(NodeId const nodeId) const
         width += w->width();
     }
 
+    // room for the [+][-] pairs of both sides
+    if (_graphModel.nodeFlags(nodeId) & NodeFlag::PortControls) {
+        QSizeF const control = portControlSize();
+        width += static_cast<unsigned int>(2 * (2 * control.width() + _portSpasing / 2.0)) + 2 * _portSpasing;
+    }
+
     width = std::max(width, static_cast<unsigned int>(capRect.width()) + 2 * _portSpasing);
 
     QSize size(width, height);
@@ -173,6 +179,37 @@ QRect DefaultHorizontalNodeGeometry::resizeHandleRect(NodeId const nodeId) const
     return QRect(size.width() - _portSpasing, size.height() - _portSpasing, rectSize, rectSize);
 }
 
+QSizeF DefaultHorizontalNodeGeometry::portControlSize() const
+{
+    return QSizeF(1.5 * _portSize, _portSize);
+}
+
+QRectF DefaultHorizontalNodeGeometry::portControlRect(NodeId const nodeId,
+                                                      PortType const portType,
+                                                      PortIndex const portIndex,
+                                                      PortControl const control) const
+{
+    QSizeF const s = portControlSize();
+    double const gap = _portSpasing / 2.0;
+
+    QPointF const p = portPosition(nodeId, portType, portIndex);
+
+    // the pair sits next to the port label, [+] first
+    double x = 0.0;
+    if (portType == PortType::In) {
+        x = 2.0 * _portSpasing + maxPortsTextAdvance(nodeId, PortType::In);
+    } else {
+        QSize const size = _graphModel.nodeData<QSize>(nodeId, NodeRole::Size);
+        x = size.width() - 2.0 * _portSpasing - maxPortsTextAdvance(nodeId, PortType::Out)
+            - 2.0 * s.width() - gap;
+    }
+
+    if (control == PortControl::Remove)
+        x += s.width() + gap;
+
+    return QRectF(QPointF(x, p.y() - s.height() / 2.0), s);
+}
+
 QRectF DefaultHorizontalNodeGeometry::portTextRect(NodeId const nodeId,
                                                    PortType const portType,
                                                    PortIndex const portIndex) const
@@ -201,8 +238,32 @@ unsigned int DefaultHorizontalNodeGeometry::maxVerticalPortsExtent(NodeId const
     return step * maxNumOfEntries;
 }
 
+void DefaultHorizontalNodeGeometry::invalidateNode(NodeId const nodeId) const
+{
+    _portTextAdvances.erase(nodeId);
+}
+
 unsigned int DefaultHorizontalNodeGeometry::maxPortsTextAdvance(NodeId const nodeId,
                                                                 PortType const portType) const
+{
+    PortCount const n = _graphModel.nodeData<PortCount>(nodeId,
+                                                        (portType == PortType::Out)
+                                                            ? NodeRole::OutPortCount
+                                                            : NodeRole::InPortCount);
+
+    PortTextAdvance &cached = _portTextAdvances[nodeId][static_cast<int>(portType)];
+
+    if (!cached.valid || cached.portCount != n) {
+        cached.advance = measurePortsTextAdvance(nodeId, portType);
+        cached.portCount = n;
+        cached.valid = true;
+    }
+
+    return cached.advance;
+}
+
+unsigned int DefaultHorizontalNodeGeometry::measurePortsTextAdvance(NodeId const nodeId,
+                                                                    PortType const portType) const
 {
     unsigned int width = 0;
 
@@ -226,11 +287,7 @@ unsigned int DefaultHorizontalNodeGeometry::maxPortsTextAdvance(NodeId const nod
             name = portData.name;
         }
 
-#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
         width = std::max(unsigned(_fontMetrics.horizontalAdvance(name)), width);
-#else
-        width = std::max(unsigned(_fontMetrics.width(name)), width);
-#endif
     }
 
     return width;
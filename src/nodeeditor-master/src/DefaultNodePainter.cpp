@@ -15,12 +15,30 @@
 
 namespace QtNodes {
 
+/// Boundary of a node with `NodeFlag::Live`.
+static QColor const liveBoundaryColor(255, 165, 0);
+
+/// Badge of a node with problems.
+static QColor const problemBadgeColor(220, 40, 40);
+
+/// Overlay of a node with a heat in (0, 1], from translucent yellow to opaque red.
+static QColor heatColor(float heat)
+{
+    return QColor::fromHsvF((1.0f - heat) / 6.0f, 1.0f, 1.0f, 0.25f + 0.5f * heat);
+}
+
 void DefaultNodePainter::paint(QPainter *painter, NodeGraphicsObject &ngo) const
 {
     // TODO?
     //AbstractNodeGeometry & geometry = ngo.nodeScene()->nodeGeometry();
     //geometry.recomputeSizeIfFontChanged(painter->font());
 
+    LevelOfDetail const lod = ngo.nodeScene()->levelOfDetail();
+    if (lod != LevelOfDetail::Full) {
+        drawSimplifiedNode(painter, ngo, lod);
+        return;
+    }
+
     drawNodeRect(painter, ngo);
 
     drawConnectionPoints(painter, ngo);
@@ -31,7 +49,11 @@ void DefaultNodePainter::paint(QPainter *painter, NodeGraphicsObject &ngo) const
 
     drawEntryLabels(painter, ngo);
 
+    drawPortControls(painter, ngo);
+
     drawResizeRect(painter, ngo);
+
+    drawProblemBadge(painter, ngo);
 }
 
 void DefaultNodePainter::drawNodeRect(QPainter *painter, NodeGraphicsObject &ngo) const
@@ -44,13 +66,14 @@ void DefaultNodePainter::drawNodeRect(QPainter *painter, NodeGraphicsObject &ngo
 
     QSize size = geometry.size(nodeId);
 
-    QJsonDocument json = QJsonDocument::fromVariant(model.nodeData(nodeId, NodeRole::Style));
-
-    NodeStyle nodeStyle(json.object());
+    NodeStyle const &nodeStyle = ngo.nodeStyle();
 
     auto color = ngo.isSelected() ? nodeStyle.SelectedBoundaryColor : nodeStyle.NormalBoundaryColor;
 
-    if (ngo.nodeState().hovered()) {
+    if (model.nodeFlags(nodeId) & NodeFlag::Live) {
+        QPen p(liveBoundaryColor, nodeStyle.HoveredPenWidth);
+        painter->setPen(p);
+    } else if (ngo.nodeState().hovered()) {
         QPen p(color, nodeStyle.HoveredPenWidth);
         painter->setPen(p);
     } else {
@@ -58,20 +81,31 @@ void DefaultNodePainter::drawNodeRect(QPainter *painter, NodeGraphicsObject &ngo
         painter->setPen(p);
     }
 
-    QLinearGradient gradient(QPointF(0.0, 0.0), QPointF(2.0, size.height()));
+    if (ngo.nodeScene()->isViewMoving()) {
+        painter->setBrush(nodeStyle.GradientColor1);
+    } else {
+        QLinearGradient gradient(QPointF(0.0, 0.0), QPointF(2.0, size.height()));
 
-    gradient.setColorAt(0.0, nodeStyle.GradientColor0);
-    gradient.setColorAt(0.10, nodeStyle.GradientColor1);
-    gradient.setColorAt(0.90, nodeStyle.GradientColor2);
-    gradient.setColorAt(1.0, nodeStyle.GradientColor3);
+        gradient.setColorAt(0.0, nodeStyle.GradientColor0);
+        gradient.setColorAt(0.10, nodeStyle.GradientColor1);
+        gradient.setColorAt(0.90, nodeStyle.GradientColor2);
+        gradient.setColorAt(1.0, nodeStyle.GradientColor3);
 
-    painter->setBrush(gradient);
+        painter->setBrush(gradient);
+    }
 
     QRectF boundary(0, 0, size.width(), size.height());
 
     double const radius = 3.0;
 
     painter->drawRoundedRect(boundary, radius, radius);
+
+    float const heat = model.nodeHeat(nodeId);
+    if (heat > 0.0f) {
+        painter->setPen(Qt::NoPen);
+        painter->setBrush(heatColor(heat));
+        painter->drawRoundedRect(boundary, radius, radius);
+    }
 }
 
 void DefaultNodePainter::drawConnectionPoints(QPainter *painter, NodeGraphicsObject &ngo) const
@@ -80,8 +114,7 @@ void DefaultNodePainter::drawConnectionPoints(QPainter *painter, NodeGraphicsObj
     NodeId const nodeId = ngo.nodeId();
     AbstractNodeGeometry &geometry = ngo.nodeScene()->nodeGeometry();
 
-    QJsonDocument json = QJsonDocument::fromVariant(model.nodeData(nodeId, NodeRole::Style));
-    NodeStyle nodeStyle(json.object());
+    NodeStyle const &nodeStyle = ngo.nodeStyle();
 
     auto const &connectionStyle = StyleCollection::connectionStyle();
 
@@ -101,35 +134,8 @@ void DefaultNodePainter::drawConnectionPoints(QPainter *painter, NodeGraphicsObj
             auto const &dataType = model.portData(nodeId, portType, portIndex, PortRole::DataType)
                                        .value<NodeDataType>();
 
-            double r = 1.0;
-
-            NodeState const &state = ngo.nodeState();
-
-            if (auto const *cgo = state.connectionForReaction()) {
-                PortType requiredPort = cgo->connectionState().requiredPort();
-
-                if (requiredPort == portType) {
-                    ConnectionId possibleConnectionId = makeCompleteConnectionId(cgo->connectionId(),
-                                                                                 nodeId,
-                                                                                 portIndex);
-
-                    bool const possible = model.connectionPossible(possibleConnectionId);
-
-                    auto cp = cgo->sceneTransform().map(cgo->endPoint(requiredPort));
-                    cp = ngo.sceneTransform().inverted().map(cp);
-
-                    auto diff = cp - p;
-                    double dist = std::sqrt(QPointF::dotProduct(diff, diff));
-
-                    if (possible) {
-                        double const thres = 40.0;
-                        r = (dist < thres) ? (2.0 - dist / thres) : 1.0;
-                    } else {
-                        double const thres = 80.0;
-                        r = (dist < thres) ? (dist / thres) : 1.0;
-                    }
-                }
-            }
+            // set by the scene once per move of a draft connection
+            double const r = ngo.nodeState().connectionPointScale(portType, portIndex);
 
             if (connectionStyle.useDataDefinedColors()) {
                 painter->setBrush(connectionStyle.normalColor(dataType.id));
@@ -140,10 +146,6 @@ void DefaultNodePainter::drawConnectionPoints(QPainter *painter, NodeGraphicsObj
             painter->drawEllipse(p, reducedDiameter * r, reducedDiameter * r);
         }
     }
-
-    if (ngo.nodeState().connectionForReaction()) {
-        ngo.nodeState().resetConnectionForReaction();
-    }
 }
 
 void DefaultNodePainter::drawFilledConnectionPoints(QPainter *painter, NodeGraphicsObject &ngo) const
@@ -152,8 +154,7 @@ void DefaultNodePainter::drawFilledConnectionPoints(QPainter *painter, NodeGraph
     NodeId const nodeId = ngo.nodeId();
     AbstractNodeGeometry &geometry = ngo.nodeScene()->nodeGeometry();
 
-    QJsonDocument json = QJsonDocument::fromVariant(model.nodeData(nodeId, NodeRole::Style));
-    NodeStyle nodeStyle(json.object());
+    NodeStyle const &nodeStyle = ngo.nodeStyle();
 
     auto diameter = nodeStyle.ConnectionPointDiameter;
 
@@ -206,8 +207,7 @@ void DefaultNodePainter::drawNodeCaption(QPainter *painter, NodeGraphicsObject &
 
     QPointF position = geometry.captionPosition(nodeId);
 
-    QJsonDocument json = QJsonDocument::fromVariant(model.nodeData(nodeId, NodeRole::Style));
-    NodeStyle nodeStyle(json.object());
+    NodeStyle const &nodeStyle = ngo.nodeStyle();
 
     painter->setFont(f);
     painter->setPen(nodeStyle.FontColor);
@@ -223,8 +223,7 @@ void DefaultNodePainter::drawEntryLabels(QPainter *painter, NodeGraphicsObject &
     NodeId const nodeId = ngo.nodeId();
     AbstractNodeGeometry &geometry = ngo.nodeScene()->nodeGeometry();
 
-    QJsonDocument json = QJsonDocument::fromVariant(model.nodeData(nodeId, NodeRole::Style));
-    NodeStyle nodeStyle(json.object());
+    NodeStyle const &nodeStyle = ngo.nodeStyle();
 
     for (PortType portType : {PortType::Out, PortType::In}) {
         unsigned int n = model.nodeData<unsigned int>(nodeId,
@@ -257,6 +256,133 @@ void DefaultNodePainter::drawEntryLabels(QPainter *painter, NodeGraphicsObject &
     }
 }
 
+void DefaultNodePainter::drawProblemBadge(QPainter *painter, NodeGraphicsObject &ngo) const
+{
+    AbstractGraphModel &model = ngo.graphModel();
+    NodeId const nodeId = ngo.nodeId();
+
+    if (model.nodeProblems(nodeId).isEmpty())
+        return;
+
+    QSize const size = ngo.nodeScene()->nodeGeometry().size(nodeId);
+
+    double const diameter = 14.0;
+    QRectF const badge(size.width() - diameter - 3.0, 3.0, diameter, diameter);
+
+    painter->save();
+    painter->setRenderHint(QPainter::Antialiasing, true);
+    painter->setPen(QPen(Qt::white, 1.0));
+    painter->setBrush(problemBadgeColor);
+    painter->drawEllipse(badge);
+
+    QFont font = painter->font();
+    font.setBold(true);
+    font.setPixelSize(11);
+    painter->setFont(font);
+    painter->drawText(badge, Qt::AlignCenter, QStringLiteral("!"));
+    painter->restore();
+}
+
+void DefaultNodePainter::drawSimplifiedNode(QPainter *painter,
+                                            NodeGraphicsObject &ngo,
+                                            LevelOfDetail lod) const
+{
+    AbstractGraphModel &model = ngo.graphModel();
+    NodeId const nodeId = ngo.nodeId();
+    AbstractNodeGeometry &geometry = ngo.nodeScene()->nodeGeometry();
+
+    NodeStyle const &nodeStyle = ngo.nodeStyle();
+
+    painter->setRenderHint(QPainter::Antialiasing, false);
+
+    bool const live = model.nodeFlags(nodeId) & NodeFlag::Live;
+    QColor const boundary = live              ? liveBoundaryColor
+                            : ngo.isSelected() ? nodeStyle.SelectedBoundaryColor
+                                               : nodeStyle.NormalBoundaryColor;
+
+    QPen pen(boundary, live ? nodeStyle.HoveredPenWidth : nodeStyle.PenWidth);
+    pen.setCosmetic(true);
+    painter->setPen(pen);
+    painter->setBrush(nodeStyle.GradientColor1);
+
+    QSize const size = geometry.size(nodeId);
+    painter->drawRect(QRectF(0, 0, size.width(), size.height()));
+
+    float const heat = model.nodeHeat(nodeId);
+    if (heat > 0.0f)
+        painter->fillRect(QRectF(0, 0, size.width(), size.height()), heatColor(heat));
+
+    // a zoomed out view is where a broken state has to be spotted
+    drawProblemBadge(painter, ngo);
+
+    if (lod == LevelOfDetail::Minimal)
+        return;
+
+    // ports as plain squares, filled ones when connected
+    painter->setPen(Qt::NoPen);
+
+    double const half = nodeStyle.ConnectionPointDiameter * 0.4;
+
+    for (PortType portType : {PortType::Out, PortType::In}) {
+        unsigned int n = model.nodeData<unsigned int>(nodeId,
+                                                      (portType == PortType::Out)
+                                                          ? NodeRole::OutPortCount
+                                                          : NodeRole::InPortCount);
+
+        for (PortIndex portIndex = 0; portIndex < n; ++portIndex) {
+            QPointF const p = geometry.portPosition(nodeId, portType, portIndex);
+
+            bool const connected = !model.connections(nodeId, portType, portIndex).empty();
+            painter->setBrush(connected ? nodeStyle.FilledConnectionPointColor
+                                        : nodeStyle.ConnectionPointColor);
+
+            painter->drawRect(QRectF(p.x() - half, p.y() - half, 2 * half, 2 * half));
+        }
+    }
+}
+
+void DefaultNodePainter::drawPortControls(QPainter *painter, NodeGraphicsObject &ngo) const
+{
+    AbstractGraphModel &model = ngo.graphModel();
+    NodeId const nodeId = ngo.nodeId();
+
+    if (!(model.nodeFlags(nodeId) & NodeFlag::PortControls))
+        return;
+
+    AbstractNodeGeometry &geometry = ngo.nodeScene()->nodeGeometry();
+
+    NodeStyle const &nodeStyle = ngo.nodeStyle();
+
+    painter->setPen(QPen(nodeStyle.NormalBoundaryColor, 1.0));
+
+    for (PortType portType : {PortType::Out, PortType::In}) {
+        unsigned int n = model.nodeData<unsigned int>(nodeId,
+                                                      (portType == PortType::Out)
+                                                          ? NodeRole::OutPortCount
+                                                          : NodeRole::InPortCount);
+
+        for (PortIndex portIndex = 0; portIndex < n; ++portIndex) {
+            for (PortControl control : {PortControl::Add, PortControl::Remove}) {
+                QRectF const r = geometry.portControlRect(nodeId, portType, portIndex, control);
+
+                if (r.isEmpty())
+                    continue;
+
+                painter->setBrush(nodeStyle.GradientColor0);
+                painter->drawRoundedRect(r, 2.0, 2.0);
+
+                // the glyph is drawn as lines, no text layout per control
+                QPointF const c = r.center();
+                double const half = 0.25 * r.height();
+
+                painter->drawLine(QPointF(c.x() - half, c.y()), QPointF(c.x() + half, c.y()));
+                if (control == PortControl::Add)
+                    painter->drawLine(QPointF(c.x(), c.y() - half), QPointF(c.x(), c.y() + half));
+            }
+        }
+    }
+}
+
 void DefaultNodePainter::drawResizeRect(QPainter *painter, NodeGraphicsObject &ngo) const
 {
     AbstractGraphModel &model = ngo.graphModel();
@@ -18,7 +18,7 @@ DefaultVerticalNodeGeometry::DefaultVerticalNodeGeometry(AbstractGraphModel &gra
 {
     QFont f;
     f.setBold(true);
-    _boldFontMetrics = QFontMetrics(f);
+    _boldFontMetrics = CachedFontMetrics(f);
 
     _portSize = _fontMetrics.height();
 }
@@ -227,8 +227,32 @@ unsigned int DefaultVerticalNodeGeometry::maxHorizontalPortsExtent(NodeId const
     return step * maxNumOfEntries;
 }
 
+void DefaultVerticalNodeGeometry::invalidateNode(NodeId const nodeId) const
+{
+    _portTextAdvances.erase(nodeId);
+}
+
 unsigned int DefaultVerticalNodeGeometry::maxPortsTextAdvance(NodeId const nodeId,
                                                               PortType const portType) const
+{
+    PortCount const n = _graphModel.nodeData<PortCount>(nodeId,
+                                                        (portType == PortType::Out)
+                                                            ? NodeRole::OutPortCount
+                                                            : NodeRole::InPortCount);
+
+    PortTextAdvance &cached = _portTextAdvances[nodeId][static_cast<int>(portType)];
+
+    if (!cached.valid || cached.portCount != n) {
+        cached.advance = measurePortsTextAdvance(nodeId, portType);
+        cached.portCount = n;
+        cached.valid = true;
+    }
+
+    return cached.advance;
+}
+
+unsigned int DefaultVerticalNodeGeometry::measurePortsTextAdvance(NodeId const nodeId,
+                                                                  PortType const portType) const
 {
     unsigned int width = 0;
 
@@ -252,11 +276,7 @@ unsigned int DefaultVerticalNodeGeometry::maxPortsTextAdvance(NodeId const nodeI
             name = portData.name;
         }
 
-#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
         width = std::max(unsigned(_fontMetrics.horizontalAdvance(name)), width);
-#else
-        width = std::max(unsigned(_fontMetrics.width(name)), width);
-#endif
     }
 
     return width;
@@ -20,6 +20,12 @@
 #include <QtOpenGL>
 #include <QtWidgets>
 
+#ifdef QT_NODES_OPENGL_VIEWPORT
+#include <QtGui/QOffscreenSurface>
+#include <QtGui/QOpenGLContext>
+#include <QOpenGLWidget>
+#endif
+
 #include <cmath>
 #include <iostream>
 
@@ -55,6 +61,13 @@ GraphicsView::GraphicsView(QWidget *parent)
     // re-calculation when expanding the all QGraphicsItems common rect.
     int maxSize = 32767;
     setSceneRect(-maxSize, -maxSize, (maxSize * 2), (maxSize * 2));
+
+    connect(this, &GraphicsView::scaleChanged, this, &GraphicsView::updateVisibleSceneRect);
+
+    _settleTimer = new QTimer(this);
+    _settleTimer->setSingleShot(true);
+    _settleTimer->setInterval(kSettleMs);
+    connect(_settleTimer, &QTimer::timeout, this, &GraphicsView::endViewMove);
 }
 
 GraphicsView::GraphicsView(BasicGraphicsScene *scene, QWidget *parent)
@@ -75,8 +88,18 @@ QAction *GraphicsView::deleteSelectionAction() const
 
 void GraphicsView::setScene(BasicGraphicsScene *scene)
 {
+    if (auto *oldScene = nodeScene())
+        disconnect(this, &GraphicsView::scaleChanged, oldScene, &BasicGraphicsScene::setViewScale);
+
     QGraphicsView::setScene(scene);
 
+    if (scene) {
+        connect(this, &GraphicsView::scaleChanged, scene, &BasicGraphicsScene::setViewScale);
+        scene->setViewScale(getScale());
+        updateVisibleSceneRect();
+        updateViewportUpdateMode();
+    }
+
     {
         // setup actions
         delete _clearSelectionAction;
@@ -153,7 +176,11 @@ void GraphicsView::setScene(BasicGraphicsScene *scene)
 void GraphicsView::centerScene()
 {
     if (scene()) {
-        scene()->setSceneRect(QRectF());
+        // a virtualized scene has objects for the visible nodes only
+        if (nodeScene() && nodeScene()->isVirtualized())
+            scene()->setSceneRect(nodeScene()->nodesBoundingRect());
+        else
+            scene()->setSceneRect(QRectF());
 
         QRectF sceneRect = scene()->sceneRect();
 
@@ -190,6 +217,8 @@ void GraphicsView::wheelEvent(QWheelEvent *event)
         return;
     }
 
+    beginViewMove();
+
     double const d = delta.y() / std::abs(delta.y());
 
     if (d > 0.0)
@@ -339,7 +368,9 @@ void GraphicsView::mouseMoveEvent(QMouseEvent *event)
         // Make sure shift is not being pressed
         if ((event->modifiers() & Qt::ShiftModifier) == 0) {
             QPointF difference = _clickPos - mapToScene(event->pos());
+            beginViewMove();
             setSceneRect(sceneRect().translated(difference.x(), difference.y()));
+            updateVisibleSceneRect();
         }
     }
 }
@@ -383,6 +414,9 @@ void GraphicsView::drawBackground(QPainter *painter, const QRectF &r)
 
     painter->setPen(p);
     drawGrid(150);
+
+    if (auto *basicScene = nodeScene())
+        basicScene->drawBatchedConnections(painter, r);
 }
 
 void GraphicsView::showEvent(QShowEvent *event)
@@ -390,6 +424,168 @@ void GraphicsView::showEvent(QShowEvent *event)
     QGraphicsView::showEvent(event);
 
     centerScene();
+
+    updateVisibleSceneRect();
+    updateViewportUpdateMode();
+}
+
+void GraphicsView::resizeEvent(QResizeEvent *event)
+{
+    QGraphicsView::resizeEvent(event);
+
+    updateVisibleSceneRect();
+}
+
+void GraphicsView::scrollContentsBy(int dx, int dy)
+{
+    QGraphicsView::scrollContentsBy(dx, dy);
+
+    updateVisibleSceneRect();
+}
+
+void GraphicsView::updateVisibleSceneRect()
+{
+    QRectF const visible = mapToScene(viewport()->rect()).boundingRect();
+
+    if (auto *basicScene = nodeScene())
+        basicScene->setVisibleSceneRect(visible);
+
+    Q_EMIT visibleSceneRectChanged(visible);
+}
+
+void GraphicsView::setAdaptiveQuality(bool enabled)
+{
+    _adaptiveQuality = enabled;
+
+    if (!enabled && _viewMoving)
+        endViewMove();
+}
+
+bool GraphicsView::openGLAvailable()
+{
+#ifdef QT_NODES_OPENGL_VIEWPORT
+    QOpenGLContext context;
+    if (!context.create())
+        return false;
+
+    QOffscreenSurface surface;
+    surface.setFormat(context.format());
+    surface.create();
+
+    bool const current = context.makeCurrent(&surface);
+    if (current)
+        context.doneCurrent();
+
+    return current;
+#else
+    return false;
+#endif
+}
+
+bool GraphicsView::setOpenGLViewport(bool enabled)
+{
+    if (enabled == _openGLViewport)
+        return true;
+
+    if (!enabled) {
+        setViewport(new QWidget);
+        _openGLViewport = false;
+        updateViewportUpdateMode();
+        return true;
+    }
+
+#ifdef QT_NODES_OPENGL_VIEWPORT
+    if (!openGLAvailable())
+        return false;
+
+    auto *glWidget = new QOpenGLWidget;
+
+    // multisampling gives the GL paint engine its antialiasing
+    QSurfaceFormat format = QSurfaceFormat::defaultFormat();
+    format.setSamples(4);
+    glWidget->setFormat(format);
+
+    setViewport(glWidget);
+    _openGLViewport = true;
+    updateViewportUpdateMode();
+    return true;
+#else
+    return false;
+#endif
+}
+
+void GraphicsView::setBatchedConnections(bool enabled)
+{
+    if (auto *basicScene = nodeScene())
+        basicScene->setBatchedConnections(enabled);
+
+    setCacheMode(enabled ? QGraphicsView::CacheNone : QGraphicsView::CacheBackground);
+    resetCachedContent();
+
+    viewport()->update();
+}
+
+void GraphicsView::beginViewMove()
+{
+    if (!_adaptiveQuality)
+        return;
+
+    _settleTimer->start();
+
+    if (_viewMoving)
+        return;
+
+    _viewMoving = true;
+
+    // every frame of a pan or zoom changes the whole viewport anyway
+    _antialiasing = renderHints().testFlag(QPainter::Antialiasing);
+    setRenderHint(QPainter::Antialiasing, false);
+    setViewportUpdateMode(QGraphicsView::FullViewportUpdate);
+
+    if (auto *basicScene = nodeScene())
+        basicScene->setViewMoving(true);
+}
+
+void GraphicsView::endViewMove()
+{
+    _settleTimer->stop();
+
+    if (!_viewMoving)
+        return;
+
+    _viewMoving = false;
+
+    setRenderHint(QPainter::Antialiasing, _antialiasing);
+
+    if (auto *basicScene = nodeScene())
+        basicScene->setViewMoving(false);
+
+    updateViewportUpdateMode();
+
+    viewport()->update();
+}
+
+void GraphicsView::updateViewportUpdateMode()
+{
+    auto *basicScene = nodeScene();
+    if (!basicScene || _viewMoving)
+        return;
+
+    // a GL surface is redrawn as a whole anyway
+    if (_openGLViewport) {
+        setViewportUpdateMode(QGraphicsView::FullViewportUpdate);
+        return;
+    }
+
+    std::size_t const visibleNodes
+        = basicScene->nodesInRect(mapToScene(viewport()->rect()).boundingRect()).size();
+
+    if (visibleNodes <= kSmartUpdateNodes)
+        setViewportUpdateMode(QGraphicsView::SmartViewportUpdate);
+    else if (visibleNodes < kFullUpdateNodes)
+        setViewportUpdateMode(QGraphicsView::BoundingRectViewportUpdate);
+    else
+        setViewportUpdateMode(QGraphicsView::FullViewportUpdate);
 }
 
 BasicGraphicsScene *GraphicsView::nodeScene()
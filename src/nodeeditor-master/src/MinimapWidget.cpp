@@ -0,0 +1,229 @@
+#include "MinimapWidget.hpp"
+
+#include "AbstractGraphModel.hpp"
+#include "BasicGraphicsScene.hpp"
+#include "GraphicsView.hpp"
+#include "ScopeTraceHook.hpp"
+#include "StyleCollection.hpp"
+
+#include <QtCore/QTimer>
+#include <QtGui/QMouseEvent>
+#include <QtGui/QPainter>
+
+#include <algorithm>
+
+namespace QtNodes {
+
+MinimapWidget::MinimapWidget(GraphicsView &view, QWidget *parent)
+    : QWidget(parent)
+    , _view(view)
+    , _scene(dynamic_cast<BasicGraphicsScene *>(view.scene()))
+    , _renderTimer(new QTimer(this))
+{
+    Q_ASSERT(_scene);
+
+    setCursor(Qt::PointingHandCursor);
+
+    _renderTimer->setSingleShot(true);
+    _renderTimer->setInterval(kRenderDelayMs);
+    connect(_renderTimer, &QTimer::timeout, this, &MinimapWidget::flush);
+
+    // connected after the scene, its node index is already updated when these run
+    AbstractGraphModel &model = _scene->graphModel();
+
+    connect(&model, &AbstractGraphModel::nodeCreated, this, &MinimapWidget::onNodeChanged);
+    connect(&model, &AbstractGraphModel::nodePositionUpdated, this, &MinimapWidget::onNodeChanged);
+    connect(&model, &AbstractGraphModel::nodeUpdated, this, &MinimapWidget::onNodeChanged);
+    connect(&model, &AbstractGraphModel::nodeDeleted, this, &MinimapWidget::onNodeDeleted);
+    connect(&model, &AbstractGraphModel::modelReset, this, &MinimapWidget::scheduleFullRender);
+
+    connect(&view, &GraphicsView::visibleSceneRectChanged, this, [this](QRectF const &sceneRect) {
+        if (sceneRect != _visibleSceneRect) {
+            _visibleSceneRect = sceneRect;
+            update();
+        }
+    });
+}
+
+QSize MinimapWidget::sizeHint() const
+{
+    return QSize(240, 180);
+}
+
+void MinimapWidget::onNodeChanged(NodeId const nodeId)
+{
+    if (_fullRenderPending)
+        return;
+
+    auto it = _nodeRects.find(nodeId);
+    if (it != _nodeRects.end())
+        _dirtyRects.push_back(it->second);
+
+    QRectF const rect = _scene->nodeSceneRect(nodeId);
+
+    if (!_worldRect.contains(rect)) {
+        scheduleFullRender();
+        return;
+    }
+
+    _dirtyRects.push_back(rect);
+
+    if (!_renderTimer->isActive())
+        _renderTimer->start();
+}
+
+void MinimapWidget::onNodeDeleted(NodeId const nodeId)
+{
+    if (_fullRenderPending)
+        return;
+
+    auto it = _nodeRects.find(nodeId);
+    if (it == _nodeRects.end())
+        return;
+
+    _dirtyRects.push_back(it->second);
+    _nodeRects.erase(it);
+
+    if (!_renderTimer->isActive())
+        _renderTimer->start();
+}
+
+void MinimapWidget::scheduleFullRender()
+{
+    _fullRenderPending = true;
+    _dirtyRects.clear();
+
+    if (!_renderTimer->isActive())
+        _renderTimer->start();
+}
+
+void MinimapWidget::flush()
+{
+    QTNODES_TRACE_SCOPE("MinimapWidget::flush");
+
+    if (_fullRenderPending) {
+        renderAll();
+        return;
+    }
+
+    for (QRectF const &rect : _dirtyRects)
+        renderRegion(rect);
+
+    _dirtyRects.clear();
+}
+
+void MinimapWidget::renderAll()
+{
+    _fullRenderPending = false;
+    _dirtyRects.clear();
+    _nodeRects.clear();
+
+    qreal const ratio = devicePixelRatioF();
+    _image = QImage(size() * ratio, QImage::Format_ARGB32_Premultiplied);
+    _image.setDevicePixelRatio(ratio);
+    _image.fill(StyleCollection::flowViewStyle().BackgroundColor);
+
+    QRectF const bounds = _scene->nodesBoundingRect();
+
+    if (bounds.isEmpty() || width() <= 0 || height() <= 0) {
+        _worldRect = QRectF();
+        _sceneToWidget = QTransform();
+        update();
+        return;
+    }
+
+    // room for nodes moving a little before everything has to be rendered again
+    qreal const margin = 0.1 * std::max(bounds.width(), bounds.height());
+    _worldRect = bounds.adjusted(-margin, -margin, margin, margin);
+
+    qreal const scale = std::min(width() / _worldRect.width(), height() / _worldRect.height());
+
+    _sceneToWidget = QTransform();
+    _sceneToWidget.translate((width() - _worldRect.width() * scale) / 2.0,
+                             (height() - _worldRect.height() * scale) / 2.0);
+    _sceneToWidget.scale(scale, scale);
+    _sceneToWidget.translate(-_worldRect.left(), -_worldRect.top());
+
+    QPainter painter(&_image);
+    drawNodes(painter, _worldRect);
+
+    update();
+}
+
+void MinimapWidget::renderRegion(QRectF const &sceneRect)
+{
+    QRectF const widgetRect = _sceneToWidget.mapRect(sceneRect).adjusted(-1, -1, 1, 1);
+
+    QPainter painter(&_image);
+    painter.setClipRect(widgetRect);
+    painter.fillRect(widgetRect, StyleCollection::flowViewStyle().BackgroundColor);
+
+    // the neighbours overlapping the region are drawn again, clipped to it
+    drawNodes(painter, _sceneToWidget.inverted().mapRect(widgetRect));
+
+    update(widgetRect.toAlignedRect());
+}
+
+void MinimapWidget::drawNodes(QPainter &painter, QRectF const &sceneRect)
+{
+    QColor const color = StyleCollection::nodeStyle().GradientColor1;
+
+    for (NodeId const nodeId : _scene->nodesInRect(sceneRect)) {
+        QRectF const rect = _scene->nodeSceneRect(nodeId);
+
+        _nodeRects[nodeId] = rect;
+
+        // at least a pixel, tiny nodes would vanish otherwise
+        QRectF r = _sceneToWidget.mapRect(rect);
+        r.setWidth(std::max<qreal>(r.width(), 1.0));
+        r.setHeight(std::max<qreal>(r.height(), 1.0));
+
+        painter.fillRect(r, color);
+    }
+}
+
+void MinimapWidget::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+
+    if (_image.isNull())
+        painter.fillRect(rect(), StyleCollection::flowViewStyle().BackgroundColor);
+    else
+        painter.drawImage(QPointF(0, 0), _image);
+
+    if (_worldRect.isEmpty() || _visibleSceneRect.isEmpty())
+        return;
+
+    painter.setPen(QPen(StyleCollection::nodeStyle().SelectedBoundaryColor, 1.0));
+    painter.setBrush(Qt::NoBrush);
+    painter.drawRect(_sceneToWidget.mapRect(_visibleSceneRect));
+}
+
+void MinimapWidget::resizeEvent(QResizeEvent *event)
+{
+    QWidget::resizeEvent(event);
+
+    scheduleFullRender();
+}
+
+void MinimapWidget::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton)
+        centerViewAt(event->pos());
+}
+
+void MinimapWidget::mouseMoveEvent(QMouseEvent *event)
+{
+    if (event->buttons() & Qt::LeftButton)
+        centerViewAt(event->pos());
+}
+
+void MinimapWidget::centerViewAt(QPointF const &widgetPos)
+{
+    if (_worldRect.isEmpty())
+        return;
+
+    _view.centerOn(_sceneToWidget.inverted().map(widgetPos));
+}
+
+} // namespace QtNodes
@@ -3,6 +3,7 @@
 #include <cstdlib>
 #include <iostream>
 
+#include <QtCore/QJsonDocument>
 #include <QtWidgets/QGraphicsEffect>
 #include <QtWidgets/QtWidgets>
 
@@ -13,6 +14,7 @@
 #include "ConnectionGraphicsObject.hpp"
 #include "ConnectionIdUtils.hpp"
 #include "NodeConnectionInteraction.hpp"
+#include "ScopeTraceHook.hpp"
 #include "StyleCollection.hpp"
 #include "UndoCommands.hpp"
 
@@ -29,41 +31,106 @@ NodeGraphicsObject::NodeGraphicsObject(BasicGraphicsScene &scene, NodeId nodeId)
     setFlag(QGraphicsItem::ItemDoesntPropagateOpacityToChildren, true);
     setFlag(QGraphicsItem::ItemIsFocusable, true);
 
-    setLockedState();
-
     setCacheMode(QGraphicsItem::DeviceCoordinateCache);
 
-    QJsonObject nodeStyleJson = _graphModel.nodeData(_nodeId, NodeRole::Style).toJsonObject();
-
-    NodeStyle nodeStyle(nodeStyleJson);
-
     {
         auto effect = new QGraphicsDropShadowEffect;
         effect->setOffset(4, 4);
         effect->setBlurRadius(20);
-        effect->setColor(nodeStyle.ShadowColor);
 
         setGraphicsEffect(effect);
     }
 
-    setOpacity(nodeStyle.Opacity);
-
     setAcceptHoverEvents(true);
 
+    initializeForNode();
+
+    connect(&_graphModel, &AbstractGraphModel::nodeFlagsUpdated, [this](NodeId const nodeId) {
+        if (_nodeId == nodeId && scene())
+            setLockedState();
+    });
+}
+
+void NodeGraphicsObject::rebind(BasicGraphicsScene &scene, NodeId const nodeId)
+{
+    Q_ASSERT(!this->scene());
+
+    _nodeId = nodeId;
+
+    _nodeState.setHovered(false);
+    _nodeState.setResizing(false);
+    _nodeState.resetReactingPorts();
+
+    invalidateNodeStyle();
+
+    scene.addItem(this);
+
+    setSelected(false);
+
+    initializeForNode();
+
+    // the device cache still holds the previous node
+    update();
+}
+
+void NodeGraphicsObject::removeEmbeddedWidget()
+{
+    // the proxy owns the widget, the model does not refer to it any more
+    delete _proxyWidget;
+    _proxyWidget = nullptr;
+}
+
+void NodeGraphicsObject::initializeForNode()
+{
+    setLockedState();
+
+    NodeStyle const &nodeStyle = this->nodeStyle();
+
+    if (auto effect = qobject_cast<QGraphicsDropShadowEffect *>(graphicsEffect())) {
+        effect->setColor(nodeStyle.ShadowColor);
+        effect->setEnabled(!nodeScene()->isViewMoving());
+    }
+
+    setOpacity(nodeStyle.Opacity);
+
     setZValue(0);
 
     embedQWidget();
 
+    updateLevelOfDetail();
+
     nodeScene()->nodeGeometry().recomputeSize(_nodeId);
 
     QPointF const pos = _graphModel.nodeData<QPointF>(_nodeId, NodeRole::Position);
 
     setPos(pos);
 
-    connect(&_graphModel, &AbstractGraphModel::nodeFlagsUpdated, [this](NodeId const nodeId) {
-        if (_nodeId == nodeId)
-            setLockedState();
-    });
+    nodeScene()->updateNodeIndex(*this);
+}
+
+NodeStyle const &NodeGraphicsObject::nodeStyle() const
+{
+    unsigned int const version = StyleCollection::nodeStyleVersion();
+
+    if (!_nodeStyle || _nodeStyleVersion != version) {
+        QVariant const styleData = _graphModel.nodeData(_nodeId, NodeRole::Style);
+
+        QJsonObject const json = QJsonDocument::fromVariant(styleData).object();
+
+        if (json.isEmpty() || json == StyleCollection::nodeStyleJson())
+            _nodeStyle = StyleCollection::sharedNodeStyle();
+        else
+            _nodeStyle = std::make_shared<NodeStyle const>(json);
+
+        _nodeStyleVersion = version;
+    }
+
+    return *_nodeStyle;
+}
+
+void NodeGraphicsObject::invalidateNodeStyle()
+{
+    _nodeStyle.reset();
 }
 
 AbstractGraphModel &NodeGraphicsObject::graphModel() const
@@ -84,6 +151,14 @@ void NodeGraphicsObject::updateQWidgetEmbedPos()
   }
 }
 
+void NodeGraphicsObject::updateLevelOfDetail()
+{
+    if (_proxyWidget)
+        _proxyWidget->setVisible(nodeScene()->levelOfDetail() == LevelOfDetail::Full);
+
+    update();
+}
+
 void NodeGraphicsObject::embedQWidget()
 {
     AbstractNodeGeometry &geometry = nodeScene()->nodeGeometry();
@@ -151,15 +226,10 @@ void NodeGraphicsObject::moveConnections() const
     }
 }
 
-void NodeGraphicsObject::reactToConnection(ConnectionGraphicsObject const *cgo)
-{
-    _nodeState.storeConnectionForReaction(cgo);
-
-    update();
-}
-
 void NodeGraphicsObject::paint(QPainter *painter, QStyleOptionGraphicsItem const *option, QWidget *)
 {
+    QTNODES_TRACE_SCOPE("NodeGraphicsObject::paint");
+
     painter->setClipRect(option->exposedRect);
 
     nodeScene()->nodePainter().paint(painter, *this);
@@ -168,7 +238,16 @@ void NodeGraphicsObject::paint(QPainter *painter, QStyleOptionGraphicsItem const
 QVariant NodeGraphicsObject::itemChange(GraphicsItemChange change, const QVariant &value)
 {
     if (change == ItemScenePositionHasChanged && scene()) {
-        moveConnections();
+        auto *basicScene = nodeScene();
+
+        // while the mouse drags nodes the connections follow once per frame
+        if (basicScene && basicScene->mouseGrabberItem())
+            basicScene->moveConnectionsDeferred(_nodeId);
+        else
+            moveConnections();
+
+        if (basicScene)
+            basicScene->updateNodeIndex(*this);
     }
 
     return QGraphicsObject::itemChange(change, value);
@@ -181,6 +260,18 @@ void NodeGraphicsObject::mousePressEvent(QGraphicsSceneMouseEvent *event)
 
     AbstractNodeGeometry &geometry = nodeScene()->nodeGeometry();
 
+    {
+        PortType portType;
+        PortIndex portIndex;
+        PortControl control;
+
+        if (geometry.checkPortControlHit(_nodeId, event->pos(), portType, portIndex, control)) {
+            Q_EMIT nodeScene()->portControlClicked(_nodeId, portType, portIndex, control);
+            event->accept();
+            return;
+        }
+    }
+
     for (PortType portToCheck : {PortType::In, PortType::Out}) {
         QPointF nodeCoord = sceneTransform().inverted().map(event->scenePos());
 
@@ -196,10 +287,12 @@ void NodeGraphicsObject::mousePressEvent(QGraphicsSceneMouseEvent *event)
             auto const &cnId = *connected.begin();
 
             // Need ConnectionGraphicsObject
+            auto cgo = nodeScene()->connectionGraphicsObject(cnId);
 
-            NodeConnectionInteraction interaction(*this,
-                                                  *nodeScene()->connectionGraphicsObject(cnId),
-                                                  *nodeScene());
+            if (!cgo)
+                continue;
+
+            NodeConnectionInteraction interaction(*this, *cgo, *nodeScene());
 
             if (_graphModel.detachPossible(cnId))
                 interaction.disconnect(portToCheck);
@@ -298,6 +391,7 @@ void NodeGraphicsObject::mouseReleaseEvent(QGraphicsSceneMouseEvent *event)
     QGraphicsObject::mouseReleaseEvent(event);
 
     // position connections precisely after fast node move
+    nodeScene()->flushConnectionMoves();
     moveConnections();
 
     nodeScene()->nodeClicked(_nodeId);
@@ -319,6 +413,9 @@ void NodeGraphicsObject::hoverEnterEvent(QGraphicsSceneHoverEvent *event)
 
     _nodeState.setHovered(true);
 
+    // the problems change without the node being updated, they are read when shown
+    setToolTip(_graphModel.nodeProblems(_nodeId));
+
     update();
 
     Q_EMIT nodeScene()->nodeHovered(_nodeId, event->screenPos());
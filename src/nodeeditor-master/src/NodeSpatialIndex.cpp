@@ -0,0 +1,173 @@
+#include "NodeSpatialIndex.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace QtNodes {
+
+NodeSpatialIndex::NodeSpatialIndex(qreal cellSize)
+    : _cellSize(cellSize > 0.0 ? cellSize : 256.0)
+{}
+
+NodeSpatialIndex::CellRange NodeSpatialIndex::cellRange(QRectF const &rect) const
+{
+    QRectF const r = rect.normalized();
+
+    return CellRange{static_cast<int>(std::floor(r.left() / _cellSize)),
+                     static_cast<int>(std::floor(r.top() / _cellSize)),
+                     static_cast<int>(std::floor(r.right() / _cellSize)),
+                     static_cast<int>(std::floor(r.bottom() / _cellSize))};
+}
+
+void NodeSpatialIndex::addToCells(NodeId const nodeId, CellRange const &range)
+{
+    for (int x = range.x0; x <= range.x1; ++x)
+        for (int y = range.y0; y <= range.y1; ++y)
+            _cells[cellKey(x, y)].push_back(nodeId);
+}
+
+void NodeSpatialIndex::removeFromCells(NodeId const nodeId, CellRange const &range)
+{
+    for (int x = range.x0; x <= range.x1; ++x) {
+        for (int y = range.y0; y <= range.y1; ++y) {
+            auto it = _cells.find(cellKey(x, y));
+            if (it == _cells.end())
+                continue;
+
+            auto &ids = it->second;
+            auto pos = std::find(ids.begin(), ids.end(), nodeId);
+            if (pos != ids.end()) {
+                *pos = ids.back();
+                ids.pop_back();
+            }
+
+            if (ids.empty())
+                _cells.erase(it);
+        }
+    }
+}
+
+void NodeSpatialIndex::update(NodeId const nodeId, QRectF const &sceneRect)
+{
+    CellRange const range = cellRange(sceneRect);
+
+    auto it = _rects.find(nodeId);
+    if (it == _rects.end()) {
+        _rects.emplace(nodeId, Entry{sceneRect, range});
+        addToCells(nodeId, range);
+        return;
+    }
+
+    // most moves stay within the same cells
+    if (!(it->second.cells == range)) {
+        removeFromCells(nodeId, it->second.cells);
+        addToCells(nodeId, range);
+        it->second.cells = range;
+    }
+
+    it->second.rect = sceneRect;
+}
+
+void NodeSpatialIndex::remove(NodeId const nodeId)
+{
+    auto it = _rects.find(nodeId);
+    if (it == _rects.end())
+        return;
+
+    removeFromCells(nodeId, it->second.cells);
+    _rects.erase(it);
+}
+
+void NodeSpatialIndex::clear()
+{
+    _rects.clear();
+    _cells.clear();
+}
+
+QRectF NodeSpatialIndex::rect(NodeId const nodeId) const
+{
+    auto it = _rects.find(nodeId);
+
+    return it != _rects.end() ? it->second.rect : QRectF();
+}
+
+std::vector<NodeId> NodeSpatialIndex::nodes() const
+{
+    std::vector<NodeId> result;
+    result.reserve(_rects.size());
+
+    for (auto const &entry : _rects)
+        result.push_back(entry.first);
+
+    return result;
+}
+
+QRectF NodeSpatialIndex::boundingRect() const
+{
+    QRectF result;
+
+    for (auto const &entry : _rects)
+        result = result.united(entry.second.rect);
+
+    return result;
+}
+
+std::vector<NodeId> NodeSpatialIndex::nodesAt(QPointF const &scenePoint) const
+{
+    std::vector<NodeId> result;
+
+    int const x = static_cast<int>(std::floor(scenePoint.x() / _cellSize));
+    int const y = static_cast<int>(std::floor(scenePoint.y() / _cellSize));
+
+    auto it = _cells.find(cellKey(x, y));
+    if (it == _cells.end())
+        return result;
+
+    for (NodeId const nodeId : it->second) {
+        if (_rects.at(nodeId).rect.contains(scenePoint))
+            result.push_back(nodeId);
+    }
+
+    return result;
+}
+
+std::vector<NodeId> NodeSpatialIndex::nodesIn(QRectF const &sceneRect) const
+{
+    std::vector<NodeId> result;
+
+    CellRange const range = cellRange(sceneRect);
+    QRectF const r = sceneRect.normalized();
+
+    // a large query is cheaper as a scan of all nodes
+    std::int64_t const cellCount = (static_cast<std::int64_t>(range.x1) - range.x0 + 1)
+                                   * (static_cast<std::int64_t>(range.y1) - range.y0 + 1);
+    if (cellCount > static_cast<std::int64_t>(_cells.size())) {
+        for (auto const &entry : _rects) {
+            if (entry.second.rect.intersects(r))
+                result.push_back(entry.first);
+        }
+        return result;
+    }
+
+    for (int x = range.x0; x <= range.x1; ++x) {
+        for (int y = range.y0; y <= range.y1; ++y) {
+            auto it = _cells.find(cellKey(x, y));
+            if (it == _cells.end())
+                continue;
+
+            for (NodeId const nodeId : it->second) {
+                Entry const &entry = _rects.at(nodeId);
+
+                // report a node once, from the first cell of the query it covers
+                int const firstX = std::max(range.x0, entry.cells.x0);
+                int const firstY = std::max(range.y0, entry.cells.y0);
+                if (x == firstX && y == firstY && entry.rect.intersects(r))
+                    result.push_back(nodeId);
+            }
+        }
+    }
+
+    return result;
+}
+
+} // namespace QtNodes
@@ -3,13 +3,15 @@
 #include "ConnectionGraphicsObject.hpp"
 #include "NodeGraphicsObject.hpp"
 
+#include <utility>
+
 namespace QtNodes {
 
 NodeState::NodeState(NodeGraphicsObject &ngo)
     : _ngo(ngo)
     , _hovered(false)
     , _resizing(false)
-    , _connectionForReaction{nullptr}
+    , _reactionPort(PortType::None)
 {
     Q_UNUSED(_ngo);
 }
@@ -24,19 +26,28 @@ bool NodeState::resizing() const
     return _resizing;
 }
 
-ConnectionGraphicsObject const *NodeState::connectionForReaction() const
+bool NodeState::setReactingPorts(PortType portType, std::vector<double> scales)
 {
-    return _connectionForReaction.data();
+    if (portType == _reactionPort && scales == _reactionScales)
+        return false;
+
+    _reactionPort = portType;
+    _reactionScales = std::move(scales);
+    return true;
 }
 
-void NodeState::storeConnectionForReaction(ConnectionGraphicsObject const *cgo)
+double NodeState::connectionPointScale(PortType portType, PortIndex portIndex) const
 {
-    _connectionForReaction = cgo;
+    if (portType != _reactionPort || portIndex >= _reactionScales.size())
+        return 1.0;
+
+    return _reactionScales[portIndex];
 }
 
-void NodeState::resetConnectionForReaction()
+void NodeState::resetReactingPorts()
 {
-    _connectionForReaction.clear();
+    _reactionPort = PortType::None;
+    _reactionScales.clear();
 }
 
 } // namespace QtNodes
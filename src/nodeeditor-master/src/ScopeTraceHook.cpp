@@ -0,0 +1,18 @@
+#include "ScopeTraceHook.hpp"
+
+namespace QtNodes {
+
+static std::atomic<ScopeTraceHook> traceHook{nullptr};
+
+void setScopeTraceHook(ScopeTraceHook hook)
+{
+    traceHook.store(hook, std::memory_order_release);
+}
+
+ScopeTraceHook scopeTraceHook()
+{
+    // relaxed is enough on the hot path, a scope missed right after the install does not matter
+    return traceHook.load(std::memory_order_relaxed);
+}
+
+} // namespace QtNodes
@@ -10,6 +10,31 @@ NodeStyle const &StyleCollection::nodeStyle()
     return instance()._nodeStyle;
 }
 
+std::shared_ptr<NodeStyle const> StyleCollection::sharedNodeStyle()
+{
+    auto &collection = instance();
+    if (!collection._sharedNodeStyle)
+        collection._sharedNodeStyle = std::make_shared<NodeStyle const>(collection._nodeStyle);
+
+    return collection._sharedNodeStyle;
+}
+
+QJsonObject const &StyleCollection::nodeStyleJson()
+{
+    auto &collection = instance();
+    if (collection._nodeStyleJsonVersion != collection._nodeStyleVersion) {
+        collection._nodeStyleJson = collection._nodeStyle.toJson();
+        collection._nodeStyleJsonVersion = collection._nodeStyleVersion;
+    }
+
+    return collection._nodeStyleJson;
+}
+
+unsigned int StyleCollection::nodeStyleVersion()
+{
+    return instance()._nodeStyleVersion;
+}
+
 ConnectionStyle const &StyleCollection::connectionStyle()
 {
     return instance()._connectionStyle;
@@ -22,7 +47,10 @@ GraphicsViewStyle const &StyleCollection::flowViewStyle()
 
 void StyleCollection::setNodeStyle(NodeStyle nodeStyle)
 {
-    instance()._nodeStyle = nodeStyle;
+    auto &collection = instance();
+    collection._nodeStyle = nodeStyle;
+    collection._sharedNodeStyle.reset();
+    ++collection._nodeStyleVersion;
 }
 
 void StyleCollection::setConnectionStyle(ConnectionStyle connectionStyle)
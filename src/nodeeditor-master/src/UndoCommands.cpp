@@ -6,119 +6,418 @@
 #include "Definitions.hpp"
 #include "NodeGraphicsObject.hpp"
 
+#include <QtCore/QCborMap>
+#include <QtCore/QCborValue>
+#include <QtCore/QDataStream>
+#include <QtCore/QDebug>
 #include <QtCore/QJsonArray>
 #include <QtCore/QJsonDocument>
 #include <QtCore/QMimeData>
+#include <QtCore/QTemporaryFile>
 #include <QtGui/QClipboard>
 #include <QtWidgets/QApplication>
 #include <QtWidgets/QGraphicsObject>
 
 #include <typeinfo>
+#include <unordered_map>
 
 namespace QtNodes {
 
-static QJsonObject serializeSelectedItems(BasicGraphicsScene *scene)
-{
-    QJsonObject serializedScene;
+namespace {
 
-    auto &graphModel = scene->graphModel();
+/// Binary snapshot of a copy, read by `PasteCommand` of any editor instance.
+QString const kBinaryMimeType = QStringLiteral("application/x-qt-nodes-graph-binary");
 
-    std::unordered_set<NodeId> selectedNodes;
+/// JSON of the snapshot, for other applications and older versions.
+QString const kJsonMimeType = QStringLiteral("application/qt-nodes-graph");
 
-    QJsonArray nodesJsonArray;
+QString const kTextMimeType = QStringLiteral("text/plain");
 
-    for (QGraphicsItem *item : scene->selectedItems()) {
-        if (auto n = qgraphicsitem_cast<NodeGraphicsObject *>(item)) {
-            nodesJsonArray.append(graphModel.saveNode(n->nodeId()));
+constexpr quint32 kClipboardMagic = 0x514E4742; // "QNGB"
+constexpr quint32 kClipboardVersion = 1;
 
-            selectedNodes.insert(n->nodeId());
+/// Clipboard data of a copy, the JSON is rendered when it is first asked for.
+/**
+ * Copying thousands of nodes costs the binary encoding only, the JSON text
+ * is produced if another application pastes it.
+ */
+class GraphMimeData : public QMimeData
+{
+public:
+    explicit GraphMimeData(QByteArray binary)
+        : _binary(std::move(binary))
+    {}
+
+    QStringList formats() const override { return {kBinaryMimeType, kJsonMimeType, kTextMimeType}; }
+
+    bool hasFormat(QString const &mimeType) const override { return formats().contains(mimeType); }
+
+protected:
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    QVariant retrieveData(QString const &mimeType, QMetaType type) const override
+#else
+    QVariant retrieveData(QString const &mimeType, QVariant::Type type) const override
+#endif
+    {
+        if (mimeType == kBinaryMimeType)
+            return _binary;
+
+        if (mimeType != kJsonMimeType && mimeType != kTextMimeType)
+            return QMimeData::retrieveData(mimeType, type);
+
+        if (_json.isEmpty()) {
+            _json = QJsonDocument(SceneSnapshot::fromClipboardData(_binary).toJson()).toJson();
         }
+
+        if (mimeType == kTextMimeType)
+            return QString::fromUtf8(_json);
+
+        return _json;
+    }
+
+private:
+    QByteArray _binary;
+
+    mutable QByteArray _json;
+};
+
+} // namespace
+
+SceneSnapshot::SceneSnapshot() = default;
+
+SceneSnapshot::~SceneSnapshot() = default;
+
+SceneSnapshot::SceneSnapshot(SceneSnapshot &&) = default;
+
+SceneSnapshot &SceneSnapshot::operator=(SceneSnapshot &&) = default;
+
+SceneSnapshot SceneSnapshot::fromJson(QJsonObject const &sceneJson)
+{
+    SceneSnapshot snapshot;
+
+    QJsonArray const nodesJsonArray = sceneJson["nodes"].toArray();
+    snapshot.nodes.reserve(nodesJsonArray.size());
+    for (QJsonValue const node : nodesJsonArray) {
+        snapshot.addNode(node.toObject());
+    }
+
+    QJsonArray const connJsonArray = sceneJson["connections"].toArray();
+    snapshot.connections.reserve(connJsonArray.size());
+    for (QJsonValue const connection : connJsonArray) {
+        snapshot.connections.push_back(QtNodes::fromJson(connection.toObject()));
+    }
+
+    return snapshot;
+}
+
+QJsonObject SceneSnapshot::toJson() const
+{
+    QJsonArray nodesJsonArray;
+    for (Node const &node : nodes) {
+        nodesJsonArray.append(nodeJson(node));
     }
 
     QJsonArray connJsonArray;
+    for (ConnectionId const &cid : connections) {
+        connJsonArray.append(QtNodes::toJson(cid));
+    }
 
-    for (QGraphicsItem *item : scene->selectedItems()) {
-        if (auto c = qgraphicsitem_cast<ConnectionGraphicsObject *>(item)) {
-            auto const &cid = c->connectionId();
+    QJsonObject sceneJson;
+    sceneJson["nodes"] = nodesJsonArray;
+    sceneJson["connections"] = connJsonArray;
 
-            if (selectedNodes.count(cid.outNodeId) > 0 && selectedNodes.count(cid.inNodeId) > 0) {
-                connJsonArray.append(toJson(cid));
-            }
+    return sceneJson;
+}
+
+void SceneSnapshot::addNode(QJsonObject const &nodeJson)
+{
+    Node node;
+    node.id = static_cast<NodeId>(nodeJson["id"].toInt());
+
+    QJsonObject const posJson = nodeJson["position"].toObject();
+    node.position = QPointF(posJson["x"].toDouble(), posJson["y"].toDouble());
+
+    QJsonObject rest = nodeJson;
+    rest.remove("id");
+    rest.remove("position");
+    if (!rest.isEmpty())
+        node.data = QCborValue::fromJsonValue(rest).toCbor();
+
+    nodes.push_back(std::move(node));
+}
+
+QJsonObject SceneSnapshot::nodeJson(Node const &node)
+{
+    QJsonObject obj;
+    if (!node.data.isEmpty())
+        obj = QCborValue::fromCbor(node.data).toMap().toJsonObject();
+
+    obj["id"] = static_cast<qint64>(node.id);
+
+    QJsonObject posJson;
+    posJson["x"] = node.position.x();
+    posJson["y"] = node.position.y();
+    obj["position"] = posJson;
+
+    return obj;
+}
+
+QPointF SceneSnapshot::averagePosition() const
+{
+    QPointF averagePos(0, 0);
+
+    for (Node const &node : nodes) {
+        averagePos += node.position;
+    }
+
+    averagePos /= static_cast<double>(nodes.size());
+
+    return averagePos;
+}
+
+void SceneSnapshot::offset(QPointF const &diff)
+{
+    for (Node &node : nodes) {
+        node.position += diff;
+    }
+}
+
+std::size_t SceneSnapshot::byteSize() const
+{
+    if (_spillFile)
+        return sizeof(SceneSnapshot);
+
+    std::size_t size = sizeof(SceneSnapshot) + nodes.capacity() * sizeof(Node)
+                       + connections.capacity() * sizeof(ConnectionId);
+
+    for (Node const &node : nodes) {
+        size += static_cast<std::size_t>(node.data.capacity());
+    }
+
+    return size;
+}
+
+bool SceneSnapshot::spill()
+{
+    if (_spillFile)
+        return true;
+
+    auto file = std::make_unique<QTemporaryFile>();
+    if (!file->open())
+        return false;
+
+    {
+        QDataStream out(file.get());
+
+        out << static_cast<quint32>(nodes.size());
+        for (Node const &node : nodes) {
+            out << static_cast<quint32>(node.id) << node.position << node.data;
         }
+
+        out << static_cast<quint32>(connections.size());
+        for (ConnectionId const &cid : connections) {
+            out << static_cast<quint32>(cid.outNodeId) << static_cast<quint32>(cid.outPortIndex)
+                << static_cast<quint32>(cid.inNodeId) << static_cast<quint32>(cid.inPortIndex);
+        }
+
+        if (out.status() != QDataStream::Ok)
+            return false;
     }
 
-    serializedScene["nodes"] = nodesJsonArray;
-    serializedScene["connections"] = connJsonArray;
+    file->close();
 
-    return serializedScene;
+    std::vector<Node>().swap(nodes);
+    std::vector<ConnectionId>().swap(connections);
+
+    _spillFile = std::move(file);
+
+    return true;
 }
 
-static void insertSerializedItems(QJsonObject const &json, BasicGraphicsScene *scene)
+void SceneSnapshot::restore()
 {
-    AbstractGraphModel &graphModel = scene->graphModel();
+    if (!_spillFile)
+        return;
 
-    QJsonArray const &nodesJsonArray = json["nodes"].toArray();
+    if (!_spillFile->open()) {
+        qWarning() << "Cannot read undo snapshot" << _spillFile->fileName();
+        return;
+    }
 
-    for (QJsonValue node : nodesJsonArray) {
-        QJsonObject obj = node.toObject();
+    QDataStream in(_spillFile.get());
 
-        graphModel.loadNode(obj);
+    quint32 count = 0;
+    in >> count;
+    nodes.resize(count);
+    for (Node &node : nodes) {
+        quint32 id = 0;
+        in >> id >> node.position >> node.data;
+        node.id = static_cast<NodeId>(id);
+    }
 
-        auto id = obj["id"].toInt();
-        scene->nodeGraphicsObject(id)->setZValue(1.0);
-        scene->nodeGraphicsObject(id)->setSelected(true);
+    in >> count;
+    connections.resize(count);
+    for (ConnectionId &cid : connections) {
+        quint32 outNodeId = 0, outPortIndex = 0, inNodeId = 0, inPortIndex = 0;
+        in >> outNodeId >> outPortIndex >> inNodeId >> inPortIndex;
+        cid = ConnectionId{outNodeId, outPortIndex, inNodeId, inPortIndex};
     }
 
-    QJsonArray const &connJsonArray = json["connections"].toArray();
+    if (in.status() != QDataStream::Ok)
+        qWarning() << "Undo snapshot" << _spillFile->fileName() << "is corrupted";
+
+    _spillFile.reset();
+}
 
-    for (QJsonValue connection : connJsonArray) {
-        QJsonObject connJson = connection.toObject();
+QByteArray SceneSnapshot::toClipboardData() const
+{
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    // read by other instances, possibly built with another Qt
+    out.setVersion(QDataStream::Qt_5_11);
 
-        ConnectionId connId = fromJson(connJson);
+    out << kClipboardMagic << kClipboardVersion;
 
-        // Restore the connection
-        graphModel.addConnection(connId);
+    std::unordered_map<NodeId, quint32> nodeIndices;
+    nodeIndices.reserve(nodes.size());
 
-        scene->connectionGraphicsObject(connId)->setSelected(true);
+    out << static_cast<quint32>(nodes.size());
+    for (Node const &node : nodes) {
+        nodeIndices.emplace(node.id, static_cast<quint32>(nodeIndices.size()));
+        out << static_cast<quint32>(node.id) << node.position << node.data;
     }
+
+    std::vector<ConnectionId const *> inner;
+    inner.reserve(connections.size());
+    for (ConnectionId const &cid : connections) {
+        if (nodeIndices.count(cid.outNodeId) > 0 && nodeIndices.count(cid.inNodeId) > 0)
+            inner.push_back(&cid);
+    }
+
+    out << static_cast<quint32>(inner.size());
+    for (ConnectionId const *cid : inner) {
+        out << nodeIndices[cid->outNodeId] << static_cast<quint32>(cid->outPortIndex)
+            << nodeIndices[cid->inNodeId] << static_cast<quint32>(cid->inPortIndex);
+    }
+
+    return data;
 }
 
-static void deleteSerializedItems(QJsonObject &sceneJson, AbstractGraphModel &graphModel)
+SceneSnapshot SceneSnapshot::fromClipboardData(QByteArray const &data,
+                                               std::function<NodeId()> const &newNodeId)
 {
-    QJsonArray connectionJsonArray = sceneJson["connections"].toArray();
+    SceneSnapshot snapshot;
+
+    QDataStream in(data);
+    in.setVersion(QDataStream::Qt_5_11);
+
+    quint32 magic = 0, version = 0;
+    in >> magic >> version;
+    if (magic != kClipboardMagic || version != kClipboardVersion)
+        return snapshot;
+
+    quint32 count = 0;
+    in >> count;
+    // every node takes more than a byte, a corrupted count does not allocate
+    if (count > static_cast<quint32>(data.size()))
+        return snapshot;
+
+    snapshot.nodes.resize(count);
+    for (Node &node : snapshot.nodes) {
+        quint32 id = 0;
+        in >> id >> node.position >> node.data;
+        node.id = newNodeId ? newNodeId() : static_cast<NodeId>(id);
+    }
 
-    for (QJsonValueRef connection : connectionJsonArray) {
-        QJsonObject connJson = connection.toObject();
+    in >> count;
+    if (count > static_cast<quint32>(data.size()))
+        return SceneSnapshot();
 
-        ConnectionId connId = fromJson(connJson);
+    snapshot.connections.reserve(count);
+    for (quint32 i = 0; i < count; ++i) {
+        quint32 outIndex = 0, outPortIndex = 0, inIndex = 0, inPortIndex = 0;
+        in >> outIndex >> outPortIndex >> inIndex >> inPortIndex;
 
-        graphModel.deleteConnection(connId);
+        if (outIndex >= snapshot.nodes.size() || inIndex >= snapshot.nodes.size())
+            return SceneSnapshot();
+
+        snapshot.connections.push_back(ConnectionId{snapshot.nodes[outIndex].id,
+                                                    outPortIndex,
+                                                    snapshot.nodes[inIndex].id,
+                                                    inPortIndex});
+    }
+
+    if (in.status() != QDataStream::Ok)
+        return SceneSnapshot();
+
+    return snapshot;
+}
+
+//-------------------------------------
+
+static SceneSnapshot serializeSelectedItems(BasicGraphicsScene *scene)
+{
+    SceneSnapshot snapshot;
+
+    auto &graphModel = scene->graphModel();
+
+    std::unordered_set<NodeId> selectedNodes;
+
+    QList<QGraphicsItem *> const items = scene->selectedItems();
+
+    for (QGraphicsItem *item : items) {
+        if (auto n = qgraphicsitem_cast<NodeGraphicsObject *>(item)) {
+            snapshot.addNode(graphModel.saveNode(n->nodeId()));
+
+            selectedNodes.insert(n->nodeId());
+        }
     }
 
-    QJsonArray nodesJsonArray = sceneJson["nodes"].toArray();
+    for (QGraphicsItem *item : items) {
+        if (auto c = qgraphicsitem_cast<ConnectionGraphicsObject *>(item)) {
+            auto const &cid = c->connectionId();
 
-    for (QJsonValueRef node : nodesJsonArray) {
-        QJsonObject nodeJson = node.toObject();
-        graphModel.deleteNode(nodeJson["id"].toInt());
+            if (selectedNodes.count(cid.outNodeId) > 0 && selectedNodes.count(cid.inNodeId) > 0) {
+                snapshot.connections.push_back(cid);
+            }
+        }
     }
+
+    return snapshot;
 }
 
-static QPointF computeAverageNodePosition(QJsonObject const &sceneJson)
+static void insertSerializedItems(SceneSnapshot const &snapshot, BasicGraphicsScene *scene)
 {
-    QPointF averagePos(0, 0);
+    AbstractGraphModel &graphModel = scene->graphModel();
 
-    QJsonArray nodesJsonArray = sceneJson["nodes"].toArray();
+    for (SceneSnapshot::Node const &node : snapshot.nodes) {
+        graphModel.loadNode(SceneSnapshot::nodeJson(node));
+
+        // a virtualized scene has no object for a node pasted outside the view
+        if (auto ngo = scene->nodeGraphicsObject(node.id)) {
+            ngo->setZValue(1.0);
+            ngo->setSelected(true);
+        }
+    }
 
-    for (QJsonValueRef node : nodesJsonArray) {
-        QJsonObject nodeJson = node.toObject();
+    for (ConnectionId const &connId : snapshot.connections) {
+        // Restore the connection
+        graphModel.addConnection(connId);
 
-        averagePos += QPointF(nodeJson["position"].toObject()["x"].toDouble(),
-                              nodeJson["position"].toObject()["y"].toDouble());
+        if (auto cgo = scene->connectionGraphicsObject(connId))
+            cgo->setSelected(true);
     }
+}
 
-    averagePos /= static_cast<double>(nodesJsonArray.size());
+static void deleteSerializedItems(SceneSnapshot const &snapshot, AbstractGraphModel &graphModel)
+{
+    for (ConnectionId const &connId : snapshot.connections) {
+        graphModel.deleteConnection(connId);
+    }
 
-    return averagePos;
+    for (SceneSnapshot::Node const &node : snapshot.nodes) {
+        graphModel.deleteNode(node.id);
+    }
 }
 
 //-------------------------------------
@@ -127,7 +426,6 @@ CreateCommand::CreateCommand(BasicGraphicsScene *scene,
                              QString const name,
                              QPointF const &mouseScenePos)
     : _scene(scene)
-    , _sceneJson(QJsonObject())
 {
     _nodeId = _scene->graphModel().addNode(name);
     if (_nodeId != InvalidNodeId) {
@@ -139,19 +437,30 @@ CreateCommand::CreateCommand(BasicGraphicsScene *scene,
 
 void CreateCommand::undo()
 {
-    QJsonArray nodesJsonArray;
-    nodesJsonArray.append(_scene->graphModel().saveNode(_nodeId));
-    _sceneJson["nodes"] = nodesJsonArray;
+    _snapshot = SceneSnapshot();
+    _snapshot.addNode(_scene->graphModel().saveNode(_nodeId));
 
     _scene->graphModel().deleteNode(_nodeId);
 }
 
 void CreateCommand::redo()
 {
-    if (_sceneJson.empty() || _sceneJson["nodes"].toArray().empty())
+    _snapshot.restore();
+
+    if (_snapshot.nodes.empty())
         return;
 
-    insertSerializedItems(_sceneJson, _scene);
+    insertSerializedItems(_snapshot, _scene);
+}
+
+std::size_t CreateCommand::byteSize() const
+{
+    return sizeof(CreateCommand) + _snapshot.byteSize();
+}
+
+void CreateCommand::spill()
+{
+    _snapshot.spill();
 }
 
 //-------------------------------------
@@ -161,96 +470,73 @@ DeleteCommand::DeleteCommand(BasicGraphicsScene *scene)
 {
     auto &graphModel = _scene->graphModel();
 
-    QJsonArray connJsonArray;
+    QList<QGraphicsItem *> const items = _scene->selectedItems();
+
     // Delete the selected connections first, ensuring that they won't be
     // automatically deleted when selected nodes are deleted (deleting a
     // node deletes some connections as well)
-    for (QGraphicsItem *item : _scene->selectedItems()) {
+    for (QGraphicsItem *item : items) {
         if (auto c = qgraphicsitem_cast<ConnectionGraphicsObject *>(item)) {
-            auto const &cid = c->connectionId();
-
-            connJsonArray.append(toJson(cid));
+            _snapshot.connections.push_back(c->connectionId());
         }
     }
 
-    QJsonArray nodesJsonArray;
     // Delete the nodes; this will delete many of the connections.
     // Selected connections were already deleted prior to this loop,
-    for (QGraphicsItem *item : _scene->selectedItems()) {
+    for (QGraphicsItem *item : items) {
         if (auto n = qgraphicsitem_cast<NodeGraphicsObject *>(item)) {
             // saving connections attached to the selected nodes
             for (auto const &cid : graphModel.allConnectionIds(n->nodeId())) {
-                connJsonArray.append(toJson(cid));
+                _snapshot.connections.push_back(cid);
             }
 
-            nodesJsonArray.append(graphModel.saveNode(n->nodeId()));
+            _snapshot.addNode(graphModel.saveNode(n->nodeId()));
         }
     }
 
     // If nothing is deleted, cancel this operation
-    if (connJsonArray.isEmpty() && nodesJsonArray.isEmpty())
+    if (_snapshot.empty())
         setObsolete(true);
-
-    _sceneJson["nodes"] = nodesJsonArray;
-    _sceneJson["connections"] = connJsonArray;
 }
 
 void DeleteCommand::undo()
 {
-    insertSerializedItems(_sceneJson, _scene);
+    _snapshot.restore();
+
+    insertSerializedItems(_snapshot, _scene);
 }
 
 void DeleteCommand::redo()
 {
-    deleteSerializedItems(_sceneJson, _scene->graphModel());
-}
+    _snapshot.restore();
 
-//-------------------------------------
+    deleteSerializedItems(_snapshot, _scene->graphModel());
+}
 
-void offsetNodeGroup(QJsonObject &sceneJson, QPointF const &diff)
+std::size_t DeleteCommand::byteSize() const
 {
-    QJsonArray nodesJsonArray = sceneJson["nodes"].toArray();
-
-    QJsonArray newNodesJsonArray;
-    for (QJsonValueRef node : nodesJsonArray) {
-        QJsonObject obj = node.toObject();
-
-        QPointF oldPos(obj["position"].toObject()["x"].toDouble(),
-                       obj["position"].toObject()["y"].toDouble());
-
-        oldPos += diff;
-
-        QJsonObject posJson;
-        posJson["x"] = oldPos.x();
-        posJson["y"] = oldPos.y();
-        obj["position"] = posJson;
-
-        newNodesJsonArray.append(obj);
-    }
+    return sizeof(DeleteCommand) + _snapshot.byteSize();
+}
 
-    sceneJson["nodes"] = newNodesJsonArray;
+void DeleteCommand::spill()
+{
+    _snapshot.spill();
 }
 
 //-------------------------------------
 
 CopyCommand::CopyCommand(BasicGraphicsScene *scene)
 {
-    QJsonObject sceneJson = serializeSelectedItems(scene);
+    SceneSnapshot const snapshot = serializeSelectedItems(scene);
 
-    if (sceneJson.empty() || sceneJson["nodes"].toArray().empty()) {
+    if (snapshot.nodes.empty()) {
         setObsolete(true);
         return;
     }
 
     QClipboard *clipboard = QApplication::clipboard();
 
-    QByteArray const data = QJsonDocument(sceneJson).toJson();
-
-    QMimeData *mimeData = new QMimeData();
-    mimeData->setData("application/qt-nodes-graph", data);
-    mimeData->setText(data);
-
-    clipboard->setMimeData(mimeData);
+    clipboard->setMimeData(new GraphMimeData(snapshot.toClipboardData()));
 
     // Copy command does not have any effective redo/undo operations.
     // It copies the data to the clipboard and could be immediately removed
@@ -264,38 +550,37 @@ PasteCommand::PasteCommand(BasicGraphicsScene *scene, QPointF const &mouseSceneP
     : _scene(scene)
     , _mouseScenePos(mouseScenePos)
 {
-    _newSceneJson = takeSceneJsonFromClipboard();
+    _newSnapshot = takeSnapshotFromClipboard();
 
-    if (_newSceneJson.empty() || _newSceneJson["nodes"].toArray().empty()) {
+    if (_newSnapshot.nodes.empty()) {
         setObsolete(true);
         return;
     }
 
-    _newSceneJson = makeNewNodeIdsInScene(_newSceneJson);
-
-    QPointF averagePos = computeAverageNodePosition(_newSceneJson);
-
-    offsetNodeGroup(_newSceneJson, _mouseScenePos - averagePos);
+    _newSnapshot.offset(_mouseScenePos - _newSnapshot.averagePosition());
 }
 
 void PasteCommand::undo()
 {
-    deleteSerializedItems(_newSceneJson, _scene->graphModel());
+    _newSnapshot.restore();
+
+    deleteSerializedItems(_newSnapshot, _scene->graphModel());
 }
 
 void PasteCommand::redo()
 {
     _scene->clearSelection();
 
+    _newSnapshot.restore();
+
     // Ignore if pasted in content does not generate nodes.
     try {
-        insertSerializedItems(_newSceneJson, _scene);
+        insertSerializedItems(_newSnapshot, _scene);
     } catch (...) {
         // If the paste does not work, delete all selected nodes and connections
         // `deleteNode(...)` implicitly removed connections
         auto &graphModel = _scene->graphModel();
 
-        QJsonArray nodesJsonArray;
         for (QGraphicsItem *item : _scene->selectedItems()) {
             if (auto n = qgraphicsitem_cast<NodeGraphicsObject *>(item)) {
                 graphModel.deleteNode(n->nodeId());
@@ -306,14 +591,47 @@ void PasteCommand::redo()
     }
 }
 
+std::size_t PasteCommand::byteSize() const
+{
+    return sizeof(PasteCommand) + _newSnapshot.byteSize();
+}
+
+void PasteCommand::spill()
+{
+    _newSnapshot.spill();
+}
+
+SceneSnapshot PasteCommand::takeSnapshotFromClipboard()
+{
+    QClipboard const *clipboard = QApplication::clipboard();
+    QMimeData const *mimeData = clipboard->mimeData();
+
+    if (mimeData && mimeData->hasFormat(kBinaryMimeType)) {
+        AbstractGraphModel &graphModel = _scene->graphModel();
+
+        return SceneSnapshot::fromClipboardData(mimeData->data(kBinaryMimeType),
+                                                [&graphModel]() { return graphModel.newNodeId(); });
+    }
+
+    // the JSON of another application gets new ids after it is parsed
+    SceneSnapshot snapshot = SceneSnapshot::fromJson(takeSceneJsonFromClipboard());
+
+    makeNewNodeIdsInScene(snapshot);
+
+    return snapshot;
+}
+
 QJsonObject PasteCommand::takeSceneJsonFromClipboard()
 {
     QClipboard const *clipboard = QApplication::clipboard();
     QMimeData const *mimeData = clipboard->mimeData();
 
     QJsonDocument json;
-    if (mimeData->hasFormat("application/qt-nodes-graph")) {
-        json = QJsonDocument::fromJson(mimeData->data("application/qt-nodes-graph"));
+    if (!mimeData)
+        return json.object();
+
+    if (mimeData->hasFormat(kJsonMimeType)) {
+        json = QJsonDocument::fromJson(mimeData->data(kJsonMimeType));
     } else if (mimeData->hasText()) {
         json = QJsonDocument::fromJson(mimeData->text().toUtf8());
     }
@@ -321,52 +639,27 @@ QJsonObject PasteCommand::takeSceneJsonFromClipboard()
     return json.object();
 }
 
-QJsonObject PasteCommand::makeNewNodeIdsInScene(QJsonObject const &sceneJson)
+void PasteCommand::makeNewNodeIdsInScene(SceneSnapshot &snapshot)
 {
     AbstractGraphModel &graphModel = _scene->graphModel();
 
     std::unordered_map<NodeId, NodeId> mapNodeIds;
+    mapNodeIds.reserve(snapshot.nodes.size());
 
-    QJsonArray nodesJsonArray = sceneJson["nodes"].toArray();
-
-    QJsonArray newNodesJsonArray;
-    for (QJsonValueRef node : nodesJsonArray) {
-        QJsonObject nodeJson = node.toObject();
-
-        NodeId oldNodeId = nodeJson["id"].toInt();
-
+    for (SceneSnapshot::Node &node : snapshot.nodes) {
         NodeId newNodeId = graphModel.newNodeId();
 
-        mapNodeIds[oldNodeId] = newNodeId;
-
-        // Replace NodeId in json
-        nodeJson["id"] = static_cast<qint64>(newNodeId);
+        mapNodeIds[node.id] = newNodeId;
 
-        newNodesJsonArray.append(nodeJson);
+        node.id = newNodeId;
     }
 
-    QJsonArray connectionJsonArray = sceneJson["connections"].toArray();
-
-    QJsonArray newConnJsonArray;
-    for (QJsonValueRef connection : connectionJsonArray) {
-        QJsonObject connJson = connection.toObject();
-
-        ConnectionId connId = fromJson(connJson);
-
-        ConnectionId newConnId{mapNodeIds[connId.outNodeId],
-                               connId.outPortIndex,
-                               mapNodeIds[connId.inNodeId],
-                               connId.inPortIndex};
-
-        newConnJsonArray.append(toJson(newConnId));
+    for (ConnectionId &connId : snapshot.connections) {
+        connId = ConnectionId{mapNodeIds[connId.outNodeId],
+                              connId.outPortIndex,
+                              mapNodeIds[connId.inNodeId],
+                              connId.inPortIndex};
     }
-
-    QJsonObject newSceneJson;
-
-    newSceneJson["nodes"] = newNodesJsonArray;
-    newSceneJson["connections"] = newConnJsonArray;
-
-    return newSceneJson;
 }
 
 //-------------------------------------
@@ -443,6 +736,13 @@ void MoveNodeCommand::redo()
     }
 }
 
+std::size_t MoveNodeCommand::byteSize() const
+{
+    // hash set buckets plus one node per selected id
+    return sizeof(MoveNodeCommand) + _selectedNodes.bucket_count() * sizeof(void *)
+           + _selectedNodes.size() * (sizeof(NodeId) + 2 * sizeof(void *));
+}
+
 int MoveNodeCommand::id() const
 {
     return static_cast<int>(typeid(MoveNodeCommand).hash_code());
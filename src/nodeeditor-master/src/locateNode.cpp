@@ -5,6 +5,7 @@
 #include <QtCore/QList>
 #include <QtWidgets/QGraphicsScene>
 
+#include "BasicGraphicsScene.hpp"
 #include "NodeGraphicsObject.hpp"
 
 namespace QtNodes {
@@ -13,6 +14,10 @@ NodeGraphicsObject *locateNodeAt(QPointF scenePoint,
                                  QGraphicsScene &scene,
                                  QTransform const &viewTransform)
 {
+    // node scenes keep a spatial index of their nodes
+    if (auto *basicScene = qobject_cast<BasicGraphicsScene *>(&scene))
+        return basicScene->nodeAt(scenePoint);
+
     // items under cursor
     QList<QGraphicsItem *> items = scene.items(scenePoint,
                                                Qt::IntersectsItemShape,
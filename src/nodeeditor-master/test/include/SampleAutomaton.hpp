@@ -0,0 +1,82 @@
+#pragma once
+
+#include "spec_parser/automaton-parser.hpp"
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/// A saved file with `states` states in a ring, two transitions each.
+/// `reversedStates` writes the same automaton with the STATE blocks in reverse.
+inline std::string fsmText(int states, bool reversedStates = false)
+{
+    std::ostringstream out;
+    for (int i = 0; i < states; ++i)
+        out << "#s" << i << ';' << i * 10 << ';' << -i << ";1;2\n";
+
+    out << "AUTOMATON ring\n"
+        << "    DESCRIPTION \"A ring of states\"\n"
+        << "    START s0\n"
+        << "    FINISH [s" << states - 1 << ", s0]\n"
+        << "    VARS\n"
+        << "        int k = 0\n"
+        << "        double d = 0.5\n"
+        << "        string t = hello\n"
+        << "    END\n\n";
+
+    for (int k = 0; k < states; ++k) {
+        int const i = reversedStates ? states - 1 - k : k;
+        out << "STATE s" << i << '\n'
+            << "    ACTION\n"
+            << "        # comment\n"
+            << "        k = k + " << i << '\n'
+            << "        print(k)\n"
+            << "    END\n\n";
+    }
+    for (int i = 0; i < states; ++i) {
+        out << "TRANSITION s" << i << " -> s" << (i + 1) % states << '\n'
+            << "    CONDITION k > " << i << '\n'
+            << "    DELAY " << i % 7 << "\n\n";
+        out << "TRANSITION s" << i << " -> s0\n"
+            << "    CONDITION \n"
+            << "    DELAY 0\n\n";
+    }
+    out << "END\n";
+    return out.str();
+}
+
+/// Everything the parser reads, states and final states by name.
+inline std::string describe(Automaton const &automaton, std::vector<StateInfo> const &statesInfo)
+{
+    std::ostringstream out;
+    out << automaton.getName() << '|' << automaton.getDescription() << '|' << automaton.getStartName() << '\n';
+
+    std::vector<Symbol> finals(automaton.getFinalStates().begin(), automaton.getFinalStates().end());
+    std::sort(finals.begin(), finals.end());
+    for (Symbol const &name : finals)
+        out << "final " << name << '\n';
+
+    for (auto const &var : automaton.getVariables())
+        out << Automaton::varDataTypeAsString(var.type) << ' ' << var.name << " = " << var.value << '\n';
+
+    std::vector<Symbol> states;
+    for (auto const &state : automaton.getStates())
+        states.push_back(state.first);
+    std::sort(states.begin(), states.end());
+    for (Symbol const &name : states)
+        out << "state " << name << " {" << automaton.getStateAction(name) << "}\n";
+
+    // the transitions of a state keep their order, the states go by name
+    std::vector<Transition> transitions(automaton.getTransitions().begin(), automaton.getTransitions().end());
+    std::stable_sort(transitions.begin(), transitions.end(), [](Transition const &a, Transition const &b) {
+        return a.fromState < b.fromState;
+    });
+    for (Transition const &t : transitions)
+        out << t.fromState << " -> " << t.toState << " [" << t.condition << "] " << t.delay << '\n';
+
+    for (StateInfo const &info : statesInfo)
+        out << '#' << info.name << ';' << info.posX << ';' << info.posY << ';' << info.inPortCount << ';'
+            << info.outPortCount << '\n';
+    return out.str();
+}
@@ -0,0 +1,137 @@
+#include "SampleAutomaton.hpp"
+#include "load/fsm-snapshot.hpp"
+#include "load/graph-loader.hpp"
+#include "spec_parser/automaton-binary.hpp"
+
+#include <catch2/catch.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+std::string readBytes(std::string const &filename)
+{
+    std::ifstream file(filename, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+/// Parses `text` and saves it as `filename`, returns the parsed automaton described.
+std::string saveBinary(std::string const &text, std::string const &filename)
+{
+    Automaton automaton;
+    std::vector<StateInfo> statesInfo;
+    AutomatonParser::FromBuffer(text, automaton, &statesInfo, 1);
+    REQUIRE(AutomatonBinary::ToFile(filename, automaton, &statesInfo));
+    return describe(automaton, statesInfo);
+}
+
+/// The snapshot of a loaded graph, as icp-cli takes it to convert a file.
+FsmSnapshot snapshotOf(LoadedGraph const &graph)
+{
+    FsmSnapshot snapshot;
+    snapshot.name = QString::fromStdString(graph.name);
+    snapshot.description = QString::fromStdString(graph.description);
+    snapshot.startNode = graph.startNode;
+    snapshot.variables = graph.variables;
+    snapshot.source = graph.source;
+    for (LoadedNode const &loaded : graph.nodes) {
+        SnapshotNode node;
+        node.name = QString::fromStdString(loaded.name);
+        node.posX = loaded.posX;
+        node.posY = loaded.posY;
+        node.inPortCount = loaded.inPortCount;
+        node.outPortCount = loaded.outPortCount;
+        node.isFinal = loaded.isFinal;
+        node.lazyAction = loaded.actionRef;
+        node.lazyActionSet = true;
+        snapshot.nodes.push_back(node);
+    }
+    for (LoadedConnection const &loaded : graph.connections) {
+        SnapshotConnection connection;
+        connection.outNode = loaded.outNode;
+        connection.inNode = loaded.inNode;
+        connection.lazyCondition = loaded.conditionRef;
+        connection.lazyConditionSet = true;
+        connection.delay = loaded.delay;
+        snapshot.connections.push_back(connection);
+    }
+    return snapshot;
+}
+} // namespace
+
+TEST_CASE("AutomatonBinary reads back the automaton it saved", "[binary]")
+{
+    std::string const filename = "test_icp_roundtrip.fsmb";
+    std::string const saved = saveBinary(fsmText(50), filename);
+    CHECK(AutomatonBinary::IsBinaryFile(filename));
+
+    Automaton automaton;
+    std::vector<StateInfo> statesInfo;
+    bool const loaded = AutomatonBinary::FromFile(filename, automaton, &statesInfo);
+    std::remove(filename.c_str());
+
+    REQUIRE(loaded);
+    CHECK(describe(automaton, statesInfo) == saved);
+}
+
+TEST_CASE("AutomatonBinary tells a text file from a binary one", "[binary]")
+{
+    std::string const filename = "test_icp_text.fsm";
+    {
+        std::ofstream file(filename, std::ios::binary);
+        file << fsmText(3);
+    }
+
+    Automaton automaton;
+    CHECK_FALSE(AutomatonBinary::IsBinaryFile(filename));
+    CHECK_FALSE(AutomatonBinary::FromFile(filename, automaton));
+    std::remove(filename.c_str());
+}
+
+TEST_CASE("AutomatonBinary saves the same bytes whatever the order of the states", "[binary]")
+{
+    std::string const forward = "test_icp_forward.fsmb";
+    std::string const reversed = "test_icp_reversed.fsmb";
+    saveBinary(fsmText(20), forward);
+    saveBinary(fsmText(20, true), reversed);
+
+    std::string const forwardBytes = readBytes(forward);
+    std::string const reversedBytes = readBytes(reversed);
+    std::remove(forward.c_str());
+    std::remove(reversed.c_str());
+
+    REQUIRE_FALSE(forwardBytes.empty());
+    CHECK(forwardBytes == reversedBytes);
+}
+
+TEST_CASE("A .fsmb file is converted to the .fsm text of its source", "[binary]")
+{
+    std::string const source = "test_icp_convert_source.fsm";
+    std::string const binary = "test_icp_convert.fsmb";
+    std::string const fromSource = "test_icp_convert_a.fsm";
+    std::string const fromBinary = "test_icp_convert_b.fsm";
+    {
+        std::ofstream file(source, std::ios::binary);
+        file << fsmText(30);
+    }
+    saveBinary(fsmText(30), binary);
+
+    // both are loaded the way the editor and icp-cli load a file
+    for (auto const &conversion : {std::make_pair(source, fromSource), std::make_pair(binary, fromBinary)}) {
+        LoadedGraph graph;
+        loadGraph(conversion.first, graph, nullptr, LoadProgress(), true);
+        REQUIRE(graph.startNode >= 0);
+        REQUIRE(writeFsmText(snapshotOf(graph), conversion.second));
+    }
+
+    std::string const sourceText = readBytes(fromSource);
+    std::string const binaryText = readBytes(fromBinary);
+    for (std::string const &filename : {source, binary, fromSource, fromBinary})
+        std::remove(filename.c_str());
+
+    REQUIRE_FALSE(sourceText.empty());
+    CHECK(binaryText == sourceText);
+}
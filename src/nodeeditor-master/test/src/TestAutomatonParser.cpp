@@ -0,0 +1,82 @@
+#include "SampleAutomaton.hpp"
+
+#include <catch2/catch.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+std::string parse(std::string const &text, unsigned threadCount)
+{
+    Automaton automaton;
+    std::vector<StateInfo> statesInfo;
+    AutomatonParser::FromBuffer(text, automaton, &statesInfo, threadCount);
+    return describe(automaton, statesInfo);
+}
+} // namespace
+
+TEST_CASE("AutomatonParser reads every block of a file", "[parser]")
+{
+    Automaton automaton;
+    std::vector<StateInfo> statesInfo;
+    AutomatonParser::FromBuffer(fsmText(3), automaton, &statesInfo, 1);
+
+    CHECK(automaton.getName() == "ring");
+    CHECK(automaton.getDescription() == "\"A ring of states\"");
+    CHECK(automaton.getStartName().str() == "s0");
+    CHECK(automaton.isFinalState(std::string("s2")));
+    CHECK_FALSE(automaton.isFinalState(std::string("s1")));
+    CHECK(automaton.getStates().size() == 3);
+    CHECK(automaton.getStateAction(std::string("s1")) == "        k = k + 1\n        print(k)\n");
+    REQUIRE(automaton.getVariables().size() == 3);
+    CHECK(automaton.getVariables()[1].name == "d");
+    CHECK(automaton.getVariables()[1].value == "0.5");
+
+    REQUIRE(automaton.getTransitions().size() == 6);
+    Transition const &t = automaton.getTransitions()[2];
+    CHECK(t.fromState.str() == "s1");
+    CHECK(t.toState.str() == "s2");
+    CHECK(t.condition == "k > 1");
+    CHECK(t.delay == 1);
+
+    REQUIRE(statesInfo.size() == 3);
+    CHECK(statesInfo[2].name == "s2");
+    CHECK(statesInfo[2].posX == 20);
+    CHECK(statesInfo[2].posY == -2);
+    CHECK(statesInfo[2].outPortCount == 2);
+}
+
+TEST_CASE("AutomatonParser gives the same automaton sequentially and in parallel", "[parser]")
+{
+    std::string const text = fsmText(2000);
+    std::string const sequential = parse(text, 1);
+
+    for (unsigned threadCount : {2u, 3u, 8u, 64u}) {
+        INFO(threadCount << " threads");
+        CHECK(parse(text, threadCount) == sequential);
+    }
+
+    // large enough to be split by default
+    std::string const large = fsmText(20000);
+    REQUIRE(large.size() > AutomatonParser::ParallelThreshold);
+    CHECK(parse(large, 0) == parse(large, 1));
+}
+
+TEST_CASE("AutomatonParser reads a file like its buffer", "[parser]")
+{
+    std::string const text = fsmText(50);
+    std::string const filename = "test_icp_parser.fsm";
+    {
+        std::ofstream file(filename, std::ios::binary);
+        file << text;
+    }
+
+    Automaton automaton;
+    std::vector<StateInfo> statesInfo;
+    AutomatonParser::FromFile(filename, automaton, &statesInfo);
+    std::remove(filename.c_str());
+
+    CHECK(describe(automaton, statesInfo) == parse(text, 1));
+}
@@ -0,0 +1,77 @@
+#include "DynamicPortsModel.hpp"
+
+#include "ApplicationSetup.hpp"
+
+#include <catch2/catch.hpp>
+
+#include <vector>
+
+TEST_CASE("DynamicPortsModel keeps the transition of a shifted connection", "[model]")
+{
+    auto app = applicationSetup();
+
+    DynamicPortsModel model;
+    NodeId const from = model.addNode();
+    NodeId const to = model.addNode();
+    for (int i = 0; i < 3; ++i)
+        model.addPort(from, PortType::Out, 0);
+    model.addPort(to, PortType::In, 0);
+
+    for (PortIndex port = 0; port < 3; ++port) {
+        ConnectionId const connection{from, port, to, 0};
+        model.addConnection(connection);
+        model.SetConnectionCode(connection, QString("x > %1").arg(port));
+        model.SetConnectionDelay(connection, 10 * (port + 1));
+    }
+
+    // ConnectionId is no metatype, the signals are recorded by hand
+    std::vector<ConnectionId> deleted;
+    std::vector<ConnectionId> reindexed;
+    QObject::connect(&model, &DynamicPortsModel::connectionDeleted, [&](ConnectionId const id) {
+        deleted.push_back(id);
+    });
+    QObject::connect(&model, &DynamicPortsModel::connectionReindexed, [&](ConnectionId const, ConnectionId const id) {
+        reindexed.push_back(id);
+    });
+
+    SECTION("a port is inserted before them")
+    {
+        model.addPort(from, PortType::Out, 1);
+
+        CHECK(deleted.empty());
+        CHECK(reindexed.size() == 2);
+        CHECK(model.connections(from, PortType::Out, 1).empty());
+
+        ConnectionId const first{from, 0, to, 0};
+        ConnectionId const second{from, 2, to, 0};
+        ConnectionId const third{from, 3, to, 0};
+        REQUIRE(model.connectionExists(first));
+        REQUIRE(model.connectionExists(second));
+        REQUIRE(model.connectionExists(third));
+        CHECK(model.GetConnectionCode(first) == "x > 0");
+        CHECK(model.GetConnectionDelay(first) == 10);
+        CHECK(model.GetConnectionCode(second) == "x > 1");
+        CHECK(model.GetConnectionDelay(second) == 20);
+        CHECK(model.GetConnectionCode(third) == "x > 2");
+        CHECK(model.GetConnectionDelay(third) == 30);
+    }
+    SECTION("the port of one of them is removed")
+    {
+        model.removePort(from, PortType::Out, 0);
+
+        // only the connection of the removed port is deleted
+        REQUIRE(deleted.size() == 1);
+        CHECK(deleted[0] == ConnectionId{from, 0, to, 0});
+        CHECK(reindexed.size() == 2);
+        CHECK_FALSE(model.connectionExists(ConnectionId{from, 2, to, 0}));
+
+        ConnectionId const second{from, 0, to, 0};
+        ConnectionId const third{from, 1, to, 0};
+        REQUIRE(model.connectionExists(second));
+        REQUIRE(model.connectionExists(third));
+        CHECK(model.GetConnectionCode(second) == "x > 1");
+        CHECK(model.GetConnectionDelay(second) == 20);
+        CHECK(model.GetConnectionCode(third) == "x > 2");
+        CHECK(model.GetConnectionDelay(third) == 30);
+    }
+}
@@ -0,0 +1,218 @@
+#include "engine/fsm-expression.hpp"
+
+#include <catch2/catch.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace {
+int64_t const Min = std::numeric_limits<int64_t>::min();
+int64_t const Max = std::numeric_limits<int64_t>::max();
+
+FsmSlotMap const Slots{{"a", 0}, {"b", 1}, {"s", 2}};
+
+FsmValue evaluate(std::string const &source,
+                  std::vector<FsmValue> const &vars = {FsmValue(), FsmValue(), FsmValue()})
+{
+    return FsmExpression::compile(source, Slots).evaluate(vars);
+}
+
+FsmValue evaluate(std::string const &source, int64_t a, int64_t b)
+{
+    return evaluate(source, {FsmValue(a), FsmValue(b), FsmValue()});
+}
+
+std::string evaluateError(std::string const &source)
+{
+    try {
+        evaluate(source);
+    } catch (ExpressionError const &e) {
+        return e.what();
+    }
+    return std::string();
+}
+} // namespace
+
+TEST_CASE("Expression arithmetic follows Python", "[engine]")
+{
+    SECTION("floor division and modulo round towards negative infinity")
+    {
+        CHECK(evaluate("7 // 2") == FsmValue(int64_t(3)));
+        CHECK(evaluate("7 // -2") == FsmValue(int64_t(-4)));
+        CHECK(evaluate("-7 // 2") == FsmValue(int64_t(-4)));
+        CHECK(evaluate("7 % -2") == FsmValue(int64_t(-1)));
+        CHECK(evaluate("-7 % 2") == FsmValue(int64_t(1)));
+        CHECK(evaluate("-7.5 // 2") == FsmValue(-4.0));
+        CHECK(evaluate("-7.5 % 2") == FsmValue(0.5));
+    }
+    SECTION("float floor division and modulo are the ones of CPython")
+    {
+        CHECK(evaluate("0.5 // 0.1") == FsmValue(4.0));
+        CHECK(evaluate("1 // 0.1") == FsmValue(9.0));
+        CHECK(evaluate("1 % 0.1") == FsmValue(0.09999999999999995));
+        FsmValue const zero = evaluate("-1 % 0.5");
+        CHECK(zero == FsmValue(0.0));
+        CHECK_FALSE(std::signbit(std::get<double>(zero)));
+        CHECK(std::signbit(std::get<double>(evaluate("1 % -0.5"))));
+    }
+    SECTION("true division is a float")
+    {
+        CHECK(evaluate("7 / 2") == FsmValue(3.5));
+        CHECK(evaluate("4 / 2") == FsmValue(2.0));
+    }
+    SECTION("bools are ints")
+    {
+        CHECK(evaluate("True + True") == FsmValue(int64_t(2)));
+        CHECK(evaluate("-True") == FsmValue(int64_t(-1)));
+    }
+    SECTION("a negative int exponent gives a float")
+    {
+        CHECK(evaluate("2 ** 10") == FsmValue(int64_t(1024)));
+        CHECK(evaluate("2 ** -1") == FsmValue(0.5));
+        CHECK(evaluate("2.0 ** 3") == FsmValue(8.0));
+    }
+    SECTION("strings")
+    {
+        CHECK(evaluate("'ab' + \"cd\"") == FsmValue(std::string("abcd")));
+        CHECK(evaluate("len('abc')") == FsmValue(int64_t(3)));
+        CHECK(evaluate("str(1.0)") == FsmValue(std::string("1.0")));
+        CHECK(evaluate("str(0.1 + 0.2)") == FsmValue(std::string("0.30000000000000004")));
+        CHECK(evaluate("str(10.0 ** 15)") == FsmValue(std::string("1000000000000000.0")));
+        CHECK(evaluate("str(10.0 ** 16)") == FsmValue(std::string("1e+16")));
+        CHECK(evaluate("str(1 / 100000)") == FsmValue(std::string("1e-05")));
+        CHECK(evaluate("str(-1 / 3)") == FsmValue(std::string("-0.3333333333333333")));
+        CHECK(evaluate("int('12')") == FsmValue(int64_t(12)));
+    }
+}
+
+TEST_CASE("Expression ints wrap around instead of overflowing", "[engine]")
+{
+    CHECK(evaluate("a // b", Min, -1) == FsmValue(Min));
+    CHECK(evaluate("a % b", Min, -1) == FsmValue(int64_t(0)));
+    CHECK(evaluate("(-9223372036854775807 - 1) // -1") == FsmValue(Min));
+    CHECK(evaluate("(-9223372036854775807 - 1) % -1") == FsmValue(int64_t(0)));
+
+    CHECK(evaluate("a + b", Max, 1) == FsmValue(Min));
+    CHECK(evaluate("a - b", Min, 1) == FsmValue(Max));
+    CHECK(evaluate("a * b", Min, -1) == FsmValue(Min));
+    CHECK(evaluate("-a", Min, 0) == FsmValue(Min));
+    CHECK(evaluate("abs(a)", Min, 0) == FsmValue(Min));
+    CHECK(evaluate("2 ** 63") == FsmValue(Min));
+    CHECK(evaluate("2 ** 64") == FsmValue(int64_t(0)));
+}
+
+TEST_CASE("Expression int power is computed by squaring", "[engine]")
+{
+    auto const start = std::chrono::steady_clock::now();
+
+    CHECK(evaluate("a ** b", 3, 3000000000) == FsmValue(int64_t(888636884935874561)));
+    CHECK(evaluate("a ** b", 1, Max) == FsmValue(int64_t(1)));
+    CHECK(evaluate("a ** b", -1, Max) == FsmValue(int64_t(-1)));
+
+    CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds(1));
+}
+
+TEST_CASE("Expression errors are raised when evaluated", "[engine]")
+{
+    CHECK(evaluateError("1 / 0") == "division by zero");
+    CHECK(evaluateError("1 // 0") == "integer division or modulo by zero");
+    CHECK(evaluateError("1 % 0") == "integer division or modulo by zero");
+    CHECK(evaluateError("1.0 // 0") == "float floor division by zero");
+    CHECK(evaluateError("1.0 % 0") == "float modulo");
+    CHECK(evaluateError("0 ** -1") == "0.0 cannot be raised to a negative power");
+    CHECK(evaluateError("0.0 ** -1") == "0.0 cannot be raised to a negative power");
+    CHECK(evaluateError("10.0 ** 400") == "(34, 'Numerical result out of range')");
+    CHECK(evaluateError("1 + 'a'") == "unsupported operand type(s) for +: 'int' and 'str'");
+    CHECK(evaluateError("-'a'") == "bad operand type for unary -: 'str'");
+
+    CHECK_THROWS_AS(FsmExpression::compile("unknown + 1", Slots), ExpressionError);
+    CHECK_THROWS_AS(FsmExpression::compile("1 +", Slots), ExpressionError);
+}
+
+TEST_CASE("Expression boolean logic returns an operand", "[engine]")
+{
+    CHECK(evaluate("0 or 'x'") == FsmValue(std::string("x")));
+    CHECK(evaluate("2 and 3") == FsmValue(int64_t(3)));
+    CHECK(evaluate("not ''") == FsmValue(true));
+    CHECK(evaluate("1 < 2 && 2 <= 2") == FsmValue(true));
+
+    // the right operand is not evaluated
+    CHECK(evaluate("False and 1 / 0") == FsmValue(false));
+    CHECK(evaluate("True or 1 / 0") == FsmValue(true));
+}
+
+TEST_CASE("Action statements assign the slots", "[engine]")
+{
+    std::vector<FsmValue> vars{FsmValue(int64_t(1)), FsmValue(int64_t(0)), FsmValue()};
+    std::vector<int> assigned;
+    std::vector<std::string> output;
+
+    FsmAction::compile("a += 2; b = a * 10\nprint(b) # comment\ns = str(a)", Slots)
+        .execute(vars, assigned, output);
+
+    CHECK(vars[0] == FsmValue(int64_t(3)));
+    CHECK(vars[1] == FsmValue(int64_t(30)));
+    CHECK(vars[2] == FsmValue(std::string("3")));
+    CHECK(assigned == std::vector<int>{0, 1, 2});
+    CHECK(output == std::vector<std::string>{"30"});
+}
+
+TEST_CASE("Expression constants are folded into the bytecode", "[engine]")
+{
+    CHECK(FsmExpression::compile("2 * 3 * 4", Slots).instructionCount() == 1);
+    CHECK(FsmExpression::compile("a + 2 * 3", Slots).instructionCount() == 2);
+
+    // a failing constant is kept, the error is raised when the expression runs
+    FsmExpression const failing = FsmExpression::compile("1 / 0", Slots);
+    CHECK(failing.instructionCount() > 1);
+    CHECK_THROWS_AS(failing.evaluate({FsmValue(), FsmValue(), FsmValue()}), ExpressionError);
+}
+
+TEST_CASE("Expression bytecode and tree evaluation agree", "[engine]")
+{
+    // too deep for the registers of the bytecode, runs on the tree and adds 0
+    std::string zero = "(a - a)";
+    for (int i = 0; i < 300; ++i)
+        zero = "(a - a) + (" + zero + ")";
+
+    std::vector<std::string> const sources{"a + b * 2",
+                                           "a // b",
+                                           "a % b",
+                                           "-a - b",
+                                           "a ** 3",
+                                           "abs(a) + min(a, b) - max(a, b)",
+                                           "(a < b) + (a == b) * 2",
+                                           "(a and b) + (a or b)"};
+    std::vector<int64_t> const values{Min, -7, -1, 0, 1, 2, 7, Max};
+
+    for (auto const &source : sources) {
+        FsmExpression const bytecode = FsmExpression::compile(source, Slots);
+        FsmExpression const tree = FsmExpression::compile("(" + source + ") + " + zero, Slots);
+        REQUIRE(bytecode.instructionCount() > 0);
+        REQUIRE(tree.instructionCount() == 0);
+
+        for (int64_t a : values) {
+            for (int64_t b : values) {
+                std::vector<FsmValue> const vars{FsmValue(a), FsmValue(b), FsmValue()};
+                INFO(source << " with a = " << a << ", b = " << b);
+
+                std::string bytecodeResult, treeResult;
+                try {
+                    bytecodeResult = fsmValueToString(bytecode.evaluate(vars));
+                } catch (ExpressionError const &e) {
+                    bytecodeResult = e.what();
+                }
+                try {
+                    treeResult = fsmValueToString(tree.evaluate(vars));
+                } catch (ExpressionError const &e) {
+                    treeResult = e.what();
+                }
+                CHECK(bytecodeResult == treeResult);
+            }
+        }
+    }
+}
@@ -0,0 +1,219 @@
+#include "engine/fsm-checkpoint.hpp"
+#include "engine/fsm-engine.hpp"
+#include "spec_parser/automaton-parser.hpp"
+#include "spec_parser/compiled-automaton.hpp"
+
+#include "ApplicationSetup.hpp"
+
+#include <catch2/catch.hpp>
+
+#include <QtCore/QMutex>
+#include <QtTest/QSignalSpy>
+
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <thread>
+
+namespace {
+/// Waits in the delay of idle -> done, a checkpoint is taken there.
+std::string pauseText(std::string const &variable)
+{
+    return "AUTOMATON pause\n"
+           "    DESCRIPTION \"\"\n"
+           "    START idle\n"
+           "    FINISH [done]\n"
+           "    VARS\n"
+           "        int " + variable + " = 0\n"
+           "    END\n\n"
+           "STATE idle\n"
+           "    ACTION\n"
+           "        " + variable + " = 1\n"
+           "    END\n\n"
+           "STATE done\n"
+           "    ACTION\n"
+           "    END\n\n"
+           "TRANSITION idle -> done\n"
+           "    CONDITION " + variable + " == 1\n"
+           "    DELAY 100000\n\n"
+           "END\n";
+}
+
+FsmCheckpoint sampleCheckpoint()
+{
+    FsmCheckpoint checkpoint;
+    checkpoint.program = 0x0123456789abcdef;
+    checkpoint.state = 2;
+    checkpoint.transition = 1;
+    checkpoint.remainingMs = 750;
+    checkpoint.steps = 12;
+    checkpoint.transitions = 11;
+    checkpoint.virtualTimeMs = -3;
+    checkpoint.values = {FsmValue(), FsmValue(true), FsmValue(int64_t(-42)), FsmValue(2.5),
+                         FsmValue(std::string("a\0b", 3))};
+    return checkpoint;
+}
+
+std::string decodeError(std::string const &data)
+{
+    FsmCheckpoint checkpoint;
+    std::string error;
+    if (FsmCheckpoint::decode(data, checkpoint, &error))
+        return std::string();
+    return error;
+}
+} // namespace
+
+TEST_CASE("FsmCheckpoint decodes what it encoded", "[checkpoint]")
+{
+    FsmCheckpoint const original = sampleCheckpoint();
+    std::string const data = original.encode();
+    CHECK(data.size() == sizeof(FsmCheckpointHeader) + 1 + 2 + 9 + 9 + 8);
+
+    FsmCheckpoint decoded;
+    std::string error;
+    REQUIRE(FsmCheckpoint::decode(data, decoded, &error));
+    CHECK(decoded.program == original.program);
+    CHECK(decoded.state == original.state);
+    CHECK(decoded.transition == original.transition);
+    CHECK(decoded.remainingMs == original.remainingMs);
+    CHECK(decoded.steps == original.steps);
+    CHECK(decoded.transitions == original.transitions);
+    CHECK(decoded.virtualTimeMs == original.virtualTimeMs);
+    CHECK(decoded.values == original.values);
+}
+
+TEST_CASE("FsmCheckpoint rejects a blob it did not encode", "[checkpoint]")
+{
+    std::string const data = sampleCheckpoint().encode();
+
+    SECTION("another file")
+    {
+        CHECK(decodeError(std::string()) == "Not a checkpoint.");
+        std::string other = data;
+        other[0] = 'X';
+        CHECK(decodeError(other) == "Not a checkpoint.");
+    }
+    SECTION("another version or byte order")
+    {
+        std::string other = data;
+        uint32_t const version = FsmCheckpointVersion + 1;
+        std::memcpy(&other[offsetof(FsmCheckpointHeader, version)], &version, sizeof(version));
+        CHECK(decodeError(other) == "The checkpoint is of another version or byte order.");
+
+        other = data;
+        std::swap(other[offsetof(FsmCheckpointHeader, byteOrder)], other[offsetof(FsmCheckpointHeader, byteOrder) + 3]);
+        CHECK(decodeError(other) == "The checkpoint is of another version or byte order.");
+    }
+    SECTION("truncated")
+    {
+        for (size_t size = sizeof(FsmCheckpointHeader); size < data.size(); ++size) {
+            INFO(size << " bytes");
+            CHECK(decodeError(data.substr(0, size)) == "The checkpoint is truncated or corrupted.");
+        }
+    }
+    SECTION("corrupted")
+    {
+        std::string other = data;
+        other[sizeof(FsmCheckpointHeader)] = 9; // no value type
+        CHECK(decodeError(other) == "The checkpoint is truncated or corrupted.");
+
+        // a count far beyond the data is not reserved
+        other = data;
+        uint32_t const valueCount = 0xffffffff;
+        std::memcpy(&other[offsetof(FsmCheckpointHeader, valueCount)], &valueCount, sizeof(valueCount));
+        CHECK(decodeError(other) == "The checkpoint is truncated or corrupted.");
+
+        CHECK(decodeError(data + '\0') == "The checkpoint is corrupted.");
+    }
+}
+
+TEST_CASE("CompiledAutomaton numbers the states by name", "[checkpoint]")
+{
+    // interned in another order than the names sort, the ids do not depend on it
+    Symbol const late("ck_c");
+    Symbol const middle("ck_b");
+
+    Automaton automaton;
+    AutomatonParser::FromBuffer("AUTOMATON order\n"
+                                "    DESCRIPTION \"\"\n"
+                                "    START ck_b\n"
+                                "    FINISH [ck_a]\n"
+                                "    VARS\n"
+                                "    END\n\n"
+                                "STATE ck_b\n    ACTION\n    END\n\n"
+                                "STATE ck_c\n    ACTION\n    END\n\n"
+                                "STATE ck_a\n    ACTION\n    END\n\n"
+                                "TRANSITION ck_b -> ck_c\n    CONDITION \n    DELAY 0\n\n"
+                                "TRANSITION ck_c -> ck_a\n    CONDITION \n    DELAY 0\n\n"
+                                "END\n",
+                                automaton,
+                                nullptr,
+                                1);
+
+    CompiledAutomaton const compiled = CompiledAutomaton::FromAutomaton(automaton);
+    REQUIRE(compiled.stateCount() == 3);
+    CHECK(compiled.stateName(0) == "ck_a");
+    CHECK(compiled.stateName(1) == "ck_b");
+    CHECK(compiled.stateName(2) == "ck_c");
+    CHECK(compiled.startState() == compiled.stateId(middle));
+    CHECK(compiled.stateId(late) == 2);
+}
+
+TEST_CASE("FsmEngine resumes its checkpoint and rejects the one of another automaton", "[checkpoint]")
+{
+    auto app = applicationSetup();
+
+    Automaton automaton;
+    AutomatonParser::FromBuffer(pauseText("k"), automaton, nullptr, 1);
+
+    // the worker thread sends the checkpoint
+    QMutex mutex;
+    QByteArray checkpoint;
+    FsmEngine engine;
+    QObject::connect(&engine, &FsmEngine::messageReceived, [&](QJsonObject const &message) {
+        if (message["type"].toString() != "CHECKPOINT")
+            return;
+        QMutexLocker locker(&mutex);
+        checkpoint = QByteArray::fromBase64(message["payload"].toObject().value("data").toString().toLatin1());
+    });
+    REQUIRE(engine.start(automaton));
+    engine.requestCheckpoint();
+
+    auto const deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    QByteArray data;
+    while (data.isEmpty() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        QMutexLocker locker(&mutex);
+        data = checkpoint;
+    }
+    engine.stop();
+    REQUIRE_FALSE(data.isEmpty());
+
+    SECTION("the same automaton")
+    {
+        FsmEngine resumed;
+        CHECK(resumed.start(automaton, data));
+        resumed.stop();
+    }
+    SECTION("another automaton")
+    {
+        Automaton other;
+        AutomatonParser::FromBuffer(pauseText("j"), other, nullptr, 1);
+
+        FsmEngine rejecting;
+        QSignalSpy errors(&rejecting, &FsmEngine::fsmError);
+        CHECK_FALSE(rejecting.start(other, data));
+        REQUIRE(errors.count() == 1);
+        CHECK(errors.at(0).at(0).toString().contains("another automaton"));
+    }
+    SECTION("a corrupted checkpoint")
+    {
+        FsmEngine rejecting;
+        QSignalSpy errors(&rejecting, &FsmEngine::fsmError);
+        CHECK_FALSE(rejecting.start(automaton, data.left(data.size() - 1)));
+        REQUIRE(errors.count() == 1);
+        CHECK(errors.at(0).at(0).toString().contains("truncated or corrupted"));
+    }
+}
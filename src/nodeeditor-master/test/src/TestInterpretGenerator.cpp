@@ -0,0 +1,81 @@
+#include "interpret_generator.h"
+#include "spec_parser/automaton-parser.hpp"
+
+#include "ApplicationSetup.hpp"
+
+#include <catch2/catch.hpp>
+
+#include <QtCore/QProcess>
+#include <QtCore/QProcessEnvironment>
+
+namespace {
+/// Counts k up to 5 in s0 with a delay per step, then finishes in done.
+char const *const CounterText = "AUTOMATON counter\n"
+                                "    DESCRIPTION \"\"\n"
+                                "    START s0\n"
+                                "    FINISH [done]\n"
+                                "    VARS\n"
+                                "        int k = 0\n"
+                                "    END\n\n"
+                                "STATE s0\n"
+                                "    ACTION\n"
+                                "        k = k + 1\n"
+                                "    END\n\n"
+                                "STATE done\n"
+                                "    ACTION\n"
+                                "    END\n\n"
+                                "TRANSITION s0 -> s0\n"
+                                "    CONDITION k < 5\n"
+                                "    DELAY 1000\n\n"
+                                "TRANSITION s0 -> done\n"
+                                "    CONDITION k >= 5\n"
+                                "    DELAY 0\n\n"
+                                "END\n";
+
+/// Loads the script from stdin like the runtime daemon, without its main block, and runs it.
+char const *const Driver = "import sys\n"
+                           "namespace = {'__name__': 'fsm_script'}\n"
+                           "exec(compile(sys.stdin.read(), '<script>', 'exec'), namespace)\n"
+                           "fsm = namespace['build_fsm']()\n"
+                           "fsm.run()\n"
+                           "print(fsm.get_variable('k'), fsm.current_state.name)\n";
+
+/// Runs the script in the Python runtime of the source tree, returns what the driver printed.
+QString runScript(QByteArray const &script)
+{
+    QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+    environment.insert("PYTHONPATH", ICP_TEST_RUNTIME_DIR);
+    environment.insert("PYTHONDONTWRITEBYTECODE", "1"); // the source tree stays clean
+
+    QProcess python;
+    python.setProcessEnvironment(environment);
+    python.start(ICP_TEST_PYTHON, {"-c", Driver});
+    REQUIRE(python.waitForStarted());
+    python.write(script);
+    python.closeWriteChannel();
+    REQUIRE(python.waitForFinished(30000));
+
+    INFO(python.readAllStandardError().toStdString());
+    CHECK(python.exitCode() == 0);
+    return QString::fromUtf8(python.readAllStandardOutput()).trimmed();
+}
+} // namespace
+
+TEST_CASE("A generated script imports and runs in the Python runtime", "[generator]")
+{
+    auto app = applicationSetup();
+
+    Automaton automaton;
+    AutomatonParser::FromBuffer(CounterText, automaton, nullptr, 1);
+
+    for (bool lazy : {false, true}) {
+        INFO((lazy ? "lazy" : "eager") << " functions");
+        InterpretGenerator generator;
+        generator.setLazyFunctions(lazy);
+        generator.setVirtualTime(true);
+        QByteArray const script = generator.generateScript(automaton);
+        CHECK(script.contains("LazyFunctions(globals()") == lazy);
+
+        CHECK(runScript(script) == "5 done");
+    }
+}
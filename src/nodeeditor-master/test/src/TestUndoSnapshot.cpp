@@ -0,0 +1,107 @@
+#include "DynamicPortsModel.hpp"
+
+#include "ApplicationSetup.hpp"
+#include "Stringify.hpp"
+
+#include <QtNodes/BasicGraphicsScene>
+#include <QtNodes/internal/NodeGraphicsObject.hpp>
+#include <QtNodes/internal/UndoCommands.hpp>
+
+#include <catch2/catch.hpp>
+
+#include <QUndoStack>
+
+using QtNodes::BasicGraphicsScene;
+using QtNodes::DeleteCommand;
+
+namespace {
+/// Two states, the first one with two transitions to the second one.
+struct SampleGraph
+{
+    DynamicPortsModel model;
+    NodeId from = InvalidNodeId;
+    NodeId to = InvalidNodeId;
+
+    SampleGraph()
+    {
+        from = model.addNode();
+        to = model.addNode();
+        model.setNodeData(from, NodeRole::Position, QPointF(10, 20));
+        model.setNodeData(to, NodeRole::Position, QPointF(200, 20));
+        model.addPort(from, PortType::Out, 0);
+        model.addPort(from, PortType::Out, 0);
+        model.addPort(to, PortType::In, 0);
+        model.addConnection(ConnectionId{from, 0, to, 0});
+        model.addConnection(ConnectionId{from, 1, to, 0});
+    }
+
+    /// Deletes the first state, its transitions go with it.
+    void deleteFrom(BasicGraphicsScene &scene)
+    {
+        scene.clearSelection();
+        REQUIRE(scene.nodeGraphicsObject(from));
+        scene.nodeGraphicsObject(from)->setSelected(true);
+        scene.undoStack().push(new DeleteCommand(&scene));
+    }
+
+    bool isDeleted() const
+    {
+        return !model.nodeExists(from) && model.allConnectionIds(to).empty();
+    }
+
+    bool isRestored() const
+    {
+        return model.nodeExists(from)
+               && model.nodeData(from, NodeRole::Position).value<QPointF>() == QPointF(10, 20)
+               && model.nodeData(from, NodeRole::OutPortCount).toUInt() == 2
+               && model.connectionExists(ConnectionId{from, 0, to, 0})
+               && model.connectionExists(ConnectionId{from, 1, to, 0});
+    }
+};
+} // namespace
+
+TEST_CASE("DeleteCommand brings the deleted nodes and connections back", "[undo]")
+{
+    auto app = applicationSetup();
+
+    SampleGraph graph;
+    BasicGraphicsScene scene(graph.model);
+
+    graph.deleteFrom(scene);
+    CHECK(graph.isDeleted());
+
+    scene.undoStack().undo();
+    CHECK(graph.isRestored());
+
+    scene.undoStack().redo();
+    CHECK(graph.isDeleted());
+
+    scene.undoStack().undo();
+    CHECK(graph.isRestored());
+}
+
+TEST_CASE("The undo history spills its snapshots over the budget and reads them back", "[undo]")
+{
+    auto app = applicationSetup();
+
+    SampleGraph graph;
+    BasicGraphicsScene scene(graph.model);
+
+    scene.setUndoMemoryBudget(0);
+    graph.deleteFrom(scene);
+    REQUIRE(scene.undoMemoryUsage() > sizeof(DeleteCommand));
+
+    // a spilled command keeps only itself in memory
+    scene.setUndoMemoryBudget(1);
+    CHECK(scene.undoMemoryUsage() == sizeof(DeleteCommand));
+
+    scene.undoStack().undo();
+    CHECK(graph.isRestored());
+    CHECK(scene.undoMemoryUsage() == sizeof(DeleteCommand));
+
+    scene.undoStack().redo();
+    CHECK(graph.isDeleted());
+
+    scene.undoStack().undo();
+    CHECK(graph.isRestored());
+}
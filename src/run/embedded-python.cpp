@@ -0,0 +1,357 @@
+/**
+ * @file embedded-python.cpp
+ * @brief Implementation of the EmbeddedPython class.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#include "embedded-python.hpp"
+
+// Python.h names a struct member slots, which Qt defines as a keyword
+#pragma push_macro("slots")
+#undef slots
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#pragma pop_macro("slots")
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QJsonArray>
+
+#include <chrono>
+#include <cmath>
+
+namespace {
+
+// how often the runtimes push their periodic STATS while no command comes
+constexpr auto kStatsPushInterval = std::chrono::milliseconds(500);
+
+EmbeddedPython *s_instance = nullptr;
+
+/// Takes the pending Python exception, as its message.
+QString takeError()
+{
+    PyObject *type = nullptr, *value = nullptr, *traceback = nullptr;
+    PyErr_Fetch(&type, &value, &traceback);
+    QString message = "unknown Python error";
+    if (value) {
+        if (PyObject *text = PyObject_Str(value)) {
+            if (const char *utf8 = PyUnicode_AsUTF8(text))
+                message = QString::fromUtf8(utf8);
+            Py_DECREF(text);
+        }
+    }
+    PyErr_Clear();
+    Py_XDECREF(type);
+    Py_XDECREF(value);
+    Py_XDECREF(traceback);
+    return message;
+}
+
+/// Converts what the FSM sends, the types json.dumps() accepts; anything else becomes its str().
+QJsonValue toJson(PyObject *object)
+{
+    if (object == Py_None)
+        return QJsonValue::Null;
+    if (PyBool_Check(object))
+        return object == Py_True;
+    if (PyLong_Check(object)) {
+        int overflow = 0;
+        const long long value = PyLong_AsLongLongAndOverflow(object, &overflow);
+        if (overflow == 0)
+            return QJsonValue(static_cast<qint64>(value));
+        return PyLong_AsDouble(object);
+    }
+    if (PyFloat_Check(object))
+        return PyFloat_AS_DOUBLE(object);
+    if (PyUnicode_Check(object)) {
+        Py_ssize_t size = 0;
+        const char *utf8 = PyUnicode_AsUTF8AndSize(object, &size);
+        if (!utf8) {
+            PyErr_Clear();
+            return QString();
+        }
+        return QString::fromUtf8(utf8, size);
+    }
+    if (PyDict_Check(object)) {
+        QJsonObject result;
+        PyObject *key = nullptr, *value = nullptr;
+        Py_ssize_t pos = 0;
+        while (PyDict_Next(object, &pos, &key, &value)) {
+            const QJsonValue name = PyUnicode_Check(key) ? toJson(key) : QJsonValue();
+            if (name.isString()) {
+                result.insert(name.toString(), toJson(value));
+            } else if (PyObject *text = PyObject_Str(key)) {
+                result.insert(toJson(text).toString(), toJson(value));
+                Py_DECREF(text);
+            } else {
+                PyErr_Clear();
+            }
+        }
+        return result;
+    }
+    if (PyList_Check(object) || PyTuple_Check(object)) {
+        QJsonArray result;
+        const Py_ssize_t size = PySequence_Fast_GET_SIZE(object);
+        PyObject **items = PySequence_Fast_ITEMS(object);
+        for (Py_ssize_t i = 0; i < size; ++i)
+            result.append(toJson(items[i]));
+        return result;
+    }
+
+    PyObject *text = PyObject_Str(object);
+    if (!text) {
+        PyErr_Clear();
+        return QJsonValue::Null;
+    }
+    const QJsonValue result = toJson(text);
+    Py_DECREF(text);
+    return result;
+}
+
+/// Converts a command payload, whole numbers become int as json.loads() would make them.
+PyObject *toPython(const QJsonValue &value)
+{
+    switch (value.type()) {
+    case QJsonValue::Bool:
+        return PyBool_FromLong(value.toBool());
+    case QJsonValue::Double: {
+        const double number = value.toDouble();
+        if (std::floor(number) == number && std::fabs(number) < 9007199254740992.0) // 2^53
+            return PyLong_FromLongLong(static_cast<long long>(number));
+        return PyFloat_FromDouble(number);
+    }
+    case QJsonValue::String: {
+        const QByteArray utf8 = value.toString().toUtf8();
+        return PyUnicode_FromStringAndSize(utf8.constData(), utf8.size());
+    }
+    case QJsonValue::Array: {
+        const QJsonArray array = value.toArray();
+        PyObject *list = PyList_New(array.size());
+        for (qsizetype i = 0; i < array.size(); ++i)
+            PyList_SET_ITEM(list, i, toPython(array.at(i)));
+        return list;
+    }
+    case QJsonValue::Object: {
+        const QJsonObject object = value.toObject();
+        PyObject *dict = PyDict_New();
+        for (auto it = object.constBegin(); it != object.constEnd(); ++it) {
+            PyObject *item = toPython(it.value());
+            PyDict_SetItemString(dict, it.key().toUtf8().constData(), item);
+            Py_DECREF(item);
+        }
+        return dict;
+    }
+    default:
+        Py_RETURN_NONE;
+    }
+}
+
+/// _icp.post(run_id, type, payload), the send of the LocalChannel of every runtime.
+PyObject *icpPost(PyObject *, PyObject *args)
+{
+    int runId = 0;
+    const char *type = nullptr;
+    PyObject *payload = nullptr;
+    if (!PyArg_ParseTuple(args, "isO", &runId, &type, &payload))
+        return nullptr;
+
+    QJsonObject message;
+    message["type"] = QString::fromUtf8(type);
+    message["payload"] = PyDict_Check(payload) ? toJson(payload) : QJsonObject();
+    if (s_instance)
+        s_instance->post(runId, message);
+    Py_RETURN_NONE;
+}
+
+PyMethodDef icpMethods[] = {
+    {"post", icpPost, METH_VARARGS, "Posts a message of an FSM to the editor."},
+    {nullptr, nullptr, 0, nullptr}
+};
+
+PyModuleDef icpModule = {
+    PyModuleDef_HEAD_INIT, "_icp", "The editor hosting the embedded FSM runtime.", -1, icpMethods,
+    nullptr, nullptr, nullptr, nullptr
+};
+
+PyObject *initIcpModule()
+{
+    return PyModule_Create(&icpModule);
+}
+
+} // namespace
+
+EmbeddedPython *EmbeddedPython::instance()
+{
+    if (!s_instance)
+        s_instance = new EmbeddedPython(QCoreApplication::instance());
+    return s_instance;
+}
+
+EmbeddedPython::EmbeddedPython(QObject *parent)
+    : QObject(parent)
+{
+}
+
+EmbeddedPython::~EmbeddedPython()
+{
+    if (m_thread.joinable()) {
+        enqueue({Command::Op::Shutdown});
+        m_thread.join();
+    }
+    s_instance = nullptr;
+}
+
+bool EmbeddedPython::start(const QString &runtimeDir, QString *error)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_state == State::Stopped) {
+        m_state = State::Starting;
+        m_thread = std::thread(&EmbeddedPython::serve, this, runtimeDir);
+    }
+    m_wake.wait(lock, [this]() { return m_state != State::Starting; });
+
+    if (m_state == State::Failed && error)
+        *error = m_error;
+    return m_state == State::Running;
+}
+
+void EmbeddedPython::open(int runId)
+{
+    enqueue({Command::Op::Open, runId});
+}
+
+void EmbeddedPython::send(int runId, const QString &type, const QJsonObject &payload)
+{
+    enqueue({Command::Op::Send, runId, type, payload});
+}
+
+void EmbeddedPython::close(int runId)
+{
+    enqueue({Command::Op::Close, runId});
+}
+
+void EmbeddedPython::enqueue(Command command)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_state != State::Running)
+            return;
+        m_commands.push_back(std::move(command));
+    }
+    m_wake.notify_all();
+}
+
+void EmbeddedPython::serve(const QString &runtimeDir)
+{
+    // the builtin module has to be registered before the interpreter starts
+    PyImport_AppendInittab("_icp", &initIcpModule);
+
+    PyConfig config;
+    PyConfig_InitPythonConfig(&config);
+    config.install_signal_handlers = 0; // Ctrl+C and the other signals stay with the editor
+    config.parse_argv = 0;
+    PyStatus status = Py_InitializeFromConfig(&config);
+    PyConfig_Clear(&config);
+    if (PyStatus_Exception(status)) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_error = QString("Python did not initialize: ") + (status.err_msg ? status.err_msg : "unknown error");
+        m_state = State::Failed;
+        m_wake.notify_all();
+        return;
+    }
+
+    PyObject *runtime = nullptr;
+    {
+        const QByteArray dir = runtimeDir.toUtf8();
+        PyObject *path = PySys_GetObject("path"); // borrowed
+        PyObject *entry = PyUnicode_FromStringAndSize(dir.constData(), dir.size());
+        if (path && entry)
+            PyList_Insert(path, 0, entry);
+        Py_XDECREF(entry);
+        runtime = PyImport_ImportModule("fsm_core.embedded");
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (runtime) {
+            m_state = State::Running;
+        } else {
+            m_error = "Cannot import fsm_core from " + runtimeDir + ": " + takeError();
+            m_state = State::Failed;
+        }
+    }
+    m_wake.notify_all();
+    if (!runtime) {
+        Py_FinalizeEx();
+        return;
+    }
+    qInfo() << "[EmbeddedPython] Python" << Py_GetVersion() << "runs in process, fsm_core from" << runtimeDir;
+
+    // the FSM threads run while this thread waits for commands
+    PyThreadState *thread = PyEval_SaveThread();
+
+    auto nextStatsPush = std::chrono::steady_clock::now() + kStatsPushInterval;
+    bool shutdown = false;
+    while (!shutdown) {
+        std::deque<Command> commands;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait_until(lock, nextStatsPush, [this]() { return !m_commands.empty(); });
+            commands.swap(m_commands);
+        }
+
+        PyEval_RestoreThread(thread);
+        for (Command &command : commands) {
+            PyObject *result = nullptr;
+            switch (command.op) {
+            case Command::Op::Open:
+                result = PyObject_CallMethod(runtime, "open", "i", command.runId);
+                break;
+            case Command::Op::Send: {
+                const QByteArray type = command.type.toUtf8();
+                PyObject *payload = toPython(command.payload);
+                result = PyObject_CallMethod(runtime, "dispatch", "isO", command.runId, type.constData(), payload);
+                Py_DECREF(payload);
+                break;
+            }
+            case Command::Op::Close:
+                result = PyObject_CallMethod(runtime, "close", "i", command.runId);
+                break;
+            case Command::Op::Shutdown:
+                result = PyObject_CallMethod(runtime, "shutdown", nullptr);
+                shutdown = true;
+                break;
+            }
+
+            if (result) {
+                Py_DECREF(result);
+            } else {
+                // the runtime reports the errors of the automaton itself, this is a broken fsm_core
+                const QString message = takeError();
+                qWarning() << "[EmbeddedPython] Command of run" << command.runId << "failed:" << message;
+                if (command.op == Command::Op::Open || command.op == Command::Op::Send)
+                    post(command.runId, QJsonObject{{"type", "FSM_ERROR"},
+                                                    {"payload", QJsonObject{{"message", message}}}});
+            }
+        }
+        if (!shutdown && std::chrono::steady_clock::now() >= nextStatsPush) {
+            PyObject *result = PyObject_CallMethod(runtime, "push_stats", nullptr);
+            if (result)
+                Py_DECREF(result);
+            else
+                PyErr_Clear();
+            nextStatsPush = std::chrono::steady_clock::now() + kStatsPushInterval;
+        }
+        thread = PyEval_SaveThread();
+    }
+
+    PyEval_RestoreThread(thread);
+    Py_DECREF(runtime);
+    Py_FinalizeEx();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_state = State::Failed;
+    m_error = "The embedded Python runtime has shut down.";
+}
@@ -0,0 +1,115 @@
+/**
+ * @file embedded-python.hpp
+ * @brief Declaration of the EmbeddedPython class, the Python interpreter linked into the editor.
+ *
+ * The interpreter is started once per session on a thread of its own, which imports
+ * fsm_core.embedded and then serves a queue of commands for the runs. Every run has an
+ * EmbeddedRuntime in Python, its FSM runs on a Python thread. The messages of the FSM are
+ * converted from the Python dicts to QJsonObject and emitted by messagePosted() from that
+ * thread, so a receiver in the GUI thread gets them queued; nothing is serialized, no
+ * process is started and no socket is opened.
+ *
+ * Compiled with ICP_EMBEDDED_PYTHON only, see the option of the same name in CMakeLists.txt.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#ifndef EMBEDDED_PYTHON_HPP
+#define EMBEDDED_PYTHON_HPP
+
+#include <QObject>
+#include <QJsonObject>
+#include <QString>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+/**
+ * @class EmbeddedPython
+ * @brief The in-process Python runtime shared by all embedded runs.
+ */
+class EmbeddedPython : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief The runtime of the session, created on first use and destroyed with the application.
+     */
+    static EmbeddedPython* instance();
+
+    /**
+     * @brief Stops all FSMs and finalizes the interpreter.
+     */
+    ~EmbeddedPython();
+
+    /**
+     * @brief Starts the interpreter and imports fsm_core, does nothing once it has started.
+     *
+     * Waits until fsm_core is imported. The interpreter cannot be started again in the
+     * process, a failed start fails every later call too.
+     * @param runtimeDir Directory with the fsm_core package, put first on sys.path.
+     * @param error Set to the reason if the start fails.
+     * @return False if the interpreter did not start.
+     */
+    bool start(const QString &runtimeDir, QString *error = nullptr);
+
+    /**
+     * @brief Creates the runtime of a run, it answers with FSM_CONNECTED.
+     */
+    void open(int runId);
+
+    /**
+     * @brief Hands a command of the protocol (LOAD_AUTOMATON, SET_VARIABLE, ...) to the runtime of a run.
+     */
+    void send(int runId, const QString &type, const QJsonObject &payload);
+
+    /**
+     * @brief Stops the FSM of the run and drops its runtime.
+     */
+    void close(int runId);
+
+    /**
+     * @brief Emits messagePosted(), called by _icp.post() on the thread of an FSM.
+     */
+    void post(int runId, const QJsonObject &message) { emit messagePosted(runId, message); }
+
+signals:
+    /**
+     * @brief Emitted for every message of an FSM, from a Python thread.
+     */
+    void messagePosted(int runId, const QJsonObject &message);
+
+private:
+    struct Command
+    {
+        enum class Op { Open, Send, Close, Shutdown };
+
+        Op op;
+        int runId = 0;
+        QString type;
+        QJsonObject payload;
+    };
+
+    enum class State { Stopped, Starting, Running, Failed };
+
+    explicit EmbeddedPython(QObject *parent);
+
+    void enqueue(Command command);
+
+    /**
+     * @brief Body of the interpreter thread, initializes Python and serves the commands.
+     */
+    void serve(const QString &runtimeDir);
+
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;             ///< a command was queued or the start finished
+    std::deque<Command> m_commands;
+    State m_state = State::Stopped;
+    QString m_error;                            ///< why the interpreter failed to start
+};
+
+#endif // EMBEDDED_PYTHON_HPP
@@ -0,0 +1,558 @@
+/**
+ * @file fsm-run.cpp
+ * @brief Implementation of the FsmRun class.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#include "fsm-run.hpp"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QJsonDocument>
+#include <QSaveFile>
+
+#include "../client.hpp"
+#include "../engine/fsm-engine.hpp"
+#ifdef ICP_EMBEDDED_PYTHON
+#include "embedded-python.hpp"
+#endif
+
+FsmRun::FsmRun(int id, QObject *parent)
+    : QObject(parent), m_id(id)
+{
+}
+
+FsmRun::~FsmRun()
+{
+    // the editor may already be gone, nothing is reported while the process ends
+    blockSignals(true);
+    terminate();
+}
+
+bool FsmRun::isRunning() const
+{
+    if (m_engine)
+        return m_engine->isRunning();
+    if (m_kind == Kind::Remote)
+        return m_client && m_client->hasInstance(m_instance);
+    if (m_kind == Kind::Embedded)
+        return m_embeddedOpen;
+    return m_process && m_process->state() != QProcess::NotRunning;
+}
+
+bool FsmRun::startPython(const QString &program, const QStringList &arguments,
+                         const QProcessEnvironment &environment, const QString &logFilePath,
+                         const QByteArray &script, bool daemon)
+{
+    m_kind = daemon ? Kind::Daemon : Kind::Interpret;
+
+    m_client = new FsmClient(this);
+    connect(m_client, &FsmClient::connected, this, &FsmRun::onConnected);
+    connect(m_client, &FsmClient::disconnected, this, [this]() {
+        emit logMessage(m_id, "CLIENT: Disconnected from FSM server.");
+    });
+    connect(m_client, &FsmClient::messageReceived, this, &FsmRun::onMessageReceived);
+    connect(m_client, &FsmClient::fsmError, this, [this](const QString &err) {
+        emit logMessage(m_id, "CLIENT ERROR: " + err);
+    });
+
+    // standard output is read by onReadyReadStdOut, which waits for the READY line
+    m_logFilePath = logFilePath;
+    m_logFile.setFileName(logFilePath);
+    if (!m_logFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        qWarning() << "[FsmRun] Cannot open the Python log:" << logFilePath;
+
+    // the runtime listens on the endpoint of FSM_ENDPOINT, a local socket unless the caller picked one
+    QProcessEnvironment runtimeEnvironment = environment;
+    if (!runtimeEnvironment.contains("FSM_ENDPOINT"))
+        runtimeEnvironment.insert("FSM_ENDPOINT", defaultEndpoint(m_id));
+
+    m_process = new QProcess(this);
+    m_process->setProcessEnvironment(runtimeEnvironment);
+    m_process->setStandardErrorFile(logFilePath, QIODevice::Append);
+    connect(m_process, &QProcess::readyReadStandardOutput, this, &FsmRun::onReadyReadStdOut);
+    connect(m_process, &QProcess::finished, this, &FsmRun::onProcessFinished);
+    connect(m_process, &QProcess::errorOccurred, this, [this](QProcess::ProcessError) {
+        emit logMessage(m_id, "PYTHON PROCESS ERROR: " + m_process->errorString());
+    });
+
+    qInfo() << "[FsmRun]" << m_id << "Starting Python FSM server process:" << program << arguments;
+    m_process->start(program, arguments);
+    if (!m_process->waitForStarted(5000)) { // 5 sec
+        qWarning() << "[FsmRun] Failed to start Python process:" << m_process->errorString();
+        return false;
+    }
+
+    if (!script.isEmpty()) {
+        // python starts executing once stdin is closed
+        m_process->write(script);
+        m_process->closeWriteChannel();
+    }
+
+    emit logMessage(m_id, "Python FSM process is running.");
+    return true;
+}
+
+bool FsmRun::startEmbedded(const QString &runtimeDir)
+{
+    m_kind = Kind::Embedded;
+
+#ifdef ICP_EMBEDDED_PYTHON
+    EmbeddedPython *python = EmbeddedPython::instance();
+    QString error;
+    if (!python->start(runtimeDir, &error)) {
+        qWarning() << "[FsmRun] The embedded Python runtime did not start:" << error;
+        emit logMessage(m_id, "EMBEDDED PYTHON ERROR: " + error);
+        return false;
+    }
+
+    // posted from the thread of the FSM, each run picks its own messages
+    connect(python, &EmbeddedPython::messagePosted, this, [this](int runId, const QJsonObject &message) {
+        if (runId == m_id)
+            onMessageReceived(message);
+    }, Qt::QueuedConnection);
+
+    python->open(m_id);
+    m_embeddedOpen = true;
+    emit logMessage(m_id, "Embedded Python runtime is open.");
+    return true;
+#else
+    Q_UNUSED(runtimeDir);
+    emit logMessage(m_id, "EMBEDDED PYTHON ERROR: The editor is built without ICP_EMBEDDED_PYTHON.");
+    return false;
+#endif
+}
+
+void FsmRun::startRemote(FsmClient *client, const QByteArray &script)
+{
+    m_kind = Kind::Remote;
+    m_instance = m_id;
+    m_client = client;
+
+    // one slot per run, not per message: the client finds the handler of the instance
+    client->openInstance(m_instance, [this](const QJsonObject &message) { onMessageReceived(message); });
+    connect(client, &FsmClient::disconnected, this, [this]() { emit finished(m_id); });
+    connect(client, &QObject::destroyed, this, [this]() { emit finished(m_id); });
+
+    // held by the client until the connection is multiplexed
+    emit logMessage(m_id, "CLIENT -> FSM: Loading the automaton as instance " + QString::number(m_instance) + ".");
+    client->sendLoadAutomaton(script, m_instance);
+}
+
+bool FsmRun::embeddedAvailable()
+{
+#ifdef ICP_EMBEDDED_PYTHON
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool FsmRun::startEngine(const Automaton &automaton, bool virtualTime, bool profile, bool compiled,
+                         const QByteArray &checkpoint)
+{
+    m_kind = Kind::Engine;
+
+    m_engine = new FsmEngine(this);
+    m_engine->setVirtualTime(virtualTime);
+    m_engine->setProfiling(profile);
+    m_engine->setCompiled(compiled);
+    m_engine->setCheckpointInterval(m_checkpointIntervalMs);
+    connect(m_engine, &FsmEngine::messageReceived, this, &FsmRun::onMessageReceived);
+    connect(m_engine, &FsmEngine::fsmError, this, [this](const QString &err) {
+        emit logMessage(m_id, "ENGINE ERROR: " + err);
+    });
+    connect(m_engine, &FsmEngine::outputReady, this, [this](const QString &line) {
+        emit logMessage(m_id, "ENGINE STDOUT: " + line);
+    });
+    connect(m_engine, &FsmEngine::finished, this, [this]() {
+        emit logMessage(m_id, "Native FSM engine is not running.");
+        emit finished(m_id);
+    });
+
+    emit logMessage(m_id, checkpoint.isEmpty() ? QString("Native FSM engine is starting...")
+                                               : QString("Native FSM engine is resuming from a checkpoint..."));
+    return m_engine->start(automaton, checkpoint);
+}
+
+void FsmRun::setCheckpointFile(const QString &path, int intervalMs)
+{
+    m_checkpointFile = path;
+    m_checkpointIntervalMs = intervalMs;
+}
+
+bool FsmRun::requestCheckpoint()
+{
+    if (!m_engine || !m_engine->isRunning()) {
+        emit logMessage(m_id, "Only a running native engine can be checkpointed.");
+        return false;
+    }
+    m_engine->requestCheckpoint();
+    return true;
+}
+
+void FsmRun::saveCheckpoint(const QJsonObject &payload)
+{
+    if (m_checkpointFile.isEmpty())
+        return;
+
+    // replaced at once, a crash never leaves half a checkpoint
+    QSaveFile file(m_checkpointFile);
+    const QByteArray data = QByteArray::fromBase64(payload["data"].toString().toLatin1());
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size() || !file.commit())
+        emit logMessage(m_id, "Cannot write the checkpoint " + m_checkpointFile);
+}
+
+void FsmRun::loadAutomaton(const QByteArray &script)
+{
+#ifdef ICP_EMBEDDED_PYTHON
+    if (m_embeddedOpen) {
+        emit logMessage(m_id, "EMBEDDED: Loading the automaton into the embedded runtime.");
+        EmbeddedPython::instance()->send(m_id, "LOAD_AUTOMATON", QJsonObject{{"code", QString::fromUtf8(script)}});
+        return;
+    }
+#endif
+    if (m_kind == Kind::Remote || (m_client && m_client->isConnected())) {
+        emit logMessage(m_id, "CLIENT -> FSM: Loading the automaton into the running interpreter.");
+        if (m_client)
+            m_client->sendLoadAutomaton(script, m_instance);
+        return;
+    }
+
+    // sent by onConnected
+    m_pendingScript = script;
+}
+
+bool FsmRun::reloadFunctions(const InterpretGenerator::ScriptFunctions &functions)
+{
+    if (!hasRuntime() || !m_fsmActive || m_functions.functions.empty()
+        || functions.layout != m_functions.layout || functions.functions.size() != m_functions.functions.size())
+        return false;
+
+    // the runtime knows a function by the name it was loaded with, a changed condition is
+    // sent under the name of the one it replaces
+    QByteArray code;
+    int changed = 0;
+    for (size_t i = 0; i < functions.functions.size(); ++i) {
+        InterpretGenerator::ScriptFunction &running = m_functions.functions[i];
+        const InterpretGenerator::ScriptFunction &edited = functions.functions[i];
+        if (edited.body == running.body && edited.reads == running.reads)
+            continue;
+        running.body = edited.body;
+        running.reads = edited.reads;
+        code += InterpretGenerator::functionDefinition(running).toUtf8();
+        changed++;
+    }
+
+    if (changed == 0) {
+        emit logMessage(m_id, "CLIENT: The running automaton is up to date.");
+        return true;
+    }
+    emit logMessage(m_id, "CLIENT -> FSM: Reloading " + QString::number(changed) + " function(s) into the running FSM.");
+#ifdef ICP_EMBEDDED_PYTHON
+    if (m_embeddedOpen) {
+        EmbeddedPython::instance()->send(m_id, "RELOAD_FUNCTIONS", QJsonObject{{"code", QString::fromUtf8(code)}});
+        return true;
+    }
+#endif
+    m_client->sendReloadFunctions(code, m_instance);
+    return true;
+}
+
+void FsmRun::setVariable(const QString &name, const QJsonValue &value)
+{
+    if (m_engine)
+        m_engine->setVariable(name, value);
+#ifdef ICP_EMBEDDED_PYTHON
+    else if (m_embeddedOpen)
+        EmbeddedPython::instance()->send(m_id, "SET_VARIABLE", QJsonObject{{"name", name}, {"value", value}});
+#endif
+    else if (m_client)
+        m_client->sendSetVariable(name, value, m_instance);
+}
+
+void FsmRun::setVariables(const QJsonObject &values)
+{
+    if (m_engine) {
+        for (auto it = values.constBegin(); it != values.constEnd(); ++it)
+            m_engine->setVariable(it.key(), it.value());
+#ifdef ICP_EMBEDDED_PYTHON
+    } else if (m_embeddedOpen) {
+        EmbeddedPython::instance()->send(m_id, "SET_VARIABLES", QJsonObject{{"variables", values}});
+#endif
+    } else if (m_client) {
+        m_client->sendSetVariables(values, m_instance);
+    }
+}
+
+bool FsmRun::startTrace(const QString &path)
+{
+    auto trace = std::make_unique<TraceRecorder>();
+    if (!trace->open(path.toStdString())) {
+        qWarning() << "[FsmRun] Cannot create the trace:" << path;
+        return false;
+    }
+    m_trace = std::move(trace);
+    emit logMessage(m_id, "Recording the trace to " + path);
+    return true;
+}
+
+bool FsmRun::requestStats(double intervalSeconds)
+{
+    if (!hasRuntime()) {
+        emit logMessage(m_id, "CLIENT: Cannot send GET_STATS - no runtime connection.");
+        return false;
+    }
+#ifdef ICP_EMBEDDED_PYTHON
+    if (m_embeddedOpen) {
+        QJsonObject payload;
+        if (intervalSeconds >= 0)
+            payload["interval"] = intervalSeconds;
+        EmbeddedPython::instance()->send(m_id, "GET_STATS", payload);
+        return true;
+    }
+#endif
+    m_client->sendGetStats(intervalSeconds, m_instance);
+    return true;
+}
+
+qint64 FsmRun::pendingClientBytes() const
+{
+    return m_client ? m_client->pendingBytes() : 0;
+}
+
+qint64 FsmRun::clientBufferBytes() const
+{
+    // the shared connection of a remote run is counted once, by its owner
+    return m_client && m_kind != Kind::Remote ? m_client->bufferBytes() : 0;
+}
+
+void FsmRun::stop()
+{
+    if (m_engine) {
+        emit logMessage(m_id, "CLIENT -> ENGINE: Stopping the native engine.");
+        m_engine->stop();
+#ifdef ICP_EMBEDDED_PYTHON
+    } else if (m_embeddedOpen) {
+        emit logMessage(m_id, "EMBEDDED: Stopping the FSM.");
+        EmbeddedPython::instance()->send(m_id, "STOP_FSM", QJsonObject());
+#endif
+    } else if (m_client && m_client->isConnected()) {
+        emit logMessage(m_id, "CLIENT -> FSM: Sending STOP_FSM command.");
+        m_client->sendStopFsm(m_instance);
+    } else {
+        emit logMessage(m_id, "CLIENT: Cannot send STOP_FSM - not connected.");
+    }
+}
+
+void FsmRun::terminate()
+{
+    if (m_engine)
+        m_engine->stop();
+
+#ifdef ICP_EMBEDDED_PYTHON
+    if (m_embeddedOpen) {
+        // the interpreter stays for the next runs, only the runtime of this one goes
+        EmbeddedPython::instance()->close(m_id);
+        m_embeddedOpen = false;
+        emit logMessage(m_id, "Embedded Python runtime is closed.");
+        emit finished(m_id);
+    }
+#endif
+
+    // a remote run only closes its instance, the connection is shared
+    if (m_kind == Kind::Remote) {
+        if (m_client)
+            m_client->closeInstance(m_instance);
+    } else if (m_client && m_client->isConnected()) {
+        m_client->disconnectFromServer();
+    }
+
+    if (m_process && m_process->state() != QProcess::NotRunning) {
+        m_process->terminate();
+        if (!m_process->waitForFinished(3000)) { // Wait 3s
+            qWarning() << "[FsmRun] Python FSM process did not terminate gracefully. Forcing kill.";
+            m_process->kill();
+            m_process->waitForFinished();
+        }
+    }
+}
+
+bool FsmRun::hasRuntime() const
+{
+    if (m_kind == Kind::Remote)
+        return isRunning();
+    return m_embeddedOpen || (m_client && m_client->isConnected());
+}
+
+QString FsmRun::defaultEndpoint(int id)
+{
+#ifdef Q_OS_UNIX
+    // unique per editor and run, the runtime removes a stale socket file
+    return "unix:" + QDir::tempPath() + "/icp-" + QString::number(QCoreApplication::applicationPid())
+           + "-" + QString::number(id) + ".sock";
+#else
+    Q_UNUSED(id);
+    return "tcp://localhost:0"; // the runtime would listen on AF_UNIX, QLocalSocket uses named pipes here
+#endif
+}
+
+QString FsmRun::valueToString(const QJsonValue &value)
+{
+    if (value.isString())
+        return value.toString();
+    if (value.isDouble())
+        return QString::number(value.toDouble());
+    if (value.isBool())
+        return value.toBool() ? "true" : "false";
+    if (value.isNull())
+        return "null";
+    return QString::fromUtf8(QJsonDocument(QJsonObject{{"unknown_type", value}}).toJson(QJsonDocument::Compact));
+}
+
+void FsmRun::onConnected()
+{
+    emit logMessage(m_id, "CLIENT: Connected to FSM server.");
+
+    // the daemon was started by the editor, send it the automaton now
+    if (!m_pendingScript.isEmpty()) {
+        m_client->sendLoadAutomaton(m_pendingScript);
+        m_pendingScript.clear();
+    }
+}
+
+void FsmRun::onMessageReceived(const QJsonObject &message)
+{
+    const QString type = message["type"].toString();
+    const QJsonObject payload = message["payload"].toObject();
+
+    if (type == "CURRENT_STATE") {
+        m_currentState = payload["name"].toString();
+    } else if (type == "VARIABLE_UPDATE") {
+        m_variables[payload["name"].toString()] = valueToString(payload["value"]);
+    } else if (type == "VARIABLES_BATCH") {
+        const QJsonObject changed = payload["variables"].toObject();
+        for (auto it = changed.constBegin(); it != changed.constEnd(); ++it)
+            m_variables[it.key()] = valueToString(it.value());
+    } else if (type == "PROFILE") {
+        m_profile = payload;
+    } else if (type == "CHECKPOINT") {
+        saveCheckpoint(payload);
+    } else if (type == "AUTOMATON_LOADED") {
+        // a new automaton starts from scratch
+        m_currentState.clear();
+        m_variables.clear();
+        m_profile = QJsonObject();
+        m_fsmActive = false;
+    } else if (type == "FSM_STARTED") {
+        m_fsmActive = true;
+    } else if (type == "FSM_FINISHED" || type == "FSM_STUCK" || type == "FSM_STOPPED" || type == "FSM_ERROR") {
+        m_fsmActive = false;
+        if (type == "FSM_FINISHED" && !m_checkpointFile.isEmpty())
+            QFile::remove(m_checkpointFile);
+    } else if (type == "FUNCTIONS_RELOADED" && payload.contains("error")) {
+        // nothing was replaced, the next change restarts the automaton
+        m_functions = InterpretGenerator::ScriptFunctions();
+    }
+
+    if (m_trace)
+        recordTrace(type, payload);
+
+    emit messageReceived(m_id, message);
+}
+
+void FsmRun::recordTrace(const QString &type, const QJsonObject &payload)
+{
+    auto recordValue = [this](const QString &name, const QJsonValue &value) {
+        TraceValue traceValue{};
+        if (value.isDouble()) {
+            traceValue.number = value.toDouble();
+            m_trace->recordVariable(name.toStdString(), TraceValueKind::Number, traceValue);
+        } else if (value.isBool()) {
+            traceValue.integer = value.toBool() ? 1 : 0;
+            m_trace->recordVariable(name.toStdString(), TraceValueKind::Bool, traceValue);
+        } else if (value.isString()) {
+            m_trace->recordVariable(name.toStdString(), value.toString().toStdString());
+        } else if (value.isNull()) {
+            m_trace->recordVariable(name.toStdString(), TraceValueKind::None, traceValue);
+        } else {
+            m_trace->recordVariable(name.toStdString(), valueToString(value).toStdString());
+        }
+    };
+
+    if (type == "CURRENT_STATE") {
+        m_trace->recordState(TraceEvent::State, payload["name"].toString().toStdString());
+    } else if (type == "VARIABLE_UPDATE") {
+        recordValue(payload["name"].toString(), payload["value"]);
+    } else if (type == "VARIABLES_BATCH") {
+        const QJsonObject changed = payload["variables"].toObject();
+        for (auto it = changed.constBegin(); it != changed.constEnd(); ++it)
+            recordValue(it.key(), it.value());
+    } else if (type == "TRANSITION_TAKEN") {
+        m_trace->recordTransition(TraceEvent::Transition, payload["from_state"].toString().toStdString(),
+                                  payload["to_state"].toString().toStdString());
+    } else if (type == "TRANSITION_ACTION_EXECUTED") {
+        m_trace->recordTransition(TraceEvent::TransitionAction, payload["from_state"].toString().toStdString(),
+                                  payload["to_state"].toString().toStdString());
+    } else if (type == "STATE_ACTION_EXECUTED") {
+        m_trace->recordState(TraceEvent::StateAction, payload["state_name"].toString().toStdString());
+    } else if (type == "FSM_STARTED") {
+        m_trace->recordState(TraceEvent::Started, payload["start_state"].toString().toStdString());
+    } else if (type == "FSM_FINISHED") {
+        m_trace->recordState(TraceEvent::Finished, payload["finish_state"].toString().toStdString());
+    } else if (type == "FSM_STUCK") {
+        m_trace->recordState(TraceEvent::Stuck, payload["state_name"].toString().toStdString());
+    } else if (type == "FSM_STOPPED") {
+        m_trace->recordEvent(TraceEvent::Stopped);
+    } else if (type == "FSM_ERROR") {
+        m_trace->recordError(payload["message"].toString().toStdString());
+    } else if (type == "AUTOMATON_LOADED") {
+        m_trace->recordEvent(TraceEvent::Loaded);
+    }
+}
+
+void FsmRun::onReadyReadStdOut()
+{
+    m_stdOutBuffer += m_process->readAllStandardOutput();
+
+    qsizetype newline;
+    while ((newline = m_stdOutBuffer.indexOf('\n')) >= 0) {
+        const QByteArray line = m_stdOutBuffer.left(newline + 1);
+        m_stdOutBuffer.remove(0, newline + 1);
+
+        // the interpret announces the endpoint it listens on, older ones a bare TCP port
+        if (m_endpoint.isEmpty() && line.startsWith("READY ")) {
+            const QString endpoint = QString::fromUtf8(line.mid(6).trimmed());
+            if (m_client->connectToEndpoint(endpoint)) {
+                qInfo() << "[FsmRun]" << m_id << "Python FSM server is ready on" << endpoint;
+                m_endpoint = endpoint;
+                continue;
+            }
+        }
+
+        if (m_logFile.isOpen())
+            m_logFile.write(line);
+    }
+
+    if (m_logFile.isOpen())
+        m_logFile.flush();
+}
+
+void FsmRun::onProcessFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    qInfo() << "[FsmRun]" << m_id << "Python FSM process finished. Exit code:" << exitCode << "Status:" << exitStatus;
+
+    // the rest of the output goes to the log, a last line may miss the newline
+    onReadyReadStdOut();
+    if (m_logFile.isOpen()) {
+        m_logFile.write(m_stdOutBuffer);
+        m_logFile.close();
+    }
+    m_stdOutBuffer.clear();
+
+    emit logMessage(m_id, "Python FSM process is not running.");
+    emit finished(m_id);
+}
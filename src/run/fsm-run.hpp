@@ -0,0 +1,306 @@
+/**
+ * @file fsm-run.hpp
+ * @brief Declaration of the FsmRun class, one running automaton of the editor.
+ *
+ * A run owns everything a running automaton needs: either a Python process with its own
+ * FsmClient and log, a runtime of the embedded interpreter, a native FsmEngine or an instance
+ * on a multiplexed connection to a remote daemon, shared with other runs. The editor
+ * keeps a pool of runs; all of them are serviced by the Qt event loop, so several automata
+ * run side by side.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#ifndef FSM_RUN_HPP
+#define FSM_RUN_HPP
+
+#include <QObject>
+#include <QByteArray>
+#include <QFile>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <QMap>
+#include <QPointer>
+#include <QProcess>
+#include <QProcessEnvironment>
+#include <QString>
+#include <QStringList>
+
+#include <memory>
+
+#include "../interpret_generator.h"
+#include "../spec_parser/automaton-data.hpp"
+#include "../trace/trace-recorder.hpp"
+
+class FsmClient;
+class FsmEngine;
+
+/**
+ * @class FsmRun
+ * @brief One automaton run, in a Python process, in the embedded interpreter or in the native engine.
+ *
+ * The run forwards the FSM messages with its id, so one slot serves the whole pool. It also
+ * remembers the current state and the variable values, so the editor can show any run.
+ */
+class FsmRun : public QObject
+{
+    Q_OBJECT
+public:
+    enum class Kind
+    {
+        Interpret,  ///< generated script, the process ends with the FSM
+        Daemon,     ///< warm runtime daemon, loads one automaton after another
+        Embedded,   ///< runtime of the interpreter linked into the editor, loads like the daemon
+        Engine,     ///< native in-process engine
+        Remote      ///< instance on a multiplexed daemon connection, see FsmClient::setMultiplexed()
+    };
+
+    /**
+     * @brief Constructs the FsmRun object.
+     * @param id Id of the run, unique in the editor session.
+     * @param parent The parent QObject.
+     */
+    explicit FsmRun(int id, QObject *parent = nullptr);
+
+    /**
+     * @brief Destructor, kills the Python process and stops the engine.
+     */
+    ~FsmRun();
+
+    int id() const { return m_id; }
+    Kind kind() const { return m_kind; }
+    QString name() const { return "Run " + QString::number(m_id); }
+    const QString& logFilePath() const { return m_logFilePath; }
+
+    /**
+     * @brief Checks if the Python process or the engine runs.
+     */
+    bool isRunning() const;
+
+    /**
+     * @brief Checks if the run is a warm daemon or an embedded runtime that can load another automaton.
+     */
+    bool isDaemon() const { return (m_kind == Kind::Daemon || m_kind == Kind::Embedded) && isRunning(); }
+
+    /**
+     * @brief Starts a Python process, the client connects once it prints its READY line.
+     *
+     * The runtime listens on FSM_ENDPOINT of the environment, defaultEndpoint() if it is not set.
+     * @param program The Python executable.
+     * @param arguments Arguments of the interpreter.
+     * @param environment Environment of the process.
+     * @param logFilePath Log of the standard output and error.
+     * @param script Written to the standard input, which is then closed, if not empty.
+     * @param daemon The process is the runtime daemon.
+     * @return False if the process did not start.
+     */
+    bool startPython(const QString &program, const QStringList &arguments,
+                     const QProcessEnvironment &environment, const QString &logFilePath,
+                     const QByteArray &script, bool daemon);
+
+    /**
+     * @brief Opens a runtime of the embedded interpreter, started with fsm_core on first use.
+     *
+     * The runtime loads the automaton sent by loadAutomaton(); its messages arrive without a
+     * connection, no process is started.
+     * @param runtimeDir Directory with the fsm_core package.
+     * @return False if the editor is built without ICP_EMBEDDED_PYTHON or Python did not start.
+     */
+    bool startEmbedded(const QString &runtimeDir);
+
+    /**
+     * @brief Runs the script as an instance of a multiplexed connection, shared with other runs.
+     *
+     * The instance id is the run id. The run ends when the connection does; the client is
+     * owned by the caller and may be connecting still, the script waits for it.
+     * @param client A client with FsmClient::setMultiplexed().
+     * @param script The generated interpret, defines build_fsm().
+     */
+    void startRemote(FsmClient *client, const QByteArray &script);
+
+    /**
+     * @brief Checks if the editor is built with the embedded interpreter.
+     */
+    static bool embeddedAvailable();
+
+    /**
+     * @brief Runs the automaton in a native engine owned by the run.
+     * @param virtualTime Delays advance a simulated clock instead of waiting.
+     * @param profile The engine reports PROFILE messages.
+     * @param compiled The engine runs the automaton compiled to C++ (see FsmEngine::setCompiled()).
+     * @param checkpoint A checkpoint of the automaton the run resumes from, see setCheckpointFile().
+     * @return False if the automaton does not compile or the checkpoint is not one of it.
+     */
+    bool startEngine(const Automaton &automaton, bool virtualTime = false, bool profile = false, bool compiled = false,
+                     const QByteArray &checkpoint = QByteArray());
+
+    /**
+     * @brief Saves the checkpoints of the next native run to the file, call before startEngine().
+     *
+     * Every CHECKPOINT of the engine replaces the file; it is removed when the automaton
+     * finishes, there is nothing to resume then.
+     * @param path The checkpoint file.
+     * @param intervalMs The engine checkpoints the run at this interval and when it is
+     *                   stopped, 0 only on requestCheckpoint().
+     */
+    void setCheckpointFile(const QString &path, int intervalMs = 0);
+
+    /**
+     * @brief Asks the native engine for a checkpoint, saved to the checkpoint file.
+     * @return False if the run is not a native run.
+     */
+    bool requestCheckpoint();
+
+    /**
+     * @brief Sends the script to the daemon, now or once the client is connected, or to the embedded runtime.
+     * @param script The generated interpret, defines build_fsm().
+     */
+    void loadAutomaton(const QByteArray &script);
+
+    /**
+     * @brief Remembers the functions of the script the interpret runs, see reloadFunctions().
+     */
+    void setScriptFunctions(const InterpretGenerator::ScriptFunctions &functions) { m_functions = functions; }
+
+    /**
+     * @brief Patches the running interpret with the functions of a new script of the automaton.
+     *
+     * Only the functions whose code differs from the running version are sent, in one
+     * RELOAD_FUNCTIONS message; the FSM keeps its current state and variables.
+     * @param functions InterpretGenerator::scriptFunctions() of the edited automaton.
+     * @return False if the run cannot be patched: its FSM does not run, the functions of the
+     *         running script are not known or anything but the function code has changed.
+     */
+    bool reloadFunctions(const InterpretGenerator::ScriptFunctions &functions);
+
+    /**
+     * @brief Sets a variable of the running FSM.
+     */
+    void setVariable(const QString &name, const QJsonValue &value);
+
+    /**
+     * @brief Sets several variables of the running FSM in one command.
+     */
+    void setVariables(const QJsonObject &values);
+
+    /**
+     * @brief Records the messages of the FSM to a binary trace from now on.
+     * @param path The .fsmtrace file, overwritten.
+     * @return False if the file cannot be created.
+     */
+    bool startTrace(const QString &path);
+
+    /**
+     * @brief Asks the runtime for a STATS message, see FsmClient::sendGetStats().
+     * @return False if the run has no runtime connection (the native engine has no STATS).
+     */
+    bool requestStats(double intervalSeconds = -1);
+
+    /**
+     * @brief Bytes the editor has queued for the runtime and not yet written.
+     */
+    qint64 pendingClientBytes() const;
+
+    /**
+     * @brief Capacity of the buffers of the runtime connection, 0 without one or on a shared one.
+     */
+    qint64 clientBufferBytes() const;
+
+    /**
+     * @brief Asks the FSM to stop, the process and the connection stay.
+     */
+    void stop();
+
+    /**
+     * @brief Stops the FSM and kills the Python process or closes the embedded runtime.
+     */
+    void terminate();
+
+    /**
+     * @brief Last state reported by the FSM.
+     */
+    const QString& currentState() const { return m_currentState; }
+
+    /**
+     * @brief Last values reported by the FSM, formatted by valueToString().
+     */
+    const QMap<QString, QString>& variableValues() const { return m_variables; }
+
+    /**
+     * @brief Payload of the last PROFILE message, empty if the run is not profiled.
+     */
+    const QJsonObject& profile() const { return m_profile; }
+
+    /**
+     * @brief Endpoint a runtime of the run listens on when the environment has no FSM_ENDPOINT.
+     * @return A local socket in the temporary directory, tcp://localhost:0 (any port) on Windows.
+     */
+    static QString defaultEndpoint(int id);
+
+    /**
+     * @brief Formats a variable value of a VARIABLE_UPDATE message for the variable panel.
+     */
+    static QString valueToString(const QJsonValue &value);
+
+signals:
+    /**
+     * @brief Emitted for every message of the FSM.
+     */
+    void messageReceived(int runId, const QJsonObject &message);
+
+    /**
+     * @brief Emitted for the events of the process, the client and the engine.
+     */
+    void logMessage(int runId, const QString &line);
+
+    /**
+     * @brief Emitted when the process has ended, the engine has finished or the embedded runtime is closed.
+     */
+    void finished(int runId);
+
+private slots:
+    void onConnected();
+    void onMessageReceived(const QJsonObject &message);
+    void onReadyReadStdOut();
+    void onProcessFinished(int exitCode, QProcess::ExitStatus exitStatus);
+
+private:
+    void recordTrace(const QString &type, const QJsonObject &payload);
+
+    /**
+     * @brief Writes the blob of a CHECKPOINT message to the checkpoint file.
+     */
+    void saveCheckpoint(const QJsonObject &payload);
+
+    /**
+     * @brief Checks if commands reach a runtime, over the client or in process.
+     */
+    bool hasRuntime() const;
+
+    int m_id;                        ///< Id of the run.
+    Kind m_kind = Kind::Interpret;   ///< What runs the automaton.
+    QPointer<FsmClient> m_client;    ///< Connection to the Python process, shared by the remote runs.
+    int m_instance = -1;             ///< Instance of a remote run on m_client, -1 on an own connection.
+    QProcess *m_process = nullptr;   ///< The Python process.
+    FsmEngine *m_engine = nullptr;   ///< The native engine.
+    bool m_embeddedOpen = false;     ///< The run has a runtime in the embedded interpreter.
+
+    QString m_logFilePath;           ///< Log of the Python process.
+    QFile m_logFile;                 ///< Standard output of the process except the READY line.
+    QByteArray m_stdOutBuffer;       ///< Incomplete line of the standard output.
+    QString m_endpoint;              ///< Endpoint of the READY line, empty before it.
+    QByteArray m_pendingScript;      ///< Sent to the daemon once the client connects.
+    QString m_checkpointFile;        ///< see setCheckpointFile()
+    int m_checkpointIntervalMs = 0;  ///< see setCheckpointFile()
+    InterpretGenerator::ScriptFunctions m_functions;  ///< Functions of the running script, as patched.
+    bool m_fsmActive = false;        ///< Between FSM_STARTED and the message that ends the run.
+
+    std::unique_ptr<TraceRecorder> m_trace;  ///< Binary trace of the messages, nullptr if not recorded.
+
+    QString m_currentState;              ///< Last CURRENT_STATE of the FSM.
+    QMap<QString, QString> m_variables;  ///< Last VARIABLE_UPDATE of every variable.
+    QJsonObject m_profile;               ///< Last PROFILE of the FSM.
+};
+
+#endif // FSM_RUN_HPP
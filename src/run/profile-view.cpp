@@ -0,0 +1,103 @@
+/**
+ * @file profile-view.cpp
+ * @brief Implementation of the ProfileView class.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#include "profile-view.hpp"
+
+#include <QHeaderView>
+#include <QJsonArray>
+#include <QLabel>
+#include <QTableWidget>
+#include <QVBoxLayout>
+
+namespace {
+
+enum Column { Kind, Name, Count, Successes, Time, Wait, ColumnCount };
+
+QTableWidgetItem* textItem(const QString &text)
+{
+    auto *item = new QTableWidgetItem(text);
+    item->setFlags(Qt::ItemIsSelectable | Qt::ItemIsEnabled);
+    return item;
+}
+
+/// The value is kept as a number, the column sorts numerically.
+QTableWidgetItem* numberItem(double value)
+{
+    auto *item = new QTableWidgetItem();
+    item->setData(Qt::DisplayRole, value);
+    item->setFlags(Qt::ItemIsSelectable | Qt::ItemIsEnabled);
+    item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+    return item;
+}
+
+} // namespace
+
+ProfileView::ProfileView(QWidget *parent)
+    : QDialog(parent)
+    , m_summary(new QLabel(this))
+    , m_table(new QTableWidget(0, ColumnCount, this))
+{
+    setWindowTitle(tr("Hot spots"));
+    resize(640, 420);
+
+    m_table->setHorizontalHeaderLabels({tr("Kind"), tr("Name"), tr("Count"), tr("Successes"),
+                                        tr("Time [ms]"), tr("Wait [ms]")});
+    m_table->horizontalHeader()->setSectionResizeMode(Name, QHeaderView::Stretch);
+    m_table->verticalHeader()->hide();
+    m_table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    m_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_table->setSortingEnabled(true);
+    m_table->sortByColumn(Time, Qt::DescendingOrder);
+
+    auto *layout = new QVBoxLayout(this);
+    layout->addWidget(m_summary);
+    layout->addWidget(m_table);
+
+    setProfile(QJsonObject());
+}
+
+void ProfileView::setProfile(const QJsonObject &profile)
+{
+    const QJsonArray states = profile["states"].toArray();
+    const QJsonArray transitions = profile["transitions"].toArray();
+
+    if (states.isEmpty() && transitions.isEmpty())
+        m_summary->setText(tr("No profile, run the automaton in the native engine with Run > Profile run."));
+    else
+        m_summary->setText(tr("%1 states, %2 transitions").arg(states.size()).arg(transitions.size()));
+
+    // the rows are filled unsorted, the order of the header is applied once at the end
+    m_table->setSortingEnabled(false);
+    m_table->setRowCount(states.size() + transitions.size());
+
+    int row = 0;
+    for (const QJsonValue &value : states) {
+        const QJsonObject state = value.toObject();
+        m_table->setItem(row, Kind, textItem(tr("State")));
+        m_table->setItem(row, Name, textItem(state["name"].toString()));
+        m_table->setItem(row, Count, numberItem(state["entries"].toDouble()));
+        m_table->setItem(row, Successes, textItem(QString()));
+        m_table->setItem(row, Time, numberItem(state["action_ms"].toDouble()));
+        m_table->setItem(row, Wait, numberItem(state["delay_ms"].toDouble()));
+        ++row;
+    }
+    for (const QJsonValue &value : transitions) {
+        const QJsonObject transition = value.toObject();
+        const QString name = transition["from_state"].toString() + " -> " + transition["to_state"].toString()
+                             + " #" + QString::number(transition["priority"].toInt());
+        m_table->setItem(row, Kind, textItem(tr("Transition")));
+        m_table->setItem(row, Name, textItem(name));
+        m_table->setItem(row, Count, numberItem(transition["evaluations"].toDouble()));
+        m_table->setItem(row, Successes, numberItem(transition["successes"].toDouble()));
+        m_table->setItem(row, Time, numberItem(transition["condition_ms"].toDouble()));
+        m_table->setItem(row, Wait, textItem(QString()));
+        ++row;
+    }
+
+    m_table->setSortingEnabled(true);
+}
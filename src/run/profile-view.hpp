@@ -0,0 +1,46 @@
+/**
+ * @file profile-view.hpp
+ * @brief Declaration of the ProfileView class, the hot spots of a profiled run.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#ifndef PROFILE_VIEW_HPP
+#define PROFILE_VIEW_HPP
+
+#include <QDialog>
+#include <QJsonObject>
+
+class QLabel;
+class QTableWidget;
+
+/**
+ * @class ProfileView
+ * @brief Table of the states and transitions of a PROFILE message.
+ *
+ * A row per state and per transition, sortable by any column; the numbers are kept
+ * as numbers, so the sort is numeric. The dialog is not modal, the editor refreshes
+ * it with the profile of the shown run.
+ */
+class ProfileView : public QDialog
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief Constructs the ProfileView object.
+     * @param parent The parent widget.
+     */
+    explicit ProfileView(QWidget *parent = nullptr);
+
+    /**
+     * @brief Shows the payload of a PROFILE message, an empty one clears the table.
+     */
+    void setProfile(const QJsonObject &profile);
+
+private:
+    QLabel *m_summary;
+    QTableWidget *m_table;
+};
+
+#endif // PROFILE_VIEW_HPP
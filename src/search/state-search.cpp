@@ -0,0 +1,76 @@
+/**
+ * @file state-search.cpp
+ * @brief Implementation of the StateSearch class.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#include "state-search.hpp"
+
+#include "../DynamicPortsModel.hpp"
+
+#include <QLineEdit>
+#include <QListWidget>
+#include <QVBoxLayout>
+
+StateSearch::StateSearch(DynamicPortsModel &model, QWidget *parent)
+    : QWidget(parent)
+    , m_model(model)
+    , m_field(new QLineEdit(this))
+    , m_results(new QListWidget(this))
+{
+    m_field->setPlaceholderText(tr("Name, action or condition"));
+    m_field->setClearButtonEnabled(true);
+
+    auto *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addWidget(m_field);
+    layout->addWidget(m_results);
+
+    connect(m_field, &QLineEdit::textChanged, this, &StateSearch::refresh);
+    connect(m_field, &QLineEdit::returnPressed, this, [this]() {
+        if (m_results->count() > 0)
+            onItemActivated(m_results->item(0));
+    });
+    connect(m_results, &QListWidget::itemActivated, this, &StateSearch::onItemActivated);
+    connect(m_results, &QListWidget::itemClicked, this, &StateSearch::onItemActivated);
+}
+
+void StateSearch::activate()
+{
+    // the model may have changed since the last keystroke
+    refresh();
+    m_field->setFocus();
+    m_field->selectAll();
+}
+
+void StateSearch::refresh()
+{
+    m_results->clear();
+
+    const QString text = m_field->text();
+    if (text.isEmpty())
+        return;
+
+    using Field = DynamicPortsModel::SearchMatch::Field;
+    for (const DynamicPortsModel::SearchMatch &match : m_model.Search(text, kMaxResults)) {
+        // the texts themselves are not shown, a lazily loaded action stays unread
+        QString label = m_model.GetNodeName(match.nodeId);
+        if (match.field == Field::Action)
+            label = tr("%1 (action)").arg(label);
+        else if (match.field == Field::Condition)
+            label = tr("%1 -> %2 (condition)").arg(label, m_model.GetNodeName(match.connectionId.inNodeId));
+
+        auto *item = new QListWidgetItem(label, m_results);
+        item->setData(Qt::UserRole, static_cast<qulonglong>(match.nodeId));
+    }
+}
+
+void StateSearch::onItemActivated(QListWidgetItem *item)
+{
+    const auto nodeId = static_cast<QtNodes::NodeId>(item->data(Qt::UserRole).toULongLong());
+    // a result listed before the state was deleted
+    if (m_model.nodeExists(nodeId))
+        emit stateActivated(nodeId);
+}
@@ -0,0 +1,62 @@
+/**
+ * @file state-search.hpp
+ * @brief Declaration of the StateSearch class, the search box of the states.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#ifndef STATE_SEARCH_HPP
+#define STATE_SEARCH_HPP
+
+#include <QWidget>
+
+#include <QtNodes/Definitions>
+
+class DynamicPortsModel;
+class QLineEdit;
+class QListWidget;
+class QListWidgetItem;
+
+/**
+ * @class StateSearch
+ * @brief Search field with the states matching it, updated as the user types.
+ *
+ * Looks up the names, actions and conditions with DynamicPortsModel::Search(), which
+ * answers from its index, so the list is refreshed on every keystroke. Activating a
+ * result, or pressing Enter in the field for the first one, emits stateActivated().
+ */
+class StateSearch : public QWidget
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief Constructs the StateSearch object.
+     * @param model The model searched.
+     * @param parent The parent widget.
+     */
+    explicit StateSearch(DynamicPortsModel &model, QWidget *parent = nullptr);
+
+    /**
+     * @brief Focuses the field and selects its text, the results are refreshed.
+     */
+    void activate();
+
+signals:
+    /**
+     * @brief A result was chosen, the state of a condition is its source state.
+     */
+    void stateActivated(QtNodes::NodeId nodeId);
+
+private:
+    void refresh();                             ///< Fills the list for the text of the field.
+    void onItemActivated(QListWidgetItem *item);
+
+    static constexpr int kMaxResults = 100;     ///< results listed at most
+
+    DynamicPortsModel &m_model;
+    QLineEdit *m_field;
+    QListWidget *m_results;
+};
+
+#endif // STATE_SEARCH_HPP
@@ -0,0 +1,223 @@
+/**
+ * @file text-index.cpp
+ * @brief Implementation of the TextIndex class.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#include "text-index.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <type_traits>
+
+std::string TextIndex::fold(std::string_view text)
+{
+    std::string folded(text);
+    for (char &c : folded) {
+        if (c >= 'A' && c <= 'Z')
+            c = static_cast<char>(c - 'A' + 'a');
+    }
+    return folded;
+}
+
+TextIndex::Gram TextIndex::gram(std::string_view bytes, bool prefix)
+{
+    Gram g = static_cast<Gram>(bytes.size()) << 24;
+    if (prefix)
+        g |= Gram(1) << 26;
+    for (std::size_t i = 0; i < bytes.size(); ++i)
+        g |= static_cast<Gram>(static_cast<unsigned char>(bytes[i])) << (8 * i);
+    return g;
+}
+
+std::vector<TextIndex::Gram> TextIndex::grams(std::string const &folded)
+{
+    std::vector<Gram> result;
+    const std::string_view text(folded);
+    result.reserve(3 * text.size() + 3);
+
+    for (std::size_t n = 1; n <= 3 && n <= text.size(); ++n) {
+        result.push_back(gram(text.substr(0, n), true));
+        for (std::size_t i = 0; i + n <= text.size(); ++i)
+            result.push_back(gram(text.substr(i, n), false));
+    }
+
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+void TextIndex::addPosting(Gram g, Doc doc)
+{
+    std::vector<Doc> &docs = _postings[g];
+    docs.insert(std::lower_bound(docs.begin(), docs.end(), doc), doc);
+}
+
+void TextIndex::removePosting(Gram g, Doc doc)
+{
+    auto it = _postings.find(g);
+    if (it == _postings.end())
+        return;
+
+    std::vector<Doc> &docs = it->second;
+    auto pos = std::lower_bound(docs.begin(), docs.end(), doc);
+    if (pos != docs.end() && *pos == doc)
+        docs.erase(pos);
+    if (docs.empty())
+        _postings.erase(it);
+}
+
+void TextIndex::set(Key key, std::string_view text)
+{
+    std::string folded = fold(text);
+    if (folded.empty()) {
+        remove(key);
+        return;
+    }
+
+    auto slot = _slots.find(key);
+    if (slot != _slots.end()) {
+        Document &document = _documents[slot->second];
+        if (document.text == folded)
+            return;
+
+        // an edit changes a few grams of the text, only those posting lists are touched
+        const std::vector<Gram> before = grams(document.text);
+        const std::vector<Gram> after = grams(folded);
+        std::vector<Gram> changed;
+        std::set_difference(before.begin(), before.end(), after.begin(), after.end(),
+                            std::back_inserter(changed));
+        for (Gram g : changed)
+            removePosting(g, slot->second);
+
+        changed.clear();
+        std::set_difference(after.begin(), after.end(), before.begin(), before.end(),
+                            std::back_inserter(changed));
+        for (Gram g : changed)
+            addPosting(g, slot->second);
+
+        document.text = std::move(folded);
+        return;
+    }
+
+    Doc doc;
+    if (!_freeDocuments.empty()) {
+        doc = _freeDocuments.back();
+        _freeDocuments.pop_back();
+    } else {
+        doc = static_cast<Doc>(_documents.size());
+        _documents.emplace_back();
+    }
+
+    for (Gram g : grams(folded))
+        addPosting(g, doc);
+
+    Document &document = _documents[doc];
+    document.key = key;
+    document.text = std::move(folded);
+    _slots.emplace(key, doc);
+}
+
+void TextIndex::remove(Key key)
+{
+    auto slot = _slots.find(key);
+    if (slot == _slots.end())
+        return;
+
+    const Doc doc = slot->second;
+    Document &document = _documents[doc];
+    for (Gram g : grams(document.text))
+        removePosting(g, doc);
+
+    document = Document();
+    _freeDocuments.push_back(doc);
+    _slots.erase(slot);
+}
+
+void TextIndex::clear()
+{
+    _documents.clear();
+    _freeDocuments.clear();
+    _slots.clear();
+    _postings.clear();
+}
+
+std::vector<TextIndex::Key> TextIndex::find(std::string_view query,
+                                            TextMatch match,
+                                            std::size_t limit) const
+{
+    std::vector<Key> result;
+    const std::string folded = fold(query);
+    if (folded.empty() || limit == 0)
+        return result;
+
+    const std::string_view q(folded);
+    const bool prefix = match == TextMatch::Prefix;
+
+    // a short query is a gram itself, its posting list is the answer
+    std::vector<Gram> needed;
+    if (q.size() <= 3) {
+        needed.push_back(gram(q, prefix));
+    } else {
+        if (prefix)
+            needed.push_back(gram(q.substr(0, 3), true));
+        for (std::size_t i = prefix ? 1 : 0; i + 3 <= q.size(); ++i)
+            needed.push_back(gram(q.substr(i, 3), false));
+    }
+
+    std::vector<std::vector<Doc> const *> lists;
+    lists.reserve(needed.size());
+    for (Gram g : needed) {
+        auto it = _postings.find(g);
+        if (it == _postings.end())
+            return result;
+        lists.push_back(&it->second);
+    }
+
+    // the shortest list drives, the others are only probed
+    std::sort(lists.begin(), lists.end(), [](auto const *a, auto const *b) {
+        return a->size() < b->size();
+    });
+
+    for (Doc doc : *lists.front()) {
+        bool candidate = true;
+        for (std::size_t i = 1; i < lists.size() && candidate; ++i)
+            candidate = std::binary_search(lists[i]->begin(), lists[i]->end(), doc);
+        if (!candidate)
+            continue;
+
+        Document const &document = _documents[doc];
+        if (q.size() > 3) {
+            // the trigrams may all occur without occurring in sequence
+            const bool matches = prefix ? document.text.compare(0, q.size(), q) == 0
+                                        : document.text.find(q) != std::string::npos;
+            if (!matches)
+                continue;
+        }
+
+        result.push_back(document.key);
+        if (result.size() == limit)
+            break;
+    }
+
+    return result;
+}
+
+std::size_t TextIndex::byteSize() const
+{
+    // a hash map node holds the value and two pointers, the buckets one pointer each
+    auto mapBytes = [](auto const &map) {
+        using Value = typename std::decay_t<decltype(map)>::value_type;
+        return map.bucket_count() * sizeof(void *) + map.size() * (sizeof(Value) + 2 * sizeof(void *));
+    };
+
+    std::size_t bytes = _documents.capacity() * sizeof(Document) + _freeDocuments.capacity() * sizeof(Doc)
+                        + mapBytes(_slots) + mapBytes(_postings);
+    for (Document const &document : _documents)
+        bytes += document.text.capacity() > sizeof(std::string) - 1 ? document.text.capacity() + 1 : 0;
+    for (auto const &posting : _postings)
+        bytes += posting.second.capacity() * sizeof(Doc);
+    return bytes;
+}
@@ -0,0 +1,95 @@
+/**
+ * @file text-index.hpp
+ * @brief Incremental substring index over short texts (state names, actions, conditions).
+ *
+ * Every document is split into its distinct 1, 2 and 3 byte grams, and the first up to
+ * three bytes are also indexed as prefix grams. A query of up to three bytes is answered
+ * by one posting list, a longer one by intersecting the posting lists of its trigrams and
+ * checking the candidates, so a lookup does not depend on the number of documents that
+ * cannot match. Setting a document updates only the grams that changed.
+ *
+ * The index works on UTF-8 bytes and folds ASCII letters only, other characters match
+ * case-sensitively. It does not depend on Qt.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#ifndef TEXT_INDEX_HPP
+#define TEXT_INDEX_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+enum class TextMatch
+{
+    Substring,      ///< the query is anywhere in the text
+    Prefix          ///< the text starts with the query
+};
+
+/**
+ * @class TextIndex
+ * @brief Documents under 64 bit keys, queried by case-insensitive substring or prefix.
+ */
+class TextIndex
+{
+public:
+    using Key = uint64_t;
+
+    /**
+     * @brief Adds the document or replaces its text, an empty text removes it.
+     */
+    void set(Key key, std::string_view text);
+
+    /**
+     * @brief Removes the document, does nothing if it is not indexed.
+     */
+    void remove(Key key);
+
+    void clear();
+
+    /**
+     * @brief Keys of the documents matching the query, at most limit of them.
+     *
+     * The keys are in no particular order; an empty query matches nothing.
+     */
+    std::vector<Key> find(std::string_view query, TextMatch match, std::size_t limit) const;
+
+    std::size_t size() const { return _slots.size(); }
+
+    /**
+     * @brief Heap bytes of the texts, postings and maps, estimated from the capacities.
+     */
+    std::size_t byteSize() const;
+
+private:
+    /// Up to three bytes, their count and the prefix flag packed into one number.
+    using Gram = uint32_t;
+
+    /// Documents are numbered densely, the posting lists hold these numbers sorted.
+    using Doc = uint32_t;
+
+    struct Document
+    {
+        Key key = 0;
+        std::string text;        ///< folded text
+    };
+
+    static std::string fold(std::string_view text);
+    static Gram gram(std::string_view bytes, bool prefix);
+    static std::vector<Gram> grams(std::string const &folded);
+
+    void addPosting(Gram g, Doc doc);
+    void removePosting(Gram g, Doc doc);
+
+    std::vector<Document> _documents;
+    std::vector<Doc> _freeDocuments;                        ///< unused entries of _documents
+    std::unordered_map<Key, Doc> _slots;
+    std::unordered_map<Gram, std::vector<Doc>> _postings;   ///< sorted document numbers per gram
+};
+
+#endif // TEXT_INDEX_HPP
@@ -0,0 +1,260 @@
+/**
+ * @brief Compact binary (.fsmb) automaton format
+ * @author Jakub Kovarik
+ */
+
+#include "automaton-binary.hpp"
+#include "compiled-automaton.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// Collects the string blob and the tables while writing a file
+class FsmbWriter
+{
+public:
+    FsmbStringRef addString(std::string_view s)
+    {
+        FsmbStringRef ref{static_cast<uint32_t>(m_strings.size()), static_cast<uint32_t>(s.size())};
+        m_strings += s;
+        return ref;
+    }
+
+    // appends a table, sections start 8 byte aligned so the records can be read in place
+    template<typename T>
+    FsmbSection addTable(const std::vector<T>& table)
+    {
+        align();
+        FsmbSection section{m_body.size(), table.size()};
+        const char* bytes = reinterpret_cast<const char*>(table.data());
+        m_body.append(bytes, table.size() * sizeof(T));
+        return section;
+    }
+
+    FsmbSection addStrings()
+    {
+        align();
+        FsmbSection section{m_body.size(), m_strings.size()};
+        m_body += m_strings;
+        return section;
+    }
+
+    const std::string& body() const { return m_body; }
+
+private:
+    void align()
+    {
+        while (m_body.size() % 8)
+            m_body += '\0';
+    }
+
+    std::string m_strings;
+    std::string m_body = std::string(sizeof(FsmbHeader), '\0'); // reserve room for the header
+};
+
+bool AutomatonBinary::IsBinaryFile(const std::string& filename)
+{
+    static const std::string extension = ".fsmb";
+    return filename.size() >= extension.size() &&
+           filename.compare(filename.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+bool AutomatonBinary::ToFile(const std::string& filename, const Automaton& automaton, const std::vector<StateInfo>* statesInfo)
+{
+    const CompiledAutomaton compiled = CompiledAutomaton::FromAutomaton(automaton);
+    FsmbWriter writer;
+
+    FsmbHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, FsmbMagic, sizeof(header.magic));
+    header.version = FsmbVersion;
+    header.byteOrder = FsmbByteOrderMark;
+    header.startState = compiled.startState();
+    header.name = writer.addString(automaton.getName());
+    header.description = writer.addString(automaton.getDescription());
+
+    std::vector<FsmbStateRecord> states(compiled.stateCount());
+    std::vector<uint32_t> rowOffsets(compiled.stateCount() + 1, 0);
+    std::vector<FsmbTransitionRecord> transitions(compiled.transitionCount());
+    for (StateId id = 0; id < static_cast<StateId>(compiled.stateCount()); ++id) {
+        states[id].name = writer.addString(compiled.stateName(id));
+        states[id].action = writer.addString(compiled.stateAction(id));
+        states[id].flags = compiled.isFinalState(id) ? FsmbStateFinal : FsmbStateNone;
+
+        rowOffsets[id] = compiled.firstTransition(id);
+        rowOffsets[id + 1] = compiled.lastTransition(id);
+        for (uint32_t i = compiled.firstTransition(id); i < compiled.lastTransition(id); ++i) {
+            transitions[i].target = compiled.target(i);
+            transitions[i].delay = compiled.transition(i).delay;
+            transitions[i].condition = writer.addString(compiled.transition(i).condition);
+        }
+    }
+
+    std::vector<FsmbVariableRecord> variables;
+    variables.reserve(automaton.getVariables().size());
+    for (const auto& var : automaton.getVariables())
+        variables.push_back({writer.addString(var.name), writer.addString(var.value), static_cast<uint32_t>(var.type)});
+
+    std::vector<FsmbNodeInfoRecord> nodeInfos;
+    if (statesInfo) {
+        nodeInfos.reserve(statesInfo->size());
+        for (const auto& info : *statesInfo)
+            nodeInfos.push_back({writer.addString(info.name), info.posX, info.posY, info.inPortCount, info.outPortCount});
+    }
+
+    header.states = writer.addTable(states);
+    header.rowOffsets = writer.addTable(rowOffsets);
+    header.transitions = writer.addTable(transitions);
+    header.variables = writer.addTable(variables);
+    header.nodeInfos = writer.addTable(nodeInfos);
+    header.strings = writer.addStrings();
+
+    ofstream out(filename, std::ios::binary);
+    if (!out.is_open()) {
+        cerr << "Failed to open file: " << filename << endl;
+        return false;
+    }
+    const std::string& body = writer.body();
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(body.data() + sizeof(header), static_cast<std::streamsize>(body.size() - sizeof(header)));
+    return static_cast<bool>(out);
+}
+
+bool AutomatonBinary::FromFile(const std::string& filename, Automaton& outAutomaton, std::vector<StateInfo>* outStatesInfo)
+{
+    MappedAutomaton mapped(filename);
+    if (!mapped.isValid()) {
+        cerr << "Not a valid .fsmb file: " << filename << endl;
+        return false;
+    }
+    mapped.toAutomaton(outAutomaton, outStatesInfo);
+    return true;
+}
+
+MappedAutomaton::MappedAutomaton(const std::string& filename)
+    : m_file(filename)
+{
+    if (!validate())
+        m_header = nullptr;
+}
+
+bool MappedAutomaton::validate()
+{
+    const size_t size = m_file.size();
+    if (!m_file.ok() || size < sizeof(FsmbHeader))
+        return false;
+
+    const char* base = m_file.data();
+    m_header = reinterpret_cast<const FsmbHeader*>(base);
+    if (std::memcmp(m_header->magic, FsmbMagic, sizeof(FsmbMagic)) != 0 ||
+        m_header->version != FsmbVersion || m_header->byteOrder != FsmbByteOrderMark)
+        return false;
+
+    // every section has to fit into the file
+    auto fits = [size](const FsmbSection& section, size_t recordSize) {
+        return section.offset <= size && section.count <= (size - section.offset) / recordSize;
+    };
+    if (!fits(m_header->states, sizeof(FsmbStateRecord)) ||
+        !fits(m_header->rowOffsets, sizeof(uint32_t)) ||
+        !fits(m_header->transitions, sizeof(FsmbTransitionRecord)) ||
+        !fits(m_header->variables, sizeof(FsmbVariableRecord)) ||
+        !fits(m_header->nodeInfos, sizeof(FsmbNodeInfoRecord)) ||
+        !fits(m_header->strings, 1))
+        return false;
+    if (m_header->rowOffsets.count != m_header->states.count + 1)
+        return false;
+
+    m_states = reinterpret_cast<const FsmbStateRecord*>(base + m_header->states.offset);
+    m_rowOffsets = reinterpret_cast<const uint32_t*>(base + m_header->rowOffsets.offset);
+    m_transitions = reinterpret_cast<const FsmbTransitionRecord*>(base + m_header->transitions.offset);
+    m_variables = reinterpret_cast<const FsmbVariableRecord*>(base + m_header->variables.offset);
+    m_nodeInfos = reinterpret_cast<const FsmbNodeInfoRecord*>(base + m_header->nodeInfos.offset);
+    m_strings = base + m_header->strings.offset;
+
+    // string references and transition targets have to be in range too
+    const uint64_t stringsSize = m_header->strings.count;
+    auto validRef = [stringsSize](const FsmbStringRef& ref) {
+        return ref.offset <= stringsSize && ref.length <= stringsSize - ref.offset;
+    };
+    if (!validRef(m_header->name) || !validRef(m_header->description))
+        return false;
+
+    const uint64_t stateCount = m_header->states.count;
+    const uint64_t transitionCount = m_header->transitions.count;
+    if (m_header->startState < -1 || m_header->startState >= static_cast<int64_t>(stateCount))
+        return false;
+    if (m_rowOffsets[0] != 0 || m_rowOffsets[stateCount] != transitionCount)
+        return false;
+    for (uint64_t id = 0; id < stateCount; ++id) {
+        if (!validRef(m_states[id].name) || !validRef(m_states[id].action) || m_rowOffsets[id] > m_rowOffsets[id + 1])
+            return false;
+    }
+    for (uint64_t i = 0; i < transitionCount; ++i) {
+        if (m_transitions[i].target < 0 || m_transitions[i].target >= static_cast<int64_t>(stateCount) ||
+            !validRef(m_transitions[i].condition))
+            return false;
+    }
+    for (uint64_t i = 0; i < m_header->variables.count; ++i) {
+        if (!validRef(m_variables[i].name) || !validRef(m_variables[i].value))
+            return false;
+    }
+    for (uint64_t i = 0; i < m_header->nodeInfos.count; ++i) {
+        if (!validRef(m_nodeInfos[i].name))
+            return false;
+    }
+    return true;
+}
+
+void MappedAutomaton::toAutomaton(Automaton& automaton, std::vector<StateInfo>* outStatesInfo, SourceText* outText) const
+{
+    if (outText) {
+        *outText = SourceText();
+        outText->conditions.reserve(static_cast<size_t>(m_header->transitions.count));
+    }
+
+    automaton.reserve(stateCount(), static_cast<size_t>(m_header->transitions.count), variableCount());
+    automaton.setName(std::string(name()));
+    automaton.setDescription(std::string(description()));
+
+    for (uint32_t i = 0; i < variableCount(); ++i) {
+        const auto& var = m_variables[i];
+        automaton.addVariable(std::string(str(var.name)), std::string(str(var.value)), static_cast<VarDataType>(var.type));
+    }
+
+    std::vector<Symbol> names(stateCount());
+    for (uint32_t id = 0; id < stateCount(); ++id) {
+        names[id] = Symbol(std::string(stateName(id)));
+        if (outText) {
+            outText->actions[names[id]] = stateAction(id);
+            automaton.addState(names[id]);
+        } else {
+            automaton.addState(names[id], std::string(stateAction(id)));
+        }
+        if (isFinalState(id))
+            automaton.addFinalState(names[id]);
+    }
+    if (startState() >= 0)
+        automaton.setStartState(names[startState()]);
+
+    for (uint32_t id = 0; id < stateCount(); ++id) {
+        for (uint32_t i = firstTransition(id); i < lastTransition(id); ++i) {
+            Transition t;
+            t.fromState = names[id];
+            t.toState = names[m_transitions[i].target];
+            if (outText)
+                outText->conditions.push_back(condition(i));
+            else
+                t.condition = std::string(condition(i));
+            t.delay = m_transitions[i].delay;
+            automaton.addTransition(std::move(t));
+        }
+    }
+
+    if (outStatesInfo) {
+        for (uint32_t i = 0; i < nodeInfoCount(); ++i) {
+            const auto& info = m_nodeInfos[i];
+            outStatesInfo->push_back({std::string(str(info.name)), info.posX, info.posY, info.inPortCount, info.outPortCount});
+        }
+    }
+}
@@ -0,0 +1,123 @@
+/**
+ * @brief Compact binary (.fsmb) automaton format
+ *
+ * The file consists of fixed size tables that can be used directly from the
+ * mapped memory, no parsing is needed to read it:
+ *
+ *   header | states | CSR row offsets | transitions | variables | node infos | string blob
+ *
+ * All strings (names, actions, conditions, values) are stored once in the string
+ * blob and referenced by offset and length. Transitions are grouped by their source
+ * state, the row offsets table has stateCount + 1 entries. Integers are stored in
+ * the native byte order, the header records it so foreign files are rejected.
+ *
+ * @author Jakub Kovarik
+ */
+#ifndef AUTOMATON_BINARY_H
+#define AUTOMATON_BINARY_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "automaton-data.hpp"
+#include "automaton-parser.hpp"
+#include "mapped-file.hpp"
+
+constexpr char FsmbMagic[4] = {'F', 'S', 'M', 'B'};
+constexpr uint32_t FsmbVersion = 1;
+constexpr uint32_t FsmbByteOrderMark = 0x01020304;
+
+struct FsmbStringRef { uint32_t offset; uint32_t length; };
+
+struct FsmbSection { uint64_t offset; uint64_t count; };
+
+struct FsmbHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t byteOrder;
+    int32_t startState;         ///< index into states, -1 if not set
+    FsmbStringRef name;
+    FsmbStringRef description;
+    FsmbSection states;         ///< FsmbStateRecord[count]
+    FsmbSection rowOffsets;     ///< uint32_t[states.count + 1]
+    FsmbSection transitions;    ///< FsmbTransitionRecord[count]
+    FsmbSection variables;      ///< FsmbVariableRecord[count]
+    FsmbSection nodeInfos;      ///< FsmbNodeInfoRecord[count]
+    FsmbSection strings;        ///< char[count]
+};
+
+enum FsmbStateFlags : uint32_t { FsmbStateNone = 0, FsmbStateFinal = 1 };
+
+struct FsmbStateRecord { FsmbStringRef name; FsmbStringRef action; uint32_t flags; };
+struct FsmbTransitionRecord { int32_t target; int32_t delay; FsmbStringRef condition; };
+struct FsmbVariableRecord { FsmbStringRef name; FsmbStringRef value; uint32_t type; };
+struct FsmbNodeInfoRecord { FsmbStringRef name; int32_t posX; int32_t posY; int32_t inPortCount; int32_t outPortCount; };
+
+/**
+ * @brief A .fsmb file mapped into memory, the tables are read in place.
+ */
+class MappedAutomaton
+{
+public:
+    explicit MappedAutomaton(const std::string& filename);
+
+    // false if the file could not be opened or is not a valid .fsmb file
+    bool isValid() const { return m_header != nullptr; }
+
+    std::string_view name() const { return str(m_header->name); }
+    std::string_view description() const { return str(m_header->description); }
+    int32_t startState() const { return m_header->startState; }
+
+    uint32_t stateCount() const { return static_cast<uint32_t>(m_header->states.count); }
+    std::string_view stateName(uint32_t id) const { return str(m_states[id].name); }
+    std::string_view stateAction(uint32_t id) const { return str(m_states[id].action); }
+    bool isFinalState(uint32_t id) const { return m_states[id].flags & FsmbStateFinal; }
+
+    // CSR row of a state, indices into transition(i)
+    uint32_t firstTransition(uint32_t id) const { return m_rowOffsets[id]; }
+    uint32_t lastTransition(uint32_t id) const { return m_rowOffsets[id + 1]; }
+    const FsmbTransitionRecord& transition(uint32_t i) const { return m_transitions[i]; }
+    std::string_view condition(uint32_t i) const { return str(m_transitions[i].condition); }
+
+    uint32_t variableCount() const { return static_cast<uint32_t>(m_header->variables.count); }
+    const FsmbVariableRecord& variable(uint32_t i) const { return m_variables[i]; }
+
+    uint32_t nodeInfoCount() const { return static_cast<uint32_t>(m_header->nodeInfos.count); }
+    const FsmbNodeInfoRecord& nodeInfo(uint32_t i) const { return m_nodeInfos[i]; }
+
+    std::string_view str(FsmbStringRef ref) const { return std::string_view(m_strings + ref.offset, ref.length); }
+
+    // copies the contents into an automaton (and the node header)
+    // with outText set, actions and conditions are left in the mapping and referenced by outText
+    void toAutomaton(Automaton& outAutomaton, std::vector<StateInfo>* outStatesInfo = nullptr, SourceText* outText = nullptr) const;
+
+private:
+    bool validate();
+
+    MappedFile m_file;
+    const FsmbHeader* m_header = nullptr;
+    const FsmbStateRecord* m_states = nullptr;
+    const uint32_t* m_rowOffsets = nullptr;
+    const FsmbTransitionRecord* m_transitions = nullptr;
+    const FsmbVariableRecord* m_variables = nullptr;
+    const FsmbNodeInfoRecord* m_nodeInfos = nullptr;
+    const char* m_strings = nullptr;
+};
+
+class AutomatonBinary
+{
+public:
+    // true if the file name has the .fsmb extension
+    static bool IsBinaryFile(const std::string& filename);
+
+    // write the automaton (and optionally the node header) to a .fsmb file
+    static bool ToFile(const std::string& filename, const Automaton& automaton, const std::vector<StateInfo>* statesInfo = nullptr);
+
+    // read a .fsmb file to an automaton instance
+    static bool FromFile(const std::string& filename, Automaton& outAutomaton, std::vector<StateInfo>* outStatesInfo = nullptr);
+};
+
+#endif
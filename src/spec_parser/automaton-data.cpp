@@ -6,13 +6,75 @@
 #include "automaton-data.hpp"
 #include <algorithm>
 
+Automaton::Automaton(std::pmr::memory_resource* memoryResource)
+    : resource(memoryResource), finalStates(memoryResource), states(memoryResource), transitions(memoryResource)
+{}
+
+Automaton::Automaton(const Automaton& other, std::pmr::memory_resource* memoryResource)
+    : Automaton(memoryResource)
+{
+    *this = other;
+}
+
+Automaton& Automaton::operator=(const Automaton& other) {
+    if (this == &other)
+        return *this;
+
+    // the containers keep their resource, the elements are copied into it
+    name = other.name;
+    description = other.description;
+    variables = other.variables;
+    startState = other.startState;
+    finalStates = other.finalStates;
+    states = other.states;
+    transitions.clear();
+    transitions.reserve(other.transitions.size());
+    for (const auto& t : other.transitions)
+        addTransition(t);
+    definitions = other.definitions;
+    instances = other.instances;
+    return *this;
+}
+
+Automaton& Automaton::operator=(Automaton&& other) {
+    // moved elements would keep pointing into the other resource
+    if (resource != other.resource && !resource->is_equal(*other.resource))
+        return *this = static_cast<const Automaton&>(other);
+
+    name = std::move(other.name);
+    description = std::move(other.description);
+    variables = std::move(other.variables);
+    startState = other.startState;
+    finalStates = std::move(other.finalStates);
+    states = std::move(other.states);
+    transitions = std::move(other.transitions);
+    definitions = std::move(other.definitions);
+    instances = std::move(other.instances);
+    return *this;
+}
+
+void Automaton::reserve(size_t stateCount, size_t transitionCount, size_t variableCount)
+{
+    states.reserve(stateCount);
+    transitions.reserve(transitionCount);
+    variables.reserve(variableCount);
+}
+
 // Automaton info
-void Automaton::setName(const string& newName) {name = newName;}
-void Automaton::setDescription(const string& newDescription) {description = newDescription;}
-string Automaton::getName() const {return name;}
-string Automaton::getDescription() const {return description;}
+void Automaton::setName(string newName) {name = std::move(newName);}
+void Automaton::setDescription(string newDescription) {description = std::move(newDescription);}
+const string& Automaton::getName() const {return name;}
+const string& Automaton::getDescription() const {return description;}
 
 // Variable
+VariableInfo::VariableInfo(string name, string value, VarDataType type)
+    : name(std::move(name))
+    , value(std::move(value))
+    , type(type)
+    , parsed(parseVariableValue(this->value))
+{
+}
+
 string Automaton::varDataTypeAsString(VarDataType type)
 {
     switch(type)
@@ -30,55 +92,69 @@ VarDataType Automaton::varDataTypeFromString(const string& str)
     else return VarDataType::Int; // if not recognized, default to Int, fuck it
 }
 
-void Automaton::addVariable(const string& varName, const string& varValue, const VarDataType type) {
-    variables.push_back(VariableInfo{varName, varValue, type});
+void Automaton::addVariable(string varName, string varValue, const VarDataType type) {
+    variables.push_back(VariableInfo{std::move(varName), std::move(varValue), type});
 }
 
-vector<VariableInfo> Automaton::getVariables() const { return variables; }
+const vector<VariableInfo>& Automaton::getVariables() const { return variables; }
 
 // State
-void Automaton::addState(const string& stateName, const string& action) { 
-    states[stateName] = action;
+void Automaton::addState(Symbol stateName, std::string_view action) { 
+    states[stateName].assign(action.data(), action.size());
 }
 
-void Automaton::appendToAction(const std::string& stateName, const std::string& line) {
-    states[stateName] += line + "\n";
+void Automaton::appendToAction(Symbol stateName, std::string_view line) {
+    auto& action = states[stateName];
+    action.append(line);
+    action += '\n';
 }
 
-void Automaton::setStartState(const string& stateName) {
+void Automaton::setStartState(Symbol stateName) {
     startState = stateName;
 }
 
-void Automaton::addFinalState(const string& stateName) { 
+void Automaton::addFinalState(Symbol stateName) { 
     if (!isFinalState(stateName))
         finalStates.push_back(stateName);
 }
 
-bool Automaton::isFinalState(const string& stateName) const {
+bool Automaton::isFinalState(Symbol stateName) const {
     return find(finalStates.begin(), finalStates.end(), stateName) != finalStates.end();
 }
 
-string Automaton::getStateAction(const string& stateName) const {
+std::string_view Automaton::getStateAction(Symbol stateName) const {
     auto state = states.find(stateName);
-    return (state != states.end()) ? state->second : "";
+    return (state != states.end()) ? std::string_view(state->second) : std::string_view();
 }
 
-unordered_map<string, string> Automaton::getStates() const {return states;}
+// a name that is not interned is not a state of any automaton
+bool Automaton::isFinalState(const string& stateName) const {
+    auto symbol = Symbol::find(stateName);
+    return symbol && isFinalState(*symbol);
+}
+
+std::string_view Automaton::getStateAction(const string& stateName) const {
+    auto symbol = Symbol::find(stateName);
+    return symbol ? getStateAction(*symbol) : std::string_view();
+}
+
+const std::pmr::unordered_map<Symbol, std::pmr::string>& Automaton::getStates() const {return states;}
 
-vector<string> Automaton::getFinalStates() const {return finalStates;}
+const std::pmr::vector<Symbol>& Automaton::getFinalStates() const {return finalStates;}
 
-string Automaton::getStartName() const {return startState;}
+Symbol Automaton::getStartName() const {return startState;}
 
 // Transition
-void Automaton::addTransition(const Transition& t) {
-    transitions.push_back(t);
+void Automaton::addTransition(Transition t) {
+    // moved if the condition already uses the resource, copied into it otherwise
+    transitions.push_back(Transition{t.fromState, t.toState, std::pmr::string(std::move(t.condition), resource), t.delay});
 }
 
-vector<Transition> Automaton::getTransitions() const {
+const std::pmr::vector<Transition>& Automaton::getTransitions() const {
     return transitions;
 }
 
-vector<Transition> Automaton::getTransitionsFrom(const string& stateName) const {
+vector<Transition> Automaton::getTransitionsFrom(Symbol stateName) const {
     vector<Transition> result;
     for (const auto& t : transitions) {
         if (t.fromState == stateName) {
@@ -87,3 +163,109 @@ vector<Transition> Automaton::getTransitionsFrom(const string& stateName) const
     }
     return result;
 }
+
+vector<Transition> Automaton::getTransitionsFrom(const string& stateName) const {
+    auto symbol = Symbol::find(stateName);
+    return symbol ? getTransitionsFrom(*symbol) : vector<Transition>();
+}
+
+// Sub-automata
+void Automaton::addDefinition(std::shared_ptr<const Automaton> definition) {
+    definitions.push_back(std::move(definition));
+}
+
+const vector<std::shared_ptr<const Automaton>>& Automaton::getDefinitions() const {
+    return definitions;
+}
+
+const Automaton* Automaton::findDefinition(const string& definitionName) const {
+    for (const auto& definition : definitions) {
+        if (definition->getName() == definitionName)
+            return definition.get();
+    }
+    return nullptr;
+}
+
+void Automaton::addInstance(SubAutomatonInstance instance) {
+    instances.push_back(std::move(instance));
+}
+
+const vector<SubAutomatonInstance>& Automaton::getInstances() const {
+    return instances;
+}
+
+const SubAutomatonInstance* Automaton::findInstance(const string& instanceName) const {
+    for (const auto& instance : instances) {
+        if (instance.name == instanceName)
+            return &instance;
+    }
+    return nullptr;
+}
+
+// Builder
+AutomatonBuilder& AutomatonBuilder::reserve(size_t stateCount, size_t transitionCount, size_t variableCount) {
+    automaton.reserve(stateCount, transitionCount, variableCount);
+    return *this;
+}
+
+AutomatonBuilder& AutomatonBuilder::name(string newName) {
+    automaton.setName(std::move(newName));
+    return *this;
+}
+
+AutomatonBuilder& AutomatonBuilder::description(string newDescription) {
+    automaton.setDescription(std::move(newDescription));
+    return *this;
+}
+
+AutomatonBuilder& AutomatonBuilder::variable(string varName, string varValue, VarDataType type) {
+    automaton.addVariable(std::move(varName), std::move(varValue), type);
+    return *this;
+}
+
+AutomatonBuilder& AutomatonBuilder::state(Symbol stateName, std::string_view action) {
+    automaton.addState(stateName, action);
+    return *this;
+}
+
+AutomatonBuilder& AutomatonBuilder::appendToAction(Symbol stateName, std::string_view line) {
+    automaton.appendToAction(stateName, line);
+    return *this;
+}
+
+AutomatonBuilder& AutomatonBuilder::start(Symbol stateName) {
+    automaton.setStartState(stateName);
+    return *this;
+}
+
+AutomatonBuilder& AutomatonBuilder::finalState(Symbol stateName) {
+    if (finals.insert(stateName).second)
+        automaton.finalStates.push_back(stateName);
+    return *this;
+}
+
+AutomatonBuilder& AutomatonBuilder::transition(Symbol fromState, Symbol toState, std::string_view condition, int delay) {
+    automaton.transitions.push_back(Transition{fromState, toState, std::pmr::string(condition, automaton.resource), delay});
+    return *this;
+}
+
+AutomatonBuilder& AutomatonBuilder::definition(std::shared_ptr<const Automaton> definition) {
+    automaton.addDefinition(std::move(definition));
+    return *this;
+}
+
+AutomatonBuilder& AutomatonBuilder::instance(SubAutomatonInstance instance) {
+    automaton.addInstance(std::move(instance));
+    return *this;
+}
+
+Automaton AutomatonBuilder::build() {
+    finals.clear();
+    Automaton result = std::move(automaton);
+    automaton = Automaton(result.getResource());
+    return result;
+}
+
+std::unique_ptr<Automaton> AutomatonBuilder::buildUnique() {
+    return std::make_unique<Automaton>(build());
+}
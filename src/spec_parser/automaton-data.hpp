@@ -1,16 +1,25 @@
 #ifndef AUTOMATON_DATA_H
 #define AUTOMATON_DATA_H
 
+#include <memory>
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+#include "symbol-table.hpp"
+#include "variable-value.hpp"
 
 using namespace std;
 
+// The condition uses the memory resource of its automaton, copies of a transition use the default one.
 struct Transition {
-    string fromState;
-    string toState;
-    string condition;  
+    Symbol fromState;
+    Symbol toState;
+    std::pmr::string condition;
     int delay = 0;
 };
 
@@ -23,48 +32,136 @@ enum class VarDataType
 
 struct VariableInfo
 {
+    VariableInfo() = default;
+    // parses the value once, see parseVariableValue()
+    VariableInfo(string name, string value, VarDataType type);
+
+    string name;
+    string value;          // the text as written in the file and shown in the editor
+    VarDataType type = VarDataType::Int;
+    VariableValue parsed;  // the typed value of the text
+};
+
+class Automaton;
+class AutomatonBuilder;
+
+// A use of a sub-automaton definition. The instance is entered like a state of its name: a
+// transition to it goes to the start state of the definition, its own transitions leave from the
+// final states of the definition. The states of the definition run as "<instance>.<state>", see
+// expandSubAutomata().
+struct SubAutomatonInstance {
     string name;
-    string value;
-    VarDataType type;
+    string definition;                          // Automaton::getName() of a definition
+    vector<pair<string, string>> bindings;      // variable of the definition -> variable of the automaton
 };
 
+// The actions, conditions and the containers holding them are allocated from the memory
+// resource given at construction, e.g. a std::pmr::monotonic_buffer_resource which frees
+// a whole automaton at once. The resource has to outlive the automaton. Copies and
+// assignments keep the resource of the target.
 class Automaton {
+    friend class AutomatonBuilder;
+
+    std::pmr::memory_resource* resource;
     string name;
     string description;
     vector<VariableInfo> variables;
-    string startState;
-    vector<string> finalStates;
-    unordered_map<string, string> states;
-    vector<Transition> transitions;
+    Symbol startState;
+    std::pmr::vector<Symbol> finalStates;
+    std::pmr::unordered_map<Symbol, std::pmr::string> states;
+    std::pmr::vector<Transition> transitions;
+    vector<std::shared_ptr<const Automaton>> definitions;
+    vector<SubAutomatonInstance> instances;
 
 public:
+    explicit Automaton(std::pmr::memory_resource* memoryResource = std::pmr::get_default_resource());
+    Automaton(const Automaton& other, std::pmr::memory_resource* memoryResource = std::pmr::get_default_resource());
+    Automaton(Automaton&& other) noexcept = default;
+    Automaton& operator=(const Automaton& other);
+    Automaton& operator=(Automaton&& other);
+
+    std::pmr::memory_resource* getResource() const { return resource; }
+
+    // Read accessors return const references to the internal containers,
+    // they stay valid until the automaton is modified or destroyed.
+    // Names are taken by value, pass rvalues to move them in. Actions and conditions are
+    // copied into the memory resource unless they already use it.
+
+    // preallocates the containers for the given number of elements
+    void reserve(size_t stateCount, size_t transitionCount, size_t variableCount);
+
     // Automaton info
-    void setName(const string& newName);
-    void setDescription(const string& newDescription);
-    string getName() const;
-    string getDescription() const;
+    void setName(string newName);
+    void setDescription(string newDescription);
+    const string& getName() const;
+    const string& getDescription() const;
 
     // Variables
     static string varDataTypeAsString(VarDataType type);
     static VarDataType varDataTypeFromString(const string& str);
-    void addVariable(const string& varName, const string& varValue, const VarDataType type);
-    vector<VariableInfo> getVariables() const;
+    void addVariable(string varName, string varValue, const VarDataType type);
+    const vector<VariableInfo>& getVariables() const;
 
     // States
-    void addState(const string& stateName, const string& action = "");
-    void appendToAction(const std::string& stateName, const std::string& line);
-    void setStartState(const string& stateName);
-    void addFinalState(const string& stateName);
+    void addState(Symbol stateName, std::string_view action = std::string_view());
+    void appendToAction(Symbol stateName, std::string_view line);
+    void setStartState(Symbol stateName);
+    void addFinalState(Symbol stateName);
+    bool isFinalState(Symbol stateName) const;
+    std::string_view getStateAction(Symbol stateName) const;
+    // lookups by a plain name, the name is not interned
     bool isFinalState(const string& stateName) const;
-    string getStateAction(const string& stateName) const;
-    unordered_map<string, string> getStates() const;
-    vector<string> getFinalStates() const;
-    string getStartName() const;
+    std::string_view getStateAction(const string& stateName) const;
+    const std::pmr::unordered_map<Symbol, std::pmr::string>& getStates() const;
+    const std::pmr::vector<Symbol>& getFinalStates() const;
+    Symbol getStartName() const;
     
     // Transitions
-    void addTransition(const Transition& t);
-    vector<Transition> getTransitions() const;
+    void addTransition(Transition t);
+    const std::pmr::vector<Transition>& getTransitions() const;
+    vector<Transition> getTransitionsFrom(Symbol stateName) const;
     vector<Transition> getTransitionsFrom(const string& stateName) const;
+
+    // Sub-automata, a definition is stored once and shared by copies of the automaton.
+    // Its start state is the entry of an instance, its final states are the exits and
+    // its variables are bound to variables of the automaton by the instances.
+    void addDefinition(std::shared_ptr<const Automaton> definition);
+    const vector<std::shared_ptr<const Automaton>>& getDefinitions() const;
+    const Automaton* findDefinition(const string& definitionName) const;
+    void addInstance(SubAutomatonInstance instance);
+    const vector<SubAutomatonInstance>& getInstances() const;
+    const SubAutomatonInstance* findInstance(const string& instanceName) const;
+};
+
+// Builds an automaton in one go, for converting a whole model or file.
+// Unlike Automaton::addFinalState, finalState() does not search the final states.
+class AutomatonBuilder {
+    Automaton automaton;
+    unordered_set<Symbol> finals;
+
+public:
+    explicit AutomatonBuilder(std::pmr::memory_resource* memoryResource = std::pmr::get_default_resource())
+        : automaton(memoryResource) {}
+
+    AutomatonBuilder& reserve(size_t stateCount, size_t transitionCount, size_t variableCount);
+
+    AutomatonBuilder& name(string newName);
+    AutomatonBuilder& description(string newDescription);
+    AutomatonBuilder& variable(string varName, string varValue, VarDataType type);
+
+    AutomatonBuilder& state(Symbol stateName, std::string_view action = std::string_view());
+    AutomatonBuilder& appendToAction(Symbol stateName, std::string_view line);
+    AutomatonBuilder& start(Symbol stateName);
+    AutomatonBuilder& finalState(Symbol stateName);
+
+    AutomatonBuilder& transition(Symbol fromState, Symbol toState, std::string_view condition, int delay);
+
+    AutomatonBuilder& definition(std::shared_ptr<const Automaton> definition);
+    AutomatonBuilder& instance(SubAutomatonInstance instance);
+
+    // the builder is empty afterwards, the result uses the memory resource of the builder
+    Automaton build();
+    std::unique_ptr<Automaton> buildUnique();
 };
 
 #endif // AUTOMATON_DATA_H
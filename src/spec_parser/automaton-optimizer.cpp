@@ -0,0 +1,129 @@
+/**
+ * @brief Simplification pass run over an automaton before code generation
+ * @author Jakub Kovarik
+ */
+
+#include "automaton-optimizer.hpp"
+
+#include <cctype>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+static std::string_view trim(std::string_view s)
+{
+    while (!s.empty() && isspace(static_cast<unsigned char>(s.front())))
+        s.remove_prefix(1);
+    while (!s.empty() && isspace(static_cast<unsigned char>(s.back())))
+        s.remove_suffix(1);
+    return s;
+}
+
+bool isTriviallyTrue(std::string_view condition)
+{
+    std::string_view code = condition;
+    // the recognized forms contain no strings, a '#' always starts a comment in them
+    const size_t comment = code.find('#');
+    if (comment != std::string_view::npos)
+        code = code.substr(0, comment);
+    code = trim(code);
+
+    while (code.size() >= 2 && code.front() == '(' && code.back() == ')')
+        code = trim(code.substr(1, code.size() - 2));
+
+    if (code.empty() || code == "True")
+        return true;
+
+    bool nonZero = false;
+    for (char c : code) {
+        if (!isdigit(static_cast<unsigned char>(c)))
+            return false;
+        nonZero |= c != '0';
+    }
+    return nonZero;
+}
+
+Automaton optimizeAutomaton(const Automaton& automaton, OptimizationStats* stats,
+                            std::pmr::memory_resource* resource)
+{
+    if (!resource)
+        resource = automaton.getResource();
+    OptimizationStats counts;
+    const auto& transitions = automaton.getTransitions();
+    const Symbol start = automaton.getStartName();
+    if (start.empty()) {
+        if (stats)
+            *stats = counts;
+        return Automaton(automaton, resource);
+    }
+
+    // outgoing transitions in priority order, up to the first unconditional one
+    std::unordered_map<Symbol, std::vector<size_t>> rows;
+    std::unordered_set<Symbol> closed;
+    for (size_t i = 0; i < transitions.size(); ++i) {
+        const Transition& t = transitions[i];
+        if (closed.count(t.fromState))
+            continue;
+        rows[t.fromState].push_back(i);
+        if (isTriviallyTrue(t.condition))
+            closed.insert(t.fromState);
+    }
+
+    // states reachable from the start state
+    std::unordered_set<Symbol> reachable{start};
+    std::vector<Symbol> pending{start};
+    while (!pending.empty()) {
+        const Symbol state = pending.back();
+        pending.pop_back();
+        auto row = rows.find(state);
+        if (row == rows.end())
+            continue;
+        for (size_t i : row->second) {
+            if (reachable.insert(transitions[i].toState).second)
+                pending.push_back(transitions[i].toState);
+        }
+    }
+
+    Automaton result(resource);
+    result.reserve(reachable.size(), transitions.size(), automaton.getVariables().size());
+    result.setName(automaton.getName());
+    result.setDescription(automaton.getDescription());
+    for (const auto& var : automaton.getVariables())
+        result.addVariable(var.name, var.value, var.type);
+
+    for (const auto& [name, action] : automaton.getStates()) {
+        if (reachable.count(name))
+            result.addState(name, action);
+        else
+            counts.removedStates++;
+    }
+    result.setStartState(start);
+    for (Symbol state : automaton.getFinalStates()) {
+        if (reachable.count(state))
+            result.addFinalState(state);
+    }
+
+    std::vector<char> kept(transitions.size(), 0);
+    for (const auto& [state, row] : rows) {
+        if (!reachable.count(state))
+            continue;
+        for (size_t i : row)
+            kept[i] = 1;
+    }
+    for (size_t i = 0; i < transitions.size(); ++i) {
+        if (!kept[i]) {
+            counts.removedTransitions++;
+            continue;
+        }
+        Transition t = transitions[i];
+        if (!t.condition.empty() && isTriviallyTrue(t.condition)) {
+            t.condition.clear();
+            counts.trivialConditions++;
+        }
+        result.addTransition(std::move(t));
+    }
+
+    if (stats)
+        *stats = counts;
+    return result;
+}
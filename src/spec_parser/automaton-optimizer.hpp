@@ -0,0 +1,54 @@
+/**
+ * @brief Simplification pass run over an automaton before code generation
+ *
+ * The pass keeps the behaviour of the automaton and drops what can never run:
+ * - guards that are trivially true (`True`, `1`, empty after comments) become empty
+ *   conditions, which the generators emit as the shared always true condition,
+ * - transitions of a state after its first unconditional one, they are never chosen
+ *   because transitions are evaluated in order,
+ * - states (with their actions and transitions) not reachable from the start state.
+ *
+ * Without a start state nothing is reachable and the automaton is copied unchanged,
+ * the runtime reports the missing start state.
+ *
+ * @author Jakub Kovarik
+ */
+#ifndef AUTOMATON_OPTIMIZER_H
+#define AUTOMATON_OPTIMIZER_H
+
+#include <cstddef>
+#include <string_view>
+
+#include "automaton-data.hpp"
+
+/**
+ * @brief What optimizeAutomaton() removed
+ */
+struct OptimizationStats
+{
+    size_t removedStates = 0;        ///< unreachable states
+    size_t removedTransitions = 0;   ///< shadowed transitions and transitions of removed states
+    size_t trivialConditions = 0;    ///< guards replaced by the empty condition
+};
+
+/**
+ * @brief Checks if a condition is always true without evaluating it
+ *
+ * Recognizes empty conditions, `True` and non zero integer literals, optionally in
+ * parentheses and followed by a comment.
+ */
+bool isTriviallyTrue(std::string_view condition);
+
+/**
+ * @brief Returns the simplified copy of the automaton
+ *
+ * Transitions keep their relative order, the variables, name and description are
+ * copied as they are.
+ *
+ * @param stats If not null, receives the counts of the removed parts.
+ * @param resource Memory resource of the result, null to use the one of the automaton.
+ */
+Automaton optimizeAutomaton(const Automaton& automaton, OptimizationStats* stats = nullptr,
+                            std::pmr::memory_resource* resource = nullptr);
+
+#endif
@@ -1,15 +1,34 @@
 /**
  * @brief Parse a saved file to an automaton instance
+ *
+ * The file is memory mapped (or read at once where mmap is not available) and
+ * scanned line by line with string views, the node header and the automaton
+ * blocks are parsed in the same pass.
+ *
+ * Once the VARS section has been read the STATE and TRANSITION blocks are
+ * independent, so large files split the rest of the file on block boundaries
+ * and parse the chunks on worker threads. The chunks are merged in file order,
+ * the result is the same as of a sequential parse.
+ *
+ * The MACHINE blocks of the sub-automaton definitions and the INSTANCE lines
+ * come between VARS and the first block, they are part of the sequential
+ * prologue. A MACHINE block is parsed like a file from START on by a nested
+ * parser, up to its own END.
+ *
  * @author Jakub Kovarik
  */
 
 #include <iostream>
-#include <fstream>
-#include <sstream>
 #include <string>
 #include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <thread>
 #include "automaton-data.hpp"
 #include "automaton-parser.hpp"
+#include "mapped-file.hpp"
 
 
 enum class ParserState {
@@ -28,195 +47,568 @@ enum class ParserState {
 };
 
 // Keyword check 
-bool startsWith(const string& str, const string& prefix)
+static bool startsWith(std::string_view str, std::string_view prefix)
 {
     return str.size() >= prefix.size() &&
            str.compare(0, prefix.size(), prefix) == 0;
 }
 
+// Trim whitespace
+static std::string_view trimSpaces(std::string_view str)
+{
+    size_t first = str.find_first_not_of(" \t\r\n");
+    if (first == std::string_view::npos) return std::string_view();
+
+    size_t last = str.find_last_not_of(" \t\r\n");
+    return str.substr(first, (last - first + 1));
+}
+
 // Trim comments and whitespace
-string trim(const string& str)
+static std::string_view trim(std::string_view str)
 {
     size_t hash = str.find('#');
-    string noComment = (hash != string::npos) ? str.substr(0, hash) : str;
+    return trimSpaces((hash != std::string_view::npos) ? str.substr(0, hash) : str);
+}
+
+// Next ';' separated field of a node header line
+static std::string_view nextField(std::string_view& rest)
+{
+    size_t sep = rest.find(';');
+    std::string_view field = rest.substr(0, sep);
+    rest = (sep == std::string_view::npos) ? std::string_view() : rest.substr(sep + 1);
+    return field;
+}
+
+static bool parseInt(std::string_view str, int& out)
+{
+    str = trimSpaces(str);
+    auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), out);
+    return ec == std::errc() && ptr == str.data() + str.size();
+}
+
+// "#name;x;y;in;out"
+static bool parseStateInfo(std::string_view line, StateInfo& info)
+{
+    std::string_view rest = line.substr(1); // ignore the initial #
+    info.name = std::string(nextField(rest));
+    return parseInt(nextField(rest), info.posX) &&
+           parseInt(nextField(rest), info.posY) &&
+           parseInt(nextField(rest), info.inPortCount) &&
+           parseInt(nextField(rest), info.outPortCount);
+}
+
+// "INSTANCE <name> : <definition> (parameter = variable, ...)", the bindings are optional
+static bool parseInstance(std::string_view line, SubAutomatonInstance& instance)
+{
+    std::string_view rest = trim(line.substr(9));
+    size_t colon = rest.find(':');
+    if (colon == std::string_view::npos)
+        return false;
+    instance.name = std::string(trimSpaces(rest.substr(0, colon)));
+    rest = trimSpaces(rest.substr(colon + 1));
 
-    size_t first = noComment.find_first_not_of(" \t\r\n");
-    if (first == string::npos) return "";
+    size_t open = rest.find('(');
+    instance.definition = std::string(trimSpaces(rest.substr(0, open)));
+    if (instance.name.empty() || instance.definition.empty())
+        return false;
+    if (open == std::string_view::npos)
+        return true;
 
-    size_t last = noComment.find_last_not_of(" \t\r\n");
-    return noComment.substr(first, (last - first + 1));
+    size_t close = rest.rfind(')');
+    if (close == std::string_view::npos || close < open)
+        return false;
+    rest = rest.substr(open + 1, close - open - 1);
+    while (!rest.empty()) {
+        size_t comma = rest.find(',');
+        std::string_view binding = trimSpaces(rest.substr(0, comma));
+        rest = (comma == std::string_view::npos) ? std::string_view() : rest.substr(comma + 1);
+        if (binding.empty())
+            continue;
+        size_t eq = binding.find('=');
+        if (eq == std::string_view::npos)
+            return false;
+        instance.bindings.emplace_back(std::string(trimSpaces(binding.substr(0, eq))), std::string(trimSpaces(binding.substr(eq + 1))));
+    }
+    return true;
 }
 
-// parse a text file to an automaton instance
-void AutomatonParser::FromFile(std::string const filename, Automaton& automaton) 
+// Blocks read from the file. Names point into the parsed buffer and are interned when the
+// blocks are merged, so the worker threads do not contend on the symbol table.
+// In lazy mode only the views are set, the text is left in the buffer.
+struct ParsedState {
+    std::string_view name;
+    std::string action;     // built the same way as Automaton::appendToAction
+    std::string_view actionLines;   // first to last line of the ACTION block
+};
+
+struct ParsedTransition {
+    std::string_view fromState;
+    std::string_view toState;
+    std::string condition;
+    std::string_view conditionText;
+    int delay = 0;
+};
+
+// Parses a range of lines, the blocks after VARS are collected and merged into the automaton later
+class LineParser
+{
+public:
+    // acceptsDefinitions allows MACHINE and INSTANCE before the first block, the prologue and the nested parsers only
+    LineParser(Automaton& automaton, ParserState initialState, std::vector<StateInfo>* outStatesInfo, SourceText* outText = nullptr, bool acceptsDefinitions = false)
+        : m_automaton(automaton), m_state(initialState), m_statesInfo(outStatesInfo), m_text(outText), m_inHeader(initialState == ParserState::EXPECT_AUTOMATON),
+          m_acceptsDefinitions(acceptsDefinitions)
+    {}
+
+    // parses the lines of data, stops early before the first block after VARS (and the definitions) if stopAtBlocks is set
+    // returns the number of consumed bytes
+    size_t parse(std::string_view data, bool stopAtBlocks = false);
+
+    // adds the collected blocks to the automaton and prints the errors (line numbers shifted by firstLine)
+    void merge(size_t firstLine);
+
+    ParserState state() const { return m_state; }
+    size_t lineCount() const { return m_lineCount; }
+
+private:
+    // passes the line to the MACHINE block being parsed, if any
+    void feed(std::string_view rawLine, std::string_view line);
+    void parseLine(std::string_view rawLine, std::string_view line);
+    void finishDefinition();
+
+    void error(std::string_view message, std::string_view line)
+    {
+        std::string text(message);
+        text += line;
+        m_errors.emplace_back(m_lineCount, std::move(text));
+    }
+
+    Automaton& m_automaton;                 // only written by the lines before the first block
+    ParserState m_state;
+    std::vector<StateInfo>* m_statesInfo;
+    SourceText* m_text;                     // lazy mode, written by merge() only
+    bool m_inHeader;
+    bool m_acceptsDefinitions;
+    size_t m_lineCount = 0;                 // 1 based number of the current line within data
+
+    // the MACHINE block being parsed, its lines go to m_nested up to its END
+    std::shared_ptr<Automaton> m_definition;
+    std::unique_ptr<LineParser> m_nested;
+
+    ParsedTransition m_currentTransition;
+    std::vector<ParsedState> m_states;
+    std::vector<ParsedTransition> m_transitions;
+    std::vector<std::pair<size_t, std::string>> m_errors;
+
+    // keeps the relative order of states and transitions, the merge replays them the same way
+    std::vector<std::pair<bool, size_t>> m_blocks;   // (isState, index)
+};
+
+size_t LineParser::parse(std::string_view data, bool stopAtBlocks)
 {
-    string rawLine;
-    string line;
-    ParserState state = ParserState::EXPECT_AUTOMATON;
-    string currentState;
-    Transition currentTransition;
-    ifstream in(filename);
+    const char* cursor = data.data();
+    const char* const dataEnd = data.data() + data.size();
 
-    while (std::getline(in, rawLine)) 
+    while (cursor < dataEnd)
     {
-        line = trim(rawLine);
+        const char* lineStart = cursor;
+        const char* newline = static_cast<const char*>(std::memchr(cursor, '\n', static_cast<size_t>(dataEnd - cursor)));
+        const char* lineEnd = newline ? newline : dataEnd;
+        std::string_view rawLine(cursor, static_cast<size_t>(lineEnd - cursor));
+        cursor = newline ? newline + 1 : dataEnd;
+        ++m_lineCount;
+
+        if (!rawLine.empty() && rawLine.back() == '\r')
+            rawLine.remove_suffix(1);
 
-        // ignore empty lines and lines starting with a # which are used for UI node info
+        // the file starts with "#name;x;y;in;out" lines used for UI node info
+        if (m_inHeader) {
+            if (!rawLine.empty() && rawLine[0] == '#') {
+                StateInfo info;
+                if (!parseStateInfo(rawLine, info))
+                    error("Malformed node info line: ", rawLine);
+                else if (m_statesInfo)
+                    m_statesInfo->push_back(std::move(info));
+                continue;
+            }
+            m_inHeader = false;
+        }
+
+        std::string_view line = trim(rawLine);
+
+        // ignore empty lines and comments
         if (line.empty() || line[0] == '#')
             continue;
 
-        switch (state) {
-            case ParserState::EXPECT_AUTOMATON:
-                if (startsWith(line, "AUTOMATON ")) {
-                    automaton.setName(trim(line.substr(10)));
-                    state = ParserState::EXPECT_DESCRIPTION;
-                } else {
-                    cerr << "Expected 'AUTOMATON', found: " << line << endl;
-                }
-                break;
+        // the line is left for the blocks
+        if (stopAtBlocks && m_state == ParserState::EXPECT_STATE_OR_TRANSITION && !m_nested &&
+            !startsWith(line, "MACHINE ") && !startsWith(line, "INSTANCE ")) {
+            cursor = lineStart;
+            --m_lineCount;
+            break;
+        }
 
-            case ParserState::EXPECT_DESCRIPTION:
-                if (startsWith(line, "DESCRIPTION ")) {
-                    automaton.setDescription(trim(line.substr(12)));
-                    state = ParserState::EXPECT_START;
-                } else {
-                    cerr << "Expected 'DESCRIPTION', found: " << line << endl;
-                }
-                break;
+        feed(rawLine, line);
+    }
 
-            case ParserState::EXPECT_START:
-                if (startsWith(line, "START ")) {
-                    automaton.setStartState(trim(line.substr(6)));
-                    state = ParserState::EXPECT_FINISH;
-                } else {
-                    cerr << "Expected 'START', found: " << line << endl;
-                }
-                break;
+    return static_cast<size_t>(cursor - data.data());
+}
 
-            case ParserState::EXPECT_FINISH:
-                if (startsWith(line, "FINISH ")) {
-                    string rest = trim(line.substr(7));
-                    rest.erase(remove(rest.begin(), rest.end(), '['), rest.end());
-                    rest.erase(remove(rest.begin(), rest.end(), ']'), rest.end());
-
-                    istringstream ss(rest);
-                    string stateName;
-                    while (getline(ss, stateName, ',')) {
-                        automaton.addFinalState(trim(stateName));
-                    }
-                    state = ParserState::EXPECT_VARS;
-                } else {
-                    cerr << "Expected 'FINISH', found: " << line << endl;
-                }
-                break;
+void LineParser::feed(std::string_view rawLine, std::string_view line)
+{
+    if (!m_nested) {
+        parseLine(rawLine, line);
+        return;
+    }
+    m_nested->m_lineCount = m_lineCount;
+    m_nested->feed(rawLine, line);
+    if (m_nested->m_state == ParserState::DONE)
+        finishDefinition();
+}
 
-            case ParserState::EXPECT_VARS:
-                if (line == "VARS") {
-                    state = ParserState::INSIDE_VARS;
-                } else {
-                    cerr << "Expected 'VARS', found: " << line << endl;
-                }
-                break;
+void LineParser::finishDefinition()
+{
+    for (auto& entry : m_nested->m_errors)
+        m_errors.push_back(std::move(entry));
+    m_nested->m_errors.clear();
+    m_nested->merge(0);
+    m_automaton.addDefinition(std::move(m_definition));
+    m_definition.reset();
+    m_nested.reset();
+}
 
-            case ParserState::INSIDE_VARS: {
-                if (line == "END") {
-                    state = ParserState::EXPECT_STATE_OR_TRANSITION;
-                    break;
-                }
-                size_t eq = line.find('=');
-                if (eq != string::npos) {
-                    string typeAndName = trim(line.substr(0, eq));
-                    size_t spacePos = typeAndName.find(' ');
-                    string type = trim(typeAndName.substr(0, spacePos));
-                    string name = trim(typeAndName.substr(spacePos + 1));
-                    string value = trim(line.substr(eq + 1));
-                    automaton.addVariable(name, value, Automaton::varDataTypeFromString(type));
-                } else {
-                    cerr << "Malformed VARS line: " << line << endl;
+void LineParser::parseLine(std::string_view rawLine, std::string_view line)
+{
+    Automaton& automaton = m_automaton;
+
+    switch (m_state) {
+        case ParserState::EXPECT_AUTOMATON:
+            if (startsWith(line, "AUTOMATON ")) {
+                automaton.setName(std::string(trim(line.substr(10))));
+                m_state = ParserState::EXPECT_DESCRIPTION;
+            } else {
+                error("Expected 'AUTOMATON', found: ", line);
+            }
+            break;
+
+        case ParserState::EXPECT_DESCRIPTION:
+            if (startsWith(line, "DESCRIPTION ")) {
+                automaton.setDescription(std::string(trim(line.substr(12))));
+                m_state = ParserState::EXPECT_START;
+            } else {
+                error("Expected 'DESCRIPTION', found: ", line);
+            }
+            break;
+
+        case ParserState::EXPECT_START:
+            if (startsWith(line, "START ")) {
+                automaton.setStartState(Symbol(std::string(trim(line.substr(6)))));
+                m_state = ParserState::EXPECT_FINISH;
+            } else {
+                error("Expected 'START', found: ", line);
+            }
+            break;
+
+        case ParserState::EXPECT_FINISH:
+            if (startsWith(line, "FINISH ")) {
+                std::string_view rest = trim(line.substr(7));
+                while (!rest.empty()) {
+                    size_t comma = rest.find(',');
+                    std::string_view stateName = rest.substr(0, comma);
+                    rest = (comma == std::string_view::npos) ? std::string_view() : rest.substr(comma + 1);
+
+                    stateName = trimSpaces(stateName);
+                    if (!stateName.empty() && stateName.front() == '[') stateName.remove_prefix(1);
+                    if (!stateName.empty() && stateName.back() == ']') stateName.remove_suffix(1);
+                    stateName = trimSpaces(stateName);
+                    if (!stateName.empty())
+                        automaton.addFinalState(Symbol(std::string(stateName)));
                 }
+                m_state = ParserState::EXPECT_VARS;
+            } else {
+                error("Expected 'FINISH', found: ", line);
+            }
+            break;
+
+        case ParserState::EXPECT_VARS:
+            if (line == "VARS") {
+                m_state = ParserState::INSIDE_VARS;
+            } else {
+                error("Expected 'VARS', found: ", line);
+            }
+            break;
+
+        case ParserState::INSIDE_VARS: {
+            if (line == "END") {
+                m_state = ParserState::EXPECT_STATE_OR_TRANSITION;
                 break;
             }
+            size_t eq = line.find('=');
+            if (eq != std::string_view::npos) {
+                std::string_view typeAndName = trim(line.substr(0, eq));
+                size_t spacePos = typeAndName.find(' ');
+                std::string_view type = trim(typeAndName.substr(0, spacePos));
+                std::string_view name = (spacePos != std::string_view::npos) ? trim(typeAndName.substr(spacePos + 1)) : type;
+                std::string_view value = trim(line.substr(eq + 1));
+                automaton.addVariable(std::string(name), std::string(value), Automaton::varDataTypeFromString(std::string(type)));
+            } else {
+                error("Malformed VARS line: ", line);
+            }
+            break;
+        }
 
-            case ParserState::EXPECT_STATE_OR_TRANSITION:
-                if (startsWith(line, "STATE ")) 
+        case ParserState::EXPECT_STATE_OR_TRANSITION:
+            if (startsWith(line, "STATE ")) 
+            {
+                m_blocks.emplace_back(true, m_states.size());
+                m_states.push_back({trim(line.substr(6)), std::string(), std::string_view()});
+                m_state = ParserState::EXPECT_STATE_ACTION;
+            } 
+            else if (startsWith(line, "TRANSITION "))
+            {
+                size_t arrow = line.find("->");
+                if (arrow != std::string_view::npos)
                 {
-                    currentState = trim(line.substr(6));
-                    automaton.addState(currentState);
-                    state = ParserState::EXPECT_STATE_ACTION;
+                    m_currentTransition = ParsedTransition();
+                    m_currentTransition.fromState = trim(line.substr(10, arrow - 10));
+                    m_currentTransition.toState = trim(line.substr(arrow + 2));
+                    m_state = ParserState::EXPECT_TRANSITION_CONDITION;
                 } 
-                else if (startsWith(line, "TRANSITION "))
+                else
                 {
-                    size_t arrow = line.find("->");
-                    if (arrow != string::npos)
-                    {
-                        currentTransition.fromState = trim(line.substr(10, arrow - 10));
-                        currentTransition.toState = trim(line.substr(arrow + 2));
-                        state = ParserState::EXPECT_TRANSITION_CONDITION;
-                    } 
-                    else
-                    {
-                        cerr << "Malformed TRANSITION line: " << line << endl;
-                    }
-                } else if (line == "END") {
-                    // Posledny end
-                    state = ParserState::DONE;
-                } else {
-                    cerr << "Expected 'STATE', 'TRANSITION', or 'END', found: " << line << endl;
+                    error("Malformed TRANSITION line: ", line);
                 }
-                break;
-            case ParserState::EXPECT_STATE_ACTION:
-                if (line == "ACTION") {
-                    state = ParserState::INSIDE_STATE_ACTION;
+            } else if (line == "END") {
+                // Posledny end
+                m_state = ParserState::DONE;
+            } else if (startsWith(line, "MACHINE ") || startsWith(line, "INSTANCE ")) {
+                if (!m_acceptsDefinitions || !m_blocks.empty()) {
+                    error("MACHINE and INSTANCE have to come before the states: ", line);
+                } else if (line[0] == 'M') {
+                    m_definition = std::make_shared<Automaton>();
+                    m_definition->setName(std::string(trim(line.substr(8))));
+                    m_nested = std::make_unique<LineParser>(*m_definition, ParserState::EXPECT_START, nullptr, nullptr, true);
                 } else {
-                    cerr << "Expected 'ACTION', found: " << line << endl;
+                    SubAutomatonInstance instance;
+                    if (parseInstance(line, instance))
+                        m_automaton.addInstance(std::move(instance));
+                    else
+                        error("Malformed INSTANCE line: ", line);
                 }
-                break;
+            } else {
+                error("Expected 'STATE', 'TRANSITION', or 'END', found: ", line);
+            }
+            break;
+        case ParserState::EXPECT_STATE_ACTION:
+            if (line == "ACTION") {
+                m_state = ParserState::INSIDE_STATE_ACTION;
+            } else {
+                error("Expected 'ACTION', found: ", line);
+            }
+            break;
 
-            case ParserState::INSIDE_STATE_ACTION:
-                if (line == "END") {
-                    state = ParserState::EXPECT_STATE_OR_TRANSITION;
-                } else {
-                    automaton.appendToAction(currentState, rawLine);
-                }
-                break;
-            
-            case ParserState::EXPECT_TRANSITION_CONDITION:
-                if (startsWith(line, "CONDITION"))
-                {
-                    currentTransition.condition = trim(line.substr(9));
-                    state = ParserState::EXPECT_TRANSITION_DELAY;
-                } 
+        case ParserState::INSIDE_STATE_ACTION:
+            if (line == "END") {
+                m_state = ParserState::EXPECT_STATE_OR_TRANSITION;
+            } else if (m_text) {
+                // skipped lines in between are skipped again by DecodeAction
+                std::string_view& lines = m_states.back().actionLines;
+                const char* first = lines.empty() ? rawLine.data() : lines.data();
+                lines = std::string_view(first, static_cast<size_t>(rawLine.data() + rawLine.size() - first));
+            } else {
+                std::string& action = m_states.back().action;
+                action += rawLine;
+                action += '\n';
+            }
+            break;
+        
+        case ParserState::EXPECT_TRANSITION_CONDITION:
+            if (startsWith(line, "CONDITION"))
+            {
+                if (m_text)
+                    m_currentTransition.conditionText = trim(line.substr(9));
                 else
-                {
-                    cerr << "Expected 'CONDITION', found: " << line << endl;
-                }
-                break;
+                    m_currentTransition.condition = std::string(trim(line.substr(9)));
+                m_state = ParserState::EXPECT_TRANSITION_DELAY;
+            } 
+            else
+            {
+                error("Expected 'CONDITION', found: ", line);
+            }
+            break;
 
-            case ParserState::EXPECT_TRANSITION_DELAY:
-                if (startsWith(line, "DELAY")) {
-                    string delayStr = trim(line.substr(5));
-                    size_t pos = 0;
-                    try {
-                        int delay = stoi(delayStr, &pos);
-                        if (pos != delayStr.size()) {
-                            cerr << "Invalid characters in DELAY" << delayStr << endl;
-                        } else {
-                            currentTransition.delay = delay;
-                        }
-                    } catch (const invalid_argument& e) {
-                        cerr << "Invalid delay value: " << delayStr << endl;
-                    } catch (const out_of_range& e) {
-                        cerr << "DELAY value out of range: " << delayStr << endl;
-                    }
-                    automaton.addTransition(currentTransition);
-                    state = ParserState::EXPECT_STATE_OR_TRANSITION;
+        case ParserState::EXPECT_TRANSITION_DELAY:
+            if (startsWith(line, "DELAY")) {
+                std::string_view delayStr = trim(line.substr(5));
+                int delay = 0;
+                auto [ptr, ec] = std::from_chars(delayStr.data(), delayStr.data() + delayStr.size(), delay);
+                if (ec == std::errc::result_out_of_range) {
+                    error("DELAY value out of range: ", delayStr);
+                } else if (ec != std::errc() || ptr == delayStr.data()) {
+                    error("Invalid delay value: ", delayStr);
+                } else if (ptr != delayStr.data() + delayStr.size()) {
+                    error("Invalid characters in DELAY: ", delayStr);
                 } else {
-                    cerr << "Expected 'DELAY', found: " << line << endl;
+                    m_currentTransition.delay = delay;
                 }
-                break;
+                m_blocks.emplace_back(false, m_transitions.size());
+                m_transitions.push_back(std::move(m_currentTransition));
+                m_state = ParserState::EXPECT_STATE_OR_TRANSITION;
+            } else {
+                error("Expected 'DELAY', found: ", line);
+            }
+            break;
+
+        case ParserState::DONE:
+            break;
+    }
+}
+
+void LineParser::merge(size_t firstLine)
+{
+    if (m_nested) {
+        for (auto& entry : m_nested->m_errors)
+            m_errors.push_back(std::move(entry));
+        error("MACHINE block without END: ", m_definition->getName());
+        m_nested.reset();
+    }
+
+    for (const auto& [line, message] : m_errors)
+        cerr << "Line " << (firstLine + line) << ": " << message << endl;
+
+    for (const auto& [isState, index] : m_blocks) {
+        if (isState) {
+            ParsedState& parsed = m_states[index];
+            Symbol name(std::string(parsed.name));
+            if (m_text)
+                m_text->actions[name] = parsed.actionLines;
+            m_automaton.addState(name, std::move(parsed.action));
+        } else {
+            ParsedTransition& parsed = m_transitions[index];
+            Transition t;
+            t.fromState = Symbol(std::string(parsed.fromState));
+            t.toState = Symbol(std::string(parsed.toState));
+            t.condition = std::move(parsed.condition);
+            t.delay = parsed.delay;
+            if (m_text)
+                m_text->conditions.push_back(parsed.conditionText);
+            m_automaton.addTransition(std::move(t));
+        }
+    }
+}
+
+// start of the next line at or after pos that begins a block ("STATE " or "TRANSITION " at column 0)
+static size_t nextBlockStart(std::string_view data, size_t pos)
+{
+    if (pos > 0) {
+        size_t newline = data.find('\n', pos - 1);
+        pos = (newline == std::string_view::npos) ? data.size() : newline + 1;
+    }
+    while (pos < data.size()) {
+        std::string_view rest = data.substr(pos);
+        if (startsWith(rest, "STATE ") || startsWith(rest, "TRANSITION "))
+            return pos;
+        size_t newline = data.find('\n', pos);
+        pos = (newline == std::string_view::npos) ? data.size() : newline + 1;
+    }
+    return data.size();
+}
+
+void AutomatonParser::FromFile(std::string const filename, Automaton& automaton, std::vector<StateInfo>* outStatesInfo, unsigned threadCount)
+{
+    MappedFile contents(filename);
+    if (!contents.ok()) {
+        cerr << "Failed to open file: " << filename << endl;
+        return;
+    }
+    FromBuffer(contents.view(), automaton, outStatesInfo, threadCount);
+}
+
+// parse a text buffer to an automaton instance
+void AutomatonParser::FromBuffer(std::string_view data, Automaton& automaton, std::vector<StateInfo>* outStatesInfo, unsigned threadCount, SourceText* outText)
+{
+    if (outText) {
+        *outText = SourceText();
+        outText->encodedActions = true;
+    }
 
-            case ParserState::DONE:
+    // 1) node header and the AUTOMATON ... VARS END prologue, always sequential
+    LineParser prologue(automaton, ParserState::EXPECT_AUTOMATON, outStatesInfo, outText, true);
+    size_t consumed = prologue.parse(data, true);
+    std::string_view body = data.substr(consumed);
+
+    if (threadCount == 0)
+        threadCount = (body.size() >= ParallelThreshold) ? std::max(1u, std::thread::hardware_concurrency()) : 1;
+
+    // 2) split the blocks into chunks
+    std::vector<std::string_view> chunks;
+    if (threadCount > 1 && prologue.state() == ParserState::EXPECT_STATE_OR_TRANSITION) {
+        size_t chunkSize = body.size() / threadCount + 1;
+        size_t begin = 0;
+        while (begin < body.size()) {
+            size_t end = nextBlockStart(body, std::min(body.size(), begin + chunkSize));
+            chunks.push_back(body.substr(begin, end - begin));
+            begin = end;
+        }
+    }
+
+    if (chunks.size() > 1) {
+        std::vector<LineParser> parsers;
+        parsers.reserve(chunks.size());
+        for (size_t i = 0; i < chunks.size(); ++i)
+            parsers.emplace_back(automaton, ParserState::EXPECT_STATE_OR_TRANSITION, nullptr, outText);
+
+        std::vector<std::thread> workers;
+        workers.reserve(chunks.size());
+        for (size_t i = 0; i < chunks.size(); ++i)
+            workers.emplace_back([&parsers, &chunks, i] { parsers[i].parse(chunks[i]); });
+        for (auto& worker : workers)
+            worker.join();
+
+        // a chunk has to end between two blocks, otherwise the split guessed wrong
+        // (e.g. an unindented "STATE " line inside an action) and the blocks are parsed sequentially
+        bool consistent = true;
+        for (size_t i = 0; i + 1 < chunks.size() && consistent; ++i) {
+            if (parsers[i].state() == ParserState::DONE)
                 break;
+            consistent = parsers[i].state() == ParserState::EXPECT_STATE_OR_TRANSITION;
+        }
+
+        if (consistent) {
+            prologue.merge(0);
+            size_t firstLine = prologue.lineCount();
+            for (auto& parser : parsers) {
+                parser.merge(firstLine);
+                firstLine += parser.lineCount();
+                if (parser.state() == ParserState::DONE)
+                    break;      // the rest of the file is ignored, as in a sequential parse
+            }
+            return;
         }
     }
+
+    // 3) sequential parse of the blocks
+    LineParser blocks(automaton, prologue.state(), nullptr, outText);
+    blocks.parse(body);
+    prologue.merge(0);
+    blocks.merge(prologue.lineCount());
+}
+
+std::string AutomatonParser::DecodeAction(std::string_view lines)
+{
+    std::string action;
+    action.reserve(lines.size() + 1);
+    while (!lines.empty()) {
+        size_t newline = lines.find('\n');
+        std::string_view rawLine = lines.substr(0, newline);
+        lines = (newline == std::string_view::npos) ? std::string_view() : lines.substr(newline + 1);
+
+        if (!rawLine.empty() && rawLine.back() == '\r')
+            rawLine.remove_suffix(1);
+        std::string_view line = trim(rawLine);
+        if (line.empty() || line[0] == '#')
+            continue;
+        action += rawLine;
+        action += '\n';
+    }
+    return action;
 }
@@ -5,13 +5,45 @@
 #ifndef AUTOMATON_PARSER_H
 #define AUTOMATON_PARSER_H
 
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
 #include "automaton-data.hpp"
 
+// UI info of a node, stored in the "#name;x;y;in;out" header of a saved file
+struct StateInfo {
+    std::string name;
+    int posX = 0;
+    int posY = 0;
+    int inPortCount = 0;
+    int outPortCount = 0;
+};
+
+// Action and condition text left in the parsed buffer instead of being copied into the automaton,
+// the views are valid as long as the buffer is
+struct SourceText {
+    bool encodedActions = false;                            // actions are the raw ACTION block lines, see AutomatonParser::DecodeAction
+    std::unordered_map<Symbol, std::string_view> actions;   // by state name
+    std::vector<std::string_view> conditions;               // by index into Automaton::getTransitions()
+};
+
 class AutomatonParser
 {
 public:
-    // expose a single static parsing method
-    static void FromFile(std::string const filename, Automaton& outAutomaton);
+    // blocks after VARS are parsed in parallel when there are at least this many bytes of them
+    static constexpr size_t ParallelThreshold = 1 << 20;
+
+    // parse a file in a single pass, optionally collecting the node header too
+    // threadCount 0 picks the number of threads by the file size, 1 forces a sequential parse
+    static void FromFile(std::string const filename, Automaton& outAutomaton, std::vector<StateInfo>* outStatesInfo = nullptr, unsigned threadCount = 0);
+
+    // parse an in-memory copy of a saved file
+    // with outText set, the actions and conditions of the automaton stay empty and are referenced by outText
+    static void FromBuffer(std::string_view data, Automaton& outAutomaton, std::vector<StateInfo>* outStatesInfo = nullptr, unsigned threadCount = 0, SourceText* outText = nullptr);
+
+    // builds an action from the lines of its ACTION block, as the parser does
+    static std::string DecodeAction(std::string_view lines);
 };
 
-#endif
\ No newline at end of file
+#endif
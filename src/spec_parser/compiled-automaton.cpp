@@ -0,0 +1,103 @@
+/**
+ * @brief Index based, compiled form of an automaton
+ * @author Jakub Kovarik
+ */
+
+#include "compiled-automaton.hpp"
+
+#include <algorithm>
+
+StateId CompiledAutomaton::intern(Symbol stateName)
+{
+    auto [it, inserted] = m_ids.emplace(stateName, static_cast<StateId>(m_stateNames.size()));
+    if (inserted) {
+        m_stateNames.push_back(stateName);
+        m_actions.emplace_back();
+        m_isFinal.push_back(0);
+        m_isDeclared.push_back(0);
+    }
+    return it->second;
+}
+
+StateId CompiledAutomaton::stateId(Symbol stateName) const
+{
+    auto it = m_ids.find(stateName);
+    return (it != m_ids.end()) ? it->second : InvalidStateId;
+}
+
+StateId CompiledAutomaton::stateId(const std::string& stateName) const
+{
+    auto symbol = Symbol::find(stateName);
+    return symbol ? stateId(*symbol) : InvalidStateId;
+}
+
+ArrayView<Transition> CompiledAutomaton::transitionsFrom(StateId id) const
+{
+    const Transition* base = m_transitions.data();
+    return ArrayView<Transition>(base + m_offsets[id], base + m_offsets[id + 1]);
+}
+
+ArrayView<StateId> CompiledAutomaton::targetsFrom(StateId id) const
+{
+    const StateId* base = m_targets.data();
+    return ArrayView<StateId>(base + m_offsets[id], base + m_offsets[id + 1]);
+}
+
+CompiledAutomaton CompiledAutomaton::FromAutomaton(const Automaton& automaton)
+{
+    CompiledAutomaton result;
+
+    const auto& states = automaton.getStates();
+    const auto& transitions = automaton.getTransitions();
+
+    result.m_ids.reserve(states.size());
+    result.m_stateNames.reserve(states.size());
+
+    // 1) intern the declared states sorted by name, the hashed map iterates in the order
+    //    of the interned pointers, which differs between two runs of the editor
+    std::vector<const std::pair<const Symbol, std::pmr::string>*> declared;
+    declared.reserve(states.size());
+    for (const auto& entry : states)
+        declared.push_back(&entry);
+    std::sort(declared.begin(), declared.end(), [](const auto* a, const auto* b) { return a->first < b->first; });
+    for (const auto* entry : declared) {
+        StateId id = result.intern(entry->first);
+        result.m_actions[id] = entry->second;
+        result.m_isDeclared[id] = 1;
+    }
+
+    // 2) resolve transition endpoints and count the out degree of every state
+    std::vector<StateId> from(transitions.size());
+    std::vector<StateId> to(transitions.size());
+    for (size_t i = 0; i < transitions.size(); ++i) {
+        from[i] = result.intern(transitions[i].fromState);
+        to[i] = result.intern(transitions[i].toState);
+    }
+
+    const size_t n = result.m_stateNames.size();
+    result.m_offsets.assign(n + 1, 0);
+    for (StateId f : from)
+        result.m_offsets[f + 1]++;
+    for (size_t i = 0; i < n; ++i)
+        result.m_offsets[i + 1] += result.m_offsets[i];
+
+    // 3) scatter the transitions into their rows, keeping the original order (stable)
+    result.m_transitions.resize(transitions.size());
+    result.m_targets.resize(transitions.size());
+    std::vector<uint32_t> cursor(result.m_offsets.begin(), result.m_offsets.end() - 1);
+    for (size_t i = 0; i < transitions.size(); ++i) {
+        uint32_t slot = cursor[from[i]]++;
+        result.m_transitions[slot] = transitions[i];
+        result.m_targets[slot] = to[i];
+    }
+
+    for (const auto& finalName : automaton.getFinalStates()) {
+        StateId id = result.stateId(finalName);
+        if (id != InvalidStateId)
+            result.m_isFinal[id] = 1;
+    }
+
+    result.m_startState = result.stateId(automaton.getStartName());
+
+    return result;
+}
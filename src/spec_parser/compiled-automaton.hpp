@@ -0,0 +1,98 @@
+/**
+ * @brief Index based, compiled form of an automaton
+ *
+ * State names are interned to dense integer ids (0..stateCount()-1), the declared
+ * states in the order of their names so the ids do not change between runs, and outgoing
+ * transitions are stored grouped by their source state in one contiguous array
+ * (CSR layout), so enumerating the transitions of a state is O(1) to locate and
+ * O(out degree) to iterate. Transitions of a state keep the order in which they
+ * were added to the automaton, which is also their evaluation priority.
+ *
+ * @author Jakub Kovarik
+ */
+#ifndef COMPILED_AUTOMATON_H
+#define COMPILED_AUTOMATON_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "automaton-data.hpp"
+
+using StateId = int32_t;
+constexpr StateId InvalidStateId = -1;
+
+/**
+ * @brief Read-only view over a contiguous array, used to expose parts of the tables.
+ */
+template<typename T>
+class ArrayView
+{
+public:
+    ArrayView() = default;
+    ArrayView(const T* first, const T* last) : m_begin(first), m_end(last) {}
+
+    const T* begin() const { return m_begin; }
+    const T* end() const { return m_end; }
+    size_t size() const { return static_cast<size_t>(m_end - m_begin); }
+    bool empty() const { return m_begin == m_end; }
+    const T& operator[](size_t i) const { return m_begin[i]; }
+
+private:
+    const T* m_begin = nullptr;
+    const T* m_end = nullptr;
+};
+
+class CompiledAutomaton
+{
+public:
+    /**
+     * @brief Compiles the automaton in O(states + transitions).
+     *
+     * States referenced only by transitions are interned as well, so every
+     * transition has valid endpoints, but they are not declared (isDeclaredState()).
+     */
+    static CompiledAutomaton FromAutomaton(const Automaton& automaton);
+
+    size_t stateCount() const { return m_stateNames.size(); }
+    size_t transitionCount() const { return m_transitions.size(); }
+
+    // Name interning
+    StateId stateId(Symbol stateName) const;
+    StateId stateId(const std::string& stateName) const; ///< does not intern the name
+    const std::string& stateName(StateId id) const { return m_stateNames[id].str(); }
+    Symbol stateSymbol(StateId id) const { return m_stateNames[id]; }
+
+    // State properties
+    StateId startState() const { return m_startState; }
+    bool isFinalState(StateId id) const { return m_isFinal[id] != 0; }
+    bool isDeclaredState(StateId id) const { return m_isDeclared[id] != 0; }
+    const std::string& stateAction(StateId id) const { return m_actions[id]; }
+
+    // Outgoing transitions of a state, in priority order
+    ArrayView<Transition> transitionsFrom(StateId id) const;
+    ArrayView<StateId> targetsFrom(StateId id) const;
+
+    // CSR row range of a state, indices into transition(i) / target(i)
+    uint32_t firstTransition(StateId id) const { return m_offsets[id]; }
+    uint32_t lastTransition(StateId id) const { return m_offsets[id + 1]; }
+    const Transition& transition(uint32_t i) const { return m_transitions[i]; }
+    StateId target(uint32_t i) const { return m_targets[i]; }
+
+private:
+    StateId intern(Symbol stateName);
+
+    std::vector<Symbol> m_stateNames;                   ///< id -> name
+    std::unordered_map<Symbol, StateId> m_ids;          ///< name -> id
+    std::vector<std::string> m_actions;                 ///< id -> action code
+    std::vector<char> m_isFinal;                        ///< id -> is final state
+    std::vector<char> m_isDeclared;                     ///< id -> declared by the automaton, not only by a transition
+    StateId m_startState = InvalidStateId;
+
+    std::vector<uint32_t> m_offsets;                    ///< CSR row offsets, stateCount() + 1 entries
+    std::vector<Transition> m_transitions;              ///< transitions grouped by source state
+    std::vector<StateId> m_targets;                     ///< target id of each transition
+};
+
+#endif
@@ -0,0 +1,57 @@
+/**
+ * @brief Read-only contents of a file, memory mapped where the platform supports it
+ * @author Jakub Kovarik
+ */
+
+#include "mapped-file.hpp"
+
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MAPPED_FILE_MMAP
+#endif
+
+MappedFile::MappedFile(const std::string& filename)
+{
+#ifdef MAPPED_FILE_MMAP
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        return;
+    struct stat st;
+    if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+        void* mapped = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped != MAP_FAILED) {
+            m_mapped = mapped;
+            m_size = static_cast<size_t>(st.st_size);
+        }
+    }
+    ::close(fd);
+    m_ok = true;
+    if (m_mapped)
+        return;
+#endif
+    std::ifstream in(filename, std::ios::binary);
+    if (!in)
+        return;
+    m_ok = true;
+    in.seekg(0, std::ios::end);
+    std::streamoff size = in.tellg();
+    if (size <= 0)
+        return;
+    m_buffer.resize(static_cast<size_t>(size));
+    in.seekg(0, std::ios::beg);
+    in.read(&m_buffer[0], size);
+    m_buffer.resize(static_cast<size_t>(in.gcount()));
+}
+
+MappedFile::~MappedFile()
+{
+#ifdef MAPPED_FILE_MMAP
+    if (m_mapped)
+        ::munmap(m_mapped, m_size);
+#endif
+}
@@ -0,0 +1,35 @@
+/**
+ * @brief Read-only contents of a file, memory mapped where the platform supports it
+ * @author Jakub Kovarik
+ */
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <string>
+#include <string_view>
+
+class MappedFile
+{
+public:
+    // maps the file, falls back to reading it at once where mmap is not available
+    explicit MappedFile(const std::string& filename);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // true if the file could be opened (an empty file is ok)
+    bool ok() const { return m_ok; }
+
+    const char* data() const { return m_mapped ? static_cast<const char*>(m_mapped) : m_buffer.data(); }
+    size_t size() const { return m_mapped ? m_size : m_buffer.size(); }
+    std::string_view view() const { return std::string_view(data(), size()); }
+
+private:
+    bool m_ok = false;
+    void* m_mapped = nullptr;
+    size_t m_size = 0;
+    std::string m_buffer;
+};
+
+#endif
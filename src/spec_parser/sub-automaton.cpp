@@ -0,0 +1,272 @@
+/**
+ * @brief Expansion of the sub-automaton instances into plain states
+ * @author Jakub Kovarik
+ */
+
+#include "sub-automaton.hpp"
+
+#include <cctype>
+#include <unordered_set>
+
+using Renames = std::unordered_map<std::string, std::string>;
+
+static bool isIdentifierStart(char c)
+{
+    return isalpha(static_cast<unsigned char>(c)) || c == '_';
+}
+
+static bool isIdentifierChar(char c)
+{
+    return isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+// Copies the identifiers and everything between them, renamed unless they follow a '.'
+static void renameCode(std::string_view code, const Renames& names, std::string& out);
+
+// Copies the string literal starting at code[pos], returns the position after it
+static size_t copyString(std::string_view code, size_t pos, bool formatted, const Renames& names, std::string& out)
+{
+    const char quote = code[pos];
+    const bool triple = code.compare(pos, 3, std::string(3, quote)) == 0;
+    const size_t open = triple ? 3 : 1;
+    out.append(code.substr(pos, open));
+    pos += open;
+
+    while (pos < code.size()) {
+        const char c = code[pos];
+        if (c == '\\' && pos + 1 < code.size()) {
+            out.append(code.substr(pos, 2));
+            pos += 2;
+        } else if (c == quote && (!triple || code.compare(pos, 3, std::string(3, quote)) == 0)) {
+            out.append(code.substr(pos, open));
+            return pos + open;
+        } else if (!triple && c == '\n') {
+            return pos;   // unterminated, the rest is code again
+        } else if (formatted && c == '{' && pos + 1 < code.size() && code[pos + 1] != '{') {
+            // the expression of an f-string, up to its closing brace
+            const size_t close = code.find('}', pos);
+            const size_t end = (close == std::string_view::npos) ? code.size() : close;
+            out += '{';
+            renameCode(code.substr(pos + 1, end - pos - 1), names, out);
+            pos = end;
+        } else {
+            out += c;
+            ++pos;
+        }
+    }
+    return pos;
+}
+
+static void renameCode(std::string_view code, const Renames& names, std::string& out)
+{
+    size_t pos = 0;
+    char previous = 0;   // last character that is not a space, a '.' marks an attribute
+    while (pos < code.size()) {
+        const char c = code[pos];
+        if (c == '#') {
+            const size_t newline = code.find('\n', pos);
+            const size_t end = (newline == std::string_view::npos) ? code.size() : newline;
+            out.append(code.substr(pos, end - pos));
+            pos = end;
+        } else if (c == '"' || c == '\'') {
+            pos = copyString(code, pos, false, names, out);
+            previous = c;
+        } else if (isIdentifierStart(c)) {
+            size_t end = pos + 1;
+            while (end < code.size() && isIdentifierChar(code[end]))
+                ++end;
+            const std::string_view word = code.substr(pos, end - pos);
+
+            // a string prefix such as f, rb or F
+            if (end < code.size() && (code[end] == '"' || code[end] == '\'') && word.size() <= 2
+                && word.find_first_not_of("rRbBuUfF") == std::string_view::npos) {
+                out.append(word);
+                pos = copyString(code, end, word.find_first_of("fF") != std::string_view::npos, names, out);
+                previous = '"';
+                continue;
+            }
+
+            auto renamed = (previous == '.') ? names.end() : names.find(std::string(word));
+            if (renamed != names.end())
+                out += renamed->second;
+            else
+                out.append(word);
+            pos = end;
+            previous = 'a';
+        } else {
+            if (!isspace(static_cast<unsigned char>(c)))
+                previous = c;
+            out += c;
+            ++pos;
+        }
+    }
+}
+
+std::string renameIdentifiers(std::string_view code, const Renames& names)
+{
+    if (names.empty())
+        return std::string(code);
+
+    std::string out;
+    out.reserve(code.size() + code.size() / 8);
+    renameCode(code, names, out);
+    return out;
+}
+
+namespace {
+
+// Where the transitions to and from a name of an expanded automaton go
+struct Ports {
+    Symbol entry;
+    std::vector<Symbol> exits;
+};
+
+class Expansion
+{
+public:
+    Expansion(Automaton& result, std::vector<std::string>* errors)
+        : m_result(result), m_errors(errors)
+    {
+        for (const auto& var : result.getVariables())
+            m_variables.insert(var.name);
+    }
+
+    // adds the states of the automaton with the prefix, returns its entry and exits
+    Ports expand(const Automaton& automaton, const std::string& prefix, const Renames& renames,
+                 bool finalsAreFinal, int depth);
+
+private:
+    const Automaton* findDefinition(const std::string& name) const
+    {
+        for (auto scope = m_scopes.rbegin(); scope != m_scopes.rend(); ++scope) {
+            if (const Automaton* definition = (*scope)->findDefinition(name))
+                return definition;
+        }
+        return nullptr;
+    }
+
+    void error(std::string message)
+    {
+        if (m_errors)
+            m_errors->push_back(std::move(message));
+    }
+
+    Automaton& m_result;
+    std::vector<std::string>* m_errors;
+    std::unordered_set<std::string> m_variables;    // variables of the result
+    std::vector<const Automaton*> m_scopes;         // the automata being expanded, outermost first
+};
+
+Ports Expansion::expand(const Automaton& automaton, const std::string& prefix, const Renames& renames,
+                        bool finalsAreFinal, int depth)
+{
+    m_scopes.push_back(&automaton);
+
+    // 1) the instances, before the states so their entries and exits are known
+    std::unordered_map<std::string, Ports> instances;
+    for (const SubAutomatonInstance& instance : automaton.getInstances()) {
+        const std::string qualified = prefix + instance.name;
+        const Automaton* definition = findDefinition(instance.definition);
+        if (!definition) {
+            error("Instance " + qualified + " of an unknown sub-automaton " + instance.definition);
+            continue;
+        }
+        if (depth >= MaxSubAutomatonNesting) {
+            error("Instance " + qualified + " is nested too deep, does " + instance.definition + " use itself?");
+            continue;
+        }
+        if (definition->getStartName().empty()) {
+            error("Sub-automaton " + instance.definition + " has no start state");
+            continue;
+        }
+
+        // a variable of the definition goes to its binding, renamed as the code around the instance
+        Renames inner;
+        for (const auto& var : definition->getVariables()) {
+            std::string target = var.name;
+            for (const auto& [parameter, variable] : instance.bindings) {
+                if (parameter == var.name)
+                    target = variable;
+            }
+            auto outer = renames.find(target);
+            if (outer != renames.end())
+                target = outer->second;
+
+            if (m_variables.insert(target).second)
+                m_result.addVariable(target, var.value, var.type);
+            if (target != var.name)
+                inner.emplace(var.name, std::move(target));
+        }
+
+        const bool instanceFinal = finalsAreFinal && automaton.isFinalState(instance.name);
+        instances[instance.name] = expand(*definition, qualified + ".", inner, instanceFinal, depth + 1);
+    }
+
+    auto qualify = [&prefix](Symbol name) -> Symbol {
+        return prefix.empty() ? name : Symbol(prefix + name.str());
+    };
+
+    // 2) the states, their code renamed
+    for (const auto& [name, action] : automaton.getStates()) {
+        const Symbol state = qualify(name);
+        if (renames.empty())
+            m_result.addState(state, action);
+        else
+            m_result.addState(state, renameIdentifiers(action, renames));
+        if (finalsAreFinal && automaton.isFinalState(name))
+            m_result.addFinalState(state);
+    }
+
+    // 3) the transitions in order, an instance is entered at its entry and left from its exits
+    for (const Transition& t : automaton.getTransitions()) {
+        auto to = instances.find(t.toState);
+        const Symbol target = (to != instances.end()) ? to->second.entry : qualify(t.toState);
+        const std::string condition = renames.empty() ? std::string(t.condition) : renameIdentifiers(t.condition, renames);
+
+        auto from = instances.find(t.fromState);
+        if (from == instances.end()) {
+            m_result.addTransition(Transition{qualify(t.fromState), target, std::pmr::string(condition), t.delay});
+            continue;
+        }
+        for (Symbol exit : from->second.exits)
+            m_result.addTransition(Transition{exit, target, std::pmr::string(condition), t.delay});
+    }
+
+    Ports ports;
+    auto start = instances.find(automaton.getStartName());
+    ports.entry = (start != instances.end()) ? start->second.entry : qualify(automaton.getStartName());
+    for (Symbol name : automaton.getFinalStates()) {
+        auto instance = instances.find(name);
+        if (instance == instances.end())
+            ports.exits.push_back(qualify(name));
+        else
+            ports.exits.insert(ports.exits.end(), instance->second.exits.begin(), instance->second.exits.end());
+    }
+
+    m_scopes.pop_back();
+    return ports;
+}
+
+} // namespace
+
+Automaton expandSubAutomata(const Automaton& automaton, std::vector<std::string>* errors,
+                            std::pmr::memory_resource* resource)
+{
+    if (!resource)
+        resource = automaton.getResource();
+    if (automaton.getInstances().empty())
+        return Automaton(automaton, resource);
+
+    Automaton result(resource);
+    result.reserve(automaton.getStates().size(), automaton.getTransitions().size(), automaton.getVariables().size());
+    result.setName(automaton.getName());
+    result.setDescription(automaton.getDescription());
+    for (const auto& var : automaton.getVariables())
+        result.addVariable(var.name, var.value, var.type);
+
+    Expansion expansion(result, errors);
+    const Ports ports = expansion.expand(automaton, std::string(), Renames(), true, 0);
+    if (!automaton.getStartName().empty())
+        result.setStartState(ports.entry);
+    return result;
+}
@@ -0,0 +1,55 @@
+/**
+ * @brief Expansion of the sub-automaton instances into plain states
+ *
+ * The editor, the files and the model keep a definition once and an instance as a
+ * reference to it (see SubAutomatonInstance). Before an automaton runs, each instance is
+ * replaced by a copy of the states and transitions of its definition, named
+ * "<instance>.<state>":
+ * - a transition to the instance goes to the copy of the start state of the definition,
+ * - a transition of the instance leaves from the copies of every final state of the
+ *   definition, after their own transitions,
+ * - the copies of the final states are final only if the instance is,
+ * - the variables of the definition are renamed to the variables they are bound to in
+ *   the actions and conditions; an unbound variable keeps its name and is added to the
+ *   automaton with the initial value of the definition if the automaton has none.
+ *
+ * Instances inside a definition are expanded the same way, their definitions are looked
+ * up in the definition first and then in the enclosing automata. Instances with the same
+ * bindings get the same code, the generators then share their functions.
+ *
+ * @author Jakub Kovarik
+ */
+#ifndef SUB_AUTOMATON_H
+#define SUB_AUTOMATON_H
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "automaton-data.hpp"
+
+/// Instances nested deeper are not expanded, a definition that uses itself stops there
+constexpr int MaxSubAutomatonNesting = 16;
+
+/**
+ * @brief Renames the identifiers of Python code
+ *
+ * Names after a '.', in comments and in strings are kept, the expressions in the
+ * braces of an f-string are renamed.
+ */
+std::string renameIdentifiers(std::string_view code, const std::unordered_map<std::string, std::string>& names);
+
+/**
+ * @brief Returns the automaton with its instances replaced by the states of their definitions
+ *
+ * An automaton without instances is copied unchanged, otherwise the result has no
+ * definitions and no instances.
+ *
+ * @param errors If not null, receives the instances that could not be expanded.
+ * @param resource Memory resource of the result, null to use the one of the automaton.
+ */
+Automaton expandSubAutomata(const Automaton& automaton, std::vector<std::string>* errors = nullptr,
+                            std::pmr::memory_resource* resource = nullptr);
+
+#endif
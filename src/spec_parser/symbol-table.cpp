@@ -0,0 +1,62 @@
+/**
+ * @brief Interned state names shared by the model, the parser and the generator
+ * @author Jakub Kovarik
+ */
+
+#include "symbol-table.hpp"
+
+#include <mutex>
+#include <unordered_set>
+
+// node based set, pointers to the elements stay valid on rehash
+struct Storage
+{
+    std::mutex mutex;
+    std::unordered_set<std::string> names;
+};
+
+static Storage& storage()
+{
+    static Storage instance;
+    return instance;
+}
+
+static const std::string* emptyName()
+{
+    static const std::string* name = SymbolTable::intern(std::string());
+    return name;
+}
+
+const std::string* SymbolTable::intern(const std::string& name)
+{
+    Storage& s = storage();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    return &*s.names.insert(name).first;
+}
+
+const std::string* SymbolTable::find(const std::string& name)
+{
+    Storage& s = storage();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    auto it = s.names.find(name);
+    return it != s.names.end() ? &*it : nullptr;
+}
+
+size_t SymbolTable::size()
+{
+    Storage& s = storage();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    return s.names.size();
+}
+
+Symbol::Symbol() : m_name(emptyName()) {}
+Symbol::Symbol(const std::string& name) : m_name(SymbolTable::intern(name)) {}
+Symbol::Symbol(const char* name) : m_name(SymbolTable::intern(name)) {}
+
+std::optional<Symbol> Symbol::find(const std::string& name)
+{
+    const std::string* interned = SymbolTable::find(name);
+    if (!interned)
+        return std::nullopt;
+    return Symbol(interned);
+}
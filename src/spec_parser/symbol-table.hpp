@@ -0,0 +1,75 @@
+/**
+ * @brief Interned state names shared by the model, the parser and the generator
+ *
+ * Every distinct name is stored exactly once in a process wide table. A Symbol is a
+ * pointer sized handle to the interned string, so copying a name is free and two
+ * names are equal exactly when their handles are. Interned names live until the
+ * process exits, so a name is interned only where it is stored; a lookup goes through
+ * Symbol::find(), which never inserts.
+ *
+ * @author Jakub Kovarik
+ */
+#ifndef SYMBOL_TABLE_H
+#define SYMBOL_TABLE_H
+
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <ostream>
+#include <string>
+
+class Symbol
+{
+public:
+    /// The empty name
+    Symbol();
+
+    /// Interns the name (thread safe)
+    explicit Symbol(const std::string& name);
+    explicit Symbol(const char* name);
+
+    /// The symbol of the name if it is interned already, the name is not inserted
+    static std::optional<Symbol> find(const std::string& name);
+
+    const std::string& str() const { return *m_name; }
+    operator const std::string&() const { return *m_name; }
+
+    bool empty() const { return m_name->empty(); }
+    size_t hash() const { return std::hash<const void*>()(m_name); }
+
+    friend bool operator==(const Symbol& a, const Symbol& b) { return a.m_name == b.m_name; }
+    friend bool operator!=(const Symbol& a, const Symbol& b) { return a.m_name != b.m_name; }
+
+    /// Orders by the name itself, so sorted output does not depend on the interning order
+    friend bool operator<(const Symbol& a, const Symbol& b) { return a.m_name != b.m_name && *a.m_name < *b.m_name; }
+
+    friend std::ostream& operator<<(std::ostream& os, const Symbol& s) { return os << *s.m_name; }
+
+private:
+    explicit Symbol(const std::string* interned) : m_name(interned) {}
+
+    const std::string* m_name;
+};
+
+namespace std {
+template<>
+struct hash<Symbol>
+{
+    size_t operator()(const Symbol& s) const { return s.hash(); }
+};
+}
+
+class SymbolTable
+{
+public:
+    /// Returns the stable storage of the name, inserting it if it is not interned yet
+    static const std::string* intern(const std::string& name);
+
+    /// Returns the stable storage of the name, null if it is not interned
+    static const std::string* find(const std::string& name);
+
+    /// Number of distinct interned names
+    static size_t size();
+};
+
+#endif
@@ -0,0 +1,39 @@
+/**
+ * @brief Typed initial value of an automaton variable
+ * @author Jakub Kovarik
+ */
+
+#include "variable-value.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+
+VariableValue parseVariableValue(const std::string& text)
+{
+    if (text.empty())
+        return std::monostate{};
+
+    std::string lower = text;
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    if (lower == "true") return true;
+    if (lower == "false") return false;
+
+    // the number has to span the whole text and fit its type
+    const char* begin = text.c_str();
+    const char* end = begin + text.size();
+    char* parsed = nullptr;
+
+    errno = 0;
+    const long long i = std::strtoll(begin, &parsed, 10);
+    if (parsed == end && errno != ERANGE)
+        return static_cast<int64_t>(i);
+
+    errno = 0;
+    const double d = std::strtod(begin, &parsed);
+    if (parsed == end && errno != ERANGE)
+        return d;
+
+    return text;
+}
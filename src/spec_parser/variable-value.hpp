@@ -0,0 +1,28 @@
+/**
+ * @brief Typed initial value of an automaton variable
+ *
+ * Variables are written as text in the .fsm file and in the editor. The text is parsed
+ * once, when the variable is declared or loaded, and the generators and the native
+ * engine read the typed value.
+ *
+ * @author Jakub Kovarik
+ */
+#ifndef VARIABLE_VALUE_H
+#define VARIABLE_VALUE_H
+
+#include <cstdint>
+#include <string>
+#include <variant>
+
+/// None, bool, int, float or str, in the order of the variant indexes
+using VariableValue = std::variant<std::monostate, bool, int64_t, double, std::string>;
+
+/**
+ * @brief Parses the text of a variable value, never throws
+ *
+ * Tries bool (`true`/`false` in any case), then a whole int, then a whole float; any
+ * other text is a string. The empty text is None.
+ */
+VariableValue parseVariableValue(const std::string& text);
+
+#endif
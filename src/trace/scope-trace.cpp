@@ -0,0 +1,147 @@
+/**
+ * @file scope-trace.cpp
+ * @brief Implementation of the ScopeTrace class.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#include "scope-trace.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+struct Event
+{
+    const char *name;
+    int64_t beginNs;  ///< since the epoch of the trace
+    int64_t durationNs;
+};
+
+/// Events of one thread; the mutex is only contended while the trace is written.
+struct ThreadBuffer
+{
+    std::mutex mutex;
+    std::vector<Event> events;
+    uint64_t dropped = 0;
+    uint32_t tid = 0;
+};
+
+std::mutex registryMutex;
+std::vector<std::shared_ptr<ThreadBuffer>> registry;  ///< every thread that recorded since start()
+uint32_t nextTid = 1;
+std::atomic<int64_t> epochNs{0};  ///< Clock time of start()
+
+ThreadBuffer& threadBuffer()
+{
+    // the registry keeps the buffer of a finished thread, it is written with the others
+    thread_local std::shared_ptr<ThreadBuffer> buffer;
+    if (!buffer) {
+        buffer = std::make_shared<ThreadBuffer>();
+        std::lock_guard<std::mutex> lock(registryMutex);
+        buffer->tid = nextTid++;
+        registry.push_back(buffer);
+    }
+    return *buffer;
+}
+
+int64_t sinceEpoch(ScopeTrace::Clock::time_point time)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count()
+           - epochNs.load(std::memory_order_relaxed);
+}
+
+void writeEscaped(FILE *file, const char *text)
+{
+    for (; *text; ++text) {
+        const unsigned char c = static_cast<unsigned char>(*text);
+        if (c == '"' || c == '\\')
+            std::fprintf(file, "\\%c", c);
+        else if (c < 0x20)
+            std::fprintf(file, "\\u%04x", c);
+        else
+            std::fputc(c, file);
+    }
+}
+
+} // namespace
+
+void ScopeTrace::start()
+{
+    s_enabled.store(false, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        // buffers of finished threads are only held by the registry
+        registry.erase(std::remove_if(registry.begin(), registry.end(),
+                                      [](const std::shared_ptr<ThreadBuffer>& buffer) { return buffer.use_count() == 1; }),
+                       registry.end());
+        for (const auto& buffer : registry) {
+            std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+            buffer->events.clear();
+            buffer->dropped = 0;
+        }
+    }
+    epochNs.store(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count(),
+                  std::memory_order_relaxed);
+    s_enabled.store(true, std::memory_order_release);
+}
+
+void ScopeTrace::stop()
+{
+    s_enabled.store(false, std::memory_order_release);
+}
+
+void ScopeTrace::record(const char *name, Clock::time_point begin, Clock::time_point end)
+{
+    if (!isEnabled())
+        return;
+
+    ThreadBuffer& buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    if (buffer.events.size() >= kMaxEventsPerThread) {
+        buffer.dropped++;
+        return;
+    }
+    buffer.events.push_back(Event{name, sinceEpoch(begin),
+                                  std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count()});
+}
+
+bool ScopeTrace::writeChromeTrace(const std::string &path)
+{
+    FILE *file = std::fopen(path.c_str(), "w");
+    if (!file)
+        return false;
+
+    std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", file);
+    bool first = true;
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (const auto& buffer : registry) {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        for (const Event& event : buffer->events) {
+            // complete events, the times are in microseconds
+            std::fputs(first ? "\n{\"name\":\"" : ",\n{\"name\":\"", file);
+            writeEscaped(file, event.name);
+            std::fprintf(file, "\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                         buffer->tid, event.beginNs / 1000.0, event.durationNs / 1000.0);
+            first = false;
+        }
+    }
+    std::fputs("\n]}\n", file);
+    return std::fclose(file) == 0;
+}
+
+uint64_t ScopeTrace::droppedEvents()
+{
+    std::lock_guard<std::mutex> lock(registryMutex);
+    uint64_t dropped = 0;
+    for (const auto& buffer : registry) {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        dropped += buffer->dropped;
+    }
+    return dropped;
+}
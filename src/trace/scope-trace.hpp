@@ -0,0 +1,105 @@
+/**
+ * @file scope-trace.hpp
+ * @brief Declaration of the ScopeTrace class and ICP_TRACE_SCOPE, timing of the editor hot paths.
+ *
+ * A scope costs one relaxed load while the trace is off. While it is on, the scope reads
+ * the monotonic clock twice and appends one event to a buffer of its thread, the buffers
+ * are merged only when the trace is written as Chrome `trace_event` JSON (chrome://tracing,
+ * Perfetto). Building with ICP_NO_SCOPE_TRACE removes the scopes completely.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#ifndef SCOPE_TRACE_HPP
+#define SCOPE_TRACE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @class ScopeTrace
+ * @brief Process wide recorder of timed scopes.
+ *
+ * Every thread records into its own buffer, which outlives the thread until the next
+ * start(). A buffer holds at most kMaxEventsPerThread events, later ones are counted
+ * by droppedEvents().
+ */
+class ScopeTrace
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr size_t kMaxEventsPerThread = 1 << 20;
+
+    /**
+     * @brief Drops the recorded events and starts recording.
+     */
+    static void start();
+
+    /**
+     * @brief Stops recording, the events stay until the next start().
+     */
+    static void stop();
+
+    static bool isEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Records a scope of the calling thread, nothing if the trace is off.
+     * @param name A string literal, only the pointer is kept.
+     */
+    static void record(const char *name, Clock::time_point begin, Clock::time_point end);
+
+    /**
+     * @brief Writes the recorded events as Chrome trace_event JSON.
+     * @return False if the file cannot be written.
+     */
+    static bool writeChromeTrace(const std::string &path);
+
+    static uint64_t droppedEvents();
+
+    /**
+     * @brief Records its lifetime, see ICP_TRACE_SCOPE.
+     */
+    class Scope
+    {
+    public:
+        explicit Scope(const char *name)
+            : m_name(isEnabled() ? name : nullptr)
+        {
+            if (m_name)
+                m_begin = Clock::now();
+        }
+
+        ~Scope()
+        {
+            if (m_name)
+                record(m_name, m_begin, Clock::now());
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        const char *m_name;       ///< nullptr if the trace was off when the scope began
+        Clock::time_point m_begin;
+    };
+
+private:
+    static inline std::atomic<bool> s_enabled{false};
+};
+
+#define ICP_TRACE_CONCAT_(a, b) a##b
+#define ICP_TRACE_CONCAT(a, b) ICP_TRACE_CONCAT_(a, b)
+
+/// Times the rest of the block under the name, a string literal.
+#ifdef ICP_NO_SCOPE_TRACE
+#define ICP_TRACE_SCOPE(name) ((void)0)
+#else
+#define ICP_TRACE_SCOPE(name) ScopeTrace::Scope ICP_TRACE_CONCAT(traceScope, __LINE__)(name)
+#endif
+
+#endif // SCOPE_TRACE_HPP
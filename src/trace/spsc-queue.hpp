@@ -0,0 +1,94 @@
+/**
+ * @file spsc-queue.hpp
+ * @brief Declaration of the SpscQueue class, a lock-free single producer single consumer ring.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#ifndef SPSC_QUEUE_HPP
+#define SPSC_QUEUE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @class SpscQueue
+ * @brief Bounded ring of trivially copyable items for one producer and one consumer thread.
+ *
+ * Each side owns one index and only reads the other one, so neither push() nor pop()
+ * takes a lock or allocates. The capacity is rounded up to a power of two.
+ */
+template<typename T>
+class SpscQueue
+{
+    static_assert(std::is_trivially_copyable<T>::value, "SpscQueue items are copied with memcpy");
+
+public:
+    explicit SpscQueue(size_t capacity)
+    {
+        size_t size = 2;
+        while (size < capacity)
+            size <<= 1;
+        m_items.resize(size);
+        m_mask = size - 1;
+    }
+
+    size_t capacity() const { return m_items.size(); }
+
+    /**
+     * @brief Appends the items; called by the producer only.
+     * @return False, and nothing is appended, if they do not all fit.
+     */
+    bool push(const T *items, size_t count)
+    {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        const size_t head = m_head.load(std::memory_order_acquire);
+        if (m_items.size() - (tail - head) < count)
+            return false;
+
+        // the items may wrap around the end of the ring
+        const size_t start = tail & m_mask;
+        const size_t first = std::min(count, m_items.size() - start);
+        std::memcpy(&m_items[start], items, first * sizeof(T));
+        std::memcpy(&m_items[0], items + first, (count - first) * sizeof(T));
+
+        m_tail.store(tail + count, std::memory_order_release);
+        return true;
+    }
+
+    bool push(const T &item) { return push(&item, 1); }
+
+    /**
+     * @brief Moves up to max items to out; called by the consumer only.
+     * @return The number of items moved.
+     */
+    size_t pop(T *out, size_t max)
+    {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        const size_t tail = m_tail.load(std::memory_order_acquire);
+        const size_t count = std::min(max, tail - head);
+        if (count == 0)
+            return 0;
+
+        const size_t start = head & m_mask;
+        const size_t first = std::min(count, m_items.size() - start);
+        std::memcpy(out, &m_items[start], first * sizeof(T));
+        std::memcpy(out + first, &m_items[0], (count - first) * sizeof(T));
+
+        m_head.store(head + count, std::memory_order_release);
+        return count;
+    }
+
+private:
+    std::vector<T> m_items;
+    size_t m_mask = 0;
+    alignas(64) std::atomic<size_t> m_head{0};   ///< Next item to pop, written by the consumer.
+    alignas(64) std::atomic<size_t> m_tail{0};   ///< Next free slot, written by the producer.
+};
+
+#endif // SPSC_QUEUE_HPP
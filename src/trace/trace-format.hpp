@@ -0,0 +1,103 @@
+/**
+ * @file trace-format.hpp
+ * @brief Binary execution trace (.fsmtrace) format.
+ *
+ * A trace is a header followed by fixed size records, appended as the automaton runs:
+ *
+ *   header | record | record | ...
+ *
+ * Names (states, variables and string values) are not stored in the records. The first
+ * use of a name appends a TraceEvent::Name record with its id and byte length, followed
+ * by the bytes of the name padded to whole records. Ids are dense per name kind, so a
+ * reader rebuilds its tables while it scans. Integers are stored in the native byte
+ * order, the header records it so foreign files are rejected.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#ifndef TRACE_FORMAT_HPP
+#define TRACE_FORMAT_HPP
+
+#include <cstdint>
+
+constexpr char TraceMagic[4] = {'F', 'S', 'M', 'T'};
+constexpr uint32_t TraceVersion = 1;
+constexpr uint32_t TraceByteOrderMark = 0x01020304;
+constexpr uint32_t TraceNoId = 0xffffffff;     ///< stateId of a record without a state
+constexpr uint16_t TraceNoVariable = 0xffff;   ///< variableId of a record without a variable
+
+/**
+ * @brief What happened, one record per protocol message.
+ */
+enum class TraceEvent : uint8_t
+{
+    Name = 0,            ///< name definition: kind is TraceNameKind, stateId the id, value the byte length
+    Loaded,              ///< automaton loaded, a new run starts
+    Started,             ///< stateId is the start state
+    State,               ///< stateId is the entered state
+    StateAction,         ///< stateId executed its action
+    Transition,          ///< stateId is the source, value the target state id, variableId unused
+    TransitionAction,    ///< stateId is the source, value the target state id
+    Variable,            ///< variableId changed to value
+    Finished,            ///< stateId is the final state
+    Stuck,               ///< stateId has no enabled transition
+    Stopped,             ///< stopped by the editor
+    Error                ///< value is the string id of the message
+};
+
+/**
+ * @brief Name kinds of the TraceEvent::Name records.
+ */
+enum class TraceNameKind : uint8_t
+{
+    State = 0,
+    Variable,
+    String
+};
+
+/**
+ * @brief Type of the value of a record.
+ */
+enum class TraceValueKind : uint8_t
+{
+    None = 0,
+    Number,   ///< value.number
+    Bool,     ///< value.integer is 0 or 1
+    String,   ///< value.integer is a string id
+    StateId   ///< value.integer is a state id
+};
+
+union TraceValue
+{
+    double number;
+    uint64_t integer;
+};
+
+struct TraceHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t recordSize;
+    uint64_t startTimeMs;   ///< wall clock of the first record, ms since the epoch
+    uint64_t reserved;
+};
+
+/**
+ * @brief One event, 24 bytes.
+ */
+struct TraceRecord
+{
+    uint64_t timestampUs;   ///< since the start of the trace
+    uint32_t stateId;
+    uint16_t variableId;
+    TraceEvent event;
+    uint8_t kind;           ///< TraceValueKind, TraceNameKind of a Name record
+    TraceValue value;
+};
+
+static_assert(sizeof(TraceHeader) == 32, "TraceHeader must stay 32 bytes");
+static_assert(sizeof(TraceRecord) == 24, "TraceRecord must stay 24 bytes");
+
+#endif // TRACE_FORMAT_HPP
@@ -0,0 +1,172 @@
+/**
+ * @file trace-reader.cpp
+ * @brief Implementation of the TraceReader class.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#include "trace-reader.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+bool TraceReader::open(const std::string &path)
+{
+    m_records = nullptr;
+    m_recordCount = m_eventCount = m_durationUs = 0;
+    for (auto &names : m_names)
+        names.clear();
+    m_checkpoints.clear();
+
+    m_file = std::make_unique<MappedFile>(path);
+    if (!m_file->ok() || m_file->size() < sizeof(TraceHeader))
+        return false;
+
+    TraceHeader header;
+    std::memcpy(&header, m_file->data(), sizeof(header));
+    if (std::memcmp(header.magic, TraceMagic, sizeof(header.magic)) != 0 || header.version != TraceVersion
+        || header.byteOrder != TraceByteOrderMark || header.recordSize != sizeof(TraceRecord))
+        return false;
+    m_startTimeMs = header.startTimeMs;
+
+    // a trace still being written may end in the middle of a record
+    const TraceRecord *records = reinterpret_cast<const TraceRecord*>(m_file->data() + sizeof(TraceHeader));
+    const uint64_t recordCount = (m_file->size() - sizeof(TraceHeader)) / sizeof(TraceRecord);
+
+    TraceSnapshot snapshot;
+    uint64_t index = 0;
+    while (index < recordCount) {
+        const TraceRecord &record = records[index];
+        if (record.event == TraceEvent::Name) {
+            const uint64_t chunks = nameRecordCount(record);
+            if (index + 1 + chunks > recordCount || record.kind > static_cast<uint8_t>(TraceNameKind::String))
+                break; // cut off by the writer
+            auto &names = m_names[record.kind];
+            if (names.size() <= record.stateId)
+                names.resize(record.stateId + 1);
+            names[record.stateId].assign(reinterpret_cast<const char*>(&records[index + 1]), record.value.integer);
+            index += 1 + chunks;
+            continue;
+        }
+
+        if (m_eventCount % kCheckpointInterval == 0)
+            m_checkpoints.push_back(Checkpoint{index, m_eventCount, snapshot});
+
+        apply(record, snapshot);
+        snapshot.event = m_eventCount++;
+        m_durationUs = record.timestampUs;
+        ++index;
+    }
+
+    m_records = records;
+    m_recordCount = index;
+    return true;
+}
+
+TraceSnapshot TraceReader::snapshotAtEvent(uint64_t event) const
+{
+    if (m_checkpoints.empty())
+        return TraceSnapshot();
+
+    event = std::min(event, m_eventCount - 1);
+    const Checkpoint &from = m_checkpoints[event / kCheckpointInterval];
+    return scan(from, event, UINT64_MAX);
+}
+
+TraceSnapshot TraceReader::snapshotAtTime(uint64_t timestampUs) const
+{
+    if (m_checkpoints.empty())
+        return TraceSnapshot();
+
+    // the last checkpoint not after the time, its block holds the event
+    auto it = std::upper_bound(m_checkpoints.begin(), m_checkpoints.end(), timestampUs,
+                               [this](uint64_t time, const Checkpoint &checkpoint) {
+        return time < m_records[checkpoint.record].timestampUs;
+    });
+    if (it != m_checkpoints.begin())
+        --it;
+    return scan(*it, UINT64_MAX, timestampUs);
+}
+
+std::string TraceReader::valueToString(const TraceSlot &slot) const
+{
+    switch (slot.kind) {
+    case TraceValueKind::Number: {
+        std::ostringstream out;
+        out << slot.value.number;
+        return out.str();
+    }
+    case TraceValueKind::Bool:
+        return slot.value.integer ? "true" : "false";
+    case TraceValueKind::String:
+        return stringValue(static_cast<uint32_t>(slot.value.integer));
+    case TraceValueKind::StateId:
+        return stateName(static_cast<uint32_t>(slot.value.integer));
+    case TraceValueKind::None:
+    default:
+        return "null";
+    }
+}
+
+const std::string& TraceReader::name(TraceNameKind kind, uint32_t id) const
+{
+    static const std::string unknown;
+    const auto &names = m_names[static_cast<size_t>(kind)];
+    return id < names.size() ? names[id] : unknown;
+}
+
+void TraceReader::apply(const TraceRecord &record, TraceSnapshot &snapshot) const
+{
+    snapshot.timestampUs = record.timestampUs;
+    snapshot.lastEvent = record.event;
+
+    switch (record.event) {
+    case TraceEvent::Loaded:
+        // a new automaton starts from scratch
+        snapshot.stateId = TraceNoId;
+        snapshot.variables.clear();
+        break;
+    case TraceEvent::Started:
+    case TraceEvent::State:
+    case TraceEvent::Finished:
+    case TraceEvent::Stuck:
+        snapshot.stateId = record.stateId;
+        break;
+    case TraceEvent::Variable:
+        if (record.variableId == TraceNoVariable)
+            break;
+        if (snapshot.variables.size() <= record.variableId)
+            snapshot.variables.resize(record.variableId + 1);
+        snapshot.variables[record.variableId] = TraceSlot{static_cast<TraceValueKind>(record.kind), record.value, true};
+        break;
+    default:
+        break;
+    }
+}
+
+uint64_t TraceReader::nameRecordCount(const TraceRecord &record) const
+{
+    return (record.value.integer + sizeof(TraceRecord) - 1) / sizeof(TraceRecord);
+}
+
+TraceSnapshot TraceReader::scan(const Checkpoint &from, uint64_t event, uint64_t timestampUs) const
+{
+    // the checkpoint holds the state before its first event
+    TraceSnapshot snapshot = from.snapshot;
+    uint64_t next = from.firstEvent;
+
+    for (uint64_t index = from.record; index < m_recordCount; ++index) {
+        const TraceRecord &record = m_records[index];
+        if (record.event == TraceEvent::Name) {
+            index += nameRecordCount(record);
+            continue;
+        }
+        if (next > event || record.timestampUs > timestampUs)
+            break;
+        apply(record, snapshot);
+        snapshot.event = next++;
+    }
+    return snapshot;
+}
@@ -0,0 +1,111 @@
+/**
+ * @file trace-reader.hpp
+ * @brief Declaration of the TraceReader class, random access to a recorded .fsmtrace file.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#ifndef TRACE_READER_HPP
+#define TRACE_READER_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "trace-format.hpp"
+#include "../spec_parser/mapped-file.hpp"
+
+/**
+ * @brief Value of one variable at some point of the trace.
+ */
+struct TraceSlot
+{
+    TraceValueKind kind = TraceValueKind::None;
+    TraceValue value{};
+    bool isSet = false;   ///< false until the variable is first reported
+};
+
+/**
+ * @brief State of the automaton after an event of the trace.
+ */
+struct TraceSnapshot
+{
+    uint64_t event = 0;            ///< index of the event, names are not counted
+    uint64_t timestampUs = 0;
+    TraceEvent lastEvent = TraceEvent::Loaded;
+    uint32_t stateId = TraceNoId;
+    std::vector<TraceSlot> variables;  ///< by variable id
+};
+
+/**
+ * @class TraceReader
+ * @brief Reads a trace in place from the mapped file.
+ *
+ * open() scans the file once: it collects the names and keeps a full snapshot every
+ * kCheckpointInterval events. A seek finds the checkpoint by binary search and applies
+ * at most kCheckpointInterval records to it, so any point is reached in O(log n) plus
+ * a bounded scan, and only the touched pages of the file are read into memory.
+ */
+class TraceReader
+{
+public:
+    static constexpr uint64_t kCheckpointInterval = 4096;
+
+    /**
+     * @brief Maps the file and builds the index.
+     * @return False if the file cannot be read or is not a trace of this build.
+     */
+    bool open(const std::string &path);
+
+    bool isValid() const { return m_records != nullptr; }
+
+    uint64_t eventCount() const { return m_eventCount; }
+    uint64_t durationUs() const { return m_durationUs; }
+    uint64_t startTimeMs() const { return m_startTimeMs; }
+
+    size_t variableCount() const { return m_names[static_cast<size_t>(TraceNameKind::Variable)].size(); }
+    const std::string& stateName(uint32_t id) const { return name(TraceNameKind::State, id); }
+    const std::string& variableName(uint32_t id) const { return name(TraceNameKind::Variable, id); }
+    const std::string& stringValue(uint32_t id) const { return name(TraceNameKind::String, id); }
+
+    /**
+     * @brief State after the event, the last event if it is past the end.
+     */
+    TraceSnapshot snapshotAtEvent(uint64_t event) const;
+
+    /**
+     * @brief State after the last event recorded at or before the time.
+     */
+    TraceSnapshot snapshotAtTime(uint64_t timestampUs) const;
+
+    /**
+     * @brief Formats a variable value like the variable panel does.
+     */
+    std::string valueToString(const TraceSlot &slot) const;
+
+private:
+    struct Checkpoint
+    {
+        uint64_t record;        ///< record index the scan continues from
+        uint64_t firstEvent;    ///< event index of that record
+        TraceSnapshot snapshot;
+    };
+
+    const std::string& name(TraceNameKind kind, uint32_t id) const;
+    void apply(const TraceRecord &record, TraceSnapshot &snapshot) const;
+    uint64_t nameRecordCount(const TraceRecord &record) const;
+    TraceSnapshot scan(const Checkpoint &from, uint64_t event, uint64_t timestampUs) const;
+
+    std::unique_ptr<MappedFile> m_file;
+    const TraceRecord *m_records = nullptr;
+    uint64_t m_recordCount = 0;
+    uint64_t m_eventCount = 0;
+    uint64_t m_durationUs = 0;
+    uint64_t m_startTimeMs = 0;
+    std::vector<std::string> m_names[3];   ///< by TraceNameKind and id
+    std::vector<Checkpoint> m_checkpoints; ///< every kCheckpointInterval events, the first at event 0
+};
+
+#endif // TRACE_READER_HPP
@@ -0,0 +1,181 @@
+/**
+ * @file trace-recorder.cpp
+ * @brief Implementation of the TraceRecorder class.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#include "trace-recorder.hpp"
+
+#include <cstring>
+#include <vector>
+
+TraceRecorder::TraceRecorder()
+    : m_queue(kQueueCapacity)
+{
+}
+
+TraceRecorder::~TraceRecorder()
+{
+    close();
+}
+
+bool TraceRecorder::open(const std::string &path)
+{
+    close();
+
+    m_file = std::fopen(path.c_str(), "wb");
+    if (!m_file)
+        return false;
+
+    TraceHeader header{};
+    std::memcpy(header.magic, TraceMagic, sizeof(header.magic));
+    header.version = TraceVersion;
+    header.byteOrder = TraceByteOrderMark;
+    header.recordSize = sizeof(TraceRecord);
+    header.startTimeMs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    std::fwrite(&header, sizeof(header), 1, m_file);
+
+    for (NameTable &names : m_names)
+        names.clear();
+    m_dropped = 0;
+    m_stop = false;
+    m_start = std::chrono::steady_clock::now();
+    m_writer = std::thread(&TraceRecorder::writerLoop, this);
+    return true;
+}
+
+void TraceRecorder::close()
+{
+    if (!m_file)
+        return;
+
+    m_stop = true;
+    if (m_writer.joinable())
+        m_writer.join();
+
+    std::fclose(m_file);
+    m_file = nullptr;
+}
+
+void TraceRecorder::recordState(TraceEvent event, const std::string &state)
+{
+    if (!m_file)
+        return;
+    TraceRecord record = makeRecord(event);
+    record.stateId = nameId(TraceNameKind::State, state);
+    push(record);
+}
+
+void TraceRecorder::recordTransition(TraceEvent event, const std::string &from, const std::string &to)
+{
+    if (!m_file)
+        return;
+    TraceRecord record = makeRecord(event);
+    record.stateId = nameId(TraceNameKind::State, from);
+    record.kind = static_cast<uint8_t>(TraceValueKind::StateId);
+    record.value.integer = nameId(TraceNameKind::State, to);
+    push(record);
+}
+
+void TraceRecorder::recordVariable(const std::string &name, TraceValueKind kind, TraceValue value)
+{
+    if (!m_file)
+        return;
+    TraceRecord record = makeRecord(TraceEvent::Variable);
+    record.variableId = static_cast<uint16_t>(nameId(TraceNameKind::Variable, name));
+    record.kind = static_cast<uint8_t>(kind);
+    record.value = value;
+    push(record);
+}
+
+void TraceRecorder::recordVariable(const std::string &name, const std::string &value)
+{
+    if (!m_file)
+        return;
+    TraceValue stringId;
+    stringId.integer = nameId(TraceNameKind::String, value);
+    recordVariable(name, TraceValueKind::String, stringId);
+}
+
+void TraceRecorder::recordEvent(TraceEvent event)
+{
+    if (!m_file)
+        return;
+    push(makeRecord(event));
+}
+
+void TraceRecorder::recordError(const std::string &message)
+{
+    if (!m_file)
+        return;
+    TraceRecord record = makeRecord(TraceEvent::Error);
+    record.kind = static_cast<uint8_t>(TraceValueKind::String);
+    record.value.integer = nameId(TraceNameKind::String, message);
+    push(record);
+}
+
+uint32_t TraceRecorder::nameId(TraceNameKind kind, const std::string &name)
+{
+    NameTable &names = m_names[static_cast<size_t>(kind)];
+    auto it = names.find(name);
+    if (it != names.end())
+        return it->second;
+
+    // the definition and the bytes of the name go through the queue in one push,
+    // so a reader always sees them before the first record using the id
+    const uint32_t id = static_cast<uint32_t>(names.size());
+    const size_t chunks = (name.size() + sizeof(TraceRecord) - 1) / sizeof(TraceRecord);
+    std::vector<TraceRecord> records(1 + chunks);
+    records[0] = makeRecord(TraceEvent::Name);
+    records[0].kind = static_cast<uint8_t>(kind);
+    records[0].stateId = id;
+    records[0].value.integer = name.size();
+    if (!name.empty())
+        std::memcpy(&records[1], name.data(), name.size());
+
+    if (!m_queue.push(records.data(), records.size())) {
+        // the id is not taken, the name is offered again by its next use
+        m_dropped += records.size();
+        return kind == TraceNameKind::Variable ? TraceNoVariable : TraceNoId;
+    }
+    names.emplace(name, id);
+    return id;
+}
+
+void TraceRecorder::push(TraceRecord record)
+{
+    if (!m_queue.push(record))
+        ++m_dropped;
+}
+
+TraceRecord TraceRecorder::makeRecord(TraceEvent event) const
+{
+    TraceRecord record{};
+    record.timestampUs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - m_start).count());
+    record.stateId = TraceNoId;
+    record.variableId = TraceNoVariable;
+    record.event = event;
+    return record;
+}
+
+void TraceRecorder::writerLoop()
+{
+    std::vector<TraceRecord> batch(4096);
+    for (;;) {
+        // the stop flag is read first, so the records pushed before close() are written
+        const bool stop = m_stop;
+        const size_t count = m_queue.pop(batch.data(), batch.size());
+        if (count > 0) {
+            std::fwrite(batch.data(), sizeof(TraceRecord), count, m_file);
+            continue;
+        }
+        if (stop)
+            break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    std::fflush(m_file);
+}
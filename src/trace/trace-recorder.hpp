@@ -0,0 +1,109 @@
+/**
+ * @file trace-recorder.hpp
+ * @brief Declaration of the TraceRecorder class, writes a .fsmtrace file in the background.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#ifndef TRACE_RECORDER_HPP
+#define TRACE_RECORDER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include "spsc-queue.hpp"
+#include "trace-format.hpp"
+
+/**
+ * @class TraceRecorder
+ * @brief Appends trace records to a file from a writer thread.
+ *
+ * The record functions are called by one producer thread (the editor thread, which
+ * receives the messages of both the runtime and the native engine). They only copy the
+ * record into a lock-free queue; the writer thread drains it to the file. A full queue
+ * drops the record instead of blocking the producer, droppedRecords() counts them.
+ */
+class TraceRecorder
+{
+public:
+    static constexpr size_t kQueueCapacity = 1 << 16;  ///< Records buffered for the writer.
+
+    TraceRecorder();
+
+    /**
+     * @brief Destructor, writes the queued records and closes the file.
+     */
+    ~TraceRecorder();
+
+    TraceRecorder(const TraceRecorder&) = delete;
+    TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+    /**
+     * @brief Creates the file, writes the header and starts the writer thread.
+     * @return False if the file cannot be created.
+     */
+    bool open(const std::string &path);
+
+    /**
+     * @brief Writes the queued records, stops the writer thread and closes the file.
+     */
+    void close();
+
+    bool isOpen() const { return m_file != nullptr; }
+    uint64_t droppedRecords() const { return m_dropped; }
+
+    /**
+     * @brief Records an event of a state, e.g. TraceEvent::State.
+     */
+    void recordState(TraceEvent event, const std::string &state);
+
+    /**
+     * @brief Records a transition from one state to another.
+     */
+    void recordTransition(TraceEvent event, const std::string &from, const std::string &to);
+
+    /**
+     * @brief Records a variable change.
+     */
+    void recordVariable(const std::string &name, TraceValueKind kind, TraceValue value);
+
+    /**
+     * @brief Records a variable change to a string value.
+     */
+    void recordVariable(const std::string &name, const std::string &value);
+
+    /**
+     * @brief Records an event without a state, e.g. TraceEvent::Stopped.
+     */
+    void recordEvent(TraceEvent event);
+
+    /**
+     * @brief Records an error with its message.
+     */
+    void recordError(const std::string &message);
+
+private:
+    using NameTable = std::unordered_map<std::string, uint32_t>;
+
+    uint32_t nameId(TraceNameKind kind, const std::string &name);
+    void push(TraceRecord record);
+    TraceRecord makeRecord(TraceEvent event) const;
+    void writerLoop();
+
+    std::FILE *m_file = nullptr;
+    SpscQueue<TraceRecord> m_queue;
+    std::thread m_writer;
+    std::atomic<bool> m_stop{false};
+    std::atomic<uint64_t> m_dropped{0};
+    std::chrono::steady_clock::time_point m_start;
+
+    NameTable m_names[3];  ///< Ids of the names by TraceNameKind, used by the producer only.
+};
+
+#endif // TRACE_RECORDER_HPP
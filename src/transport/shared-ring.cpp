@@ -0,0 +1,137 @@
+/**
+ * @file shared-ring.cpp
+ * @brief Implementation of the SharedRing and SharedSegment classes.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#include "shared-ring.hpp"
+
+#include <cstring>
+
+#if defined(__linux__) && defined(__x86_64__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SHARED_RING_SUPPORTED
+#endif
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "the rings need lock free 64 bit positions");
+
+SharedRing::SharedRing(char* base, uint64_t capacity)
+    : m_head(reinterpret_cast<std::atomic<uint64_t>*>(base))
+    , m_tail(reinterpret_cast<std::atomic<uint64_t>*>(base + 64))
+    , m_waiting(reinterpret_cast<std::atomic<uint32_t>*>(base + 72))
+    , m_data(base + kControlSize)
+    , m_capacity(capacity)
+{
+}
+
+uint64_t SharedRing::pending() const
+{
+    return m_head->load(std::memory_order_acquire) - m_tail->load(std::memory_order_acquire);
+}
+
+size_t SharedRing::write(const char* data, size_t size)
+{
+    const uint64_t head = m_head->load(std::memory_order_relaxed);
+    const uint64_t free = m_capacity - (head - m_tail->load(std::memory_order_acquire));
+    size = static_cast<size_t>(std::min<uint64_t>(size, free));
+    if (size == 0)
+        return 0;
+
+    const size_t start = static_cast<size_t>(head % m_capacity);
+    const size_t first = static_cast<size_t>(std::min<uint64_t>(size, m_capacity - start));
+    std::memcpy(m_data + start, data, first);
+    if (first < size)
+        std::memcpy(m_data, data + first, size - first);
+    // the head is stored before the waiting flag is read, see takeWaiting()
+    m_head->store(head + size, std::memory_order_seq_cst);
+    return size;
+}
+
+bool SharedRing::takeWaiting()
+{
+    if (m_waiting->load(std::memory_order_seq_cst) == 0)
+        return false;
+    return m_waiting->exchange(0, std::memory_order_seq_cst) != 0;
+}
+
+bool SharedRing::sleepIfEmpty()
+{
+    m_waiting->store(1, std::memory_order_seq_cst);
+    if (pending() == 0)
+        return true;
+    m_waiting->store(0, std::memory_order_relaxed);
+    return false;
+}
+
+void SharedRing::wake()
+{
+    m_waiting->store(0, std::memory_order_relaxed);
+}
+
+SharedSegment::~SharedSegment()
+{
+    detach();
+}
+
+bool SharedSegment::isSupported()
+{
+#ifdef SHARED_RING_SUPPORTED
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool SharedSegment::attach(const std::string& name)
+{
+    detach();
+#ifdef SHARED_RING_SUPPORTED
+    const int fd = ::shm_open(("/" + name).c_str(), O_RDWR, 0);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    void* base = MAP_FAILED;
+    if (::fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= kHeaderSize)
+        base = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED)
+        return false;
+
+    uint32_t header[3];
+    std::memcpy(header, base, sizeof(header));
+    const uint64_t capacity = header[2];
+    const size_t size = static_cast<size_t>(st.st_size);
+    if (header[0] != kMagic || header[1] != kVersion || capacity == 0
+        || kHeaderSize + 2 * (SharedRing::kControlSize + capacity) > size) {
+        ::munmap(base, size);
+        return false;
+    }
+
+    m_base = base;
+    m_size = size;
+    char* bytes = static_cast<char*>(base);
+    m_incoming = SharedRing(bytes + kHeaderSize, capacity);
+    m_outgoing = SharedRing(bytes + kHeaderSize + SharedRing::kControlSize + capacity, capacity);
+    return true;
+#else
+    (void)name;
+    return false;
+#endif
+}
+
+void SharedSegment::detach()
+{
+#ifdef SHARED_RING_SUPPORTED
+    if (m_base)
+        ::munmap(m_base, m_size);
+#endif
+    m_base = nullptr;
+    m_size = 0;
+    m_incoming = SharedRing();
+    m_outgoing = SharedRing();
+}
@@ -0,0 +1,147 @@
+/**
+ * @file shared-ring.hpp
+ * @brief Editor side of the shared memory transport to a runtime on the same host.
+ *
+ * The runtime creates a segment with two single producer, single consumer byte rings
+ * (fsm_core/shm.py): ring 0 carries its messages to the editor, ring 1 the commands of
+ * the editor. The rings carry the same byte stream as the socket would, the socket
+ * stays open as the doorbell: a producer writes one byte to it only when the consumer
+ * has flagged that it sleeps, so an idle editor is only woken when data arrives.
+ *
+ * The layout has to match fsm_core/shm.py. The positions are free running byte
+ * counters, each written by one side only; the Python side relies on the x86-64
+ * memory model, the transport is only available there.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#ifndef SHARED_RING_HPP
+#define SHARED_RING_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief One direction of a shared segment.
+ *
+ * The ring does not own its memory, it is a view into the SharedSegment.
+ */
+class SharedRing
+{
+public:
+    static constexpr size_t kControlSize = 128;  ///< head, tail and waiting flag on two cache lines
+
+    SharedRing() = default;
+    SharedRing(char* base, uint64_t capacity);
+
+    bool isValid() const { return m_data != nullptr; }
+
+    /// Bytes written and not yet read.
+    uint64_t pending() const;
+
+    /**
+     * @brief Producer: copies as much of the data as fits.
+     * @return The number of bytes written, 0 if the ring is full.
+     */
+    size_t write(const char* data, size_t size);
+
+    /**
+     * @brief Consumer: appends everything written so far to out and frees its space.
+     * @return The number of bytes read.
+     */
+    template<typename Buffer>
+    size_t readAll(Buffer& out);
+
+    /**
+     * @brief Producer: checks if the consumer sleeps and clears its flag.
+     * @return True if the caller has to ring the doorbell.
+     */
+    bool takeWaiting();
+
+    /**
+     * @brief Consumer: flags the sleep unless data has arrived meanwhile.
+     * @return False if the ring is not empty, the flag is cleared again then.
+     */
+    bool sleepIfEmpty();
+
+    /// Consumer: clears the sleep flag, the producer does not ring until it is set again.
+    void wake();
+
+private:
+    std::atomic<uint64_t>* m_head = nullptr;     ///< written by the producer
+    std::atomic<uint64_t>* m_tail = nullptr;     ///< written by the consumer
+    std::atomic<uint32_t>* m_waiting = nullptr;  ///< set by the sleeping consumer, cleared by the bell
+    char* m_data = nullptr;
+    uint64_t m_capacity = 0;
+};
+
+/**
+ * @brief A segment created by the runtime, mapped by the editor.
+ */
+class SharedSegment
+{
+public:
+    static constexpr uint32_t kMagic = 0x52534D46;  ///< "FMSR" in memory
+    static constexpr uint32_t kVersion = 1;
+    static constexpr size_t kHeaderSize = 64;
+
+    SharedSegment() = default;
+    ~SharedSegment();
+
+    SharedSegment(const SharedSegment&) = delete;
+    SharedSegment& operator=(const SharedSegment&) = delete;
+
+    /**
+     * @brief Checks if this build and host can use the transport.
+     */
+    static bool isSupported();
+
+    /**
+     * @brief Maps the segment of the runtime.
+     * @param name The name sent in TRANSPORT_SET, without the leading slash.
+     * @return False if the segment does not exist or has an unknown layout.
+     */
+    bool attach(const std::string& name);
+
+    /**
+     * @brief Unmaps the segment, the runtime removes it.
+     */
+    void detach();
+
+    bool isAttached() const { return m_base != nullptr; }
+
+    /// Ring 0, the messages of the runtime.
+    SharedRing& incoming() { return m_incoming; }
+    /// Ring 1, the commands of the editor.
+    SharedRing& outgoing() { return m_outgoing; }
+
+private:
+    void* m_base = nullptr;
+    size_t m_size = 0;
+    SharedRing m_incoming;
+    SharedRing m_outgoing;
+};
+
+template<typename Buffer>
+size_t SharedRing::readAll(Buffer& out)
+{
+    const uint64_t tail = m_tail->load(std::memory_order_relaxed);
+    const uint64_t head = m_head->load(std::memory_order_acquire);
+    const size_t size = static_cast<size_t>(head - tail);
+    if (size == 0)
+        return 0;
+
+    const size_t start = static_cast<size_t>(tail % m_capacity);
+    const size_t first = static_cast<size_t>(std::min<uint64_t>(size, m_capacity - start));
+    out.append(m_data + start, first);
+    if (first < size)
+        out.append(m_data, size - first);
+    m_tail->store(head, std::memory_order_release);
+    return size;
+}
+
+#endif // SHARED_RING_HPP
@@ -0,0 +1,318 @@
+/**
+ * @file automaton-validator.cpp
+ * @brief Implementation of the AutomatonValidator class.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#include "automaton-validator.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <unordered_set>
+
+namespace {
+
+bool isPlaceholderAction(std::string_view code)
+{
+    const std::size_t first = code.find_first_not_of(" \t\r\n");
+    if (first == std::string_view::npos)
+        return true;
+    return code.compare(0, 18, "# Enter code here:") == 0;
+}
+
+std::string atLine(int line, const std::string& message)
+{
+    return "line " + std::to_string(line) + ": " + message;
+}
+
+char closingOf(char open)
+{
+    return open == '(' ? ')' : open == '[' ? ']' : '}';
+}
+
+} // namespace
+
+std::optional<std::string> AutomatonValidator::checkPythonSyntax(std::string_view code, bool expression)
+{
+    struct Bracket
+    {
+        char open;
+        int line;
+    };
+    std::vector<Bracket> brackets;
+
+    char quote = 0;               // quote of the string being read, 0 outside strings
+    bool triple = false;
+    int stringLine = 0;
+
+    std::vector<int> indents{0};
+    bool expectIndent = false;    // the last logical line opened a block
+    int blockLine = 0;
+    bool continued = false;       // the last physical line ended with a backslash
+
+    // keyword defaults of a lambda are the only '=' an expression may hold outside brackets
+    const bool checkAssignment = expression && code.find("lambda") == std::string_view::npos;
+
+    int lineNumber = 0;
+    std::size_t lineStart = 0;
+    while (lineStart <= code.size()) {
+        std::size_t lineEnd = code.find('\n', lineStart);
+        if (lineEnd == std::string_view::npos)
+            lineEnd = code.size();
+        std::string_view line = code.substr(lineStart, lineEnd - lineStart);
+        if (!line.empty() && line.back() == '\r')
+            line.remove_suffix(1);
+        ++lineNumber;
+
+        const bool logicalStart = quote == 0 && brackets.empty() && !continued;
+        continued = false;
+
+        std::size_t pos = 0;
+        if (logicalStart) {
+            int indent = 0;
+            while (pos < line.size() && (line[pos] == ' ' || line[pos] == '\t')) {
+                indent = line[pos] == '\t' ? (indent / 8 + 1) * 8 : indent + 1;
+                ++pos;
+            }
+
+            const bool blank = pos == line.size() || line[pos] == '#';
+            if (!blank && !expression) {
+                if (expectIndent) {
+                    if (indent <= indents.back())
+                        return atLine(lineNumber, "expected an indented block after line " + std::to_string(blockLine));
+                    indents.push_back(indent);
+                } else if (indent > indents.back()) {
+                    return atLine(lineNumber, "unexpected indent");
+                } else {
+                    while (indent < indents.back())
+                        indents.pop_back();
+                    if (indent != indents.back())
+                        return atLine(lineNumber, "unindent does not match any outer indentation level");
+                }
+                expectIndent = false;
+            }
+        }
+
+        char last = 0;            // last character of the line outside strings and comments
+        for (; pos < line.size(); ++pos) {
+            const char c = line[pos];
+
+            if (quote != 0) {
+                if (c == '\\') {
+                    if (pos + 1 == line.size())
+                        continued = !triple;
+                    ++pos;
+                } else if (c == quote) {
+                    if (!triple) {
+                        quote = 0;
+                    } else if (line.substr(pos, 3) == std::string_view(std::string(3, quote))) {
+                        quote = 0;
+                        pos += 2;
+                    }
+                }
+                last = quote == 0 ? c : last;
+                continue;
+            }
+
+            if (c == '#')
+                break;
+            if (c == ' ' || c == '\t')
+                continue;
+
+            if (c == '"' || c == '\'') {
+                quote = c;
+                stringLine = lineNumber;
+                triple = line.substr(pos, 3) == std::string_view(std::string(3, c));
+                if (triple)
+                    pos += 2;
+            } else if (c == '(' || c == '[' || c == '{') {
+                brackets.push_back({c, lineNumber});
+            } else if (c == ')' || c == ']' || c == '}') {
+                if (brackets.empty())
+                    return atLine(lineNumber, std::string("unmatched '") + c + "'");
+                if (closingOf(brackets.back().open) != c)
+                    return atLine(lineNumber, std::string("closing '") + c + "' does not match '"
+                                                  + brackets.back().open + "' on line "
+                                                  + std::to_string(brackets.back().line));
+                brackets.pop_back();
+            } else if (c == '\\') {
+                if (pos + 1 != line.size())
+                    return atLine(lineNumber, "unexpected character after line continuation character");
+                continued = true;
+            } else if (c == '=' && checkAssignment && brackets.empty()) {
+                const char before = pos > 0 ? line[pos - 1] : 0;
+                const char after = pos + 1 < line.size() ? line[pos + 1] : 0;
+                if (after == '=') {
+                    ++pos;
+                } else if (before != '=' && before != '!' && before != '<' && before != '>' && before != ':') {
+                    return atLine(lineNumber, "assignment in a condition, did you mean '=='?");
+                }
+            }
+            last = c;
+        }
+
+        if (quote != 0 && !triple && !continued)
+            return atLine(stringLine, "unterminated string literal");
+
+        if (!expression && quote == 0 && brackets.empty() && !continued && last == ':') {
+            expectIndent = true;
+            blockLine = lineNumber;
+        }
+
+        lineStart = lineEnd + 1;
+    }
+
+    if (quote != 0)
+        return atLine(stringLine, triple ? "unterminated triple-quoted string literal" : "unterminated string literal");
+    if (!brackets.empty())
+        return atLine(brackets.back().line, std::string("'") + brackets.back().open + "' was never closed");
+    if (continued)
+        return atLine(lineNumber, "unexpected end of the code after line continuation character");
+    if (expectIndent)
+        return atLine(blockLine, "expected an indented block after this line");
+
+    return std::nullopt;
+}
+
+void AutomatonValidator::setAction(uint32_t stateId, std::string_view code)
+{
+    std::optional<std::string> error;
+    if (!isPlaceholderAction(code))
+        error = checkPythonSyntax(code, false);
+
+    if (error)
+        m_actionErrors[stateId] = std::move(*error);
+    else
+        m_actionErrors.erase(stateId);
+}
+
+void AutomatonValidator::setCondition(const TransitionKey& key, std::string_view code)
+{
+    std::optional<std::string> error;
+    if (code.find_first_not_of(" \t\r\n") != std::string_view::npos)
+        error = checkPythonSyntax(code, true);
+
+    if (error)
+        m_conditionErrors[key] = std::move(*error);
+    else
+        m_conditionErrors.erase(key);
+}
+
+void AutomatonValidator::clear()
+{
+    m_actionErrors.clear();
+    m_conditionErrors.clear();
+}
+
+std::vector<ValidationProblem> AutomatonValidator::validate(const ValidationGraph& graph)
+{
+    using Kind = ValidationProblem::Kind;
+
+    const std::size_t count = graph.states.size();
+    std::unordered_map<uint32_t, std::size_t> index;
+    index.reserve(count);
+    for (std::size_t i = 0; i < count; ++i)
+        index.emplace(graph.states[i].id, i);
+
+    std::vector<ValidationProblem> automatonProblems;
+    std::vector<std::vector<ValidationProblem>> stateProblems(count);
+    auto report = [&](Kind kind, uint32_t stateId, std::string message) {
+        auto it = stateId != 0 ? index.find(stateId) : index.end();
+        if (it == index.end())
+            automatonProblems.push_back({kind, 0, std::move(message)});
+        else
+            stateProblems[it->second].push_back({kind, stateId, std::move(message)});
+    };
+
+    auto start = index.find(graph.startState);
+    if (graph.startState == 0 || start == index.end())
+        report(Kind::NoStartState, 0, "Start state not set");
+
+    // --- Names ---
+    std::unordered_map<std::string_view, std::size_t> nameCount;
+    nameCount.reserve(count);
+    for (const auto& state : graph.states)
+        ++nameCount[state.name];
+    for (const auto& state : graph.states) {
+        if (state.name.empty())
+            report(Kind::UnnamedState, state.id, "The state has no name");
+        else if (nameCount[state.name] > 1)
+            report(Kind::DuplicateName, state.id, "The name '" + state.name + "' is used by another state too");
+    }
+
+    // --- Transitions, as adjacency lists packed in one array ---
+    std::vector<std::size_t> offsets(count + 1, 0);
+    std::vector<std::pair<std::size_t, std::size_t>> edges;
+    edges.reserve(graph.transitions.size());
+    for (const auto& transition : graph.transitions) {
+        auto from = index.find(transition.from);
+        auto to = index.find(transition.to);
+        if (from == index.end() || to == index.end()) {
+            report(Kind::MissingState, transition.from, "A transition leads to a state that does not exist");
+            continue;
+        }
+        edges.emplace_back(from->second, to->second);
+        ++offsets[from->second + 1];
+    }
+    for (std::size_t i = 0; i < count; ++i)
+        offsets[i + 1] += offsets[i];
+    std::vector<std::size_t> targets(edges.size());
+    {
+        std::vector<std::size_t> fill(offsets.begin(), offsets.end() - 1);
+        for (const auto& [from, to] : edges)
+            targets[fill[from]++] = to;
+    }
+
+    for (std::size_t i = 0; i < count; ++i) {
+        if (!graph.states[i].final && offsets[i] == offsets[i + 1])
+            report(Kind::DeadEnd, graph.states[i].id, "The state is not final and no transition leaves it");
+    }
+
+    if (start != index.end()) {
+        std::vector<bool> reached(count, false);
+        std::vector<std::size_t> queue{start->second};
+        reached[start->second] = true;
+        while (!queue.empty()) {
+            const std::size_t state = queue.back();
+            queue.pop_back();
+            for (std::size_t e = offsets[state]; e < offsets[state + 1]; ++e) {
+                if (!reached[targets[e]]) {
+                    reached[targets[e]] = true;
+                    queue.push_back(targets[e]);
+                }
+            }
+        }
+        for (std::size_t i = 0; i < count; ++i) {
+            if (!reached[i])
+                report(Kind::Unreachable, graph.states[i].id, "The state cannot be reached from the start state");
+        }
+    }
+
+    // --- Syntax, from the texts checked when they changed ---
+    for (auto it = m_actionErrors.begin(); it != m_actionErrors.end();) {
+        if (index.count(it->first) == 0) {
+            it = m_actionErrors.erase(it);
+            continue;
+        }
+        report(Kind::ActionSyntax, it->first, "Action: " + it->second);
+        ++it;
+    }
+
+    const std::unordered_set<TransitionKey, TransitionKeyHash> present(graph.transitions.begin(),
+                                                                       graph.transitions.end());
+    for (auto it = m_conditionErrors.begin(); it != m_conditionErrors.end();) {
+        if (present.count(it->first) == 0) {
+            it = m_conditionErrors.erase(it);
+            continue;
+        }
+        report(Kind::ConditionSyntax, it->first.from, "Condition: " + it->second);
+        ++it;
+    }
+
+    std::vector<ValidationProblem> problems = std::move(automatonProblems);
+    for (auto& perState : stateProblems)
+        std::move(perState.begin(), perState.end(), std::back_inserter(problems));
+    return problems;
+}
@@ -0,0 +1,139 @@
+/**
+ * @file automaton-validator.hpp
+ * @brief Checks of an edited automaton that would otherwise fail only when it is run.
+ *
+ * The validator finds a missing start state, unnamed and duplicate state names,
+ * states not reachable from the start state, states that are neither final nor left
+ * by a transition, transitions to missing states and syntax errors in the Python of
+ * the actions and conditions.
+ *
+ * The syntax check is lexical: it matches brackets, terminates strings, follows the
+ * indentation of the blocks of an action and rejects assignments in conditions. It
+ * catches the usual typing errors without a Python interpreter, the full grammar is
+ * still checked by Python when the automaton runs.
+ *
+ * The texts are checked when they change and the results are kept, so a validation
+ * of the graph costs O(states + transitions) plus the changed texts only. The class
+ * does not depend on Qt.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#ifndef AUTOMATON_VALIDATOR_HPP
+#define AUTOMATON_VALIDATOR_HPP
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Identifies a transition, the ends and ports of the connection in the editor.
+ */
+struct TransitionKey
+{
+    uint32_t from = 0;
+    uint32_t fromPort = 0;
+    uint32_t to = 0;
+    uint32_t toPort = 0;
+
+    bool operator==(const TransitionKey& other) const
+    {
+        return from == other.from && fromPort == other.fromPort && to == other.to && toPort == other.toPort;
+    }
+};
+
+struct TransitionKeyHash
+{
+    std::size_t operator()(const TransitionKey& key) const
+    {
+        uint64_t h = (uint64_t(key.from) << 32 | key.to) * 0x9e3779b97f4a7c15ull;
+        h ^= (uint64_t(key.fromPort) << 32 | key.toPort) + 0x9e3779b9 + (h << 6) + (h >> 2);
+        return static_cast<std::size_t>(h);
+    }
+};
+
+/**
+ * @brief Structure of the automaton to validate, without the texts.
+ */
+struct ValidationGraph
+{
+    struct State
+    {
+        uint32_t id = 0;
+        std::string name;
+        bool final = false;
+    };
+
+    std::vector<State> states;
+    std::vector<TransitionKey> transitions;
+    uint32_t startState = 0;                ///< 0 if none is set
+};
+
+/**
+ * @brief A problem found by the validator.
+ */
+struct ValidationProblem
+{
+    enum class Kind
+    {
+        NoStartState,
+        UnnamedState,
+        DuplicateName,
+        Unreachable,
+        DeadEnd,
+        MissingState,
+        ActionSyntax,
+        ConditionSyntax
+    };
+
+    Kind kind;
+    uint32_t stateId = 0;                   ///< the state, the source of a transition; 0 for the automaton
+    std::string message;
+};
+
+/**
+ * @class AutomatonValidator
+ * @brief Validates the automaton, keeps the syntax results of the texts between runs.
+ */
+class AutomatonValidator
+{
+public:
+    /**
+     * @brief Checks the new action of a state.
+     */
+    void setAction(uint32_t stateId, std::string_view code);
+
+    /**
+     * @brief Checks the new condition of a transition.
+     */
+    void setCondition(const TransitionKey& key, std::string_view code);
+
+    /**
+     * @brief Forgets all the texts, before the whole automaton is set again.
+     */
+    void clear();
+
+    /**
+     * @brief Validates the automaton with the syntax results of the texts set so far.
+     *
+     * The results of states and transitions missing in the graph are dropped.
+     * @return The problems, those of a state in a row.
+     */
+    std::vector<ValidationProblem> validate(const ValidationGraph& graph);
+
+    /**
+     * @brief Checks the Python of an action or, with expression, of a condition.
+     * @return The first error with its line, nothing when no error was found.
+     */
+    static std::optional<std::string> checkPythonSyntax(std::string_view code, bool expression);
+
+private:
+    std::unordered_map<uint32_t, std::string> m_actionErrors;                          ///< by state, errors only
+    std::unordered_map<TransitionKey, std::string, TransitionKeyHash> m_conditionErrors; ///< by transition, errors only
+};
+
+#endif // AUTOMATON_VALIDATOR_HPP
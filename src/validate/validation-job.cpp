@@ -0,0 +1,55 @@
+/**
+ * @file validation-job.cpp
+ * @brief Implementation of the ValidationJob class.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#include "validation-job.hpp"
+
+ValidationJob::ValidationJob(QObject *parent)
+    : QObject(parent)
+{
+}
+
+ValidationJob::~ValidationJob()
+{
+    if (m_thread.joinable())
+        m_thread.join();
+}
+
+bool ValidationJob::start(ValidationRequest request)
+{
+    if (m_running)
+        return false;
+
+    if (m_thread.joinable())
+        m_thread.join();
+
+    m_running = true;
+
+    m_thread = std::thread([this, request = std::move(request)]() {
+        if (request.reset)
+            m_validator.clear();
+        for (const auto& [stateId, code] : request.actions)
+            m_validator.setAction(stateId, code);
+        for (const auto& [key, code] : request.conditions)
+            m_validator.setCondition(key, code);
+
+        std::vector<ValidationProblem> result = m_validator.validate(request.graph);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_result = std::move(result);
+        }
+        m_running = false;
+        emit finished();
+    });
+    return true;
+}
+
+std::vector<ValidationProblem> ValidationJob::takeResult()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return std::move(m_result);
+}
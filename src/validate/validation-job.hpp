@@ -0,0 +1,86 @@
+/**
+ * @file validation-job.hpp
+ * @brief Declaration of the ValidationJob class, runs AutomatonValidator on a worker thread.
+ *
+ * @author Josef Ambruz
+ * @date 2026-10-14
+ */
+
+#ifndef VALIDATION_JOB_HPP
+#define VALIDATION_JOB_HPP
+
+#include <QObject>
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "automaton-validator.hpp"
+
+/**
+ * @brief What changed since the last validation.
+ */
+struct ValidationRequest
+{
+    ValidationGraph graph;                                          ///< The whole structure, it is cheap to check.
+    std::vector<std::pair<uint32_t, std::string>> actions;          ///< Changed actions by state.
+    std::vector<std::pair<TransitionKey, std::string>> conditions;  ///< Changed conditions.
+    bool reset = false;                                             ///< The texts are all set again.
+};
+
+/**
+ * @class ValidationJob
+ * @brief Validates the automaton without blocking the UI.
+ *
+ * The validator and the syntax results it keeps live in the job and are only used
+ * by the worker thread, so a request carries the changed texts only. finished() is
+ * emitted from the worker thread, the problems are picked up with takeResult().
+ */
+class ValidationJob : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief Constructs the ValidationJob object.
+     * @param parent The parent QObject.
+     */
+    explicit ValidationJob(QObject *parent = nullptr);
+
+    /**
+     * @brief Destructor, waits for the worker thread.
+     */
+    ~ValidationJob();
+
+    /**
+     * @brief Starts validating on the worker thread.
+     * @return False if a validation is already running.
+     */
+    bool start(ValidationRequest request);
+
+    /**
+     * @brief Checks if a validation is running.
+     */
+    bool isRunning() const { return m_running; }
+
+    /**
+     * @brief Returns the problems found by the last validation.
+     */
+    std::vector<ValidationProblem> takeResult();
+
+signals:
+    /**
+     * @brief Emitted when the worker thread has finished the validation.
+     */
+    void finished();
+
+private:
+    std::thread m_thread;                       ///< The worker thread.
+    std::atomic<bool> m_running{false};         ///< True while the worker thread runs.
+    AutomatonValidator m_validator;             ///< Used by the worker thread only.
+    std::mutex m_mutex;                         ///< Guards m_result.
+    std::vector<ValidationProblem> m_result;    ///< Result of the last validation.
+};
+
+#endif // VALIDATION_JOB_HPP
@@ -0,0 +1,118 @@
+"""
+Tests of the multiplexed connection of the daemon, src/interpret/fsm_core/mux.py.
+
+Run with PYTHONPATH=src/interpret python3 -m unittest discover tests (ctest runs them
+with ICP_TESTS).
+"""
+
+import time
+import unittest
+
+from fsm_core.mux import InstanceTable, Multiplexer
+from fsm_core.wire import encode_message
+
+# an automaton that never ends, every step sends a CURRENT_STATE
+ENDLESS = """
+from fsm_core import FSM, State, Transition
+
+def build_fsm():
+    fsm = FSM()
+    loop = State("loop", is_start_state=True)
+    loop.add_transition(Transition("loop"))
+    fsm.add_state(loop)
+    return fsm
+"""
+
+
+class FakeChannel:
+    """The editor connection, records the batches and never grants credit."""
+
+    send_encoding = "json"
+
+    def __init__(self):
+        self.batches = []
+
+    def send(self, message_type, payload=None):
+        self.batches.append((message_type, payload))
+
+    def send_queue_bytes(self):
+        return 0
+
+
+class CborChannel(FakeChannel):
+    """Encodes every batch like wire.Channel in the CBOR encoding."""
+
+    send_encoding = "cbor"
+
+    def send(self, message_type, payload=None):
+        encode_message(message_type, payload, "cbor")
+        super().send(message_type, payload)
+
+
+class MultiplexerTest(unittest.TestCase):
+    def test_a_message_that_fails_to_encode_leaves_its_batch(self):
+        channel = CborChannel()
+        mux = Multiplexer(channel)
+        mux.open(1)
+        mux.open(2)
+        mux.send(1, "VARIABLE_UPDATE", {"name": "x", "value": 2**64})
+        mux.send(2, "VARIABLE_UPDATE", {"name": "y", "value": 1})
+        deadline = time.monotonic() + 5.0
+        while mux.pending() and time.monotonic() < deadline:
+            time.sleep(0.01)
+        mux.close()
+
+        messages = [message for _, payload in channel.batches for message in payload["messages"]]
+        self.assertEqual([message[0] for message in messages], [2])
+
+
+class InstanceTableTest(unittest.TestCase):
+    def setUp(self):
+        self.table = InstanceTable(FakeChannel(), window=4)
+
+    def tearDown(self):
+        self.table.close()
+
+    def load_out_of_credit(self, instance):
+        self.table.dispatch({"type": "LOAD_AUTOMATON", "instance": instance, "payload": {"code": ENDLESS}})
+        runtime = self.table._instances[instance]
+        deadline = time.monotonic() + 5.0
+        while self.table.mux._credits.get(instance) > 0 and time.monotonic() < deadline:
+            time.sleep(0.01)
+        self.assertLessEqual(self.table.mux._credits.get(instance), 0)
+        return runtime
+
+    def test_close_instance_out_of_credit(self):
+        runtime = self.load_out_of_credit(1)
+        thread = runtime._fsm_thread
+
+        start = time.monotonic()
+        self.table.dispatch({"type": "CLOSE_INSTANCE", "instance": 1})
+        self.assertLess(time.monotonic() - start, 1.0)
+        self.assertFalse(thread.is_alive())
+        self.assertEqual(len(self.table), 0)
+        self.assertNotIn(1, self.table.mux._credits)
+
+    def test_reload_instance_out_of_credit(self):
+        runtime = self.load_out_of_credit(1)
+        thread = runtime._fsm_thread
+
+        start = time.monotonic()
+        self.table.dispatch({"type": "LOAD_AUTOMATON", "instance": 1, "payload": {"code": ENDLESS}})
+        self.assertLess(time.monotonic() - start, 1.0)
+        self.assertFalse(thread.is_alive())
+        # the new automaton runs on the credit the old one left, none at all
+        self.assertIs(self.table._instances[1], runtime)
+        self.assertTrue(runtime._fsm_thread.is_alive())
+        self.assertLessEqual(self.table.mux._credits.get(1), 0)
+
+    def test_other_instances_go_on(self):
+        self.load_out_of_credit(1)
+        self.table.dispatch({"type": "LOAD_AUTOMATON", "instance": 2, "payload": {"code": ENDLESS}})
+        self.table.dispatch({"type": "CLOSE_INSTANCE", "instance": 1})
+        self.assertEqual(len(self.table), 1)
+        self.assertIn(2, self.table.mux._credits)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,56 @@
+"""
+Tests of the wire encodings, src/interpret/fsm_core/wire.py.
+
+Run with PYTHONPATH=src/interpret python3 -m unittest discover tests (ctest runs them
+with ICP_TESTS).
+"""
+
+import socket
+import unittest
+
+from fsm_core import FSM
+from fsm_core.wire import Channel, EncodeError, cbor_dumps, cbor_loads
+
+
+class CborTest(unittest.TestCase):
+    def test_ints_of_64_bits_round_trip(self):
+        for value in (0, 23, 24, 255, 256, 2**32, 2**64 - 1, -1, -2**63, -2**64):
+            self.assertEqual(cbor_loads(cbor_dumps(value)), value)
+
+    def test_wider_ints_fail(self):
+        for value in (2**64, -2**64 - 1, 10**30):
+            with self.assertRaises(EncodeError):
+                cbor_dumps({"value": [value]})
+
+
+class ChannelTest(unittest.TestCase):
+    def setUp(self):
+        self.runtime, self.editor = socket.socketpair()
+        self.editor.settimeout(1.0)
+        self.channel = Channel(self.runtime)
+        self.channel._send_encoding = "cbor"
+
+    def tearDown(self):
+        self.runtime.close()
+        self.editor.close()
+
+    def test_a_message_that_fails_to_encode_is_not_sent(self):
+        with self.assertRaises(EncodeError):
+            self.channel.send("VARIABLE_UPDATE", {"name": "x", "value": 2**64})
+        self.assertEqual(self.channel.messages_sent, 0)
+        self.channel.send("VARIABLE_UPDATE", {"name": "x", "value": 1})
+        frame = self.editor.recv(65536)
+        self.assertEqual(cbor_loads(frame[4:])[1], {"name": "x", "value": 1})
+
+    def test_the_fsm_drops_the_message_and_stays_connected(self):
+        fsm = FSM()
+        fsm.attach_client(self.channel)
+        fsm._send_to_client("VARIABLE_UPDATE", {"name": "x", "value": 2**64})
+        self.assertEqual(fsm.stats.dropped_messages, 1)
+        self.assertFalse(fsm._stop_event.is_set())
+        fsm._send_to_client("VARIABLE_UPDATE", {"name": "x", "value": 1})
+        self.assertEqual(self.channel.messages_sent, 1)
+
+
+if __name__ == "__main__":
+    unittest.main()